@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+# Copyright 2022 The IREE Authors
+#
+# Licensed under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+"""Counts the most frequently dispatched VM op sequences in execution traces.
+
+Candidates for new VM superinstructions are sequences of ops that are
+dispatched back-to-back in real programs. This script reads the execution
+traces the bytecode interpreter writes to stderr when tracing is enabled and
+reports the most common op n-grams weighted by how often they are dispatched.
+
+Sequences are only counted within a single function frame and, unless
+--cross_blocks is specified, within a single block: ops following a branch,
+call, or return start a new sequence as they could not be fused with the op
+that preceded them.
+
+Example usage:
+  iree-run-module --trace_execution --module_file=module.vmfb ... \\
+      2> trace.txt
+  python3 count_vm_opcode_ngrams.py --n=2,3 --top=20 trace.txt
+"""
+
+import argparse
+import collections
+import re
+import sys
+from typing import Dict, Iterable, List, Sequence, Tuple
+
+# Matches `[module.function+0000002A]    <disassembly>` trace lines. Not
+# anchored as IREE_VM_EXECUTION_TRACING_SRC_LOC_ENABLE prefixes each line with
+# its padded source location.
+TRACE_LINE_PATTERN = re.compile(
+    r"\[(?P<frame>[^\]+\s]+)\+(?P<pc>[0-9A-F]+)\]\s+(?P<op>.*)$")
+
+# The first op mnemonic in a disassembled instruction, such as `vm.add.i32`.
+MNEMONIC_PATTERN = re.compile(r"\b(vm\.[a-z0-9_.]+)")
+
+# Mnemonic prefixes of ops that end a fusable sequence.
+CONTROL_FLOW_PREFIXES = ("vm.br", "vm.cond_br", "vm.call", "vm.return",
+                         "vm.fail", "vm.yield", "vm.break", "vm.cond_break")
+
+
+def parse_trace(lines: Iterable[str]) -> Iterable[Tuple[str, str]]:
+  """Yields (frame, mnemonic) for each dispatched op in a trace."""
+  for line in lines:
+    match = TRACE_LINE_PATTERN.search(line.strip())
+    if not match:
+      continue
+    mnemonic = MNEMONIC_PATTERN.search(match.group("op"))
+    if not mnemonic:
+      continue
+    yield match.group("frame"), mnemonic.group(1)
+
+
+def count_ngrams(
+    ops: Iterable[Tuple[str, str]], sizes: Sequence[int],
+    cross_blocks: bool) -> Tuple[int, Dict[int, collections.Counter]]:
+  """Counts op n-grams of each size in |sizes|.
+
+  Returns the total number of dispatched ops and a counter per n-gram size.
+  """
+  counters = {n: collections.Counter() for n in sizes}
+  max_size = max(sizes)
+  window: List[str] = []
+  current_frame = None
+  total = 0
+  for frame, mnemonic in ops:
+    total += 1
+    if frame != current_frame:
+      current_frame = frame
+      window = []
+    window.append(mnemonic)
+    if len(window) > max_size:
+      window.pop(0)
+    for n in sizes:
+      if len(window) >= n:
+        counters[n][tuple(window[-n:])] += 1
+    if not cross_blocks and mnemonic.startswith(CONTROL_FLOW_PREFIXES):
+      window = []
+  return total, counters
+
+
+def parse_arguments():
+  parser = argparse.ArgumentParser(
+      description="Counts VM op n-grams in execution traces.")
+  parser.add_argument(
+      "traces",
+      nargs="*",
+      metavar="<trace>",
+      help="Execution trace files to read; defaults to stdin.")
+  parser.add_argument("--n",
+                      type=str,
+                      default="2,3",
+                      help="Comma-separated n-gram sizes to count.")
+  parser.add_argument("--top",
+                      type=int,
+                      default=20,
+                      help="Number of n-grams of each size to report.")
+  parser.add_argument(
+      "--cross_blocks",
+      action="store_true",
+      help="Continue sequences across branches, calls, and returns.")
+  return parser.parse_args()
+
+
+def main(args):
+  sizes = sorted({int(n) for n in args.n.split(",")})
+  if not sizes or sizes[0] < 1:
+    raise ValueError("n-gram sizes must be positive")
+
+  def read_lines():
+    if not args.traces:
+      yield from sys.stdin
+    for path in args.traces:
+      with open(path, "r") as f:
+        yield from f
+
+  total, counters = count_ngrams(parse_trace(read_lines()), sizes,
+                                 args.cross_blocks)
+  print(f"{total} ops dispatched")
+  for n in sizes:
+    print(f"\nTop {n}-grams:")
+    for ngram, count in counters[n].most_common(args.top):
+      percent = 100.0 * count / total if total else 0.0
+      print(f"  {count:>12} {percent:6.2f}%  {' '.join(ngram)}")
+
+
+if __name__ == "__main__":
+  main(parse_arguments())
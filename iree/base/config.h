@@ -187,6 +187,16 @@ typedef IREE_DEVICE_SIZE_T iree_device_size_t;
 #define IREE_VM_BACKTRACE_ENABLE 1
 #endif  // !IREE_VM_BACKTRACE_ENABLE
 
+#if !defined(IREE_VM_BYTECODE_VERIFICATION_ENABLE)
+// Verifies the bytecode of modules when they are loaded and rejects those that
+// are malformed. Verified modules are dispatched without the register masking
+// and per-op bounds checks that are otherwise required to safely run untrusted
+// modules. Disabling verification reduces load time in exchange for slower
+// dispatch of the latest bytecode version; older versions are always verified
+// as they are transcoded when loaded.
+#define IREE_VM_BYTECODE_VERIFICATION_ENABLE 1
+#endif  // !IREE_VM_BYTECODE_VERIFICATION_ENABLE
+
 #if !defined(IREE_VM_EXECUTION_TRACING_ENABLE)
 // Enables disassembly of vm bytecode functions and stderr dumping of execution.
 // Increases code size quite, lowers VM performance, and is generally unsafe;
@@ -0,0 +1,324 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/numa.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "iree/base/target_platform.h"
+
+#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_LINUX)
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define IREE_NUMA_SYSFS 1
+#endif  // IREE_PLATFORM_ANDROID || IREE_PLATFORM_LINUX
+
+#if defined(IREE_NUMA_SYSFS)
+
+//==============================================================================
+// Linux sysfs queries
+//==============================================================================
+// https://www.kernel.org/doc/html/latest/admin-guide/mm/numaperf.html
+// https://www.kernel.org/doc/Documentation/ABI/stable/sysfs-devices-node
+
+// Parses a sysfs cpu/node list like `0-3,8,10-11` and returns one more than the
+// largest ID present or 0 if the list is empty or invalid.
+static uint32_t iree_numa_parse_list_upper_bound(const char* list) {
+  uint32_t upper_bound = 0;
+  const char* p = list;
+  while (*p) {
+    char* end = NULL;
+    unsigned long value = strtoul(p, &end, 10);
+    if (end == p) break;
+    if (*end == '-') {
+      p = end + 1;
+      value = strtoul(p, &end, 10);
+      if (end == p) break;
+    }
+    if (value + 1 > upper_bound) upper_bound = (uint32_t)value + 1;
+    if (*end != ',') break;
+    p = end + 1;
+  }
+  return upper_bound;
+}
+
+iree_host_size_t iree_numa_node_count(void) {
+  FILE* file = fopen("/sys/devices/system/node/online", "r");
+  if (!file) return 1;
+  char buffer[256] = {0};
+  bool did_read = fgets(buffer, sizeof(buffer), file) != NULL;
+  fclose(file);
+  if (!did_read) return 1;
+  uint32_t node_count = iree_numa_parse_list_upper_bound(buffer);
+  return iree_max(1, iree_min(node_count, IREE_NUMA_MAX_NODE_COUNT));
+}
+
+uint32_t iree_numa_node_for_processor(uint32_t processor_id) {
+  // Each cpu directory contains a `nodeN` link to the node it belongs to.
+  char path[64];
+  snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u", processor_id);
+  DIR* dir = opendir(path);
+  if (!dir) return 0;
+  uint32_t numa_node = 0;
+  struct dirent* entry = NULL;
+  while ((entry = readdir(dir)) != NULL) {
+    if (strncmp(entry->d_name, "node", 4) != 0) continue;
+    char* end = NULL;
+    unsigned long value = strtoul(entry->d_name + 4, &end, 10);
+    if (end != entry->d_name + 4 && *end == 0 &&
+        value < IREE_NUMA_MAX_NODE_COUNT) {
+      numa_node = (uint32_t)value;
+      break;
+    }
+  }
+  closedir(dir);
+  return numa_node;
+}
+
+//==============================================================================
+// mmap + mbind allocator
+//==============================================================================
+
+// Bytes reserved immediately before each allocation to track its mapping.
+// Kept at a cache line so that user data does not share a line with it.
+#define IREE_NUMA_ALLOCATION_HEADER_SIZE 64
+
+// Huge page size assumed for alignment and explicit huge page mappings. This is
+// the default on x86-64 and arm64 Linux; systems with a different default size
+// fail explicit mappings and fall back to transparent huge pages.
+#define IREE_NUMA_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// Allocator self pointers pack the NUMA node into the low bits (with the mask
+// value meaning unbound) and the allocation flags above it.
+#define IREE_NUMA_SELF_NODE_MASK 0xFFu
+#define IREE_NUMA_SELF_FLAGS_SHIFT 8
+
+// From linux/mempolicy.h; defined here to avoid requiring kernel headers.
+#define IREE_NUMA_MPOL_PREFERRED 1
+
+// Stored in the IREE_NUMA_ALLOCATION_HEADER_SIZE bytes preceding each
+// allocation.
+typedef struct iree_numa_allocation_header_t {
+  // Base of the mapping, which may precede the header.
+  uint8_t* base_ptr;
+  // Total length of the mapping from |base_ptr|.
+  iree_host_size_t total_length;
+} iree_numa_allocation_header_t;
+
+static iree_numa_allocation_header_t* iree_numa_allocation_header(void* ptr) {
+  return (iree_numa_allocation_header_t*)((uint8_t*)ptr -
+                                          IREE_NUMA_ALLOCATION_HEADER_SIZE);
+}
+
+// Maps |total_length| bytes such that the byte at |data_offset| is aligned to
+// |alignment| by over-mapping and unmapping the unused head and tail.
+static uint8_t* iree_numa_map_aligned(iree_host_size_t total_length,
+                                      iree_host_size_t data_offset,
+                                      iree_host_size_t alignment) {
+  iree_host_size_t mapped_length = total_length + alignment;
+  uint8_t* mapped_ptr = (uint8_t*)mmap(NULL, mapped_length,
+                                       PROT_READ | PROT_WRITE,
+                                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapped_ptr == MAP_FAILED) return NULL;
+  uint8_t* data_ptr =
+      (uint8_t*)iree_host_align((uintptr_t)mapped_ptr + data_offset, alignment);
+  uint8_t* base_ptr = data_ptr - data_offset;
+  uint8_t* end_ptr = base_ptr + total_length;
+  if (base_ptr != mapped_ptr) munmap(mapped_ptr, base_ptr - mapped_ptr);
+  if (end_ptr != mapped_ptr + mapped_length) {
+    munmap(end_ptr, mapped_ptr + mapped_length - end_ptr);
+  }
+  return base_ptr;
+}
+
+static iree_status_t iree_numa_allocate(uint32_t numa_node,
+                                        iree_numa_allocation_flags_t flags,
+                                        iree_host_size_t byte_length,
+                                        void** out_ptr) {
+  *out_ptr = NULL;
+  iree_host_size_t page_size = (iree_host_size_t)sysconf(_SC_PAGESIZE);
+  uint8_t* base_ptr = NULL;
+  iree_host_size_t total_length = 0;
+  iree_host_size_t data_offset = IREE_NUMA_ALLOCATION_HEADER_SIZE;
+
+  if (iree_all_bits_set(flags, IREE_NUMA_ALLOCATION_FLAG_EXPLICIT_HUGE_PAGES)) {
+#if defined(MAP_HUGETLB)
+    // Huge page mappings are always huge page aligned so the header shares the
+    // first page with the data.
+    total_length = iree_host_align(
+        IREE_NUMA_ALLOCATION_HEADER_SIZE + byte_length,
+        IREE_NUMA_HUGE_PAGE_SIZE);
+    void* ptr = mmap(NULL, total_length, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (ptr != MAP_FAILED) base_ptr = (uint8_t*)ptr;
+#endif  // MAP_HUGETLB
+    if (!base_ptr) flags |= IREE_NUMA_ALLOCATION_FLAG_TRANSPARENT_HUGE_PAGES;
+  }
+
+#if defined(MADV_HUGEPAGE)
+  if (!base_ptr &&
+      iree_all_bits_set(flags,
+                        IREE_NUMA_ALLOCATION_FLAG_TRANSPARENT_HUGE_PAGES)) {
+    // The header gets its own small page so that the data starts on a huge
+    // page boundary and a huge page sized allocation only needs one.
+    data_offset = page_size;
+    total_length =
+        page_size + iree_host_align(byte_length, IREE_NUMA_HUGE_PAGE_SIZE);
+    base_ptr = iree_numa_map_aligned(total_length, data_offset,
+                                     IREE_NUMA_HUGE_PAGE_SIZE);
+    if (base_ptr) {
+      // Failures are ignored as THP may be disabled; the memory is still
+      // usable, just backed by base pages.
+      madvise(base_ptr + data_offset, total_length - data_offset,
+              MADV_HUGEPAGE);
+    }
+  }
+#endif  // MADV_HUGEPAGE
+
+  if (!base_ptr) {
+    data_offset = IREE_NUMA_ALLOCATION_HEADER_SIZE;
+    total_length = iree_host_align(
+        IREE_NUMA_ALLOCATION_HEADER_SIZE + byte_length, page_size);
+    void* ptr = mmap(NULL, total_length, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr != MAP_FAILED) base_ptr = (uint8_t*)ptr;
+  }
+  if (!base_ptr) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "mmap of %zu bytes for NUMA node %u failed",
+                            total_length, numa_node);
+  }
+
+#if defined(SYS_mbind)
+  // Pages are not yet committed and the policy is applied as they are first
+  // touched (which is below when we write the header). Failures are ignored as
+  // the kernel may not have NUMA support or we may be in a sandbox that
+  // disallows the syscall; the memory is still usable, just not placed.
+  if (numa_node < IREE_NUMA_MAX_NODE_COUNT) {
+    uint64_t node_mask = 1ull << numa_node;
+    syscall(SYS_mbind, base_ptr, total_length, IREE_NUMA_MPOL_PREFERRED,
+            &node_mask, sizeof(node_mask) * 8 + 1, 0);
+  }
+#endif  // SYS_mbind
+
+  uint8_t* data_ptr = base_ptr + data_offset;
+  iree_numa_allocation_header_t* header = iree_numa_allocation_header(data_ptr);
+  header->base_ptr = base_ptr;
+  header->total_length = total_length;
+
+  // MAP_POPULATE would fault pages before the policies above are applied so
+  // pages are touched manually instead. Fresh anonymous pages are zeroed and
+  // writing a zero does not change their contents.
+  if (iree_all_bits_set(flags, IREE_NUMA_ALLOCATION_FLAG_PREFAULT)) {
+    for (iree_host_size_t offset = data_offset; offset < total_length;
+         offset += page_size) {
+      ((volatile uint8_t*)base_ptr)[offset] = 0;
+    }
+  }
+
+  *out_ptr = data_ptr;
+  return iree_ok_status();
+}
+
+static iree_host_size_t iree_numa_allocation_length(void* ptr) {
+  iree_numa_allocation_header_t* header = iree_numa_allocation_header(ptr);
+  return (iree_host_size_t)(header->base_ptr + header->total_length -
+                            (uint8_t*)ptr);
+}
+
+static void iree_numa_free(void* ptr) {
+  if (!ptr) return;
+  iree_numa_allocation_header_t* header = iree_numa_allocation_header(ptr);
+  munmap(header->base_ptr, header->total_length);
+}
+
+static iree_status_t iree_numa_allocator_ctl(void* self,
+                                             iree_allocator_command_t command,
+                                             const void* params,
+                                             void** inout_ptr) {
+  uint32_t numa_node = (uint32_t)((uintptr_t)self & IREE_NUMA_SELF_NODE_MASK);
+  iree_numa_allocation_flags_t flags =
+      (iree_numa_allocation_flags_t)((uintptr_t)self >>
+                                     IREE_NUMA_SELF_FLAGS_SHIFT);
+  switch (command) {
+    case IREE_ALLOCATOR_COMMAND_MALLOC:
+    case IREE_ALLOCATOR_COMMAND_CALLOC: {
+      // Fresh anonymous pages are always zeroed.
+      const iree_allocator_alloc_params_t* alloc_params =
+          (const iree_allocator_alloc_params_t*)params;
+      return iree_numa_allocate(numa_node, flags, alloc_params->byte_length,
+                                inout_ptr);
+    }
+    case IREE_ALLOCATOR_COMMAND_REALLOC: {
+      const iree_allocator_alloc_params_t* alloc_params =
+          (const iree_allocator_alloc_params_t*)params;
+      void* existing_ptr = *inout_ptr;
+      if (existing_ptr && iree_numa_allocation_length(existing_ptr) >=
+                              alloc_params->byte_length) {
+        return iree_ok_status();  // fits in the existing pages
+      }
+      void* new_ptr = NULL;
+      IREE_RETURN_IF_ERROR(iree_numa_allocate(
+          numa_node, flags, alloc_params->byte_length, &new_ptr));
+      if (existing_ptr) {
+        memcpy(new_ptr, existing_ptr,
+               iree_numa_allocation_length(existing_ptr));
+        iree_numa_free(existing_ptr);
+      }
+      *inout_ptr = new_ptr;
+      return iree_ok_status();
+    }
+    case IREE_ALLOCATOR_COMMAND_FREE:
+      iree_numa_free(*inout_ptr);
+      return iree_ok_status();
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "unsupported NUMA allocator command");
+  }
+}
+
+iree_allocator_t iree_numa_allocator(uint32_t numa_node) {
+  return iree_numa_allocator_with_flags(numa_node,
+                                        IREE_NUMA_ALLOCATION_FLAG_NONE);
+}
+
+iree_allocator_t iree_numa_allocator_with_flags(
+    uint32_t numa_node, iree_numa_allocation_flags_t flags) {
+  if (numa_node >= IREE_NUMA_MAX_NODE_COUNT) {
+    if (flags == IREE_NUMA_ALLOCATION_FLAG_NONE) return iree_allocator_system();
+    numa_node = IREE_NUMA_SELF_NODE_MASK;
+  }
+  uintptr_t self =
+      (uintptr_t)numa_node | ((uintptr_t)flags << IREE_NUMA_SELF_FLAGS_SHIFT);
+  iree_allocator_t v = {(void*)self, iree_numa_allocator_ctl};
+  return v;
+}
+
+#else
+
+//==============================================================================
+// Fallback (no NUMA support)
+//==============================================================================
+
+iree_host_size_t iree_numa_node_count(void) { return 1; }
+
+uint32_t iree_numa_node_for_processor(uint32_t processor_id) { return 0; }
+
+iree_allocator_t iree_numa_allocator(uint32_t numa_node) {
+  return iree_allocator_system();
+}
+
+iree_allocator_t iree_numa_allocator_with_flags(
+    uint32_t numa_node, iree_numa_allocation_flags_t flags) {
+  return iree_allocator_system();
+}
+
+#endif  // IREE_NUMA_SYSFS
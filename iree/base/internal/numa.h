@@ -0,0 +1,79 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_BASE_INTERNAL_NUMA_H_
+#define IREE_BASE_INTERNAL_NUMA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "iree/base/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//==============================================================================
+// NUMA topology queries
+//==============================================================================
+// Only Linux exposes the information we need today (via sysfs); all other
+// platforms report a single node containing all processors. Callers should
+// treat the results as hints: processors/memory may be hotplugged and the
+// information is only captured at the time of the call.
+
+// Maximum number of NUMA nodes queried. Nodes beyond this are ignored.
+#define IREE_NUMA_MAX_NODE_COUNT 64
+
+// Returns the total number of NUMA nodes in the system (always at least 1).
+// Node IDs are in the range [0, count).
+iree_host_size_t iree_numa_node_count(void);
+
+// Returns the NUMA node the logical processor with the given platform
+// |processor_id| (the Linux CPU number) is attached to or 0 if unknown.
+uint32_t iree_numa_node_for_processor(uint32_t processor_id);
+
+//==============================================================================
+// NUMA-local allocation
+//==============================================================================
+
+// Returns an allocator that prefers placing pages on |numa_node| memory.
+// Placement is a preference and the system may fall back to other nodes when
+// the requested node is out of memory.
+//
+// Allocations are made with whole pages directly from the system and this is
+// only intended for large long-lived allocations such as arena blocks. On
+// platforms without NUMA support this is equivalent to iree_allocator_system.
+iree_allocator_t iree_numa_allocator(uint32_t numa_node);
+
+// Controls how pages are mapped by iree_numa_allocator_with_flags.
+enum iree_numa_allocation_flag_bits_t {
+  IREE_NUMA_ALLOCATION_FLAG_NONE = 0u,
+  // Advises the kernel to back the allocation with transparent huge pages
+  // (MADV_HUGEPAGE). The mapping is aligned to the huge page size so that the
+  // kernel can use huge pages for all of it. Ignored if unsupported.
+  IREE_NUMA_ALLOCATION_FLAG_TRANSPARENT_HUGE_PAGES = 1u << 0,
+  // Maps explicit huge pages from the system hugetlbfs pool (MAP_HUGETLB).
+  // Falls back to transparent huge pages if the pool is exhausted or the
+  // system does not support it.
+  IREE_NUMA_ALLOCATION_FLAG_EXPLICIT_HUGE_PAGES = 1u << 1,
+  // Faults in all pages during allocation so that first use does not.
+  // Pages are faulted after the NUMA and huge page policies are applied.
+  IREE_NUMA_ALLOCATION_FLAG_PREFAULT = 1u << 2,
+};
+typedef uint32_t iree_numa_allocation_flags_t;
+
+// Returns an allocator as with iree_numa_allocator that maps pages with the
+// given |flags|. |numa_node| may be IREE_NUMA_MAX_NODE_COUNT or larger to not
+// bind the pages to any node. Intended for very large allocations where TLB
+// pressure dominates such as model weights and activations.
+iree_allocator_t iree_numa_allocator_with_flags(
+    uint32_t numa_node, iree_numa_allocation_flags_t flags);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // IREE_BASE_INTERNAL_NUMA_H_
@@ -0,0 +1,98 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/numa.h"
+
+#include <cstring>
+
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+TEST(NUMATest, NodeCount) {
+  iree_host_size_t node_count = iree_numa_node_count();
+  EXPECT_GE(node_count, 1);
+  EXPECT_LE(node_count, IREE_NUMA_MAX_NODE_COUNT);
+}
+
+TEST(NUMATest, NodeForProcessor) {
+  // Processor 0 should always exist and be attached to a valid node.
+  EXPECT_LT(iree_numa_node_for_processor(0), iree_numa_node_count());
+  // Unknown processors report node 0.
+  EXPECT_EQ(0, iree_numa_node_for_processor(UINT32_MAX));
+}
+
+TEST(NUMATest, AllocatorLifetime) {
+  iree_allocator_t allocator = iree_numa_allocator(0);
+  void* ptr = NULL;
+  IREE_ASSERT_OK(iree_allocator_malloc(allocator, 1024, &ptr));
+  ASSERT_NE(nullptr, ptr);
+  for (int i = 0; i < 1024; ++i) {
+    EXPECT_EQ(0, ((uint8_t*)ptr)[i]);
+  }
+  memset(ptr, 0xCD, 1024);
+  iree_allocator_free(allocator, ptr);
+}
+
+TEST(NUMATest, AllocatorRealloc) {
+  iree_allocator_t allocator = iree_numa_allocator(0);
+  void* ptr = NULL;
+  IREE_ASSERT_OK(iree_allocator_malloc(allocator, 16, &ptr));
+  memset(ptr, 0xCD, 16);
+
+  // Growing beyond the initial page must preserve the contents.
+  IREE_ASSERT_OK(iree_allocator_realloc(allocator, 64 * 1024, &ptr));
+  for (int i = 0; i < 16; ++i) {
+    EXPECT_EQ(0xCD, ((uint8_t*)ptr)[i]);
+  }
+  memset(ptr, 0xAB, 64 * 1024);
+
+  // Shrinking can reuse the existing allocation.
+  IREE_ASSERT_OK(iree_allocator_realloc(allocator, 32, &ptr));
+  for (int i = 0; i < 32; ++i) {
+    EXPECT_EQ(0xAB, ((uint8_t*)ptr)[i]);
+  }
+  iree_allocator_free(allocator, ptr);
+}
+
+TEST(NUMATest, AllocatorHugePages) {
+  // Huge pages are a hint and allocations must succeed even if the system does
+  // not have them enabled or has no explicit huge pages reserved.
+  static const iree_numa_allocation_flags_t kFlags[] = {
+      IREE_NUMA_ALLOCATION_FLAG_TRANSPARENT_HUGE_PAGES,
+      IREE_NUMA_ALLOCATION_FLAG_EXPLICIT_HUGE_PAGES,
+      IREE_NUMA_ALLOCATION_FLAG_TRANSPARENT_HUGE_PAGES |
+          IREE_NUMA_ALLOCATION_FLAG_PREFAULT,
+  };
+  for (iree_numa_allocation_flags_t flags : kFlags) {
+    iree_allocator_t allocator =
+        iree_numa_allocator_with_flags(UINT32_MAX, flags);
+    const iree_host_size_t size = 2 * 1024 * 1024 + 4096;
+    void* ptr = NULL;
+    IREE_ASSERT_OK(iree_allocator_malloc(allocator, size, &ptr));
+    ASSERT_NE(nullptr, ptr);
+    EXPECT_EQ(0, ((uint8_t*)ptr)[0]);
+    EXPECT_EQ(0, ((uint8_t*)ptr)[size - 1]);
+    memset(ptr, 0xCD, size);
+
+    // Growing must preserve the contents and keep the flags.
+    IREE_ASSERT_OK(iree_allocator_realloc(allocator, 2 * size, &ptr));
+    EXPECT_EQ(0xCD, ((uint8_t*)ptr)[size - 1]);
+    memset(ptr, 0xAB, 2 * size);
+    iree_allocator_free(allocator, ptr);
+  }
+}
+
+TEST(NUMATest, AllocatorInvalidNode) {
+  // Nodes out of range fall back to the system allocator.
+  iree_allocator_t allocator = iree_numa_allocator(UINT32_MAX);
+  void* ptr = NULL;
+  IREE_ASSERT_OK(iree_allocator_malloc(allocator, 128, &ptr));
+  iree_allocator_free(allocator, ptr);
+}
+
+}  // namespace
@@ -0,0 +1,52 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+//==============================================================================
+//
+// SHA-256 (FIPS 180-4) content hashing.
+//
+// Used where contents are identified by their digest alone (such as to share
+// executables loaded from identical data) and a collision would be a
+// correctness issue. This is a straightforward portable implementation and not
+// intended for hashing large amounts of data on hot paths.
+//
+//==============================================================================
+
+#ifndef IREE_BASE_INTERNAL_SHA256_H_
+#define IREE_BASE_INTERNAL_SHA256_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Size in bytes of a SHA-256 digest.
+#define IREE_SHA256_DIGEST_SIZE 32
+
+// A SHA-256 digest.
+typedef struct iree_sha256_digest_t {
+  uint8_t bytes[IREE_SHA256_DIGEST_SIZE];
+} iree_sha256_digest_t;
+
+// Computes the SHA-256 digest of |data| into |out_digest|.
+void iree_sha256(iree_const_byte_span_t data, iree_sha256_digest_t* out_digest);
+
+// Returns true if digests |a| and |b| are equal.
+static inline bool iree_sha256_digest_equal(const iree_sha256_digest_t* a,
+                                            const iree_sha256_digest_t* b) {
+  return memcmp(a->bytes, b->bytes, sizeof(a->bytes)) == 0;
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // IREE_BASE_INTERNAL_SHA256_H_
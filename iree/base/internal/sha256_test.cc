@@ -0,0 +1,83 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/sha256.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "iree/testing/gtest.h"
+
+namespace {
+
+static std::string Sha256Hex(const void* data, size_t data_length) {
+  iree_sha256_digest_t digest;
+  iree_sha256(
+      iree_make_const_byte_span((const uint8_t*)data, data_length), &digest);
+  std::string hex;
+  for (uint8_t byte : digest.bytes) {
+    char buffer[3];
+    snprintf(buffer, sizeof(buffer), "%02x", byte);
+    hex += buffer;
+  }
+  return hex;
+}
+
+static std::string Sha256Hex(const char* message) {
+  return Sha256Hex(message, strlen(message));
+}
+
+// Test vectors from FIPS 180-4 examples and NIST CAVP SHA256ShortMsg.
+TEST(SHA256Test, KnownAnswers) {
+  EXPECT_EQ("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+            Sha256Hex(""));
+  EXPECT_EQ("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+            Sha256Hex("abc"));
+  // 56 bytes: the padding spills into a second block.
+  EXPECT_EQ(
+      "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+      Sha256Hex("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"));
+  // 112 bytes: one full block followed by a tail.
+  EXPECT_EQ(
+      "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1",
+      Sha256Hex("abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmn"
+                "hijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu"));
+}
+
+TEST(SHA256Test, MillionA) {
+  std::vector<uint8_t> data(1000000, 'a');
+  EXPECT_EQ("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0",
+            Sha256Hex(data.data(), data.size()));
+}
+
+TEST(SHA256Test, BlockBoundaries) {
+  // Digests of messages of every length around the padding boundaries must be
+  // distinct; a mistake in the tail handling typically causes collisions.
+  std::vector<uint8_t> data(130, 0);
+  std::vector<std::string> digests;
+  for (size_t length = 50; length <= data.size(); ++length) {
+    digests.push_back(Sha256Hex(data.data(), length));
+  }
+  for (size_t i = 0; i < digests.size(); ++i) {
+    for (size_t j = i + 1; j < digests.size(); ++j) {
+      EXPECT_NE(digests[i], digests[j]);
+    }
+  }
+}
+
+TEST(SHA256Test, DigestEqual) {
+  iree_sha256_digest_t a, b, c;
+  const uint8_t data[] = {1, 2, 3};
+  iree_sha256(iree_make_const_byte_span(data, sizeof(data)), &a);
+  iree_sha256(iree_make_const_byte_span(data, sizeof(data)), &b);
+  iree_sha256(iree_make_const_byte_span(data, 2), &c);
+  EXPECT_TRUE(iree_sha256_digest_equal(&a, &b));
+  EXPECT_FALSE(iree_sha256_digest_equal(&a, &c));
+}
+
+}  // namespace
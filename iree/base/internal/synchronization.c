@@ -8,6 +8,11 @@
 
 #include <assert.h>
 #include <string.h>
+#include <time.h>
+
+#if defined(IREE_ARCH_X86_32) || defined(IREE_ARCH_X86_64)
+#include <immintrin.h>
+#endif  // IREE_ARCH_X86_*
 
 #if IREE_SYNCHRONIZATION_DISABLE_UNSAFE
 
@@ -32,6 +37,12 @@
 #ifndef FUTEX_PRIVATE_FLAG
 #define FUTEX_PRIVATE_FLAG 128
 #endif  // !FUTEX_PRIVATE_FLAG
+#ifndef FUTEX_WAIT_BITSET
+#define FUTEX_WAIT_BITSET 9
+#endif  // !FUTEX_WAIT_BITSET
+#ifndef FUTEX_WAKE_BITSET
+#define FUTEX_WAKE_BITSET 10
+#endif  // !FUTEX_WAKE_BITSET
 
 #endif  // IREE_PLATFORM_*
 
@@ -70,6 +81,21 @@ static inline iree_status_t iree_futex_wait(void* address,
 // over lower priority waiters.
 static inline void iree_futex_wake(void* address, int32_t count);
 
+// Waits in the OS for the value at the specified |address| to change like
+// iree_futex_wait but only wakes for iree_futex_wake_bitset calls with a
+// |bitset| that intersects the one provided. There is no timeout.
+// Platforms without native support treat this as an iree_futex_wait and may
+// wake for any wake on |address|.
+static inline iree_status_t iree_futex_wait_bitset(void* address,
+                                                   uint32_t expected_value,
+                                                   uint32_t bitset);
+
+// Wakes at most |count| threads waiting for the |address| to change with a
+// wait bitset that intersects |bitset|. |bitset| must be non-zero.
+// Platforms without native support treat this as an iree_futex_wake.
+static inline void iree_futex_wake_bitset(void* address, int32_t count,
+                                          uint32_t bitset);
+
 #if defined(IREE_PLATFORM_EMSCRIPTEN)
 
 static inline iree_status_t iree_futex_wait(void* address,
@@ -141,8 +167,40 @@ static inline void iree_futex_wake(void* address, int32_t count) {
           NULL, 0);
 }
 
+#define IREE_PLATFORM_HAS_FUTEX_BITSET 1
+
+static inline iree_status_t iree_futex_wait_bitset(void* address,
+                                                   uint32_t expected_value,
+                                                   uint32_t bitset) {
+  int rc = syscall(SYS_futex, address, FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG,
+                   expected_value, NULL, NULL, bitset);
+  if (IREE_LIKELY(rc == 0)) return iree_ok_status();
+  return iree_status_from_code(IREE_STATUS_UNAVAILABLE);
+}
+
+static inline void iree_futex_wake_bitset(void* address, int32_t count,
+                                          uint32_t bitset) {
+  syscall(SYS_futex, address, FUTEX_WAKE_BITSET | FUTEX_PRIVATE_FLAG, count,
+          NULL, NULL, bitset);
+}
+
 #endif  // IREE_PLATFORM_*
 
+#if !defined(IREE_PLATFORM_HAS_FUTEX_BITSET)
+
+static inline iree_status_t iree_futex_wait_bitset(void* address,
+                                                   uint32_t expected_value,
+                                                   uint32_t bitset) {
+  return iree_futex_wait(address, expected_value, IREE_INFINITE_TIMEOUT_MS);
+}
+
+static inline void iree_futex_wake_bitset(void* address, int32_t count,
+                                          uint32_t bitset) {
+  iree_futex_wake(address, count);
+}
+
+#endif  // !IREE_PLATFORM_HAS_FUTEX_BITSET
+
 #endif  // IREE_PLATFORM_HAS_FUTEX
 
 //==============================================================================
@@ -608,20 +666,54 @@ iree_wait_token_t iree_notification_prepare_wait(
 
 void iree_notification_commit_wait(iree_notification_t* notification,
                                    iree_wait_token_t wait_token) {
+  iree_notification_commit_wait_until(notification, wait_token,
+                                      IREE_TIME_INFINITE_FUTURE);
+}
+
+bool iree_notification_commit_wait_until(iree_notification_t* notification,
+                                         iree_wait_token_t wait_token,
+                                         iree_time_t deadline_ns) {
   // Spin until notified and the epoch increments from what we captured during
   // iree_notification_prepare_wait.
+  bool notified = true;
   while ((iree_atomic_load_int64(&notification->value,
                                  iree_memory_order_acquire) >>
           IREE_NOTIFICATION_EPOCH_SHIFT) == wait_token) {
+    uint32_t timeout_ms = IREE_INFINITE_TIMEOUT_MS;
+    if (deadline_ns != IREE_TIME_INFINITE_FUTURE) {
+      iree_duration_t timeout_ns =
+          iree_absolute_deadline_to_timeout_ns(deadline_ns);
+      if (timeout_ns <= 0) {
+        notified = false;
+        break;
+      }
+      // Round up so that we don't spin on sub-millisecond remainders.
+      timeout_ms = (uint32_t)iree_min((timeout_ns + 999999) / 1000000,
+                                      (iree_duration_t)UINT32_MAX - 1);
+    }
 #if IREE_SYNCHRONIZATION_DISABLE_UNSAFE
     // TODO(benvanik): platform sleep? this spins.
+    (void)timeout_ms;
 #elif defined(IREE_PLATFORM_HAS_FUTEX)
     iree_status_ignore(
         iree_futex_wait(iree_notification_epoch_address(notification),
-                        wait_token, IREE_INFINITE_TIMEOUT_MS));
+                        wait_token, timeout_ms));
 #else
     pthread_mutex_lock(&notification->mutex);
-    pthread_cond_wait(&notification->cond, &notification->mutex);
+    if (timeout_ms == IREE_INFINITE_TIMEOUT_MS) {
+      pthread_cond_wait(&notification->cond, &notification->mutex);
+    } else {
+      struct timespec abstime;
+      clock_gettime(CLOCK_REALTIME, &abstime);
+      abstime.tv_sec += timeout_ms / 1000;
+      abstime.tv_nsec += (timeout_ms % 1000) * 1000000;
+      if (abstime.tv_nsec >= 1000000000) {
+        abstime.tv_sec += 1;
+        abstime.tv_nsec -= 1000000000;
+      }
+      pthread_cond_timedwait(&notification->cond, &notification->mutex,
+                             &abstime);
+    }
     pthread_mutex_unlock(&notification->mutex);
 #endif  // IREE_PLATFORM_HAS_FUTEX
   }
@@ -633,6 +725,7 @@ void iree_notification_commit_wait(iree_notification_t* notification,
       &notification->value, IREE_NOTIFICATION_WAITER_DEC,
       iree_memory_order_seq_cst);
   SYNC_ASSERT((previous_value & IREE_NOTIFICATION_WAITER_MASK) != 0);
+  return notified;
 }
 
 void iree_notification_cancel_wait(iree_notification_t* notification) {
@@ -664,3 +757,166 @@ void iree_notification_await(iree_notification_t* notification,
     }
   }
 }
+
+bool iree_notification_await_until(iree_notification_t* notification,
+                                   iree_condition_fn_t condition_fn,
+                                   void* condition_arg,
+                                   iree_time_t deadline_ns) {
+  if (IREE_LIKELY(condition_fn(condition_arg))) {
+    // Fast-path with condition already met.
+    return true;
+  } else if (deadline_ns == IREE_TIME_INFINITE_PAST) {
+    // Polling only.
+    return false;
+  }
+  // Slow-path: try-wait until the condition is met or the deadline elapses.
+  while (true) {
+    iree_wait_token_t wait_token = iree_notification_prepare_wait(notification);
+    if (condition_fn(condition_arg)) {
+      // Condition is now met; no need to wait on the futex.
+      iree_notification_cancel_wait(notification);
+      return true;
+    } else if (!iree_notification_commit_wait_until(notification, wait_token,
+                                                    deadline_ns)) {
+      // Deadline elapsed; the condition may have been met just prior.
+      return condition_fn(condition_arg);
+    }
+  }
+}
+
+//==============================================================================
+// iree_notification_set_t
+//==============================================================================
+
+// Hints to the processor that the caller is in a spin-wait loop.
+static inline void iree_notification_set_spin_pause(void) {
+#if defined(IREE_ARCH_X86_32) || defined(IREE_ARCH_X86_64)
+  _mm_pause();
+#elif defined(IREE_ARCH_ARM_64) && !defined(IREE_COMPILER_MSVC)
+  __asm__ __volatile__("yield");
+#endif  // IREE_ARCH_*
+}
+
+// Folds a 64-bit waiter mask into the 32-bit futex bitset. Waiters 32 apart
+// share a bit and may be woken for each other's posts; they check their own
+// posted bit and go back to sleep.
+static inline uint32_t iree_notification_set_futex_bitset(
+    uint64_t waiter_mask) {
+  return (uint32_t)waiter_mask | (uint32_t)(waiter_mask >> 32);
+}
+
+void iree_notification_set_initialize(iree_notification_set_t* out_set) {
+  memset(out_set, 0, sizeof(*out_set));
+#if IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+  // Nothing required.
+#elif !defined(IREE_PLATFORM_HAS_FUTEX)
+  pthread_mutex_init(&out_set->mutex, NULL);
+  pthread_cond_init(&out_set->cond, NULL);
+#endif  // IREE_PLATFORM_HAS_FUTEX
+}
+
+void iree_notification_set_deinitialize(iree_notification_set_t* set) {
+  // Assert no more waiters (callers must tear down waiters first).
+  SYNC_ASSERT(iree_atomic_load_int64(&set->parked_mask,
+                                     iree_memory_order_seq_cst) == 0);
+#if IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+  // Nothing required.
+#elif !defined(IREE_PLATFORM_HAS_FUTEX)
+  pthread_cond_destroy(&set->cond);
+  pthread_mutex_destroy(&set->mutex);
+#endif  // IREE_PLATFORM_HAS_FUTEX
+}
+
+void iree_notification_set_post(iree_notification_set_t* set,
+                                uint64_t waiter_mask) {
+  // Record the posts first so that waiters that have not yet parked observe
+  // them when they check prior to parking.
+  iree_atomic_fetch_or_int64(&set->posted_mask, (int64_t)waiter_mask,
+                             iree_memory_order_seq_cst);
+  uint64_t parked_mask = (uint64_t)iree_atomic_load_int64(
+                             &set->parked_mask, iree_memory_order_seq_cst) &
+                         waiter_mask;
+  if (!parked_mask) return;  // no one to wake
+
+  // Advance the wake word so that waiters between checking their posted bit
+  // and parking fail their futex wait and recheck.
+  iree_atomic_fetch_add_int32(&set->epoch, 1, iree_memory_order_seq_cst);
+#if IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+  // Nothing required.
+#elif defined(IREE_PLATFORM_HAS_FUTEX)
+  iree_futex_wake_bitset(&set->epoch, IREE_ALL_WAITERS,
+                         iree_notification_set_futex_bitset(parked_mask));
+#else
+  pthread_mutex_lock(&set->mutex);
+  pthread_cond_broadcast(&set->cond);
+  pthread_mutex_unlock(&set->mutex);
+#endif  // IREE_PLATFORM_HAS_FUTEX
+}
+
+void iree_notification_set_prepare_wait(iree_notification_set_t* set,
+                                        iree_host_size_t waiter_index) {
+  SYNC_ASSERT(waiter_index < IREE_NOTIFICATION_SET_MAX_WAITERS);
+  const uint64_t waiter_bit = 1ull << waiter_index;
+  // Only touch the shared cache line for writing if we were posted to; waiters
+  // prepare on every pass through their loops and usually have not been.
+  if ((uint64_t)iree_atomic_load_int64(&set->posted_mask,
+                                       iree_memory_order_acquire) &
+      waiter_bit) {
+    iree_atomic_fetch_and_int64(&set->posted_mask, ~(int64_t)waiter_bit,
+                                iree_memory_order_acq_rel);
+  }
+}
+
+bool iree_notification_set_commit_wait(iree_notification_set_t* set,
+                                       iree_host_size_t waiter_index,
+                                       uint32_t spin_count) {
+  SYNC_ASSERT(waiter_index < IREE_NOTIFICATION_SET_MAX_WAITERS);
+  const uint64_t waiter_bit = 1ull << waiter_index;
+
+  // Spin for a bit first in case a post is about to arrive; this avoids the
+  // syscalls (and the scheduler latency) on both sides of a park/wake.
+  for (uint32_t i = 0; i < spin_count; ++i) {
+    if ((uint64_t)iree_atomic_load_int64(&set->posted_mask,
+                                         iree_memory_order_acquire) &
+        waiter_bit) {
+      return false;
+    }
+    iree_notification_set_spin_pause();
+  }
+
+  // Mark ourselves as parked so that posters know to wake us. This pairs with
+  // the posted_mask update in iree_notification_set_post: either the poster
+  // observes our parked bit or we observe its posted bit.
+  iree_atomic_fetch_or_int64(&set->parked_mask, (int64_t)waiter_bit,
+                             iree_memory_order_seq_cst);
+  bool did_park = false;
+  while (true) {
+    // The epoch must be captured before checking our posted bit so that a post
+    // landing between the check and the wait changes it and fails the wait.
+    uint32_t epoch = (uint32_t)iree_atomic_load_int32(
+        &set->epoch, iree_memory_order_seq_cst);
+    if ((uint64_t)iree_atomic_load_int64(&set->posted_mask,
+                                         iree_memory_order_seq_cst) &
+        waiter_bit) {
+      break;
+    }
+    did_park = true;
+#if IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+    // TODO(benvanik): platform sleep? this spins.
+    (void)epoch;
+#elif defined(IREE_PLATFORM_HAS_FUTEX)
+    iree_status_ignore(iree_futex_wait_bitset(
+        &set->epoch, epoch, iree_notification_set_futex_bitset(waiter_bit)));
+#else
+    pthread_mutex_lock(&set->mutex);
+    if (iree_atomic_load_int32(&set->epoch, iree_memory_order_seq_cst) ==
+        (int32_t)epoch) {
+      pthread_cond_wait(&set->cond, &set->mutex);
+    }
+    pthread_mutex_unlock(&set->mutex);
+#endif  // IREE_PLATFORM_HAS_FUTEX
+  }
+  iree_atomic_fetch_and_int64(&set->parked_mask, ~(int64_t)waiter_bit,
+                              iree_memory_order_seq_cst);
+  return did_park;
+}
@@ -340,6 +340,14 @@ iree_wait_token_t iree_notification_prepare_wait(
 void iree_notification_commit_wait(iree_notification_t* notification,
                                    iree_wait_token_t wait_token);
 
+// Commits a pending wait operation like iree_notification_commit_wait but
+// gives up once |deadline_ns| has elapsed. Returns true if a notification was
+// posted and false if the deadline elapsed first. The pending wait is completed
+// in either case and must not be cancelled.
+bool iree_notification_commit_wait_until(iree_notification_t* notification,
+                                         iree_wait_token_t wait_token,
+                                         iree_time_t deadline_ns);
+
 // Cancels a pending wait operation without blocking.
 //
 // Acts as (at least) a memory_order_relaxed barrier:
@@ -371,6 +379,82 @@ void iree_notification_await(iree_notification_t* notification,
                              iree_condition_fn_t condition_fn,
                              void* condition_arg);
 
+// Blocks and waits until |condition_fn| returns true or |deadline_ns| elapses.
+// Returns true if the condition was met and false if the deadline elapsed
+// first. A deadline of IREE_TIME_INFINITE_PAST polls the condition once.
+bool iree_notification_await_until(iree_notification_t* notification,
+                                   iree_condition_fn_t condition_fn,
+                                   void* condition_arg,
+                                   iree_time_t deadline_ns);
+
+//==============================================================================
+// iree_notification_set_t
+//==============================================================================
+
+// Maximum number of waiters that may share a single iree_notification_set_t.
+#define IREE_NOTIFICATION_SET_MAX_WAITERS 64
+
+// A set of up to IREE_NOTIFICATION_SET_MAX_WAITERS notifications sharing a
+// single wake word so that any subset of them can be posted at once.
+// Each waiter is identified by a stable index in the set and only one thread
+// may wait on a particular index at a time.
+//
+// Where available (Linux/Android) posting uses FUTEX_WAKE_BITSET so that all of
+// the waiters in a mask are woken with a single syscall instead of one per
+// waiter, letting the kernel see the full set of threads that need to run.
+// Other platforms wake all parked waiters of the set and those not posted
+// return to sleep without the caller observing the wake.
+typedef struct iree_notification_set_t {
+#if IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+  // Nothing required.
+#elif !defined(IREE_PLATFORM_HAS_FUTEX)
+  // No futex on darwin, so use mutex/condvar instead.
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+#endif  // IREE_PLATFORM_*
+  // Bitmask of waiters that have been posted since they last prepared a wait.
+  iree_atomic_int64_t posted_mask;
+  // Bitmask of waiters that are (or are about to be) parked in the OS.
+  iree_atomic_int64_t parked_mask;
+  // Wake word incremented each time a parked waiter is posted.
+  iree_atomic_int32_t epoch;
+} iree_notification_set_t;
+
+// Initializes a notification set with no waiters.
+void iree_notification_set_initialize(iree_notification_set_t* out_set);
+
+// Deinitializes |set| (after a prior call to iree_notification_set_initialize).
+// No threads may be waiting on the set.
+void iree_notification_set_deinitialize(iree_notification_set_t* set);
+
+// Posts a notification to each waiter with a bit set in |waiter_mask|.
+// Waiters that are not currently parked only have their bit recorded and no
+// syscall is made. All parked waiters in the mask are woken together.
+//
+// Acts as (at least) a memory_order_release barrier.
+void iree_notification_set_post(iree_notification_set_t* set,
+                                uint64_t waiter_mask);
+
+// Prepares for a wait operation by |waiter_index|. Any post made after this
+// call returns will cause the following iree_notification_set_commit_wait to
+// return without blocking. Callers must check their wait condition after
+// preparing and before committing. No cancellation is required if the caller
+// decides not to wait.
+//
+// Acts as a memory_order_acq_rel barrier.
+void iree_notification_set_prepare_wait(iree_notification_set_t* set,
+                                        iree_host_size_t waiter_index);
+
+// Commits a pending wait operation when the caller has ensured it must wait.
+// The waiter first spins for up to |spin_count| iterations checking for a post
+// before parking in the OS; pass 0 to park immediately. Returns true if the
+// waiter had to park and false if a post was observed while spinning.
+//
+// Acts as (at least) a memory_order_acquire barrier.
+bool iree_notification_set_commit_wait(iree_notification_set_t* set,
+                                       iree_host_size_t waiter_index,
+                                       uint32_t spin_count);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
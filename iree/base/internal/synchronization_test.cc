@@ -6,6 +6,8 @@
 
 #include "iree/base/internal/synchronization.h"
 
+#include <atomic>
+#include <chrono>
 #include <thread>
 
 #include "iree/testing/gtest.h"
@@ -173,6 +175,97 @@ TEST(SlimMutexTest, ExclusiveAccessTryLock) {
 // iree_notification_t
 //==============================================================================
 
-// Tested implicitly in threading_test.cc.
+// Basic wait/post behavior is tested implicitly in threading_test.cc.
+
+// Waits with a deadline should time out if the condition is never met.
+TEST(NotificationTest, AwaitUntilTimeout) {
+  iree_notification_t notification;
+  iree_notification_initialize(&notification);
+  auto condition_fn = +[](void* arg) -> bool { return false; };
+  EXPECT_FALSE(iree_notification_await_until(&notification, condition_fn,
+                                             NULL, IREE_TIME_INFINITE_PAST));
+  EXPECT_FALSE(iree_notification_await_until(
+      &notification, condition_fn, NULL,
+      iree_relative_timeout_to_deadline_ns(10 * 1000000)));
+  iree_notification_deinitialize(&notification);
+}
+
+// Waits with a deadline should return as soon as the condition is met.
+TEST(NotificationTest, AwaitUntilPosted) {
+  iree_notification_t notification;
+  iree_notification_initialize(&notification);
+  std::atomic<bool> flag = {false};
+  auto condition_fn = +[](void* arg) -> bool {
+    return static_cast<std::atomic<bool>*>(arg)->load();
+  };
+  std::thread th1([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    flag = true;
+    iree_notification_post(&notification, IREE_ALL_WAITERS);
+  });
+  EXPECT_TRUE(iree_notification_await_until(
+      &notification, condition_fn, &flag,
+      iree_relative_timeout_to_deadline_ns(60 * 1000000000ll)));
+  th1.join();
+  iree_notification_deinitialize(&notification);
+}
+
+//==============================================================================
+// iree_notification_set_t
+//==============================================================================
+
+// Posts made after preparing a wait should prevent the wait from blocking.
+TEST(NotificationSetTest, PostBeforeCommit) {
+  iree_notification_set_t set;
+  iree_notification_set_initialize(&set);
+  iree_notification_set_prepare_wait(&set, 3);
+  iree_notification_set_post(&set, 1ull << 3);
+  EXPECT_FALSE(iree_notification_set_commit_wait(&set, 3, /*spin_count=*/0));
+  iree_notification_set_deinitialize(&set);
+}
+
+// Only the waiters posted should wake, including waiters sharing a futex bit
+// with a posted waiter (indices 32 apart).
+TEST(NotificationSetTest, WakeSubset) {
+  iree_notification_set_t set;
+  iree_notification_set_initialize(&set);
+
+  static constexpr int kWaiterIndices[] = {1, 33, 63};
+  std::atomic<int> wake_counts[3] = {{0}, {0}, {0}};
+  std::atomic<bool> exit_requested = {false};
+  std::thread threads[3];
+  for (int i = 0; i < 3; ++i) {
+    threads[i] = std::thread([&, i]() {
+      while (true) {
+        iree_notification_set_prepare_wait(&set, kWaiterIndices[i]);
+        if (exit_requested.load()) break;
+        iree_notification_set_commit_wait(&set, kWaiterIndices[i],
+                                          /*spin_count=*/0);
+        ++wake_counts[i];
+      }
+    });
+  }
+
+  // Wake just the waiter at index 1; the waiter at 33 shares its futex bit but
+  // must not observe the post.
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  iree_notification_set_post(&set, 1ull << 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(1, wake_counts[0].load());
+  EXPECT_EQ(0, wake_counts[1].load());
+  EXPECT_EQ(0, wake_counts[2].load());
+
+  // Wake the other two together.
+  iree_notification_set_post(&set, (1ull << 33) | (1ull << 63));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(1, wake_counts[0].load());
+  EXPECT_EQ(1, wake_counts[1].load());
+  EXPECT_EQ(1, wake_counts[2].load());
+
+  exit_requested = true;
+  iree_notification_set_post(&set, (1ull << 1) | (1ull << 33) | (1ull << 63));
+  for (auto& thread : threads) thread.join();
+  iree_notification_set_deinitialize(&set);
+}
 
 }  // namespace
@@ -95,7 +95,10 @@ iree_status_t iree_wait_handle_ctl(iree_wait_source_t wait_source,
 // particular set at any time.
 typedef struct iree_wait_set_t iree_wait_set_t;
 
-// Allocates a wait set with the maximum |capacity| of unique handles.
+// Allocates a wait set with an initial |capacity| of unique handles.
+// Implementations backed by kernel-managed sets (epoll) grow as needed and are
+// effectively unbounded while others (poll/WaitForMultipleObjects) fail
+// insertions beyond |capacity| with IREE_STATUS_RESOURCE_EXHAUSTED.
 iree_status_t iree_wait_set_allocate(iree_host_size_t capacity,
                                      iree_allocator_t allocator,
                                      iree_wait_set_t** out_set);
@@ -9,58 +9,392 @@
 
 #if IREE_WAIT_API == IREE_WAIT_API_EPOLL
 
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <time.h>
+#include <unistd.h>
+
 #include "iree/base/internal/wait_handle_posix.h"
 #include "iree/base/tracing.h"
 
+//===----------------------------------------------------------------------===//
+// Platform utilities
+//===----------------------------------------------------------------------===//
+
+// Maximum number of events returned from a single epoll_wait during
+// iree_wait_all. iree_wait_any only ever needs one.
+#define IREE_WAIT_SET_EPOLL_EVENT_BATCH_SIZE 64
+
+// Converts an absolute deadline into an epoll_wait timeout in milliseconds.
+// epoll only supports millisecond granularity so we round up to ensure that we
+// never wake before the deadline and spin.
+static int iree_epoll_timeout_ms(iree_time_t deadline_ns) {
+  if (deadline_ns == IREE_TIME_INFINITE_PAST) {
+    return 0;
+  } else if (deadline_ns == IREE_TIME_INFINITE_FUTURE) {
+    return -1;
+  }
+  iree_duration_t timeout_ns = deadline_ns - iree_time_now();
+  if (timeout_ns <= 0) return 0;
+  iree_duration_t timeout_ms = (timeout_ns + 1000000 - 1) / 1000000;
+  return timeout_ms > INT32_MAX ? INT32_MAX : (int)timeout_ms;
+}
+
+// epoll_wait may spuriously wake with an EINTR. We don't do anything with that
+// opportunity (no fancy signal stuff), but we do need to retry the wait and
+// ensure that we do so with an updated timeout based on the deadline.
+//
+// Documentation: https://man7.org/linux/man-pages/man2/epoll_wait.2.html
+static iree_status_t iree_syscall_epoll_wait(int epoll_fd,
+                                             struct epoll_event* events,
+                                             int max_events,
+                                             iree_time_t deadline_ns,
+                                             int* out_signaled_count) {
+  *out_signaled_count = 0;
+  int rv = -1;
+  do {
+    rv = epoll_wait(epoll_fd, events, max_events,
+                    iree_epoll_timeout_ms(deadline_ns));
+  } while (rv < 0 && errno == EINTR);
+  if (rv > 0) {
+    // One or more events set.
+    *out_signaled_count = rv;
+    return iree_ok_status();
+  } else if (IREE_UNLIKELY(rv < 0)) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "epoll_wait failure %d", errno);
+  }
+  // rv == 0
+  // Timeout; no events set.
+  return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+}
+
+// Maps an epoll event bitfield result to a status (on failure) and an
+// indicator of whether the handle was signaled.
+static iree_status_t iree_wait_set_resolve_epoll_events(uint32_t events,
+                                                        bool* out_signaled) {
+  if (events & EPOLLERR) {
+    return iree_make_status(IREE_STATUS_INTERNAL, "EPOLLERR on fd");
+  } else if (events & EPOLLHUP) {
+    return iree_make_status(IREE_STATUS_CANCELLED, "EPOLLHUP on fd");
+  }
+  *out_signaled = (events & (EPOLLIN | EPOLLPRI)) != 0;
+  return iree_ok_status();
+}
+
 //===----------------------------------------------------------------------===//
 // iree_wait_set_t
 //===----------------------------------------------------------------------===//
 
-// TODO(benvanik): iree_wait_set_s using an epoll fd.
-// epoll lets us route the wait set operations right to kernel and not need our
-// own duplicate data structure. epoll is great, just not available on mac/ios
-// so we still need poll for that. linux/android/bsd all have epoll, though.
+// A handle in the set. Entries are stored in a table indexed by their read fd
+// as fds are small dense integers; this makes insert/erase/wake O(1) without
+// needing a separate lookup structure.
+typedef struct iree_wait_set_entry_t {
+  // Number of times the handle has been inserted. 0 if the entry is unused.
+  uint32_t reference_count;
+  // True if the handle was observed signaled during an iree_wait_all and has
+  // been disabled in the epoll set until the wait completes.
+  bool is_disabled;
+  // User-provided handle.
+  iree_wait_handle_t handle;
+} iree_wait_set_entry_t;
+
+// epoll lets us route the wait set operations right to the kernel which
+// maintains the set incrementally and only reports ready handles. Unlike the
+// poll-based implementation the set is not limited to its initial capacity and
+// waits are O(ready) instead of O(handles).
 struct iree_wait_set_t {
-  // NOTE: we could in theory use the epoll handle directly (iree_wait_set_s
-  // then is just a pointer). Then allocate/free just go straight to the system.
-  int reserved;
+  iree_allocator_t allocator;
+
+  // epoll instance containing each unique handle in the set.
+  int epoll_fd;
+
+  // Total number of unique handles in the set.
+  iree_host_size_t handle_count;
+
+  // Table of entries indexed by read fd. Grown on demand to fit the largest
+  // fd inserted.
+  iree_host_size_t entry_capacity;
+  iree_wait_set_entry_t* entries;
 };
 
 iree_status_t iree_wait_set_allocate(iree_host_size_t capacity,
                                      iree_allocator_t allocator,
                                      iree_wait_set_t** out_set) {
-  // TODO(benvanik): epoll_create()
+  // The set will grow as needed but an initial capacity this large indicates
+  // a bug in the caller.
+  if (capacity >= UINT16_MAX) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "wait set capacity of %zu is unreasonably large",
+                            capacity);
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_wait_set_t* set = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(allocator, sizeof(*set), (void**)&set));
+  memset(set, 0, sizeof(*set));
+  set->allocator = allocator;
+
+  iree_status_t status = iree_ok_status();
+  set->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (set->epoll_fd < 0) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "epoll_create1 failure %d", errno);
+  }
+
+  if (iree_status_is_ok(status) && capacity > 0) {
+    status = iree_allocator_malloc(allocator, capacity * sizeof(*set->entries),
+                                   (void**)&set->entries);
+    if (iree_status_is_ok(status)) {
+      memset(set->entries, 0, capacity * sizeof(*set->entries));
+      set->entry_capacity = capacity;
+    }
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_set = set;
+  } else {
+    iree_wait_set_free(set);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
 void iree_wait_set_free(iree_wait_set_t* set) {
-  // TODO(benvanik): close()
+  if (!set) return;
+  if (set->epoll_fd >= 0) close(set->epoll_fd);
+  iree_allocator_free(set->allocator, set->entries);
+  iree_allocator_free(set->allocator, set);
+}
+
+// Grows the entry table such that it can hold |fd|.
+static iree_status_t iree_wait_set_reserve(iree_wait_set_t* set, int fd) {
+  if ((iree_host_size_t)fd < set->entry_capacity) return iree_ok_status();
+  iree_host_size_t new_capacity =
+      iree_max((iree_host_size_t)fd + 1, set->entry_capacity * 2);
+  // NOTE: we allocate and copy instead of using iree_allocator_realloc as sets
+  // are commonly allocated from arenas (which cannot realloc).
+  iree_wait_set_entry_t* new_entries = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      set->allocator, new_capacity * sizeof(*new_entries),
+      (void**)&new_entries));
+  if (set->entry_capacity > 0) {
+    memcpy(new_entries, set->entries,
+           set->entry_capacity * sizeof(*new_entries));
+  }
+  memset(&new_entries[set->entry_capacity], 0,
+         (new_capacity - set->entry_capacity) * sizeof(*new_entries));
+  iree_allocator_free(set->allocator, set->entries);
+  set->entries = new_entries;
+  set->entry_capacity = new_capacity;
+  return iree_ok_status();
 }
 
 iree_status_t iree_wait_set_insert(iree_wait_set_t* set,
                                    iree_wait_handle_t handle) {
-  // TODO(benvanik): epoll_ctl(EPOLL_CTL_ADD)
+  int fd = iree_wait_primitive_get_read_fd(&handle);
+  if (IREE_UNLIKELY(fd < 0)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "wait handle type %d has no pollable fd",
+                            (int)handle.type);
+  }
+  IREE_RETURN_IF_ERROR(iree_wait_set_reserve(set, fd));
+
+  // Duplicates are just reference counted as epoll only allows an fd to be
+  // registered once.
+  iree_wait_set_entry_t* entry = &set->entries[fd];
+  if (entry->reference_count > 0) {
+    ++entry->reference_count;
+    return iree_ok_status();
+  }
+
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN | EPOLLPRI;  // implicit EPOLLERR | EPOLLHUP
+  event.data.fd = fd;
+  if (IREE_UNLIKELY(epoll_ctl(set->epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0)) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "epoll_ctl add failure %d", errno);
+  }
+
+  entry->reference_count = 1;
+  entry->is_disabled = false;
+  IREE_IGNORE_ERROR(iree_wait_handle_wrap_primitive(handle.type, handle.value,
+                                                    &entry->handle));
+  ++set->handle_count;
+  return iree_ok_status();
+}
+
+// Removes the entry for |fd| from the set entirely.
+static void iree_wait_set_remove_entry(iree_wait_set_t* set, int fd) {
+  iree_wait_set_entry_t* entry = &set->entries[fd];
+  // NOTE: this may fail if the fd was closed prior to removal; the kernel
+  // removes closed fds from the set automatically so that's fine.
+  epoll_ctl(set->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+  memset(entry, 0, sizeof(*entry));
+  --set->handle_count;
 }
 
 void iree_wait_set_erase(iree_wait_set_t* set, iree_wait_handle_t handle) {
-  // TODO(benvanik): epoll_ctl(EPOLL_CTL_DEL)
+  int fd = iree_wait_primitive_get_read_fd(&handle);
+  if (fd < 0 || (iree_host_size_t)fd >= set->entry_capacity) return;
+  iree_wait_set_entry_t* entry = &set->entries[fd];
+  if (entry->reference_count == 0) return;
+  if (--entry->reference_count == 0) {
+    iree_wait_set_remove_entry(set, fd);
+  }
 }
 
 void iree_wait_set_clear(iree_wait_set_t* set) {
-  // TODO(benvanik): close and reopen?
+  for (iree_host_size_t fd = 0;
+       fd < set->entry_capacity && set->handle_count > 0; ++fd) {
+    if (set->entries[fd].reference_count > 0) {
+      iree_wait_set_remove_entry(set, (int)fd);
+    }
+  }
+}
+
+// Enables or disables reporting of events on the entry for |fd|.
+static iree_status_t iree_wait_set_enable_entry(iree_wait_set_t* set, int fd,
+                                                bool enabled) {
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = enabled ? (EPOLLIN | EPOLLPRI) : 0;
+  event.data.fd = fd;
+  if (IREE_UNLIKELY(epoll_ctl(set->epoll_fd, EPOLL_CTL_MOD, fd, &event) < 0)) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "epoll_ctl mod failure %d", errno);
+  }
+  set->entries[fd].is_disabled = !enabled;
+  return iree_ok_status();
 }
 
 iree_status_t iree_wait_all(iree_wait_set_t* set, iree_time_t deadline_ns) {
-  // TODO(benvanik): epoll_wait
+  // Make the syscall only when we have at least one valid fd.
+  // Don't use this as a sleep.
+  if (set->handle_count == 0) {
+    return iree_ok_status();
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Wait-all requires that we repeatedly wait until all handles have been
+  // signaled. epoll is level-triggered so a handle that has signaled would be
+  // reported again on every wait; to avoid that (and not miss events) we
+  // disable any handle we have observed signaled so that the kernel ignores it
+  // and only when all handles are disabled have we waited for all of them.
+  struct epoll_event events[IREE_WAIT_SET_EPOLL_EVENT_BATCH_SIZE];
+  iree_status_t status = iree_ok_status();
+  iree_host_size_t unsignaled_count = set->handle_count;
+  while (iree_status_is_ok(status) && unsignaled_count > 0) {
+    int signaled_count = 0;
+    status = iree_syscall_epoll_wait(set->epoll_fd, events,
+                                     IREE_ARRAYSIZE(events), deadline_ns,
+                                     &signaled_count);
+    for (int i = 0; i < signaled_count && iree_status_is_ok(status); ++i) {
+      bool signaled = false;
+      status = iree_wait_set_resolve_epoll_events(events[i].events, &signaled);
+      if (iree_status_is_ok(status) && signaled) {
+        status = iree_wait_set_enable_entry(set, events[i].data.fd,
+                                            /*enabled=*/false);
+        --unsignaled_count;
+      }
+    }
+  }
+
+  // Since we disabled handles during the operation we need to re-enable them
+  // so that the next wait can happen. Wait-all is rare enough that a scan of
+  // the table is fine here.
+  for (iree_host_size_t fd = 0; fd < set->entry_capacity; ++fd) {
+    if (set->entries[fd].is_disabled) {
+      status = iree_status_join(
+          status, iree_wait_set_enable_entry(set, (int)fd, /*enabled=*/true));
+    }
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
 iree_status_t iree_wait_any(iree_wait_set_t* set, iree_time_t deadline_ns,
                             iree_wait_handle_t* out_wake_handle) {
-  // TODO(benvanik): epoll_wait
+  // Make the syscall only when we have at least one valid fd.
+  // Don't use this as a sleep.
+  memset(out_wake_handle, 0, sizeof(*out_wake_handle));
+  if (set->handle_count == 0) {
+    return iree_ok_status();
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // We only need a single signaled handle and the kernel only returns those
+  // that are ready so this is O(1) regardless of how many handles are in the
+  // set. Level-triggered events are requeued at the tail of the ready list
+  // by the kernel so repeated waits will rotate through all ready handles.
+  struct epoll_event event;
+  int signaled_count = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_syscall_epoll_wait(set->epoll_fd, &event, 1, deadline_ns,
+                                  &signaled_count));
+  bool signaled = false;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_wait_set_resolve_epoll_events(event.events, &signaled));
+  if (signaled) {
+    memcpy(out_wake_handle, &set->entries[event.data.fd].handle,
+           sizeof(*out_wake_handle));
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
 }
 
 iree_status_t iree_wait_one(iree_wait_handle_t* handle,
                             iree_time_t deadline_ns) {
-  // TODO(benvanik): just use poll?
+  // A single handle doesn't benefit from an epoll set so we use ppoll directly
+  // which avoids creating (and tearing down) an epoll instance per wait.
+  struct pollfd poll_fd;
+  poll_fd.fd = iree_wait_primitive_get_read_fd(handle);
+  if (poll_fd.fd == -1) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "wait handle type %d has no pollable fd",
+                            (int)handle->type);
+  }
+  poll_fd.events = POLLIN;
+  poll_fd.revents = 0;
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  int rv = -1;
+  do {
+    struct timespec timeout_ts;
+    struct timespec* tmo_p = &timeout_ts;
+    if (deadline_ns == IREE_TIME_INFINITE_PAST) {
+      memset(&timeout_ts, 0, sizeof(timeout_ts));
+    } else if (deadline_ns == IREE_TIME_INFINITE_FUTURE) {
+      tmo_p = NULL;
+    } else {
+      iree_duration_t timeout_ns = deadline_ns - iree_time_now();
+      if (timeout_ns < 0) timeout_ns = 0;
+      timeout_ts.tv_sec = (time_t)(timeout_ns / 1000000000ull);
+      timeout_ts.tv_nsec = (long)(timeout_ns % 1000000000ull);
+    }
+    rv = ppoll(&poll_fd, 1, tmo_p, NULL);
+  } while (rv < 0 && errno == EINTR);
+
+  iree_status_t status = iree_ok_status();
+  if (rv < 0) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "ppoll failure %d", errno);
+  } else if (rv == 0) {
+    status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
 #endif  // IREE_WAIT_API == IREE_WAIT_API_EPOLL
@@ -48,11 +48,15 @@
 #define IREE_WAIT_API IREE_WAIT_API_WIN32  // WFMO used in wait_handle_win32.c
 #else
 
-// TODO(benvanik): EPOLL on android/linux/bsd/etc.
+// EPOLL is only used on Linux and Android; other POSIX platforms (the BSDs,
+// etc) use PPOLL.
 // TODO(benvanik): KQUEUE on mac/ios.
 // KQUEUE is not implemented yet. Use POLL for mac/ios
-// Android ppoll requires API version >= 21
-#if !defined(IREE_PLATFORM_APPLE) && !defined(__EMSCRIPTEN__) && \
+// Android ppoll and epoll_create1 require API version >= 21
+#if (defined(IREE_PLATFORM_LINUX) || defined(IREE_PLATFORM_ANDROID)) && \
+    (!defined(__ANDROID_API__) || __ANDROID_API__ >= 21)
+#define IREE_WAIT_API IREE_WAIT_API_EPOLL
+#elif !defined(IREE_PLATFORM_APPLE) && !defined(__EMSCRIPTEN__) && \
     (!defined(__ANDROID_API__) || __ANDROID_API__ >= 21)
 #define IREE_WAIT_API IREE_WAIT_API_PPOLL
 #else
@@ -13,6 +13,7 @@
 #include <cstring>
 #include <thread>
 
+#include "iree/base/internal/arena.h"
 #include "iree/testing/gtest.h"
 #include "iree/testing/status_matchers.h"
 
@@ -243,6 +244,91 @@ TEST(WaitSet, UnreasonableCapacity) {
   iree_status_free(status);
 }
 
+// Tests that sets either grow beyond their initial capacity (epoll) or cleanly
+// fail insertion once full (poll/WFMO) and that waits find the right handle.
+TEST(WaitSet, GrowBeyondCapacity) {
+  constexpr int kEventCount = 256;
+  iree_event_t events[kEventCount];
+  for (int i = 0; i < kEventCount; ++i) {
+    IREE_ASSERT_OK(iree_event_initialize(/*initial_state=*/false, &events[i]));
+  }
+  iree_wait_set_t* wait_set = NULL;
+  IREE_ASSERT_OK(iree_wait_set_allocate(4, iree_allocator_system(), &wait_set));
+
+  int inserted_count = 0;
+  for (; inserted_count < kEventCount; ++inserted_count) {
+    iree_status_t status =
+        iree_wait_set_insert(wait_set, events[inserted_count]);
+    if (!iree_status_is_ok(status)) {
+      IREE_EXPECT_STATUS_IS(IREE_STATUS_RESOURCE_EXHAUSTED, status);
+      iree_status_free(status);
+      break;
+    }
+  }
+  ASSERT_GE(inserted_count, 4);
+
+  // Nothing is set so polling should fail.
+  iree_wait_handle_t wake_handle;
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_DEADLINE_EXCEEDED,
+      iree_wait_any(wait_set, IREE_TIME_INFINITE_PAST, &wake_handle));
+
+  // Set the last inserted event and ensure it is the one that wakes.
+  iree_event_t* last_event = &events[inserted_count - 1];
+  iree_event_set(last_event);
+  IREE_ASSERT_OK(
+      iree_wait_any(wait_set, IREE_TIME_INFINITE_PAST, &wake_handle));
+  EXPECT_EQ(0, memcmp(&last_event->value, &wake_handle.value,
+                      sizeof(last_event->value)));
+  iree_wait_set_erase(wait_set, wake_handle);
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_DEADLINE_EXCEEDED,
+      iree_wait_any(wait_set, IREE_TIME_INFINITE_PAST, &wake_handle));
+
+  iree_wait_set_free(wait_set);
+  for (int i = 0; i < kEventCount; ++i) {
+    iree_event_deinitialize(&events[i]);
+  }
+}
+
+// Tests that sets allocated from an arena (which cannot realloc) can be used
+// as with any other allocator.
+TEST(WaitSet, ArenaAllocator) {
+  iree_arena_block_pool_t block_pool;
+  iree_arena_block_pool_initialize(4096, iree_allocator_system(), &block_pool);
+  iree_arena_allocator_t arena;
+  iree_arena_initialize(&block_pool, &arena);
+
+  constexpr int kEventCount = 8;
+  iree_event_t events[kEventCount];
+  for (int i = 0; i < kEventCount; ++i) {
+    IREE_ASSERT_OK(iree_event_initialize(/*initial_state=*/false, &events[i]));
+  }
+  iree_wait_set_t* wait_set = NULL;
+  IREE_ASSERT_OK(iree_wait_set_allocate(
+      kEventCount, iree_arena_allocator(&arena), &wait_set));
+  for (int i = 0; i < kEventCount; ++i) {
+    IREE_ASSERT_OK(iree_wait_set_insert(wait_set, events[i]));
+  }
+
+  iree_wait_handle_t wake_handle;
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_DEADLINE_EXCEEDED,
+      iree_wait_any(wait_set, IREE_TIME_INFINITE_PAST, &wake_handle));
+  iree_event_set(&events[kEventCount - 1]);
+  IREE_ASSERT_OK(
+      iree_wait_any(wait_set, IREE_TIME_INFINITE_PAST, &wake_handle));
+  EXPECT_EQ(0, memcmp(&events[kEventCount - 1].value, &wake_handle.value,
+                      sizeof(wake_handle.value)));
+
+  iree_wait_set_free(wait_set);
+  for (int i = 0; i < kEventCount; ++i) {
+    iree_event_deinitialize(&events[i]);
+  }
+  iree_arena_deinitialize(&arena);
+  iree_arena_block_pool_deinitialize(&block_pool);
+}
+
 // Tests that inserting the same handles multiple times is tracked correctly.
 TEST(WaitSet, Deduplication) {
   iree_event_t ev_unset, ev_dupe;
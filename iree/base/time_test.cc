@@ -0,0 +1,46 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <chrono>
+#include <ctime>
+#include <thread>
+
+#include "iree/base/api.h"
+#include "iree/testing/gtest.h"
+
+namespace {
+
+TEST(TimeTest, NowIsUnixNanoseconds) {
+  // The seconds returned from the C library and iree_time_now must agree to
+  // within some slop for the two calls happening on either side of a second.
+  int64_t expected_seconds = (int64_t)std::time(nullptr);
+  int64_t actual_seconds = iree_time_now() / 1000000000ll;
+  EXPECT_NEAR(expected_seconds, actual_seconds, 2);
+}
+
+TEST(TimeTest, NowMeasuresDurations) {
+  // Durations must be measurable across second boundaries: a sleep that
+  // straddles one must not produce a negative or truncated duration.
+  iree_time_t start_ns = iree_time_now();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  iree_duration_t duration_ns = iree_time_now() - start_ns;
+  EXPECT_GE(duration_ns, 20 * 1000000ll);
+  EXPECT_LT(duration_ns, 60 * 1000000000ll);
+}
+
+TEST(TimeTest, RelativeTimeoutToDeadline) {
+  EXPECT_EQ(IREE_TIME_INFINITE_PAST,
+            iree_relative_timeout_to_deadline_ns(IREE_DURATION_ZERO));
+  EXPECT_EQ(IREE_TIME_INFINITE_FUTURE,
+            iree_relative_timeout_to_deadline_ns(IREE_DURATION_INFINITE));
+  iree_time_t now_ns = iree_time_now();
+  iree_time_t deadline_ns =
+      iree_relative_timeout_to_deadline_ns(1000 * 1000000ll);
+  EXPECT_GE(deadline_ns, now_ns + 1000 * 1000000ll);
+  EXPECT_LT(deadline_ns, now_ns + 2000 * 1000000ll);
+}
+
+}  // namespace
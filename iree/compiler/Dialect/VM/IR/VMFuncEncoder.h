@@ -56,7 +56,8 @@ class VMFuncEncoder {
   // Encodes a string attribute as a B-string.
   virtual LogicalResult encodeStrAttr(StringAttr value) = 0;
 
-  // Encodes a branch target and the operand mappings.
+  // Encodes a branch target and the operand mappings partitioned by bank,
+  // including a count of i32 mappings and the total count.
   virtual LogicalResult encodeBranch(Block *targetBlock,
                                      Operation::operand_range operands,
                                      int successorIndex) = 0;
@@ -64,13 +65,15 @@ class VMFuncEncoder {
   // Encodes an operand value (by reference).
   virtual LogicalResult encodeOperand(Value value, int ordinal) = 0;
 
-  // Encodes a variable list of operands (by reference), including a count.
+  // Encodes a variable list of operands (by reference) partitioned by bank,
+  // including a count of i32 operands and the total count.
   virtual LogicalResult encodeOperands(Operation::operand_range values) = 0;
 
   // Encodes a result value (by reference).
   virtual LogicalResult encodeResult(Value value) = 0;
 
-  // Encodes a variable list of results (by reference), including a count.
+  // Encodes a variable list of results (by reference) partitioned by bank,
+  // including a count of i32 results and the total count.
   virtual LogicalResult encodeResults(Operation::result_range values) = 0;
 };
 
@@ -1280,6 +1280,34 @@ Optional<MutableOperandRange> CondBranchOp::getMutableSuccessorOperands(
                             : falseDestOperandsMutable();
 }
 
+template <typename T>
+static Optional<MutableOperandRange> getCondBranchCmpSuccessorOperands(
+    T op, unsigned index) {
+  assert(index < op->getNumSuccessors() && "invalid successor index");
+  return index == T::trueIndex ? op.trueDestOperandsMutable()
+                               : op.falseDestOperandsMutable();
+}
+
+Optional<MutableOperandRange>
+CondBranchCmpEQI32Op::getMutableSuccessorOperands(unsigned index) {
+  return getCondBranchCmpSuccessorOperands(*this, index);
+}
+
+Optional<MutableOperandRange>
+CondBranchCmpNEI32Op::getMutableSuccessorOperands(unsigned index) {
+  return getCondBranchCmpSuccessorOperands(*this, index);
+}
+
+Optional<MutableOperandRange>
+CondBranchCmpLTI32SOp::getMutableSuccessorOperands(unsigned index) {
+  return getCondBranchCmpSuccessorOperands(*this, index);
+}
+
+Optional<MutableOperandRange>
+CondBranchCmpLTI32UOp::getMutableSuccessorOperands(unsigned index) {
+  return getCondBranchCmpSuccessorOperands(*this, index);
+}
+
 template <typename T>
 static LogicalResult verifyFailOp(T op) {
   APInt status;
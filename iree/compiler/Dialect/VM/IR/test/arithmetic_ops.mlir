@@ -11,6 +11,17 @@ vm.module @my_module {
 
 // -----
 
+// CHECK-LABEL: @add_i32_imm
+vm.module @my_module {
+  vm.func @add_i32_imm(%arg0 : i32) -> i32 {
+    // CHECK: %0 = vm.add.i32.imm %arg0, -4 : i32
+    %0 = vm.add.i32.imm %arg0, -4 : i32
+    vm.return %0 : i32
+  }
+}
+
+// -----
+
 // CHECK-LABEL: @sub_i32
 vm.module @my_module {
   vm.func @sub_i32(%arg0 : i32, %arg1 : i32) -> i32 {
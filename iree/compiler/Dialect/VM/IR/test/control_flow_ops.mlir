@@ -52,6 +52,27 @@ vm.module @my_module {
 
 // -----
 
+// CHECK-LABEL: @cond_branch_cmp
+vm.module @my_module {
+  vm.func @cond_branch_cmp(%arg0 : i32, %arg1 : i32) -> i32 {
+    // CHECK: vm.cond_br.cmp.eq.i32 %arg0, %arg1, ^bb1, ^bb2 : i32
+    vm.cond_br.cmp.eq.i32 %arg0, %arg1, ^bb1, ^bb2 : i32
+  ^bb1:
+    // CHECK: vm.cond_br.cmp.ne.i32 %arg0, %arg1, ^bb2, ^bb3(%arg1 : i32) : i32
+    vm.cond_br.cmp.ne.i32 %arg0, %arg1, ^bb2, ^bb3(%arg1 : i32) : i32
+  ^bb2:
+    // CHECK: vm.cond_br.cmp.lt.i32.s %arg0, %arg1, ^bb3(%arg0 : i32), ^bb4 : i32
+    vm.cond_br.cmp.lt.i32.s %arg0, %arg1, ^bb3(%arg0 : i32), ^bb4 : i32
+  ^bb3(%0 : i32):
+    vm.return %0 : i32
+  ^bb4:
+    // CHECK: vm.cond_br.cmp.lt.i32.u %arg0, %arg1, ^bb3(%arg0 : i32), ^bb3(%arg1 : i32) : i32
+    vm.cond_br.cmp.lt.i32.u %arg0, %arg1, ^bb3(%arg0 : i32), ^bb3(%arg1 : i32) : i32
+  }
+}
+
+// -----
+
 // CHECK-LABEL: @call_fn
 vm.module @my_module {
   vm.import @import_fn(%arg0 : i32) -> i32
@@ -185,9 +185,17 @@ class V0BytecodeEncoder : public BytecodeEncoder {
     // Compute required remappings - we only need to emit them when the source
     // and dest registers differ. Hopefully the allocator did a good job and
     // this list is small :)
+    // Pairs are partitioned by bank with all i32 pairs preceding ref pairs.
     auto srcDstRegs = registerAllocation_->remapSuccessorRegisters(
         currentOp_, successorIndex);
-    if (failed(ensureAlignment(2)) || failed(writeUint16(srcDstRegs.size()))) {
+    auto refBegin = std::stable_partition(
+        srcDstRegs.begin(), srcDstRegs.end(),
+        [](const std::pair<Register, Register> &srcDstReg) {
+          return !srcDstReg.first.isRef();
+        });
+    if (failed(ensureAlignment(2)) ||
+        failed(writeUint16(std::distance(srcDstRegs.begin(), refBegin))) ||
+        failed(writeUint16(srcDstRegs.size()))) {
       return failure();
     }
     for (auto srcDstReg : srcDstRegs) {
@@ -208,19 +216,12 @@ class V0BytecodeEncoder : public BytecodeEncoder {
   }
 
   LogicalResult encodeOperands(Operation::operand_range values) override {
-    if (failed(ensureAlignment(2)) ||
-        failed(writeUint16(std::distance(values.begin(), values.end())))) {
-      return failure();
-    }
+    SmallVector<Register, 8> regs;
     for (auto it : llvm::enumerate(values)) {
-      uint16_t reg = registerAllocation_
-                         ->mapUseToRegister(it.value(), currentOp_, it.index())
-                         .encode();
-      if (failed(writeUint16(reg))) {
-        return failure();
-      }
+      regs.push_back(registerAllocation_->mapUseToRegister(
+          it.value(), currentOp_, it.index()));
     }
-    return success();
+    return writeRegisterList(regs);
   }
 
   LogicalResult encodeResult(Value value) override {
@@ -229,17 +230,11 @@ class V0BytecodeEncoder : public BytecodeEncoder {
   }
 
   LogicalResult encodeResults(Operation::result_range values) override {
-    if (failed(ensureAlignment(2)) ||
-        failed(writeUint16(std::distance(values.begin(), values.end())))) {
-      return failure();
-    }
+    SmallVector<Register, 8> regs;
     for (auto value : values) {
-      uint16_t reg = registerAllocation_->mapToRegister(value).encode();
-      if (failed(writeUint16(reg))) {
-        return failure();
-      }
+      regs.push_back(registerAllocation_->mapToRegister(value));
     }
-    return success();
+    return writeRegisterList(regs);
   }
 
   Optional<std::vector<uint8_t>> finish() {
@@ -261,6 +256,26 @@ class V0BytecodeEncoder : public BytecodeEncoder {
   }
 
  private:
+  // Writes a register list partitioned by bank: the i32 register count and
+  // total register count followed by all i32 registers and then all ref
+  // registers, each in their original order.
+  LogicalResult writeRegisterList(MutableArrayRef<Register> regs) {
+    auto refBegin =
+        std::stable_partition(regs.begin(), regs.end(),
+                              [](Register reg) { return !reg.isRef(); });
+    if (failed(ensureAlignment(2)) ||
+        failed(writeUint16(std::distance(regs.begin(), refBegin))) ||
+        failed(writeUint16(regs.size()))) {
+      return failure();
+    }
+    for (auto reg : regs) {
+      if (failed(writeUint16(reg.encode()))) {
+        return failure();
+      }
+    }
+    return success();
+  }
+
   // TODO(benvanik): replace this with something not using an ever-expanding
   // vector. I'm sure LLVM has something.
 
@@ -31,6 +31,10 @@ struct EncodedBytecodeFunction {
 // Abstract encoder used for function bytecode encoding.
 class BytecodeEncoder : public VMFuncEncoder {
  public:
+  // Encoding version of the emitted bytecode.
+  // Must match IREE_VM_BYTECODE_VERSION_LATEST in the runtime.
+  static constexpr uint32_t kVersion = 2;
+
   // Encodes a vm.func to bytecode and returns the result.
   // Returns None on failure.
   static Optional<EncodedBytecodeFunction> encodeFunction(
@@ -416,6 +416,12 @@ static LogicalResult canonicalizeModule(BytecodeTargetOptions targetOptions,
     modulePasses.addPass(mlir::createInlinerPass());
     modulePasses.addPass(mlir::createCSEPass());
     modulePasses.addPass(mlir::createCanonicalizerPass());
+
+    // Superinstructions are specific to the bytecode interpreter and are
+    // formed last so that the canonical ops they fuse are visible above.
+    if (targetOptions.fuseSuperinstructions) {
+      modulePasses.addPass(IREE::VM::createFuseSuperinstructionsPass());
+    }
   }
 
   modulePasses.addPass(IREE::Util::createDropCompilerHintsPass());
@@ -766,6 +772,8 @@ static LogicalResult buildFlatBufferModule(BytecodeTargetOptions targetOptions,
                                                      functionDescriptorsRef);
   iree_vm_BytecodeModuleDef_bytecode_data_add(fbb, bytecodeDataRef);
   iree_vm_BytecodeModuleDef_debug_database_add(fbb, debugDatabaseRef);
+  iree_vm_BytecodeModuleDef_bytecode_version_add(fbb,
+                                                 BytecodeEncoder::kVersion);
   iree_vm_BytecodeModuleDef_end_as_root(fbb);
 
   return success();
@@ -901,6 +909,11 @@ void BytecodeTargetOptions::bindOptions(OptionsBinder &binder) {
       llvm::cl::cat(vmBytecodeOptionsCategory),
       llvm::cl::desc("Optimizes the VM module with CSE/inlining/etc prior to "
                      "serialization"));
+  binder.opt<bool>(
+      "iree-vm-bytecode-module-fuse-superinstructions", fuseSuperinstructions,
+      llvm::cl::cat(vmBytecodeOptionsCategory),
+      llvm::cl::desc("Fuses common op sequences into superinstructions when "
+                     "optimizing (see -iree-vm-fuse-superinstructions)"));
   binder.opt<std::string>(
       "iree-vm-bytecode-source-listing", sourceListing,
       llvm::cl::cat(vmBytecodeOptionsCategory),
@@ -39,6 +39,8 @@ struct BytecodeTargetOptions {
 
   // Run basic CSE/inlining/etc passes prior to serialization.
   bool optimize = true;
+  // Fuse common op sequences into superinstructions when optimizing.
+  bool fuseSuperinstructions = true;
 
   // Dump a VM MLIR file and annotate source locations with it.
   // This allows for the runtime to serve stack traces referencing both the
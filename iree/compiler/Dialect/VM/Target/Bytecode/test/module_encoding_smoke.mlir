@@ -26,9 +26,10 @@ vm.module @simple_module {
   // CHECK-NEXT:   0,
   // CHECK-NEXT:   1,
   // CHECK-NEXT:   0,
-  // CHECK-NEXT:   0,
+  // CHECK-NEXT:   1,
   // CHECK-NEXT:   0,
   // CHECK-NEXT:   0,
   // CHECK-NEXT:   0
   // CHECK-NEXT: ]
+  // CHECK: "bytecode_version": 2
 }
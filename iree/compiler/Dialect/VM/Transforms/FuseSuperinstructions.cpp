@@ -0,0 +1,121 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/VM/IR/VMOps.h"
+#include "iree/compiler/Dialect/VM/Transforms/Passes.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Pass/PassRegistry.h"
+#include "mlir/Support/LLVM.h"
+#include "mlir/Support/LogicalResult.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace VM {
+
+namespace {
+
+/// Fuses a comparison whose only use is as the condition of a vm.cond_br in
+/// the same block into a single vm.cond_br.cmp.* superinstruction.
+template <typename CmpOp, typename FusedOp>
+struct FuseCmpCondBranch : public OpRewritePattern<CondBranchOp> {
+  using OpRewritePattern<CondBranchOp>::OpRewritePattern;
+  LogicalResult matchAndRewrite(CondBranchOp op,
+                                PatternRewriter &rewriter) const override {
+    auto cmpOp = op.getCondition().getDefiningOp<CmpOp>();
+    if (!cmpOp || !cmpOp.result().hasOneUse() ||
+        cmpOp->getBlock() != op->getBlock()) {
+      // Other users need the condition in a register and fusing across
+      // blocks would extend the live ranges of the operands.
+      return failure();
+    }
+    rewriter.replaceOpWithNewOp<FusedOp>(
+        op, cmpOp.lhs(), cmpOp.rhs(), op.getTrueOperands(),
+        op.getFalseOperands(), op.getTrueDest(), op.getFalseDest());
+    rewriter.eraseOp(cmpOp);
+    return success();
+  }
+};
+
+/// Folds a constant operand of vm.add.i32 into a vm.add.i32.imm.
+struct FuseAddI32Const : public OpRewritePattern<AddI32Op> {
+  using OpRewritePattern<AddI32Op>::OpRewritePattern;
+  LogicalResult matchAndRewrite(AddI32Op op,
+                                PatternRewriter &rewriter) const override {
+    APInt imm;
+    Value operand;
+    if (matchPattern(op.rhs(), m_ConstantInt(&imm))) {
+      operand = op.lhs();
+    } else if (matchPattern(op.lhs(), m_ConstantInt(&imm))) {
+      operand = op.rhs();
+    } else {
+      return failure();
+    }
+    rewriter.replaceOpWithNewOp<AddI32ImmOp>(
+        op, op.getType(), operand,
+        rewriter.getI32IntegerAttr(static_cast<int32_t>(imm.getZExtValue())));
+    return success();
+  }
+};
+
+/// Folds a constant rhs of vm.sub.i32 into a vm.add.i32.imm of its negation.
+struct FuseSubI32Const : public OpRewritePattern<SubI32Op> {
+  using OpRewritePattern<SubI32Op>::OpRewritePattern;
+  LogicalResult matchAndRewrite(SubI32Op op,
+                                PatternRewriter &rewriter) const override {
+    APInt imm;
+    if (!matchPattern(op.rhs(), m_ConstantInt(&imm))) return failure();
+    // Two's complement negation wraps identically to the subtraction.
+    imm.negate();
+    rewriter.replaceOpWithNewOp<AddI32ImmOp>(
+        op, op.getType(), op.lhs(),
+        rewriter.getI32IntegerAttr(static_cast<int32_t>(imm.getZExtValue())));
+    return success();
+  }
+};
+
+}  // namespace
+
+class FuseSuperinstructionsPass
+    : public PassWrapper<FuseSuperinstructionsPass, OperationPass<ModuleOp>> {
+ public:
+  StringRef getArgument() const override {
+    return "iree-vm-fuse-superinstructions";
+  }
+
+  StringRef getDescription() const override {
+    return "Fuses common op sequences into bytecode superinstructions.";
+  }
+
+  void runOnOperation() override {
+    MLIRContext *context = &getContext();
+    RewritePatternSet patterns(context);
+    patterns.insert<FuseCmpCondBranch<CmpEQI32Op, CondBranchCmpEQI32Op>,
+                    FuseCmpCondBranch<CmpNEI32Op, CondBranchCmpNEI32Op>,
+                    FuseCmpCondBranch<CmpLTI32SOp, CondBranchCmpLTI32SOp>,
+                    FuseCmpCondBranch<CmpLTI32UOp, CondBranchCmpLTI32UOp>>(
+        context);
+    patterns.insert<FuseAddI32Const, FuseSubI32Const>(context);
+    if (failed(applyPatternsAndFoldGreedily(getOperation(),
+                                            std::move(patterns)))) {
+      return signalPassFailure();
+    }
+  }
+};
+
+std::unique_ptr<OperationPass<ModuleOp>> createFuseSuperinstructionsPass() {
+  return std::make_unique<FuseSuperinstructionsPass>();
+}
+
+static PassRegistration<FuseSuperinstructionsPass> pass;
+
+}  // namespace VM
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
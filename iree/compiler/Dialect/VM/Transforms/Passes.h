@@ -81,6 +81,12 @@ createOrdinalAllocationPass();
 // number of live registers at the cost of additional storage requirements.
 std::unique_ptr<OperationPass<IREE::VM::ModuleOp>> createSinkDefiningOpsPass();
 
+// Fuses common op sequences such as comparisons feeding conditional branches
+// into superinstructions that dispatch once in the bytecode interpreter.
+// Only valid when targeting bytecode as other targets do not support them.
+std::unique_ptr<OperationPass<IREE::VM::ModuleOp>>
+createFuseSuperinstructionsPass();
+
 //===----------------------------------------------------------------------===//
 // Test passes
 //===----------------------------------------------------------------------===//
@@ -101,6 +107,7 @@ inline void registerVMPasses() {
   createGlobalInitializationPass();
   createOrdinalAllocationPass();
   createSinkDefiningOpsPass();
+  createFuseSuperinstructionsPass();
 }
 
 inline void registerVMTestPasses() {
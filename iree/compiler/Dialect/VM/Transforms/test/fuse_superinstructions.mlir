@@ -0,0 +1,94 @@
+// RUN: iree-opt -split-input-file -iree-vm-fuse-superinstructions %s | FileCheck %s
+
+vm.module @module {
+  // CHECK-LABEL: @cmp_cond_br
+  vm.func @cmp_cond_br(%arg0 : i32, %arg1 : i32) -> i32 {
+    // CHECK-NOT: vm.cmp.lt.i32.s
+    %0 = vm.cmp.lt.i32.s %arg0, %arg1 : i32
+    // CHECK: vm.cond_br.cmp.lt.i32.s %arg0, %arg1, ^bb1(%arg0 : i32), ^bb2 : i32
+    vm.cond_br %0, ^bb1(%arg0 : i32), ^bb2
+  ^bb1(%1 : i32):
+    vm.return %1 : i32
+  ^bb2:
+    vm.return %arg1 : i32
+  }
+}
+
+// -----
+
+vm.module @module {
+  // CHECK-LABEL: @cmp_cond_br_all
+  vm.func @cmp_cond_br_all(%arg0 : i32, %arg1 : i32) {
+    %0 = vm.cmp.eq.i32 %arg0, %arg1 : i32
+    // CHECK: vm.cond_br.cmp.eq.i32 %arg0, %arg1, ^bb1, ^bb4 : i32
+    vm.cond_br %0, ^bb1, ^bb4
+  ^bb1:
+    %1 = vm.cmp.ne.i32 %arg0, %arg1 : i32
+    // CHECK: vm.cond_br.cmp.ne.i32 %arg0, %arg1, ^bb2, ^bb4 : i32
+    vm.cond_br %1, ^bb2, ^bb4
+  ^bb2:
+    %2 = vm.cmp.lt.i32.u %arg0, %arg1 : i32
+    // CHECK: vm.cond_br.cmp.lt.i32.u %arg0, %arg1, ^bb3, ^bb4 : i32
+    vm.cond_br %2, ^bb3, ^bb4
+  ^bb3:
+    vm.return
+  ^bb4:
+    vm.return
+  }
+}
+
+// -----
+
+vm.module @module {
+  // CHECK-LABEL: @cmp_multiple_uses
+  vm.func @cmp_multiple_uses(%arg0 : i32, %arg1 : i32) -> i32 {
+    // CHECK: %[[CMP:.+]] = vm.cmp.lt.i32.s %arg0, %arg1 : i32
+    %0 = vm.cmp.lt.i32.s %arg0, %arg1 : i32
+    // CHECK-NEXT: vm.cond_br %[[CMP]], ^bb1, ^bb2
+    vm.cond_br %0, ^bb1, ^bb2
+  ^bb1:
+    vm.return %0 : i32
+  ^bb2:
+    vm.return %arg1 : i32
+  }
+}
+
+// -----
+
+vm.module @module {
+  // CHECK-LABEL: @add_const
+  vm.func @add_const(%arg0 : i32) -> (i32, i32, i32) {
+    // CHECK-NOT: vm.const.i32
+    %c1 = vm.const.i32 1 : i32
+    %c2 = vm.const.i32 2 : i32
+    %c3 = vm.const.i32 3 : i32
+    // CHECK: %[[ADD_RHS:.+]] = vm.add.i32.imm %arg0, 1 : i32
+    %0 = vm.add.i32 %arg0, %c1 : i32
+    // CHECK-NEXT: %[[ADD_LHS:.+]] = vm.add.i32.imm %arg0, 2 : i32
+    %1 = vm.add.i32 %c2, %arg0 : i32
+    // CHECK-NEXT: %[[SUB:.+]] = vm.add.i32.imm %arg0, -3 : i32
+    %2 = vm.sub.i32 %arg0, %c3 : i32
+    // CHECK-NEXT: vm.return %[[ADD_RHS]], %[[ADD_LHS]], %[[SUB]]
+    vm.return %0, %1, %2 : i32, i32, i32
+  }
+}
+
+// -----
+
+vm.module @module {
+  // CHECK-LABEL: @loop
+  vm.func @loop(%arg0 : i32) -> i32 {
+    %c0 = vm.const.i32.zero : i32
+    // CHECK: vm.br ^bb1
+    vm.br ^bb1(%c0 : i32)
+  ^bb1(%0 : i32):
+    %c1 = vm.const.i32 1 : i32
+    // CHECK: %[[NEXT:.+]] = vm.add.i32.imm %0, 1 : i32
+    %1 = vm.add.i32 %0, %c1 : i32
+    %2 = vm.cmp.lt.i32.s %1, %arg0 : i32
+    // CHECK-NEXT: vm.cond_br.cmp.lt.i32.s %[[NEXT]], %arg0, ^bb1(%[[NEXT]] : i32), ^bb2 : i32
+    vm.cond_br %2, ^bb1(%1 : i32), ^bb2
+  ^bb2:
+    vm.return %1 : i32
+  }
+}
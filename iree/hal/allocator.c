@@ -6,6 +6,7 @@
 
 #include "iree/hal/allocator.h"
 
+#include <inttypes.h>
 #include <stddef.h>
 #include <stdio.h>
 
@@ -36,6 +37,23 @@ IREE_API_EXPORT iree_status_t iree_hal_allocator_statistics_format(
       statistics->device_bytes_freed,
       (statistics->device_bytes_allocated - statistics->device_bytes_freed)));
 
+  if (statistics->cache_hit_count || statistics->cache_miss_count) {
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder,
+        "       CACHE: %12" PRIdsz "B retained / %12" PRIu64
+        " hits / %12" PRIu64 " misses\n",
+        statistics->cache_bytes_retained, statistics->cache_hit_count,
+        statistics->cache_miss_count));
+  }
+
+  if (statistics->large_page_mapping_count) {
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder,
+        "  LARGE_PAGE: %12" PRIdsz "B mapped / %12" PRIu64 " mappings\n",
+        statistics->large_page_bytes_mapped,
+        statistics->large_page_mapping_count));
+  }
+
 #else
   // No-op when disabled.
 #endif  // IREE_STATISTICS_ENABLE
@@ -173,6 +173,17 @@ typedef struct iree_hal_allocator_statistics_t {
   iree_device_size_t device_bytes_peak;
   iree_device_size_t device_bytes_allocated;
   iree_device_size_t device_bytes_freed;
+  // Bytes of released buffer storage currently retained by allocator caches.
+  iree_device_size_t cache_bytes_retained;
+  // Number of allocations serviced from a cache without a new allocation.
+  uint64_t cache_hit_count;
+  // Number of allocations that missed the cache when caching was enabled.
+  uint64_t cache_miss_count;
+  // Bytes of buffer storage currently mapped with large page hints (including
+  // storage retained by caches).
+  iree_device_size_t large_page_bytes_mapped;
+  // Total number of large page mappings made.
+  uint64_t large_page_mapping_count;
   // TODO(benvanik): mapping information (discarded, mapping ranges,
   //                 flushed/invalidated, etc).
 #else
@@ -334,6 +345,62 @@ IREE_API_EXPORT iree_status_t iree_hal_allocator_create_heap(
     iree_string_view_t identifier, iree_allocator_t data_allocator,
     iree_allocator_t host_allocator, iree_hal_allocator_t** out_allocator);
 
+// Controls how iree_hal_heap_allocator_t maps large buffer storage.
+enum iree_hal_heap_large_page_flag_bits_t {
+  IREE_HAL_HEAP_LARGE_PAGE_FLAG_NONE = 0u,
+  // Advises the system to back storage with transparent huge pages.
+  IREE_HAL_HEAP_LARGE_PAGE_FLAG_TRANSPARENT = 1u << 0,
+  // Maps storage from the explicitly reserved huge page pool, falling back to
+  // transparent huge pages when the pool is exhausted.
+  IREE_HAL_HEAP_LARGE_PAGE_FLAG_EXPLICIT = 1u << 1,
+  // Faults in all pages when storage is allocated instead of on first use.
+  IREE_HAL_HEAP_LARGE_PAGE_FLAG_PREFAULT = 1u << 2,
+};
+typedef uint32_t iree_hal_heap_large_page_flags_t;
+
+// Parameters configuring an iree_hal_heap_allocator_t.
+// Must be initialized with iree_hal_heap_allocator_params_initialize prior to
+// use.
+typedef struct iree_hal_heap_allocator_params_t {
+  // Maximum total bytes of released buffer storage that will be retained for
+  // reuse by future allocations. When non-zero allocations are rounded up to a
+  // size class (~25% granularity) and released buffers are kept in per-class
+  // free lists, with blocks larger than |max_size_class| kept in a best-fit
+  // list instead. Retained storage is released by iree_hal_allocator_trim.
+  // 0 disables caching and all storage is returned to the data allocator as
+  // soon as a buffer is released.
+  iree_device_size_t cache_capacity;
+
+  // Largest allocation size that is rounded to a size class; allocations larger
+  // than this are only rounded to a page multiple.
+  iree_device_size_t max_size_class;
+
+  // Allocations of at least this many bytes have their storage mapped directly
+  // from the system using |large_page_flags| instead of the data allocator.
+  // Large pages reduce TLB misses when kernels stream through large weights and
+  // activations. 0 disables large page mappings. Only supported on Linux and
+  // ignored elsewhere.
+  iree_device_size_t large_page_threshold;
+  iree_hal_heap_large_page_flags_t large_page_flags;
+  // NUMA node large page mappings prefer or UINT32_MAX for no preference.
+  uint32_t large_page_numa_node;
+} iree_hal_heap_allocator_params_t;
+
+// Initializes |out_params| to default values (caching and large pages
+// disabled).
+IREE_API_EXPORT void iree_hal_heap_allocator_params_initialize(
+    iree_hal_heap_allocator_params_t* out_params);
+
+// Creates a host-local heap allocator as with iree_hal_allocator_create_heap
+// using the provided |params|. Allocators with caching enabled can be passed to
+// devices that perform many transient allocations in steady state in order to
+// avoid the host allocator (and the page faults of fresh allocations) on each.
+IREE_API_EXPORT iree_status_t iree_hal_allocator_create_heap_with_params(
+    iree_string_view_t identifier,
+    const iree_hal_heap_allocator_params_t* params,
+    iree_allocator_t data_allocator, iree_allocator_t host_allocator,
+    iree_hal_allocator_t** out_allocator);
+
 //===----------------------------------------------------------------------===//
 // iree_hal_allocator_t implementation details
 //===----------------------------------------------------------------------===//
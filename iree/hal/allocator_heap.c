@@ -7,6 +7,7 @@
 #include <stddef.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/numa.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/allocator.h"
 #include "iree/hal/buffer.h"
@@ -19,6 +20,8 @@ typedef struct iree_hal_heap_allocator_t {
   iree_allocator_t data_allocator;
   iree_string_view_t identifier;
   IREE_STATISTICS(iree_hal_heap_allocator_statistics_t statistics;)
+  iree_hal_heap_buffer_cache_t cache;
+  iree_hal_heap_large_page_policy_t large_pages;
 } iree_hal_heap_allocator_t;
 
 static const iree_hal_allocator_vtable_t iree_hal_heap_allocator_vtable;
@@ -28,9 +31,49 @@ iree_hal_heap_allocator_t* iree_hal_heap_allocator_cast(
   return (iree_hal_heap_allocator_t*)base_value;
 }
 
+IREE_API_EXPORT void iree_hal_heap_allocator_params_initialize(
+    iree_hal_heap_allocator_params_t* out_params) {
+  out_params->cache_capacity = 0;
+  out_params->max_size_class = 16 * 1024 * 1024;
+  out_params->large_page_threshold = 0;
+  out_params->large_page_flags = IREE_HAL_HEAP_LARGE_PAGE_FLAG_TRANSPARENT;
+  out_params->large_page_numa_node = UINT32_MAX;
+}
+
+// Returns an allocator mapping storage with the large page |params|.
+static iree_allocator_t iree_hal_heap_allocator_select_large_page_allocator(
+    const iree_hal_heap_allocator_params_t* params) {
+  iree_numa_allocation_flags_t flags = IREE_NUMA_ALLOCATION_FLAG_NONE;
+  if (iree_all_bits_set(params->large_page_flags,
+                        IREE_HAL_HEAP_LARGE_PAGE_FLAG_TRANSPARENT)) {
+    flags |= IREE_NUMA_ALLOCATION_FLAG_TRANSPARENT_HUGE_PAGES;
+  }
+  if (iree_all_bits_set(params->large_page_flags,
+                        IREE_HAL_HEAP_LARGE_PAGE_FLAG_EXPLICIT)) {
+    flags |= IREE_NUMA_ALLOCATION_FLAG_EXPLICIT_HUGE_PAGES;
+  }
+  if (iree_all_bits_set(params->large_page_flags,
+                        IREE_HAL_HEAP_LARGE_PAGE_FLAG_PREFAULT)) {
+    flags |= IREE_NUMA_ALLOCATION_FLAG_PREFAULT;
+  }
+  return iree_numa_allocator_with_flags(params->large_page_numa_node, flags);
+}
+
 IREE_API_EXPORT iree_status_t iree_hal_allocator_create_heap(
     iree_string_view_t identifier, iree_allocator_t data_allocator,
     iree_allocator_t host_allocator, iree_hal_allocator_t** out_allocator) {
+  iree_hal_heap_allocator_params_t params;
+  iree_hal_heap_allocator_params_initialize(&params);
+  return iree_hal_allocator_create_heap_with_params(
+      identifier, &params, data_allocator, host_allocator, out_allocator);
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_allocator_create_heap_with_params(
+    iree_string_view_t identifier,
+    const iree_hal_heap_allocator_params_t* params,
+    iree_allocator_t data_allocator, iree_allocator_t host_allocator,
+    iree_hal_allocator_t** out_allocator) {
+  IREE_ASSERT_ARGUMENT(params);
   IREE_ASSERT_ARGUMENT(out_allocator);
   IREE_TRACE_ZONE_BEGIN(z0);
 
@@ -48,10 +91,18 @@ IREE_API_EXPORT iree_status_t iree_hal_allocator_create_heap(
         identifier, &allocator->identifier,
         (char*)allocator + iree_sizeof_struct(*allocator));
 
+    iree_hal_heap_allocator_statistics_t* statistics = NULL;
     IREE_STATISTICS({
       // All start initialized to zero.
       iree_slim_mutex_initialize(&allocator->statistics.mutex);
+      statistics = &allocator->statistics;
     });
+    iree_hal_heap_buffer_cache_initialize(params->cache_capacity,
+                                          params->max_size_class, statistics,
+                                          &allocator->cache);
+    allocator->large_pages.threshold = params->large_page_threshold;
+    allocator->large_pages.allocator =
+        iree_hal_heap_allocator_select_large_page_allocator(params);
 
     *out_allocator = (iree_hal_allocator_t*)allocator;
   }
@@ -67,6 +118,7 @@ static void iree_hal_heap_allocator_destroy(
   iree_allocator_t host_allocator = allocator->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  iree_hal_heap_buffer_cache_deinitialize(&allocator->cache);
   IREE_STATISTICS(iree_slim_mutex_deinitialize(&allocator->statistics.mutex));
 
   iree_allocator_free(host_allocator, allocator);
@@ -83,6 +135,9 @@ static iree_allocator_t iree_hal_heap_allocator_host_allocator(
 
 static iree_status_t iree_hal_heap_allocator_trim(
     iree_hal_allocator_t* base_allocator) {
+  iree_hal_heap_allocator_t* allocator =
+      iree_hal_heap_allocator_cast(base_allocator);
+  iree_hal_heap_buffer_cache_trim(&allocator->cache);
   return iree_ok_status();
 }
 
@@ -168,9 +223,9 @@ static iree_status_t iree_hal_heap_allocator_allocate_buffer(
   IREE_STATISTICS(statistics = &allocator->statistics);
   iree_hal_buffer_t* buffer = NULL;
   IREE_RETURN_IF_ERROR(iree_hal_heap_buffer_create(
-      base_allocator, statistics, memory_type, allowed_access, allowed_usage,
-      allocation_size, allocator->data_allocator, allocator->host_allocator,
-      &buffer));
+      base_allocator, statistics, &allocator->cache, &allocator->large_pages,
+      memory_type, allowed_access, allowed_usage, allocation_size,
+      allocator->data_allocator, allocator->host_allocator, &buffer));
 
   iree_status_t status = iree_ok_status();
   if (!iree_const_byte_span_is_empty(initial_data)) {
@@ -188,9 +243,14 @@ static iree_status_t iree_hal_heap_allocator_allocate_buffer(
 
 static void iree_hal_heap_allocator_deallocate_buffer(
     iree_hal_allocator_t* base_allocator, iree_hal_buffer_t* base_buffer) {
-  // We don't do any pooling yet.
+  iree_hal_heap_allocator_t* allocator =
+      iree_hal_heap_allocator_cast(base_allocator);
+  // Retain the buffer for reuse if caching is enabled and there is capacity;
+  // otherwise (or for wrapped/subspan buffers) destroy it immediately.
   // TODO(benvanik): move stats tracking here.
-  iree_hal_buffer_destroy(base_buffer);
+  if (!iree_hal_heap_buffer_cache_recycle(&allocator->cache, base_buffer)) {
+    iree_hal_buffer_destroy(base_buffer);
+  }
 }
 
 static iree_status_t iree_hal_heap_allocator_wrap_buffer(
@@ -0,0 +1,416 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/file_io.h"
+#include "iree/base/internal/flags.h"
+#include "iree/hal/api.h"
+#include "iree/testing/benchmark.h"
+
+IREE_FLAG(string, allocation_trace, "",
+          "Path to an allocation trace to replay in addition to the built-in\n"
+          "traces. Each line is either `a <slot> <size>` to allocate a buffer\n"
+          "of <size> bytes into <slot> or `f <slot>` to release it.");
+
+IREE_FLAG(int64_t, cache_capacity, 1024ll * 1024 * 1024,
+          "Cache capacity in bytes used by the cached trace variants.");
+
+// A single allocation or release in a trace.
+// Slots identify live buffers and are reused once released.
+typedef struct iree_hal_allocation_trace_op_t {
+  uint32_t slot;
+  // Allocation size in bytes or 0 to release the buffer in |slot|.
+  iree_device_size_t size;
+} iree_hal_allocation_trace_op_t;
+
+typedef struct iree_hal_allocation_trace_t {
+  iree_host_size_t slot_count;
+  iree_host_size_t op_count;
+  const iree_hal_allocation_trace_op_t* ops;
+} iree_hal_allocation_trace_t;
+
+#define KB(n) ((iree_device_size_t)(n)*1024)
+#define MB(n) ((iree_device_size_t)(n)*1024 * 1024)
+
+// A transformer-style block executed with transient buffers: activations are
+// ping-ponged between layers, the wide MLP intermediate is short-lived, and
+// small scalar/reduction buffers are interleaved throughout. Sizes are taken
+// from a batch 1, 384 sequence length, 1024 hidden BERT-large layer.
+static const iree_hal_allocation_trace_op_t iree_hal_trace_encoder_layer[] = {
+    {0, MB(1) + KB(512)},  // input activations
+    {1, MB(4) + KB(512)},  // fused qkv projection
+    {2, KB(576)},          // attention scores (per head)
+    {3, 64},               // softmax max
+    {4, 64},               // softmax sum
+    {3, 0},
+    {4, 0},
+    {5, MB(1) + KB(512)},  // attention output
+    {2, 0},
+    {1, 0},
+    {6, MB(1) + KB(512)},  // residual + layernorm
+    {5, 0},
+    {0, 0},
+    {7, MB(6)},            // mlp intermediate
+    {8, 4096},             // layernorm statistics
+    {9, MB(1) + KB(512)},  // mlp output
+    {7, 0},
+    {8, 0},
+    {6, 0},
+    {9, 0},
+};
+
+// An image pipeline with a pyramid of decreasing feature map sizes where each
+// stage releases its input after producing its output.
+static const iree_hal_allocation_trace_op_t iree_hal_trace_conv_pyramid[] = {
+    {0, MB(12)},      {1, MB(24)}, {0, 0},      {2, MB(6)},     {1, 0},
+    {3, MB(12)},      {2, 0},      {4, MB(3)},  {3, 0},         {5, MB(6)},
+    {4, 0},           {6, KB(1536)}, {5, 0},    {7, MB(3)},     {6, 0},
+    {8, KB(768)},     {7, 0},      {9, KB(4)},  {8, 0},         {9, 0},
+};
+
+// Growing sequence lengths in a decoder where large cache-like buffers differ
+// slightly in size between steps and must be matched best-fit.
+static const iree_hal_allocation_trace_op_t iree_hal_trace_decoder_steps[] = {
+    {0, MB(32) + KB(4)},  {1, MB(8) + KB(1)},   {1, 0},
+    {0, 0},               {0, MB(32) + KB(8)},  {1, MB(8) + KB(2)},
+    {1, 0},               {0, 0},               {0, MB(32) + KB(12)},
+    {1, MB(8) + KB(3)},   {1, 0},               {0, 0},
+    {0, MB(32) + KB(16)}, {1, MB(8) + KB(4)},   {1, 0},
+    {0, 0},
+};
+
+#define IREE_HAL_DEFINE_TRACE(name, slots)                    \
+  static const iree_hal_allocation_trace_t name##_trace = {   \
+      slots, IREE_ARRAYSIZE(name), name}
+IREE_HAL_DEFINE_TRACE(iree_hal_trace_encoder_layer, 10);
+IREE_HAL_DEFINE_TRACE(iree_hal_trace_conv_pyramid, 10);
+IREE_HAL_DEFINE_TRACE(iree_hal_trace_decoder_steps, 2);
+
+// Parses a trace file in the format described by --allocation_trace.
+static iree_status_t iree_hal_allocation_trace_parse(
+    iree_string_view_t contents, iree_allocator_t host_allocator,
+    iree_hal_allocation_trace_t* out_trace) {
+  iree_host_size_t capacity = 0;
+  iree_hal_allocation_trace_op_t* ops = NULL;
+  iree_host_size_t op_count = 0;
+  iree_host_size_t slot_count = 0;
+  iree_status_t status = iree_ok_status();
+  while (iree_status_is_ok(status) && !iree_string_view_is_empty(contents)) {
+    iree_string_view_t line;
+    iree_string_view_split(contents, '\n', &line, &contents);
+    line = iree_string_view_trim(line);
+    if (iree_string_view_is_empty(line) || line.data[0] == '#') continue;
+
+    char line_str[128] = {0};
+    memcpy(line_str, line.data, iree_min(line.size, sizeof(line_str) - 1));
+    char op_type = 0;
+    uint32_t slot = 0;
+    uint64_t size = 0;
+    int field_count = sscanf(line_str, "%c %u %" SCNu64, &op_type, &slot,
+                             &size);
+    if (!((op_type == 'a' && field_count == 3 && size > 0) ||
+          (op_type == 'f' && field_count >= 2))) {
+      status = iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "malformed trace line '%.*s'", (int)line.size,
+                                line.data);
+      break;
+    }
+    if (op_count == capacity) {
+      capacity = iree_max(64, capacity * 2);
+      status = iree_allocator_realloc(host_allocator, capacity * sizeof(*ops),
+                                      (void**)&ops);
+      if (!iree_status_is_ok(status)) break;
+    }
+    ops[op_count].slot = slot;
+    ops[op_count].size = op_type == 'a' ? (iree_device_size_t)size : 0;
+    ++op_count;
+    slot_count = iree_max(slot_count, (iree_host_size_t)slot + 1);
+  }
+  if (iree_status_is_ok(status)) {
+    out_trace->slot_count = slot_count;
+    out_trace->op_count = op_count;
+    out_trace->ops = ops;
+  } else {
+    iree_allocator_free(host_allocator, ops);
+  }
+  return status;
+}
+
+typedef struct iree_hal_allocator_benchmark_params_t {
+  const iree_hal_allocation_trace_t* trace;
+  bool cached;
+} iree_hal_allocator_benchmark_params_t;
+
+// Replays a trace against a heap allocator with or without caching.
+// Each benchmark iteration replays the full trace and any buffers still live
+// at the end of the trace are released.
+static iree_status_t iree_hal_allocator_benchmark_replay(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  const iree_hal_allocator_benchmark_params_t* params =
+      (const iree_hal_allocator_benchmark_params_t*)benchmark_def->user_data;
+  const iree_hal_allocation_trace_t* trace = params->trace;
+  iree_allocator_t host_allocator = benchmark_state->host_allocator;
+
+  iree_hal_heap_allocator_params_t allocator_params;
+  iree_hal_heap_allocator_params_initialize(&allocator_params);
+  if (params->cached) {
+    allocator_params.cache_capacity =
+        (iree_device_size_t)iree_max(0, FLAG_cache_capacity);
+  }
+  iree_hal_allocator_t* allocator = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_allocator_create_heap_with_params(
+      iree_make_cstring_view("benchmark"), &allocator_params, host_allocator,
+      host_allocator, &allocator));
+
+  iree_hal_buffer_t** slots = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, trace->slot_count * sizeof(*slots), (void**)&slots);
+
+  while (iree_status_is_ok(status) &&
+         iree_benchmark_keep_running(benchmark_state,
+                                     /*batch_count=*/trace->op_count)) {
+    for (iree_host_size_t i = 0; i < trace->op_count; ++i) {
+      const iree_hal_allocation_trace_op_t* op = &trace->ops[i];
+      iree_hal_buffer_release(slots[op->slot]);
+      slots[op->slot] = NULL;
+      if (op->size == 0) continue;
+      status = iree_hal_allocator_allocate_buffer(
+          allocator,
+          IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+          IREE_HAL_BUFFER_USAGE_DISPATCH | IREE_HAL_BUFFER_USAGE_TRANSFER,
+          op->size, iree_const_byte_span_empty(), &slots[op->slot]);
+      if (!iree_status_is_ok(status)) break;
+
+      // Touch the first byte of each page as a dispatch writing the buffer
+      // would; this is where fresh allocations pay for their page faults.
+      iree_hal_buffer_mapping_t mapping;
+      status = iree_hal_buffer_map_range(
+          slots[op->slot], IREE_HAL_MAPPING_MODE_SCOPED,
+          IREE_HAL_MEMORY_ACCESS_WRITE, 0, IREE_WHOLE_BUFFER, &mapping);
+      if (!iree_status_is_ok(status)) break;
+      for (iree_host_size_t j = 0; j < mapping.contents.data_length;
+           j += 4096) {
+        mapping.contents.data[j] = (uint8_t)j;
+      }
+      iree_hal_buffer_unmap_range(&mapping);
+    }
+    for (iree_host_size_t i = 0; i < trace->slot_count; ++i) {
+      iree_hal_buffer_release(slots[i]);
+      slots[i] = NULL;
+    }
+  }
+
+  if (slots) {
+    for (iree_host_size_t i = 0; i < trace->slot_count; ++i) {
+      iree_hal_buffer_release(slots[i]);
+    }
+  }
+  iree_allocator_free(host_allocator, slots);
+  iree_hal_allocator_release(allocator);
+  return status;
+}
+
+static void iree_hal_allocator_benchmark_register_trace(
+    const char* name, const iree_hal_allocation_trace_t* trace) {
+  // Leaked; benchmark definitions must outlive registration.
+  iree_hal_allocator_benchmark_params_t* params = NULL;
+  IREE_CHECK_OK(iree_allocator_malloc(iree_allocator_system(),
+                                      2 * sizeof(*params), (void**)&params));
+  params[0].trace = trace;
+  params[0].cached = false;
+  params[1].trace = trace;
+  params[1].cached = true;
+
+  iree_benchmark_def_t benchmark_def = {
+      .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+               IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+      .time_unit = IREE_BENCHMARK_UNIT_NANOSECOND,
+      .minimum_duration_ns = 0,
+      .iteration_count = 0,
+      .run = iree_hal_allocator_benchmark_replay,
+  };
+  char benchmark_name[128];
+  snprintf(benchmark_name, sizeof(benchmark_name), "%s_uncached", name);
+  benchmark_def.user_data = &params[0];
+  iree_benchmark_register(iree_make_cstring_view(benchmark_name),
+                          &benchmark_def);
+  snprintf(benchmark_name, sizeof(benchmark_name), "%s_cached", name);
+  benchmark_def.user_data = &params[1];
+  iree_benchmark_register(iree_make_cstring_view(benchmark_name),
+                          &benchmark_def);
+}
+
+// Matmul dimensions used to measure the effect of large pages on TLB misses.
+// The 32MB RHS is walked down its columns as a kernel streaming a transposed
+// operand would: each step of the reduction touches a new 16KB row and thus a
+// new base page, far exceeding the TLB reach of base pages while needing only
+// 16 huge pages.
+#define IREE_HAL_MATMUL_M 4
+#define IREE_HAL_MATMUL_K 2048
+#define IREE_HAL_MATMUL_N 4096
+#define IREE_HAL_MATMUL_TILE_N 16
+
+typedef struct iree_hal_matmul_benchmark_params_t {
+  // Large page flags used for the operands or NONE to use base pages.
+  iree_hal_heap_large_page_flags_t large_page_flags;
+} iree_hal_matmul_benchmark_params_t;
+
+// Allocates a buffer of |size| bytes from |allocator| and maps it for the
+// lifetime of the buffer.
+static iree_status_t iree_hal_matmul_benchmark_allocate(
+    iree_hal_allocator_t* allocator, iree_device_size_t size,
+    iree_hal_buffer_t** out_buffer, iree_hal_buffer_mapping_t* out_mapping) {
+  IREE_RETURN_IF_ERROR(iree_hal_allocator_allocate_buffer(
+      allocator,
+      IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+      IREE_HAL_BUFFER_USAGE_DISPATCH | IREE_HAL_BUFFER_USAGE_MAPPING, size,
+      iree_const_byte_span_empty(), out_buffer));
+  return iree_hal_buffer_map_range(*out_buffer, IREE_HAL_MAPPING_MODE_SCOPED,
+                                   IREE_HAL_MEMORY_ACCESS_ALL, 0,
+                                   IREE_WHOLE_BUFFER, out_mapping);
+}
+
+// Computes OUT = LHS * RHS with operands allocated from a heap allocator with
+// or without large pages. Run under `perf stat -e dTLB-load-misses` to see the
+// TLB miss reduction directly.
+static iree_status_t iree_hal_allocator_benchmark_matmul(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  const iree_hal_matmul_benchmark_params_t* params =
+      (const iree_hal_matmul_benchmark_params_t*)benchmark_def->user_data;
+  iree_allocator_t host_allocator = benchmark_state->host_allocator;
+
+  iree_hal_heap_allocator_params_t allocator_params;
+  iree_hal_heap_allocator_params_initialize(&allocator_params);
+  if (params->large_page_flags != IREE_HAL_HEAP_LARGE_PAGE_FLAG_NONE) {
+    allocator_params.large_page_threshold = MB(1);
+    allocator_params.large_page_flags =
+        params->large_page_flags | IREE_HAL_HEAP_LARGE_PAGE_FLAG_PREFAULT;
+  }
+  iree_hal_allocator_t* allocator = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_allocator_create_heap_with_params(
+      iree_make_cstring_view("benchmark"), &allocator_params, host_allocator,
+      host_allocator, &allocator));
+
+  const iree_host_size_t m = IREE_HAL_MATMUL_M;
+  const iree_host_size_t k = IREE_HAL_MATMUL_K;
+  const iree_host_size_t n = IREE_HAL_MATMUL_N;
+  iree_hal_buffer_t* buffers[3] = {NULL, NULL, NULL};
+  iree_hal_buffer_mapping_t mappings[3];
+  const iree_device_size_t sizes[3] = {
+      m * k * sizeof(float),
+      k * n * sizeof(float),
+      m * n * sizeof(float),
+  };
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(buffers); ++i) {
+    status = iree_hal_matmul_benchmark_allocate(allocator, sizes[i],
+                                                &buffers[i], &mappings[i]);
+    if (!iree_status_is_ok(status)) break;
+  }
+
+  if (iree_status_is_ok(status)) {
+    float* lhs = (float*)mappings[0].contents.data;
+    float* rhs = (float*)mappings[1].contents.data;
+    float* out = (float*)mappings[2].contents.data;
+    for (iree_host_size_t i = 0; i < m * k; ++i) lhs[i] = (float)(i % 7);
+    for (iree_host_size_t i = 0; i < k * n; ++i) rhs[i] = (float)(i % 5);
+
+    while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+      for (iree_host_size_t j = 0; j < n; j += IREE_HAL_MATMUL_TILE_N) {
+        float acc[IREE_HAL_MATMUL_M][IREE_HAL_MATMUL_TILE_N] = {{0}};
+        for (iree_host_size_t r = 0; r < k; ++r) {
+          const float* rhs_row = &rhs[r * n + j];
+          for (iree_host_size_t mi = 0; mi < m; ++mi) {
+            float a = lhs[mi * k + r];
+            for (iree_host_size_t ji = 0; ji < IREE_HAL_MATMUL_TILE_N; ++ji) {
+              acc[mi][ji] += a * rhs_row[ji];
+            }
+          }
+        }
+        for (iree_host_size_t mi = 0; mi < m; ++mi) {
+          memcpy(&out[mi * n + j], acc[mi], sizeof(acc[mi]));
+        }
+      }
+    }
+  }
+
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(buffers); ++i) {
+    if (!buffers[i]) continue;
+    iree_hal_buffer_unmap_range(&mappings[i]);
+    iree_hal_buffer_release(buffers[i]);
+  }
+  iree_hal_allocator_release(allocator);
+  return status;
+}
+
+static void iree_hal_allocator_benchmark_register_matmul(
+    const char* name, iree_hal_heap_large_page_flags_t large_page_flags) {
+  // Leaked; benchmark definitions must outlive registration.
+  iree_hal_matmul_benchmark_params_t* params = NULL;
+  IREE_CHECK_OK(iree_allocator_malloc(iree_allocator_system(), sizeof(*params),
+                                      (void**)&params));
+  params->large_page_flags = large_page_flags;
+  iree_benchmark_def_t benchmark_def = {
+      .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+               IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+      .time_unit = IREE_BENCHMARK_UNIT_MILLISECOND,
+      .minimum_duration_ns = 0,
+      .iteration_count = 0,
+      .run = iree_hal_allocator_benchmark_matmul,
+      .user_data = params,
+  };
+  iree_benchmark_register(iree_make_cstring_view(name), &benchmark_def);
+}
+
+int main(int argc, char** argv) {
+  iree_flags_set_usage(
+      "allocator_heap_benchmark",
+      "Replays allocation traces against the heap HAL allocator with and\n"
+      "without buffer caching and runs a large matmul with operands backed\n"
+      "by base pages and huge pages.\n");
+  iree_flags_parse_checked(IREE_FLAGS_PARSE_MODE_UNDEFINED_OK, &argc, &argv);
+  iree_benchmark_initialize(&argc, argv);
+
+  iree_hal_allocator_benchmark_register_trace(
+      "encoder_layer", &iree_hal_trace_encoder_layer_trace);
+  iree_hal_allocator_benchmark_register_trace(
+      "conv_pyramid", &iree_hal_trace_conv_pyramid_trace);
+  iree_hal_allocator_benchmark_register_trace(
+      "decoder_steps", &iree_hal_trace_decoder_steps_trace);
+
+  iree_hal_allocator_benchmark_register_matmul(
+      "large_matmul_base_pages", IREE_HAL_HEAP_LARGE_PAGE_FLAG_NONE);
+  iree_hal_allocator_benchmark_register_matmul(
+      "large_matmul_transparent_huge_pages",
+      IREE_HAL_HEAP_LARGE_PAGE_FLAG_TRANSPARENT);
+  iree_hal_allocator_benchmark_register_matmul(
+      "large_matmul_explicit_huge_pages",
+      IREE_HAL_HEAP_LARGE_PAGE_FLAG_EXPLICIT);
+
+  iree_hal_allocation_trace_t file_trace = {0};
+  if (strlen(FLAG_allocation_trace) > 0) {
+    iree_byte_span_t contents = iree_byte_span_empty();
+    IREE_CHECK_OK(iree_file_read_contents(
+        FLAG_allocation_trace, iree_allocator_system(), &contents));
+    IREE_CHECK_OK(iree_hal_allocation_trace_parse(
+        iree_make_string_view((const char*)contents.data,
+                              contents.data_length),
+        iree_allocator_system(), &file_trace));
+    iree_allocator_free(iree_allocator_system(), contents.data);
+    iree_hal_allocator_benchmark_register_trace("file", &file_trace);
+  }
+
+  iree_benchmark_run_specified();
+  return 0;
+}
@@ -0,0 +1,279 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <set>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+// All checks are made against the allocator statistics.
+#if IREE_STATISTICS_ENABLE
+
+// Data allocator that tracks its live allocations and fails the test if asked
+// to free storage that it did not allocate.
+struct TrackingAllocator {
+  static iree_status_t Ctl(void* self, iree_allocator_command_t command,
+                           const void* params, void** inout_ptr) {
+    auto* tracker = (TrackingAllocator*)self;
+    switch (command) {
+      case IREE_ALLOCATOR_COMMAND_MALLOC:
+      case IREE_ALLOCATOR_COMMAND_CALLOC: {
+        IREE_RETURN_IF_ERROR(iree_allocator_system_ctl(NULL, command, params,
+                                                       inout_ptr));
+        tracker->live.insert(*inout_ptr);
+        return iree_ok_status();
+      }
+      case IREE_ALLOCATOR_COMMAND_FREE: {
+        if (!tracker->live.erase(*inout_ptr)) {
+          ADD_FAILURE() << "freeing storage not owned by the data allocator";
+          return iree_ok_status();
+        }
+        return iree_allocator_system_ctl(NULL, command, params, inout_ptr);
+      }
+      default:
+        return iree_make_status(IREE_STATUS_UNIMPLEMENTED);
+    }
+  }
+  iree_allocator_t allocator() { return {this, Ctl}; }
+  std::set<void*> live;
+};
+
+class HeapAllocatorTest : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    if (allocator_) iree_hal_allocator_release(allocator_);
+  }
+
+  void CreateAllocator(const iree_hal_heap_allocator_params_t& params,
+                       iree_allocator_t data_allocator =
+                           iree_allocator_system()) {
+    IREE_ASSERT_OK(iree_hal_allocator_create_heap_with_params(
+        iree_make_cstring_view("heap"), &params, data_allocator,
+        iree_allocator_system(), &allocator_));
+  }
+
+  iree_hal_buffer_t* Allocate(iree_device_size_t size) {
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_CHECK_OK(iree_hal_allocator_allocate_buffer(
+        allocator_,
+        IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_DISPATCH | IREE_HAL_BUFFER_USAGE_MAPPING, size,
+        iree_const_byte_span_empty(), &buffer));
+    EXPECT_EQ(size, iree_hal_buffer_allocation_size(buffer));
+    return buffer;
+  }
+
+  // Returns the host pointer to the storage of |buffer|.
+  static uint8_t* StoragePtr(iree_hal_buffer_t* buffer) {
+    iree_hal_buffer_mapping_t mapping;
+    IREE_CHECK_OK(iree_hal_buffer_map_range(
+        buffer, IREE_HAL_MAPPING_MODE_SCOPED, IREE_HAL_MEMORY_ACCESS_WRITE, 0,
+        IREE_WHOLE_BUFFER, &mapping));
+    uint8_t* ptr = mapping.contents.data;
+    iree_hal_buffer_unmap_range(&mapping);
+    return ptr;
+  }
+
+  iree_hal_allocator_statistics_t QueryStatistics() {
+    iree_hal_allocator_statistics_t statistics;
+    iree_hal_allocator_query_statistics(allocator_, &statistics);
+    return statistics;
+  }
+
+  iree_hal_allocator_t* allocator_ = NULL;
+};
+
+// Tests that caching is disabled by default.
+TEST_F(HeapAllocatorTest, CacheDisabled) {
+  iree_hal_heap_allocator_params_t params;
+  iree_hal_heap_allocator_params_initialize(&params);
+  CreateAllocator(params);
+
+  iree_hal_buffer_release(Allocate(1000));
+  iree_hal_buffer_release(Allocate(1000));
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(0, statistics.cache_bytes_retained);
+  EXPECT_EQ(0, statistics.cache_hit_count);
+  EXPECT_EQ(0, statistics.cache_miss_count);
+}
+
+// Tests that allocations are rounded up to size classes with 4 classes per
+// power of two and reuse buffers retained in the same class.
+TEST_F(HeapAllocatorTest, SizeClassSelection) {
+  iree_hal_heap_allocator_params_t params;
+  iree_hal_heap_allocator_params_initialize(&params);
+  params.cache_capacity = 64 * 1024;
+  CreateAllocator(params);
+
+  // 1000 is in the (896, 1024] class and retains 1024 bytes.
+  iree_hal_buffer_t* buffer = Allocate(1000);
+  uint8_t* storage = StoragePtr(buffer);
+  iree_hal_buffer_release(buffer);
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(1024, statistics.cache_bytes_retained);
+  EXPECT_EQ(0, statistics.cache_hit_count);
+  EXPECT_EQ(1, statistics.cache_miss_count);
+
+  // 897 is in the same class and reuses the storage.
+  buffer = Allocate(897);
+  EXPECT_EQ(storage, StoragePtr(buffer));
+  statistics = QueryStatistics();
+  EXPECT_EQ(0, statistics.cache_bytes_retained);
+  EXPECT_EQ(1, statistics.cache_hit_count);
+  iree_hal_buffer_release(buffer);
+
+  // 896 is in the (768, 896] class and 1025 in the (1024, 1280] class.
+  iree_hal_buffer_release(Allocate(896));
+  iree_hal_buffer_release(Allocate(1025));
+  statistics = QueryStatistics();
+  EXPECT_EQ(1, statistics.cache_hit_count);
+  EXPECT_EQ(3, statistics.cache_miss_count);
+  EXPECT_EQ(1024 + 896 + 1280, statistics.cache_bytes_retained);
+
+  // Allocations below the smallest class share the 256 byte class.
+  iree_hal_buffer_release(Allocate(1));
+  iree_hal_buffer_release(Allocate(256));
+  statistics = QueryStatistics();
+  EXPECT_EQ(2, statistics.cache_hit_count);
+  EXPECT_EQ(1024 + 896 + 1280 + 256, statistics.cache_bytes_retained);
+}
+
+// Tests that buffers larger than the largest size class are matched best-fit
+// and not reused when they would waste more than a quarter of their capacity.
+TEST_F(HeapAllocatorTest, LargeBestFit) {
+  iree_hal_heap_allocator_params_t params;
+  iree_hal_heap_allocator_params_initialize(&params);
+  params.cache_capacity = 16 * 1024 * 1024;
+  params.max_size_class = 64 * 1024;
+  CreateAllocator(params);
+
+  // Large buffers are only rounded up to a page multiple.
+  iree_hal_buffer_t* buffer_200k = Allocate(200 * 1024);
+  iree_hal_buffer_t* buffer_100k = Allocate(100 * 1024 + 1);
+  iree_hal_buffer_t* buffer_300k = Allocate(300 * 1024);
+  uint8_t* storage_100k = StoragePtr(buffer_100k);
+  uint8_t* storage_200k = StoragePtr(buffer_200k);
+  iree_hal_buffer_release(buffer_200k);
+  iree_hal_buffer_release(buffer_300k);
+  iree_hal_buffer_release(buffer_100k);
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(200 * 1024 + 104 * 1024 + 300 * 1024,
+            statistics.cache_bytes_retained);
+
+  // The smallest retained buffer that fits is used.
+  iree_hal_buffer_t* buffer = Allocate(90 * 1024);
+  EXPECT_EQ(storage_100k, StoragePtr(buffer));
+  iree_hal_buffer_release(buffer);
+
+  // 200k would waste more than a quarter of its capacity for 150k.
+  buffer = Allocate(150 * 1024);
+  EXPECT_NE(storage_200k, StoragePtr(buffer));
+  statistics = QueryStatistics();
+  EXPECT_EQ(1, statistics.cache_hit_count);
+  EXPECT_EQ(4, statistics.cache_miss_count);
+  iree_hal_buffer_release(buffer);
+
+  // 160k is within a quarter of 200k.
+  buffer = Allocate(160 * 1024);
+  EXPECT_EQ(storage_200k, StoragePtr(buffer));
+  iree_hal_buffer_release(buffer);
+}
+
+// Tests that released buffers are only retained up to the cache capacity.
+TEST_F(HeapAllocatorTest, CapacityLimit) {
+  iree_hal_heap_allocator_params_t params;
+  iree_hal_heap_allocator_params_initialize(&params);
+  params.cache_capacity = 4096;
+  CreateAllocator(params);
+
+  iree_hal_buffer_t* buffers[3] = {Allocate(2048), Allocate(2048),
+                                   Allocate(2048)};
+  for (auto* buffer : buffers) iree_hal_buffer_release(buffer);
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(4096, statistics.cache_bytes_retained);
+  // The buffer that did not fit is freed and no longer counted as live.
+  EXPECT_EQ(statistics.host_bytes_allocated, statistics.host_bytes_freed);
+
+  // Buffers larger than the capacity are never retained.
+  iree_hal_buffer_release(Allocate(8192));
+  statistics = QueryStatistics();
+  EXPECT_EQ(4096, statistics.cache_bytes_retained);
+}
+
+// Tests that trimming releases all retained buffers.
+TEST_F(HeapAllocatorTest, Trim) {
+  iree_hal_heap_allocator_params_t params;
+  iree_hal_heap_allocator_params_initialize(&params);
+  params.cache_capacity = 16 * 1024 * 1024;
+  params.max_size_class = 64 * 1024;
+  CreateAllocator(params);
+
+  iree_hal_buffer_release(Allocate(1000));
+  iree_hal_buffer_release(Allocate(100 * 1024));
+  EXPECT_EQ(1024 + 100 * 1024, QueryStatistics().cache_bytes_retained);
+
+  IREE_ASSERT_OK(iree_hal_allocator_trim(allocator_));
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(0, statistics.cache_bytes_retained);
+
+  // Nothing is left to reuse.
+  iree_hal_buffer_release(Allocate(1000));
+  iree_hal_buffer_release(Allocate(100 * 1024));
+  statistics = QueryStatistics();
+  EXPECT_EQ(0, statistics.cache_hit_count);
+  EXPECT_EQ(4, statistics.cache_miss_count);
+}
+
+// Tests that buffers with large page storage are reused through the cache and
+// that their storage is returned to the large page allocator (and not the data
+// allocator) when trimmed.
+TEST_F(HeapAllocatorTest, LargePageReuse) {
+  TrackingAllocator data_allocator;
+  iree_hal_heap_allocator_params_t params;
+  iree_hal_heap_allocator_params_initialize(&params);
+  params.cache_capacity = 64 * 1024 * 1024;
+  params.max_size_class = 64 * 1024;
+  params.large_page_threshold = 1024 * 1024;
+  CreateAllocator(params, data_allocator.allocator());
+
+  iree_hal_buffer_t* buffer = Allocate(2 * 1024 * 1024);
+  uint8_t* storage = StoragePtr(buffer);
+  memset(storage, 0xCD, 2 * 1024 * 1024);
+  iree_hal_buffer_release(buffer);
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(1, statistics.large_page_mapping_count);
+  EXPECT_GE(statistics.large_page_bytes_mapped, 2 * 1024 * 1024);
+
+  // Reuse the storage a few times; no new mappings are made.
+  for (int i = 0; i < 3; ++i) {
+    buffer = Allocate(2 * 1024 * 1024 - i * 4096);
+    EXPECT_EQ(storage, StoragePtr(buffer));
+    iree_hal_buffer_release(buffer);
+  }
+  // Storage below the threshold still comes from the data allocator.
+  iree_hal_buffer_release(Allocate(100 * 1024));
+  statistics = QueryStatistics();
+  EXPECT_EQ(3, statistics.cache_hit_count);
+  EXPECT_EQ(1, statistics.large_page_mapping_count);
+  EXPECT_EQ(1, data_allocator.live.size());
+
+  IREE_ASSERT_OK(iree_hal_allocator_trim(allocator_));
+  statistics = QueryStatistics();
+  EXPECT_EQ(0, statistics.cache_bytes_retained);
+  EXPECT_EQ(0, statistics.large_page_bytes_mapped);
+  EXPECT_EQ(0, data_allocator.live.size());
+
+  iree_hal_allocator_release(allocator_);
+  allocator_ = NULL;
+}
+
+#endif  // IREE_STATISTICS_ENABLE
+
+}  // namespace
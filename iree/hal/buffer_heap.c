@@ -9,6 +9,7 @@
 #include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/math.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/allocator.h"
 #include "iree/hal/buffer.h"
@@ -23,6 +24,16 @@ typedef struct iree_hal_heap_buffer_t {
 
   // Optional statistics shared with the allocator.
   IREE_STATISTICS(iree_hal_heap_allocator_statistics_t* statistics;)
+
+  // Cache the buffer may be recycled into when released, if any.
+  // The buffer storage capacity (|data|.data_length) is rounded up to the
+  // cache size class.
+  iree_hal_heap_buffer_cache_t* cache;
+  // Next buffer in the cache free list while retained by |cache|.
+  iree_hal_heap_buffer_t* next_free;
+
+  // True if |data| was mapped by a large page policy allocator.
+  bool large_pages;
 } iree_hal_heap_buffer_t;
 
 static const iree_hal_buffer_vtable_t iree_hal_heap_buffer_vtable;
@@ -68,9 +79,219 @@ static iree_status_t iree_hal_heap_buffer_allocate_slab(
   return iree_ok_status();
 }
 
+//===----------------------------------------------------------------------===//
+// iree_hal_heap_buffer_cache_t
+//===----------------------------------------------------------------------===//
+
+// Large blocks are only reused if they waste at most 1/2^N of their capacity.
+#define IREE_HAL_HEAP_BUFFER_CACHE_LARGE_WASTE_LOG2 2
+
+// Large blocks are rounded up to a page multiple.
+#define IREE_HAL_HEAP_BUFFER_CACHE_LARGE_ALIGNMENT 4096
+
+static bool iree_hal_heap_buffer_cache_is_enabled(
+    const iree_hal_heap_buffer_cache_t* cache) {
+  return cache && cache->capacity > 0;
+}
+
+// Returns the size class index of |size| and its rounded |out_class_size|.
+// |size| must be <= the maximum class size.
+static iree_host_size_t iree_hal_heap_buffer_cache_select_class(
+    iree_device_size_t size, iree_device_size_t* out_class_size) {
+  const int min_log2 = IREE_HAL_HEAP_BUFFER_CACHE_MIN_CLASS_SIZE_LOG2;
+  const int step_log2 = IREE_HAL_HEAP_BUFFER_CACHE_CLASSES_PER_POW2_LOG2;
+  if (size <= (1ull << min_log2)) {
+    *out_class_size = 1ull << min_log2;
+    return 0;
+  }
+  // 2^k < size <= 2^(k+1); each power of two is split into 2^step_log2 steps.
+  int k = 63 - iree_math_count_leading_zeros_u64((uint64_t)size - 1);
+  uint64_t step = 1ull << (k - step_log2);
+  uint64_t sub = (size - (1ull << k) + step - 1) >> (k - step_log2);
+  *out_class_size = (1ull << k) + sub * step;
+  return ((iree_host_size_t)(k - min_log2) << step_log2) +
+         (iree_host_size_t)sub;
+}
+
+// Returns the capacity to allocate for a buffer of |size| bytes such that it
+// can later be recycled into |cache|.
+static iree_device_size_t iree_hal_heap_buffer_cache_round_size(
+    const iree_hal_heap_buffer_cache_t* cache, iree_device_size_t size) {
+  if (size > cache->max_size_class) {
+    return iree_device_align(size, IREE_HAL_HEAP_BUFFER_CACHE_LARGE_ALIGNMENT);
+  }
+  iree_device_size_t class_size = 0;
+  iree_hal_heap_buffer_cache_select_class(size, &class_size);
+  return class_size;
+}
+
+void iree_hal_heap_buffer_cache_initialize(
+    iree_device_size_t capacity, iree_device_size_t max_size_class,
+    iree_hal_heap_allocator_statistics_t* statistics,
+    iree_hal_heap_buffer_cache_t* out_cache) {
+  memset(out_cache, 0, sizeof(*out_cache));
+  iree_slim_mutex_initialize(&out_cache->mutex);
+  out_cache->capacity = capacity;
+  out_cache->max_size_class = iree_min(
+      max_size_class, 1ull << IREE_HAL_HEAP_BUFFER_CACHE_MAX_CLASS_SIZE_LOG2);
+  IREE_STATISTICS(out_cache->statistics = statistics);
+}
+
+static void iree_hal_heap_buffer_free_storage(iree_hal_heap_buffer_t* buffer);
+
+static void iree_hal_heap_buffer_free_list(iree_hal_heap_buffer_t* list) {
+  while (list) {
+    iree_hal_heap_buffer_t* next = list->next_free;
+    iree_hal_heap_buffer_free_storage(list);
+    list = next;
+  }
+}
+
+void iree_hal_heap_buffer_cache_trim(iree_hal_heap_buffer_cache_t* cache) {
+  if (!iree_hal_heap_buffer_cache_is_enabled(cache)) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Detach all lists under the lock and free outside of it.
+  iree_hal_heap_buffer_t* class_lists[IREE_HAL_HEAP_BUFFER_CACHE_CLASS_COUNT];
+  iree_slim_mutex_lock(&cache->mutex);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, cache->retained_size);
+  memcpy(class_lists, cache->class_lists, sizeof(class_lists));
+  memset(cache->class_lists, 0, sizeof(cache->class_lists));
+  iree_hal_heap_buffer_t* large_list = cache->large_list;
+  cache->large_list = NULL;
+  cache->retained_size = 0;
+  iree_slim_mutex_unlock(&cache->mutex);
+
+  IREE_STATISTICS({
+    if (cache->statistics) {
+      iree_slim_mutex_lock(&cache->statistics->mutex);
+      cache->statistics->base.cache_bytes_retained = 0;
+      iree_slim_mutex_unlock(&cache->statistics->mutex);
+    }
+  });
+
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(class_lists); ++i) {
+    iree_hal_heap_buffer_free_list(class_lists[i]);
+  }
+  iree_hal_heap_buffer_free_list(large_list);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+void iree_hal_heap_buffer_cache_deinitialize(
+    iree_hal_heap_buffer_cache_t* cache) {
+  iree_hal_heap_buffer_cache_trim(cache);
+  iree_slim_mutex_deinitialize(&cache->mutex);
+}
+
+// Updates the cache statistics with a change in the retained size and whether
+// an allocation hit or missed.
+static void iree_hal_heap_buffer_cache_record(
+    iree_hal_heap_buffer_cache_t* cache, iree_device_size_t retained_size,
+    int hit_count, int miss_count) {
+  IREE_STATISTICS({
+    if (cache->statistics) {
+      iree_slim_mutex_lock(&cache->statistics->mutex);
+      cache->statistics->base.cache_bytes_retained = retained_size;
+      cache->statistics->base.cache_hit_count += hit_count;
+      cache->statistics->base.cache_miss_count += miss_count;
+      iree_slim_mutex_unlock(&cache->statistics->mutex);
+    }
+  });
+}
+
+// Removes a retained buffer with a capacity of at least |size| from |cache|.
+// Returns NULL if no suitable buffer is retained.
+static iree_hal_heap_buffer_t* iree_hal_heap_buffer_cache_acquire(
+    iree_hal_heap_buffer_cache_t* cache, iree_device_size_t size) {
+  iree_hal_heap_buffer_t* buffer = NULL;
+  iree_slim_mutex_lock(&cache->mutex);
+  if (size <= cache->max_size_class) {
+    iree_device_size_t class_size = 0;
+    iree_host_size_t class_index =
+        iree_hal_heap_buffer_cache_select_class(size, &class_size);
+    buffer = cache->class_lists[class_index];
+    if (buffer) cache->class_lists[class_index] = buffer->next_free;
+  } else {
+    // The list is sorted by capacity so the first that fits is the best fit.
+    iree_device_size_t max_capacity =
+        size + (size >> IREE_HAL_HEAP_BUFFER_CACHE_LARGE_WASTE_LOG2);
+    iree_hal_heap_buffer_t** link = &cache->large_list;
+    while (*link && (*link)->data.data_length < size) {
+      link = &(*link)->next_free;
+    }
+    if (*link && (*link)->data.data_length <= max_capacity) {
+      buffer = *link;
+      *link = buffer->next_free;
+    }
+  }
+  if (buffer) {
+    buffer->next_free = NULL;
+    cache->retained_size -= buffer->data.data_length;
+  }
+  iree_device_size_t retained_size = cache->retained_size;
+  iree_slim_mutex_unlock(&cache->mutex);
+  iree_hal_heap_buffer_cache_record(cache, retained_size, buffer ? 1 : 0,
+                                    buffer ? 0 : 1);
+  return buffer;
+}
+
+bool iree_hal_heap_buffer_cache_recycle(iree_hal_heap_buffer_cache_t* cache,
+                                        iree_hal_buffer_t* base_buffer) {
+  if (!iree_hal_heap_buffer_cache_is_enabled(cache)) return false;
+  if (!iree_hal_resource_is(base_buffer, &iree_hal_heap_buffer_vtable)) {
+    return false;  // subspan or other buffer type
+  }
+  iree_hal_heap_buffer_t* buffer = (iree_hal_heap_buffer_t*)base_buffer;
+  if (buffer->cache != cache) return false;  // wrapped or foreign buffer
+  iree_device_size_t capacity = buffer->data.data_length;
+
+  iree_slim_mutex_lock(&cache->mutex);
+  bool retained = cache->retained_size + capacity <= cache->capacity;
+  if (retained) {
+    if (capacity <= cache->max_size_class) {
+      iree_device_size_t class_size = 0;
+      iree_host_size_t class_index =
+          iree_hal_heap_buffer_cache_select_class(capacity, &class_size);
+      buffer->next_free = cache->class_lists[class_index];
+      cache->class_lists[class_index] = buffer;
+    } else {
+      iree_hal_heap_buffer_t** link = &cache->large_list;
+      while (*link && (*link)->data.data_length < capacity) {
+        link = &(*link)->next_free;
+      }
+      buffer->next_free = *link;
+      *link = buffer;
+    }
+    cache->retained_size += capacity;
+  }
+  iree_device_size_t retained_size = cache->retained_size;
+  iree_slim_mutex_unlock(&cache->mutex);
+  if (!retained) return false;
+
+  // The buffer is no longer live from the perspective of the allocator.
+  IREE_STATISTICS({
+    if (buffer->statistics != NULL) {
+      iree_slim_mutex_lock(&buffer->statistics->mutex);
+      iree_hal_allocator_statistics_record_free(&buffer->statistics->base,
+                                                base_buffer->memory_type,
+                                                base_buffer->allocation_size);
+      iree_slim_mutex_unlock(&buffer->statistics->mutex);
+    }
+  });
+  iree_hal_heap_buffer_cache_record(cache, retained_size, 0, 0);
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_heap_buffer_t
+//===----------------------------------------------------------------------===//
+
 iree_status_t iree_hal_heap_buffer_create(
     iree_hal_allocator_t* allocator,
     iree_hal_heap_allocator_statistics_t* statistics,
+    iree_hal_heap_buffer_cache_t* cache,
+    const iree_hal_heap_large_page_policy_t* large_pages,
     iree_hal_memory_type_t memory_type, iree_hal_memory_access_t allowed_access,
     iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
     iree_allocator_t data_allocator, iree_allocator_t host_allocator,
@@ -85,23 +306,54 @@ iree_status_t iree_hal_heap_buffer_create(
   bool same_allocator =
       memcmp(&data_allocator, &host_allocator, sizeof(data_allocator)) == 0;
 
+  // Reuse a retained buffer if possible and otherwise round up the storage so
+  // that the buffer can be recycled into the cache when released.
   iree_hal_heap_buffer_t* buffer = NULL;
   iree_byte_span_t data = iree_make_byte_span(NULL, 0);
-  iree_status_t status =
-      same_allocator
-          ? iree_hal_heap_buffer_allocate_slab(allocation_size, host_allocator,
-                                               &buffer, &data)
-          : iree_hal_heap_buffer_allocate_split(allocation_size, data_allocator,
-                                                host_allocator, &buffer, &data);
+  iree_device_size_t capacity = allocation_size;
+  if (iree_hal_heap_buffer_cache_is_enabled(cache)) {
+    buffer = iree_hal_heap_buffer_cache_acquire(cache, allocation_size);
+    if (!buffer) {
+      capacity = iree_hal_heap_buffer_cache_round_size(cache, allocation_size);
+    }
+  } else {
+    cache = NULL;
+  }
+
+  // Large buffers get their storage mapped with large pages; this must be split
+  // from the metadata so that the storage can be aligned to the large pages.
+  bool use_large_pages = false;
+  if (!buffer && large_pages && large_pages->threshold > 0 &&
+      allocation_size >= large_pages->threshold) {
+    use_large_pages = true;
+    data_allocator = large_pages->allocator;
+    same_allocator = false;
+  }
+
+  // Buffers reused from the cache keep the storage (and the allocator that
+  // must free it) they were originally created with.
+  iree_status_t status = iree_ok_status();
+  if (!buffer) {
+    status = same_allocator ? iree_hal_heap_buffer_allocate_slab(
+                                  capacity, host_allocator, &buffer, &data)
+                            : iree_hal_heap_buffer_allocate_split(
+                                  capacity, data_allocator, host_allocator,
+                                  &buffer, &data);
+    if (iree_status_is_ok(status)) {
+      buffer->data = data;
+      buffer->data_allocator =
+          same_allocator ? iree_allocator_null() : data_allocator;
+      buffer->large_pages = use_large_pages;
+    }
+  }
 
   if (iree_status_is_ok(status)) {
     iree_hal_buffer_initialize(host_allocator, allocator, &buffer->base,
                                allocation_size, 0, allocation_size, memory_type,
                                allowed_access, allowed_usage,
                                &iree_hal_heap_buffer_vtable, &buffer->base);
-    buffer->data = data;
-    buffer->data_allocator =
-        same_allocator ? iree_allocator_null() : data_allocator;
+    buffer->cache = cache;
+    buffer->next_free = NULL;
 
     IREE_STATISTICS({
       if (statistics != NULL) {
@@ -109,6 +361,10 @@ iree_status_t iree_hal_heap_buffer_create(
         iree_slim_mutex_lock(&statistics->mutex);
         iree_hal_allocator_statistics_record_alloc(
             &statistics->base, memory_type, allocation_size);
+        if (use_large_pages) {
+          statistics->base.large_page_bytes_mapped += data.data_length;
+          ++statistics->base.large_page_mapping_count;
+        }
         iree_slim_mutex_unlock(&statistics->mutex);
       }
     });
@@ -149,9 +405,22 @@ IREE_API_EXPORT iree_status_t iree_hal_heap_buffer_wrap(
   return status;
 }
 
+static void iree_hal_heap_buffer_free_storage(iree_hal_heap_buffer_t* buffer) {
+  IREE_STATISTICS({
+    if (buffer->large_pages && buffer->statistics != NULL) {
+      iree_slim_mutex_lock(&buffer->statistics->mutex);
+      buffer->statistics->base.large_page_bytes_mapped -=
+          buffer->data.data_length;
+      iree_slim_mutex_unlock(&buffer->statistics->mutex);
+    }
+  });
+  iree_allocator_t host_allocator = buffer->base.host_allocator;
+  iree_allocator_free(buffer->data_allocator, buffer->data.data);
+  iree_allocator_free(host_allocator, buffer);
+}
+
 static void iree_hal_heap_buffer_destroy(iree_hal_buffer_t* base_buffer) {
   iree_hal_heap_buffer_t* buffer = (iree_hal_heap_buffer_t*)base_buffer;
-  iree_allocator_t host_allocator = base_buffer->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
   IREE_STATISTICS({
@@ -164,8 +433,7 @@ static void iree_hal_heap_buffer_destroy(iree_hal_buffer_t* base_buffer) {
     }
   });
 
-  iree_allocator_free(buffer->data_allocator, buffer->data.data);
-  iree_allocator_free(host_allocator, buffer);
+  iree_hal_heap_buffer_free_storage(buffer);
 
   IREE_TRACE_ZONE_END(z0);
 }
@@ -26,13 +26,93 @@ typedef struct iree_hal_heap_allocator_statistics_t {
   iree_hal_allocator_statistics_t base;
 } iree_hal_heap_allocator_statistics_t;
 
+// Smallest size class; smaller allocations are rounded up to this.
+#define IREE_HAL_HEAP_BUFFER_CACHE_MIN_CLASS_SIZE_LOG2 8
+// Number of size classes between each power of two.
+#define IREE_HAL_HEAP_BUFFER_CACHE_CLASSES_PER_POW2_LOG2 2
+// Largest size class that can be tracked; larger |max_size_class| values are
+// clamped to this.
+#define IREE_HAL_HEAP_BUFFER_CACHE_MAX_CLASS_SIZE_LOG2 32
+#define IREE_HAL_HEAP_BUFFER_CACHE_CLASS_COUNT                 \
+  (((IREE_HAL_HEAP_BUFFER_CACHE_MAX_CLASS_SIZE_LOG2 -          \
+     IREE_HAL_HEAP_BUFFER_CACHE_MIN_CLASS_SIZE_LOG2)           \
+    << IREE_HAL_HEAP_BUFFER_CACHE_CLASSES_PER_POW2_LOG2) +     \
+   1)
+
+typedef struct iree_hal_heap_buffer_t iree_hal_heap_buffer_t;
+
+// A cache of released heap buffers owned by a heap allocator.
+// Buffers at or below |max_size_class| are rounded up to a size class and kept
+// in per-class LIFO free lists so that a hit is O(1) and returns the most
+// recently used (and likely still cache/TLB-warm) storage. Larger buffers are
+// kept in a list sorted by capacity and matched best-fit.
+//
+// Thread-safe; buffers may be released from any thread.
+typedef struct iree_hal_heap_buffer_cache_t {
+  iree_slim_mutex_t mutex;
+  // Maximum total bytes of storage retained.
+  iree_device_size_t capacity;
+  // Largest allocation size that is rounded to a size class.
+  iree_device_size_t max_size_class;
+  // Total bytes of storage currently retained.
+  iree_device_size_t retained_size IREE_GUARDED_BY(mutex);
+  // Free lists of retained buffers for each size class.
+  iree_hal_heap_buffer_t* class_lists[IREE_HAL_HEAP_BUFFER_CACHE_CLASS_COUNT]
+      IREE_GUARDED_BY(mutex);
+  // Retained buffers larger than |max_size_class| sorted by capacity.
+  iree_hal_heap_buffer_t* large_list IREE_GUARDED_BY(mutex);
+  // Optional statistics shared with the allocator.
+  IREE_STATISTICS(iree_hal_heap_allocator_statistics_t* statistics;)
+} iree_hal_heap_buffer_cache_t;
+
+// Initializes |out_cache| to retain up to |capacity| bytes of storage.
+// A |capacity| of 0 disables caching. |statistics| is optional.
+void iree_hal_heap_buffer_cache_initialize(
+    iree_device_size_t capacity, iree_device_size_t max_size_class,
+    iree_hal_heap_allocator_statistics_t* statistics,
+    iree_hal_heap_buffer_cache_t* out_cache);
+
+// Deinitializes |cache| and frees all retained buffers.
+void iree_hal_heap_buffer_cache_deinitialize(
+    iree_hal_heap_buffer_cache_t* cache);
+
+// Frees all retained buffers in |cache|.
+void iree_hal_heap_buffer_cache_trim(iree_hal_heap_buffer_cache_t* cache);
+
+// Attempts to retain |buffer| in |cache| after its last reference has been
+// released. Returns true if the buffer was retained and false if it must be
+// destroyed by the caller (it was not allocated from the cache or the cache is
+// at capacity).
+bool iree_hal_heap_buffer_cache_recycle(iree_hal_heap_buffer_cache_t* cache,
+                                        iree_hal_buffer_t* buffer);
+
+// Policy for mapping the storage of large heap buffers with large pages; owned
+// by a heap allocator.
+typedef struct iree_hal_heap_large_page_policy_t {
+  // Buffers with an allocation size of at least this many bytes have their
+  // storage allocated from |allocator|. 0 disables the policy.
+  iree_device_size_t threshold;
+  // Allocator mapping pages directly from the system with large page hints.
+  iree_allocator_t allocator;
+} iree_hal_heap_large_page_policy_t;
+
 // Allocates a new heap buffer from the specified |data_allocator|.
 // |host_allocator| is used for the iree_hal_buffer_t metadata. If both
 // |data_allocator| and |host_allocator| are the same the buffer will be created
 // as a flat slab. |out_buffer| must be released by the caller.
+//
+// If |cache| is provided and enabled a retained buffer of sufficient capacity
+// is reused if available and otherwise the new buffer storage is rounded up so
+// that it can be recycled into the cache when released. The contents of reused
+// buffers are undefined.
+//
+// If |large_pages| is provided then new storage for buffers at or above its
+// threshold is allocated from its allocator instead of |data_allocator|.
 iree_status_t iree_hal_heap_buffer_create(
     iree_hal_allocator_t* allocator,
     iree_hal_heap_allocator_statistics_t* statistics,
+    iree_hal_heap_buffer_cache_t* cache,
+    const iree_hal_heap_large_page_policy_t* large_pages,
     iree_hal_memory_type_t memory_type, iree_hal_memory_access_t allowed_access,
     iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
     iree_allocator_t data_allocator, iree_allocator_t host_allocator,
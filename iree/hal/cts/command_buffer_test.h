@@ -245,6 +245,137 @@ TEST_P(command_buffer_test, CopySubBuffer) {
   iree_hal_buffer_release(host_buffer);
 }
 
+// Commands separated by barriers must observe each other's effects when they
+// access the same memory (read-after-write and write-after-read) even when
+// other independent commands are recorded in between.
+TEST_P(command_buffer_test, CopyChainAcrossBarriers) {
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_command_buffer_create(
+      device_, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT,
+      IREE_HAL_COMMAND_CATEGORY_TRANSFER, IREE_HAL_QUEUE_AFFINITY_ANY,
+      &command_buffer));
+
+  iree_hal_buffer_t* buffers[4] = {NULL};
+  for (auto& buffer : buffers) {
+    IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+        device_allocator_,
+        IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_ALL, kBufferSize,
+        iree_const_byte_span_empty(), &buffer));
+  }
+  iree_hal_buffer_t* a = buffers[0];
+  iree_hal_buffer_t* b = buffers[1];
+  iree_hal_buffer_t* c = buffers[2];
+  iree_hal_buffer_t* unrelated = buffers[3];
+
+  auto barrier = [&]() {
+    return iree_hal_command_buffer_execution_barrier(
+        command_buffer, IREE_HAL_EXECUTION_STAGE_TRANSFER,
+        IREE_HAL_EXECUTION_STAGE_TRANSFER, IREE_HAL_EXECUTION_BARRIER_FLAG_NONE,
+        /*memory_barrier_count=*/0, NULL, /*buffer_barrier_count=*/0, NULL);
+  };
+
+  uint8_t first_val = 0x11;
+  uint8_t second_val = 0x22;
+  uint8_t unrelated_val = 0x33;
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer));
+  // a = first
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer, a, /*target_offset=*/0, kBufferSize, &first_val,
+      /*pattern_length=*/sizeof(first_val)));
+  IREE_ASSERT_OK(barrier());
+  // b = a (read-after-write of a); unrelated work in the same scope.
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer, a, /*source_offset=*/0, b, /*target_offset=*/0,
+      kBufferSize));
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer, unrelated, /*target_offset=*/0, kBufferSize,
+      &unrelated_val, /*pattern_length=*/sizeof(unrelated_val)));
+  IREE_ASSERT_OK(barrier());
+  // a = second (write-after-read of a by the copy into b).
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer, a, /*target_offset=*/0, kBufferSize, &second_val,
+      /*pattern_length=*/sizeof(second_val)));
+  IREE_ASSERT_OK(barrier());
+  // c = a (read-after-write of a).
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer, a, /*source_offset=*/0, c, /*target_offset=*/0,
+      kBufferSize));
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer));
+
+  IREE_ASSERT_OK(SubmitCommandBufferAndWait(IREE_HAL_COMMAND_CATEGORY_TRANSFER,
+                                            command_buffer));
+
+  std::vector<uint8_t> actual_data(kBufferSize);
+  IREE_ASSERT_OK(iree_hal_buffer_read_data(b, /*source_offset=*/0,
+                                           actual_data.data(), kBufferSize));
+  EXPECT_THAT(actual_data,
+              ContainerEq(std::vector<uint8_t>(kBufferSize, first_val)));
+  IREE_ASSERT_OK(iree_hal_buffer_read_data(c, /*source_offset=*/0,
+                                           actual_data.data(), kBufferSize));
+  EXPECT_THAT(actual_data,
+              ContainerEq(std::vector<uint8_t>(kBufferSize, second_val)));
+  IREE_ASSERT_OK(iree_hal_buffer_read_data(unrelated, /*source_offset=*/0,
+                                           actual_data.data(), kBufferSize));
+  EXPECT_THAT(actual_data,
+              ContainerEq(std::vector<uint8_t>(kBufferSize, unrelated_val)));
+
+  // Must release the command buffer before resources used by it.
+  iree_hal_command_buffer_release(command_buffer);
+  for (auto& buffer : buffers) iree_hal_buffer_release(buffer);
+}
+
+// Reusable command buffers must observe the buffer contents at the time of
+// each submission.
+TEST_P(command_buffer_test, SubmitReusableMultipleTimes) {
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_command_buffer_create(
+      device_, /*mode=*/0, IREE_HAL_COMMAND_CATEGORY_TRANSFER,
+      IREE_HAL_QUEUE_AFFINITY_ANY, &command_buffer));
+
+  iree_hal_buffer_t* buffers[3] = {NULL};
+  for (auto& buffer : buffers) {
+    IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+        device_allocator_,
+        IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_ALL, kBufferSize,
+        iree_const_byte_span_empty(), &buffer));
+  }
+  iree_hal_buffer_t* a = buffers[0];
+  iree_hal_buffer_t* b = buffers[1];
+  iree_hal_buffer_t* c = buffers[2];
+
+  // c = b = a
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer));
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer, a, /*source_offset=*/0, b, /*target_offset=*/0,
+      kBufferSize));
+  IREE_ASSERT_OK(iree_hal_command_buffer_execution_barrier(
+      command_buffer, IREE_HAL_EXECUTION_STAGE_TRANSFER,
+      IREE_HAL_EXECUTION_STAGE_TRANSFER, IREE_HAL_EXECUTION_BARRIER_FLAG_NONE,
+      /*memory_barrier_count=*/0, NULL, /*buffer_barrier_count=*/0, NULL));
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer, b, /*source_offset=*/0, c, /*target_offset=*/0,
+      kBufferSize));
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer));
+
+  std::vector<uint8_t> actual_data(kBufferSize);
+  for (uint8_t i = 1; i <= 3; ++i) {
+    std::vector<uint8_t> source_data(kBufferSize, i);
+    IREE_ASSERT_OK(iree_hal_buffer_write_data(a, /*target_offset=*/0,
+                                              source_data.data(), kBufferSize));
+    IREE_ASSERT_OK(SubmitCommandBufferAndWait(
+        IREE_HAL_COMMAND_CATEGORY_TRANSFER, command_buffer));
+    IREE_ASSERT_OK(iree_hal_buffer_read_data(c, /*source_offset=*/0,
+                                             actual_data.data(), kBufferSize));
+    EXPECT_THAT(actual_data, ContainerEq(source_data));
+  }
+
+  // Must release the command buffer before resources used by it.
+  iree_hal_command_buffer_release(command_buffer);
+  for (auto& buffer : buffers) iree_hal_buffer_release(buffer);
+}
+
 TEST_P(command_buffer_test, FillBuffer_pattern1_size1_offset0_length1) {
   iree_device_size_t buffer_size = 1;
   iree_device_size_t target_offset = 0;
@@ -8,6 +8,7 @@
 #define IREE_HAL_CTS_EVENT_TEST_H_
 
 #include <cstdint>
+#include <vector>
 
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
@@ -19,6 +20,8 @@ namespace iree {
 namespace hal {
 namespace cts {
 
+using ::testing::ContainerEq;
+
 class event_test : public CtsTestBase {};
 
 TEST_P(event_test, Create) {
@@ -51,6 +54,93 @@ TEST_P(event_test, SignalAndReset) {
   iree_hal_command_buffer_release(command_buffer);
 }
 
+// Commands recorded after a wait must observe the results of all commands
+// recorded before the signal even when unrelated work is recorded in between.
+TEST_P(event_test, SplitBarrierWithinCommandBuffer) {
+  static constexpr iree_device_size_t kBufferSize = 4096;
+
+  iree_hal_event_t* event;
+  IREE_ASSERT_OK(iree_hal_event_create(device_, &event));
+
+  iree_hal_command_buffer_t* command_buffer;
+  IREE_ASSERT_OK(iree_hal_command_buffer_create(
+      device_, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT,
+      IREE_HAL_COMMAND_CATEGORY_ANY, IREE_HAL_QUEUE_AFFINITY_ANY,
+      &command_buffer));
+
+  iree_hal_buffer_t* buffers[3] = {NULL};
+  for (auto& buffer : buffers) {
+    IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+        device_allocator_,
+        IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_ALL, kBufferSize,
+        iree_const_byte_span_empty(), &buffer));
+  }
+  iree_hal_buffer_t* a = buffers[0];
+  iree_hal_buffer_t* b = buffers[1];
+  iree_hal_buffer_t* c = buffers[2];
+
+  const iree_hal_event_t* event_ptrs[] = {event};
+  auto wait = [&]() {
+    return iree_hal_command_buffer_wait_events(
+        command_buffer, IREE_ARRAYSIZE(event_ptrs), event_ptrs,
+        /*source_stage_mask=*/IREE_HAL_EXECUTION_STAGE_TRANSFER,
+        /*target_stage_mask=*/IREE_HAL_EXECUTION_STAGE_TRANSFER,
+        /*memory_barrier_count=*/0, /*memory_barriers=*/NULL,
+        /*buffer_barrier_count=*/0, /*buffer_barriers=*/NULL);
+  };
+
+  uint8_t a_val = 0x11;
+  uint8_t b_val = 0x22;
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer));
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer, a, /*target_offset=*/0, kBufferSize, &a_val,
+      /*pattern_length=*/sizeof(a_val)));
+  IREE_ASSERT_OK(iree_hal_command_buffer_signal_event(
+      command_buffer, event, IREE_HAL_EXECUTION_STAGE_TRANSFER));
+  // Independent of both the signal and the wait.
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer, b, /*target_offset=*/0, kBufferSize, &b_val,
+      /*pattern_length=*/sizeof(b_val)));
+  IREE_ASSERT_OK(wait());
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer, a, /*source_offset=*/0, c, /*target_offset=*/0,
+      kBufferSize));
+  // Events may be signaled again after a reset and waits order after the
+  // most recent signal.
+  IREE_ASSERT_OK(iree_hal_command_buffer_reset_event(
+      command_buffer, event, IREE_HAL_EXECUTION_STAGE_TRANSFER));
+  IREE_ASSERT_OK(iree_hal_command_buffer_signal_event(
+      command_buffer, event, IREE_HAL_EXECUTION_STAGE_TRANSFER));
+  IREE_ASSERT_OK(wait());
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer, b, /*source_offset=*/0, a, /*target_offset=*/0,
+      kBufferSize));
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer));
+
+  IREE_ASSERT_OK(SubmitCommandBufferAndWait(IREE_HAL_COMMAND_CATEGORY_ANY,
+                                            command_buffer));
+
+  std::vector<uint8_t> actual_data(kBufferSize);
+  IREE_ASSERT_OK(iree_hal_buffer_read_data(a, /*source_offset=*/0,
+                                           actual_data.data(), kBufferSize));
+  EXPECT_THAT(actual_data,
+              ContainerEq(std::vector<uint8_t>(kBufferSize, b_val)));
+  IREE_ASSERT_OK(iree_hal_buffer_read_data(c, /*source_offset=*/0,
+                                           actual_data.data(), kBufferSize));
+  EXPECT_THAT(actual_data,
+              ContainerEq(std::vector<uint8_t>(kBufferSize, a_val)));
+
+  // Must release the command buffer before resources used by it.
+  iree_hal_command_buffer_release(command_buffer);
+  for (auto& buffer : buffers) iree_hal_buffer_release(buffer);
+  iree_hal_event_release(event);
+}
+
+// Only checks that waits on events signaled by another command buffer are
+// accepted and the submission completes. Drivers are not required to support
+// events across command buffers and may reject the wait with
+// IREE_STATUS_UNIMPLEMENTED; see the CTS README.
 TEST_P(event_test, SubmitWithChainedCommandBuffers) {
   iree_hal_event_t* event;
   IREE_ASSERT_OK(iree_hal_event_create(device_, &event));
@@ -76,13 +166,21 @@ TEST_P(event_test, SubmitWithChainedCommandBuffers) {
   IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer_2));
   const iree_hal_event_t* event_pts[] = {event};
   // TODO(scotttodd): verify execution stage usage (check Vulkan spec)
-  IREE_ASSERT_OK(iree_hal_command_buffer_wait_events(
+  iree_status_t status = iree_hal_command_buffer_wait_events(
       command_buffer_2, IREE_ARRAYSIZE(event_pts), event_pts,
       /*source_stage_mask=*/IREE_HAL_EXECUTION_STAGE_COMMAND_RETIRE,
       /*target_stage_mask=*/IREE_HAL_EXECUTION_STAGE_COMMAND_ISSUE,
       /*memory_barrier_count=*/0,
       /*memory_barriers=*/NULL, /*buffer_barrier_count=*/0,
-      /*buffer_barriers=*/NULL));
+      /*buffer_barriers=*/NULL);
+  if (iree_status_is_unimplemented(status)) {
+    iree_status_ignore(status);
+    iree_hal_command_buffer_release(command_buffer_1);
+    iree_hal_command_buffer_release(command_buffer_2);
+    iree_hal_event_release(event);
+    GTEST_SKIP() << "events across command buffers are not supported";
+  }
+  IREE_ASSERT_OK(status);
   IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer_2));
 
   // No wait semaphores, one signal which we immediately wait on after submit.
@@ -27,6 +27,21 @@
 
 #define IREE_HAL_DYLIB_DRIVER_ID 0x58444C4Cu  // XDLL
 
+IREE_FLAG(int64_t, dylib_heap_cache_capacity, 0,
+          "Maximum bytes of released buffer storage retained by the device\n"
+          "allocator for reuse by future allocations. 0 disables caching.");
+
+IREE_FLAG(int64_t, dylib_heap_large_page_threshold, 0,
+          "Buffers of at least this many bytes are backed by huge pages\n"
+          "(transparent unless --dylib_heap_explicit_huge_pages is set) to\n"
+          "reduce TLB misses. 0 disables huge page backing.");
+IREE_FLAG(bool, dylib_heap_explicit_huge_pages, false,
+          "Maps huge pages from the reserved hugetlbfs pool instead of using\n"
+          "transparent huge pages when possible.");
+IREE_FLAG(bool, dylib_heap_large_page_prefault, false,
+          "Faults in huge page backed buffers when allocated instead of on\n"
+          "first use.");
+
 static iree_status_t iree_hal_dylib_driver_factory_enumerate(
     void* self, const iree_hal_driver_info_t** out_driver_infos,
     iree_host_size_t* out_driver_info_count) {
@@ -71,26 +86,53 @@ static iree_status_t iree_hal_dylib_driver_factory_try_create(
         &loaders[loader_count++]);
   }
 
-  iree_task_executor_t* executor = NULL;
+  // One executor per NUMA node (if enabled by flags); more than a handful of
+  // nodes in a single process is rare and any beyond this go unused.
+  iree_task_executor_t* executors[8] = {NULL};
+  iree_host_size_t executor_count = 0;
   if (iree_status_is_ok(status)) {
-    status = iree_task_executor_create_from_flags(host_allocator, &executor);
+    status = iree_task_executors_create_from_flags(
+        host_allocator, IREE_ARRAYSIZE(executors), executors, &executor_count);
   }
 
   iree_hal_allocator_t* device_allocator = NULL;
   if (iree_status_is_ok(status)) {
-    status = iree_hal_allocator_create_heap(iree_make_cstring_view("cpu"),
-                                            host_allocator, host_allocator,
-                                            &device_allocator);
+    iree_hal_heap_allocator_params_t allocator_params;
+    iree_hal_heap_allocator_params_initialize(&allocator_params);
+    allocator_params.cache_capacity =
+        (iree_device_size_t)iree_max(0, FLAG_dylib_heap_cache_capacity);
+    allocator_params.large_page_threshold =
+        (iree_device_size_t)iree_max(0, FLAG_dylib_heap_large_page_threshold);
+    if (FLAG_dylib_heap_explicit_huge_pages) {
+      allocator_params.large_page_flags |=
+          IREE_HAL_HEAP_LARGE_PAGE_FLAG_EXPLICIT;
+    }
+    if (FLAG_dylib_heap_large_page_prefault) {
+      allocator_params.large_page_flags |=
+          IREE_HAL_HEAP_LARGE_PAGE_FLAG_PREFAULT;
+    }
+    // The allocator is shared by all executors so it can only prefer a node
+    // when there is just one.
+    if (executor_count == 1) {
+      allocator_params.large_page_numa_node =
+          iree_task_executor_numa_node(executors[0]);
+    }
+    status = iree_hal_allocator_create_heap_with_params(
+        iree_make_cstring_view("cpu"), &allocator_params, host_allocator,
+        host_allocator, &device_allocator);
   }
 
   if (iree_status_is_ok(status)) {
     status = iree_hal_task_driver_create(
-        iree_make_cstring_view("cpu"), &default_params, executor, loader_count,
-        loaders, device_allocator, host_allocator, out_driver);
+        iree_make_cstring_view("cpu"), &default_params, executor_count,
+        executors, loader_count, loaders, device_allocator, host_allocator,
+        out_driver);
   }
 
   iree_hal_allocator_release(device_allocator);
-  iree_task_executor_release(executor);
+  for (iree_host_size_t i = 0; i < executor_count; ++i) {
+    iree_task_executor_release(executors[i]);
+  }
   for (iree_host_size_t i = 0; i < loader_count; ++i) {
     iree_hal_executable_loader_release(loaders[i]);
   }
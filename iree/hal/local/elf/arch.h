@@ -44,6 +44,15 @@ iree_status_t iree_elf_arch_apply_relocations(
 // TODO(benvanik): add thunk functions (iree_elf_thunk_*) to be used by imports
 // for marshaling from linux ABI in the ELF to host ABI.
 
+// Set to 1 when the host uses the same calling convention as the ELF. When set
+// the iree_elf_call_* and iree_elf_thunk_* functions are plain calls and ELF
+// code may directly call host functions (and the other way around).
+#if defined(IREE_PLATFORM_WINDOWS)
+#define IREE_ELF_HOST_CALLING_CONVENTION_MATCHES 0
+#else
+#define IREE_ELF_HOST_CALLING_CONVENTION_MATCHES 1
+#endif  // IREE_PLATFORM_WINDOWS
+
 // Host -> ELF: void(*)(void)
 void iree_elf_call_v_v(const void* symbol_ptr);
 
@@ -68,9 +68,11 @@ static iree_status_t run_test() {
     const iree_hal_executable_library_header_t** header;
     const iree_hal_executable_library_v0_t* v0;
   } library;
+  // The checked-in test files are built with
+  // IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0.
   library.header =
       (const iree_hal_executable_library_header_t**)iree_elf_call_p_ip(
-          query_fn_ptr, IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION,
+          query_fn_ptr, IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0,
           /*reserved=*/NULL);
   if (library.header == NULL) {
     return iree_make_status(IREE_STATUS_NOT_FOUND, "library header is empty");
@@ -80,6 +80,10 @@ typedef enum iree_hal_executable_library_version_e {
   // iree_hal_executable_library_v0_t is used as the API communication
   // structure.
   IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0 = 0,
+  // iree_hal_executable_library_v0_t is used as the API communication
+  // structure and iree_hal_executable_dispatch_state_v0_t::import_thunk may be
+  // NULL to indicate that imports must be called directly.
+  IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0_1 = 1,
 
   IREE_HAL_EXECUTABLE_LIBRARY_VERSION_MAX_ENUM = INT32_MAX,
 } iree_hal_executable_library_version_t;
@@ -88,7 +92,7 @@ static_assert(sizeof(iree_hal_executable_library_version_t) == 4, "uint32_t");
 // The latest version of the library API; can be used to populate the
 // iree_hal_executable_library_header_t::version when building libraries.
 #define IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION \
-  IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0
+  IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0_1
 
 // A header present at the top of all versions of the library API used by the
 // runtime to ensure version compatibility.
@@ -113,6 +117,11 @@ typedef struct iree_hal_executable_library_header_t {
 // The provided |max_version| is the maximum version the caller supports;
 // callees must return NULL if their lowest available version is greater
 // than the max version supported by the caller.
+//
+// NOTE: libraries produced prior to IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0_1
+// only return their header when |max_version| is exactly
+// IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0. Runtimes that wish to load them must
+// query again with that version if the query for their latest version fails.
 typedef const iree_hal_executable_library_header_t** (
     *iree_hal_executable_library_query_fn_t)(
     iree_hal_executable_library_version_t max_version, void* reserved);
@@ -147,6 +156,16 @@ typedef int (*iree_hal_executable_import_v0_t)(void* import_params);
 // All imports must be called through this function by passing the import
 // function pointer as the first argument followed by the arguments of the
 // import function itself.
+//
+// Since IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0_1 the runtime may omit the thunk
+// when the imported functions use the same calling convention as the
+// executable. Libraries declaring that version must then call the import
+// directly:
+//   int ret = dispatch_state->import_thunk
+//                 ? dispatch_state->import_thunk(fn_ptr, import_params)
+//                 : fn_ptr(import_params);
+// The runtime will always provide the thunk to libraries declaring an older
+// version.
 typedef int (*iree_hal_executable_import_thunk_v0_t)(
     iree_hal_executable_import_v0_t fn_ptr, void* import_params);
 
@@ -227,7 +246,9 @@ typedef struct iree_hal_executable_dispatch_state_v0_t {
   // The length of each binding in bytes, 1:1 with |binding_ptrs|.
   const size_t* binding_lengths;
 
-  // Thunk function for calling imports. All calls must be made through this.
+  // Thunk function for calling imports. All calls must be made through this
+  // unless it is NULL, in which case imports must be called directly (only for
+  // libraries of IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0_1 and later).
   iree_hal_executable_import_thunk_v0_t import_thunk;
   // Optional imported functions available for use within the executable.
   // Contains one entry per imported function. If an import was marked as weak
@@ -312,7 +333,8 @@ typedef struct iree_hal_executable_export_table_v0_t {
 // available.
 typedef struct iree_hal_executable_library_v0_t {
   // Version/metadata header.
-  // Will have a version of IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0.
+  // Will have a version of IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0 or
+  // IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0_1.
   const iree_hal_executable_library_header_t* header;
 
   // Table of imported functions available to functions in the executable.
@@ -13,6 +13,7 @@
 #include "iree/base/internal/flags.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
+#include "iree/hal/local/elf/arch.h"
 #include "iree/hal/local/executable_library.h"
 #include "iree/hal/local/executable_loader.h"
 #include "iree/hal/local/local_descriptor_set_layout.h"
@@ -300,8 +301,8 @@ static iree_status_t iree_hal_executable_library_run(
       .binding_count = dispatch_params.binding_count,
       .binding_ptrs = binding_ptrs,
       .binding_lengths = binding_lengths,
-      .import_thunk = NULL,  // not yet implemented
-      .imports = NULL,       // not yet implemented
+      .import_thunk = local_executable->import_thunk,
+      .imports = local_executable->imports,
   };
 
   // Execute benchmark the workgroup invocation.
@@ -339,6 +340,79 @@ static iree_status_t iree_hal_executable_library_run(
   return iree_ok_status();
 }
 
+//===----------------------------------------------------------------------===//
+// Import call overhead
+//===----------------------------------------------------------------------===//
+
+// Number of import calls made per benchmark iteration.
+#define IREE_HAL_IMPORT_CALL_BATCH_SIZE 1024
+
+// A trivial import standing in for a runtime-provided function.
+IREE_ATTRIBUTE_NOINLINE static int iree_hal_executable_library_benchmark_import(
+    void* import_params) {
+  ++*(int64_t*)import_params;
+  return 0;
+}
+
+// Calls the first import the same way generated code does: through the thunk
+// when one is provided and otherwise directly.
+IREE_ATTRIBUTE_NOINLINE static int iree_hal_executable_library_call_imports(
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    int64_t* counter) {
+  for (int i = 0; i < IREE_HAL_IMPORT_CALL_BATCH_SIZE; ++i) {
+    iree_hal_executable_import_v0_t import = dispatch_state->imports[0];
+    int ret = dispatch_state->import_thunk
+                  ? dispatch_state->import_thunk(import, counter)
+                  : import(counter);
+    if (ret != 0) return ret;
+  }
+  return 0;
+}
+
+static iree_status_t iree_hal_executable_library_run_import_calls(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  const iree_hal_executable_import_v0_t imports[1] = {
+      (iree_hal_executable_import_v0_t)
+          iree_hal_executable_library_benchmark_import,
+  };
+  iree_hal_executable_dispatch_state_v0_t dispatch_state;
+  memset(&dispatch_state, 0, sizeof(dispatch_state));
+  dispatch_state.import_thunk =
+      (iree_hal_executable_import_thunk_v0_t)benchmark_def->user_data;
+  dispatch_state.imports = imports;
+
+  // Hide the dispatch state from the optimizer so that the calls are not
+  // specialized for the thunk/import being benchmarked.
+  const iree_hal_executable_dispatch_state_v0_t* volatile dispatch_state_ptr =
+      &dispatch_state;
+
+  int64_t counter = 0;
+  while (iree_benchmark_keep_running(benchmark_state,
+                                     IREE_HAL_IMPORT_CALL_BATCH_SIZE)) {
+    if (iree_hal_executable_library_call_imports(dispatch_state_ptr,
+                                                 &counter) != 0) {
+      return iree_make_status(IREE_STATUS_INTERNAL, "import call failed");
+    }
+  }
+  iree_benchmark_set_items_processed(benchmark_state, counter);
+  return iree_ok_status();
+}
+
+static void iree_hal_executable_library_register_import_call_benchmark(
+    const char* name, iree_hal_executable_import_thunk_v0_t import_thunk) {
+  iree_benchmark_def_t benchmark_def = {
+      .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+               IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+      .time_unit = IREE_BENCHMARK_UNIT_NANOSECOND,
+      .minimum_duration_ns = 0,
+      .iteration_count = 0,
+      .run = iree_hal_executable_library_run_import_calls,
+      .user_data = (void*)import_thunk,
+  };
+  iree_benchmark_register(iree_make_cstring_view(name), &benchmark_def);
+}
+
 int main(int argc, char** argv) {
   iree_flags_set_usage(
       "executable_library_benchmark",
@@ -384,6 +458,15 @@ int main(int argc, char** argv) {
   };
   iree_benchmark_register(iree_make_cstring_view("dispatch"), &benchmark_def);
 
+  // Measures the per-call overhead of imports made through the ELF thunk as
+  // with VERSION_0 libraries against the direct calls VERSION_0_1 libraries
+  // make when the runtime ABI matches.
+  iree_hal_executable_library_register_import_call_benchmark(
+      "import_call_thunk",
+      (iree_hal_executable_import_thunk_v0_t)iree_elf_thunk_i_p);
+  iree_hal_executable_library_register_import_call_benchmark(
+      "import_call_direct", NULL);
+
   iree_benchmark_run_specified();
   return 0;
 }
@@ -106,7 +106,7 @@ static const iree_hal_executable_library_v0_t library = {
 // architecture-specific version.
 const iree_hal_executable_library_header_t** demo_executable_library_query(
     iree_hal_executable_library_version_t max_version, void* reserved) {
-  return max_version <= 0
+  return max_version >= IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION
              ? (const iree_hal_executable_library_header_t**)&library
              : NULL;
 }
@@ -49,11 +49,19 @@ static iree_status_t iree_hal_elf_executable_query_library(
       &executable->module, IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME,
       (void**)&query_fn));
 
-  // Query for a compatible version of the library.
+  // Query for a compatible version of the library. Libraries built prior to
+  // IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0_1 only respond to exactly
+  // IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0.
   executable->library.header =
       (const iree_hal_executable_library_header_t**)iree_elf_call_p_ip(
           query_fn, IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION,
           /*reserved=*/NULL);
+  if (!executable->library.header) {
+    executable->library.header =
+        (const iree_hal_executable_library_header_t**)iree_elf_call_p_ip(
+            query_fn, IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0,
+            /*reserved=*/NULL);
+  }
   if (!executable->library.header) {
     return iree_make_status(
         IREE_STATUS_FAILED_PRECONDITION,
@@ -96,10 +104,16 @@ static iree_status_t iree_hal_elf_executable_resolve_imports(
   if (!import_table->count) return iree_ok_status();
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  // All calls from the loaded ELF route through our thunk function so that we
-  // can adapt to ABI differences.
+  // Calls from the loaded ELF route through our thunk function so that we can
+  // adapt to ABI differences. Libraries that support calling imports directly
+  // skip the thunk when the host calling convention matches the ELF.
+  const bool direct_calls =
+      IREE_ELF_HOST_CALLING_CONVENTION_MATCHES &&
+      (*executable->library.header)->version >=
+          IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0_1;
   executable->base.import_thunk =
-      (iree_hal_executable_import_thunk_v0_t)iree_elf_thunk_i_p;
+      direct_calls ? NULL
+                   : (iree_hal_executable_import_thunk_v0_t)iree_elf_thunk_i_p;
 
   // Allocate storage for the imports.
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
@@ -145,9 +145,15 @@ static iree_status_t iree_hal_system_executable_query_library(
       executable->handle, IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME,
       (void**)&query_fn));
 
-  // Query for a compatible version of the library.
+  // Query for a compatible version of the library. Libraries built prior to
+  // IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0_1 only respond to exactly
+  // IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0.
   executable->library.header =
       query_fn(IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION, /*reserved=*/NULL);
+  if (!executable->library.header) {
+    executable->library.header =
+        query_fn(IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0, /*reserved=*/NULL);
+  }
   if (!executable->library.header) {
     return iree_make_status(
         IREE_STATUS_FAILED_PRECONDITION,
@@ -208,8 +214,13 @@ static iree_status_t iree_hal_system_executable_resolve_imports(
   if (!import_table->count) return iree_ok_status();
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  // Pass all imports right through.
-  executable->base.import_thunk = iree_hal_system_executable_import_thunk_v0;
+  // Pass all imports right through. System libraries use the host calling
+  // convention and those that support it call imports directly.
+  executable->base.import_thunk =
+      (*executable->library.header)->version >=
+              IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0_1
+          ? NULL
+          : iree_hal_system_executable_import_thunk_v0;
 
   // Allocate storage for the imports.
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
@@ -36,6 +36,14 @@ iree_status_t iree_hal_local_descriptor_set_layout_create(
         IREE_STATUS_INVALID_ARGUMENT, "binding count %zu over the limit of %d",
         binding_count, IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT);
   }
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    if (bindings[i].binding >= IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "binding ordinal %u over the limit of %d",
+                              bindings[i].binding,
+                              IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT);
+    }
+  }
 
   IREE_TRACE_ZONE_BEGIN(z0);
 
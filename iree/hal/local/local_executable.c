@@ -7,6 +7,7 @@
 #include "iree/hal/local/local_executable.h"
 
 #include "iree/base/tracing.h"
+#include "iree/hal/local/local_executable_registry.h"
 
 void iree_hal_local_executable_initialize(
     const iree_hal_local_executable_vtable_t* vtable,
@@ -32,10 +33,17 @@ void iree_hal_local_executable_initialize(
   // Imports will be provided by the parent type, if needed.
   out_base_executable->import_thunk = NULL;
   out_base_executable->imports = NULL;
+
+  // Registration happens after loading, if at all.
+  out_base_executable->registry = NULL;
 }
 
 void iree_hal_local_executable_deinitialize(
     iree_hal_local_executable_t* base_executable) {
+  if (base_executable->registry) {
+    iree_hal_local_executable_registry_remove(base_executable->registry,
+                                              base_executable);
+  }
   for (iree_host_size_t i = 0; i < base_executable->executable_layout_count;
        ++i) {
     iree_hal_executable_layout_release(
@@ -10,6 +10,7 @@
 #include <stddef.h>
 
 #include "iree/base/tracing.h"
+#include "iree/hal/local/local_executable_registry.h"
 
 typedef struct iree_hal_local_executable_cache_t {
   iree_hal_resource_t resource;
@@ -110,8 +111,10 @@ static iree_status_t iree_hal_local_executable_cache_prepare_executable(
     }
     // The loader _may_ handle the executable; if the specific executable is not
     // supported then the try will fail with IREE_STATUS_CANCELLED and we should
-    // continue trying other loaders.
-    iree_status_t status = iree_hal_executable_loader_try_load(
+    // continue trying other loaders. Identical executables loaded by the same
+    // loader are shared process-wide through the registry.
+    iree_status_t status = iree_hal_local_executable_registry_load(
+        iree_hal_local_executable_registry_default(),
         executable_cache->loaders[i], executable_spec, out_executable);
     if (iree_status_is_ok(status)) {
       // Executable was successfully loaded.
@@ -18,11 +18,11 @@ extern "C" {
 // TODO(benvanik): when we refactor executable caches this can become something
 // more specialized; like nop_executable_cache (does nothing but pass through)
 // or inproc_lru_executable_cache (simple in-memory LRU of recent executables).
-//
-// We can also set this up so they share storage. Ideally a JIT'ed executable in
-// one device is the same JIT'ed executable in another, and in multi-tenant
-// situations we're likely to want that isolation _and_ sharing.
 
+// Creates an executable cache that loads executables with |loaders|.
+// Executables are shared through the process-wide
+// iree_hal_local_executable_registry_t such that identical executables
+// prepared by any cache using the same loader are only loaded once.
 iree_status_t iree_hal_local_executable_cache_create(
     iree_string_view_t identifier, iree_host_size_t loader_count,
     iree_hal_executable_loader_t** loaders, iree_allocator_t host_allocator,
@@ -57,6 +57,7 @@ iree_status_t iree_hal_local_executable_layout_create(
     layout->push_constants = push_constants;
     layout->dynamic_binding_count = 0;
     layout->used_bindings = 0;
+    layout->read_only_bindings = 0;
     layout->set_layout_count = set_layout_count;
     for (iree_host_size_t i = 0; i < set_layout_count; ++i) {
       layout->set_layouts[i] = set_layouts[i];
@@ -67,11 +68,19 @@ iree_status_t iree_hal_local_executable_layout_create(
       for (iree_host_size_t j = 0; j < local_set_layout->binding_count; ++j) {
         const iree_hal_descriptor_set_layout_binding_t* binding =
             &local_set_layout->bindings[j];
-        layout->used_bindings |=
-            1ull << (i * IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT + j);
+        iree_hal_local_binding_mask_t binding_bit =
+            1ull << (i * IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT +
+                     binding->binding);
+        layout->used_bindings |= binding_bit;
         switch (binding->type) {
-          case IREE_HAL_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+          case IREE_HAL_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+            layout->read_only_bindings |= binding_bit;
+            break;
           case IREE_HAL_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+            layout->read_only_bindings |= binding_bit;
+            ++layout->dynamic_binding_count;
+            break;
+          case IREE_HAL_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
             ++layout->dynamic_binding_count;
             break;
           default:
@@ -30,6 +30,8 @@ typedef struct iree_hal_local_executable_layout_t {
   iree_host_size_t push_constants;
   iree_host_size_t dynamic_binding_count;
   iree_hal_local_binding_mask_t used_bindings;
+  // Subset of |used_bindings| that are only ever read (uniform buffers).
+  iree_hal_local_binding_mask_t read_only_bindings;
   iree_host_size_t set_layout_count;
   iree_hal_descriptor_set_layout_t* set_layouts[];
 } iree_hal_local_executable_layout_t;
@@ -0,0 +1,77 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/local_executable_layout.h"
+
+#include "iree/hal/local/local_descriptor_set_layout.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+static iree_hal_descriptor_set_layout_t* CreateSetLayout(
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_layout_binding_t* bindings) {
+  iree_hal_descriptor_set_layout_t* set_layout = NULL;
+  IREE_CHECK_OK(iree_hal_local_descriptor_set_layout_create(
+      IREE_HAL_DESCRIPTOR_SET_LAYOUT_USAGE_TYPE_PUSH_ONLY, binding_count,
+      bindings, iree_allocator_system(), &set_layout));
+  return set_layout;
+}
+
+// Tests that binding masks are indexed by binding number and not by the
+// position of the binding in the set layout.
+TEST(LocalExecutableLayoutTest, NonContiguousBindings) {
+  const iree_hal_descriptor_set_layout_binding_t set0_bindings[] = {
+      {/*binding=*/0, IREE_HAL_DESCRIPTOR_TYPE_STORAGE_BUFFER},
+      {/*binding=*/2, IREE_HAL_DESCRIPTOR_TYPE_UNIFORM_BUFFER},
+      {/*binding=*/5, IREE_HAL_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC},
+  };
+  const iree_hal_descriptor_set_layout_binding_t set1_bindings[] = {
+      {/*binding=*/3, IREE_HAL_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC},
+  };
+  iree_hal_descriptor_set_layout_t* set_layouts[2] = {
+      CreateSetLayout(IREE_ARRAYSIZE(set0_bindings), set0_bindings),
+      CreateSetLayout(IREE_ARRAYSIZE(set1_bindings), set1_bindings),
+  };
+
+  iree_hal_executable_layout_t* executable_layout = NULL;
+  IREE_ASSERT_OK(iree_hal_local_executable_layout_create(
+      /*push_constants=*/0, IREE_ARRAYSIZE(set_layouts), set_layouts,
+      iree_allocator_system(), &executable_layout));
+  iree_hal_local_executable_layout_t* local_layout =
+      iree_hal_local_executable_layout_cast(executable_layout);
+
+  const iree_hal_local_binding_mask_t set1_base =
+      IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT;
+  EXPECT_EQ((1ull << 0) | (1ull << 2) | (1ull << 5) | (1ull << (set1_base + 3)),
+            local_layout->used_bindings);
+  EXPECT_EQ((1ull << 2) | (1ull << (set1_base + 3)),
+            local_layout->read_only_bindings);
+  EXPECT_EQ(2, local_layout->dynamic_binding_count);
+
+  iree_hal_executable_layout_release(executable_layout);
+  iree_hal_descriptor_set_layout_release(set_layouts[0]);
+  iree_hal_descriptor_set_layout_release(set_layouts[1]);
+}
+
+// Tests that binding numbers that can't be represented in the masks are
+// rejected.
+TEST(LocalExecutableLayoutTest, BindingOrdinalOutOfRange) {
+  const iree_hal_descriptor_set_layout_binding_t bindings[] = {
+      {/*binding=*/IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT,
+       IREE_HAL_DESCRIPTOR_TYPE_STORAGE_BUFFER},
+  };
+  iree_hal_descriptor_set_layout_t* set_layout = NULL;
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_INVALID_ARGUMENT,
+                        iree_hal_local_descriptor_set_layout_create(
+                            IREE_HAL_DESCRIPTOR_SET_LAYOUT_USAGE_TYPE_PUSH_ONLY,
+                            IREE_ARRAYSIZE(bindings), bindings,
+                            iree_allocator_system(), &set_layout));
+  EXPECT_EQ(NULL, set_layout);
+}
+
+}  // namespace
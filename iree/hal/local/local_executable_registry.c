@@ -0,0 +1,369 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/local_executable_registry.h"
+
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/call_once.h"
+#include "iree/base/internal/sha256.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/local/local_descriptor_set_layout.h"
+#include "iree/hal/local/local_executable_layout.h"
+
+//===----------------------------------------------------------------------===//
+// iree_hal_local_executable_registry_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_local_executable_registry_entry_t {
+  struct iree_hal_local_executable_registry_entry_t* next;
+
+  // Key used to match requests.
+  iree_hal_executable_loader_t* loader;
+  iree_hal_executable_caching_mode_t caching_mode;
+  iree_string_view_t executable_format;
+  // Length and SHA-256 digest of the executable data. Contents with the same
+  // length and digest are treated as identical.
+  iree_host_size_t data_length;
+  iree_sha256_digest_t digest;
+
+  // Copy of the executable data stored in the trailing storage of the entry
+  // when loaded with IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA and
+  // empty otherwise. Aliasing executables are loaded from this copy instead of
+  // the data of the first caller, which other callers sharing the executable
+  // may outlive. Other executables do not reference their data once loaded.
+  iree_const_byte_span_t executable_data;
+
+  // Weak reference to the executable; it removes itself from the registry
+  // upon destruction.
+  iree_hal_local_executable_t* executable;
+} iree_hal_local_executable_registry_entry_t;
+
+struct iree_hal_local_executable_registry_t {
+  iree_allocator_t host_allocator;
+  iree_slim_mutex_t mutex;
+  // Unordered list of entries. Processes rarely have more than a few hundred
+  // executables live and a lookup is trivial compared to a load.
+  iree_hal_local_executable_registry_entry_t* entry_head
+      IREE_GUARDED_BY(mutex);
+  iree_host_size_t entry_count IREE_GUARDED_BY(mutex);
+};
+
+static iree_hal_local_executable_registry_t
+    iree_hal_local_executable_registry_default_;
+static iree_once_flag iree_hal_local_executable_registry_default_flag_ =
+    IREE_ONCE_FLAG_INIT;
+static void iree_hal_local_executable_registry_default_initialize(void) {
+  memset(&iree_hal_local_executable_registry_default_, 0,
+         sizeof(iree_hal_local_executable_registry_default_));
+  iree_hal_local_executable_registry_default_.host_allocator =
+      iree_allocator_system();
+  iree_slim_mutex_initialize(
+      &iree_hal_local_executable_registry_default_.mutex);
+}
+
+iree_hal_local_executable_registry_t*
+iree_hal_local_executable_registry_default(void) {
+  iree_call_once(&iree_hal_local_executable_registry_default_flag_,
+                 iree_hal_local_executable_registry_default_initialize);
+  return &iree_hal_local_executable_registry_default_;
+}
+
+iree_status_t iree_hal_local_executable_registry_allocate(
+    iree_allocator_t host_allocator,
+    iree_hal_local_executable_registry_t** out_registry) {
+  IREE_ASSERT_ARGUMENT(out_registry);
+  *out_registry = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_local_executable_registry_t* registry = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*registry),
+                                (void**)&registry));
+  registry->host_allocator = host_allocator;
+  iree_slim_mutex_initialize(&registry->mutex);
+
+  *out_registry = registry;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+void iree_hal_local_executable_registry_free(
+    iree_hal_local_executable_registry_t* registry) {
+  if (!registry) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_ASSERT(!registry->entry_head,
+              "executables must be released before freeing their registry");
+  iree_slim_mutex_deinitialize(&registry->mutex);
+  iree_allocator_free(registry->host_allocator, registry);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+iree_host_size_t iree_hal_local_executable_registry_count(
+    iree_hal_local_executable_registry_t* registry) {
+  iree_slim_mutex_lock(&registry->mutex);
+  iree_host_size_t count = registry->entry_count;
+  iree_slim_mutex_unlock(&registry->mutex);
+  return count;
+}
+
+// Retains |executable| unless its last reference has already been released
+// and it is being destroyed. Must be called with the registry mutex held so
+// that the executable memory is not freed while we inspect it.
+static bool iree_hal_local_executable_registry_try_retain(
+    iree_hal_local_executable_t* executable) {
+  iree_atomic_ref_count_t* ref_count = &executable->resource.ref_count;
+  int32_t value = iree_atomic_load_int32(ref_count, iree_memory_order_relaxed);
+  while (value > 0) {
+    if (iree_atomic_compare_exchange_weak_int32(ref_count, &value, value + 1,
+                                                iree_memory_order_acquire,
+                                                iree_memory_order_relaxed)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool iree_hal_local_executable_registry_entry_matches(
+    const iree_hal_local_executable_registry_entry_t* entry,
+    iree_hal_executable_loader_t* loader,
+    const iree_hal_executable_spec_t* executable_spec,
+    const iree_sha256_digest_t* digest) {
+  return entry->loader == loader &&
+         entry->caching_mode == executable_spec->caching_mode &&
+         entry->data_length == executable_spec->executable_data.data_length &&
+         iree_sha256_digest_equal(&entry->digest, digest) &&
+         iree_string_view_equal(entry->executable_format,
+                                executable_spec->executable_format);
+}
+
+// Returns true if descriptor set layouts |a| and |b| have the same bindings.
+static bool iree_hal_local_executable_registry_set_layouts_equal(
+    iree_hal_descriptor_set_layout_t* base_a,
+    iree_hal_descriptor_set_layout_t* base_b) {
+  if (base_a == base_b) return true;
+  const iree_hal_local_descriptor_set_layout_t* a =
+      iree_hal_local_descriptor_set_layout_cast(base_a);
+  const iree_hal_local_descriptor_set_layout_t* b =
+      iree_hal_local_descriptor_set_layout_cast(base_b);
+  if (a->usage_type != b->usage_type || a->binding_count != b->binding_count) {
+    return false;
+  }
+  for (iree_host_size_t i = 0; i < a->binding_count; ++i) {
+    if (a->bindings[i].binding != b->bindings[i].binding ||
+        a->bindings[i].type != b->bindings[i].type) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns true if the executable layouts in |executable_spec| are
+// interchangeable with those the registered |executable| was loaded with.
+static bool iree_hal_local_executable_registry_layouts_compatible(
+    const iree_hal_local_executable_t* executable,
+    const iree_hal_executable_spec_t* executable_spec) {
+  if (executable->executable_layout_count !=
+      executable_spec->executable_layout_count) {
+    return false;
+  }
+  for (iree_host_size_t i = 0; i < executable->executable_layout_count; ++i) {
+    const iree_hal_local_executable_layout_t* a =
+        executable->executable_layouts[i];
+    const iree_hal_local_executable_layout_t* b =
+        (const iree_hal_local_executable_layout_t*)
+            executable_spec->executable_layouts[i];
+    if (a == b) continue;
+    if (a->push_constants != b->push_constants ||
+        a->dynamic_binding_count != b->dynamic_binding_count ||
+        a->used_bindings != b->used_bindings ||
+        a->read_only_bindings != b->read_only_bindings ||
+        a->set_layout_count != b->set_layout_count) {
+      return false;
+    }
+    for (iree_host_size_t j = 0; j < a->set_layout_count; ++j) {
+      if (!iree_hal_local_executable_registry_set_layouts_equal(
+              a->set_layouts[j], b->set_layouts[j])) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Finds a live executable matching the request with compatible layouts and
+// retains it for the caller. Returns NULL if there is none.
+// Must be called with the registry mutex held.
+static iree_hal_local_executable_t* iree_hal_local_executable_registry_find(
+    iree_hal_local_executable_registry_t* registry,
+    iree_hal_executable_loader_t* loader,
+    const iree_hal_executable_spec_t* executable_spec,
+    const iree_sha256_digest_t* digest) {
+  for (iree_hal_local_executable_registry_entry_t* entry =
+           registry->entry_head;
+       entry != NULL; entry = entry->next) {
+    if (!iree_hal_local_executable_registry_entry_matches(
+            entry, loader, executable_spec, digest) ||
+        !iree_hal_local_executable_registry_layouts_compatible(
+            entry->executable, executable_spec)) {
+      continue;
+    }
+    // The executable may be dying; if so treat it as if it were not present.
+    // Its entry will be removed as part of destruction.
+    if (!iree_hal_local_executable_registry_try_retain(entry->executable)) {
+      continue;
+    }
+    return entry->executable;
+  }
+  return NULL;
+}
+
+// Allocates an unregistered entry for |executable_spec|. The executable data
+// is only copied into the entry if the executable will alias it. The entry must
+// be registered with iree_hal_local_executable_registry_insert or freed by the
+// caller.
+static iree_status_t iree_hal_local_executable_registry_entry_allocate(
+    iree_hal_local_executable_registry_t* registry,
+    iree_hal_executable_loader_t* loader,
+    const iree_hal_executable_spec_t* executable_spec,
+    const iree_sha256_digest_t* digest,
+    iree_hal_local_executable_registry_entry_t** out_entry) {
+  const iree_host_size_t data_length =
+      executable_spec->executable_data.data_length;
+  const iree_host_size_t copy_size =
+      iree_all_bits_set(executable_spec->caching_mode,
+                        IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA)
+          ? data_length
+          : 0;
+  iree_hal_local_executable_registry_entry_t* entry = NULL;
+  iree_host_size_t total_size = sizeof(*entry) +
+                                executable_spec->executable_format.size +
+                                copy_size;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(registry->host_allocator,
+                                             total_size, (void**)&entry));
+  uint8_t* ptr = (uint8_t*)entry + sizeof(*entry);
+  entry->loader = loader;
+  entry->caching_mode = executable_spec->caching_mode;
+  iree_string_view_append_to_buffer(executable_spec->executable_format,
+                                    &entry->executable_format, (char*)ptr);
+  ptr += executable_spec->executable_format.size;
+  entry->data_length = data_length;
+  entry->digest = *digest;
+  if (copy_size) {
+    memcpy(ptr, executable_spec->executable_data.data, copy_size);
+    entry->executable_data = iree_make_const_byte_span(ptr, copy_size);
+  } else {
+    entry->executable_data = iree_const_byte_span_empty();
+  }
+  *out_entry = entry;
+  return iree_ok_status();
+}
+
+// Registers |entry| for the |executable| that was loaded from it.
+// The entry is freed when the executable is destroyed.
+// Must be called with the registry mutex held.
+static void iree_hal_local_executable_registry_insert(
+    iree_hal_local_executable_registry_t* registry,
+    iree_hal_local_executable_registry_entry_t* entry,
+    iree_hal_local_executable_t* executable) {
+  entry->executable = executable;
+  executable->registry = registry;
+  entry->next = registry->entry_head;
+  registry->entry_head = entry;
+  ++registry->entry_count;
+}
+
+iree_status_t iree_hal_local_executable_registry_load(
+    iree_hal_local_executable_registry_t* registry,
+    iree_hal_executable_loader_t* loader,
+    const iree_hal_executable_spec_t* executable_spec,
+    iree_hal_executable_t** out_executable) {
+  IREE_ASSERT_ARGUMENT(registry);
+  IREE_ASSERT_ARGUMENT(loader);
+  IREE_ASSERT_ARGUMENT(executable_spec);
+  IREE_ASSERT_ARGUMENT(out_executable);
+  *out_executable = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_sha256_digest_t digest;
+  iree_sha256(executable_spec->executable_data, &digest);
+
+  iree_slim_mutex_lock(&registry->mutex);
+  iree_hal_local_executable_t* executable =
+      iree_hal_local_executable_registry_find(registry, loader,
+                                              executable_spec, &digest);
+  iree_slim_mutex_unlock(&registry->mutex);
+  if (executable) {
+    IREE_TRACE_ZONE_APPEND_TEXT(z0, "shared");
+    *out_executable = (iree_hal_executable_t*)executable;
+    IREE_TRACE_ZONE_END(z0);
+    return iree_ok_status();
+  }
+
+  // Load outside of the lock as loading may take a while. Concurrent requests
+  // for the same executable may both load it and the loser will use the
+  // winner's executable.
+  //
+  // Executables aliasing their data are loaded from the copy owned by the
+  // entry so that they remain valid for all callers sharing them.
+  iree_hal_local_executable_registry_entry_t* entry = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_local_executable_registry_entry_allocate(
+              registry, loader, executable_spec, &digest, &entry));
+  iree_hal_executable_spec_t entry_spec = *executable_spec;
+  if (!iree_const_byte_span_is_empty(entry->executable_data)) {
+    entry_spec.executable_data = entry->executable_data;
+  }
+  iree_hal_executable_t* loaded_executable = NULL;
+  iree_status_t status = iree_hal_executable_loader_try_load(
+      loader, &entry_spec, &loaded_executable);
+  if (!iree_status_is_ok(status)) {
+    iree_allocator_free(registry->host_allocator, entry);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  iree_slim_mutex_lock(&registry->mutex);
+  executable = iree_hal_local_executable_registry_find(
+      registry, loader, executable_spec, &digest);
+  if (!executable) {
+    iree_hal_local_executable_registry_insert(
+        registry, entry, iree_hal_local_executable_cast(loaded_executable));
+  }
+  iree_slim_mutex_unlock(&registry->mutex);
+  if (executable) {
+    // The unregistered executable is destroyed here and the entry it may
+    // alias is no longer needed.
+    iree_hal_executable_release(loaded_executable);
+    iree_allocator_free(registry->host_allocator, entry);
+    *out_executable = (iree_hal_executable_t*)executable;
+  } else {
+    *out_executable = loaded_executable;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+void iree_hal_local_executable_registry_remove(
+    iree_hal_local_executable_registry_t* registry,
+    iree_hal_local_executable_t* executable) {
+  iree_slim_mutex_lock(&registry->mutex);
+  iree_hal_local_executable_registry_entry_t** entry_ptr =
+      &registry->entry_head;
+  while (*entry_ptr && (*entry_ptr)->executable != executable) {
+    entry_ptr = &(*entry_ptr)->next;
+  }
+  iree_hal_local_executable_registry_entry_t* entry = *entry_ptr;
+  if (entry) {
+    *entry_ptr = entry->next;
+    --registry->entry_count;
+  }
+  iree_slim_mutex_unlock(&registry->mutex);
+  iree_allocator_free(registry->host_allocator, entry);
+}
@@ -0,0 +1,83 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_LOCAL_LOCAL_EXECUTABLE_REGISTRY_H_
+#define IREE_HAL_LOCAL_LOCAL_EXECUTABLE_REGISTRY_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/executable_loader.h"
+#include "iree/hal/local/local_executable.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_hal_local_executable_registry_t
+//===----------------------------------------------------------------------===//
+
+// A registry of loaded executables keyed by their contents.
+// Executables prepared through the registry with the same loader, caching mode,
+// format, and executable data are loaded once and shared by all callers
+// (including across devices and contexts) along with any relocated code pages.
+// Executable data is identified by its length and SHA-256 digest.
+//
+// The registry only weakly references executables: entries are removed when
+// the last reference to an executable is released and a subsequent request
+// will load it again. Shared executables retain the executable layouts and
+// host allocator of the request that first loaded them; requests with layouts
+// that are not compatible with those of a registered executable load and
+// register their own. Executables aliasing their data (with
+// IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA) are loaded from a copy
+// of the data owned by the registry so that they don't depend on the lifetime
+// of the data provided by the caller that first loaded them; the data of other
+// executables is not retained.
+//
+// Thread-safe.
+typedef struct iree_hal_local_executable_registry_t
+    iree_hal_local_executable_registry_t;
+
+// Returns the process-wide registry used by local executable caches.
+iree_hal_local_executable_registry_t*
+iree_hal_local_executable_registry_default(void);
+
+// Allocates a new registry independent of the default registry.
+// All executables loaded through the registry must be released prior to
+// freeing it.
+iree_status_t iree_hal_local_executable_registry_allocate(
+    iree_allocator_t host_allocator,
+    iree_hal_local_executable_registry_t** out_registry);
+
+// Frees a registry allocated with iree_hal_local_executable_registry_allocate.
+void iree_hal_local_executable_registry_free(
+    iree_hal_local_executable_registry_t* registry);
+
+// Returns an executable matching |executable_spec| loaded with |loader|,
+// either a registered one or a newly loaded one that will be registered for
+// use by subsequent requests. Fails with IREE_STATUS_CANCELLED if the loader
+// does not support the executable as with iree_hal_executable_loader_try_load.
+iree_status_t iree_hal_local_executable_registry_load(
+    iree_hal_local_executable_registry_t* registry,
+    iree_hal_executable_loader_t* loader,
+    const iree_hal_executable_spec_t* executable_spec,
+    iree_hal_executable_t** out_executable);
+
+// Returns the number of executables currently registered.
+iree_host_size_t iree_hal_local_executable_registry_count(
+    iree_hal_local_executable_registry_t* registry);
+
+// Removes |executable| from |registry| as it is being destroyed.
+// Called by iree_hal_local_executable_deinitialize.
+void iree_hal_local_executable_registry_remove(
+    iree_hal_local_executable_registry_t* registry,
+    iree_hal_local_executable_t* executable);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_LOCAL_LOCAL_EXECUTABLE_REGISTRY_H_
@@ -0,0 +1,384 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/local_executable_registry.h"
+
+#include <cstring>
+#include <vector>
+
+#include "iree/hal/local/local_descriptor_set_layout.h"
+#include "iree/hal/local/local_executable_cache.h"
+#include "iree/hal/local/local_executable_layout.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+//===----------------------------------------------------------------------===//
+// Fake executable/loader
+//===----------------------------------------------------------------------===//
+
+typedef struct fake_executable_t {
+  iree_hal_local_executable_t base;
+  // Executable data the executable was loaded from, as if it aliased it.
+  iree_const_byte_span_t data;
+  iree_hal_local_executable_layout_t* layouts[];
+} fake_executable_t;
+
+static void fake_executable_destroy(iree_hal_executable_t* base_executable) {
+  fake_executable_t* executable = (fake_executable_t*)base_executable;
+  iree_allocator_t host_allocator = executable->base.host_allocator;
+  iree_hal_local_executable_deinitialize(&executable->base);
+  iree_allocator_free(host_allocator, executable);
+}
+
+static iree_status_t fake_executable_issue_call(
+    iree_hal_local_executable_t* executable, iree_host_size_t ordinal,
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    const iree_hal_vec3_t* workgroup_id, iree_byte_span_t local_memory) {
+  return iree_ok_status();
+}
+
+static const iree_hal_local_executable_vtable_t fake_executable_vtable = {
+    /*.base=*/{
+        /*.destroy=*/fake_executable_destroy,
+    },
+    /*.issue_call=*/fake_executable_issue_call,
+};
+
+typedef struct fake_loader_t {
+  iree_hal_executable_loader_t base;
+  int load_count;
+} fake_loader_t;
+
+static void fake_loader_destroy(iree_hal_executable_loader_t* base_loader) {
+  iree_allocator_free(iree_allocator_system(), base_loader);
+}
+
+static bool fake_loader_query_support(
+    iree_hal_executable_loader_t* base_loader,
+    iree_hal_executable_caching_mode_t caching_mode,
+    iree_string_view_t executable_format) {
+  return iree_string_view_equal(executable_format, IREE_SV("fake"));
+}
+
+static iree_status_t fake_loader_try_load(
+    iree_hal_executable_loader_t* base_loader,
+    const iree_hal_executable_spec_t* executable_spec,
+    iree_hal_executable_t** out_executable) {
+  fake_loader_t* loader = (fake_loader_t*)base_loader;
+  ++loader->load_count;
+  fake_executable_t* executable = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      iree_allocator_system(),
+      sizeof(*executable) + executable_spec->executable_layout_count *
+                                sizeof(*executable->layouts),
+      (void**)&executable));
+  iree_hal_local_executable_initialize(
+      &fake_executable_vtable, executable_spec->executable_layout_count,
+      executable_spec->executable_layouts, &executable->layouts[0],
+      iree_allocator_system(), &executable->base);
+  executable->data = executable_spec->executable_data;
+  *out_executable = (iree_hal_executable_t*)executable;
+  return iree_ok_status();
+}
+
+static const iree_hal_executable_loader_vtable_t fake_loader_vtable = {
+    /*.destroy=*/fake_loader_destroy,
+    /*.query_support=*/fake_loader_query_support,
+    /*.try_load=*/fake_loader_try_load,
+};
+
+//===----------------------------------------------------------------------===//
+// Tests
+//===----------------------------------------------------------------------===//
+
+class LocalExecutableRegistryTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    IREE_ASSERT_OK(iree_hal_local_executable_registry_allocate(
+        iree_allocator_system(), &registry_));
+    IREE_ASSERT_OK(iree_allocator_malloc(
+        iree_allocator_system(), sizeof(*loader_), (void**)&loader_));
+    iree_hal_executable_loader_initialize(
+        &fake_loader_vtable, iree_hal_executable_import_provider_null(),
+        &loader_->base);
+    IREE_ASSERT_OK(iree_hal_local_executable_layout_create(
+        /*push_constants=*/1, /*set_layout_count=*/0, /*set_layouts=*/NULL,
+        iree_allocator_system(), &layout_));
+  }
+
+  void TearDown() override {
+    iree_hal_executable_layout_release(layout_);
+    iree_hal_executable_loader_release(&loader_->base);
+    iree_hal_local_executable_registry_free(registry_);
+  }
+
+  iree_hal_executable_spec_t MakeSpec(const void* data,
+                                      iree_host_size_t data_length) {
+    iree_hal_executable_spec_t spec;
+    iree_hal_executable_spec_initialize(&spec);
+    spec.executable_format = IREE_SV("fake");
+    spec.executable_data =
+        iree_make_const_byte_span((const uint8_t*)data, data_length);
+    spec.executable_layout_count = 1;
+    spec.executable_layouts = &layout_;
+    return spec;
+  }
+
+  iree_hal_local_executable_registry_t* registry_ = NULL;
+  fake_loader_t* loader_ = NULL;
+  iree_hal_executable_layout_t* layout_ = NULL;
+};
+
+TEST_F(LocalExecutableRegistryTest, SharesIdenticalContents) {
+  // Different buffers with the same contents, as when two sessions each load
+  // their own copy of the same module.
+  uint8_t data_a[64];
+  uint8_t data_b[64];
+  memset(data_a, 0xAB, sizeof(data_a));
+  memset(data_b, 0xAB, sizeof(data_b));
+  iree_hal_executable_spec_t spec_a = MakeSpec(data_a, sizeof(data_a));
+  iree_hal_executable_spec_t spec_b = MakeSpec(data_b, sizeof(data_b));
+
+  iree_hal_executable_t* executable_a = NULL;
+  IREE_ASSERT_OK(iree_hal_local_executable_registry_load(
+      registry_, &loader_->base, &spec_a, &executable_a));
+  iree_hal_executable_t* executable_b = NULL;
+  IREE_ASSERT_OK(iree_hal_local_executable_registry_load(
+      registry_, &loader_->base, &spec_b, &executable_b));
+  EXPECT_EQ(executable_a, executable_b);
+  EXPECT_EQ(1, loader_->load_count);
+  EXPECT_EQ(1, iree_hal_local_executable_registry_count(registry_));
+
+  // Changing the source after loading must not affect the registered contents.
+  memset(data_a, 0xCD, sizeof(data_a));
+  iree_hal_executable_t* executable_c = NULL;
+  IREE_ASSERT_OK(iree_hal_local_executable_registry_load(
+      registry_, &loader_->base, &spec_a, &executable_c));
+  EXPECT_NE(executable_a, executable_c);
+  EXPECT_EQ(2, loader_->load_count);
+  EXPECT_EQ(2, iree_hal_local_executable_registry_count(registry_));
+
+  iree_hal_executable_release(executable_a);
+  iree_hal_executable_release(executable_b);
+  iree_hal_executable_release(executable_c);
+  EXPECT_EQ(0, iree_hal_local_executable_registry_count(registry_));
+}
+
+TEST_F(LocalExecutableRegistryTest, ReloadsAfterRelease) {
+  uint8_t data[16] = {1, 2, 3, 4};
+  iree_hal_executable_spec_t spec = MakeSpec(data, sizeof(data));
+
+  iree_hal_executable_t* executable = NULL;
+  IREE_ASSERT_OK(iree_hal_local_executable_registry_load(
+      registry_, &loader_->base, &spec, &executable));
+  iree_hal_executable_release(executable);
+  EXPECT_EQ(0, iree_hal_local_executable_registry_count(registry_));
+
+  IREE_ASSERT_OK(iree_hal_local_executable_registry_load(
+      registry_, &loader_->base, &spec, &executable));
+  EXPECT_EQ(2, loader_->load_count);
+  iree_hal_executable_release(executable);
+}
+
+TEST_F(LocalExecutableRegistryTest, IncompatibleLayoutsAreNotShared) {
+  uint8_t data[16] = {1, 2, 3, 4};
+  iree_hal_executable_spec_t spec_a = MakeSpec(data, sizeof(data));
+
+  iree_hal_executable_layout_t* other_layout = NULL;
+  IREE_ASSERT_OK(iree_hal_local_executable_layout_create(
+      /*push_constants=*/4, /*set_layout_count=*/0, /*set_layouts=*/NULL,
+      iree_allocator_system(), &other_layout));
+  iree_hal_executable_spec_t spec_b = MakeSpec(data, sizeof(data));
+  spec_b.executable_layouts = &other_layout;
+
+  iree_hal_executable_t* executable_a = NULL;
+  IREE_ASSERT_OK(iree_hal_local_executable_registry_load(
+      registry_, &loader_->base, &spec_a, &executable_a));
+  iree_hal_executable_t* executable_b = NULL;
+  IREE_ASSERT_OK(iree_hal_local_executable_registry_load(
+      registry_, &loader_->base, &spec_b, &executable_b));
+  EXPECT_NE(executable_a, executable_b);
+  EXPECT_EQ(2, loader_->load_count);
+
+  iree_hal_executable_release(executable_a);
+  iree_hal_executable_release(executable_b);
+  iree_hal_executable_layout_release(other_layout);
+}
+
+// Creates an executable layout with a single set layout of |bindings|.
+static iree_hal_executable_layout_t* CreateLayoutWithSet(
+    iree_hal_descriptor_set_layout_usage_type_t usage_type,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_layout_binding_t* bindings) {
+  iree_hal_descriptor_set_layout_t* set_layout = NULL;
+  IREE_CHECK_OK(iree_hal_local_descriptor_set_layout_create(
+      usage_type, binding_count, bindings, iree_allocator_system(),
+      &set_layout));
+  iree_hal_executable_layout_t* layout = NULL;
+  IREE_CHECK_OK(iree_hal_local_executable_layout_create(
+      /*push_constants=*/1, /*set_layout_count=*/1, &set_layout,
+      iree_allocator_system(), &layout));
+  iree_hal_descriptor_set_layout_release(set_layout);
+  return layout;
+}
+
+TEST_F(LocalExecutableRegistryTest, SetLayoutsAreCompared) {
+  uint8_t data[16] = {1, 2, 3, 4};
+  const iree_hal_descriptor_set_layout_binding_t bindings[] = {
+      {/*binding=*/0, IREE_HAL_DESCRIPTOR_TYPE_STORAGE_BUFFER},
+      {/*binding=*/1, IREE_HAL_DESCRIPTOR_TYPE_STORAGE_BUFFER},
+  };
+  // Distinct but identical layouts are compatible.
+  iree_hal_executable_layout_t* layout_a = CreateLayoutWithSet(
+      IREE_HAL_DESCRIPTOR_SET_LAYOUT_USAGE_TYPE_PUSH_ONLY,
+      IREE_ARRAYSIZE(bindings), bindings);
+  iree_hal_executable_layout_t* layout_b = CreateLayoutWithSet(
+      IREE_HAL_DESCRIPTOR_SET_LAYOUT_USAGE_TYPE_PUSH_ONLY,
+      IREE_ARRAYSIZE(bindings), bindings);
+  // Same binding masks and counts but a different set layout.
+  iree_hal_executable_layout_t* layout_c = CreateLayoutWithSet(
+      IREE_HAL_DESCRIPTOR_SET_LAYOUT_USAGE_TYPE_IMMUTABLE,
+      IREE_ARRAYSIZE(bindings), bindings);
+
+  iree_hal_executable_spec_t spec_a = MakeSpec(data, sizeof(data));
+  spec_a.executable_layouts = &layout_a;
+  iree_hal_executable_spec_t spec_b = MakeSpec(data, sizeof(data));
+  spec_b.executable_layouts = &layout_b;
+  iree_hal_executable_spec_t spec_c = MakeSpec(data, sizeof(data));
+  spec_c.executable_layouts = &layout_c;
+
+  iree_hal_executable_t* executable_a = NULL;
+  IREE_ASSERT_OK(iree_hal_local_executable_registry_load(
+      registry_, &loader_->base, &spec_a, &executable_a));
+  iree_hal_executable_t* executable_b = NULL;
+  IREE_ASSERT_OK(iree_hal_local_executable_registry_load(
+      registry_, &loader_->base, &spec_b, &executable_b));
+  iree_hal_executable_t* executable_c = NULL;
+  IREE_ASSERT_OK(iree_hal_local_executable_registry_load(
+      registry_, &loader_->base, &spec_c, &executable_c));
+  EXPECT_EQ(executable_a, executable_b);
+  EXPECT_NE(executable_a, executable_c);
+  EXPECT_EQ(2, loader_->load_count);
+
+  iree_hal_executable_release(executable_a);
+  iree_hal_executable_release(executable_b);
+  iree_hal_executable_release(executable_c);
+  iree_hal_executable_layout_release(layout_a);
+  iree_hal_executable_layout_release(layout_b);
+  iree_hal_executable_layout_release(layout_c);
+}
+
+TEST_F(LocalExecutableRegistryTest, AliasedDataOutlivesFirstCaller) {
+  // The first caller's data is released after the executable is shared with
+  // a second caller that still uses it.
+  std::vector<uint8_t> data_a(64, 0xAB);
+  std::vector<uint8_t> data_b(64, 0xAB);
+  iree_hal_executable_spec_t spec_a = MakeSpec(data_a.data(), data_a.size());
+  spec_a.caching_mode |= IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA;
+  iree_hal_executable_spec_t spec_b = MakeSpec(data_b.data(), data_b.size());
+  spec_b.caching_mode |= IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA;
+
+  iree_hal_executable_t* executable_a = NULL;
+  IREE_ASSERT_OK(iree_hal_local_executable_registry_load(
+      registry_, &loader_->base, &spec_a, &executable_a));
+  iree_hal_executable_t* executable_b = NULL;
+  IREE_ASSERT_OK(iree_hal_local_executable_registry_load(
+      registry_, &loader_->base, &spec_b, &executable_b));
+  EXPECT_EQ(executable_a, executable_b);
+  EXPECT_EQ(1, loader_->load_count);
+  iree_hal_executable_release(executable_a);
+  data_a.clear();
+  data_a.shrink_to_fit();
+
+  // The executable must alias data owned by the registry.
+  iree_const_byte_span_t aliased_data =
+      ((fake_executable_t*)executable_b)->data;
+  ASSERT_EQ(64, aliased_data.data_length);
+  EXPECT_NE(data_b.data(), aliased_data.data);
+  for (iree_host_size_t i = 0; i < aliased_data.data_length; ++i) {
+    ASSERT_EQ(0xAB, aliased_data.data[i]);
+  }
+  iree_hal_executable_release(executable_b);
+  EXPECT_EQ(0, iree_hal_local_executable_registry_count(registry_));
+}
+
+TEST_F(LocalExecutableRegistryTest, UnaliasedDataIsNotCopied) {
+  // Executables that don't alias their data are loaded from the data of the
+  // caller and the registry keeps only its digest.
+  std::vector<uint8_t> data_a(64, 0xAB);
+  std::vector<uint8_t> data_b(64, 0xAB);
+  iree_hal_executable_spec_t spec_a = MakeSpec(data_a.data(), data_a.size());
+  iree_hal_executable_spec_t spec_b = MakeSpec(data_b.data(), data_b.size());
+
+  iree_hal_executable_t* executable_a = NULL;
+  IREE_ASSERT_OK(iree_hal_local_executable_registry_load(
+      registry_, &loader_->base, &spec_a, &executable_a));
+  EXPECT_EQ(data_a.data(), ((fake_executable_t*)executable_a)->data.data);
+
+  // Identical contents are still matched after the first caller's data is
+  // gone.
+  data_a.clear();
+  data_a.shrink_to_fit();
+  iree_hal_executable_t* executable_b = NULL;
+  IREE_ASSERT_OK(iree_hal_local_executable_registry_load(
+      registry_, &loader_->base, &spec_b, &executable_b));
+  EXPECT_EQ(executable_a, executable_b);
+  EXPECT_EQ(1, loader_->load_count);
+
+  iree_hal_executable_release(executable_a);
+  iree_hal_executable_release(executable_b);
+}
+
+TEST_F(LocalExecutableRegistryTest, DifferentLengthsAreNotShared) {
+  // Zero padding changes the length and digest but not the common prefix.
+  std::vector<uint8_t> data(17, 0);
+  iree_hal_executable_spec_t spec_a = MakeSpec(data.data(), 16);
+  iree_hal_executable_spec_t spec_b = MakeSpec(data.data(), 17);
+
+  iree_hal_executable_t* executable_a = NULL;
+  IREE_ASSERT_OK(iree_hal_local_executable_registry_load(
+      registry_, &loader_->base, &spec_a, &executable_a));
+  iree_hal_executable_t* executable_b = NULL;
+  IREE_ASSERT_OK(iree_hal_local_executable_registry_load(
+      registry_, &loader_->base, &spec_b, &executable_b));
+  EXPECT_NE(executable_a, executable_b);
+  EXPECT_EQ(2, loader_->load_count);
+
+  iree_hal_executable_release(executable_a);
+  iree_hal_executable_release(executable_b);
+}
+
+TEST_F(LocalExecutableRegistryTest, SharedAcrossExecutableCaches) {
+  // Caches for different devices using the same loader share executables
+  // through the default registry.
+  iree_hal_executable_loader_t* loader = &loader_->base;
+  iree_hal_executable_cache_t* cache_a = NULL;
+  IREE_ASSERT_OK(iree_hal_local_executable_cache_create(
+      IREE_SV("a"), 1, &loader, iree_allocator_system(), &cache_a));
+  iree_hal_executable_cache_t* cache_b = NULL;
+  IREE_ASSERT_OK(iree_hal_local_executable_cache_create(
+      IREE_SV("b"), 1, &loader, iree_allocator_system(), &cache_b));
+
+  uint8_t data[32] = {5, 6, 7, 8};
+  iree_hal_executable_spec_t spec = MakeSpec(data, sizeof(data));
+  iree_hal_executable_t* executable_a = NULL;
+  IREE_ASSERT_OK(iree_hal_executable_cache_prepare_executable(cache_a, &spec,
+                                                              &executable_a));
+  iree_hal_executable_t* executable_b = NULL;
+  IREE_ASSERT_OK(iree_hal_executable_cache_prepare_executable(cache_b, &spec,
+                                                              &executable_b));
+  EXPECT_EQ(executable_a, executable_b);
+  EXPECT_EQ(1, loader_->load_count);
+
+  iree_hal_executable_release(executable_a);
+  iree_hal_executable_release(executable_b);
+  iree_hal_executable_cache_release(cache_a);
+  iree_hal_executable_cache_release(cache_b);
+}
+
+}  // namespace
@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "iree/base/internal/arena.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/local/inline_command_buffer.h"
 #include "iree/hal/local/local_descriptor_set.h"
@@ -19,6 +20,7 @@
 #include "iree/hal/local/sync_event.h"
 #include "iree/hal/local/sync_semaphore.h"
 #include "iree/hal/utils/buffer_transfer.h"
+#include "iree/hal/utils/deferred_command_buffer.h"
 
 typedef struct iree_hal_sync_device_t {
   iree_hal_resource_t resource;
@@ -27,6 +29,9 @@ typedef struct iree_hal_sync_device_t {
   iree_allocator_t host_allocator;
   iree_hal_allocator_t* device_allocator;
 
+  // Block pool used for command buffer recording.
+  iree_arena_block_pool_t block_pool;
+
   iree_hal_sync_semaphore_state_t semaphore_state;
 
   iree_host_size_t loader_count;
@@ -44,10 +49,15 @@ static iree_hal_sync_device_t* iree_hal_sync_device_cast(
 void iree_hal_sync_device_params_initialize(
     iree_hal_sync_device_params_t* out_params) {
   memset(out_params, 0, sizeof(*out_params));
+  out_params->arena_block_size = 32 * 1024;
 }
 
 static iree_status_t iree_hal_sync_device_check_params(
     const iree_hal_sync_device_params_t* params) {
+  if (params->arena_block_size < 4096) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "arena block size too small (< 4096 bytes)");
+  }
   return iree_ok_status();
 }
 
@@ -81,6 +91,8 @@ iree_status_t iree_hal_sync_device_create(
     device->host_allocator = host_allocator;
     device->device_allocator = device_allocator;
     iree_hal_allocator_retain(device_allocator);
+    iree_arena_block_pool_initialize(params->arena_block_size, host_allocator,
+                                     &device->block_pool);
 
     device->loader_count = loader_count;
     for (iree_host_size_t i = 0; i < device->loader_count; ++i) {
@@ -111,6 +123,7 @@ static void iree_hal_sync_device_destroy(iree_hal_device_t* base_device) {
     iree_hal_executable_loader_release(device->loaders[i]);
   }
   iree_hal_allocator_release(device->device_allocator);
+  iree_arena_block_pool_deinitialize(&device->block_pool);
   iree_allocator_free(host_allocator, device);
 
   IREE_TRACE_ZONE_END(z0);
@@ -136,6 +149,7 @@ static iree_hal_allocator_t* iree_hal_sync_device_allocator(
 
 static iree_status_t iree_hal_sync_device_trim(iree_hal_device_t* base_device) {
   iree_hal_sync_device_t* device = iree_hal_sync_device_cast(base_device);
+  iree_arena_block_pool_trim(&device->block_pool);
   return iree_hal_allocator_trim(device->device_allocator);
 }
 
@@ -166,10 +180,20 @@ static iree_status_t iree_hal_sync_device_create_command_buffer(
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
     iree_hal_command_buffer_t** out_command_buffer) {
-  // TODO(#4680): implement a non-inline command buffer that stores its commands
-  // and can be submitted later on/multiple-times.
-  return iree_hal_inline_command_buffer_create(
-      base_device, mode, command_categories, queue_affinity,
+  iree_hal_sync_device_t* device = iree_hal_sync_device_cast(base_device);
+  if (iree_all_bits_set(mode,
+                        IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION)) {
+    // The caller has indicated the command buffer can be executed as it is
+    // recorded, implying that the command buffer cannot be reused and doesn't
+    // need to be persisted.
+    return iree_hal_inline_command_buffer_create(
+        base_device, mode, command_categories, queue_affinity,
+        iree_hal_device_host_allocator(base_device), out_command_buffer);
+  }
+  // Record the commands so that they can be replayed inline at submission time
+  // (possibly multiple times, possibly from multiple threads).
+  return iree_hal_deferred_command_buffer_create(
+      base_device, mode, command_categories, &device->block_pool,
       iree_hal_device_host_allocator(base_device), out_command_buffer);
 }
 
@@ -233,29 +257,57 @@ static iree_status_t iree_hal_sync_device_queue_submit(
     iree_hal_queue_affinity_t queue_affinity, iree_host_size_t batch_count,
     const iree_hal_submission_batch_t* batches) {
   iree_hal_sync_device_t* device = iree_hal_sync_device_cast(base_device);
+  IREE_TRACE_ZONE_BEGIN(z0);
 
-  // TODO(#4680): there is some better error handling here needed; we should
-  // propagate failures to all signal semaphores. Today we aren't as there
-  // shouldn't be any failures or if there are there's not much we'd be able to
-  // do - we already executed everything inline!
+  // Deferred command buffers are replayed against an inline command buffer
+  // that executes the commands as they are applied. The same inline command
+  // buffer is reused for all command buffers in the submission.
+  iree_hal_command_buffer_t* inline_command_buffer = NULL;
 
+  iree_status_t status = iree_ok_status();
   for (iree_host_size_t i = 0; i < batch_count; ++i) {
     const iree_hal_submission_batch_t* batch = &batches[i];
 
     // Wait for semaphores to be signaled before performing any work.
-    IREE_RETURN_IF_ERROR(iree_hal_sync_semaphore_multi_wait(
+    status = iree_hal_sync_semaphore_multi_wait(
         &device->semaphore_state, IREE_HAL_WAIT_MODE_ALL,
-        &batch->wait_semaphores, iree_infinite_timeout()));
-
-    // TODO(#4680): if we were doing deferred submissions we would issue them
-    // here. With only inline command buffers we have nothing to do here.
+        &batch->wait_semaphores, iree_infinite_timeout());
+
+    // Execute any command buffers that have not already executed inline.
+    for (iree_host_size_t j = 0;
+         iree_status_is_ok(status) && j < batch->command_buffer_count; ++j) {
+      iree_hal_command_buffer_t* command_buffer = batch->command_buffers[j];
+      if (iree_hal_inline_command_buffer_isa(command_buffer)) continue;
+      if (!inline_command_buffer) {
+        status = iree_hal_inline_command_buffer_create(
+            base_device,
+            IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT |
+                IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION |
+                IREE_HAL_COMMAND_BUFFER_MODE_UNVALIDATED,
+            IREE_HAL_COMMAND_CATEGORY_ANY, IREE_HAL_QUEUE_AFFINITY_ANY,
+            device->host_allocator, &inline_command_buffer);
+        if (!iree_status_is_ok(status)) break;
+      }
+      status = iree_hal_deferred_command_buffer_apply(command_buffer,
+                                                      inline_command_buffer);
+    }
 
-    // Signal all semaphores now that batch work has completed.
-    IREE_RETURN_IF_ERROR(iree_hal_sync_semaphore_multi_signal(
-        &device->semaphore_state, &batch->signal_semaphores));
+    // Signal all semaphores now that batch work has completed. If the batch
+    // failed we propagate the failure to the semaphores such that waiters are
+    // woken and observe it.
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_sync_semaphore_multi_signal(&device->semaphore_state,
+                                                    &batch->signal_semaphores);
+    } else {
+      iree_hal_sync_semaphore_multi_fail(&batch->signal_semaphores,
+                                         iree_status_clone(status));
+    }
+    if (!iree_status_is_ok(status)) break;
   }
 
-  return iree_ok_status();
+  iree_hal_command_buffer_release(inline_command_buffer);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
 static iree_status_t iree_hal_sync_device_submit_and_wait(
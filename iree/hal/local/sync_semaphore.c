@@ -43,6 +43,11 @@ typedef struct iree_hal_sync_semaphore_t {
   // Shared across all semaphores.
   iree_hal_sync_semaphore_state_t* shared_state;
 
+  // Notification posted when this semaphore's value changes. Waiters on only
+  // this semaphore use this instead of the shared notification such that they
+  // aren't woken by unrelated semaphores.
+  iree_notification_t notification;
+
   // Guards all mutable fields. We expect low contention on semaphores and since
   // iree_slim_mutex_t is (effectively) just a CAS this keeps things simpler
   // than trying to make the entire structure lock-free.
@@ -81,6 +86,7 @@ iree_status_t iree_hal_sync_semaphore_create(
                                  &semaphore->resource);
     semaphore->host_allocator = host_allocator;
     semaphore->shared_state = shared_state;
+    iree_notification_initialize(&semaphore->notification);
 
     iree_slim_mutex_initialize(&semaphore->mutex);
     semaphore->current_value = initial_value;
@@ -102,6 +108,7 @@ static void iree_hal_sync_semaphore_destroy(
 
   iree_status_free(semaphore->failure_status);
   iree_slim_mutex_deinitialize(&semaphore->mutex);
+  iree_notification_deinitialize(&semaphore->notification);
   iree_allocator_free(host_allocator, semaphore);
 
   IREE_TRACE_ZONE_END(z0);
@@ -132,7 +139,6 @@ static iree_status_t iree_hal_sync_semaphore_signal_unsafe(
     iree_hal_sync_semaphore_t* semaphore, uint64_t new_value) {
   if (new_value <= semaphore->current_value) {
     uint64_t current_value IREE_ATTRIBUTE_UNUSED = semaphore->current_value;
-    iree_slim_mutex_unlock(&semaphore->mutex);
     return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
                             "semaphore values must be monotonically "
                             "increasing; current_value=%" PRIu64
@@ -146,6 +152,13 @@ static iree_status_t iree_hal_sync_semaphore_signal_unsafe(
   return iree_ok_status();
 }
 
+// Wakes all waiters on just |semaphore|. Multi-waiters must be notified via the
+// shared state notification.
+static void iree_hal_sync_semaphore_notify(
+    iree_hal_sync_semaphore_t* semaphore) {
+  iree_notification_post(&semaphore->notification, IREE_ALL_WAITERS);
+}
+
 static iree_status_t iree_hal_sync_semaphore_signal(
     iree_hal_semaphore_t* base_semaphore, uint64_t new_value) {
   iree_hal_sync_semaphore_t* semaphore =
@@ -157,9 +170,7 @@ static iree_status_t iree_hal_sync_semaphore_signal(
   iree_slim_mutex_unlock(&semaphore->mutex);
 
   if (iree_status_is_ok(status)) {
-    // Post a global notification so that any waiter will wake.
-    // TODO(#4680): make notifications per-semaphore; would make multi-wait
-    // impossible with iree_notification_t and we'd have to use wait handles.
+    iree_hal_sync_semaphore_notify(semaphore);
     iree_notification_post(&semaphore->shared_state->notification,
                            IREE_ALL_WAITERS);
   }
@@ -189,6 +200,7 @@ static void iree_hal_sync_semaphore_fail(iree_hal_semaphore_t* base_semaphore,
 
   iree_slim_mutex_unlock(&semaphore->mutex);
 
+  iree_hal_sync_semaphore_notify(semaphore);
   iree_notification_post(&semaphore->shared_state->notification,
                          IREE_ALL_WAITERS);
 }
@@ -206,6 +218,7 @@ iree_status_t iree_hal_sync_semaphore_multi_signal(
         semaphore, semaphore_list->payload_values[i]);
     iree_slim_mutex_unlock(&semaphore->mutex);
     if (!iree_status_is_ok(status)) break;
+    iree_hal_sync_semaphore_notify(semaphore);
   }
 
   // Notify all waiters that we've updated semaphores. They'll wake and check
@@ -217,6 +230,15 @@ iree_status_t iree_hal_sync_semaphore_multi_signal(
   return status;
 }
 
+void iree_hal_sync_semaphore_multi_fail(
+    const iree_hal_semaphore_list_t* semaphore_list, iree_status_t status) {
+  for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
+    iree_hal_semaphore_fail(semaphore_list->semaphores[i],
+                            iree_status_clone(status));
+  }
+  iree_status_ignore(status);
+}
+
 typedef struct iree_hal_sync_semaphore_notify_state_t {
   iree_hal_sync_semaphore_t* semaphore;
   uint64_t value;
@@ -255,21 +277,16 @@ static iree_status_t iree_hal_sync_semaphore_wait(
   }
   iree_slim_mutex_unlock(&semaphore->mutex);
 
-  // TODO(#4680): we should be checking for DEADLINE_EXCEEDED here. This is
-  // easy when it's iree_timeout_is_infinite (we can just use the notification
-  // as below) but if it's an actual deadline we'll need to probably switch to
-  // iree_wait_handle_t.
-
-  // Perform wait on the global notification. Will wait forever.
-  iree_hal_sync_semaphore_state_t* shared_state = semaphore->shared_state;
+  // Perform wait on the semaphore notification until signaled or the deadline
+  // elapses. The result is derived from the semaphore state below.
   iree_hal_sync_semaphore_notify_state_t notify_state = {
       .semaphore = semaphore,
       .value = value,
   };
-  iree_notification_await(
-      &shared_state->notification,
+  iree_notification_await_until(
+      &semaphore->notification,
       (iree_condition_fn_t)iree_hal_sync_semaphore_is_signaled,
-      (void*)&notify_state);
+      (void*)&notify_state, iree_timeout_as_deadline_ns(timeout));
 
   iree_status_t status = iree_ok_status();
   iree_slim_mutex_lock(&semaphore->mutex);
@@ -384,18 +401,14 @@ iree_status_t iree_hal_sync_semaphore_multi_wait(
     return status;
   }
 
-  // TODO(#4680): we should be checking for DEADLINE_EXCEEDED here. This is
-  // easy when it's iree_timeout_is_infinite (we can just use the notification
-  // as below) but if it's an actual deadline we'll need to probably switch to
-  // iree_wait_handle_t.
-
-  // Perform wait on the global notification. Will wait forever.
-  iree_notification_await(
+  // Perform wait on the global notification until the condition is met or the
+  // deadline elapses.
+  iree_notification_await_until(
       &shared_state->notification,
       wait_mode == IREE_HAL_WAIT_MODE_ALL
           ? (iree_condition_fn_t)iree_hal_sync_semaphore_all_signaled
           : (iree_condition_fn_t)iree_hal_sync_semaphore_any_signaled,
-      (void*)semaphore_list);
+      (void*)semaphore_list, iree_timeout_as_deadline_ns(timeout));
 
   // We may have been successful - or may have a partial failure.
   iree_status_t status =
@@ -26,6 +26,8 @@ extern "C" {
 // semaphore created from it.
 typedef struct iree_hal_sync_semaphore_state_t {
   // In-process notification signaled when any semaphore value changes.
+  // Only used by multi-waits; waits on a single semaphore use the notification
+  // of that semaphore.
   iree_notification_t notification;
 } iree_hal_sync_semaphore_state_t;
 
@@ -43,8 +45,9 @@ void iree_hal_sync_semaphore_state_deinitialize(
 //===----------------------------------------------------------------------===//
 
 // Creates a semaphore that allows for ordering of operations on the local host.
-// Backed by a shared iree_notification_t in |shared_state|. Not efficient under
-// high contention or many simultaneous users but that's not what the
+// Backed by a per-semaphore iree_notification_t for single waits and a shared
+// iree_notification_t in |shared_state| for multi-waits. Not efficient under
+// high contention or many simultaneous multi-waits but that's not what the
 // synchronous backend is intended for - if you want something efficient in the
 // face of hundreds or thousands of active asynchronous operations then use the
 // task system.
@@ -59,6 +62,11 @@ iree_status_t iree_hal_sync_semaphore_multi_signal(
     iree_hal_sync_semaphore_state_t* shared_state,
     const iree_hal_semaphore_list_t* semaphore_list);
 
+// Fails all semaphores in |semaphore_list| with |status|.
+// Ownership of |status| is transferred and each semaphore receives a clone.
+void iree_hal_sync_semaphore_multi_fail(
+    const iree_hal_semaphore_list_t* semaphore_list, iree_status_t status);
+
 // Performs a multi-wait on one or more semaphores.
 // Returns IREE_STATUS_DEADLINE_EXCEEDED if the wait does not complete before
 // |timeout| elapses.
@@ -12,6 +12,7 @@
 #include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/math.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/local/executable_library.h"
 #include "iree/hal/local/local_descriptor_set_layout.h"
@@ -23,6 +24,120 @@
 #include "iree/task/submission.h"
 #include "iree/task/task.h"
 
+#if defined(IREE_ARCH_X86_64)
+// SSE2 is part of the x86-64 baseline and provides non-temporal stores.
+#include <emmintrin.h>
+#define IREE_HAL_CMD_TRANSFER_SSE2 1
+#endif  // IREE_ARCH_X86_64
+
+//===----------------------------------------------------------------------===//
+// Hazard tracking
+//===----------------------------------------------------------------------===//
+
+#if !defined(IREE_HAL_TASK_COMMAND_BUFFER_MAX_TRACKED_ACCESSES)
+// Maximum number of buffer ranges tracked for hazards since the last global
+// barrier. Each recorded command checks all tracked ranges so recording cost
+// grows linearly with this value. When a command would exceed it a global
+// barrier joining all outstanding commands is inserted and tracking restarts;
+// lower values trade concurrency across barriers for cheaper recording.
+#define IREE_HAL_TASK_COMMAND_BUFFER_MAX_TRACKED_ACCESSES 256
+#endif  // !IREE_HAL_TASK_COMMAND_BUFFER_MAX_TRACKED_ACCESSES
+
+// A byte range of an allocated buffer read or written by a recorded command.
+typedef struct iree_hal_task_buffer_access_t {
+  // Allocated buffer containing the range or NULL to indicate all buffers.
+  iree_hal_buffer_t* buffer;
+  // Absolute byte range in the allocated buffer.
+  iree_device_size_t offset;
+  iree_device_size_t length;
+  // True if the command may write to the range.
+  bool is_write;
+} iree_hal_task_buffer_access_t;
+
+typedef struct iree_hal_task_command_node_t iree_hal_task_command_node_t;
+
+// A dependency edge from a node to a node that must execute after it.
+typedef struct iree_hal_task_command_edge_t {
+  struct iree_hal_task_command_edge_t* next;
+  iree_hal_task_command_node_t* target;
+} iree_hal_task_command_edge_t;
+
+// A task recorded into the command buffer and its edges in the DAG.
+// Edges are only gathered during recording and are translated into task
+// completion tasks and barriers when recording ends and the number of
+// successors of each task is known.
+struct iree_hal_task_command_node_t {
+  // Next node in recording order.
+  iree_hal_task_command_node_t* next;
+  // Index of the node in recording order.
+  iree_host_size_t index;
+  iree_task_t* task;
+  // Successor edges, most recently added first.
+  iree_hal_task_command_edge_t* successor_head;
+  iree_host_size_t successor_count;
+  iree_host_size_t predecessor_count;
+};
+
+// A buffer range accessed by a recorded node, retained so that commands
+// recorded after a subsequent barrier can check for hazards against it.
+typedef struct iree_hal_task_access_record_t {
+  struct iree_hal_task_access_record_t* next;
+  iree_hal_task_command_node_t* node;
+  // Barrier-delimited segment the node was recorded in.
+  uint32_t segment;
+  iree_hal_task_buffer_access_t access;
+} iree_hal_task_access_record_t;
+
+// An event signaled within the command buffer. Events have no state outside of
+// recording: waits are resolved to the node joining the commands recorded prior
+// to the signal and only the commands between the signal and the wait are
+// allowed to overlap.
+typedef struct iree_hal_task_event_record_t {
+  struct iree_hal_task_event_record_t* next;
+  iree_hal_event_t* event;
+  // Node that completes once all commands recorded prior to the most recent
+  // signal of the event have completed or NULL if the event has been reset.
+  iree_hal_task_command_node_t* signal_node;
+} iree_hal_task_event_record_t;
+
+// Returns an access of |length| bytes at |offset| into |buffer| translated to
+// its allocated buffer so that accesses through different subspans of the same
+// allocation can be compared.
+static iree_hal_task_buffer_access_t iree_hal_task_make_buffer_access(
+    iree_hal_buffer_t* buffer, iree_device_size_t offset,
+    iree_device_size_t length, bool is_write) {
+  if (length == IREE_WHOLE_BUFFER) {
+    length = iree_hal_buffer_byte_length(buffer) - offset;
+  }
+  iree_hal_task_buffer_access_t access = {
+      .buffer = iree_hal_buffer_allocated_buffer(buffer),
+      .offset = iree_hal_buffer_byte_offset(buffer) + offset,
+      .length = length,
+      .is_write = is_write,
+  };
+  return access;
+}
+
+// Returns true if executing |a| and |b| in either order (or concurrently) may
+// produce different results: they overlap and at least one writes.
+static bool iree_hal_task_buffer_accesses_conflict(
+    const iree_hal_task_buffer_access_t* a,
+    const iree_hal_task_buffer_access_t* b) {
+  if (!a->is_write && !b->is_write) return false;
+  if (!a->buffer || !b->buffer) return true;
+  if (a->buffer != b->buffer) return false;
+  return a->offset < b->offset + b->length && b->offset < a->offset + a->length;
+}
+
+// Returns true if the range of |access| fully contains that of |other|.
+static bool iree_hal_task_buffer_access_covers(
+    const iree_hal_task_buffer_access_t* access,
+    const iree_hal_task_buffer_access_t* other) {
+  return access->buffer && access->buffer == other->buffer &&
+         access->offset <= other->offset &&
+         access->offset + access->length >= other->offset + other->length;
+}
+
 //===----------------------------------------------------------------------===//
 // iree_hal_task_command_buffer_t
 //===----------------------------------------------------------------------===//
@@ -35,12 +150,35 @@
 // additional allocations required during recording or execution. That means our
 // command buffer here is essentially just a builder for the task system types
 // and manager of the lifetime of the tasks.
+//
+// Barriers do not join all prior work. Instead each command records the buffer
+// ranges it reads and writes and after a barrier only depends on the prior
+// commands it has a read-after-write, write-after-read, or write-after-write
+// hazard with. Independent commands on either side of a barrier are free to
+// overlap. Events signaled and waited on within the same command buffer are
+// split barriers: commands recorded between the signal and the wait may overlap
+// with those on either side.
+//
+// One-shot command buffers wire up and submit the recorded tasks directly.
+// Reusable command buffers (those created without
+// IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT) instead keep the recorded tasks as an
+// immutable template: each time they are issued the tasks are copied into the
+// submission arena and wired into a new DAG instance. The command payloads
+// (bindings, push constants, buffer references, etc) are shared by all
+// instances and never copied.
 typedef struct iree_hal_task_command_buffer_t {
   iree_hal_command_buffer_t base;
   iree_allocator_t host_allocator;
 
+  // Executor the command buffer will be issued on; unretained as the device
+  // owning the command buffer retains it.
+  iree_task_executor_t* executor;
   iree_task_scope_t* scope;
 
+  // Length of each tile of fill and copy commands; a power of two derived from
+  // the executor worker cache size.
+  uint32_t transfer_slice_length;
+
   // Arena used for all allocations; references the shared device block pool.
   iree_arena_allocator_t arena;
 
@@ -53,31 +191,41 @@ typedef struct iree_hal_task_command_buffer_t {
   // ready task set in the submission.
   iree_task_list_t root_tasks;
 
-  // One or more tasks at the leaves of the DAG.
+  // One or more tasks at the leaves of the DAG with no successors.
   // Only once all these tasks have completed execution will the command buffer
-  // be considered completed as a whole.
-  //
-  // An empty list indicates that root_tasks are also the leaves.
-  iree_task_list_t leaf_tasks;
+  // be considered completed as a whole. Tasks may be both roots and leaves.
+  // Allocated from the arena when recording ends. Reusable command buffers
+  // only track the count and produce the leaves of each instance on issue.
+  iree_host_size_t leaf_task_count;
+  iree_task_t** leaf_tasks;
 
   // TODO(benvanik): move this out of the struct and allocate from the arena -
-  // we only need this during recording and it's ~4KB of waste otherwise.
+  // we only need this during recording and it's ~6KB of waste otherwise.
   // State tracked within the command buffer during recording only.
   struct {
-    // The last global barrier that was inserted, if any.
-    // The barrier is allocated and inserted into the DAG when requested but the
-    // actual barrier dependency list is only allocated and set on flushes.
-    // This lets us allocate the appropriately sized barrier task list from the
-    // arena even though when the barrier is recorded we don't yet know what
-    // other tasks we'll be emitting as we walk the command stream.
-    iree_task_barrier_t* open_barrier;
-
-    // The number of tasks in the open barrier (|open_tasks|), used to quickly
-    // allocate storage for the task list without needing to walk the list.
-    iree_host_size_t open_task_count;
-
-    // All execution tasks emitted that must execute after |open_barrier|.
-    iree_task_list_t open_tasks;
+    // All nodes recorded in recording order. Retained after recording ends
+    // by reusable command buffers as the template for each issued instance.
+    iree_hal_task_command_node_t* node_head;
+    iree_hal_task_command_node_t* node_tail;
+    iree_host_size_t node_count;
+
+    // Barrier-delimited segment new commands are recorded into. Commands only
+    // depend on commands from prior segments.
+    uint32_t segment;
+
+    // Buffer ranges accessed by recorded commands that later commands may
+    // have hazards with. Ranges fully overwritten by a later command are
+    // dropped as depending on that command transitively orders against them.
+    iree_hal_task_access_record_t* access_head;
+    iree_host_size_t access_count;
+    // Dropped records available for reuse.
+    iree_hal_task_access_record_t* access_free_list;
+
+    // Events signaled within the command buffer.
+    iree_hal_task_event_record_t* event_head;
+    // Node joining all events waited on so far, if any. All commands recorded
+    // after a wait are ordered after it.
+    iree_hal_task_command_node_t* wait_node;
 
     // A flattened list of all available descriptor set bindings.
     // As descriptor sets are pushed/bound the bindings will be updated to
@@ -89,6 +237,10 @@ typedef struct iree_hal_task_command_buffer_t {
     iree_device_size_t
         binding_lengths[IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT *
                         IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT];
+    // Buffer ranges of each binding used for hazard tracking.
+    iree_hal_task_buffer_access_t
+        binding_accesses[IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT *
+                         IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT];
 
     // All available push constants updated each time push_constants is called.
     // Reset only with the command buffer and otherwise will maintain its values
@@ -106,8 +258,51 @@ static iree_hal_task_command_buffer_t* iree_hal_task_command_buffer_cast(
   return (iree_hal_task_command_buffer_t*)base_value;
 }
 
+//===----------------------------------------------------------------------===//
+// Transfer tiling
+//===----------------------------------------------------------------------===//
+// Fills and copies are dispatched as tiles for parallelism. Tiles are sized to
+// half of the private cache of a worker so that the source and target of a
+// copy tile both stay in cache while it runs. The tile length must be a power
+// of two so that every tile is aligned to the fill pattern length.
+
+// Tile length used when the executor does not know its worker cache size.
+#define IREE_HAL_CMD_TRANSFER_DEFAULT_SLICE_LENGTH (128 * 1024)
+// Bounds for tile lengths derived from cache sizes. Too small and the per-tile
+// overhead dominates and too large and the tiles no longer balance well across
+// workers.
+#define IREE_HAL_CMD_TRANSFER_MIN_SLICE_LENGTH (32 * 1024)
+#define IREE_HAL_CMD_TRANSFER_MAX_SLICE_LENGTH (2 * 1024 * 1024)
+
+// Transfers at least this large write their targets with non-temporal stores.
+// Such targets do not fit in cache and are unlikely to be read again soon so
+// streaming them directly to memory avoids evicting the working set of
+// dispatches running concurrently on other workers.
+#define IREE_HAL_CMD_TRANSFER_NON_TEMPORAL_THRESHOLD (32 * 1024 * 1024)
+
+static uint32_t iree_hal_task_command_buffer_select_transfer_slice_length(
+    iree_task_executor_t* executor) {
+  iree_host_size_t cache_size =
+      iree_task_executor_worker_cache_size(executor) / 2;
+  if (cache_size < IREE_HAL_CMD_TRANSFER_MIN_SLICE_LENGTH) {
+    return cache_size ? IREE_HAL_CMD_TRANSFER_MIN_SLICE_LENGTH
+                      : IREE_HAL_CMD_TRANSFER_DEFAULT_SLICE_LENGTH;
+  }
+  cache_size = iree_min(cache_size, IREE_HAL_CMD_TRANSFER_MAX_SLICE_LENGTH);
+  // Round down to a power of two.
+  return 1u << (31 - iree_math_count_leading_zeros_u32((uint32_t)cache_size));
+}
+
+// Returns the workgroup count required to cover |length| bytes with tiles of
+// |slice_length| bytes.
+static uint32_t iree_hal_task_command_buffer_transfer_slice_count(
+    iree_device_size_t length, uint32_t slice_length) {
+  return (uint32_t)iree_max(1, (length + slice_length - 1) / slice_length);
+}
+
 iree_status_t iree_hal_task_command_buffer_create(
-    iree_hal_device_t* device, iree_task_scope_t* scope,
+    iree_hal_device_t* device, iree_task_executor_t* executor,
+    iree_task_scope_t* scope,
     iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
@@ -115,20 +310,6 @@ iree_status_t iree_hal_task_command_buffer_create(
     iree_hal_command_buffer_t** out_command_buffer) {
   IREE_ASSERT_ARGUMENT(out_command_buffer);
   *out_command_buffer = NULL;
-  if (!iree_all_bits_set(mode, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT)) {
-    // If we want reuse we'd need to support duplicating the task DAG after
-    // recording or have some kind of copy-on-submit behavior that does so if
-    // a command buffer is submitted for execution twice. Allowing for the same
-    // command buffer to be enqueued multiple times would be fine so long as
-    // execution doesn't overlap (`cmdbuf|cmdbuf` vs
-    // `cmdbuf -> semaphore -> cmdbuf`) though we'd still need to be careful
-    // that we did the enqueuing and reset of the task structures at the right
-    // times. Definitely something that'll be useful in the future... but not
-    // today :)
-    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                            "only one-shot command buffer usage is supported");
-  }
-
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_hal_task_command_buffer_t* command_buffer = NULL;
@@ -139,10 +320,14 @@ iree_status_t iree_hal_task_command_buffer_create(
         device, mode, command_categories, queue_affinity,
         &iree_hal_task_command_buffer_vtable, &command_buffer->base);
     command_buffer->host_allocator = host_allocator;
+    command_buffer->executor = executor;
     command_buffer->scope = scope;
+    command_buffer->transfer_slice_length =
+        iree_hal_task_command_buffer_select_transfer_slice_length(executor);
     iree_arena_initialize(block_pool, &command_buffer->arena);
     iree_task_list_initialize(&command_buffer->root_tasks);
-    iree_task_list_initialize(&command_buffer->leaf_tasks);
+    command_buffer->leaf_task_count = 0;
+    command_buffer->leaf_tasks = NULL;
     memset(&command_buffer->state, 0, sizeof(command_buffer->state));
     status = iree_hal_resource_set_allocate(block_pool,
                                             &command_buffer->resource_set);
@@ -160,7 +345,8 @@ iree_status_t iree_hal_task_command_buffer_create(
 static void iree_hal_task_command_buffer_reset(
     iree_hal_task_command_buffer_t* command_buffer) {
   memset(&command_buffer->state, 0, sizeof(command_buffer->state));
-  iree_task_list_discard(&command_buffer->leaf_tasks);
+  command_buffer->leaf_task_count = 0;
+  command_buffer->leaf_tasks = NULL;
   iree_task_list_discard(&command_buffer->root_tasks);
   iree_hal_resource_set_reset(command_buffer->resource_set);
   iree_arena_reset(&command_buffer->arena);
@@ -200,8 +386,10 @@ static void* iree_hal_task_command_buffer_dyn_cast(
 // iree_hal_task_command_buffer_t recording
 //===----------------------------------------------------------------------===//
 
-static iree_status_t iree_hal_task_command_buffer_flush_tasks(
-    iree_hal_task_command_buffer_t* command_buffer);
+static iree_status_t iree_hal_task_command_buffer_build_dag(
+    iree_hal_task_command_buffer_t* command_buffer, iree_task_t** node_tasks,
+    iree_arena_allocator_t* arena, iree_task_list_t* root_tasks,
+    iree_task_t** leaf_tasks);
 
 static iree_status_t iree_hal_task_command_buffer_begin(
     iree_hal_command_buffer_t* base_command_buffer) {
@@ -216,132 +404,306 @@ static iree_status_t iree_hal_task_command_buffer_end(
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
 
-  // Flush any open barriers.
-  IREE_RETURN_IF_ERROR(
-      iree_hal_task_command_buffer_flush_tasks(command_buffer));
+  iree_host_size_t leaf_task_count = 0;
+  for (iree_hal_task_command_node_t* node = command_buffer->state.node_head;
+       node != NULL; node = node->next) {
+    if (node->successor_count == 0) ++leaf_task_count;
+  }
+  command_buffer->leaf_task_count = leaf_task_count;
 
-  // Move the tasks from the leaf list (tail) to the root list (head) if this
-  // was the first set of tasks recorded.
-  if (iree_task_list_is_empty(&command_buffer->root_tasks) &&
-      !iree_task_list_is_empty(&command_buffer->leaf_tasks)) {
-    iree_task_list_move(&command_buffer->leaf_tasks,
-                        &command_buffer->root_tasks);
+  // Reusable command buffers keep the recorded tasks pristine and build a new
+  // DAG instance each time they are issued.
+  if (!iree_all_bits_set(command_buffer->base.mode,
+                         IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT)) {
+    return iree_ok_status();
   }
 
-  return iree_ok_status();
+  // Now that we know all of the edges in the DAG we can wire up the tasks.
+  if (leaf_task_count > 0) {
+    IREE_RETURN_IF_ERROR(iree_arena_allocate(
+        &command_buffer->arena, leaf_task_count * sizeof(iree_task_t*),
+        (void**)&command_buffer->leaf_tasks));
+  }
+  return iree_hal_task_command_buffer_build_dag(
+      command_buffer, /*node_tasks=*/NULL, &command_buffer->arena,
+      &command_buffer->root_tasks, command_buffer->leaf_tasks);
 }
 
-// Flushes all open tasks to the previous barrier and prepares for more
-// recording. The root tasks are also populated here when required as this is
-// the one place where we can see both halves of the most recent synchronization
-// event: those tasks recorded prior (if any) and the task that marks the set of
-// tasks that will be recorded after (if any).
-static iree_status_t iree_hal_task_command_buffer_flush_tasks(
-    iree_hal_task_command_buffer_t* command_buffer) {
-  iree_task_barrier_t* open_barrier = command_buffer->state.open_barrier;
-  if (open_barrier != NULL) {
-    // There is an open barrier we need to fixup the fork out to all of the open
-    // tasks that were recorded after it.
-    iree_task_t* task_head =
-        iree_task_list_front(&command_buffer->state.open_tasks);
-    iree_host_size_t dependent_task_count =
-        command_buffer->state.open_task_count;
-    if (dependent_task_count == 1) {
-      // Special-case: only one open task so we can avoid the additional barrier
-      // overhead by reusing the completion task.
-      iree_task_set_completion_task(&open_barrier->header, task_head);
-    } else if (dependent_task_count > 1) {
-      // Allocate the list of tasks we'll stash back on the previous barrier.
-      // Since we couldn't know at the time how many tasks would end up in the
-      // barrier we had to defer it until now.
+// Returns the task executing |node| in a DAG instance: either the task in
+// |node_tasks| at the node index or the recorded task if no instance is used.
+static inline iree_task_t* iree_hal_task_command_node_task(
+    const iree_hal_task_command_node_t* node, iree_task_t** node_tasks) {
+  return node_tasks ? node_tasks[node->index] : node->task;
+}
+
+// Translates the recorded nodes and edges into the task DAG. This has to wait
+// until recording ends as tasks only have a single completion task: nodes with
+// multiple successors need a barrier sized to fan out to all of them and we
+// don't know how many successors a node will have until no more commands can
+// be recorded.
+//
+// |node_tasks| optionally provides the task to use for each node by index when
+// building an instance of a reusable command buffer. Barriers are allocated
+// from |arena|, tasks with no predecessors are appended to |root_tasks|, and
+// tasks with no successors are stored in |leaf_tasks| (with storage for
+// leaf_task_count entries).
+static iree_status_t iree_hal_task_command_buffer_build_dag(
+    iree_hal_task_command_buffer_t* command_buffer, iree_task_t** node_tasks,
+    iree_arena_allocator_t* arena, iree_task_list_t* root_tasks,
+    iree_task_t** leaf_tasks) {
+  iree_host_size_t leaf_task_index = 0;
+  for (iree_hal_task_command_node_t* node = command_buffer->state.node_head;
+       node != NULL; node = node->next) {
+    iree_task_t* task = iree_hal_task_command_node_task(node, node_tasks);
+    if (node->successor_count == 0) {
+      leaf_tasks[leaf_task_index++] = task;
+    } else if (node->successor_count == 1) {
+      // Special-case: only one successor so we can avoid the additional
+      // barrier overhead by reusing the completion task.
+      iree_task_set_completion_task(
+          task, iree_hal_task_command_node_task(node->successor_head->target,
+                                                node_tasks));
+    } else {
+      // Fan out to all successors with a barrier.
+      iree_task_barrier_t* barrier = NULL;
       iree_task_t** dependent_tasks = NULL;
       IREE_RETURN_IF_ERROR(iree_arena_allocate(
-          &command_buffer->arena, dependent_task_count * sizeof(iree_task_t*),
-          (void**)&dependent_tasks));
-      iree_task_t* task = task_head;
-      for (iree_host_size_t i = 0; i < dependent_task_count; ++i) {
-        dependent_tasks[i] = task;
-        task = task->next_task;
+          arena,
+          sizeof(*barrier) + node->successor_count * sizeof(iree_task_t*),
+          (void**)&barrier));
+      dependent_tasks = (iree_task_t**)((uint8_t*)barrier + sizeof(*barrier));
+      iree_host_size_t i = node->successor_count;
+      for (iree_hal_task_command_edge_t* edge = node->successor_head;
+           edge != NULL; edge = edge->next) {
+        // Edges are most-recent first; reverse to retain recording order.
+        dependent_tasks[--i] =
+            iree_hal_task_command_node_task(edge->target, node_tasks);
       }
-      iree_task_barrier_set_dependent_tasks(open_barrier, dependent_task_count,
+      iree_task_barrier_initialize_empty(command_buffer->scope, barrier);
+      iree_task_set_completion_task(task, &barrier->header);
+      iree_task_barrier_set_dependent_tasks(barrier, node->successor_count,
                                             dependent_tasks);
     }
   }
-  command_buffer->state.open_barrier = NULL;
 
-  // Move the open tasks to the tail as they represent the first half of the
-  // *next* barrier that will be inserted.
-  if (command_buffer->state.open_task_count > 0) {
-    iree_task_list_move(&command_buffer->state.open_tasks,
-                        &command_buffer->leaf_tasks);
-    command_buffer->state.open_task_count = 0;
+  // Root tasks are only added once all edges are wired up as the task list
+  // links would otherwise be clobbered.
+  for (iree_hal_task_command_node_t* node = command_buffer->state.node_head;
+       node != NULL; node = node->next) {
+    if (node->predecessor_count == 0) {
+      iree_task_list_push_back(
+          root_tasks, iree_hal_task_command_node_task(node, node_tasks));
+    }
   }
 
   return iree_ok_status();
 }
 
-// Emits a global barrier, splitting execution into all prior recorded tasks
-// and all subsequent recorded tasks. This is currently the critical piece that
-// limits our concurrency: changing to fine-grained barriers (via barrier
-// buffers or events) will allow more work to overlap at the cost of more brain
-// to build out the proper task graph.
-static iree_status_t iree_hal_task_command_buffer_emit_global_barrier(
-    iree_hal_task_command_buffer_t* command_buffer) {
-  // Flush open tasks to the previous barrier. This resets our state such that
-  // we can assign the new open barrier and start recording tasks for it.
-  // Previous tasks will be moved into the leaf_tasks list.
-  IREE_RETURN_IF_ERROR(
-      iree_hal_task_command_buffer_flush_tasks(command_buffer));
-
-  // Allocate the new open barrier.
-  // As we are recording forward we can't yet assign the dependent tasks (the
-  // second half of the synchronization domain) and instead are just inserting
-  // it so we can setup the join from previous tasks (the first half of the
-  // synchronization domain).
-  iree_task_barrier_t* barrier = NULL;
+// Adds an edge ordering |target| after |source|, if not already present.
+static iree_status_t iree_hal_task_command_buffer_add_edge(
+    iree_hal_task_command_buffer_t* command_buffer,
+    iree_hal_task_command_node_t* source,
+    iree_hal_task_command_node_t* target) {
+  // Successors are added one target at a time so duplicates (from multiple
+  // hazards between the same two commands) are always at the head.
+  if (source->successor_head && source->successor_head->target == target) {
+    return iree_ok_status();
+  }
+  iree_hal_task_command_edge_t* edge = NULL;
   IREE_RETURN_IF_ERROR(iree_arena_allocate(&command_buffer->arena,
-                                           sizeof(*barrier), (void**)&barrier));
-  iree_task_barrier_initialize_empty(command_buffer->scope, barrier);
+                                           sizeof(*edge), (void**)&edge));
+  edge->next = source->successor_head;
+  edge->target = target;
+  source->successor_head = edge;
+  ++source->successor_count;
+  ++target->predecessor_count;
+  return iree_ok_status();
+}
 
-  // If there were previous tasks then join them to the barrier.
-  for (iree_task_t* task = iree_task_list_front(&command_buffer->leaf_tasks);
-       task != NULL; task = task->next_task) {
-    iree_task_set_completion_task(task, &barrier->header);
+// Allocates a new node for |task| and appends it to the recorded node list.
+static iree_status_t iree_hal_task_command_buffer_append_node(
+    iree_hal_task_command_buffer_t* command_buffer, iree_task_t* task,
+    iree_hal_task_command_node_t** out_node) {
+  iree_hal_task_command_node_t* node = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(&command_buffer->arena,
+                                           sizeof(*node), (void**)&node));
+  memset(node, 0, sizeof(*node));
+  node->index = command_buffer->state.node_count++;
+  node->task = task;
+  if (command_buffer->state.node_tail) {
+    command_buffer->state.node_tail->next = node;
+  } else {
+    command_buffer->state.node_head = node;
   }
+  command_buffer->state.node_tail = node;
+  *out_node = node;
+  return iree_ok_status();
+}
 
-  // Move the tasks from the leaf list (tail) to the root list (head) if this
-  // was the first set of tasks recorded.
-  if (iree_task_list_is_empty(&command_buffer->root_tasks) &&
-      !iree_task_list_is_empty(&command_buffer->leaf_tasks)) {
-    iree_task_list_move(&command_buffer->leaf_tasks,
-                        &command_buffer->root_tasks);
+// Tracks |access| made by |node| so that later commands can order against it.
+static iree_status_t iree_hal_task_command_buffer_track_access(
+    iree_hal_task_command_buffer_t* command_buffer,
+    iree_hal_task_command_node_t* node,
+    const iree_hal_task_buffer_access_t* access) {
+  iree_hal_task_access_record_t* record =
+      command_buffer->state.access_free_list;
+  if (record) {
+    command_buffer->state.access_free_list = record->next;
+  } else {
+    IREE_RETURN_IF_ERROR(iree_arena_allocate(
+        &command_buffer->arena, sizeof(*record), (void**)&record));
   }
+  record->next = command_buffer->state.access_head;
+  record->node = node;
+  record->segment = command_buffer->state.segment;
+  record->access = *access;
+  command_buffer->state.access_head = record;
+  ++command_buffer->state.access_count;
+  return iree_ok_status();
+}
 
-  // Reset the tail of the command buffer to the barrier. This leaves us in a
-  // consistent state if the recording ends immediate after this (the barrier
-  // will be the last task).
-  iree_task_list_initialize(&command_buffer->leaf_tasks);
-  iree_task_list_push_back(&command_buffer->leaf_tasks, &barrier->header);
+// Drops all tracked accesses from prior segments whose ranges are fully
+// overwritten by |access|. Any later command with a hazard against them also
+// has one against |access| and will be ordered after them transitively.
+static void iree_hal_task_command_buffer_drop_covered_accesses(
+    iree_hal_task_command_buffer_t* command_buffer,
+    const iree_hal_task_buffer_access_t* access) {
+  if (!access->is_write) return;
+  iree_hal_task_access_record_t** record_ptr =
+      &command_buffer->state.access_head;
+  while (*record_ptr) {
+    iree_hal_task_access_record_t* record = *record_ptr;
+    if (record->segment < command_buffer->state.segment &&
+        iree_hal_task_buffer_access_covers(access, &record->access)) {
+      *record_ptr = record->next;
+      record->next = command_buffer->state.access_free_list;
+      command_buffer->state.access_free_list = record;
+      --command_buffer->state.access_count;
+    } else {
+      record_ptr = &record->next;
+    }
+  }
+}
 
-  // NOTE: all new tasks emitted will be executed after this barrier.
-  command_buffer->state.open_barrier = barrier;
-  command_buffer->state.open_task_count = 0;
+// Appends a nop node that has no effect other than ordering its successors
+// after its predecessors.
+static iree_status_t iree_hal_task_command_buffer_append_nop_node(
+    iree_hal_task_command_buffer_t* command_buffer,
+    iree_hal_task_command_node_t** out_node) {
+  iree_task_nop_t* nop_task = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(
+      &command_buffer->arena, sizeof(*nop_task), (void**)&nop_task));
+  iree_task_nop_initialize(command_buffer->scope, nop_task);
+  return iree_hal_task_command_buffer_append_node(
+      command_buffer, &nop_task->header, out_node);
+}
 
+// Appends a node that completes once all commands recorded so far have
+// completed. Every node recorded so far is either a leaf or an ancestor of one
+// so only the current leaves need to be joined.
+static iree_status_t iree_hal_task_command_buffer_append_join_node(
+    iree_hal_task_command_buffer_t* command_buffer,
+    iree_hal_task_command_node_t** out_node) {
+  iree_hal_task_command_node_t* join_node = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_task_command_buffer_append_nop_node(command_buffer, &join_node));
+  for (iree_hal_task_command_node_t* node = command_buffer->state.node_head;
+       node != join_node; node = node->next) {
+    if (node->successor_count == 0) {
+      IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_add_edge(
+          command_buffer, node, join_node));
+    }
+  }
+  *out_node = join_node;
   return iree_ok_status();
 }
 
-// Emits a the given execution |task| into the current open synchronization
-// scope (after state.open_barrier and before the next barrier).
+// Emits a global barrier: all commands recorded after it execute after all
+// commands recorded before it, regardless of what they access. Used when we
+// can't or don't want to track accesses precisely.
+static iree_status_t iree_hal_task_command_buffer_emit_global_barrier(
+    iree_hal_task_command_buffer_t* command_buffer) {
+  if (!command_buffer->state.node_head) {
+    // Nothing recorded yet so there is nothing to wait on.
+    ++command_buffer->state.segment;
+    return iree_ok_status();
+  }
+
+  iree_hal_task_command_node_t* join_node = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_append_join_node(
+      command_buffer, &join_node));
+
+  // The join is ordered after any prior wait and all later commands will be
+  // ordered after the join.
+  command_buffer->state.wait_node = NULL;
+
+  // Replace all tracked accesses with one that conflicts with everything such
+  // that all later commands are ordered after the join.
+  while (command_buffer->state.access_head) {
+    iree_hal_task_access_record_t* record = command_buffer->state.access_head;
+    command_buffer->state.access_head = record->next;
+    record->next = command_buffer->state.access_free_list;
+    command_buffer->state.access_free_list = record;
+  }
+  command_buffer->state.access_count = 0;
+  const iree_hal_task_buffer_access_t all_access = {
+      .buffer = NULL,
+      .offset = 0,
+      .length = IREE_WHOLE_BUFFER,
+      .is_write = true,
+  };
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_track_access(
+      command_buffer, join_node, &all_access));
+
+  ++command_buffer->state.segment;
+  return iree_ok_status();
+}
+
+// Emits the given execution |task| into the DAG ordered after any commands
+// recorded prior to the most recent barrier that it has a hazard with based on
+// the buffer |accesses| it makes.
 static iree_status_t iree_hal_task_command_buffer_emit_execution_task(
-    iree_hal_task_command_buffer_t* command_buffer, iree_task_t* task) {
-  if (command_buffer->state.open_barrier == NULL) {
-    // If there is no open barrier then we are at the head and going right into
-    // the task DAG.
-    iree_task_list_push_back(&command_buffer->leaf_tasks, task);
-  } else {
-    // Append to the open task list that will be flushed to the open barrier.
-    iree_task_list_push_back(&command_buffer->state.open_tasks, task);
-    ++command_buffer->state.open_task_count;
+    iree_hal_task_command_buffer_t* command_buffer, iree_task_t* task,
+    iree_host_size_t access_count,
+    const iree_hal_task_buffer_access_t* accesses) {
+  // Bound the cost of hazard checks; tracking restarts after a global barrier.
+  if (command_buffer->state.access_count + access_count >
+      IREE_HAL_TASK_COMMAND_BUFFER_MAX_TRACKED_ACCESSES) {
+    IREE_RETURN_IF_ERROR(
+        iree_hal_task_command_buffer_emit_global_barrier(command_buffer));
+  }
+
+  iree_hal_task_command_node_t* node = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_task_command_buffer_append_node(command_buffer, task, &node));
+
+  // Order after any events waited on.
+  if (command_buffer->state.wait_node) {
+    IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_add_edge(
+        command_buffer, command_buffer->state.wait_node, node));
+  }
+
+  // Order after all commands from prior segments with hazards. Commands in the
+  // current segment are allowed to execute concurrently with this one.
+  for (iree_hal_task_access_record_t* record =
+           command_buffer->state.access_head;
+       record != NULL; record = record->next) {
+    if (record->segment == command_buffer->state.segment) continue;
+    for (iree_host_size_t i = 0; i < access_count; ++i) {
+      if (iree_hal_task_buffer_accesses_conflict(&record->access,
+                                                 &accesses[i])) {
+        IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_add_edge(
+            command_buffer, record->node, node));
+        break;
+      }
+    }
+  }
+
+  for (iree_host_size_t i = 0; i < access_count; ++i) {
+    iree_hal_task_command_buffer_drop_covered_accesses(command_buffer,
+                                                       &accesses[i]);
+    IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_track_access(
+        command_buffer, node, &accesses[i]));
   }
   return iree_ok_status();
 }
@@ -350,6 +712,80 @@ static iree_status_t iree_hal_task_command_buffer_emit_execution_task(
 // iree_hal_task_command_buffer_t execution
 //===----------------------------------------------------------------------===//
 
+// Returns the size of the task structure of the given |type| as recorded into
+// command buffers or 0 if the type is never recorded.
+static iree_host_size_t iree_hal_task_command_buffer_task_size(
+    iree_task_type_t type) {
+  switch (type) {
+    case IREE_TASK_TYPE_NOP:
+      return sizeof(iree_task_nop_t);
+    case IREE_TASK_TYPE_CALL:
+      return sizeof(iree_task_call_t);
+    case IREE_TASK_TYPE_DISPATCH:
+      return sizeof(iree_task_dispatch_t);
+    default:
+      return 0;
+  }
+}
+
+// Issues a new instance of the task DAG recorded into a reusable
+// |command_buffer|. All tasks are copied from the recorded tasks (which are
+// never executed themselves) into |arena| and the copies are wired together.
+// Task closures continue to reference the recorded commands and must treat
+// them as read-only as multiple instances may be executing concurrently.
+static iree_status_t iree_hal_task_command_buffer_issue_instance(
+    iree_hal_task_command_buffer_t* command_buffer, iree_task_t* retire_task,
+    iree_arena_allocator_t* arena, iree_task_submission_t* pending_submission) {
+  // If the command buffer is empty (valid!) then we are a no-op.
+  iree_host_size_t node_count = command_buffer->state.node_count;
+  if (node_count == 0) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)node_count);
+
+  iree_host_size_t leaf_task_count = command_buffer->leaf_task_count;
+  iree_task_t** node_tasks = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_arena_allocate(
+              arena, (node_count + leaf_task_count) * sizeof(iree_task_t*),
+              (void**)&node_tasks));
+  iree_task_t** leaf_tasks = node_tasks + node_count;
+  for (iree_hal_task_command_node_t* node = command_buffer->state.node_head;
+       node != NULL; node = node->next) {
+    iree_host_size_t task_size =
+        iree_hal_task_command_buffer_task_size(node->task->type);
+    if (IREE_UNLIKELY(task_size == 0)) {
+      IREE_TRACE_ZONE_END(z0);
+      return iree_make_status(IREE_STATUS_INTERNAL,
+                              "unexpected task type %d recorded",
+                              (int)node->task->type);
+    }
+    iree_task_t* task = NULL;
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_arena_allocate(arena, task_size, (void**)&task));
+    memcpy(task, node->task, task_size);
+    node_tasks[node->index] = task;
+  }
+
+  iree_task_list_t root_tasks;
+  iree_task_list_initialize(&root_tasks);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_task_command_buffer_build_dag(
+              command_buffer, node_tasks, arena, &root_tasks, leaf_tasks));
+
+  // Chain the retire task onto the leaf tasks as their completion indicates
+  // that all commands have completed.
+  for (iree_host_size_t i = 0; i < leaf_task_count; ++i) {
+    iree_task_set_completion_task(leaf_tasks[i], retire_task);
+  }
+
+  // Enqueue all root tasks that are ready to run immediately. The instance is
+  // owned by the submission and the arena outlives its execution.
+  iree_task_submission_enqueue_list(pending_submission, &root_tasks);
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
 iree_status_t iree_hal_task_command_buffer_issue(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_task_queue_state_t* queue_state, iree_task_t* retire_task,
@@ -359,27 +795,22 @@ iree_status_t iree_hal_task_command_buffer_issue(
                                        &iree_hal_task_command_buffer_vtable);
   IREE_ASSERT_TRUE(command_buffer);
 
+  if (!iree_all_bits_set(command_buffer->base.mode,
+                         IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT)) {
+    return iree_hal_task_command_buffer_issue_instance(
+        command_buffer, retire_task, arena, pending_submission);
+  }
+
   // If the command buffer is empty (valid!) then we are a no-op.
   bool has_root_tasks = !iree_task_list_is_empty(&command_buffer->root_tasks);
   if (!has_root_tasks) {
     return iree_ok_status();
   }
 
-  bool has_leaf_tasks = !iree_task_list_is_empty(&command_buffer->leaf_tasks);
-  if (has_leaf_tasks) {
-    // Chain the retire task onto the leaf tasks as their completion indicates
-    // that all commands have completed.
-    for (iree_task_t* task = command_buffer->leaf_tasks.head; task != NULL;
-         task = task->next_task) {
-      iree_task_set_completion_task(task, retire_task);
-    }
-  } else {
-    // If we have no leaf tasks it means that this is a single layer DAG and
-    // after the root tasks complete the entire command buffer has completed.
-    for (iree_task_t* task = command_buffer->root_tasks.head; task != NULL;
-         task = task->next_task) {
-      iree_task_set_completion_task(task, retire_task);
-    }
+  // Chain the retire task onto the leaf tasks as their completion indicates
+  // that all commands have completed.
+  for (iree_host_size_t i = 0; i < command_buffer->leaf_task_count; ++i) {
+    iree_task_set_completion_task(command_buffer->leaf_tasks[i], retire_task);
   }
 
   // Enqueue all root tasks that are ready to run immediately.
@@ -387,7 +818,8 @@ iree_status_t iree_hal_task_command_buffer_issue(
   // we need to ensure the command buffer doesn't try to discard them.
   iree_task_submission_enqueue_list(pending_submission,
                                     &command_buffer->root_tasks);
-  iree_task_list_initialize(&command_buffer->leaf_tasks);
+  command_buffer->leaf_task_count = 0;
+  command_buffer->leaf_tasks = NULL;
 
   return iree_ok_status();
 }
@@ -424,20 +856,52 @@ static iree_status_t iree_hal_task_command_buffer_execution_barrier(
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
 
-  // TODO(benvanik): actual DAG construction. Right now we are just doing simple
-  // global barriers each time and forcing a join-fork point.
-  return iree_hal_task_command_buffer_emit_global_barrier(command_buffer);
+  // Commands recorded after this point will be ordered after those recorded
+  // prior that they have hazards with. The memory and buffer barriers are not
+  // needed as we track the ranges each command accesses ourselves.
+  ++command_buffer->state.segment;
+  return iree_ok_status();
 }
 
 //===----------------------------------------------------------------------===//
 // iree_hal_command_buffer_signal_event
 //===----------------------------------------------------------------------===//
 
+// Returns the record of |event| within the command buffer or NULL if it has not
+// been signaled during recording.
+static iree_hal_task_event_record_t* iree_hal_task_command_buffer_find_event(
+    iree_hal_task_command_buffer_t* command_buffer,
+    const iree_hal_event_t* event) {
+  for (iree_hal_task_event_record_t* record = command_buffer->state.event_head;
+       record != NULL; record = record->next) {
+    if (record->event == event) return record;
+  }
+  return NULL;
+}
+
 static iree_status_t iree_hal_task_command_buffer_signal_event(
     iree_hal_command_buffer_t* base_command_buffer, iree_hal_event_t* event,
     iree_hal_execution_stage_t source_stage_mask) {
-  // TODO(#4518): implement events. For now we just insert global barriers.
-  return iree_ok_status();
+  iree_hal_task_command_buffer_t* command_buffer =
+      iree_hal_task_command_buffer_cast(base_command_buffer);
+
+  iree_hal_task_event_record_t* record =
+      iree_hal_task_command_buffer_find_event(command_buffer, event);
+  if (!record) {
+    IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
+        command_buffer->resource_set, 1, &event));
+    IREE_RETURN_IF_ERROR(iree_arena_allocate(
+        &command_buffer->arena, sizeof(*record), (void**)&record));
+    record->next = command_buffer->state.event_head;
+    record->event = event;
+    command_buffer->state.event_head = record;
+  }
+
+  // The event is signaled once everything recorded so far has completed. We
+  // don't differentiate between execution stages as all commands execute to
+  // completion on the CPU.
+  return iree_hal_task_command_buffer_append_join_node(command_buffer,
+                                                       &record->signal_node);
 }
 
 //===----------------------------------------------------------------------===//
@@ -447,7 +911,11 @@ static iree_status_t iree_hal_task_command_buffer_signal_event(
 static iree_status_t iree_hal_task_command_buffer_reset_event(
     iree_hal_command_buffer_t* base_command_buffer, iree_hal_event_t* event,
     iree_hal_execution_stage_t source_stage_mask) {
-  // TODO(#4518): implement events. For now we just insert global barriers.
+  iree_hal_task_command_buffer_t* command_buffer =
+      iree_hal_task_command_buffer_cast(base_command_buffer);
+  iree_hal_task_event_record_t* record =
+      iree_hal_task_command_buffer_find_event(command_buffer, event);
+  if (record) record->signal_node = NULL;
   return iree_ok_status();
 }
 
@@ -466,8 +934,47 @@ static iree_status_t iree_hal_task_command_buffer_wait_events(
     const iree_hal_buffer_barrier_t* buffer_barriers) {
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
-  // TODO(#4518): implement events. For now we just insert global barriers.
-  return iree_hal_task_command_buffer_emit_global_barrier(command_buffer);
+
+  // Events must be signaled within this command buffer prior to the wait.
+  // Events signaled by other command buffers are not supported: command
+  // buffers in a submission are issued concurrently and a wait here would not
+  // be ordered after their signals. Cross-command-buffer ordering must use
+  // semaphores between submissions.
+  for (iree_host_size_t i = 0; i < event_count; ++i) {
+    iree_hal_task_event_record_t* record =
+        iree_hal_task_command_buffer_find_event(command_buffer, events[i]);
+    if (IREE_UNLIKELY(!record)) {
+      return iree_make_status(
+          IREE_STATUS_UNIMPLEMENTED,
+          "waits on events not signaled within the same command buffer are "
+          "not supported; use semaphores to order work across command "
+          "buffers");
+    } else if (IREE_UNLIKELY(!record->signal_node)) {
+      return iree_make_status(
+          IREE_STATUS_FAILED_PRECONDITION,
+          "event was reset and not signaled again prior to the wait");
+    }
+  }
+
+  // Join all of the signals along with any prior wait such that commands
+  // recorded after this point need only a single edge to be ordered after
+  // all of them. Commands recorded between the signals and this wait are not
+  // joined and may still be executing when the commands after it begin.
+  iree_hal_task_command_node_t* wait_node = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_task_command_buffer_append_nop_node(command_buffer, &wait_node));
+  if (command_buffer->state.wait_node) {
+    IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_add_edge(
+        command_buffer, command_buffer->state.wait_node, wait_node));
+  }
+  for (iree_host_size_t i = 0; i < event_count; ++i) {
+    iree_hal_task_event_record_t* record =
+        iree_hal_task_command_buffer_find_event(command_buffer, events[i]);
+    IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_add_edge(
+        command_buffer, record->signal_node, wait_node));
+  }
+  command_buffer->state.wait_node = wait_node;
+  return iree_ok_status();
 }
 
 //===----------------------------------------------------------------------===//
@@ -482,24 +989,73 @@ static iree_status_t iree_hal_task_command_buffer_discard_buffer(
 //===----------------------------------------------------------------------===//
 // iree_hal_command_buffer_fill_buffer
 //===----------------------------------------------------------------------===//
-// NOTE: for large copies we dispatch this as tiles for parallelism.
-// We'd want to do some measurement for when it's worth it; filling a 200KB
-// buffer: maybe not, filling a 200MB buffer: yeah. For now we just do
-// arbitrarily sized chunks.
-
-// TODO(benvanik): make this a configurable setting. Must be aligned to pattern
-// length so pick a power of two.
-#define IREE_HAL_CMD_FILL_SLICE_LENGTH (128 * 1024)
+// NOTE: for large fills we dispatch this as tiles for parallelism; see the
+// transfer tiling section above for how the tiles are sized.
 
 typedef struct iree_hal_cmd_fill_buffer_t {
   iree_task_dispatch_t task;
   iree_hal_buffer_t* target_buffer;
   iree_device_size_t target_offset;
   iree_device_size_t length;
-  uint32_t pattern_length;
-  uint8_t pattern[8];
+  // Fill pattern replicated to 32 bits (1 and 2 byte patterns are repeated).
+  uint32_t pattern;
+  // True to write the target with non-temporal stores.
+  bool non_temporal;
 } iree_hal_cmd_fill_buffer_t;
 
+// Fills |length| bytes of |data| with the replicated 32-bit |pattern|.
+// |data| must start at a multiple of the original pattern length from the
+// start of the fill.
+static void iree_hal_cmd_fill_bytes(uint8_t* data, iree_host_size_t length,
+                                    uint32_t pattern, bool non_temporal) {
+  uint8_t pattern_bytes[4];
+  memcpy(pattern_bytes, &pattern, sizeof(pattern_bytes));
+  bool is_splat = pattern_bytes[0] == pattern_bytes[1] &&
+                  pattern_bytes[0] == pattern_bytes[2] &&
+                  pattern_bytes[0] == pattern_bytes[3];
+  if (is_splat && !non_temporal) {
+    memset(data, pattern_bytes[0], length);
+    return;
+  }
+
+  iree_host_size_t offset = 0;
+#if defined(IREE_HAL_CMD_TRANSFER_SSE2)
+  // Non-temporal stores must be aligned so write the unaligned head normally.
+  iree_host_size_t head_length =
+      non_temporal ? iree_min(length, (16 - ((uintptr_t)data & 15)) & 15) : 0;
+  for (; offset < head_length; ++offset) {
+    data[offset] = pattern_bytes[offset & 3];
+  }
+  // Rotate the pattern such that it starts at the current phase.
+  uint8_t phase_bytes[4];
+  for (int i = 0; i < 4; ++i) phase_bytes[i] = pattern_bytes[(offset + i) & 3];
+  int32_t phase_pattern = 0;
+  memcpy(&phase_pattern, phase_bytes, sizeof(phase_pattern));
+  __m128i value = _mm_set1_epi32(phase_pattern);
+  iree_host_size_t body_end =
+      offset + ((length - offset) & ~(iree_host_size_t)15);
+  if (non_temporal) {
+    for (; offset < body_end; offset += 16) {
+      _mm_stream_si128((__m128i*)(data + offset), value);
+    }
+    _mm_sfence();
+  } else {
+    for (; offset < body_end; offset += 16) {
+      _mm_storeu_si128((__m128i*)(data + offset), value);
+    }
+  }
+#else
+  // Compilers vectorize this into the widest stores available.
+  uint64_t pattern64 = ((uint64_t)pattern << 32) | pattern;
+  for (; offset + sizeof(pattern64) <= length; offset += sizeof(pattern64)) {
+    memcpy(data + offset, &pattern64, sizeof(pattern64));
+  }
+#endif  // IREE_HAL_CMD_TRANSFER_SSE2
+  for (; offset < length; ++offset) {
+    data[offset] = pattern_bytes[offset & 3];
+  }
+}
+
 static iree_status_t iree_hal_cmd_fill_tile(
     void* user_context, const iree_task_tile_context_t* tile_context,
     iree_task_submission_t* pending_submission) {
@@ -509,15 +1065,25 @@ static iree_status_t iree_hal_cmd_fill_tile(
 
   uint32_t length_per_slice = tile_context->workgroup_size[0];
   iree_device_size_t slice_offset =
-      tile_context->workgroup_xyz[0] * length_per_slice;
+      (iree_device_size_t)tile_context->workgroup_xyz[0] * length_per_slice;
   iree_device_size_t remaining_length = cmd->length - slice_offset;
   iree_device_size_t slice_length =
       iree_min(length_per_slice, remaining_length);
   IREE_TRACE_ZONE_APPEND_VALUE(z0, (uint64_t)slice_length);
 
-  iree_status_t status = iree_hal_buffer_fill(
-      cmd->target_buffer, cmd->target_offset + slice_offset, slice_length,
-      cmd->pattern, cmd->pattern_length);
+  // Slices start at a multiple of the (power of two) slice length and thus at
+  // the start of the fill pattern.
+  iree_hal_buffer_mapping_t target_mapping;
+  iree_status_t status = iree_hal_buffer_map_range(
+      cmd->target_buffer, IREE_HAL_MAPPING_MODE_SCOPED,
+      IREE_HAL_MEMORY_ACCESS_WRITE, cmd->target_offset + slice_offset,
+      slice_length, &target_mapping);
+  if (iree_status_is_ok(status)) {
+    iree_hal_cmd_fill_bytes(target_mapping.contents.data,
+                            target_mapping.contents.data_length, cmd->pattern,
+                            cmd->non_temporal);
+    status = iree_hal_buffer_unmap_range(&target_mapping);
+  }
 
   IREE_TRACE_ZONE_END(z0);
   return status;
@@ -531,6 +1097,27 @@ static iree_status_t iree_hal_task_command_buffer_fill_buffer(
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
 
+  uint32_t pattern_bits = 0;
+  switch (pattern_length) {
+    case 1:
+      pattern_bits = *(const uint8_t*)pattern * 0x01010101u;
+      break;
+    case 2: {
+      uint16_t pattern_16 = 0;
+      memcpy(&pattern_16, pattern, sizeof(pattern_16));
+      memcpy(&pattern_bits, &pattern_16, sizeof(pattern_16));
+      memcpy((uint8_t*)&pattern_bits + 2, &pattern_16, sizeof(pattern_16));
+      break;
+    }
+    case 4:
+      memcpy(&pattern_bits, pattern, sizeof(pattern_bits));
+      break;
+    default:
+      return iree_make_status(
+          IREE_STATUS_INVALID_ARGUMENT,
+          "fill patterns must be 1, 2, or 4 bytes (got %zu)", pattern_length);
+  }
+
   IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
       command_buffer->resource_set, 1, &target_buffer));
 
@@ -539,12 +1126,13 @@ static iree_status_t iree_hal_task_command_buffer_fill_buffer(
       iree_arena_allocate(&command_buffer->arena, sizeof(*cmd), (void**)&cmd));
 
   const uint32_t workgroup_size[3] = {
-      /*x=*/IREE_HAL_CMD_FILL_SLICE_LENGTH,
+      /*x=*/command_buffer->transfer_slice_length,
       /*y=*/1,
       /*z=*/1,
   };
   const uint32_t workgroup_count[3] = {
-      /*x=*/length / workgroup_size[0] + 1,
+      /*x=*/iree_hal_task_command_buffer_transfer_slice_count(
+          length, command_buffer->transfer_slice_length),
       /*y=*/1,
       /*z=*/1,
   };
@@ -555,11 +1143,13 @@ static iree_status_t iree_hal_task_command_buffer_fill_buffer(
   cmd->target_buffer = target_buffer;
   cmd->target_offset = target_offset;
   cmd->length = length;
-  memcpy(cmd->pattern, pattern, pattern_length);
-  cmd->pattern_length = pattern_length;
+  cmd->pattern = pattern_bits;
+  cmd->non_temporal = length >= IREE_HAL_CMD_TRANSFER_NON_TEMPORAL_THRESHOLD;
 
-  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
-                                                          &cmd->task.header);
+  iree_hal_task_buffer_access_t access = iree_hal_task_make_buffer_access(
+      target_buffer, target_offset, length, /*is_write=*/true);
+  return iree_hal_task_command_buffer_emit_execution_task(
+      command_buffer, &cmd->task.header, 1, &access);
 }
 
 //===----------------------------------------------------------------------===//
@@ -614,21 +1204,17 @@ static iree_status_t iree_hal_task_command_buffer_update_buffer(
   memcpy(cmd->source_buffer, (const uint8_t*)source_buffer + source_offset,
          cmd->length);
 
-  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
-                                                          &cmd->task.header);
+  iree_hal_task_buffer_access_t access = iree_hal_task_make_buffer_access(
+      target_buffer, target_offset, length, /*is_write=*/true);
+  return iree_hal_task_command_buffer_emit_execution_task(
+      command_buffer, &cmd->task.header, 1, &access);
 }
 
 //===----------------------------------------------------------------------===//
 // iree_hal_command_buffer_copy_buffer
 //===----------------------------------------------------------------------===//
-// NOTE: for large copies we dispatch this as tiles for parallelism.
-// We'd want to do some measurement for when it's worth it; copying a 200KB
-// buffer: maybe not, copying a 200MB buffer: yeah. For now we just do
-// arbitrarily sized chunks.
-
-// TODO(benvanik): make this a configurable setting. Must be aligned to pattern
-// length so pick a power of two.
-#define IREE_HAL_CMD_COPY_SLICE_LENGTH (128 * 1024)
+// NOTE: for large copies we dispatch this as tiles for parallelism; see the
+// transfer tiling section above for how the tiles are sized.
 
 typedef struct iree_hal_cmd_copy_buffer_t {
   iree_task_dispatch_t task;
@@ -637,8 +1223,34 @@ typedef struct iree_hal_cmd_copy_buffer_t {
   iree_hal_buffer_t* target_buffer;
   iree_device_size_t target_offset;
   iree_device_size_t length;
+  // True to write the target with non-temporal stores.
+  bool non_temporal;
 } iree_hal_cmd_copy_buffer_t;
 
+// Copies |length| bytes from |source| to the non-overlapping |target|.
+static void iree_hal_cmd_copy_bytes(const uint8_t* source, uint8_t* target,
+                                    iree_host_size_t length,
+                                    bool non_temporal) {
+#if defined(IREE_HAL_CMD_TRANSFER_SSE2)
+  if (non_temporal) {
+    // Non-temporal stores must be aligned so copy the unaligned head normally.
+    iree_host_size_t offset =
+        iree_min(length, (16 - ((uintptr_t)target & 15)) & 15);
+    memcpy(target, source, offset);
+    iree_host_size_t body_end =
+        offset + ((length - offset) & ~(iree_host_size_t)15);
+    for (; offset < body_end; offset += 16) {
+      __m128i value = _mm_loadu_si128((const __m128i*)(source + offset));
+      _mm_stream_si128((__m128i*)(target + offset), value);
+    }
+    _mm_sfence();
+    memcpy(target + offset, source + offset, length - offset);
+    return;
+  }
+#endif  // IREE_HAL_CMD_TRANSFER_SSE2
+  memcpy(target, source, length);
+}
+
 static iree_status_t iree_hal_cmd_copy_tile(
     void* user_context, const iree_task_tile_context_t* tile_context,
     iree_task_submission_t* pending_submission) {
@@ -648,15 +1260,33 @@ static iree_status_t iree_hal_cmd_copy_tile(
 
   uint32_t length_per_slice = tile_context->workgroup_size[0];
   iree_device_size_t slice_offset =
-      tile_context->workgroup_xyz[0] * length_per_slice;
+      (iree_device_size_t)tile_context->workgroup_xyz[0] * length_per_slice;
   iree_device_size_t remaining_length = cmd->length - slice_offset;
   iree_device_size_t slice_length =
       iree_min(length_per_slice, remaining_length);
   IREE_TRACE_ZONE_APPEND_VALUE(z0, (uint64_t)slice_length);
 
-  iree_status_t status = iree_hal_buffer_copy_data(
-      cmd->source_buffer, cmd->source_offset + slice_offset, cmd->target_buffer,
-      cmd->target_offset + slice_offset, slice_length);
+  iree_hal_buffer_mapping_t source_mapping;
+  iree_status_t status = iree_hal_buffer_map_range(
+      cmd->source_buffer, IREE_HAL_MAPPING_MODE_SCOPED,
+      IREE_HAL_MEMORY_ACCESS_READ, cmd->source_offset + slice_offset,
+      slice_length, &source_mapping);
+  if (iree_status_is_ok(status)) {
+    iree_hal_buffer_mapping_t target_mapping;
+    status = iree_hal_buffer_map_range(
+        cmd->target_buffer, IREE_HAL_MAPPING_MODE_SCOPED,
+        IREE_HAL_MEMORY_ACCESS_WRITE, cmd->target_offset + slice_offset,
+        slice_length, &target_mapping);
+    if (iree_status_is_ok(status)) {
+      iree_hal_cmd_copy_bytes(source_mapping.contents.data,
+                              target_mapping.contents.data,
+                              target_mapping.contents.data_length,
+                              cmd->non_temporal);
+      status = iree_hal_buffer_unmap_range(&target_mapping);
+    }
+    status =
+        iree_status_join(status, iree_hal_buffer_unmap_range(&source_mapping));
+  }
 
   IREE_TRACE_ZONE_END(z0);
   return status;
@@ -679,12 +1309,13 @@ static iree_status_t iree_hal_task_command_buffer_copy_buffer(
       iree_arena_allocate(&command_buffer->arena, sizeof(*cmd), (void**)&cmd));
 
   const uint32_t workgroup_size[3] = {
-      /*x=*/IREE_HAL_CMD_COPY_SLICE_LENGTH,
+      /*x=*/command_buffer->transfer_slice_length,
       /*y=*/1,
       /*z=*/1,
   };
   const uint32_t workgroup_count[3] = {
-      /*x=*/length / workgroup_size[0] + 1,
+      /*x=*/iree_hal_task_command_buffer_transfer_slice_count(
+          length, command_buffer->transfer_slice_length),
       /*y=*/1,
       /*z=*/1,
   };
@@ -697,9 +1328,16 @@ static iree_status_t iree_hal_task_command_buffer_copy_buffer(
   cmd->target_buffer = target_buffer;
   cmd->target_offset = target_offset;
   cmd->length = length;
+  cmd->non_temporal = length >= IREE_HAL_CMD_TRANSFER_NON_TEMPORAL_THRESHOLD;
 
-  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
-                                                          &cmd->task.header);
+  iree_hal_task_buffer_access_t accesses[2] = {
+      iree_hal_task_make_buffer_access(source_buffer, source_offset, length,
+                                       /*is_write=*/false),
+      iree_hal_task_make_buffer_access(target_buffer, target_offset, length,
+                                       /*is_write=*/true),
+  };
+  return iree_hal_task_command_buffer_emit_execution_task(
+      command_buffer, &cmd->task.header, IREE_ARRAYSIZE(accesses), accesses);
 }
 
 //===----------------------------------------------------------------------===//
@@ -769,6 +1407,12 @@ static iree_status_t iree_hal_task_command_buffer_push_descriptor_set(
         buffer_mapping.contents.data;
     command_buffer->state.binding_lengths[binding_ordinal] =
         buffer_mapping.contents.data_length;
+    // Dispatches may or may not write to the binding depending on the
+    // executable layout; that's decided when they are recorded.
+    command_buffer->state.binding_accesses[binding_ordinal] =
+        iree_hal_task_make_buffer_access(
+            bindings[i].buffer, bindings[i].offset,
+            buffer_mapping.contents.data_length, /*is_write=*/true);
   }
 
   return iree_ok_status();
@@ -857,6 +1501,7 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_executable_t* executable, int32_t entry_point,
     uint32_t workgroup_x, uint32_t workgroup_y, uint32_t workgroup_z,
+    const iree_hal_task_buffer_access_t* workgroups_access,
     iree_hal_cmd_dispatch_t** out_cmd) {
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
@@ -867,6 +1512,8 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
       local_executable->executable_layouts[entry_point];
   iree_host_size_t push_constant_count = local_layout->push_constants;
   iree_hal_local_binding_mask_t used_binding_mask = local_layout->used_bindings;
+  iree_hal_local_binding_mask_t read_only_binding_mask =
+      local_layout->read_only_bindings;
   iree_host_size_t used_binding_count =
       iree_math_count_ones_u64(used_binding_mask);
 
@@ -906,6 +1553,8 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
           ? local_executable->dispatch_attrs[entry_point].local_memory_pages *
                 IREE_HAL_WORKGROUP_LOCAL_MEMORY_PAGE_SIZE
           : 0;
+  iree_task_executor_reserve_worker_local_memory(command_buffer->executor,
+                                                 cmd->task.local_memory_size);
 
   // Copy only the push constant range used by the executable.
   uint8_t* cmd_ptr = (uint8_t*)cmd + sizeof(*cmd);
@@ -926,6 +1575,12 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
   cmd_ptr += used_binding_count * sizeof(*binding_ptrs);
   size_t* binding_lengths = (size_t*)cmd_ptr;
   cmd_ptr += used_binding_count * sizeof(*binding_lengths);
+
+  // Gather the buffer ranges the dispatch accesses for hazard tracking. Uniform
+  // buffers are read-only and anything else may be written.
+  iree_hal_task_buffer_access_t accesses[IREE_HAL_LOCAL_BINDING_MASK_BITS + 1];
+  iree_host_size_t access_count = 0;
+
   iree_host_size_t binding_base = 0;
   for (iree_host_size_t i = 0; i < used_binding_count; ++i) {
     int mask_offset = iree_math_count_trailing_zeros_u64(used_binding_mask);
@@ -938,11 +1593,19 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
       return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
                               "(flat) binding %d is NULL", binding_ordinal);
     }
+    accesses[access_count] =
+        command_buffer->state.binding_accesses[binding_ordinal];
+    accesses[access_count].is_write =
+        !(read_only_binding_mask & (1ull << binding_ordinal));
+    ++access_count;
+  }
+  if (workgroups_access) {
+    accesses[access_count++] = *workgroups_access;
   }
 
   *out_cmd = cmd;
-  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
-                                                          &cmd->task.header);
+  return iree_hal_task_command_buffer_emit_execution_task(
+      command_buffer, &cmd->task.header, access_count, accesses);
 }
 
 static iree_status_t iree_hal_task_command_buffer_dispatch(
@@ -956,7 +1619,7 @@ static iree_status_t iree_hal_task_command_buffer_dispatch(
   iree_hal_cmd_dispatch_t* cmd = NULL;
   return iree_hal_task_command_buffer_build_dispatch(
       base_command_buffer, executable, entry_point, workgroup_x, workgroup_y,
-      workgroup_z, &cmd);
+      workgroup_z, /*workgroups_access=*/NULL, &cmd);
 }
 
 static iree_status_t iree_hal_task_command_buffer_dispatch_indirect(
@@ -978,9 +1641,16 @@ static iree_status_t iree_hal_task_command_buffer_dispatch_indirect(
       IREE_HAL_MEMORY_ACCESS_READ, workgroups_offset, 3 * sizeof(uint32_t),
       &buffer_mapping));
 
+  // The workgroup count is read when the dispatch begins executing.
+  iree_hal_task_buffer_access_t workgroups_access =
+      iree_hal_task_make_buffer_access(workgroups_buffer, workgroups_offset,
+                                       3 * sizeof(uint32_t),
+                                       /*is_write=*/false);
+
   iree_hal_cmd_dispatch_t* cmd = NULL;
   IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_build_dispatch(
-      base_command_buffer, executable, entry_point, 0, 0, 0, &cmd));
+      base_command_buffer, executable, entry_point, 0, 0, 0,
+      &workgroups_access, &cmd));
   cmd->task.workgroup_count.ptr = (const uint32_t*)buffer_mapping.contents.data;
   cmd->task.header.flags |= IREE_TASK_FLAG_DISPATCH_INDIRECT;
   return iree_ok_status();
@@ -11,6 +11,7 @@
 #include "iree/base/internal/arena.h"
 #include "iree/hal/api.h"
 #include "iree/hal/local/task_queue_state.h"
+#include "iree/task/executor.h"
 #include "iree/task/scope.h"
 #include "iree/task/task.h"
 
@@ -18,8 +19,12 @@
 extern "C" {
 #endif  // __cplusplus
 
+// Creates a command buffer recording tasks into |scope|. Dispatches recorded
+// reserve their workgroup local memory requirements on |executor| so that
+// workers can grow their local memory ahead of execution.
 iree_status_t iree_hal_task_command_buffer_create(
-    iree_hal_device_t* device, iree_task_scope_t* scope,
+    iree_hal_device_t* device, iree_task_executor_t* executor,
+    iree_task_scope_t* scope,
     iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
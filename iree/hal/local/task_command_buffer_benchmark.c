@@ -0,0 +1,575 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stdint.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/flags.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/executable_library.h"
+#include "iree/hal/local/loaders/static_library_loader.h"
+#include "iree/hal/local/task_device.h"
+#include "iree/task/api.h"
+#include "iree/testing/benchmark.h"
+
+IREE_FLAG(int64_t, transfer_size, 256ll * 1024 * 1024,
+          "Size in bytes of the buffers filled/copied in each iteration.\n"
+          "Sizes above the non-temporal threshold (32MB) stream the stores.");
+IREE_FLAG(int32_t, barrier_dispatch_count, 16,
+          "Number of dispatches recorded in the barrier benchmarks, each\n"
+          "separated from the next by an execution barrier.");
+IREE_FLAG(int32_t, barrier_dispatch_duration_us, 1000,
+          "Duration in microseconds of each dispatch in the barrier\n"
+          "benchmarks.");
+
+typedef enum iree_hal_transfer_benchmark_op_e {
+  IREE_HAL_TRANSFER_BENCHMARK_OP_FILL = 0,
+  IREE_HAL_TRANSFER_BENCHMARK_OP_COPY,
+} iree_hal_transfer_benchmark_op_t;
+
+typedef struct iree_hal_transfer_benchmark_params_t {
+  iree_hal_transfer_benchmark_op_t op;
+  // True to execute the transfer with a command buffer on a task device and
+  // false to run it on the calling thread with memset/memcpy as a baseline.
+  bool use_device;
+} iree_hal_transfer_benchmark_params_t;
+
+// Allocates a mappable transfer buffer of |size| bytes from |device|.
+static iree_status_t iree_hal_transfer_benchmark_allocate(
+    iree_hal_device_t* device, iree_device_size_t size,
+    iree_hal_buffer_t** out_buffer) {
+  return iree_hal_allocator_allocate_buffer(
+      iree_hal_device_allocator(device),
+      IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+      IREE_HAL_BUFFER_USAGE_TRANSFER | IREE_HAL_BUFFER_USAGE_MAPPING, size,
+      iree_const_byte_span_empty(), out_buffer);
+}
+
+// Runs the baseline transfer on the calling thread.
+static iree_status_t iree_hal_transfer_benchmark_run_host(
+    const iree_hal_transfer_benchmark_params_t* params,
+    iree_hal_buffer_t* source_buffer, iree_hal_buffer_t* target_buffer,
+    iree_benchmark_state_t* benchmark_state, int64_t* out_iteration_count) {
+  iree_hal_buffer_mapping_t source_mapping;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_map_range(
+      source_buffer, IREE_HAL_MAPPING_MODE_SCOPED, IREE_HAL_MEMORY_ACCESS_READ,
+      0, IREE_WHOLE_BUFFER, &source_mapping));
+  iree_hal_buffer_mapping_t target_mapping;
+  iree_status_t status = iree_hal_buffer_map_range(
+      target_buffer, IREE_HAL_MAPPING_MODE_SCOPED,
+      IREE_HAL_MEMORY_ACCESS_WRITE, 0, IREE_WHOLE_BUFFER, &target_mapping);
+  if (!iree_status_is_ok(status)) {
+    iree_hal_buffer_unmap_range(&source_mapping);
+    return status;
+  }
+
+  int64_t iteration_count = 0;
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    if (params->op == IREE_HAL_TRANSFER_BENCHMARK_OP_FILL) {
+      memset(target_mapping.contents.data, 0xCD,
+             target_mapping.contents.data_length);
+    } else {
+      memcpy(target_mapping.contents.data, source_mapping.contents.data,
+             target_mapping.contents.data_length);
+    }
+    ++iteration_count;
+  }
+  *out_iteration_count = iteration_count;
+
+  iree_hal_buffer_unmap_range(&target_mapping);
+  iree_hal_buffer_unmap_range(&source_mapping);
+  return iree_ok_status();
+}
+
+// Records the transfer into a reusable command buffer once and then submits it
+// to the device each iteration, waiting for it to complete.
+static iree_status_t iree_hal_transfer_benchmark_run_device(
+    const iree_hal_transfer_benchmark_params_t* params,
+    iree_hal_device_t* device, iree_hal_buffer_t* source_buffer,
+    iree_hal_buffer_t* target_buffer, iree_benchmark_state_t* benchmark_state,
+    int64_t* out_iteration_count) {
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_command_buffer_create(
+      device, IREE_HAL_COMMAND_BUFFER_MODE_UNVALIDATED,
+      IREE_HAL_COMMAND_CATEGORY_TRANSFER, IREE_HAL_QUEUE_AFFINITY_ANY,
+      &command_buffer));
+  iree_status_t status = iree_hal_command_buffer_begin(command_buffer);
+  if (iree_status_is_ok(status)) {
+    if (params->op == IREE_HAL_TRANSFER_BENCHMARK_OP_FILL) {
+      // A non-splat pattern to exercise the vectorized pattern fill.
+      const uint32_t pattern = 0xCAFEF00Du;
+      status = iree_hal_command_buffer_fill_buffer(
+          command_buffer, target_buffer, 0,
+          iree_hal_buffer_byte_length(target_buffer), &pattern,
+          sizeof(pattern));
+    } else {
+      status = iree_hal_command_buffer_copy_buffer(
+          command_buffer, source_buffer, 0, target_buffer, 0,
+          iree_hal_buffer_byte_length(target_buffer));
+    }
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_command_buffer_end(command_buffer);
+  }
+
+  iree_hal_semaphore_t* semaphore = NULL;
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_semaphore_create(device, 0ull, &semaphore);
+  }
+
+  int64_t iteration_count = 0;
+  uint64_t signal_value = 0;
+  while (iree_status_is_ok(status) &&
+         iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    ++signal_value;
+    iree_hal_submission_batch_t batch = {
+        .wait_semaphores = {0, NULL, NULL},
+        .command_buffer_count = 1,
+        .command_buffers = &command_buffer,
+        .signal_semaphores = {1, &semaphore, &signal_value},
+    };
+    status = iree_hal_device_submit_and_wait(
+        device, IREE_HAL_COMMAND_CATEGORY_TRANSFER, IREE_HAL_QUEUE_AFFINITY_ANY,
+        1, &batch, semaphore, signal_value, iree_infinite_timeout());
+    ++iteration_count;
+  }
+  *out_iteration_count = iteration_count;
+
+  iree_hal_semaphore_release(semaphore);
+  iree_hal_command_buffer_release(command_buffer);
+  return status;
+}
+
+static iree_status_t iree_hal_transfer_benchmark_run(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  const iree_hal_transfer_benchmark_params_t* params =
+      (const iree_hal_transfer_benchmark_params_t*)benchmark_def->user_data;
+  iree_allocator_t host_allocator = benchmark_state->host_allocator;
+  if (FLAG_transfer_size <= 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "--transfer_size must be positive");
+  }
+  const iree_device_size_t size = (iree_device_size_t)FLAG_transfer_size;
+
+  // The baselines also allocate from the device so that both run against
+  // identically placed memory.
+  iree_task_executor_t* executor = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_task_executor_create_from_flags(host_allocator, &executor));
+  iree_hal_allocator_t* device_allocator = NULL;
+  iree_status_t status = iree_hal_allocator_create_heap(
+      iree_make_cstring_view("benchmark"), host_allocator, host_allocator,
+      &device_allocator);
+  iree_hal_device_t* device = NULL;
+  if (iree_status_is_ok(status)) {
+    iree_hal_task_device_params_t device_params;
+    iree_hal_task_device_params_initialize(&device_params);
+    status = iree_hal_task_device_create(
+        iree_make_cstring_view("benchmark"), &device_params,
+        /*executor_count=*/1, &executor, /*loader_count=*/0, /*loaders=*/NULL,
+        device_allocator, host_allocator, &device);
+  }
+
+  iree_hal_buffer_t* source_buffer = NULL;
+  iree_hal_buffer_t* target_buffer = NULL;
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_transfer_benchmark_allocate(device, size, &source_buffer);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_transfer_benchmark_allocate(device, size, &target_buffer);
+  }
+
+  // Fault in all pages ahead of time so the first iteration does not pay for
+  // them.
+  if (iree_status_is_ok(status)) {
+    const uint8_t zero = 0;
+    status = iree_hal_buffer_fill(source_buffer, 0, IREE_WHOLE_BUFFER, &zero,
+                                  sizeof(zero));
+  }
+  if (iree_status_is_ok(status)) {
+    const uint8_t zero = 0;
+    status = iree_hal_buffer_fill(target_buffer, 0, IREE_WHOLE_BUFFER, &zero,
+                                  sizeof(zero));
+  }
+
+  int64_t iteration_count = 0;
+  if (iree_status_is_ok(status)) {
+    if (params->use_device) {
+      status = iree_hal_transfer_benchmark_run_device(
+          params, device, source_buffer, target_buffer, benchmark_state,
+          &iteration_count);
+    } else {
+      status = iree_hal_transfer_benchmark_run_host(
+          params, source_buffer, target_buffer, benchmark_state,
+          &iteration_count);
+    }
+  }
+  if (iree_status_is_ok(status)) {
+    // Copies both read and write each byte but we report only the bytes
+    // produced so the numbers are comparable with memcpy bandwidth figures.
+    iree_benchmark_set_bytes_processed(benchmark_state,
+                                       iteration_count * (int64_t)size);
+  }
+
+  iree_hal_buffer_release(target_buffer);
+  iree_hal_buffer_release(source_buffer);
+  iree_hal_device_release(device);
+  iree_hal_allocator_release(device_allocator);
+  iree_task_executor_release(executor);
+  return status;
+}
+
+static void iree_hal_transfer_benchmark_register(
+    const char* name, iree_hal_transfer_benchmark_op_t op, bool use_device) {
+  // Leaked; benchmark definitions must outlive registration.
+  iree_hal_transfer_benchmark_params_t* params = NULL;
+  IREE_CHECK_OK(iree_allocator_malloc(iree_allocator_system(), sizeof(*params),
+                                      (void**)&params));
+  params->op = op;
+  params->use_device = use_device;
+  iree_benchmark_def_t benchmark_def = {
+      .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+               IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+      .time_unit = IREE_BENCHMARK_UNIT_MILLISECOND,
+      .minimum_duration_ns = 0,
+      .iteration_count = 0,
+      .run = iree_hal_transfer_benchmark_run,
+      .user_data = params,
+  };
+  iree_benchmark_register(iree_make_cstring_view(name), &benchmark_def);
+}
+
+//===----------------------------------------------------------------------===//
+// Barrier-separated dispatches
+//===----------------------------------------------------------------------===//
+// Records dispatches of a single workgroup each separated by an execution
+// barrier. When the dispatches write disjoint ranges the barriers carry no
+// hazards and the dispatches can execute concurrently; when they all write the
+// same range each one must wait for the one before it, as every dispatch would
+// if barriers joined all prior commands.
+
+// Busy-waits for push_constants[0] microseconds to model compute-bound work.
+static int iree_hal_barrier_benchmark_spin(
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    const iree_hal_vec3_t* workgroup_id, void* local_memory) {
+  iree_time_t deadline_ns =
+      iree_time_now() + dispatch_state->push_constants[0] * 1000ll;
+  while (iree_time_now() < deadline_ns) {
+  }
+  ((uint32_t*)dispatch_state->binding_ptrs[0])[0] = workgroup_id->x;
+  return 0;
+}
+
+static bool iree_hal_barrier_benchmark_never(void* arg) { return false; }
+
+// Blocks for push_constants[0] microseconds without using the CPU to model
+// work bound by latency (such as waiting on memory or another device).
+static int iree_hal_barrier_benchmark_sleep(
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    const iree_hal_vec3_t* workgroup_id, void* local_memory) {
+  iree_time_t deadline_ns =
+      iree_time_now() + dispatch_state->push_constants[0] * 1000ll;
+  iree_notification_t notification;
+  iree_notification_initialize(&notification);
+  iree_notification_await_until(&notification,
+                                iree_hal_barrier_benchmark_never, NULL,
+                                deadline_ns);
+  iree_notification_deinitialize(&notification);
+  ((uint32_t*)dispatch_state->binding_ptrs[0])[0] = workgroup_id->x;
+  return 0;
+}
+
+static const iree_hal_executable_library_header_t
+    iree_hal_barrier_benchmark_library_header = {
+        .version = IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION,
+        .name = "task_command_buffer_benchmark",
+        .features = IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_NONE,
+        .sanitizer = IREE_HAL_EXECUTABLE_LIBRARY_SANITIZER_NONE,
+};
+static const iree_hal_executable_dispatch_v0_t
+    iree_hal_barrier_benchmark_entry_points[2] = {
+        iree_hal_barrier_benchmark_spin,
+        iree_hal_barrier_benchmark_sleep,
+};
+static const char* iree_hal_barrier_benchmark_entry_point_names[2] = {
+    "spin",
+    "sleep",
+};
+static const iree_hal_executable_library_v0_t
+    iree_hal_barrier_benchmark_library = {
+        .header = &iree_hal_barrier_benchmark_library_header,
+        .imports = {.count = 0, .symbols = NULL},
+        .exports =
+            {
+                .count = 2,
+                .ptrs = iree_hal_barrier_benchmark_entry_points,
+                .attrs = NULL,
+                .names = iree_hal_barrier_benchmark_entry_point_names,
+                .tags = NULL,
+            },
+};
+
+static const iree_hal_executable_library_header_t**
+iree_hal_barrier_benchmark_library_query(
+    iree_hal_executable_library_version_t max_version, void* reserved) {
+  return max_version >= IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION
+             ? (const iree_hal_executable_library_header_t**)&
+                   iree_hal_barrier_benchmark_library
+             : NULL;
+}
+
+typedef struct iree_hal_barrier_benchmark_params_t {
+  // Entry point ordinal in iree_hal_barrier_benchmark_library.
+  uint32_t entry_point;
+  // True if each dispatch writes its own range and false if all dispatches
+  // write the same range.
+  bool independent;
+} iree_hal_barrier_benchmark_params_t;
+
+// Records the barrier-separated dispatches into |command_buffer|.
+static iree_status_t iree_hal_barrier_benchmark_record(
+    const iree_hal_barrier_benchmark_params_t* params,
+    iree_hal_executable_t* executable,
+    iree_hal_executable_layout_t* executable_layout, iree_hal_buffer_t* buffer,
+    iree_hal_command_buffer_t* command_buffer) {
+  // Ranges are kept on separate cache lines to avoid false sharing.
+  const iree_device_size_t range_size = 64;
+  const uint32_t duration_us = (uint32_t)FLAG_barrier_dispatch_duration_us;
+  IREE_RETURN_IF_ERROR(iree_hal_command_buffer_begin(command_buffer));
+  IREE_RETURN_IF_ERROR(iree_hal_command_buffer_push_constants(
+      command_buffer, executable_layout, 0, &duration_us,
+      sizeof(duration_us)));
+  for (int32_t i = 0; i < FLAG_barrier_dispatch_count; ++i) {
+    iree_hal_descriptor_set_binding_t binding = {
+        .binding = 0,
+        .buffer = buffer,
+        .offset = params->independent ? i * range_size : 0,
+        .length = range_size,
+    };
+    IREE_RETURN_IF_ERROR(iree_hal_command_buffer_push_descriptor_set(
+        command_buffer, executable_layout, /*set=*/0, 1, &binding));
+    IREE_RETURN_IF_ERROR(iree_hal_command_buffer_dispatch(
+        command_buffer, executable, params->entry_point, 1, 1, 1));
+    IREE_RETURN_IF_ERROR(iree_hal_command_buffer_execution_barrier(
+        command_buffer, IREE_HAL_EXECUTION_STAGE_DISPATCH,
+        IREE_HAL_EXECUTION_STAGE_DISPATCH,
+        IREE_HAL_EXECUTION_BARRIER_FLAG_NONE, 0, NULL, 0, NULL));
+  }
+  return iree_hal_command_buffer_end(command_buffer);
+}
+
+// Prepares the benchmark executable on |device| and submits the recorded
+// dispatches each iteration, waiting for them to complete.
+static iree_status_t iree_hal_barrier_benchmark_run_device(
+    const iree_hal_barrier_benchmark_params_t* params,
+    iree_hal_device_t* device, iree_benchmark_state_t* benchmark_state,
+    int64_t* out_iteration_count) {
+  iree_hal_executable_cache_t* executable_cache = NULL;
+  iree_hal_descriptor_set_layout_t* set_layout = NULL;
+  iree_hal_executable_layout_t* executable_layout = NULL;
+  iree_hal_executable_t* executable = NULL;
+  iree_hal_buffer_t* buffer = NULL;
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  iree_hal_semaphore_t* semaphore = NULL;
+
+  iree_status_t status = iree_hal_executable_cache_create(
+      device, iree_make_cstring_view("benchmark"), &executable_cache);
+  if (iree_status_is_ok(status)) {
+    const iree_hal_descriptor_set_layout_binding_t binding = {
+        0, IREE_HAL_DESCRIPTOR_TYPE_STORAGE_BUFFER};
+    status = iree_hal_descriptor_set_layout_create(
+        device, IREE_HAL_DESCRIPTOR_SET_LAYOUT_USAGE_TYPE_PUSH_ONLY, 1,
+        &binding, &set_layout);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_executable_layout_create(
+        device, /*push_constants=*/1, /*set_layout_count=*/1, &set_layout,
+        &executable_layout);
+  }
+  if (iree_status_is_ok(status)) {
+    iree_hal_executable_spec_t executable_spec;
+    iree_hal_executable_spec_initialize(&executable_spec);
+    executable_spec.caching_mode =
+        IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA;
+    executable_spec.executable_format = iree_make_cstring_view("static");
+    executable_spec.executable_data = iree_make_const_byte_span(
+        iree_hal_barrier_benchmark_library_header.name,
+        strlen(iree_hal_barrier_benchmark_library_header.name));
+    // Both entry points share the same layout.
+    iree_hal_executable_layout_t* executable_layouts[2] = {
+        executable_layout,
+        executable_layout,
+    };
+    executable_spec.executable_layout_count =
+        IREE_ARRAYSIZE(executable_layouts);
+    executable_spec.executable_layouts = executable_layouts;
+    status = iree_hal_executable_cache_prepare_executable(
+        executable_cache, &executable_spec, &executable);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_allocator_allocate_buffer(
+        iree_hal_device_allocator(device),
+        IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_DISPATCH,
+        (iree_device_size_t)FLAG_barrier_dispatch_count * 64,
+        iree_const_byte_span_empty(), &buffer);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_command_buffer_create(
+        device, IREE_HAL_COMMAND_BUFFER_MODE_UNVALIDATED,
+        IREE_HAL_COMMAND_CATEGORY_DISPATCH, IREE_HAL_QUEUE_AFFINITY_ANY,
+        &command_buffer);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_barrier_benchmark_record(
+        params, executable, executable_layout, buffer, command_buffer);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_semaphore_create(device, 0ull, &semaphore);
+  }
+
+  int64_t iteration_count = 0;
+  uint64_t signal_value = 0;
+  while (iree_status_is_ok(status) &&
+         iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    ++signal_value;
+    iree_hal_submission_batch_t batch = {
+        .wait_semaphores = {0, NULL, NULL},
+        .command_buffer_count = 1,
+        .command_buffers = &command_buffer,
+        .signal_semaphores = {1, &semaphore, &signal_value},
+    };
+    status = iree_hal_device_submit_and_wait(
+        device, IREE_HAL_COMMAND_CATEGORY_DISPATCH, IREE_HAL_QUEUE_AFFINITY_ANY,
+        1, &batch, semaphore, signal_value, iree_infinite_timeout());
+    ++iteration_count;
+  }
+  *out_iteration_count = iteration_count;
+
+  iree_hal_semaphore_release(semaphore);
+  iree_hal_command_buffer_release(command_buffer);
+  iree_hal_buffer_release(buffer);
+  iree_hal_executable_release(executable);
+  iree_hal_executable_layout_release(executable_layout);
+  iree_hal_descriptor_set_layout_release(set_layout);
+  iree_hal_executable_cache_release(executable_cache);
+  return status;
+}
+
+static iree_status_t iree_hal_barrier_benchmark_run(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  const iree_hal_barrier_benchmark_params_t* params =
+      (const iree_hal_barrier_benchmark_params_t*)benchmark_def->user_data;
+  iree_allocator_t host_allocator = benchmark_state->host_allocator;
+  if (FLAG_barrier_dispatch_count <= 0 ||
+      FLAG_barrier_dispatch_duration_us < 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "--barrier_dispatch_count must be positive and "
+                            "--barrier_dispatch_duration_us non-negative");
+  }
+
+  iree_task_executor_t* executor = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_task_executor_create_from_flags(host_allocator, &executor));
+  const iree_hal_executable_library_header_t** libraries[1] = {
+      iree_hal_barrier_benchmark_library_query(
+          IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION, /*reserved=*/NULL),
+  };
+  iree_hal_executable_loader_t* loader = NULL;
+  iree_status_t status = iree_hal_static_library_loader_create(
+      IREE_ARRAYSIZE(libraries), libraries,
+      iree_hal_executable_import_provider_null(), host_allocator, &loader);
+  iree_hal_allocator_t* device_allocator = NULL;
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_allocator_create_heap(iree_make_cstring_view("benchmark"),
+                                            host_allocator, host_allocator,
+                                            &device_allocator);
+  }
+  iree_hal_device_t* device = NULL;
+  if (iree_status_is_ok(status)) {
+    iree_hal_task_device_params_t device_params;
+    iree_hal_task_device_params_initialize(&device_params);
+    status = iree_hal_task_device_create(
+        iree_make_cstring_view("benchmark"), &device_params,
+        /*executor_count=*/1, &executor, /*loader_count=*/1, &loader,
+        device_allocator, host_allocator, &device);
+  }
+
+  int64_t iteration_count = 0;
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_barrier_benchmark_run_device(
+        params, device, benchmark_state, &iteration_count);
+  }
+  if (iree_status_is_ok(status)) {
+    iree_benchmark_set_items_processed(
+        benchmark_state, iteration_count * FLAG_barrier_dispatch_count);
+  }
+
+  iree_hal_device_release(device);
+  iree_hal_allocator_release(device_allocator);
+  iree_hal_executable_loader_release(loader);
+  iree_task_executor_release(executor);
+  return status;
+}
+
+static void iree_hal_barrier_benchmark_register(const char* name,
+                                                uint32_t entry_point,
+                                                bool independent) {
+  // Leaked; benchmark definitions must outlive registration.
+  iree_hal_barrier_benchmark_params_t* params = NULL;
+  IREE_CHECK_OK(iree_allocator_malloc(iree_allocator_system(), sizeof(*params),
+                                      (void**)&params));
+  params->entry_point = entry_point;
+  params->independent = independent;
+  iree_benchmark_def_t benchmark_def = {
+      .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+               IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+      .time_unit = IREE_BENCHMARK_UNIT_MILLISECOND,
+      .minimum_duration_ns = 0,
+      .iteration_count = 0,
+      .run = iree_hal_barrier_benchmark_run,
+      .user_data = params,
+  };
+  iree_benchmark_register(iree_make_cstring_view(name), &benchmark_def);
+}
+
+int main(int argc, char** argv) {
+  iree_flags_set_usage(
+      "task_command_buffer_benchmark",
+      "Measures the bandwidth of fill and copy commands executed on a task\n"
+      "device against single-threaded memset/memcpy on the same buffers and\n"
+      "the overlap of independent dispatches separated by barriers against\n"
+      "dispatches that depend on each other.\n"
+      "Task executor flags such as --task_topology_group_count control the\n"
+      "parallelism of the device.\n");
+  iree_flags_parse_checked(IREE_FLAGS_PARSE_MODE_UNDEFINED_OK, &argc, &argv);
+  iree_benchmark_initialize(&argc, argv);
+
+  iree_hal_transfer_benchmark_register(
+      "fill_memset", IREE_HAL_TRANSFER_BENCHMARK_OP_FILL, false);
+  iree_hal_transfer_benchmark_register(
+      "fill_command_buffer", IREE_HAL_TRANSFER_BENCHMARK_OP_FILL, true);
+  iree_hal_transfer_benchmark_register(
+      "copy_memcpy", IREE_HAL_TRANSFER_BENCHMARK_OP_COPY, false);
+  iree_hal_transfer_benchmark_register(
+      "copy_command_buffer", IREE_HAL_TRANSFER_BENCHMARK_OP_COPY, true);
+
+  iree_hal_barrier_benchmark_register("barrier_spin_dependent",
+                                      /*entry_point=*/0, false);
+  iree_hal_barrier_benchmark_register("barrier_spin_independent",
+                                      /*entry_point=*/0, true);
+  iree_hal_barrier_benchmark_register("barrier_sleep_dependent",
+                                      /*entry_point=*/1, false);
+  iree_hal_barrier_benchmark_register("barrier_sleep_independent",
+                                      /*entry_point=*/1, true);
+
+  iree_benchmark_run_specified();
+  return 0;
+}
@@ -11,6 +11,7 @@
 #include <string.h>
 
 #include "iree/base/internal/arena.h"
+#include "iree/base/internal/numa.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/local/local_descriptor_set.h"
 #include "iree/hal/local/local_descriptor_set_layout.h"
@@ -22,9 +23,13 @@
 #include "iree/hal/local/task_semaphore.h"
 #include "iree/hal/utils/buffer_transfer.h"
 
-typedef struct iree_hal_task_device_t {
-  iree_hal_resource_t resource;
-  iree_string_view_t identifier;
+// State for one of the executors used by the device. Queues are distributed
+// across partitions and all memory used by the queue comes from its partition.
+// When the executor is pinned to a NUMA node the block pools allocate from that
+// node such that transient task and command buffer storage is local to the
+// workers touching it.
+typedef struct iree_hal_task_device_partition_t {
+  iree_task_executor_t* executor;
 
   // Block pool used for small allocations like tasks and submissions.
   iree_arena_block_pool_t small_block_pool;
@@ -32,8 +37,14 @@ typedef struct iree_hal_task_device_t {
   // Block pool used for command buffers with a larger block size (as command
   // buffers can contain inlined data uploads).
   iree_arena_block_pool_t large_block_pool;
+} iree_hal_task_device_partition_t;
 
-  iree_task_executor_t* executor;
+typedef struct iree_hal_task_device_t {
+  iree_hal_resource_t resource;
+  iree_string_view_t identifier;
+
+  iree_host_size_t partition_count;
+  iree_hal_task_device_partition_t* partitions;
 
   iree_host_size_t loader_count;
   iree_hal_executable_loader_t** loaders;
@@ -72,13 +83,33 @@ static iree_status_t iree_hal_task_device_check_params(
   return iree_ok_status();
 }
 
+// Returns the allocator used for the block pools of a partition using
+// |executor|. Pinned executors on multi-node systems get memory from their own
+// node and otherwise we use the |host_allocator| like everything else.
+static iree_allocator_t iree_hal_task_device_select_block_allocator(
+    iree_task_executor_t* executor, iree_allocator_t host_allocator) {
+  uint32_t numa_node = iree_task_executor_numa_node(executor);
+  if (numa_node == IREE_TASK_TOPOLOGY_NUMA_NODE_ANY ||
+      iree_numa_node_count() <= 1) {
+    return host_allocator;
+  }
+  return iree_numa_allocator(numa_node);
+}
+
+// Returns the partition that serves the queue at |queue_index|.
+static iree_hal_task_device_partition_t* iree_hal_task_device_queue_partition(
+    iree_hal_task_device_t* device, iree_host_size_t queue_index) {
+  return &device->partitions[queue_index % device->partition_count];
+}
+
 iree_status_t iree_hal_task_device_create(
     iree_string_view_t identifier, const iree_hal_task_device_params_t* params,
-    iree_task_executor_t* executor, iree_host_size_t loader_count,
-    iree_hal_executable_loader_t** loaders,
+    iree_host_size_t executor_count, iree_task_executor_t** executors,
+    iree_host_size_t loader_count, iree_hal_executable_loader_t** loaders,
     iree_hal_allocator_t* device_allocator, iree_allocator_t host_allocator,
     iree_hal_device_t** out_device) {
   IREE_ASSERT_ARGUMENT(params);
+  IREE_ASSERT_ARGUMENT(executor_count > 0 && executors);
   IREE_ASSERT_ARGUMENT(!loader_count || loaders);
   IREE_ASSERT_ARGUMENT(device_allocator);
   IREE_ASSERT_ARGUMENT(out_device);
@@ -89,9 +120,14 @@ iree_status_t iree_hal_task_device_create(
                                     iree_hal_task_device_check_params(params));
 
   iree_hal_task_device_t* device = NULL;
-  iree_host_size_t struct_size = sizeof(*device) +
-                                 params->queue_count * sizeof(*device->queues) +
-                                 loader_count * sizeof(*device->loaders);
+  iree_host_size_t partitions_offset =
+      iree_host_align(sizeof(*device) +
+                          params->queue_count * sizeof(*device->queues),
+                      iree_max_align_t);
+  iree_host_size_t loaders_offset =
+      partitions_offset + executor_count * sizeof(*device->partitions);
+  iree_host_size_t struct_size =
+      loaders_offset + loader_count * sizeof(*device->loaders);
   iree_host_size_t total_size = struct_size + identifier.size;
   iree_status_t status =
       iree_allocator_malloc(host_allocator, total_size, (void**)&device);
@@ -105,19 +141,27 @@ iree_status_t iree_hal_task_device_create(
     device->device_allocator = device_allocator;
     iree_hal_allocator_retain(device_allocator);
 
-    iree_arena_block_pool_initialize(4096, host_allocator,
-                                     &device->small_block_pool);
-    iree_arena_block_pool_initialize(params->arena_block_size, host_allocator,
-                                     &device->large_block_pool);
-
-    device->executor = executor;
-    iree_task_executor_retain(device->executor);
+    device->partition_count = executor_count;
+    device->partitions =
+        (iree_hal_task_device_partition_t*)((uint8_t*)device +
+                                            partitions_offset);
+    for (iree_host_size_t i = 0; i < device->partition_count; ++i) {
+      iree_hal_task_device_partition_t* partition = &device->partitions[i];
+      partition->executor = executors[i];
+      iree_task_executor_retain(partition->executor);
+      iree_allocator_t block_allocator =
+          iree_hal_task_device_select_block_allocator(partition->executor,
+                                                      host_allocator);
+      iree_arena_block_pool_initialize(4096, block_allocator,
+                                       &partition->small_block_pool);
+      iree_arena_block_pool_initialize(params->arena_block_size,
+                                       block_allocator,
+                                       &partition->large_block_pool);
+    }
 
     device->loader_count = loader_count;
     device->loaders =
-        (iree_hal_executable_loader_t**)((uint8_t*)device + sizeof(*device) +
-                                         params->queue_count *
-                                             sizeof(*device->queues));
+        (iree_hal_executable_loader_t**)((uint8_t*)device + loaders_offset);
     for (iree_host_size_t i = 0; i < device->loader_count; ++i) {
       device->loaders[i] = loaders[i];
       iree_hal_executable_loader_retain(device->loaders[i]);
@@ -126,8 +170,10 @@ iree_status_t iree_hal_task_device_create(
     device->queue_count = params->queue_count;
     for (iree_host_size_t i = 0; i < device->queue_count; ++i) {
       // TODO(benvanik): add a number to each queue ID.
-      iree_hal_task_queue_initialize(device->identifier, device->executor,
-                                     &device->small_block_pool,
+      iree_hal_task_device_partition_t* partition =
+          iree_hal_task_device_queue_partition(device, i);
+      iree_hal_task_queue_initialize(device->identifier, partition->executor,
+                                     &partition->small_block_pool,
                                      &device->queues[i]);
     }
   }
@@ -152,9 +198,12 @@ static void iree_hal_task_device_destroy(iree_hal_device_t* base_device) {
   for (iree_host_size_t i = 0; i < device->loader_count; ++i) {
     iree_hal_executable_loader_release(device->loaders[i]);
   }
-  iree_task_executor_release(device->executor);
-  iree_arena_block_pool_deinitialize(&device->large_block_pool);
-  iree_arena_block_pool_deinitialize(&device->small_block_pool);
+  for (iree_host_size_t i = 0; i < device->partition_count; ++i) {
+    iree_hal_task_device_partition_t* partition = &device->partitions[i];
+    iree_task_executor_release(partition->executor);
+    iree_arena_block_pool_deinitialize(&partition->large_block_pool);
+    iree_arena_block_pool_deinitialize(&partition->small_block_pool);
+  }
   iree_hal_allocator_release(device->device_allocator);
   iree_allocator_free(host_allocator, device);
 
@@ -181,9 +230,12 @@ static iree_hal_allocator_t* iree_hal_task_device_allocator(
 
 static iree_status_t iree_hal_task_device_trim(iree_hal_device_t* base_device) {
   iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
-  iree_arena_block_pool_trim(&device->small_block_pool);
-  iree_arena_block_pool_trim(&device->large_block_pool);
-  iree_task_executor_trim(device->executor);
+  for (iree_host_size_t i = 0; i < device->partition_count; ++i) {
+    iree_hal_task_device_partition_t* partition = &device->partitions[i];
+    iree_arena_block_pool_trim(&partition->small_block_pool);
+    iree_arena_block_pool_trim(&partition->large_block_pool);
+    iree_task_executor_trim(partition->executor);
+  }
   return iree_hal_allocator_trim(device->device_allocator);
 }
 
@@ -231,10 +283,12 @@ static iree_status_t iree_hal_task_device_create_command_buffer(
   iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
   iree_host_size_t queue_index = iree_hal_task_device_select_queue(
       device, command_categories, queue_affinity);
+  iree_hal_task_device_partition_t* partition =
+      iree_hal_task_device_queue_partition(device, queue_index);
   return iree_hal_task_command_buffer_create(
-      base_device, &device->queues[queue_index].scope, mode, command_categories,
-      queue_affinity, &device->large_block_pool, device->host_allocator,
-      out_command_buffer);
+      base_device, partition->executor, &device->queues[queue_index].scope,
+      mode, command_categories, queue_affinity, &partition->large_block_pool,
+      device->host_allocator, out_command_buffer);
 }
 
 static iree_status_t iree_hal_task_device_create_descriptor_set(
@@ -287,9 +341,11 @@ static iree_status_t iree_hal_task_device_create_semaphore(
     iree_hal_device_t* base_device, uint64_t initial_value,
     iree_hal_semaphore_t** out_semaphore) {
   iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
-  return iree_hal_task_semaphore_create(
-      iree_task_executor_event_pool(device->executor), initial_value,
-      device->host_allocator, out_semaphore);
+  // Semaphores may be used across queues but only need an executor to
+  // coordinate waits with; the first is as good as any.
+  return iree_hal_task_semaphore_create(device->partitions[0].executor,
+                                        initial_value, device->host_allocator,
+                                        out_semaphore);
 }
 
 static iree_status_t iree_hal_task_device_queue_submit(
@@ -323,10 +379,10 @@ static iree_status_t iree_hal_task_device_wait_semaphores(
     iree_hal_device_t* base_device, iree_hal_wait_mode_t wait_mode,
     const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout) {
   iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
-  return iree_hal_task_semaphore_multi_wait(
-      wait_mode, semaphore_list, timeout,
-      iree_task_executor_event_pool(device->executor),
-      &device->large_block_pool);
+  iree_hal_task_device_partition_t* partition = &device->partitions[0];
+  return iree_hal_task_semaphore_multi_wait(wait_mode, semaphore_list, timeout,
+                                            partition->executor,
+                                            &partition->large_block_pool);
 }
 
 static iree_status_t iree_hal_task_device_wait_idle(
@@ -342,6 +398,32 @@ static iree_status_t iree_hal_task_device_wait_idle(
   return status;
 }
 
+iree_status_t iree_hal_task_device_query_statistics(
+    iree_hal_device_t* base_device,
+    iree_hal_task_device_statistics_t* out_statistics) {
+  IREE_ASSERT_ARGUMENT(base_device);
+  IREE_ASSERT_ARGUMENT(out_statistics);
+  memset(out_statistics, 0, sizeof(*out_statistics));
+  if (!iree_hal_resource_is(base_device, &iree_hal_task_device_vtable)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "device is not a task device");
+  }
+  iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
+  for (iree_host_size_t i = 0; i < device->partition_count; ++i) {
+    iree_task_executor_statistics_t executor_statistics;
+    iree_task_executor_query_statistics(device->partitions[i].executor,
+                                        &executor_statistics);
+    iree_task_executor_statistics_merge(&executor_statistics,
+                                        &out_statistics->executor);
+  }
+  for (iree_host_size_t i = 0; i < device->queue_count; ++i) {
+    iree_task_dispatch_statistics_merge(
+        &device->queues[i].scope.dispatch_statistics,
+        &out_statistics->dispatch);
+  }
+  return iree_ok_status();
+}
+
 static const iree_hal_device_vtable_t iree_hal_task_device_vtable = {
     .destroy = iree_hal_task_device_destroy,
     .id = iree_hal_task_device_id,
@@ -34,16 +34,41 @@ typedef struct iree_hal_task_device_params_t {
 void iree_hal_task_device_params_initialize(
     iree_hal_task_device_params_t* out_params);
 
-// Creates a new iree/task/-based local CPU device that uses |executor| for
+// Creates a new iree/task/-based local CPU device that uses |executors| for
 // scheduling tasks. |loaders| is the set of executable loaders that are
 // available for loading in the device context.
+//
+// Device queues are distributed round-robin across the executors. Each
+// executor is given its own transient memory pools and if the executor is
+// pinned to a NUMA node (such as those created with
+// iree_task_executors_create_from_flags) the pools are allocated from memory
+// local to that node.
 iree_status_t iree_hal_task_device_create(
     iree_string_view_t identifier, const iree_hal_task_device_params_t* params,
-    iree_task_executor_t* executor, iree_host_size_t loader_count,
-    iree_hal_executable_loader_t** loaders,
+    iree_host_size_t executor_count, iree_task_executor_t** executors,
+    iree_host_size_t loader_count, iree_hal_executable_loader_t** loaders,
     iree_hal_allocator_t* device_allocator, iree_allocator_t host_allocator,
     iree_hal_device_t** out_device);
 
+// Aggregate statistics of an iree_hal_task_device_t.
+typedef struct iree_hal_task_device_statistics_t {
+  // Statistics aggregated across the workers of all device executors.
+  // Executors shared with other devices will include their work as well.
+  iree_task_executor_statistics_t executor;
+  // Statistics aggregated across all dispatches retired on the device queues.
+  iree_task_dispatch_statistics_t dispatch;
+} iree_hal_task_device_statistics_t;
+
+// Queries the aggregate statistics of |device| since it was created.
+// |device| must have been created with iree_hal_task_device_create.
+// Thread-safe and lock-free; see iree_task_executor_query_statistics.
+//
+// NOTE: statistics may be compiled out in some configurations and this call
+// will become a memset(0).
+iree_status_t iree_hal_task_device_query_statistics(
+    iree_hal_device_t* device,
+    iree_hal_task_device_statistics_t* out_statistics);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -21,7 +21,8 @@ typedef struct iree_hal_task_driver_t {
   iree_string_view_t identifier;
   iree_hal_task_device_params_t default_params;
 
-  iree_task_executor_t* executor;
+  iree_host_size_t executor_count;
+  iree_task_executor_t** executors;
 
   iree_host_size_t loader_count;
   iree_hal_executable_loader_t* loaders[];
@@ -38,11 +39,12 @@ static iree_hal_task_driver_t* iree_hal_task_driver_cast(
 iree_status_t iree_hal_task_driver_create(
     iree_string_view_t identifier,
     const iree_hal_task_device_params_t* default_params,
-    iree_task_executor_t* executor, iree_host_size_t loader_count,
-    iree_hal_executable_loader_t** loaders,
+    iree_host_size_t executor_count, iree_task_executor_t** executors,
+    iree_host_size_t loader_count, iree_hal_executable_loader_t** loaders,
     iree_hal_allocator_t* device_allocator, iree_allocator_t host_allocator,
     iree_hal_driver_t** out_driver) {
   IREE_ASSERT_ARGUMENT(default_params);
+  IREE_ASSERT_ARGUMENT(executor_count > 0 && executors);
   IREE_ASSERT_ARGUMENT(!loader_count || loaders);
   IREE_ASSERT_ARGUMENT(device_allocator);
   IREE_ASSERT_ARGUMENT(out_driver);
@@ -50,8 +52,10 @@ iree_status_t iree_hal_task_driver_create(
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_hal_task_driver_t* driver = NULL;
-  iree_host_size_t struct_size =
+  iree_host_size_t executors_offset =
       sizeof(*driver) + loader_count * sizeof(*driver->loaders);
+  iree_host_size_t struct_size =
+      executors_offset + executor_count * sizeof(*driver->executors);
   iree_host_size_t total_size = struct_size + identifier.size;
   iree_status_t status =
       iree_allocator_malloc(host_allocator, total_size, (void**)&driver);
@@ -67,8 +71,13 @@ iree_status_t iree_hal_task_driver_create(
     memcpy(&driver->default_params, default_params,
            sizeof(driver->default_params));
 
-    driver->executor = executor;
-    iree_task_executor_retain(driver->executor);
+    driver->executor_count = executor_count;
+    driver->executors =
+        (iree_task_executor_t**)((uint8_t*)driver + executors_offset);
+    for (iree_host_size_t i = 0; i < driver->executor_count; ++i) {
+      driver->executors[i] = executors[i];
+      iree_task_executor_retain(driver->executors[i]);
+    }
 
     driver->loader_count = loader_count;
     for (iree_host_size_t i = 0; i < driver->loader_count; ++i) {
@@ -95,7 +104,9 @@ static void iree_hal_task_driver_destroy(iree_hal_driver_t* base_driver) {
   for (iree_host_size_t i = 0; i < driver->loader_count; ++i) {
     iree_hal_executable_loader_release(driver->loaders[i]);
   }
-  iree_task_executor_release(driver->executor);
+  for (iree_host_size_t i = 0; i < driver->executor_count; ++i) {
+    iree_task_executor_release(driver->executors[i]);
+  }
   iree_allocator_free(host_allocator, driver);
 
   IREE_TRACE_ZONE_END(z0);
@@ -122,9 +133,9 @@ static iree_status_t iree_hal_task_driver_create_device(
     iree_allocator_t host_allocator, iree_hal_device_t** out_device) {
   iree_hal_task_driver_t* driver = iree_hal_task_driver_cast(base_driver);
   return iree_hal_task_device_create(
-      driver->identifier, &driver->default_params, driver->executor,
-      driver->loader_count, driver->loaders, driver->device_allocator,
-      host_allocator, out_device);
+      driver->identifier, &driver->default_params, driver->executor_count,
+      driver->executors, driver->loader_count, driver->loaders,
+      driver->device_allocator, host_allocator, out_device);
 }
 
 static const iree_hal_driver_vtable_t iree_hal_task_driver_vtable = {
@@ -14,6 +14,10 @@
 extern "C" {
 #endif  // __cplusplus
 
+// Creates an event for use within task command buffers.
+// Events have no state of their own: command buffers resolve waits on events
+// signaled earlier in the same command buffer to the commands recorded prior
+// to the signal when recording and reject waits on any other event.
 iree_status_t iree_hal_task_event_create(iree_allocator_t host_allocator,
                                          iree_hal_event_t** out_event);
 
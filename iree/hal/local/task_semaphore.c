@@ -133,6 +133,7 @@ static void iree_hal_task_timepoint_list_notify_ready(
 typedef struct iree_hal_task_semaphore_t {
   iree_hal_resource_t resource;
   iree_allocator_t host_allocator;
+  iree_task_executor_t* executor;
   iree_event_pool_t* event_pool;
 
   // Guards all mutable fields. We expect low contention on semaphores and since
@@ -167,9 +168,9 @@ static iree_hal_task_semaphore_t* iree_hal_task_semaphore_cast(
 }
 
 iree_status_t iree_hal_task_semaphore_create(
-    iree_event_pool_t* event_pool, uint64_t initial_value,
+    iree_task_executor_t* executor, uint64_t initial_value,
     iree_allocator_t host_allocator, iree_hal_semaphore_t** out_semaphore) {
-  IREE_ASSERT_ARGUMENT(event_pool);
+  IREE_ASSERT_ARGUMENT(executor);
   IREE_ASSERT_ARGUMENT(out_semaphore);
   *out_semaphore = NULL;
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -181,7 +182,9 @@ iree_status_t iree_hal_task_semaphore_create(
     iree_hal_resource_initialize(&iree_hal_task_semaphore_vtable,
                                  &semaphore->resource);
     semaphore->host_allocator = host_allocator;
-    semaphore->event_pool = event_pool;
+    semaphore->executor = executor;
+    iree_task_executor_retain(executor);
+    semaphore->event_pool = iree_task_executor_event_pool(executor);
 
     iree_slim_mutex_initialize(&semaphore->mutex);
     semaphore->current_value = initial_value;
@@ -206,6 +209,7 @@ static void iree_hal_task_semaphore_destroy(
   iree_status_free(semaphore->failure_status);
   iree_notification_deinitialize(&semaphore->notification);
   iree_slim_mutex_deinitialize(&semaphore->mutex);
+  iree_task_executor_release(semaphore->executor);
   iree_allocator_free(host_allocator, semaphore);
 
   IREE_TRACE_ZONE_END(z0);
@@ -403,10 +407,11 @@ static iree_status_t iree_hal_task_semaphore_wait(
   iree_slim_mutex_unlock(&semaphore->mutex);
   if (IREE_UNLIKELY(!iree_status_is_ok(status))) return status;
 
-  // Wait until the timepoint resolves.
+  // Wait until the timepoint resolves while helping the executor get there.
   // If satisfied the timepoint is automatically cleaned up and we are done. If
   // the deadline is reached before satisfied then we have to clean it up.
-  status = iree_wait_one(&timepoint.event, deadline_ns);
+  status = iree_task_executor_donate_caller(semaphore->executor,
+                                            &timepoint.event, deadline_ns);
   if (!iree_status_is_ok(status)) {
     iree_slim_mutex_lock(&semaphore->mutex);
     iree_hal_task_timepoint_list_erase(&semaphore->timepoint_list, &timepoint);
@@ -419,7 +424,7 @@ static iree_status_t iree_hal_task_semaphore_wait(
 iree_status_t iree_hal_task_semaphore_multi_wait(
     iree_hal_wait_mode_t wait_mode,
     const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout,
-    iree_event_pool_t* event_pool, iree_arena_block_pool_t* block_pool) {
+    iree_task_executor_t* executor, iree_arena_block_pool_t* block_pool) {
   IREE_ASSERT_ARGUMENT(semaphore_list);
   if (semaphore_list->count == 0) {
     return iree_ok_status();
@@ -475,15 +480,29 @@ iree_status_t iree_hal_task_semaphore_multi_wait(
   // Perform the wait.
   if (iree_status_is_ok(status)) {
     if (wait_mode == IREE_HAL_WAIT_MODE_ANY) {
-      status = iree_wait_any(wait_set, deadline_ns, /*out_wake_handle=*/NULL);
+      if (timepoint_count < semaphore_list->count) {
+        // At least one semaphore was already satisfied.
+      } else {
+        // Donate the caller until any of the timepoints resolve; with
+        // threadless executors this is the only way the work can progress.
+        status = iree_task_executor_donate_caller_any(executor, wait_set,
+                                                      deadline_ns);
+      }
     } else {
-      status = iree_wait_all(wait_set, deadline_ns);
+      // Waiting for all is the same as waiting for each in turn and lets us
+      // donate the caller to the executor for the duration.
+      for (iree_host_size_t i = 0; i < timepoint_count; ++i) {
+        status = iree_task_executor_donate_caller(
+            executor, &timepoints[i].event, deadline_ns);
+        if (!iree_status_is_ok(status)) break;
+      }
     }
   }
 
   if (timepoints != NULL) {
     // TODO(benvanik): if we flip the API to multi-acquire events from the pool
     // above then we can multi-release here too.
+    iree_event_pool_t* event_pool = iree_task_executor_event_pool(executor);
     for (iree_host_size_t i = 0; i < timepoint_count; ++i) {
       iree_event_pool_release(event_pool, 1, &timepoints[i].event);
     }
@@ -109,6 +109,17 @@ IREE_API_EXPORT void iree_hal_semaphore_fail(iree_hal_semaphore_t* semaphore,
 IREE_API_EXPORT iree_status_t iree_hal_semaphore_wait(
     iree_hal_semaphore_t* semaphore, uint64_t value, iree_timeout_t timeout);
 
+// Returns a wait source that resolves when |semaphore| reaches or exceeds the
+// specified payload |value|. If the semaphore fails the wait source resolves
+// with the failure status code.
+//
+// Allows waiting on semaphores without blocking the calling thread by
+// querying the wait source and scheduling other work until it resolves.
+// The wait source does not retain |semaphore| and the caller must ensure it
+// remains live while the wait source is in use.
+IREE_API_EXPORT iree_wait_source_t
+iree_hal_semaphore_await(iree_hal_semaphore_t* semaphore, uint64_t value);
+
 //===----------------------------------------------------------------------===//
 // iree_hal_semaphore_t implementation details
 //===----------------------------------------------------------------------===//
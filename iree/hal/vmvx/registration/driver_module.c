@@ -61,9 +61,13 @@ static iree_status_t iree_hal_vmvx_driver_factory_try_create(
       instance, host_allocator, &vmvx_loader);
   iree_hal_executable_loader_t* loaders[1] = {vmvx_loader};
 
-  iree_task_executor_t* executor = NULL;
+  // One executor per NUMA node (if enabled by flags); more than a handful of
+  // nodes in a single process is rare and any beyond this go unused.
+  iree_task_executor_t* executors[8] = {NULL};
+  iree_host_size_t executor_count = 0;
   if (iree_status_is_ok(status)) {
-    status = iree_task_executor_create_from_flags(host_allocator, &executor);
+    status = iree_task_executors_create_from_flags(
+        host_allocator, IREE_ARRAYSIZE(executors), executors, &executor_count);
   }
 
   iree_hal_allocator_t* device_allocator = NULL;
@@ -75,13 +79,15 @@ static iree_status_t iree_hal_vmvx_driver_factory_try_create(
 
   if (iree_status_is_ok(status)) {
     status = iree_hal_task_driver_create(
-        iree_make_cstring_view("vmvx"), &default_params, executor,
-        IREE_ARRAYSIZE(loaders), loaders, device_allocator, host_allocator,
-        out_driver);
+        iree_make_cstring_view("vmvx"), &default_params, executor_count,
+        executors, IREE_ARRAYSIZE(loaders), loaders, device_allocator,
+        host_allocator, out_driver);
   }
 
   iree_hal_allocator_release(device_allocator);
-  iree_task_executor_release(executor);
+  for (iree_host_size_t i = 0; i < executor_count; ++i) {
+    iree_task_executor_release(executors[i]);
+  }
   iree_hal_executable_loader_release(vmvx_loader);
   iree_vm_instance_release(instance);
   return status;
@@ -1310,14 +1310,18 @@ IREE_VM_ABI_EXPORT(iree_hal_module_semaphore_await,  //
   IREE_RETURN_IF_ERROR(iree_hal_semaphore_check_deref(args->r0, &semaphore));
   uint64_t new_value = (uint32_t)args->i1;
 
-  // TODO(benvanik): coroutine magic.
-  iree_status_t status =
-      iree_hal_semaphore_wait(semaphore, new_value, iree_infinite_timeout());
+  // Asynchronous invocations yield here (with IREE_STATUS_DEFERRED) and
+  // reissue the call once the semaphore is reached while synchronous ones
+  // block the calling thread.
+  iree_status_t status = iree_vm_stack_wait(
+      stack, iree_hal_semaphore_await(semaphore, new_value),
+      iree_infinite_timeout());
   if (iree_status_is_ok(status)) {
     rets->i0 = 0;
   } else if (iree_status_is_deadline_exceeded(status)) {
     // Propagate deadline exceeded back to the VM.
     rets->i0 = (int32_t)iree_status_consume_code(status);
+    status = iree_ok_status();
   }
   return status;
 }
@@ -10,6 +10,7 @@
 #include <string.h>
 
 #include "iree/base/internal/flags.h"
+#include "iree/base/internal/numa.h"
 #include "iree/base/tracing.h"
 #include "iree/task/topology.h"
 #include "iree/task/topology_cpuinfo.h"
@@ -34,15 +35,12 @@ IREE_FLAG(
     "threads that would otherwise need to perform the syscalls during\n"
     "coordination.");
 
-// TODO(benvanik): enable this when we use it - though hopefully we don't!
 IREE_FLAG(
-    int32_t, task_worker_local_memory, 0,  // 64 * 1024,
-    "Specifies the bytes of per-worker local memory allocated for use by\n"
-    "dispatched tiles. Tiles may use less than this but will fail to dispatch\n"
-    "if they require more. Conceptually it is like a stack reservation and\n"
-    "should be treated the same way: the source programs must be built to\n"
-    "only use a specific maximum amount of local memory and the runtime must\n"
-    "be configured to make at least that amount of local memory available.");
+    int32_t, task_worker_local_memory, 0,
+    "Specifies the bytes of per-worker local memory reserved up front for use\n"
+    "by dispatched tiles. Workers grow their local memory on demand when a\n"
+    "dispatch requires more than this so it only needs to be set to avoid the\n"
+    "first-use allocation (or to preallocate on memory-constrained systems).");
 
 //===----------------------------------------------------------------------===//
 // Topology configuration
@@ -76,6 +74,13 @@ IREE_FLAG(
     "detected and used when --task_topology_group_count=0 and is ignored\n"
     "otherwise.\n");
 
+IREE_FLAG(
+    bool, task_topology_per_numa_node, false,
+    "Creates one executor per NUMA node with workers pinned to the cores of\n"
+    "that node when using iree_task_executors_create_from_flags. The\n"
+    "--task_topology_group_count/--task_topology_max_group_count limits apply\n"
+    "per node. Has no effect on machines with a single node.");
+
 // TODO(benvanik): add --task_topology_dump to dump out the current machine
 // configuration as seen by the topology utilities.
 
@@ -83,11 +88,15 @@ IREE_FLAG(
 // Task system factory functions
 //===----------------------------------------------------------------------===//
 
-iree_status_t iree_task_executor_create_from_flags(
-    iree_allocator_t host_allocator, iree_task_executor_t** out_executor) {
+// Creates an executor from flags with workers on |numa_node| or all nodes if
+// IREE_TASK_TOPOLOGY_NUMA_NODE_ANY.
+static iree_status_t iree_task_executor_create_from_flags_for_numa_node(
+    uint32_t numa_node, iree_allocator_t host_allocator,
+    iree_task_executor_t** out_executor) {
   IREE_ASSERT_ARGUMENT(out_executor);
   *out_executor = NULL;
   IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, numa_node);
 
   iree_task_scheduling_mode_t scheduling_mode = 0;
   if (FLAG_task_scheduling_defer_worker_startup) {
@@ -105,7 +114,14 @@ iree_status_t iree_task_executor_create_from_flags(
   iree_task_topology_t topology;
   iree_task_topology_initialize(&topology);
 
-  if (FLAG_task_topology_group_count != 0) {
+  if (numa_node != IREE_TASK_TOPOLOGY_NUMA_NODE_ANY) {
+    iree_task_topology_initialize_from_numa_node(
+        numa_node,
+        FLAG_task_topology_group_count != 0
+            ? FLAG_task_topology_group_count
+            : FLAG_task_topology_max_group_count,
+        &topology);
+  } else if (FLAG_task_topology_group_count != 0) {
     iree_task_topology_initialize_from_group_count(
         FLAG_task_topology_group_count, &topology);
   } else if (strcmp(FLAG_task_topology_mode, "physical_cores") == 0) {
@@ -133,3 +149,51 @@ iree_status_t iree_task_executor_create_from_flags(
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
+
+iree_status_t iree_task_executor_create_from_flags(
+    iree_allocator_t host_allocator, iree_task_executor_t** out_executor) {
+  return iree_task_executor_create_from_flags_for_numa_node(
+      IREE_TASK_TOPOLOGY_NUMA_NODE_ANY, host_allocator, out_executor);
+}
+
+iree_status_t iree_task_executors_create_from_flags(
+    iree_allocator_t host_allocator, iree_host_size_t executor_capacity,
+    iree_task_executor_t** executors, iree_host_size_t* out_executor_count) {
+  IREE_ASSERT_ARGUMENT(executor_capacity == 0 || executors);
+  IREE_ASSERT_ARGUMENT(out_executor_count);
+  *out_executor_count = 0;
+  if (executor_capacity == 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "at least one executor must be allowed");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_host_size_t numa_node_count =
+      FLAG_task_topology_per_numa_node ? iree_numa_node_count() : 1;
+  if (numa_node_count <= 1) {
+    iree_status_t status =
+        iree_task_executor_create_from_flags(host_allocator, &executors[0]);
+    if (iree_status_is_ok(status)) *out_executor_count = 1;
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  iree_host_size_t executor_count =
+      iree_min(numa_node_count, executor_capacity);
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < executor_count; ++i) {
+    status = iree_task_executor_create_from_flags_for_numa_node(
+        (uint32_t)i, host_allocator, &executors[i]);
+    if (!iree_status_is_ok(status)) {
+      for (iree_host_size_t j = 0; j < i; ++j) {
+        iree_task_executor_release(executors[j]);
+        executors[j] = NULL;
+      }
+      break;
+    }
+  }
+  if (iree_status_is_ok(status)) *out_executor_count = executor_count;
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -32,6 +32,17 @@ extern "C" {
 iree_status_t iree_task_executor_create_from_flags(
     iree_allocator_t host_allocator, iree_task_executor_t** out_executor);
 
+// Creates one or more task system executors from the current command line
+// flags. When --task_topology_per_numa_node is set one executor is created per
+// NUMA node (up to |executor_capacity|) with its workers pinned to that node
+// and otherwise this is equivalent to iree_task_executor_create_from_flags.
+// The executors are stored in |executors| ordered by NUMA node and
+// |out_executor_count| is set to the number created. Each executor must be
+// released by the caller.
+iree_status_t iree_task_executors_create_from_flags(
+    iree_allocator_t host_allocator, iree_host_size_t executor_capacity,
+    iree_task_executor_t** executors, iree_host_size_t* out_executor_count);
+
 //===----------------------------------------------------------------------===//
 // Task system simple invocation utilities
 //===----------------------------------------------------------------------===//
@@ -0,0 +1,206 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/task/deque.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define IREE_TASK_DEQUE_MASK ((int64_t)IREE_TASK_DEQUE_CAPACITY - 1)
+
+void iree_task_deque_initialize(iree_task_deque_t* out_deque) {
+  memset(out_deque, 0, sizeof(*out_deque));
+  iree_atomic_store_int64(&out_deque->top, 0, iree_memory_order_relaxed);
+  iree_atomic_store_int64(&out_deque->bottom, 0, iree_memory_order_relaxed);
+  iree_task_list_initialize(&out_deque->overflow_list);
+}
+
+void iree_task_deque_deinitialize(iree_task_deque_t* deque) {
+  // Gather up all remaining tasks and discard them together so that any
+  // dependent tasks are discarded in the proper order.
+  iree_task_list_t discard_list;
+  iree_task_list_initialize(&discard_list);
+  iree_task_t* task = NULL;
+  while ((task = iree_task_deque_pop(deque)) != NULL) {
+    iree_task_list_push_back(&discard_list, task);
+  }
+  iree_task_list_discard(&discard_list);
+}
+
+bool iree_task_deque_is_empty(iree_task_deque_t* deque) {
+  int64_t b = iree_atomic_load_int64(&deque->bottom, iree_memory_order_relaxed);
+  int64_t t = iree_atomic_load_int64(&deque->top, iree_memory_order_relaxed);
+  return b <= t && iree_task_list_is_empty(&deque->overflow_list);
+}
+
+iree_host_size_t iree_task_deque_stealable_count(iree_task_deque_t* deque) {
+  int64_t t = iree_atomic_load_int64(&deque->top, iree_memory_order_acquire);
+  int64_t b = iree_atomic_load_int64(&deque->bottom, iree_memory_order_acquire);
+  return b > t ? (iree_host_size_t)(b - t) : 0;
+}
+
+void iree_task_deque_push(iree_task_deque_t* deque, iree_task_t* task) {
+  int64_t b = iree_atomic_load_int64(&deque->bottom, iree_memory_order_relaxed);
+  int64_t t = iree_atomic_load_int64(&deque->top, iree_memory_order_acquire);
+  if (IREE_UNLIKELY(b - t >= IREE_TASK_DEQUE_CAPACITY)) {
+    // Ring is full; keep the task local to the owner. It'll be processed after
+    // the ring has drained.
+    iree_task_list_push_front(&deque->overflow_list, task);
+    return;
+  }
+  iree_atomic_store_intptr(&deque->slots[b & IREE_TASK_DEQUE_MASK],
+                           (intptr_t)task, iree_memory_order_relaxed);
+  iree_atomic_thread_fence(iree_memory_order_release);
+  iree_atomic_store_int64(&deque->bottom, b + 1, iree_memory_order_relaxed);
+}
+
+// Moves tasks from the front of the FIFO |list| into the ring such that the
+// front of the list is the next to be popped. Any tasks that do not fit remain
+// in |list| in their original order.
+//
+// Must only be called from the owning worker's thread.
+static void iree_task_deque_push_fifo_ring(iree_task_deque_t* deque,
+                                           iree_task_list_t* list) {
+  if (iree_task_list_is_empty(list)) return;
+
+  int64_t b = iree_atomic_load_int64(&deque->bottom, iree_memory_order_relaxed);
+  int64_t t = iree_atomic_load_int64(&deque->top, iree_memory_order_acquire);
+  int64_t capacity = IREE_TASK_DEQUE_CAPACITY - (b - t);
+
+  // Count how many tasks we can fit. The owner pops from the bottom and we
+  // want the front of the list to be popped first so we need to know where the
+  // range ends before we can start storing.
+  int64_t count = 0;
+  for (iree_task_t* p = list->head; p != NULL && count < capacity;
+       p = p->next_task) {
+    ++count;
+  }
+  if (count == 0) return;
+
+  // Store in reverse: list[0] goes to slots[b + count - 1] (the bottom).
+  for (int64_t i = count - 1; i >= 0; --i) {
+    iree_task_t* task = iree_task_list_pop_front(list);
+    iree_atomic_store_intptr(&deque->slots[(b + i) & IREE_TASK_DEQUE_MASK],
+                             (intptr_t)task, iree_memory_order_relaxed);
+  }
+
+  // Publish all of the tasks at once.
+  iree_atomic_thread_fence(iree_memory_order_release);
+  iree_atomic_store_int64(&deque->bottom, b + count, iree_memory_order_relaxed);
+}
+
+void iree_task_deque_push_fifo_list(iree_task_deque_t* deque,
+                                    iree_task_list_t* list) {
+  iree_task_deque_push_fifo_ring(deque, list);
+  if (IREE_UNLIKELY(!iree_task_list_is_empty(list))) {
+    // Ring is full; retain the remaining tasks for the owner to process after
+    // the ring has drained.
+    iree_task_list_append(&deque->overflow_list, list);
+  }
+}
+
+void iree_task_deque_push_lifo_list(iree_task_deque_t* deque,
+                                    iree_task_list_t* list) {
+  if (iree_task_list_is_empty(list)) return;
+  iree_task_list_reverse(list);
+  iree_task_deque_push_fifo_list(deque, list);
+}
+
+iree_task_t* iree_task_deque_flush_from_lifo_slist(
+    iree_task_deque_t* deque, iree_atomic_task_slist_t* source_slist) {
+  // Flushing is atomic and afterward we own the list exclusively.
+  iree_task_list_t list;
+  iree_task_list_initialize(&list);
+  if (iree_atomic_task_slist_flush(
+          source_slist, IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_FIFO,
+          &list.head, &list.tail)) {
+    iree_task_deque_push_fifo_list(deque, &list);
+  }
+  return iree_task_deque_pop(deque);
+}
+
+// Pops a task from the bottom of the ring buffer, ignoring the overflow list.
+static iree_task_t* iree_task_deque_pop_ring(iree_task_deque_t* deque) {
+  int64_t b =
+      iree_atomic_load_int64(&deque->bottom, iree_memory_order_relaxed) - 1;
+  iree_atomic_store_int64(&deque->bottom, b, iree_memory_order_relaxed);
+  iree_atomic_thread_fence(iree_memory_order_seq_cst);
+  int64_t t = iree_atomic_load_int64(&deque->top, iree_memory_order_relaxed);
+
+  iree_task_t* task = NULL;
+  if (t <= b) {
+    // Non-empty.
+    task = (iree_task_t*)iree_atomic_load_intptr(
+        &deque->slots[b & IREE_TASK_DEQUE_MASK], iree_memory_order_relaxed);
+    if (t == b) {
+      // Last task in the ring; race thieves for it.
+      if (!iree_atomic_compare_exchange_strong_int64(
+              &deque->top, &t, t + 1, iree_memory_order_seq_cst,
+              iree_memory_order_relaxed)) {
+        // Lost the race.
+        task = NULL;
+      }
+      iree_atomic_store_int64(&deque->bottom, b + 1, iree_memory_order_relaxed);
+    }
+  } else {
+    // Empty; restore the bottom.
+    iree_atomic_store_int64(&deque->bottom, b + 1, iree_memory_order_relaxed);
+  }
+  return task;
+}
+
+iree_task_t* iree_task_deque_pop(iree_task_deque_t* deque) {
+  iree_task_t* task = iree_task_deque_pop_ring(deque);
+  if (IREE_UNLIKELY(!task &&
+                    !iree_task_list_is_empty(&deque->overflow_list))) {
+    // Ring has drained; refill it with as many overflow tasks as fit so that
+    // thieves can see them again.
+    iree_task_deque_push_fifo_ring(deque, &deque->overflow_list);
+    task = iree_task_deque_pop_ring(deque);
+  }
+  return task;
+}
+
+iree_task_t* iree_task_deque_steal(iree_task_deque_t* deque) {
+  int64_t t = iree_atomic_load_int64(&deque->top, iree_memory_order_acquire);
+  iree_atomic_thread_fence(iree_memory_order_seq_cst);
+  int64_t b = iree_atomic_load_int64(&deque->bottom, iree_memory_order_acquire);
+  if (t >= b) return NULL;  // empty
+
+  // NOTE: the load must happen before the CAS: once top is bumped the owner
+  // is free to reuse the slot.
+  iree_task_t* task = (iree_task_t*)iree_atomic_load_intptr(
+      &deque->slots[t & IREE_TASK_DEQUE_MASK], iree_memory_order_relaxed);
+  if (!iree_atomic_compare_exchange_strong_int64(&deque->top, &t, t + 1,
+                                                 iree_memory_order_seq_cst,
+                                                 iree_memory_order_relaxed)) {
+    // Lost a race with the owner or another thief.
+    return NULL;
+  }
+  return task;
+}
+
+iree_task_t* iree_task_deque_try_steal(iree_task_deque_t* source_deque,
+                                       iree_task_deque_t* target_deque,
+                                       iree_host_size_t max_tasks) {
+  if (max_tasks == 0) return NULL;
+  iree_task_t* task = iree_task_deque_steal(source_deque);
+  if (!task) return NULL;
+
+  // Take up to half of what remains so that over many thefts the work evens
+  // out between the victim and thieves. Any individual steal failing indicates
+  // contention and we stop early with what we have.
+  iree_host_size_t steal_count =
+      iree_min(max_tasks - 1,
+               iree_task_deque_stealable_count(source_deque) / 2);
+  for (iree_host_size_t i = 0; i < steal_count; ++i) {
+    iree_task_t* stolen_task = iree_task_deque_steal(source_deque);
+    if (!stolen_task) break;
+    iree_task_deque_push(target_deque, stolen_task);
+  }
+
+  return task;
+}
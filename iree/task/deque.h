@@ -0,0 +1,159 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_TASK_DEQUE_H_
+#define IREE_TASK_DEQUE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/task/list.h"
+#include "iree/task/task.h"
+#include "iree/task/tuning.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// A lock-free work-stealing deque based on the Chase-Lev algorithm.
+// Each worker owns one deque and is the only thread allowed to push and pop at
+// the bottom while any number of thieves may concurrently steal from the top.
+// The owner never takes a lock or performs a read-modify-write on the fast
+// path: a push is a store + release fence and a pop is a store + full fence
+// that only escalates to a CAS when racing thieves for the very last task.
+//
+// Compared to iree_task_queue_t (a linked list under a futex) this removes all
+// contention between the owner and thieves except when the deque is nearly
+// empty and moves the theft cost entirely onto the thieves (where it belongs,
+// as they had nothing better to do anyway).
+//
+// The ring buffer is bounded to IREE_TASK_DEQUE_CAPACITY entries so that it
+// can be stored inline within the worker and never needs to be reallocated
+// (growing a Chase-Lev deque requires deferred reclamation of the old buffers
+// that thieves may still be reading). If the owner pushes more tasks than fit
+// the excess is placed in an owner-only overflow list that is not visible to
+// thieves; the overflow list is moved back into the ring as the owner pops.
+// Capacity should be chosen such that overflow is rare: workers only receive
+// new tasks in batches when they have run out of work and each batch is
+// usually bounded by the number of concurrently issued dispatches.
+//
+// Order of processing is chosen to match the FIFO behavior of the worker
+// mailbox: LIFO lists are pushed head-first so that the least-recently added
+// task ends up at the bottom of the deque and is popped first by the owner.
+// Thieves then take the most-recently added tasks from the top - which are the
+// ones the owner would have gotten to last.
+//
+//  +--------+ <- slots[top & mask]
+//  |  top   | <- stealers consume here: task = slots[top++]
+//  |        |
+//  |   ||   |
+//  |   vv   |
+//  | bottom | <- owner pushes here:    slots[bottom++] = task
+//  |        |    owner consumes here:  task = slots[--bottom]
+//  +--------+
+//
+// References:
+//   "Dynamic Circular Work-Stealing Deque":
+//   https://dl.acm.org/doi/10.1145/1073970.1073974
+//   "Correct and Efficient Work-Stealing for Weak Memory Models":
+//   https://fzn.fr/readings/ppopp13.pdf
+typedef struct iree_task_deque_t {
+  // Index of the next task thieves will steal. Only ever increases.
+  // LAYOUT: written by thieves and must not share a cache line with bottom.
+  iree_alignas(iree_hardware_destructive_interference_size)
+      iree_atomic_int64_t top;
+
+  // Index one past the most recently pushed task. Only written by the owner.
+  // LAYOUT: hammered by the owner and kept away from top.
+  iree_alignas(iree_hardware_destructive_interference_size)
+      iree_atomic_int64_t bottom;
+
+  // Owner-only FIFO list of tasks that did not fit in the ring buffer.
+  // Thieves cannot see these tasks until the owner moves them into the ring.
+  iree_task_list_t overflow_list;
+
+  // Ring buffer of iree_task_t* indexed by [top, bottom) & mask.
+  iree_atomic_intptr_t slots[IREE_TASK_DEQUE_CAPACITY];
+} iree_task_deque_t;
+
+static_assert((IREE_TASK_DEQUE_CAPACITY & (IREE_TASK_DEQUE_CAPACITY - 1)) == 0,
+              "deque capacity must be a power of two");
+
+// Initializes a work-stealing deque in-place.
+void iree_task_deque_initialize(iree_task_deque_t* out_deque);
+
+// Deinitializes a deque and discards all remaining tasks.
+// Must not be called while any other thread may be attempting to steal tasks.
+void iree_task_deque_deinitialize(iree_task_deque_t* deque);
+
+// Returns true if the deque (including its overflow list) is empty.
+//
+// Must only be called from the owning worker's thread.
+bool iree_task_deque_is_empty(iree_task_deque_t* deque);
+
+// Returns the approximate number of tasks that may be stolen from the deque.
+// Tasks in the owner-only overflow list are not included.
+iree_host_size_t iree_task_deque_stealable_count(iree_task_deque_t* deque);
+
+// Pushes a task onto the bottom of the deque; it will be the next task popped
+// by the owner unless more tasks are pushed.
+//
+// Must only be called from the owning worker's thread.
+void iree_task_deque_push(iree_task_deque_t* deque, iree_task_t* task);
+
+// Pushes a FIFO |list| of tasks onto the deque such that the head of the list
+// is the next task popped by the owner. |list| will be reset.
+//
+// Must only be called from the owning worker's thread.
+void iree_task_deque_push_fifo_list(iree_task_deque_t* deque,
+                                    iree_task_list_t* list);
+
+// Pushes a LIFO |list| of tasks onto the deque such that the tail of the list
+// (the least-recently added task) is the next task popped by the owner.
+// |list| will be reset.
+//
+// Must only be called from the owning worker's thread.
+void iree_task_deque_push_lifo_list(iree_task_deque_t* deque,
+                                    iree_task_list_t* list);
+
+// Flushes the |source_slist| LIFO mailbox into the deque.
+// Returns the next task to process upon success; the task may be pre-existing
+// or from the newly flushed tasks.
+//
+// Must only be called from the owning worker's thread.
+iree_task_t* iree_task_deque_flush_from_lifo_slist(
+    iree_task_deque_t* deque, iree_atomic_task_slist_t* source_slist);
+
+// Pops a task from the bottom of the deque if any are available.
+//
+// Must only be called from the owning worker's thread.
+iree_task_t* iree_task_deque_pop(iree_task_deque_t* deque);
+
+// Tries to steal a single task from the top of the deque.
+// Returns NULL if the deque is empty or the theft raced with the owner or
+// another thief.
+//
+// Safe to call from any thread.
+iree_task_t* iree_task_deque_steal(iree_task_deque_t* deque);
+
+// Tries to steal up to |max_tasks| from the top of the |source_deque|.
+// Returns NULL if no tasks are available and otherwise the first stolen task.
+// To amortize the cost of theft up to half of the stealable tasks (bounded by
+// |max_tasks|) will be taken and all but the returned task will be pushed onto
+// the |target_deque|.
+//
+// Must only be called from the thread owning |target_deque|.
+iree_task_t* iree_task_deque_try_steal(iree_task_deque_t* source_deque,
+                                       iree_task_deque_t* target_deque,
+                                       iree_host_size_t max_tasks);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_TASK_DEQUE_H_
@@ -0,0 +1,221 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "iree/task/deque.h"
+#include "iree/task/queue.h"
+
+namespace {
+
+// Number of tasks pushed/popped per benchmark iteration.
+constexpr int kBatchSize = 64;
+
+std::vector<iree_task_t> MakeTasks(size_t count) {
+  std::vector<iree_task_t> tasks(count);
+  memset(tasks.data(), 0, tasks.size() * sizeof(iree_task_t));
+  return tasks;
+}
+
+//==============================================================================
+// Owner-only push/pop
+//==============================================================================
+// Measures the uncontended fast path a worker hits when processing its own
+// tasks. The deque requires no read-modify-write operations here while the
+// queue must take its mutex on every operation.
+
+void BM_DequePushPop(benchmark::State& state) {
+  iree_task_deque_t* deque = new iree_task_deque_t();
+  iree_task_deque_initialize(deque);
+  auto tasks = MakeTasks(kBatchSize);
+  for (auto _ : state) {
+    for (int i = 0; i < kBatchSize; ++i) {
+      iree_task_deque_push(deque, &tasks[i]);
+    }
+    for (int i = 0; i < kBatchSize; ++i) {
+      benchmark::DoNotOptimize(iree_task_deque_pop(deque));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+  iree_task_deque_deinitialize(deque);
+  delete deque;
+}
+BENCHMARK(BM_DequePushPop);
+
+void BM_QueuePushPop(benchmark::State& state) {
+  iree_task_queue_t queue;
+  iree_task_queue_initialize(&queue);
+  auto tasks = MakeTasks(kBatchSize);
+  for (auto _ : state) {
+    for (int i = 0; i < kBatchSize; ++i) {
+      iree_task_queue_push_front(&queue, &tasks[i]);
+    }
+    for (int i = 0; i < kBatchSize; ++i) {
+      benchmark::DoNotOptimize(iree_task_queue_pop_front(&queue));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+  iree_task_queue_deinitialize(&queue);
+}
+BENCHMARK(BM_QueuePushPop);
+
+//==============================================================================
+// Batched mailbox flush
+//==============================================================================
+// Measures moving a batch of posted tasks from a worker mailbox into the local
+// work list and draining it, as happens each time a worker wakes.
+
+void BM_DequeFlushSlist(benchmark::State& state) {
+  iree_task_deque_t* deque = new iree_task_deque_t();
+  iree_task_deque_initialize(deque);
+  iree_atomic_task_slist_t slist;
+  iree_atomic_task_slist_initialize(&slist);
+  auto tasks = MakeTasks(kBatchSize);
+  for (auto _ : state) {
+    for (int i = 0; i < kBatchSize; ++i) {
+      iree_atomic_task_slist_push(&slist, &tasks[i]);
+    }
+    iree_task_t* task = iree_task_deque_flush_from_lifo_slist(deque, &slist);
+    while (task) {
+      benchmark::DoNotOptimize(task);
+      task = iree_task_deque_pop(deque);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+  iree_atomic_task_slist_deinitialize(&slist);
+  iree_task_deque_deinitialize(deque);
+  delete deque;
+}
+BENCHMARK(BM_DequeFlushSlist);
+
+void BM_QueueFlushSlist(benchmark::State& state) {
+  iree_task_queue_t queue;
+  iree_task_queue_initialize(&queue);
+  iree_atomic_task_slist_t slist;
+  iree_atomic_task_slist_initialize(&slist);
+  auto tasks = MakeTasks(kBatchSize);
+  for (auto _ : state) {
+    for (int i = 0; i < kBatchSize; ++i) {
+      iree_atomic_task_slist_push(&slist, &tasks[i]);
+    }
+    iree_task_t* task = iree_task_queue_flush_from_lifo_slist(&queue, &slist);
+    while (task) {
+      benchmark::DoNotOptimize(task);
+      task = iree_task_queue_pop_front(&queue);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+  iree_atomic_task_slist_deinitialize(&slist);
+  iree_task_queue_deinitialize(&queue);
+}
+BENCHMARK(BM_QueueFlushSlist);
+
+//==============================================================================
+// Contended owner + thieves
+//==============================================================================
+// The benchmark thread acts as the owner continuously pushing and popping
+// batches while |state.range(0)| thief threads try to steal from it into their
+// own local storage. This approximates a loaded worker being raided by idle
+// workers and shows how much the owner is slowed down by theft.
+//
+// Each iteration waits for all stolen tasks to be consumed before the tasks
+// are reused so that the intrusive task list pointers are never shared.
+
+template <typename Traits>
+void BM_ContendedSteal(benchmark::State& state) {
+  typename Traits::type* shared = Traits::Create();
+  auto tasks = MakeTasks(kBatchSize);
+  std::atomic<int> in_flight_count{0};
+  std::atomic<bool> done{false};
+  std::vector<std::thread> thieves;
+  for (int i = 0; i < state.range(0); ++i) {
+    thieves.emplace_back([&]() {
+      typename Traits::type* local = Traits::Create();
+      while (!done.load(std::memory_order_relaxed)) {
+        iree_task_t* task = Traits::TrySteal(shared, local);
+        while (task) {
+          benchmark::DoNotOptimize(task);
+          in_flight_count.fetch_sub(1, std::memory_order_release);
+          task = Traits::Pop(local);
+        }
+      }
+      Traits::Destroy(local);
+    });
+  }
+
+  for (auto _ : state) {
+    in_flight_count.store(kBatchSize, std::memory_order_relaxed);
+    for (int i = 0; i < kBatchSize; ++i) {
+      Traits::Push(shared, &tasks[i]);
+    }
+    while (iree_task_t* task = Traits::Pop(shared)) {
+      benchmark::DoNotOptimize(task);
+      in_flight_count.fetch_sub(1, std::memory_order_release);
+    }
+    while (in_flight_count.load(std::memory_order_acquire) > 0) {
+      // Wait for thieves to finish with the tasks they took.
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+
+  done = true;
+  for (auto& thread : thieves) thread.join();
+  Traits::Destroy(shared);
+}
+
+struct DequeTraits {
+  using type = iree_task_deque_t;
+  static type* Create() {
+    auto* deque = new iree_task_deque_t();
+    iree_task_deque_initialize(deque);
+    return deque;
+  }
+  // NOTE: all tasks have been consumed and there is nothing to discard.
+  static void Destroy(type* deque) { delete deque; }
+  static void Push(type* deque, iree_task_t* task) {
+    iree_task_deque_push(deque, task);
+  }
+  static iree_task_t* Pop(type* deque) { return iree_task_deque_pop(deque); }
+  static iree_task_t* TrySteal(type* source, type* target) {
+    return iree_task_deque_try_steal(source, target,
+                                     IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT);
+  }
+};
+BENCHMARK_TEMPLATE(BM_ContendedSteal, DequeTraits)
+    ->UseRealTime()
+    ->DenseRange(0, 4);
+
+struct QueueTraits {
+  using type = iree_task_queue_t;
+  static type* Create() {
+    auto* queue = new iree_task_queue_t();
+    iree_task_queue_initialize(queue);
+    return queue;
+  }
+  static void Destroy(type* queue) {
+    iree_task_queue_deinitialize(queue);
+    delete queue;
+  }
+  static void Push(type* queue, iree_task_t* task) {
+    iree_task_queue_push_front(queue, task);
+  }
+  static iree_task_t* Pop(type* queue) {
+    return iree_task_queue_pop_front(queue);
+  }
+  static iree_task_t* TrySteal(type* source, type* target) {
+    return iree_task_queue_try_steal(source, target,
+                                     IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT);
+  }
+};
+BENCHMARK_TEMPLATE(BM_ContendedSteal, QueueTraits)
+    ->UseRealTime()
+    ->DenseRange(0, 4);
+
+}  // namespace
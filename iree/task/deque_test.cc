@@ -0,0 +1,321 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/task/deque.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "iree/testing/gtest.h"
+
+namespace {
+
+TEST(DequeTest, Lifetime) {
+  iree_task_deque_t deque;
+  iree_task_deque_initialize(&deque);
+  iree_task_deque_deinitialize(&deque);
+}
+
+TEST(DequeTest, Empty) {
+  iree_task_deque_t deque;
+  iree_task_deque_initialize(&deque);
+  EXPECT_TRUE(iree_task_deque_is_empty(&deque));
+  EXPECT_EQ(0, iree_task_deque_stealable_count(&deque));
+  EXPECT_FALSE(iree_task_deque_pop(&deque));
+  EXPECT_FALSE(iree_task_deque_steal(&deque));
+  EXPECT_TRUE(iree_task_deque_is_empty(&deque));
+  iree_task_deque_deinitialize(&deque);
+}
+
+TEST(DequeTest, PushPop) {
+  iree_task_deque_t deque;
+  iree_task_deque_initialize(&deque);
+
+  iree_task_t task_a = {0};
+  iree_task_deque_push(&deque, &task_a);
+  EXPECT_FALSE(iree_task_deque_is_empty(&deque));
+
+  iree_task_t task_b = {0};
+  iree_task_deque_push(&deque, &task_b);
+  EXPECT_EQ(2, iree_task_deque_stealable_count(&deque));
+
+  // Owner pops in LIFO order.
+  EXPECT_EQ(&task_b, iree_task_deque_pop(&deque));
+  EXPECT_FALSE(iree_task_deque_is_empty(&deque));
+  EXPECT_EQ(&task_a, iree_task_deque_pop(&deque));
+  EXPECT_TRUE(iree_task_deque_is_empty(&deque));
+  EXPECT_FALSE(iree_task_deque_pop(&deque));
+
+  iree_task_deque_deinitialize(&deque);
+}
+
+TEST(DequeTest, PushSteal) {
+  iree_task_deque_t deque;
+  iree_task_deque_initialize(&deque);
+
+  iree_task_t task_a = {0};
+  iree_task_deque_push(&deque, &task_a);
+  iree_task_t task_b = {0};
+  iree_task_deque_push(&deque, &task_b);
+
+  // Thieves steal in FIFO order.
+  EXPECT_EQ(&task_a, iree_task_deque_steal(&deque));
+  EXPECT_EQ(&task_b, iree_task_deque_steal(&deque));
+  EXPECT_FALSE(iree_task_deque_steal(&deque));
+  EXPECT_TRUE(iree_task_deque_is_empty(&deque));
+
+  iree_task_deque_deinitialize(&deque);
+}
+
+TEST(DequeTest, PushLifoListEmpty) {
+  iree_task_deque_t deque;
+  iree_task_deque_initialize(&deque);
+
+  iree_task_list_t list = {0};
+  iree_task_deque_push_lifo_list(&deque, &list);
+  EXPECT_TRUE(iree_task_deque_is_empty(&deque));
+  EXPECT_TRUE(iree_task_list_is_empty(&list));
+
+  iree_task_deque_deinitialize(&deque);
+}
+
+TEST(DequeTest, PushLifoListOrdered) {
+  iree_task_deque_t deque;
+  iree_task_deque_initialize(&deque);
+
+  // Make a lifo list: c<-b<-a.
+  iree_task_list_t list = {0};
+  iree_task_t task_a = {0};
+  iree_task_list_push_front(&list, &task_a);
+  iree_task_t task_b = {0};
+  iree_task_list_push_front(&list, &task_b);
+  iree_task_t task_c = {0};
+  iree_task_list_push_front(&list, &task_c);
+
+  iree_task_deque_push_lifo_list(&deque, &list);
+  EXPECT_TRUE(iree_task_list_is_empty(&list));
+  EXPECT_EQ(3, iree_task_deque_stealable_count(&deque));
+
+  // Owner pops the least-recently added first while thieves take the most
+  // recently added.
+  EXPECT_EQ(&task_a, iree_task_deque_pop(&deque));
+  EXPECT_EQ(&task_c, iree_task_deque_steal(&deque));
+  EXPECT_EQ(&task_b, iree_task_deque_pop(&deque));
+  EXPECT_TRUE(iree_task_deque_is_empty(&deque));
+
+  iree_task_deque_deinitialize(&deque);
+}
+
+TEST(DequeTest, FlushSlistEmpty) {
+  iree_task_deque_t deque;
+  iree_task_deque_initialize(&deque);
+
+  iree_atomic_task_slist_t slist;
+  iree_atomic_task_slist_initialize(&slist);
+
+  EXPECT_FALSE(iree_task_deque_flush_from_lifo_slist(&deque, &slist));
+  EXPECT_TRUE(iree_task_deque_is_empty(&deque));
+
+  iree_atomic_task_slist_deinitialize(&slist);
+  iree_task_deque_deinitialize(&deque);
+}
+
+TEST(DequeTest, FlushSlistOrdered) {
+  iree_task_deque_t deque;
+  iree_task_deque_initialize(&deque);
+
+  // Make a lifo list: c<-b<-a.
+  iree_atomic_task_slist_t slist;
+  iree_atomic_task_slist_initialize(&slist);
+  iree_task_t task_a = {0};
+  iree_atomic_task_slist_push(&slist, &task_a);
+  iree_task_t task_b = {0};
+  iree_atomic_task_slist_push(&slist, &task_b);
+  iree_task_t task_c = {0};
+  iree_atomic_task_slist_push(&slist, &task_c);
+
+  // Flush the list to the deque; it should return the first task.
+  EXPECT_EQ(&task_a, iree_task_deque_flush_from_lifo_slist(&deque, &slist));
+  EXPECT_FALSE(iree_task_deque_is_empty(&deque));
+
+  // Pop and ensure order: [a->]b->c.
+  EXPECT_EQ(&task_b, iree_task_deque_pop(&deque));
+  EXPECT_EQ(&task_c, iree_task_deque_pop(&deque));
+  EXPECT_TRUE(iree_task_deque_is_empty(&deque));
+
+  iree_atomic_task_slist_deinitialize(&slist);
+  iree_task_deque_deinitialize(&deque);
+}
+
+// Tests that pushing more tasks than fit in the ring spills into the overflow
+// list and that all tasks are still returned in order.
+TEST(DequeTest, Overflow) {
+  iree_task_deque_t deque;
+  iree_task_deque_initialize(&deque);
+
+  static const int kTaskCount = IREE_TASK_DEQUE_CAPACITY * 2 + 3;
+  std::vector<iree_task_t> tasks(kTaskCount);
+  memset(tasks.data(), 0, tasks.size() * sizeof(iree_task_t));
+  iree_task_list_t list = {0};
+  for (int i = 0; i < kTaskCount; ++i) {
+    iree_task_list_push_front(&list, &tasks[i]);
+  }
+  iree_task_deque_push_lifo_list(&deque, &list);
+  EXPECT_TRUE(iree_task_list_is_empty(&list));
+  EXPECT_EQ(IREE_TASK_DEQUE_CAPACITY, iree_task_deque_stealable_count(&deque));
+
+  for (int i = 0; i < kTaskCount; ++i) {
+    EXPECT_EQ(&tasks[i], iree_task_deque_pop(&deque));
+  }
+  EXPECT_TRUE(iree_task_deque_is_empty(&deque));
+  EXPECT_FALSE(iree_task_deque_pop(&deque));
+
+  iree_task_deque_deinitialize(&deque);
+}
+
+TEST(DequeTest, TryStealEmpty) {
+  iree_task_deque_t source_deque;
+  iree_task_deque_initialize(&source_deque);
+  iree_task_deque_t target_deque;
+  iree_task_deque_initialize(&target_deque);
+
+  EXPECT_FALSE(iree_task_deque_try_steal(&source_deque, &target_deque, 100));
+  EXPECT_TRUE(iree_task_deque_is_empty(&target_deque));
+
+  iree_task_deque_deinitialize(&source_deque);
+  iree_task_deque_deinitialize(&target_deque);
+}
+
+TEST(DequeTest, TryStealLast) {
+  iree_task_deque_t source_deque;
+  iree_task_deque_initialize(&source_deque);
+  iree_task_deque_t target_deque;
+  iree_task_deque_initialize(&target_deque);
+
+  iree_task_t task_a = {0};
+  iree_task_deque_push(&source_deque, &task_a);
+
+  EXPECT_EQ(&task_a,
+            iree_task_deque_try_steal(&source_deque, &target_deque, 100));
+  EXPECT_TRUE(iree_task_deque_is_empty(&target_deque));
+  EXPECT_TRUE(iree_task_deque_is_empty(&source_deque));
+
+  iree_task_deque_deinitialize(&source_deque);
+  iree_task_deque_deinitialize(&target_deque);
+}
+
+TEST(DequeTest, TryStealHalf) {
+  iree_task_deque_t source_deque;
+  iree_task_deque_initialize(&source_deque);
+  iree_task_deque_t target_deque;
+  iree_task_deque_initialize(&target_deque);
+
+  // Owner will process a->b->c->d; thieves take from the end.
+  iree_task_t task_a = {0};
+  iree_task_t task_b = {0};
+  iree_task_t task_c = {0};
+  iree_task_t task_d = {0};
+  iree_task_deque_push(&source_deque, &task_d);
+  iree_task_deque_push(&source_deque, &task_c);
+  iree_task_deque_push(&source_deque, &task_b);
+  iree_task_deque_push(&source_deque, &task_a);
+
+  EXPECT_EQ(&task_d,
+            iree_task_deque_try_steal(&source_deque, &target_deque, 1000));
+  EXPECT_EQ(&task_c, iree_task_deque_pop(&target_deque));
+  EXPECT_TRUE(iree_task_deque_is_empty(&target_deque));
+
+  EXPECT_EQ(&task_a, iree_task_deque_pop(&source_deque));
+  EXPECT_EQ(&task_b, iree_task_deque_pop(&source_deque));
+  EXPECT_TRUE(iree_task_deque_is_empty(&source_deque));
+
+  iree_task_deque_deinitialize(&source_deque);
+  iree_task_deque_deinitialize(&target_deque);
+}
+
+TEST(DequeTest, TryStealMaxTasks) {
+  iree_task_deque_t source_deque;
+  iree_task_deque_initialize(&source_deque);
+  iree_task_deque_t target_deque;
+  iree_task_deque_initialize(&target_deque);
+
+  iree_task_t task_a = {0};
+  iree_task_t task_b = {0};
+  iree_task_t task_c = {0};
+  iree_task_t task_d = {0};
+  iree_task_deque_push(&source_deque, &task_d);
+  iree_task_deque_push(&source_deque, &task_c);
+  iree_task_deque_push(&source_deque, &task_b);
+  iree_task_deque_push(&source_deque, &task_a);
+
+  EXPECT_EQ(&task_d,
+            iree_task_deque_try_steal(&source_deque, &target_deque, 1));
+  EXPECT_TRUE(iree_task_deque_is_empty(&target_deque));
+  EXPECT_EQ(3, iree_task_deque_stealable_count(&source_deque));
+
+  iree_task_deque_deinitialize(&source_deque);
+  iree_task_deque_deinitialize(&target_deque);
+}
+
+// Hammers a single deque with one owner pushing/popping and several thieves
+// stealing and ensures every task is consumed exactly once.
+TEST(DequeTest, ConcurrentStealing) {
+  static const int kThiefCount = 4;
+  static const int kTaskCount = 64 * 1024;
+  static const int kBatchSize = 37;
+
+  iree_task_deque_t deque;
+  iree_task_deque_initialize(&deque);
+
+  std::vector<iree_task_t> tasks(kTaskCount);
+  memset(tasks.data(), 0, tasks.size() * sizeof(iree_task_t));
+  std::vector<std::atomic<int>> consume_counts(kTaskCount);
+  for (auto& count : consume_counts) count = 0;
+  auto consume = [&](iree_task_t* task) {
+    consume_counts[task - tasks.data()].fetch_add(1);
+  };
+
+  std::atomic<bool> done{false};
+  std::vector<std::thread> thieves;
+  for (int i = 0; i < kThiefCount; ++i) {
+    thieves.emplace_back([&]() {
+      while (!done.load()) {
+        iree_task_t* task = iree_task_deque_steal(&deque);
+        if (task) consume(task);
+      }
+    });
+  }
+
+  // Owner: push in batches and pop some of each batch to race the thieves at
+  // both ends of the deque.
+  for (int base = 0; base < kTaskCount; base += kBatchSize) {
+    int end = std::min(base + kBatchSize, kTaskCount);
+    for (int i = base; i < end; ++i) {
+      iree_task_deque_push(&deque, &tasks[i]);
+    }
+    for (int i = 0; i < kBatchSize / 2; ++i) {
+      iree_task_t* task = iree_task_deque_pop(&deque);
+      if (!task) break;
+      consume(task);
+    }
+  }
+  iree_task_t* task = NULL;
+  while ((task = iree_task_deque_pop(&deque)) != NULL) {
+    consume(task);
+  }
+  done = true;
+  for (auto& thread : thieves) thread.join();
+
+  EXPECT_TRUE(iree_task_deque_is_empty(&deque));
+  for (int i = 0; i < kTaskCount; ++i) {
+    ASSERT_EQ(1, consume_counts[i].load()) << "task " << i;
+  }
+
+  iree_task_deque_deinitialize(&deque);
+}
+
+}  // namespace
@@ -0,0 +1,97 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <chrono>
+
+#include "benchmark/benchmark.h"
+#include "iree/base/api.h"
+#include "iree/task/executor.h"
+#include "iree/task/scope.h"
+#include "iree/task/submission.h"
+#include "iree/task/task.h"
+#include "iree/task/topology.h"
+
+namespace {
+
+// Number of workers in the executor; small enough to saturate on most hosts.
+constexpr iree_host_size_t kWorkerCount = 4;
+
+// Busy-waits for |duration_ns| to simulate a tile doing real work.
+iree_status_t SpinTile(void* user_context,
+                       const iree_task_tile_context_t* tile_context,
+                       iree_task_submission_t* pending_submission) {
+  int64_t duration_ns = (int64_t)(intptr_t)user_context;
+  if (duration_ns == 0) return iree_ok_status();
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::nanoseconds(duration_ns);
+  while (std::chrono::steady_clock::now() < deadline) {
+  }
+  return iree_ok_status();
+}
+
+//==============================================================================
+// Dispatch throughput
+//==============================================================================
+// Submits a single dispatch of |state.range(0)| tiles each taking
+// |state.range(1)| nanoseconds and waits for it to complete. With many cheap
+// tiles the cost of reserving tiles from the shared grid dominates and with
+// fewer expensive tiles the imbalance at the tail of the grid does.
+//
+// Reported times are per dispatch and the number of tile reservations made
+// per dispatch is reported as a counter (when statistics are enabled).
+
+void BM_Dispatch(benchmark::State& state) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(kWorkerCount, &topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(iree_task_executor_create(
+      IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+      /*worker_local_memory_size=*/0, iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("dispatch"), &scope);
+
+  const uint32_t tile_count = (uint32_t)state.range(0);
+  const iree_task_dispatch_closure_t closure = iree_task_make_dispatch_closure(
+      SpinTile, (void*)(intptr_t)state.range(1));
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {tile_count, 1, 1};
+  for (auto _ : state) {
+    iree_task_dispatch_t dispatch;
+    iree_task_dispatch_initialize(&scope, closure, workgroup_size,
+                                  workgroup_count, &dispatch);
+    iree_task_fence_t* fence = NULL;
+    IREE_CHECK_OK(iree_task_executor_acquire_fence(executor, &scope, &fence));
+    iree_task_set_completion_task(&dispatch.header, &fence->header);
+
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    iree_task_submission_enqueue(&submission, &dispatch.header);
+    iree_task_executor_submit(executor, &submission);
+    iree_task_executor_flush(executor);
+    IREE_CHECK_OK(iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+  }
+  state.SetItemsProcessed(state.iterations() * tile_count);
+
+#if IREE_STATISTICS_ENABLE
+  iree_task_dispatch_statistics_t statistics;
+  iree_task_scope_query_statistics(&scope, &statistics);
+  state.counters["reservations"] = benchmark::Counter(
+      (double)statistics.reservation_count, benchmark::Counter::kAvgIterations);
+#endif  // IREE_STATISTICS_ENABLE
+
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+}
+BENCHMARK(BM_Dispatch)
+    ->ArgNames({"tiles", "tile_ns"})
+    ->ArgsProduct({{64, 1024, 16384}, {0, 500, 20000}})
+    ->MeasureProcessCPUTime()
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace
@@ -13,11 +13,11 @@
 #include "iree/base/internal/math.h"
 #include "iree/base/tracing.h"
 #include "iree/task/affinity_set.h"
+#include "iree/task/deque.h"
 #include "iree/task/executor_impl.h"
 #include "iree/task/list.h"
 #include "iree/task/pool.h"
 #include "iree/task/post_batch.h"
-#include "iree/task/queue.h"
 #include "iree/task/task_impl.h"
 #include "iree/task/tuning.h"
 #include "iree/task/worker.h"
@@ -37,13 +37,13 @@ iree_status_t iree_task_executor_create(
         IREE_TASK_EXECUTOR_MAX_WORKER_COUNT);
   }
 
-  // TODO(benvanik): support a threadless mode where we have one dummy worker
-  // that just holds the lists but is pumped from donate_caller.
-  if (worker_count == 0) {
-    return iree_make_status(
-        IREE_STATUS_UNIMPLEMENTED,
-        "threadless donate-only executor mode not yet implemented");
-  }
+  // A topology with no groups creates a threadless executor: a single worker
+  // without a thread holds all posted tasks and is pumped by whichever thread
+  // is donated to the executor. Otherwise we allocate an additional threadless
+  // worker that donated threads use to steal work from the real workers.
+  bool is_threadless = worker_count == 0;
+  iree_host_size_t total_worker_count = worker_count + 1;
+  if (is_threadless) worker_count = 1;
 
   IREE_TRACE_ZONE_BEGIN(z0);
   IREE_ASSERT_ARGUMENT(out_executor);
@@ -58,10 +58,11 @@ iree_status_t iree_task_executor_create(
       iree_host_align(sizeof(iree_task_executor_t),
                       iree_hardware_destructive_interference_size);
   iree_host_size_t worker_list_size =
-      iree_host_align(worker_count * sizeof(iree_task_worker_t),
+      iree_host_align(total_worker_count * sizeof(iree_task_worker_t),
                       iree_hardware_destructive_interference_size);
-  iree_host_size_t executor_size = executor_base_size + worker_list_size +
-                                   worker_count * worker_local_memory_size;
+  iree_host_size_t executor_size =
+      executor_base_size + worker_list_size +
+      total_worker_count * worker_local_memory_size;
 
   iree_task_executor_t* executor = NULL;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
@@ -70,10 +71,16 @@ iree_status_t iree_task_executor_create(
   iree_atomic_ref_count_init(&executor->ref_count);
   executor->allocator = allocator;
   executor->scheduling_mode = scheduling_mode;
+  executor->numa_node = iree_task_topology_numa_node(topology);
+  executor->worker_cache_size = iree_task_topology_cache_size(topology);
   iree_atomic_task_slist_initialize(&executor->incoming_ready_slist);
   iree_atomic_task_slist_initialize(&executor->incoming_waiting_slist);
   iree_slim_mutex_initialize(&executor->coordinator_mutex);
   iree_slim_mutex_initialize(&executor->wait_mutex);
+  iree_slim_mutex_initialize(&executor->donation_mutex);
+  iree_notification_set_initialize(&executor->worker_wake_notifications);
+  executor->waiting_deadline_ns = IREE_TIME_INFINITE_FUTURE;
+  executor->waiting_scope_epoch = iree_task_scope_change_epoch();
 
   // Simple PRNG used to generate seeds for the per-worker PRNGs used to
   // distribute work. This isn't strong (and doesn't need to be); it's just
@@ -98,11 +105,22 @@ iree_status_t iree_task_executor_create(
   }
 
   // Wait set used to batch syscalls for polling/waiting on wait handles.
-  // This is currently limited to a relatively small max to make bad behavior
-  // clearer with nice RESOURCE_EXHAUSTED errors.
+  // Where the wait set is bounded (poll/WFMO) this limits the number of
+  // outstanding waits and insertions beyond it fail the waiting scope with
+  // RESOURCE_EXHAUSTED; epoll-based sets grow as needed. One additional slot
+  // is used for our own wake event.
+  if (iree_status_is_ok(status)) {
+    status =
+        iree_wait_set_allocate(IREE_TASK_EXECUTOR_MAX_OUTSTANDING_WAITS + 1,
+                               allocator, &executor->wait_set);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_event_initialize(/*initial_state=*/false,
+                                   &executor->wait_wake_event);
+  }
   if (iree_status_is_ok(status)) {
-    status = iree_wait_set_allocate(IREE_TASK_EXECUTOR_MAX_OUTSTANDING_WAITS,
-                                    allocator, &executor->wait_set);
+    status =
+        iree_wait_set_insert(executor->wait_set, executor->wait_wake_event);
   }
 
   // Pool used for all fanout tasks. These only live within the executor and
@@ -128,22 +146,55 @@ iree_status_t iree_task_executor_create(
     iree_task_affinity_set_t worker_idle_mask = 0;
     iree_task_affinity_set_t worker_live_mask = 0;
     iree_task_affinity_set_t worker_suspend_mask = 0;
-    for (iree_host_size_t i = 0; i < worker_count; ++i) {
-      iree_task_affinity_set_t worker_bit = iree_task_affinity_for_worker(i);
-      worker_idle_mask |= worker_bit;
-      worker_live_mask |= worker_bit;
-      if (executor->scheduling_mode &
-          IREE_TASK_SCHEDULING_MODE_DEFER_WORKER_STARTUP) {
-        worker_suspend_mask |= worker_bit;
+    if (is_threadless) {
+      // The only worker is the donation worker and all tasks are posted to it.
+      worker_idle_mask = worker_live_mask = iree_task_affinity_for_worker(0);
+      executor->donation_worker = &executor->workers[0];
+      iree_task_worker_initialize_donated(
+          executor, iree_task_affinity_for_worker(0),
+          /*constructive_sharing_mask=*/0, /*max_theft_attempts=*/0,
+          iree_make_byte_span(worker_local_memory, worker_local_memory_size),
+          &seed_prng, executor->donation_worker);
+    } else {
+      for (iree_host_size_t i = 0; i < worker_count; ++i) {
+        iree_task_affinity_set_t worker_bit = iree_task_affinity_for_worker(i);
+        worker_idle_mask |= worker_bit;
+        worker_live_mask |= worker_bit;
+        if (executor->scheduling_mode &
+            IREE_TASK_SCHEDULING_MODE_DEFER_WORKER_STARTUP) {
+          worker_suspend_mask |= worker_bit;
+        }
+
+        // Workers only steal from others on the same NUMA node unless the
+        // user has asked otherwise.
+        const iree_task_topology_group_t* group =
+            iree_task_topology_get_group(topology, i);
+        iree_task_affinity_set_t theft_victim_mask =
+            iree_task_affinity_for_any_worker();
+        if (!(executor->scheduling_mode &
+              IREE_TASK_SCHEDULING_MODE_CROSS_NUMA_NODE_STEALING)) {
+          theft_victim_mask = iree_task_topology_group_mask_for_numa_node(
+              topology, group->numa_node);
+        }
+
+        iree_task_worker_t* worker = &executor->workers[i];
+        status = iree_task_worker_initialize(
+            executor, i, group, theft_victim_mask,
+            iree_make_byte_span(worker_local_memory, worker_local_memory_size),
+            &seed_prng, worker);
+        worker_local_memory += worker_local_memory_size;
+        if (!iree_status_is_ok(status)) break;
       }
 
-      iree_task_worker_t* worker = &executor->workers[i];
-      status = iree_task_worker_initialize(
-          executor, i, iree_task_topology_get_group(topology, i),
+      // The donation worker has no bit in any mask and is never posted to; it
+      // is free to steal from any of the workers.
+      executor->donation_worker = &executor->workers[worker_count];
+      iree_task_worker_initialize_donated(
+          executor, /*worker_bit=*/0,
+          /*constructive_sharing_mask=*/iree_task_affinity_for_any_worker(),
+          /*max_theft_attempts=*/worker_count,
           iree_make_byte_span(worker_local_memory, worker_local_memory_size),
-          &seed_prng, worker);
-      worker_local_memory += worker_local_memory_size;
-      if (!iree_status_is_ok(status)) break;
+          &seed_prng, executor->donation_worker);
     }
     iree_atomic_task_affinity_set_store(&executor->worker_live_mask,
                                         worker_live_mask,
@@ -187,9 +238,16 @@ static void iree_task_executor_destroy(iree_task_executor_t* executor) {
     iree_task_worker_t* worker = &executor->workers[i];
     iree_task_worker_deinitialize(worker);
   }
+  if (executor->donation_worker &&
+      !iree_task_executor_is_threadless(executor)) {
+    iree_task_worker_deinitialize(executor->donation_worker);
+  }
 
   iree_wait_set_free(executor->wait_set);
+  iree_event_deinitialize(&executor->wait_wake_event);
   iree_event_pool_free(executor->event_pool);
+  iree_notification_set_deinitialize(&executor->worker_wake_notifications);
+  iree_slim_mutex_deinitialize(&executor->donation_mutex);
   iree_slim_mutex_deinitialize(&executor->wait_mutex);
   iree_slim_mutex_deinitialize(&executor->coordinator_mutex);
   iree_atomic_task_slist_deinitialize(&executor->incoming_ready_slist);
@@ -213,12 +271,96 @@ void iree_task_executor_release(iree_task_executor_t* executor) {
 }
 
 void iree_task_executor_trim(iree_task_executor_t* executor) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
   // TODO(benvanik): figure out a good way to do this; the pools require that
   // no tasks are in-flight to trim but our caller can't reliably make that
   // guarantee. We'd need some global executor lock that we did here and
   // on submit - or rework pools to not have this limitation.
   // iree_task_pool_trim(&executor->fence_task_pool);
   // iree_task_pool_trim(&executor->transient_task_pool);
+
+  // Worker local memory may be in use by a running dispatch and can only be
+  // released by the worker owning it. Ask all workers to trim and wake any
+  // that are idle so that they do so immediately instead of on their next
+  // wake.
+  iree_task_affinity_set_t worker_mask = 0;
+  for (iree_host_size_t i = 0; i < executor->worker_count; ++i) {
+    iree_task_worker_request_trim(&executor->workers[i]);
+    worker_mask |= executor->workers[i].worker_bit;
+  }
+  if (!iree_task_executor_is_threadless(executor)) {
+    iree_task_worker_request_trim(executor->donation_worker);
+    iree_notification_set_post(&executor->worker_wake_notifications,
+                               worker_mask);
+  }
+
+  // The donation worker is only pumped by donated threads and trims when one
+  // finishes pumping; if none is pumping now we can trim it ourselves.
+  if (iree_slim_mutex_try_lock(&executor->donation_mutex)) {
+    iree_task_worker_trim_if_requested(executor->donation_worker);
+    iree_slim_mutex_unlock(&executor->donation_mutex);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+void iree_task_executor_reserve_worker_local_memory(
+    iree_task_executor_t* executor, iree_host_size_t local_memory_size) {
+  int64_t desired = (int64_t)local_memory_size;
+  int64_t current = iree_atomic_load_int64(
+      &executor->worker_local_memory_reservation, iree_memory_order_relaxed);
+  while (current < desired &&
+         !iree_atomic_compare_exchange_weak_int64(
+             &executor->worker_local_memory_reservation, &current, desired,
+             iree_memory_order_relaxed, iree_memory_order_relaxed)) {
+    // |current| is updated on failure; retry until reserved or superseded.
+  }
+}
+
+void iree_task_executor_statistics_merge(
+    const iree_task_executor_statistics_t* source,
+    iree_task_executor_statistics_t* target) {
+#if IREE_STATISTICS_ENABLE
+  target->task_count += source->task_count;
+  target->tile_count += source->tile_count;
+  target->steal_attempt_count += source->steal_attempt_count;
+  target->steal_success_count += source->steal_success_count;
+  target->coordinator_acquire_count += source->coordinator_acquire_count;
+  target->sleep_count += source->sleep_count;
+  target->wake_count += source->wake_count;
+  target->execute_duration_ns += source->execute_duration_ns;
+  target->coordinate_duration_ns += source->coordinate_duration_ns;
+  target->steal_duration_ns += source->steal_duration_ns;
+  target->sleep_duration_ns += source->sleep_duration_ns;
+#endif  // IREE_STATISTICS_ENABLE
+}
+
+void iree_task_executor_query_statistics(
+    iree_task_executor_t* executor,
+    iree_task_executor_statistics_t* out_statistics) {
+  memset(out_statistics, 0, sizeof(*out_statistics));
+#if IREE_STATISTICS_ENABLE
+  for (iree_host_size_t i = 0; i < executor->worker_count; ++i) {
+    iree_task_worker_statistics_query(&executor->workers[i].statistics,
+                                      out_statistics);
+  }
+  if (!iree_task_executor_is_threadless(executor)) {
+    iree_task_worker_statistics_query(&executor->donation_worker->statistics,
+                                      out_statistics);
+  }
+  iree_task_worker_statistics_query(&executor->coordinator_statistics,
+                                    out_statistics);
+#endif  // IREE_STATISTICS_ENABLE
+}
+
+uint32_t iree_task_executor_numa_node(iree_task_executor_t* executor) {
+  return executor->numa_node;
+}
+
+iree_host_size_t iree_task_executor_worker_cache_size(
+    iree_task_executor_t* executor) {
+  return executor->worker_cache_size;
 }
 
 iree_event_pool_t* iree_task_executor_event_pool(
@@ -252,6 +394,35 @@ static void iree_task_executor_relay_to_worker(
   iree_task_post_batch_enqueue(post_batch, worker_index, task);
 }
 
+// Stably reorders the FIFO |list| such that tasks from higher priority scopes
+// come first. Tasks of the same priority retain their relative order.
+static void iree_task_executor_sort_by_priority(iree_task_list_t* list) {
+  // Fast-path for the common case of all tasks having the same priority.
+  iree_task_t* head = iree_task_list_front(list);
+  if (!head) return;
+  const iree_task_scope_priority_t head_priority = iree_task_priority(head);
+  bool is_uniform = true;
+  for (iree_task_t* task = head->next_task; task; task = task->next_task) {
+    if (iree_task_priority(task) != head_priority) {
+      is_uniform = false;
+      break;
+    }
+  }
+  if (is_uniform) return;
+
+  iree_task_list_t lane_lists[IREE_TASK_SCOPE_PRIORITY_COUNT];
+  for (int i = 0; i < IREE_TASK_SCOPE_PRIORITY_COUNT; ++i) {
+    iree_task_list_initialize(&lane_lists[i]);
+  }
+  iree_task_t* task = NULL;
+  while ((task = iree_task_list_pop_front(list))) {
+    iree_task_list_push_back(&lane_lists[iree_task_priority(task)], task);
+  }
+  for (int i = IREE_TASK_SCOPE_PRIORITY_COUNT - 1; i >= 0; --i) {
+    iree_task_list_append(list, &lane_lists[i]);
+  }
+}
+
 // Schedules all ready tasks in the |pending_submission| list.
 // Task may enqueue zero or more new tasks (or newly-ready/waiting tasks) to
 // |pending_submission| or queue work for posting to workers via the
@@ -262,12 +433,16 @@ static void iree_task_executor_relay_to_worker(
 // least recently added tasks from the submission (nice in-order traversal) we
 // are pushing them as what will become the least recent tasks in the batch.
 //
+// Tasks from higher priority scopes are scheduled ahead of lower priority ones
+// such that they get first pick of any idle workers.
+//
 // Only called during coordination and expects the coordinator lock to be held.
 void iree_task_executor_schedule_ready_tasks(
     iree_task_executor_t* executor, iree_task_submission_t* pending_submission,
     iree_task_post_batch_t* post_batch) {
   if (iree_task_list_is_empty(&pending_submission->ready_list)) return;
   IREE_TRACE_ZONE_BEGIN(z0);
+  iree_task_executor_sort_by_priority(&pending_submission->ready_list);
   iree_task_t* task = NULL;
   while ((task = iree_task_list_pop_front(&pending_submission->ready_list))) {
     // If the scope has been marked as failing then we abort the task.
@@ -373,28 +548,145 @@ void iree_task_executor_flush(iree_task_executor_t* executor) {
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Acquires the wait lock guarding the wait_set. If another thread holds it
+// while blocked waiting then it is woken so that the lock is released promptly.
+//
+// Only called during coordination and expects the coordinator lock to be held.
+static void iree_task_executor_lock_wait_set(iree_task_executor_t* executor) {
+  if (iree_slim_mutex_try_lock(&executor->wait_mutex)) return;
+  iree_event_set(&executor->wait_wake_event);
+  iree_slim_mutex_lock(&executor->wait_mutex);
+}
+
+// Returns true if |wake_handle| is the executor wake event (and not a task).
+static bool iree_task_executor_is_wake_handle(iree_task_executor_t* executor,
+                                              iree_wait_handle_t wake_handle) {
+  return wake_handle.type == executor->wait_wake_event.type &&
+         memcmp(&wake_handle.value, &executor->wait_wake_event.value,
+                sizeof(wake_handle.value)) == 0;
+}
+
+// Removes |wait_task| from the wait_set and discards it. |prev_task| must be
+// the task preceding it in |list| or NULL if it is at the head.
+//
+// Only called during coordination and expects the coordinator lock to be held.
+// The wait lock must be held as the wait_set is modified.
+static void iree_task_executor_discard_wait(iree_task_executor_t* executor,
+                                            iree_task_list_t* list,
+                                            iree_task_t* prev_task,
+                                            iree_task_wait_t* wait_task) {
+  iree_wait_set_erase(executor->wait_set, wait_task->wait_handle);
+  iree_task_list_erase(list, prev_task, &wait_task->header);
+  iree_task_list_t discard_worklist;
+  iree_task_list_initialize(&discard_worklist);
+  iree_task_discard(&wait_task->header, &discard_worklist);
+  iree_task_list_discard(&discard_worklist);
+}
+
+// Discards all waiting tasks from scopes that have failed, been aborted, or
+// passed their deadline. Returns the earliest deadline of the scopes of the
+// remaining waiting tasks.
+//
+// The waiting list is only rescanned if a scope has changed or a deadline
+// passed since the last scan so that coordinators with many long-lived waits
+// outstanding don't have to touch every task each time.
+//
+// Only called during coordination and expects the coordinator lock to be held.
+// The wait lock must be held as the wait_set is modified.
+static iree_time_t iree_task_executor_discard_failed_waits(
+    iree_task_executor_t* executor) {
+  // NOTE: the epoch must be read prior to scanning so that any scopes changing
+  // during the scan cause another scan next time.
+  int32_t scope_epoch = iree_task_scope_change_epoch();
+  if (scope_epoch == executor->waiting_scope_epoch &&
+      (executor->waiting_deadline_ns == IREE_TIME_INFINITE_FUTURE ||
+       iree_time_now() < executor->waiting_deadline_ns)) {
+    return executor->waiting_deadline_ns;
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_time_t deadline_ns = IREE_TIME_INFINITE_FUTURE;
+  iree_task_t* prev_task = NULL;
+  iree_task_t* task = iree_task_list_front(&executor->waiting_list);
+  while (task != NULL) {
+    iree_task_t* next_task = task->next_task;
+    if (IREE_UNLIKELY(iree_task_scope_has_failed(task->scope))) {
+      iree_task_executor_discard_wait(executor, &executor->waiting_list,
+                                      prev_task, (iree_task_wait_t*)task);
+    } else {
+      deadline_ns =
+          iree_min(deadline_ns, iree_task_scope_deadline(task->scope));
+      prev_task = task;
+    }
+    task = next_task;
+  }
+  executor->waiting_deadline_ns = deadline_ns;
+  executor->waiting_scope_epoch = scope_epoch;
+  IREE_TRACE_ZONE_END(z0);
+  return deadline_ns;
+}
+
+// Fails the scopes of all waiting tasks with |status| and discards the tasks.
+// Used when the wait_set itself fails and we can no longer tell which tasks
+// are affected. Takes ownership of |status|.
+//
+// Only called during coordination and expects the coordinator lock to be held.
+// The wait lock must be held as the wait_set is modified.
+static void iree_task_executor_fail_waiting_tasks(
+    iree_task_executor_t* executor, iree_status_t status) {
+  iree_task_t* task = NULL;
+  while ((task = iree_task_list_front(&executor->waiting_list))) {
+    iree_task_scope_fail(task->scope, task, iree_status_clone(status));
+    iree_task_executor_discard_wait(executor, &executor->waiting_list,
+                                    /*prev_task=*/NULL,
+                                    (iree_task_wait_t*)task);
+  }
+  iree_status_ignore(status);
+}
+
 // Merges incoming likely-unresolved wait tasks into the primary executor lists.
 // The handle of each task will be inserted into the wait_set (where it may be
-// a duplicate).
+// a duplicate). Tasks from scopes that have failed are discarded and any that
+// cannot be inserted fail their scope.
 //
 // Only called during coordination and expects the coordinator lock to be held.
 static void iree_task_executor_merge_wait_list(
     iree_task_executor_t* executor, iree_task_list_t* incoming_waiting_list) {
   if (iree_task_list_is_empty(incoming_waiting_list)) return;
 
-  iree_slim_mutex_lock(&executor->wait_mutex);
+  iree_task_executor_lock_wait_set(executor);
 
   // Walk the list of incoming wait tasks and add them to our wait_set.
-  iree_task_wait_t* wait_task =
-      (iree_task_wait_t*)iree_task_list_front(incoming_waiting_list);
-  do {
-    iree_status_t status =
-        iree_wait_set_insert(executor->wait_set, wait_task->wait_handle);
-    // TODO(#4026): propagate failure to the task scope.
-    IREE_ASSERT_TRUE(iree_status_is_ok(status));
-    iree_status_ignore(status);
-    wait_task = (iree_task_wait_t*)wait_task->header.next_task;
-  } while (wait_task);
+  iree_task_t* prev_task = NULL;
+  iree_task_t* task = iree_task_list_front(incoming_waiting_list);
+  while (task != NULL) {
+    iree_task_t* next_task = task->next_task;
+    iree_task_wait_t* wait_task = (iree_task_wait_t*)task;
+    iree_status_t status = iree_ok_status();
+    if (IREE_UNLIKELY(iree_task_scope_has_failed(task->scope))) {
+      status = iree_status_from_code(IREE_STATUS_ABORTED);
+    } else {
+      status = iree_wait_set_insert(executor->wait_set, wait_task->wait_handle);
+      if (IREE_UNLIKELY(!iree_status_is_ok(status))) {
+        iree_task_scope_fail(task->scope, task, status);
+        status = iree_status_from_code(IREE_STATUS_ABORTED);
+      }
+    }
+    if (IREE_UNLIKELY(!iree_status_is_ok(status))) {
+      // Not in the wait_set so only needs to be removed from the list.
+      iree_status_ignore(status);
+      iree_task_list_erase(incoming_waiting_list, prev_task, task);
+      iree_task_list_t discard_worklist;
+      iree_task_list_initialize(&discard_worklist);
+      iree_task_discard(task, &discard_worklist);
+      iree_task_list_discard(&discard_worklist);
+    } else {
+      executor->waiting_deadline_ns = iree_min(
+          executor->waiting_deadline_ns, iree_task_scope_deadline(task->scope));
+      prev_task = task;
+    }
+    task = next_task;
+  }
 
   iree_slim_mutex_unlock(&executor->wait_mutex);
 
@@ -406,12 +698,18 @@ static void iree_task_executor_merge_wait_list(
 // Finds the waiting task corresponding to |wake_handle| and retires it.
 // Any dependent tasks will be enqueued in the |pending_submission| for issuing.
 // If multiple tasks were waiting on the same wait handle all will be readied.
+// If the wake handle was the executor wake event it is reset.
 //
 // Only called during coordination and expects the coordinator lock to be held.
 // The wait lock must be held as the wait_set is modified.
 static void iree_task_executor_wake_waiting_task(
     iree_task_executor_t* executor, iree_wait_handle_t wake_handle,
     iree_task_submission_t* pending_submission) {
+  if (iree_task_executor_is_wake_handle(executor, wake_handle)) {
+    iree_event_reset(&executor->wait_wake_event);
+    return;
+  }
+
   // Walk through the waiting_list and find all waits with this handle.
   // Some may not have resolved yet and need to remain in the list.
   iree_task_t* prev_task = NULL;
@@ -437,26 +735,33 @@ static void iree_task_executor_wake_waiting_task(
 }
 
 // Polls all waiting tasks to see if they have completed and adds any newly
-// ready dependencies to |pending_submission|.
+// ready dependencies to |pending_submission|. Waiting tasks from scopes that
+// have failed are discarded.
+//
+// If another thread is blocked waiting and |wake_waiter| is true then it will
+// be woken so that it observes any changes made since it began waiting.
 //
 // Only called during coordination and expects the coordinator lock to be held.
 static void iree_task_executor_poll_waiting_tasks(
-    iree_task_executor_t* executor,
+    iree_task_executor_t* executor, bool wake_waiter,
     iree_task_submission_t* pending_submission) {
   if (iree_task_list_is_empty(&executor->waiting_list)) return;
 
   // Hold the wait lock for the duration we use the wait_set.
   if (!iree_slim_mutex_try_lock(&executor->wait_mutex)) {
+    if (wake_waiter) iree_event_set(&executor->wait_wake_event);
     return;
   }
 
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  iree_task_executor_discard_failed_waits(executor);
+
   // Poll all root waiting tasks (infinite-past duration) to see if any have
   // completed. If one or more have resolved then wake_handle will contain an
   // unspecified wake handle.
   int woken_tasks = 0;
-  do {
+  while (!iree_task_list_is_empty(&executor->waiting_list)) {
     iree_wait_handle_t wake_handle;
     iree_status_t status = iree_wait_any(executor->wait_set,
                                          IREE_TIME_INFINITE_PAST, &wake_handle);
@@ -469,18 +774,15 @@ static void iree_task_executor_poll_waiting_tasks(
       continue;
     } else if (iree_status_is_deadline_exceeded(status)) {
       // Indicates nothing was woken. Gracefully bail for now.
+      iree_status_ignore(status);
       break;
     } else {
-      // (Spurious?) error during poll.
-      // TODO(#4026): propagate failure to all scopes involved.
-      // It may be ok to ignore when polling as the eventual wait will handle
-      // the full propagation. For now we assert so its easy to see if we have
-      // tried to perform a bad iree_wait_any.
-      IREE_ASSERT_TRUE(iree_status_is_ok(status));
-      iree_status_ignore(status);
+      // Error during poll. We can't tell which waits are at fault and the
+      // eventual wait would fail the same way so we fail them all now.
+      iree_task_executor_fail_waiting_tasks(executor, status);
       break;
     }
-  } while (!iree_task_list_is_empty(&executor->waiting_list));
+  }
 
   iree_slim_mutex_unlock(&executor->wait_mutex);
 
@@ -490,22 +792,44 @@ static void iree_task_executor_poll_waiting_tasks(
 
 // Waits for one or more waiting tasks to be ready to execute.
 // If a wait task retires any newly-ready tasks will be added to
-// |pending_submission|.
+// |pending_submission|. The wait ends early if the earliest deadline of the
+// scopes of waiting tasks elapses or another thread wakes us.
+//
+// Returns true if the wait ended without any task being woken and the caller
+// should coordinate again to observe whatever changed.
 //
 // Only called during coordination and expects the coordinator lock to be held.
-static void iree_task_executor_wait_any_task(
+static bool iree_task_executor_wait_any_task(
     iree_task_executor_t* executor, iree_task_worker_t* current_worker,
     iree_task_submission_t* pending_submission) {
-  if (iree_task_list_is_empty(&executor->waiting_list)) return;
+  if (iree_task_list_is_empty(&executor->waiting_list)) return false;
+
+  // Only one thread waits at a time; if another already is then it will pick
+  // up any changes to the wait set when woken by whoever makes them. We must
+  // acquire the wait lock before releasing the coordinator lock so that the
+  // waiting tasks cannot be polled away in between, leaving us blocked on an
+  // empty wait set.
+  if (!iree_slim_mutex_try_lock(&executor->wait_mutex)) return false;
 
   IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Wait no longer than the earliest deadline of any scope we're waiting on
+  // so that we can discard the tasks once it passes.
+  iree_time_t deadline_ns = iree_task_executor_discard_failed_waits(executor);
+  if (iree_task_list_is_empty(&executor->waiting_list)) {
+    iree_slim_mutex_unlock(&executor->wait_mutex);
+    IREE_TRACE_ZONE_END(z0);
+    return false;
+  }
+
   iree_slim_mutex_unlock(&executor->coordinator_mutex);
 
   // We can't hold the coordinator lock during the wait but also need to ensure
   // no other coordination messes with the wait set. We have a dedicated wait
   // mutex and guard wait-set accesses (polling/waiting/etc) with that. Polls
   // may try-lock and bail if the lock is held indicating that someone else has
-  // a non-polling wait active.
+  // a non-polling wait active; coordinators that need to modify the wait set
+  // set the wake event to get us to release the lock.
 
   // TODO(benvanik): ensure coordinator wake semantics are modeled:
   // - donator:
@@ -520,44 +844,44 @@ static void iree_task_executor_wait_any_task(
   //     try steal
   //     if fail to steal: coordinate
 
-  iree_slim_mutex_lock(&executor->wait_mutex);
-
-  iree_time_t deadline_ns = IREE_TIME_INFINITE_FUTURE;
   iree_wait_handle_t wake_handle;
   iree_status_t status =
       iree_wait_any(executor->wait_set, deadline_ns, &wake_handle);
 
   iree_slim_mutex_unlock(&executor->wait_mutex);
 
-  // TODO(#4026): propagate failure to all scopes involved.
-  IREE_ASSERT_TRUE(iree_status_is_ok(status));
-  iree_status_ignore(status);
-
   iree_slim_mutex_lock(&executor->coordinator_mutex);
 
+  bool should_retry = false;
   int woken_tasks = 0;
   if (iree_status_is_ok(status)) {
     // One or more waiters is ready. We don't support multi-wake right now so
     // we'll just take the one we got back and try again.
+    iree_task_executor_lock_wait_set(executor);
+    should_retry = iree_task_executor_is_wake_handle(executor, wake_handle);
     iree_task_executor_wake_waiting_task(executor, wake_handle,
                                          pending_submission);
-    ++woken_tasks;
+    iree_slim_mutex_unlock(&executor->wait_mutex);
+    if (!should_retry) ++woken_tasks;
   } else if (iree_status_is_deadline_exceeded(status)) {
-    // Indicates nothing was woken. Gracefully bail and return to the
-    // coordinator to see if we should wait again.
+    // Indicates nothing was woken but a scope deadline has passed. Return to
+    // the coordinator to discard the waits from the scope and wait again.
+    iree_status_ignore(status);
+    should_retry = true;
   } else {
-    // (Spurious?) error during wait.
-    // TODO(#4026): propagate failure to all scopes involved.
+    // Error during wait.
     // Failures during waits are serious: ignoring them could lead to live-lock
     // as tasks further in the pipeline expect them to have completed or - even
     // worse - user code/other processes/drivers/etc may expect them to
-    // complete.
-    IREE_ASSERT_TRUE(iree_status_is_ok(status));
-    iree_status_ignore(status);
+    // complete. We can't tell which waits are at fault so fail them all.
+    iree_task_executor_lock_wait_set(executor);
+    iree_task_executor_fail_waiting_tasks(executor, status);
+    iree_slim_mutex_unlock(&executor->wait_mutex);
   }
 
   IREE_TRACE_ZONE_APPEND_VALUE(z0, woken_tasks);
   IREE_TRACE_ZONE_END(z0);
+  return should_retry;
 }
 
 // Dispatches tasks in the global submission queue to workers.
@@ -578,6 +902,16 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
   iree_slim_mutex_lock(&executor->coordinator_mutex);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Coordination is attributed to the worker performing it, if any.
+  // Time spent waiting on wait handles is counted as sleeping instead.
+#if IREE_STATISTICS_ENABLE
+  iree_task_worker_statistics_t* statistics =
+      current_worker ? &current_worker->statistics
+                     : &executor->coordinator_statistics;
+  iree_time_t start_ns = iree_time_now();
+  iree_duration_t sleep_duration_ns = 0;
+#endif  // IREE_STATISTICS_ENABLE
+
   // We may be adding tasks/waiting/etc on each pass through coordination - to
   // ensure we completely drain the incoming queues and satisfied waits we loop
   // until there's nothing left to coordinate.
@@ -624,7 +958,11 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
     // If any waits have resolved then they'll be moved to the ready list here
     // and then get processed FIFO with the tasks that were ready in the
     // request.
-    iree_task_executor_poll_waiting_tasks(executor, &pending_submission);
+    //
+    // Coordinators that won't wait themselves wake any thread that is blocked
+    // waiting so that it can pick up changes (such as aborted scopes).
+    iree_task_executor_poll_waiting_tasks(
+        executor, /*wake_waiter=*/!wait_on_idle, &pending_submission);
 
     // Schedule all ready tasks in this batch. Some may complete inline (such
     // as ready barriers with all their dependencies resolved) while others may
@@ -639,27 +977,54 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
     // Post all new work to workers; they may wake and begin executing
     // immediately. Returns whether this worker has new tasks for it to work on.
     bool did_post = iree_task_post_batch_submit(post_batch);
-    if (!did_post && wait_on_idle) {
+    bool wait_interrupted = false;
+    if (!did_post && !wait_on_idle &&
+        !iree_task_executor_is_threadless(executor) &&
+        !iree_task_list_is_empty(&executor->waiting_list) &&
+        iree_slim_mutex_try_lock(&executor->wait_mutex)) {
+      // There are waiting tasks but no thread is waiting on them and we won't
+      // either. Wake a worker so that it coordinates and takes over the wait;
+      // otherwise the waits would not be noticed until other work arrived.
+      iree_slim_mutex_unlock(&executor->wait_mutex);
+      iree_task_post_batch_wake_worker(
+          post_batch, iree_task_post_batch_select_worker(
+                          post_batch, iree_task_affinity_for_any_worker()));
+    } else if (!did_post && wait_on_idle) {
       // No work was found; wait on one or more of our wait handles.
       // This will block the calling thread but that's fine as they were going
       // to wait anyway and were just speculatively seeing if there was work
       // first by requesting coordination. If work completes here we'll catch it
       // on the poll next loop around.
-      iree_task_executor_wait_any_task(executor, current_worker,
-                                       &pending_submission);
+      IREE_STATISTICS(iree_time_t sleep_start_ns = iree_time_now());
+      wait_interrupted = iree_task_executor_wait_any_task(
+          executor, current_worker, &pending_submission);
+#if IREE_STATISTICS_ENABLE
+      sleep_duration_ns += iree_time_now() - sleep_start_ns;
+      iree_task_worker_statistics_add(&statistics->sleep_count, 1);
+#endif  // IREE_STATISTICS_ENABLE
     }
 
     // Merge any new work into the submission list for future coordinators to
     // deal with - we don't want the possibility of starvation by looping on
-    // this.
+    // this. If our wait was interrupted we also go around again to observe
+    // whatever interrupted it and resume waiting.
     if (!iree_task_submission_is_empty(&pending_submission)) {
       iree_task_executor_merge_submission(executor, &pending_submission);
       schedule_dirty = true;
     } else {
-      schedule_dirty = false;
+      schedule_dirty = wait_interrupted;
     }
   } while (schedule_dirty);
 
+#if IREE_STATISTICS_ENABLE
+  iree_task_worker_statistics_add(&statistics->coordinator_acquire_count, 1);
+  iree_task_worker_statistics_add(
+      &statistics->coordinate_duration_ns,
+      iree_time_now() - start_ns - sleep_duration_ns);
+  iree_task_worker_statistics_add(&statistics->sleep_duration_ns,
+                                  sleep_duration_ns);
+#endif  // IREE_STATISTICS_ENABLE
+
   iree_slim_mutex_unlock(&executor->coordinator_mutex);
   IREE_TRACE_ZONE_END(z0);
 }
@@ -667,7 +1032,8 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
 static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
     iree_task_executor_t* executor, iree_task_affinity_set_t victim_mask,
     uint32_t max_theft_attempts, int rotation_offset,
-    iree_task_queue_t* local_task_queue) {
+    iree_task_scope_priority_t min_priority,
+    iree_task_deque_t* local_task_deques) {
   if (!victim_mask) return NULL;
   max_theft_attempts = iree_min(max_theft_attempts,
                                 iree_task_affinity_set_count_ones(victim_mask));
@@ -694,14 +1060,14 @@ static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
     mask = iree_shr(mask, offset + 1);
     iree_task_worker_t* victim_worker = &executor->workers[victim_index];
 
-    // Policy: steal a chunk of tasks at the tail of the victim queue.
+    // Policy: steal a chunk of tasks at the top of the victim deque.
     // This will steal multiple tasks from the victim up to the specified max
-    // and move the them into our local task queue. Not all tasks will be stolen
+    // and move the them into our local task deque. Not all tasks will be stolen
     // and the assumption is that over a large-enough random distribution of
-    // thievery taking ~half of the tasks each time (across all queues) will
+    // thievery taking ~half of the tasks each time (across all deques) will
     // lead to a relatively even distribution.
     iree_task_t* task = iree_task_worker_try_steal_task(
-        victim_worker, local_task_queue,
+        victim_worker, min_priority, local_task_deques,
         /*max_tasks=*/IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT);
     if (task) return task;
   }
@@ -712,7 +1078,10 @@ static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
 
 // Tries to steal an entire task from a sibling worker (based on topology).
 // Returns a task that is available (has not yet begun processing at all).
-// May steal multiple tasks and add them to the |local_task_queue|.
+// May steal multiple tasks and add them to the |local_task_deques|.
+// Only tasks with a priority of at least |min_priority| will be stolen and only
+// workers in |theft_victim_mask| (usually those on the same NUMA node) will be
+// considered.
 //
 // We do a scan through ideal victims indicated by the
 // |constructive_sharing_mask|; these are the workers most likely to have some
@@ -727,13 +1096,16 @@ static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
 iree_task_t* iree_task_executor_try_steal_task(
     iree_task_executor_t* executor,
     iree_task_affinity_set_t constructive_sharing_mask,
-    uint32_t max_theft_attempts, iree_prng_minilcg128_state_t* theft_prng,
-    iree_task_queue_t* local_task_queue) {
+    iree_task_affinity_set_t theft_victim_mask, uint32_t max_theft_attempts,
+    iree_prng_minilcg128_state_t* theft_prng,
+    iree_task_scope_priority_t min_priority,
+    iree_task_deque_t* local_task_deques) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   // Limit the workers we will steal from to the ones that are currently live
-  // and not idle.
+  // and not idle (and that we are allowed to steal from at all).
   iree_task_affinity_set_t victim_mask =
+      theft_victim_mask &
       iree_atomic_task_affinity_set_load(&executor->worker_live_mask,
                                          iree_memory_order_relaxed) &
       ~iree_atomic_task_affinity_set_load(&executor->worker_idle_mask,
@@ -753,13 +1125,13 @@ iree_task_t* iree_task_executor_try_steal_task(
   // event that the thief and victim are running close to each other in time.
   iree_task_t* task = iree_task_executor_try_steal_task_from_affinity_set(
       executor, victim_mask & constructive_sharing_mask, max_theft_attempts,
-      rotation_offset, local_task_queue);
+      rotation_offset, min_priority, local_task_deques);
   if (task) {
     IREE_TRACE_ZONE_APPEND_TEXT(z0, "local");
   } else {
     task = iree_task_executor_try_steal_task_from_affinity_set(
         executor, victim_mask & ~constructive_sharing_mask, max_theft_attempts,
-        rotation_offset, local_task_queue);
+        rotation_offset, min_priority, local_task_deques);
     if (task) {
       IREE_TRACE_ZONE_APPEND_TEXT(z0, "non-local");
     }
@@ -769,18 +1141,83 @@ iree_task_t* iree_task_executor_try_steal_task(
   return task;
 }
 
-iree_status_t iree_task_executor_donate_caller(iree_task_executor_t* executor,
-                                               iree_wait_handle_t* wait_handle,
-                                               iree_time_t deadline_ns) {
+// Donates the caller to |executor| until |wait| resolves or |deadline_ns|
+// elapses. Shared by the single handle and wait set donation entry points.
+static iree_status_t iree_task_executor_donate_caller_until(
+    iree_task_executor_t* executor, const iree_task_donated_wait_t* wait,
+    iree_time_t deadline_ns) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   // Perform an immediate flush/coordination (in case the caller queued).
   iree_task_executor_flush(executor);
 
-  // Wait until completed.
-  // TODO(benvanik): make this steal tasks until wait_handle resolves.
-  iree_status_t status = iree_wait_one(wait_handle, deadline_ns);
+  const bool is_threadless = iree_task_executor_is_threadless(executor);
+  iree_task_worker_t* donation_worker = executor->donation_worker;
+  iree_status_t status = iree_ok_status();
+  while (true) {
+    // Check to see if the wait has resolved (or failed) before doing any work.
+    status = iree_task_donated_wait_until(wait, IREE_TIME_INFINITE_PAST);
+    if (!iree_status_is_deadline_exceeded(status)) break;
+    iree_status_ignore(status);
+    if (iree_time_now() >= deadline_ns) {
+      status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+      break;
+    }
+
+    // Act as the donation worker if no other thread is. The worker will run
+    // any tasks posted to it (if threadless) or steal tasks from the other
+    // workers until it runs dry or the wait resolves.
+    bool has_work = false;
+    if (iree_slim_mutex_try_lock(&executor->donation_mutex)) {
+      has_work = iree_task_worker_pump_donated(donation_worker, wait);
+
+      // Schedule anything the tasks we ran made ready. When threadless this
+      // posts the tasks directly back into the donation worker.
+      iree_task_executor_coordinate(executor, donation_worker,
+                                    /*wait_on_idle=*/false);
+      has_work |= iree_task_worker_has_local_tasks(donation_worker);
+
+      iree_slim_mutex_unlock(&executor->donation_mutex);
+    }
+    if (has_work) continue;
+
+    if (is_threadless) {
+      // No threads will wake us when new work arrives or waits resolve so we
+      // have to check back periodically.
+      iree_time_t poll_deadline_ns = iree_min(
+          deadline_ns,
+          iree_time_now() + IREE_TASK_EXECUTOR_DONATION_POLL_INTERVAL_NS);
+      status = iree_task_donated_wait_until(wait, poll_deadline_ns);
+      if (!iree_status_is_deadline_exceeded(status)) break;
+      iree_status_ignore(status);
+    } else {
+      // No work available; the workers will complete whatever remains so we
+      // just wait as if we had never donated ourselves.
+      status = iree_task_donated_wait_until(wait, deadline_ns);
+      break;
+    }
+  }
 
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
+
+iree_status_t iree_task_executor_donate_caller(iree_task_executor_t* executor,
+                                               iree_wait_handle_t* wait_handle,
+                                               iree_time_t deadline_ns) {
+  const iree_task_donated_wait_t wait = {
+      .wait_handle = wait_handle,
+      .wait_set = NULL,
+  };
+  return iree_task_executor_donate_caller_until(executor, &wait, deadline_ns);
+}
+
+iree_status_t iree_task_executor_donate_caller_any(
+    iree_task_executor_t* executor, iree_wait_set_t* wait_set,
+    iree_time_t deadline_ns) {
+  const iree_task_donated_wait_t wait = {
+      .wait_handle = NULL,
+      .wait_set = wait_set,
+  };
+  return iree_task_executor_donate_caller_until(executor, &wait, deadline_ns);
+}
@@ -128,24 +128,29 @@ extern "C" {
 //
 //   c. iree_task_executor_schedule_ready_tasks: walks the FIFO task queue and
 //      builds a iree_task_post_batch_t containing the per-worker tasks
-//      in LIFO order.
+//      in LIFO order. Tasks from higher priority scopes are scheduled first
+//      so that they are the ones assigned to any idle workers.
 //
 //   d. iree_task_post_batch_submit: per-worker tasks are pushed to their
 //      respective iree_task_worker_t mailbox_slist and the workers with new
 //      tasks are notified to wake up (if not already awake).
 //
-// 4. iree_task_worker_main_pump_once (LIFO mailbox -> FIFO thread-local list)
+// 4. iree_task_worker_main_pump_once (LIFO mailbox -> thread-local deque)
 //    When either woken or after completing all available thread-local work
 //    each worker will check its mailbox_slist to see if any tasks have been
 //    posted.
 //
-//    a. Tasks are flushed from the LIFO mailbox into the local_task_queue FIFO
-//       for the particular worker.
+//    a. Tasks are flushed from the LIFO mailbox into the local_task_deques
+//       of the particular worker: one Chase-Lev deque per scope priority.
+//       Tasks posted with a higher priority than any the worker has locally
+//       are flushed immediately (preempting dispatch shards between tile
+//       reservations) instead of waiting for the local work to drain.
 //
 //    b. If the mailbox is empty the worker *may* attempt to steal work from
 //       another nearby worker in the topology.
 //
-//    c. Any tasks in the local_task_queue are executed until empty.
+//    c. Any tasks in the local_task_deques are executed until empty, highest
+//       priority first with lower priorities guaranteed a periodic turn.
 //       Tasks are retired and dependent tasks (via completion_task or barriers)
 //       are made ready and placed in the executor incoming_ready_slist or
 //       incoming_waiting_slist as with iree_task_executor_submit.
@@ -294,19 +299,69 @@ enum iree_task_scheduling_mode_bits_t {
   // It also keeps any wait-related syscalls off the worker threads that would
   // otherwise need to perform the syscalls during coordination.
   IREE_TASK_SCHEDULING_MODE_DEDICATED_WAIT_THREAD = 1u << 1,
+
+  // Allows workers to steal tasks from workers attached to other NUMA nodes.
+  // By default stealing is limited to workers on the same node as the data
+  // the stolen tasks touch is likely to live in the victim's node memory and
+  // the cost of accessing it remotely outweighs the benefits of balancing.
+  // Workloads that are compute-bound and poorly distributed may benefit.
+  IREE_TASK_SCHEDULING_MODE_CROSS_NUMA_NODE_STEALING = 1u << 2,
 };
 typedef uint32_t iree_task_scheduling_mode_t;
 
 // Base task system executor interface.
 typedef struct iree_task_executor_t iree_task_executor_t;
 
+// Aggregate statistics gathered across all workers of an executor.
+// Counters monotonically increase from the time the executor is created and
+// consumers wanting rates should diff subsequent queries.
+typedef struct iree_task_executor_statistics_t {
+#if IREE_STATISTICS_ENABLE
+  // Total number of tasks executed by workers (calls and dispatch shards).
+  int64_t task_count;
+  // Total number of dispatch tiles executed by workers.
+  int64_t tile_count;
+  // Total number of times workers went looking for tasks to steal.
+  int64_t steal_attempt_count;
+  // Total number of steal attempts that found a task.
+  int64_t steal_success_count;
+  // Total number of times any thread acquired the coordinator role.
+  int64_t coordinator_acquire_count;
+  // Total number of times workers went to sleep waiting for work or waits.
+  int64_t sleep_count;
+  // Total number of times workers were woken by other threads to take work.
+  int64_t wake_count;
+  // Total time spent by workers executing tasks.
+  iree_duration_t execute_duration_ns;
+  // Total time spent coordinating (scheduling tasks and polling waits).
+  iree_duration_t coordinate_duration_ns;
+  // Total time spent by workers trying to steal tasks.
+  iree_duration_t steal_duration_ns;
+  // Total time spent by workers sleeping.
+  iree_duration_t sleep_duration_ns;
+#else
+  int reserved;
+#endif  // IREE_STATISTICS_ENABLE
+} iree_task_executor_statistics_t;
+
+// Adds the counters from |source| to |target|.
+void iree_task_executor_statistics_merge(
+    const iree_task_executor_statistics_t* source,
+    iree_task_executor_statistics_t* target);
+
 // Creates a task executor using the specified topology.
 //
-// |worker_local_memory_size| defines the bytes to be allocated and reserved for
-// each worker to use for local memory operations. Will be rounded up to the
-// next power of two. Dispatches performed will be able to request up to this
-// amount of memory for their invocations and no more. May be 0 if no worker
-// local memory is required.
+// |worker_local_memory_size| defines the bytes to be allocated and reserved up
+// front for each worker to use for local memory operations. Dispatches that
+// request more than this cause the executing worker to grow its local memory
+// on demand (see iree_task_executor_reserve_worker_local_memory). May be 0 to
+// only allocate local memory once a dispatch requires it.
+//
+// If |topology| contains no groups the executor is created threadless: no
+// worker threads are created and tasks only make progress while a thread is
+// donated to the executor with iree_task_executor_donate_caller. This is useful
+// when embedding in hosts that already own their thread pools and would like
+// to drive execution from them.
 //
 // |topology| is only used during creation and need not live beyond this call.
 // |out_executor| must be released by the caller.
@@ -323,8 +378,39 @@ void iree_task_executor_retain(iree_task_executor_t* executor);
 void iree_task_executor_release(iree_task_executor_t* executor);
 
 // Trims pools and caches used by the executor and its workers.
+// Worker local memory grown beyond the initial reservation is released by each
+// worker the next time it goes idle.
 void iree_task_executor_trim(iree_task_executor_t* executor);
 
+// Hints that dispatches requiring up to |local_memory_size| bytes of worker
+// local memory will be executed. Workers grow their local memory to at least
+// the largest reserved size the next time they need to grow so that a sequence
+// of increasingly large dispatches only grows once. Growth happens on the
+// worker thread so that the memory is placed local to the worker.
+// Thread-safe and cheap when the size has already been reserved.
+void iree_task_executor_reserve_worker_local_memory(
+    iree_task_executor_t* executor, iree_host_size_t local_memory_size);
+
+// Returns the NUMA node all workers of the executor are attached to or
+// IREE_TASK_TOPOLOGY_NUMA_NODE_ANY if the workers span multiple nodes or are
+// not pinned. Memory used primarily by the executor is best placed here.
+uint32_t iree_task_executor_numa_node(iree_task_executor_t* executor);
+
+// Returns the smallest cache size private to any worker (usually the L2 size)
+// or 0 if unknown. Work can be tiled to this size to keep it in cache.
+iree_host_size_t iree_task_executor_worker_cache_size(
+    iree_task_executor_t* executor);
+
+// Queries the aggregate statistics of all workers in the executor since it was
+// created. Thread-safe and lock-free; counters are gathered from each worker
+// independently and may tear with respect to each other if tasks are in-flight.
+//
+// NOTE: statistics may be compiled out in some configurations and this call
+// will become a memset(0).
+void iree_task_executor_query_statistics(
+    iree_task_executor_t* executor,
+    iree_task_executor_statistics_t* out_statistics);
+
 // Returns an iree_event_t pool managed by the executor.
 // Users of the task system should acquire their transient events from this.
 // Long-lived events should be allocated on their own in order to avoid
@@ -371,7 +457,14 @@ void iree_task_executor_flush(iree_task_executor_t* executor);
 // If there are no tasks available then the calling thread will block as if
 // iree_wait_one had been used on |wait_handle|. If tasks are ready then the
 // caller will not block prior to starting to perform work on behalf of the
-// executor.
+// executor. Only one thread may be donated at a time; if another thread is
+// already donated the caller will just wait.
+//
+// Threadless executors only make progress while a thread is donated. Donated
+// threads will run tasks until |wait_handle| resolves and otherwise poll for
+// newly submitted tasks and resolved waits every
+// IREE_TASK_EXECUTOR_DONATION_POLL_INTERVAL_NS. Any work remaining after the
+// wait resolves will be performed on the next donation.
 //
 // Donation is intended as an optimization to elide context switches when the
 // caller would have waited anyway; now instead of performing a kernel wait and
@@ -396,6 +489,17 @@ iree_status_t iree_task_executor_donate_caller(iree_task_executor_t* executor,
                                                iree_wait_handle_t* wait_handle,
                                                iree_time_t deadline_ns);
 
+// Donates the calling thread to the executor until any handle in |wait_set|
+// resolves or |deadline_ns| elapses. Otherwise behaves as
+// iree_task_executor_donate_caller and is required to wait on multiple handles
+// with threadless executors.
+//
+// iree_wait_set_t is thread-compatible and the caller must not manipulate
+// |wait_set| until the donation returns.
+iree_status_t iree_task_executor_donate_caller_any(
+    iree_task_executor_t* executor, iree_wait_set_t* wait_set,
+    iree_time_t deadline_ns);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
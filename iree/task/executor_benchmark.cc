@@ -0,0 +1,327 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "iree/base/api.h"
+#include "iree/base/internal/wait_handle.h"
+#include "iree/task/affinity_set.h"
+#include "iree/task/executor.h"
+#include "iree/task/scope.h"
+#include "iree/task/submission.h"
+#include "iree/task/task.h"
+#include "iree/task/topology.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Creates an executor with |worker_count| workers in a flat topology.
+iree_task_executor_t* CreateExecutor(iree_host_size_t worker_count) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(worker_count, &topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(iree_task_executor_create(
+      IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+      /*worker_local_memory_size=*/0, iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+  return executor;
+}
+
+// Submits |submission| with |tail_tasks| signaling a fence in |scope| and waits
+// for the scope to go idle.
+void SubmitAndWait(iree_task_executor_t* executor, iree_task_scope_t* scope,
+                   iree_task_submission_t* submission,
+                   iree_host_size_t tail_task_count, iree_task_t** tail_tasks) {
+  iree_task_fence_t* fence = NULL;
+  IREE_CHECK_OK(iree_task_executor_acquire_fence(executor, scope, &fence));
+  for (iree_host_size_t i = 0; i < tail_task_count; ++i) {
+    iree_task_set_completion_task(tail_tasks[i], &fence->header);
+  }
+  iree_task_executor_submit(executor, submission);
+  iree_task_executor_flush(executor);
+  IREE_CHECK_OK(iree_task_scope_wait_idle(scope, IREE_TIME_INFINITE_FUTURE));
+}
+
+// Submits a single task |task| with no dependents and waits for it to
+// complete.
+void SubmitAndWait(iree_task_executor_t* executor, iree_task_scope_t* scope,
+                   iree_task_t* task) {
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_task_submission_enqueue(&submission, task);
+  SubmitAndWait(executor, scope, &submission, 1, &task);
+}
+
+iree_status_t EmptyCall(void* user_context, iree_task_t* task,
+                        iree_task_submission_t* pending_submission) {
+  return iree_ok_status();
+}
+
+iree_status_t EmptyTile(void* user_context,
+                        const iree_task_tile_context_t* tile_context,
+                        iree_task_submission_t* pending_submission) {
+  return iree_ok_status();
+}
+
+// Records the time the call executed into the Clock::time_point at
+// |user_context|.
+iree_status_t RecordTimeCall(void* user_context, iree_task_t* task,
+                             iree_task_submission_t* pending_submission) {
+  *reinterpret_cast<Clock::time_point*>(user_context) = Clock::now();
+  return iree_ok_status();
+}
+
+// Busy-waits for the number of microseconds encoded in |user_context|.
+iree_status_t SpinCall(void* user_context, iree_task_t* task,
+                       iree_task_submission_t* pending_submission) {
+  auto deadline =
+      Clock::now() + std::chrono::microseconds((intptr_t)user_context);
+  while (Clock::now() < deadline) {
+  }
+  return iree_ok_status();
+}
+
+// Worker counts every benchmark is swept across.
+void WorkerCounts(benchmark::internal::Benchmark* benchmark) {
+  for (int worker_count : {1, 2, 4, 8}) {
+    benchmark->Args({worker_count});
+  }
+}
+
+//==============================================================================
+// Submit-to-start latency
+//==============================================================================
+// Measures the time from iree_task_executor_submit to a single call task
+// beginning execution on a worker. This includes coordination, posting to the
+// worker, and waking it if it was sleeping.
+
+void BM_SubmitToStart(benchmark::State& state) {
+  iree_task_executor_t* executor = CreateExecutor(state.range(0));
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("bench"), &scope);
+
+  for (auto _ : state) {
+    Clock::time_point start_time;
+    iree_task_call_t call;
+    iree_task_call_initialize(
+        &scope, iree_task_make_call_closure(RecordTimeCall, &start_time),
+        &call);
+    Clock::time_point submit_time = Clock::now();
+    SubmitAndWait(executor, &scope, &call.header);
+    state.SetIterationTime(
+        std::chrono::duration<double>(start_time - submit_time).count());
+  }
+
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+}
+BENCHMARK(BM_SubmitToStart)
+    ->ArgNames({"workers"})
+    ->Apply(WorkerCounts)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond);
+
+//==============================================================================
+// Empty task throughput
+//==============================================================================
+// Submits |state.range(1)| independent empty call tasks at once and waits for
+// all of them to complete. This is dominated by the per-task overhead of
+// coordination, posting, and retiring.
+
+void BM_EmptyTaskThroughput(benchmark::State& state) {
+  iree_task_executor_t* executor = CreateExecutor(state.range(0));
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("bench"), &scope);
+
+  const iree_host_size_t task_count = (iree_host_size_t)state.range(1);
+  std::vector<iree_task_call_t> calls(task_count);
+  std::vector<iree_task_t*> tail_tasks(task_count);
+  for (auto _ : state) {
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    for (iree_host_size_t i = 0; i < task_count; ++i) {
+      iree_task_call_initialize(
+          &scope, iree_task_make_call_closure(EmptyCall, NULL), &calls[i]);
+      iree_task_submission_enqueue(&submission, &calls[i].header);
+      tail_tasks[i] = &calls[i].header;
+    }
+    SubmitAndWait(executor, &scope, &submission, task_count,
+                  tail_tasks.data());
+  }
+  state.SetItemsProcessed(state.iterations() * task_count);
+
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+}
+BENCHMARK(BM_EmptyTaskThroughput)
+    ->ArgNames({"workers", "tasks"})
+    ->ArgsProduct({{1, 2, 4, 8}, {64, 1024}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+//==============================================================================
+// Dispatch fan-out and fan-in
+//==============================================================================
+// A barrier fans out to |state.range(1)| dispatches of empty tiles (one per
+// worker) that all join on a single nop task. This measures the cost of
+// readying many tasks at once, sharding the dispatches across workers, and
+// retiring them back into a single dependent task.
+
+void BM_DispatchFanOutFanIn(benchmark::State& state) {
+  const iree_host_size_t worker_count = (iree_host_size_t)state.range(0);
+  iree_task_executor_t* executor = CreateExecutor(worker_count);
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("bench"), &scope);
+
+  const iree_host_size_t width = (iree_host_size_t)state.range(1);
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {(uint32_t)worker_count, 1, 1};
+  std::vector<iree_task_dispatch_t> dispatches(width);
+  std::vector<iree_task_t*> dependent_tasks(width);
+  for (auto _ : state) {
+    iree_task_nop_t join;
+    iree_task_nop_initialize(&scope, &join);
+    for (iree_host_size_t i = 0; i < width; ++i) {
+      iree_task_dispatch_initialize(
+          &scope, iree_task_make_dispatch_closure(EmptyTile, NULL),
+          workgroup_size, workgroup_count, &dispatches[i]);
+      iree_task_set_completion_task(&dispatches[i].header, &join.header);
+      dependent_tasks[i] = &dispatches[i].header;
+    }
+    iree_task_barrier_t fork;
+    iree_task_barrier_initialize(&scope, width, dependent_tasks.data(), &fork);
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    iree_task_submission_enqueue(&submission, &fork.header);
+    iree_task_t* tail_task = &join.header;
+    SubmitAndWait(executor, &scope, &submission, 1, &tail_task);
+  }
+  state.SetItemsProcessed(state.iterations() * width);
+
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+}
+BENCHMARK(BM_DispatchFanOutFanIn)
+    ->ArgNames({"workers", "width"})
+    ->ArgsProduct({{1, 2, 4, 8}, {8, 64}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+//==============================================================================
+// Work stealing under imbalanced load
+//==============================================================================
+// Submits |state.range(1)| call tasks that each spin for a short while and are
+// all posted to worker 0. Every other worker only gets work by stealing it and
+// ideally the total time approaches the serial time divided by the worker
+// count. The number of successful steals per iteration is reported as a
+// counter (when statistics are enabled).
+
+void BM_StealImbalanced(benchmark::State& state) {
+  iree_task_executor_t* executor = CreateExecutor(state.range(0));
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("bench"), &scope);
+
+  const iree_host_size_t task_count = (iree_host_size_t)state.range(1);
+  const intptr_t task_duration_us = 10;
+  std::vector<iree_task_call_t> calls(task_count);
+  std::vector<iree_task_t*> tail_tasks(task_count);
+  iree_task_executor_statistics_t start_statistics;
+  iree_task_executor_query_statistics(executor, &start_statistics);
+  for (auto _ : state) {
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    for (iree_host_size_t i = 0; i < task_count; ++i) {
+      iree_task_call_initialize(
+          &scope,
+          iree_task_make_call_closure(SpinCall, (void*)task_duration_us),
+          &calls[i]);
+      calls[i].header.affinity_set = iree_task_affinity_for_worker(0);
+      iree_task_submission_enqueue(&submission, &calls[i].header);
+      tail_tasks[i] = &calls[i].header;
+    }
+    SubmitAndWait(executor, &scope, &submission, task_count,
+                  tail_tasks.data());
+  }
+  state.SetItemsProcessed(state.iterations() * task_count);
+
+#if IREE_STATISTICS_ENABLE
+  iree_task_executor_statistics_t end_statistics;
+  iree_task_executor_query_statistics(executor, &end_statistics);
+  state.counters["steals"] = benchmark::Counter(
+      (double)(end_statistics.steal_success_count -
+               start_statistics.steal_success_count),
+      benchmark::Counter::kAvgIterations);
+#endif  // IREE_STATISTICS_ENABLE
+
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+}
+BENCHMARK(BM_StealImbalanced)
+    ->ArgNames({"workers", "tasks"})
+    ->ArgsProduct({{1, 2, 4, 8}, {256}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+//==============================================================================
+// Wait task wake latency
+//==============================================================================
+// Submits a wait task on an unsignaled event followed by a call task and gives
+// the executor time to begin waiting. The event is then signaled and the time
+// until the call task begins executing is measured. This includes the wake of
+// the waiting coordinator, retiring the wait, and scheduling the call.
+
+void BM_WaitWake(benchmark::State& state) {
+  iree_task_executor_t* executor = CreateExecutor(state.range(0));
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("bench"), &scope);
+
+  iree_event_t event;
+  IREE_CHECK_OK(iree_event_initialize(/*initial_state=*/false, &event));
+  for (auto _ : state) {
+    iree_event_reset(&event);
+    iree_task_wait_t wait;
+    iree_task_wait_initialize(&scope, event, &wait);
+    Clock::time_point start_time;
+    iree_task_call_t call;
+    iree_task_call_initialize(
+        &scope, iree_task_make_call_closure(RecordTimeCall, &start_time),
+        &call);
+    iree_task_set_completion_task(&wait.header, &call.header);
+
+    iree_task_fence_t* fence = NULL;
+    IREE_CHECK_OK(iree_task_executor_acquire_fence(executor, &scope, &fence));
+    iree_task_set_completion_task(&call.header, &fence->header);
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    iree_task_submission_enqueue(&submission, &wait.header);
+    iree_task_executor_submit(executor, &submission);
+    iree_task_executor_flush(executor);
+
+    // Give a worker a chance to pick up the wait and block on it.
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+    Clock::time_point signal_time = Clock::now();
+    iree_event_set(&event);
+    IREE_CHECK_OK(iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+    state.SetIterationTime(
+        std::chrono::duration<double>(start_time - signal_time).count());
+  }
+  iree_event_deinitialize(&event);
+
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+}
+BENCHMARK(BM_WaitWake)
+    ->ArgNames({"workers"})
+    ->Apply(WorkerCounts)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace
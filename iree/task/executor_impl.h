@@ -12,11 +12,12 @@
 #include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
 #include "iree/task/affinity_set.h"
+#include "iree/task/deque.h"
 #include "iree/task/executor.h"
 #include "iree/task/list.h"
 #include "iree/task/pool.h"
 #include "iree/task/post_batch.h"
-#include "iree/task/queue.h"
+#include "iree/task/scope.h"
 #include "iree/task/tuning.h"
 #include "iree/task/worker.h"
 
@@ -32,6 +33,14 @@ struct iree_task_executor_t {
   // TODO(benvanik): make mutable; currently always the same reserved value.
   iree_task_scheduling_mode_t scheduling_mode;
 
+  // NUMA node all workers are attached to or IREE_TASK_TOPOLOGY_NUMA_NODE_ANY
+  // if they span nodes/are unpinned. Immutable after creation.
+  uint32_t numa_node;
+
+  // Smallest cache size private to any worker or 0 if unknown. Immutable after
+  // creation.
+  iree_host_size_t worker_cache_size;
+
   // State used by the work-stealing operations performed by donated threads.
   // This is **NOT SYNCHRONIZED** and relies on the fact that we actually don't
   // much care about the precise selection of workers enough to mind any tears
@@ -79,15 +88,31 @@ struct iree_task_executor_t {
   // Guards coordination logic; only one thread at a time may be acting as the
   // coordinator.
   iree_slim_mutex_t coordinator_mutex;
+  // Statistics for coordination performed by threads that are not workers
+  // (such as submitting or flushing threads). Only updated while holding the
+  // coordinator_mutex.
+  iree_task_worker_statistics_t coordinator_statistics;
   // A list of wait tasks with external handles that need to be waited on.
   // Coordinators can choose to poll/wait on these.
   iree_task_list_t waiting_list;
+  // Earliest deadline of the scopes of tasks in waiting_list as of the last
+  // time it was checked for failed scopes. May be earlier than the true
+  // deadline (causing an extra check) but never later.
+  iree_time_t waiting_deadline_ns;
+  // iree_task_scope_change_epoch when waiting_list was last checked for
+  // failed scopes. The list only needs to be checked again once the epoch
+  // changes or waiting_deadline_ns passes.
+  int32_t waiting_scope_epoch;
   // Guards manipulation and use of the wait_set.
   // coordinator_mutex may be held when taking this lock.
   iree_slim_mutex_t wait_mutex;
   // Wait set containing all the tasks in waiting_list. Coordinator manages
   // keeping the waiting_list and wait_set in sync.
   iree_wait_set_t* wait_set;
+  // Event always present in the wait_set that is used to wake a coordinator
+  // blocked waiting such that it can observe changes made after it began
+  // waiting (new submissions, aborted scopes, etc).
+  iree_event_t wait_wake_event;
 
   // A bitset indicating which workers are live and usable; all attempts to
   // push work onto a particular worker should check first with this mask. This
@@ -105,13 +130,43 @@ struct iree_task_executor_t {
   // on already woken workers.
   iree_atomic_task_affinity_set_t worker_idle_mask;
 
+  // Wake notifications for all workers indexed by worker index. Sharing a
+  // single wake word allows a post batch to wake every worker that received
+  // tasks with one operation (a single syscall on platforms with futex
+  // bitsets) instead of one per worker.
+  iree_notification_set_t worker_wake_notifications;
+
+  // Largest worker local memory size reserved with
+  // iree_task_executor_reserve_worker_local_memory. Workers growing their
+  // local memory grow to at least this size.
+  iree_atomic_int64_t worker_local_memory_reservation;
+
   // Specifies how many workers threads there are.
   // For now this number is fixed per executor however if we wanted to enable
   // live join/leave behavior we could change this to a registration mechanism.
   iree_host_size_t worker_count;
   iree_task_worker_t* workers;  // [worker_count]
+
+  // Guards the donation worker; only one donated thread at a time may pump it
+  // as it owns the worker local deque. Other donating threads just wait.
+  iree_slim_mutex_t donation_mutex;
+
+  // Threadless worker pumped by threads donated via
+  // iree_task_executor_donate_caller. When the executor has threads of its own
+  // the donation worker is stored at workers[worker_count] (outside of the
+  // live worker set) and only receives work by stealing from the others. When
+  // the executor is threadless the donation worker is workers[0] and is where
+  // all work is posted.
+  iree_task_worker_t* donation_worker;
 };
 
+// Returns true if the executor has no threads of its own and only makes
+// progress when threads are donated to it.
+static inline bool iree_task_executor_is_threadless(
+    const iree_task_executor_t* executor) {
+  return executor->donation_worker == &executor->workers[0];
+}
+
 // Merges a submission into the primary FIFO queues.
 // Coordinators will fetch items from here as workers demand them but otherwise
 // not be notified of the changes (waiting until coordination runs again).
@@ -140,12 +195,17 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
 
 // Tries to steal an entire task from a sibling worker (based on topology).
 // Returns a task that is available (has not yet begun processing at all).
-// May steal multiple tasks and add them to the |local_task_queue|.
+// May steal multiple tasks and add them to the |local_task_deques| lane
+// matching their priority. Only tasks with a priority of at least
+// |min_priority| will be stolen and only workers in |theft_victim_mask| will be
+// stolen from.
 iree_task_t* iree_task_executor_try_steal_task(
     iree_task_executor_t* executor,
     iree_task_affinity_set_t constructive_sharing_mask,
-    uint32_t max_theft_attempts, iree_prng_minilcg128_state_t* theft_prng,
-    iree_task_queue_t* local_task_queue);
+    iree_task_affinity_set_t theft_victim_mask, uint32_t max_theft_attempts,
+    iree_prng_minilcg128_state_t* theft_prng,
+    iree_task_scope_priority_t min_priority,
+    iree_task_deque_t* local_task_deques);
 
 #ifdef __cplusplus
 }  // extern "C"
@@ -6,12 +6,19 @@
 
 #include "iree/task/executor.h"
 
+#include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <cstring>
+#include <thread>
 
 #include "iree/base/internal/prng.h"
+#include "iree/base/internal/wait_handle.h"
 #include "iree/base/tracing.h"
 #include "iree/task/topology_cpuinfo.h"
+#include "iree/task/tuning.h"
 #include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
 
 namespace {
 
@@ -91,8 +98,6 @@ TEST(ExecutorTest, Any) {
             IREE_TRACE_SCOPE0("tile0");
             EXPECT_EQ(0, user_context);
             simulate_work(tile_context);
-            iree_atomic_fetch_add_int32(&tile_context->statistics->reserved, 1,
-                                        iree_memory_order_relaxed);
             return iree_ok_status();
           },
           0),
@@ -109,8 +114,6 @@ TEST(ExecutorTest, Any) {
             IREE_TRACE_SCOPE0("tile1");
             EXPECT_EQ(0, user_context);
             simulate_work(tile_context);
-            iree_atomic_fetch_add_int32(&tile_context->statistics->reserved, 1,
-                                        iree_memory_order_relaxed);
             return iree_ok_status();
           },
           0),
@@ -169,4 +172,712 @@ TEST(ExecutorTest, Any) {
   iree_task_executor_release(executor);
 }
 
+// State shared between the tasks submitted by SubmitAndDonate.
+struct DonationState {
+  iree_event_t done_event;
+  std::thread::id caller_thread_id;
+  std::atomic<int> tile_count{0};
+  std::atomic<int> caller_tile_count{0};
+};
+
+// Submits call -> dispatch -> call+fence with the final call signaling
+// |state->done_event| and then donates the caller until it is signaled.
+// If |wait_set| is provided the caller is instead donated until any handle in
+// the set (which should include |state->done_event|) resolves.
+static iree_status_t SubmitAndDonate(iree_task_executor_t* executor,
+                                     iree_task_scope_t* scope,
+                                     DonationState* state,
+                                     iree_time_t deadline_ns,
+                                     iree_wait_set_t* wait_set = NULL) {
+  iree_task_call_t call0;
+  iree_task_call_initialize(scope,
+                            iree_task_make_call_closure(
+                                [](void* user_context, iree_task_t* task,
+                                   iree_task_submission_t* pending_submission) {
+                                  return iree_ok_status();
+                                },
+                                0),
+                            &call0);
+
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {64, 4, 1};
+  iree_task_dispatch_t dispatch0;
+  iree_task_dispatch_initialize(
+      scope,
+      iree_task_make_dispatch_closure(
+          [](void* user_context, const iree_task_tile_context_t* tile_context,
+             iree_task_submission_t* pending_submission) {
+            auto* state = (DonationState*)user_context;
+            ++state->tile_count;
+            if (std::this_thread::get_id() == state->caller_thread_id) {
+              ++state->caller_tile_count;
+            }
+            return iree_ok_status();
+          },
+          state),
+      workgroup_size, workgroup_count, &dispatch0);
+  iree_task_set_completion_task(&call0.header, &dispatch0.header);
+
+  iree_task_call_t call1;
+  iree_task_call_initialize(scope,
+                            iree_task_make_call_closure(
+                                [](void* user_context, iree_task_t* task,
+                                   iree_task_submission_t* pending_submission) {
+                                  auto* state = (DonationState*)user_context;
+                                  iree_event_set(&state->done_event);
+                                  return iree_ok_status();
+                                },
+                                state),
+                            &call1);
+  iree_task_set_completion_task(&dispatch0.header, &call1.header);
+
+  iree_task_fence_t* fence0 = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_task_executor_acquire_fence(executor, scope, &fence0));
+  iree_task_set_completion_task(&call1.header, &fence0->header);
+
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_task_submission_enqueue(&submission, &call0.header);
+  iree_task_executor_submit(executor, &submission);
+
+  state->caller_thread_id = std::this_thread::get_id();
+  if (wait_set) {
+    return iree_task_executor_donate_caller_any(executor, wait_set,
+                                                deadline_ns);
+  }
+  return iree_task_executor_donate_caller(executor, &state->done_event,
+                                          deadline_ns);
+}
+
+// Tests that a caller can donate itself to an executor with workers.
+TEST(ExecutorTest, DonateCaller) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/2, &topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_ASSERT_OK(iree_task_executor_create(
+      IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+      /*worker_local_memory_size=*/0, iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope);
+
+  DonationState state;
+  IREE_ASSERT_OK(iree_event_initialize(/*initial_state=*/false,
+                                       &state.done_event));
+  IREE_EXPECT_OK(
+      SubmitAndDonate(executor, &scope, &state, IREE_TIME_INFINITE_FUTURE));
+  IREE_EXPECT_OK(
+      iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+  EXPECT_EQ(64 * 4, state.tile_count.load());
+
+  iree_event_deinitialize(&state.done_event);
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+}
+
+#if IREE_STATISTICS_ENABLE
+// Tests that executor and scope statistics account for the work performed.
+TEST(ExecutorTest, Statistics) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/2, &topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_ASSERT_OK(iree_task_executor_create(
+      IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+      /*worker_local_memory_size=*/0, iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope);
+
+  DonationState state;
+  IREE_ASSERT_OK(iree_event_initialize(/*initial_state=*/false,
+                                       &state.done_event));
+  IREE_EXPECT_OK(
+      SubmitAndDonate(executor, &scope, &state, IREE_TIME_INFINITE_FUTURE));
+  IREE_EXPECT_OK(
+      iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+
+  iree_task_dispatch_statistics_t scope_statistics;
+  iree_task_scope_query_statistics(&scope, &scope_statistics);
+  EXPECT_EQ(1, scope_statistics.dispatch_count);
+  EXPECT_EQ(64 * 4, scope_statistics.tile_count);
+  EXPECT_GE(scope_statistics.reservation_count, 1);
+
+  // Querying must not reset the statistics.
+  iree_task_scope_query_statistics(&scope, &scope_statistics);
+  EXPECT_EQ(64 * 4, scope_statistics.tile_count);
+
+  // Two calls and at least one dispatch shard were executed; the dispatch
+  // itself is expanded by the coordinator and not counted.
+  iree_task_executor_statistics_t executor_statistics;
+  iree_task_executor_query_statistics(executor, &executor_statistics);
+  EXPECT_EQ(64 * 4, executor_statistics.tile_count);
+  EXPECT_GE(executor_statistics.task_count, 3);
+  EXPECT_GE(executor_statistics.coordinator_acquire_count, 1);
+  EXPECT_GE(executor_statistics.steal_attempt_count,
+            executor_statistics.steal_success_count);
+  EXPECT_GT(executor_statistics.execute_duration_ns, 0);
+
+  iree_event_deinitialize(&state.done_event);
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+}
+#endif  // IREE_STATISTICS_ENABLE
+
+// Tests that a threadless executor performs all work on the donated caller.
+TEST(ExecutorTest, Threadless) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/0, &topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_ASSERT_OK(iree_task_executor_create(
+      IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+      /*worker_local_memory_size=*/0, iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope);
+
+  for (int i = 0; i < 4; ++i) {
+    DonationState state;
+    IREE_ASSERT_OK(iree_event_initialize(/*initial_state=*/false,
+                                         &state.done_event));
+    IREE_EXPECT_OK(
+        SubmitAndDonate(executor, &scope, &state, IREE_TIME_INFINITE_FUTURE));
+    EXPECT_EQ(64 * 4, state.tile_count.load());
+    EXPECT_EQ(64 * 4, state.caller_tile_count.load());
+    // The fence is retired by the donated caller prior to it returning.
+    EXPECT_TRUE(iree_task_scope_is_idle(&scope));
+    iree_event_deinitialize(&state.done_event);
+  }
+
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+}
+
+// Tests that a threadless executor makes progress when the caller donates
+// itself while waiting on any of several handles.
+TEST(ExecutorTest, ThreadlessWaitAny) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/0, &topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_ASSERT_OK(iree_task_executor_create(
+      IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+      /*worker_local_memory_size=*/0, iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope);
+
+  // Only the event signaled by the submitted work will resolve.
+  iree_event_t never_event;
+  IREE_ASSERT_OK(iree_event_initialize(/*initial_state=*/false, &never_event));
+  DonationState state;
+  IREE_ASSERT_OK(iree_event_initialize(/*initial_state=*/false,
+                                       &state.done_event));
+  iree_wait_set_t* wait_set = NULL;
+  IREE_ASSERT_OK(
+      iree_wait_set_allocate(2, iree_allocator_system(), &wait_set));
+  IREE_ASSERT_OK(iree_wait_set_insert(wait_set, never_event));
+  IREE_ASSERT_OK(iree_wait_set_insert(wait_set, state.done_event));
+
+  IREE_EXPECT_OK(SubmitAndDonate(executor, &scope, &state,
+                                 IREE_TIME_INFINITE_FUTURE, wait_set));
+  EXPECT_EQ(64 * 4, state.caller_tile_count.load());
+  EXPECT_TRUE(iree_task_scope_is_idle(&scope));
+
+  // With nothing to do and nothing signaled the deadline is respected.
+  iree_wait_set_erase(wait_set, state.done_event);
+  iree_status_t status = iree_task_executor_donate_caller_any(
+      executor, wait_set, iree_time_now() + 1 * 1000000);
+  EXPECT_TRUE(iree_status_is_deadline_exceeded(status));
+  iree_status_ignore(status);
+
+  iree_wait_set_free(wait_set);
+  iree_event_deinitialize(&state.done_event);
+  iree_event_deinitialize(&never_event);
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+}
+
+// Tests that donating to a threadless executor with nothing to do respects the
+// deadline.
+TEST(ExecutorTest, ThreadlessDeadline) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/0, &topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_ASSERT_OK(iree_task_executor_create(
+      IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+      /*worker_local_memory_size=*/0, iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  iree_event_t event;
+  IREE_ASSERT_OK(iree_event_initialize(/*initial_state=*/false, &event));
+  iree_status_t status = iree_task_executor_donate_caller(
+      executor, &event, iree_time_now() + 1 * 1000000);
+  EXPECT_TRUE(iree_status_is_deadline_exceeded(status));
+  iree_status_ignore(status);
+
+  iree_event_set(&event);
+  IREE_EXPECT_OK(iree_task_executor_donate_caller(executor, &event,
+                                                  IREE_TIME_INFINITE_FUTURE));
+
+  iree_event_deinitialize(&event);
+  iree_task_executor_release(executor);
+}
+
+// Tests that workers grow their local memory on demand for dispatches that
+// require more than was reserved when the executor was created and that the
+// memory can still be used after a trim releases it.
+TEST(ExecutorTest, LocalMemoryGrowth) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/2, &topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_ASSERT_OK(iree_task_executor_create(
+      IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+      /*worker_local_memory_size=*/0, iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope);
+
+  static constexpr iree_host_size_t kLocalMemorySize = 192 * 1024;
+  iree_task_executor_reserve_worker_local_memory(executor, kLocalMemorySize);
+  for (int i = 0; i < 2; ++i) {
+    std::atomic<int> tile_count{0};
+    const uint32_t workgroup_size[3] = {1, 1, 1};
+    const uint32_t workgroup_count[3] = {16, 4, 1};
+    iree_task_dispatch_t dispatch0;
+    iree_task_dispatch_initialize(
+        &scope,
+        iree_task_make_dispatch_closure(
+            [](void* user_context, const iree_task_tile_context_t* tile_context,
+               iree_task_submission_t* pending_submission) {
+              if (tile_context->local_memory.data_length < kLocalMemorySize) {
+                return iree_make_status(IREE_STATUS_INTERNAL,
+                                        "local memory not grown");
+              }
+              // Touch the full range so that ASAN can verify it.
+              memset(tile_context->local_memory.data, 0xCD,
+                     tile_context->local_memory.data_length);
+              ++*(std::atomic<int>*)user_context;
+              return iree_ok_status();
+            },
+            &tile_count),
+        workgroup_size, workgroup_count, &dispatch0);
+    dispatch0.local_memory_size = kLocalMemorySize;
+
+    iree_task_fence_t* fence0 = NULL;
+    IREE_ASSERT_OK(iree_task_executor_acquire_fence(executor, &scope, &fence0));
+    iree_task_set_completion_task(&dispatch0.header, &fence0->header);
+
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    iree_task_submission_enqueue(&submission, &dispatch0.header);
+    iree_task_executor_submit(executor, &submission);
+    iree_task_executor_flush(executor);
+    IREE_EXPECT_OK(
+        iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+    IREE_EXPECT_OK(iree_task_scope_consume_status(&scope));
+    EXPECT_EQ(16 * 4, tile_count.load());
+
+    // Release the grown memory; the next iteration must grow it again.
+    iree_task_executor_trim(executor);
+  }
+
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+}
+
+// Busy-waits for |duration_ns| to simulate a tile or call doing real work.
+static void SpinFor(iree_duration_t duration_ns) {
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::nanoseconds(duration_ns);
+  while (std::chrono::steady_clock::now() < deadline) {
+  }
+}
+
+// Creates an executor with a single worker so that task ordering is entirely
+// determined by the worker lanes.
+static iree_task_executor_t* CreateSingleWorkerExecutor() {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/1, &topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(iree_task_executor_create(
+      IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+      /*worker_local_memory_size=*/0, iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+  return executor;
+}
+
+// State shared between the tasks in the priority tests.
+struct PriorityState {
+  static constexpr int kLowTileCount = 64;
+  std::atomic<int> low_tile_count{0};
+  std::atomic<int> low_tile_count_at_high{-1};
+};
+
+// Tests that a high priority task posted to a worker busy with a low priority
+// dispatch preempts the dispatch instead of waiting for it to complete.
+TEST(ExecutorTest, PriorityPreemption) {
+  iree_task_executor_t* executor = CreateSingleWorkerExecutor();
+
+  iree_task_scope_t low_scope;
+  iree_task_scope_initialize(iree_make_cstring_view("low"), &low_scope);
+  iree_task_scope_set_priority(&low_scope, IREE_TASK_SCOPE_PRIORITY_LOW);
+  iree_task_scope_t high_scope;
+  iree_task_scope_initialize(iree_make_cstring_view("high"), &high_scope);
+  iree_task_scope_set_priority(&high_scope, IREE_TASK_SCOPE_PRIORITY_HIGH);
+
+  PriorityState state;
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {PriorityState::kLowTileCount, 1, 1};
+  iree_task_dispatch_t low_dispatch;
+  iree_task_dispatch_initialize(
+      &low_scope,
+      iree_task_make_dispatch_closure(
+          [](void* user_context, const iree_task_tile_context_t* tile_context,
+             iree_task_submission_t* pending_submission) {
+            SpinFor(500 * 1000);
+            ++((PriorityState*)user_context)->low_tile_count;
+            return iree_ok_status();
+          },
+          &state),
+      workgroup_size, workgroup_count, &low_dispatch);
+  iree_task_fence_t* low_fence = NULL;
+  IREE_ASSERT_OK(
+      iree_task_executor_acquire_fence(executor, &low_scope, &low_fence));
+  iree_task_set_completion_task(&low_dispatch.header, &low_fence->header);
+  iree_task_submission_t low_submission;
+  iree_task_submission_initialize(&low_submission);
+  iree_task_submission_enqueue(&low_submission, &low_dispatch.header);
+  iree_task_executor_submit(executor, &low_submission);
+  iree_task_executor_flush(executor);
+
+  // Wait for the worker to be in the middle of the dispatch.
+  while (state.low_tile_count.load() == 0) {
+    std::this_thread::yield();
+  }
+
+  iree_task_call_t high_call;
+  iree_task_call_initialize(
+      &high_scope,
+      iree_task_make_call_closure(
+          [](void* user_context, iree_task_t* task,
+             iree_task_submission_t* pending_submission) {
+            auto* state = (PriorityState*)user_context;
+            state->low_tile_count_at_high = state->low_tile_count.load();
+            return iree_ok_status();
+          },
+          &state),
+      &high_call);
+  iree_task_fence_t* high_fence = NULL;
+  IREE_ASSERT_OK(
+      iree_task_executor_acquire_fence(executor, &high_scope, &high_fence));
+  iree_task_set_completion_task(&high_call.header, &high_fence->header);
+  iree_task_submission_t high_submission;
+  iree_task_submission_initialize(&high_submission);
+  iree_task_submission_enqueue(&high_submission, &high_call.header);
+  iree_task_executor_submit(executor, &high_submission);
+  iree_task_executor_flush(executor);
+
+  IREE_EXPECT_OK(
+      iree_task_scope_wait_idle(&high_scope, IREE_TIME_INFINITE_FUTURE));
+  IREE_EXPECT_OK(
+      iree_task_scope_wait_idle(&low_scope, IREE_TIME_INFINITE_FUTURE));
+  EXPECT_EQ(PriorityState::kLowTileCount, state.low_tile_count.load());
+  EXPECT_GE(state.low_tile_count_at_high.load(), 1);
+  EXPECT_LT(state.low_tile_count_at_high.load(), PriorityState::kLowTileCount);
+
+  iree_task_scope_deinitialize(&high_scope);
+  iree_task_scope_deinitialize(&low_scope);
+  iree_task_executor_release(executor);
+}
+
+// State for a chain of high priority calls that each enqueue the next.
+struct PriorityChainState {
+  static constexpr int kCallCount = 512;
+  iree_task_call_t calls[kCallCount];
+  std::atomic<int> call_count{0};
+  std::atomic<int> call_count_at_low{-1};
+};
+
+// Tests that low priority work still makes progress while a worker is
+// continuously fed high priority work.
+TEST(ExecutorTest, PriorityStarvationGuard) {
+  iree_task_executor_t* executor = CreateSingleWorkerExecutor();
+
+  iree_task_scope_t low_scope;
+  iree_task_scope_initialize(iree_make_cstring_view("low"), &low_scope);
+  iree_task_scope_set_priority(&low_scope, IREE_TASK_SCOPE_PRIORITY_LOW);
+  iree_task_scope_t high_scope;
+  iree_task_scope_initialize(iree_make_cstring_view("high"), &high_scope);
+  iree_task_scope_set_priority(&high_scope, IREE_TASK_SCOPE_PRIORITY_HIGH);
+
+  // Each high priority call enqueues the next such that there is always one
+  // ready until the chain completes.
+  auto* chain = new PriorityChainState();
+  for (int i = 0; i < PriorityChainState::kCallCount; ++i) {
+    iree_task_call_initialize(
+        &high_scope,
+        iree_task_make_call_closure(
+            [](void* user_context, iree_task_t* task,
+               iree_task_submission_t* pending_submission) {
+              auto* chain = (PriorityChainState*)user_context;
+              SpinFor(20 * 1000);
+              int index = (int)((iree_task_call_t*)task - chain->calls);
+              ++chain->call_count;
+              if (index + 1 < PriorityChainState::kCallCount) {
+                iree_task_submission_enqueue(pending_submission,
+                                             &chain->calls[index + 1].header);
+              }
+              return iree_ok_status();
+            },
+            chain),
+        &chain->calls[i]);
+  }
+  iree_task_fence_t* high_fence = NULL;
+  IREE_ASSERT_OK(
+      iree_task_executor_acquire_fence(executor, &high_scope, &high_fence));
+  iree_task_set_completion_task(
+      &chain->calls[PriorityChainState::kCallCount - 1].header,
+      &high_fence->header);
+
+  iree_task_call_t low_call;
+  iree_task_call_initialize(
+      &low_scope,
+      iree_task_make_call_closure(
+          [](void* user_context, iree_task_t* task,
+             iree_task_submission_t* pending_submission) {
+            auto* chain = (PriorityChainState*)user_context;
+            chain->call_count_at_low = chain->call_count.load();
+            return iree_ok_status();
+          },
+          chain),
+      &low_call);
+  iree_task_fence_t* low_fence = NULL;
+  IREE_ASSERT_OK(
+      iree_task_executor_acquire_fence(executor, &low_scope, &low_fence));
+  iree_task_set_completion_task(&low_call.header, &low_fence->header);
+
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_task_submission_enqueue(&submission, &chain->calls[0].header);
+  iree_task_submission_enqueue(&submission, &low_call.header);
+  iree_task_executor_submit(executor, &submission);
+  iree_task_executor_flush(executor);
+
+  IREE_EXPECT_OK(
+      iree_task_scope_wait_idle(&high_scope, IREE_TIME_INFINITE_FUTURE));
+  IREE_EXPECT_OK(
+      iree_task_scope_wait_idle(&low_scope, IREE_TIME_INFINITE_FUTURE));
+  EXPECT_EQ(PriorityChainState::kCallCount, chain->call_count.load());
+  EXPECT_LT(chain->call_count_at_low.load(), PriorityChainState::kCallCount);
+
+  delete chain;
+  iree_task_scope_deinitialize(&high_scope);
+  iree_task_scope_deinitialize(&low_scope);
+  iree_task_executor_release(executor);
+}
+
+#if IREE_STATISTICS_ENABLE
+// Tests that a starvation guard turn only grants a single slice: once the
+// higher priority work is gone the low priority dispatch must run without
+// being preempted.
+TEST(ExecutorTest, PriorityStarvationGuardEnds) {
+  iree_task_executor_t* executor = CreateSingleWorkerExecutor();
+
+  iree_task_scope_t low_scope;
+  iree_task_scope_initialize(iree_make_cstring_view("low"), &low_scope);
+  iree_task_scope_set_priority(&low_scope, IREE_TASK_SCOPE_PRIORITY_LOW);
+  iree_task_scope_t high_scope;
+  iree_task_scope_initialize(iree_make_cstring_view("high"), &high_scope);
+  iree_task_scope_set_priority(&high_scope, IREE_TASK_SCOPE_PRIORITY_HIGH);
+
+  // Independent high priority calls that are all ready at once and trigger
+  // the guard a few times. Nothing is posted to the worker after they are
+  // flushed into its local lanes.
+  static constexpr int kHighCallCount = 2 * IREE_TASK_PRIORITY_STARVATION_LIMIT;
+  auto* chain = new PriorityChainState();
+  iree_task_fence_t* high_fence = NULL;
+  IREE_ASSERT_OK(
+      iree_task_executor_acquire_fence(executor, &high_scope, &high_fence));
+  for (int i = 0; i < kHighCallCount; ++i) {
+    iree_task_call_initialize(
+        &high_scope,
+        iree_task_make_call_closure(
+            [](void* user_context, iree_task_t* task,
+               iree_task_submission_t* pending_submission) {
+              SpinFor(20 * 1000);
+              ++((PriorityChainState*)user_context)->call_count;
+              return iree_ok_status();
+            },
+            chain),
+        &chain->calls[i]);
+    iree_task_set_completion_task(&chain->calls[i].header,
+                                  &high_fence->header);
+  }
+
+  // Expensive tiles keep reservations small such that a lingering preemption
+  // bit would preempt the dispatch many times.
+  PriorityState state;
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {PriorityState::kLowTileCount, 1, 1};
+  iree_task_dispatch_t low_dispatch;
+  iree_task_dispatch_initialize(
+      &low_scope,
+      iree_task_make_dispatch_closure(
+          [](void* user_context, const iree_task_tile_context_t* tile_context,
+             iree_task_submission_t* pending_submission) {
+            SpinFor(500 * 1000);
+            ++((PriorityState*)user_context)->low_tile_count;
+            return iree_ok_status();
+          },
+          &state),
+      workgroup_size, workgroup_count, &low_dispatch);
+  iree_task_fence_t* low_fence = NULL;
+  IREE_ASSERT_OK(
+      iree_task_executor_acquire_fence(executor, &low_scope, &low_fence));
+  iree_task_set_completion_task(&low_dispatch.header, &low_fence->header);
+
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  for (int i = 0; i < kHighCallCount; ++i) {
+    iree_task_submission_enqueue(&submission, &chain->calls[i].header);
+  }
+  iree_task_submission_enqueue(&submission, &low_dispatch.header);
+  iree_task_executor_submit(executor, &submission);
+  iree_task_executor_flush(executor);
+
+  IREE_EXPECT_OK(
+      iree_task_scope_wait_idle(&high_scope, IREE_TIME_INFINITE_FUTURE));
+  IREE_EXPECT_OK(
+      iree_task_scope_wait_idle(&low_scope, IREE_TIME_INFINITE_FUTURE));
+  EXPECT_EQ(kHighCallCount, chain->call_count.load());
+  EXPECT_EQ(PriorityState::kLowTileCount, state.low_tile_count.load());
+
+  // At most one preemption per guard turn (plus one for the high priority
+  // work arriving while the dispatch runs).
+  iree_task_dispatch_statistics_t statistics;
+  iree_task_scope_query_statistics(&low_scope, &statistics);
+  EXPECT_LE(statistics.preemption_count,
+            kHighCallCount / IREE_TASK_PRIORITY_STARVATION_LIMIT + 1);
+
+  delete chain;
+  iree_task_scope_deinitialize(&high_scope);
+  iree_task_scope_deinitialize(&low_scope);
+  iree_task_executor_release(executor);
+}
+#endif  // IREE_STATISTICS_ENABLE
+
+// Submits a wait task on |event| followed by a call task that increments
+// |call_count| and a fence and flushes them to |executor|.
+static void SubmitWaitAndCall(iree_task_executor_t* executor,
+                              iree_task_scope_t* scope, iree_event_t event,
+                              iree_task_wait_t* wait, iree_task_call_t* call,
+                              std::atomic<int>* call_count) {
+  iree_task_wait_initialize(scope, event, wait);
+  iree_task_call_initialize(scope,
+                            iree_task_make_call_closure(
+                                [](void* user_context, iree_task_t* task,
+                                   iree_task_submission_t* pending_submission) {
+                                  ++*(std::atomic<int>*)user_context;
+                                  return iree_ok_status();
+                                },
+                                call_count),
+                            call);
+  iree_task_set_completion_task(&wait->header, &call->header);
+  iree_task_fence_t* fence = NULL;
+  IREE_CHECK_OK(iree_task_executor_acquire_fence(executor, scope, &fence));
+  iree_task_set_completion_task(&call->header, &fence->header);
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_task_submission_enqueue(&submission, &wait->header);
+  iree_task_executor_submit(executor, &submission);
+  iree_task_executor_flush(executor);
+}
+
+// Tests that a wait submitted to an executor with all workers idle is waited
+// on: the coordinator flushing it won't wait itself and must hand the wait
+// off to a worker.
+TEST(ExecutorTest, WaitOnIdleExecutor) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/2, &topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_ASSERT_OK(iree_task_executor_create(
+      IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+      /*worker_local_memory_size=*/0, iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope);
+  iree_event_t event;
+  IREE_ASSERT_OK(iree_event_initialize(/*initial_state=*/false, &event));
+
+  for (int i = 0; i < 8; ++i) {
+    // Let the workers go idle before the wait arrives.
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    iree_event_reset(&event);
+    std::atomic<int> call_count{0};
+    iree_task_wait_t wait;
+    iree_task_call_t call;
+    SubmitWaitAndCall(executor, &scope, event, &wait, &call, &call_count);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    EXPECT_EQ(0, call_count.load());
+
+    // Nothing else is submitted: only a thread waiting on the wait set can
+    // notice the signal.
+    iree_event_set(&event);
+    IREE_ASSERT_OK(
+        iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+    EXPECT_EQ(1, call_count.load());
+  }
+
+  iree_event_deinitialize(&event);
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+}
+
+// Tests that waits racing with coordinators polling them away do not leave a
+// worker blocked on a wait set with nothing left in it. Previously a worker
+// released the coordinator lock before acquiring the wait lock and could end
+// up blocked forever, hanging the scope and executor teardown.
+TEST(ExecutorTest, WaitRacingPoll) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/2, &topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_ASSERT_OK(iree_task_executor_create(
+      IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+      /*worker_local_memory_size=*/0, iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope);
+  iree_event_t event;
+  IREE_ASSERT_OK(iree_event_initialize(/*initial_state=*/false, &event));
+
+  iree_prng_splitmix64_state_t prng;
+  iree_prng_splitmix64_initialize(/*seed=*/0, &prng);
+  for (int i = 0; i < 2048; ++i) {
+    iree_event_reset(&event);
+    std::atomic<int> call_count{0};
+    iree_task_wait_t wait;
+    iree_task_call_t call;
+    SubmitWaitAndCall(executor, &scope, event, &wait, &call, &call_count);
+    // Signal and poll the wait away at varying points while the workers are
+    // coordinating (and deciding who waits) after the flush.
+    SpinFor(iree_prng_splitmix64_next(&prng) % (50 * 1000));
+    iree_event_set(&event);
+    iree_task_executor_flush(executor);
+    IREE_ASSERT_OK(
+        iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+    EXPECT_EQ(1, call_count.load());
+  }
+
+  iree_event_deinitialize(&event);
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+}
+
 }  // namespace
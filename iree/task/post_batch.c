@@ -14,7 +14,6 @@
 #include "iree/base/internal/threading.h"
 #include "iree/base/tracing.h"
 #include "iree/task/executor_impl.h"
-#include "iree/task/queue.h"
 #include "iree/task/worker.h"
 
 void iree_task_post_batch_initialize(iree_task_executor_t* executor,
@@ -112,7 +111,7 @@ static void iree_task_post_batch_wake_workers(
     int resume_count = iree_task_affinity_set_count_ones(resume_mask);
     int worker_index = 0;
     for (int i = 0; i < resume_count; ++i) {
-      int offset = iree_task_affinity_set_count_trailing_zeros(resume_mask) + 1;
+      int offset = iree_task_affinity_set_count_trailing_zeros(resume_mask);
       int resume_index = worker_index + offset;
       worker_index += offset + 1;
       resume_mask = iree_shr(resume_mask, offset + 1);
@@ -120,14 +119,16 @@ static void iree_task_post_batch_wake_workers(
     }
   }
 
-  // TODO(#4016): use a FUTEX_WAKE_BITSET here to wake all of the workers that
-  // have pending work in a single syscall (vs. popcnt(worker_pending_mask)
-  // syscalls). This will reduce wake latency for workers later in the set;
-  // for example today worker[31] will wait until workers[0-30] have had their
-  // syscalls performed before it's even requested to wake. This also loses
-  // information the kernel could use to avoid core migration as it knows when N
-  // threads will be needed simultaneously and can hopefully perform any needed
-  // migrations prior to beginning execution.
+  // Wake all of the workers that have pending work at once. Workers that are
+  // not parked (still running or spinning) only have their bit set and need no
+  // syscall, while all parked workers are woken together with a single syscall
+  // where supported (FUTEX_WAKE_BITSET). This avoids workers later in the set
+  // waiting on the syscalls for all earlier ones and gives the kernel the full
+  // set of threads that will be needed simultaneously so that it can perform
+  // any needed migrations prior to beginning execution.
+  iree_notification_set_post(&executor->worker_wake_notifications, wake_mask);
+
+#if IREE_STATISTICS_ENABLE
   int wake_count = iree_task_affinity_set_count_ones(wake_mask);
   int worker_index = 0;
   for (int i = 0; i < wake_count; ++i) {
@@ -135,18 +136,21 @@ static void iree_task_post_batch_wake_workers(
     int wake_index = worker_index + offset;
     worker_index += offset + 1;
     wake_mask = iree_shr(wake_mask, offset + 1);
-
-    // Wake workers if they are waiting - workers are the only thing that can
-    // wait on this notification so this should almost always be either free (an
-    // atomic load) if a particular worker isn't waiting or it's required to
-    // actually wake it and we can't avoid it.
     iree_task_worker_t* worker = &executor->workers[wake_index];
-    iree_notification_post(&worker->wake_notification, 1);
+    iree_atomic_fetch_add_int64(&worker->statistics.wake_count, 1,
+                                iree_memory_order_relaxed);
   }
+#endif  // IREE_STATISTICS_ENABLE
 
   IREE_TRACE_ZONE_END(z0);
 }
 
+void iree_task_post_batch_wake_worker(iree_task_post_batch_t* post_batch,
+                                      iree_host_size_t worker_index) {
+  iree_task_post_batch_wake_workers(
+      post_batch, iree_task_affinity_for_worker(worker_index));
+}
+
 bool iree_task_post_batch_submit(iree_task_post_batch_t* post_batch) {
   if (!post_batch->worker_pending_mask) return false;
 
@@ -173,8 +177,7 @@ bool iree_task_post_batch_submit(iree_task_post_batch_t* post_batch) {
       // role of coordinator and we want to ensure we aren't doing a fully
       // block-and-flush loop when we could just be popping the next new task
       // off the list.
-      iree_task_queue_append_from_lifo_list_unsafe(&worker->local_task_queue,
-                                                   target_pending_lifo);
+      iree_task_worker_push_lifo_list(worker, target_pending_lifo);
     } else {
       iree_task_worker_post_tasks(worker, target_pending_lifo);
       worker_wake_mask |= iree_task_affinity_for_worker(target_index);
@@ -62,6 +62,11 @@ void iree_task_post_batch_enqueue(iree_task_post_batch_t* post_batch,
                                   iree_host_size_t worker_index,
                                   iree_task_t* task);
 
+// Wakes the given worker (resuming it if needed) without posting any tasks to
+// it. The worker will coordinate before going idle again.
+void iree_task_post_batch_wake_worker(iree_task_post_batch_t* post_batch,
+                                      iree_host_size_t worker_index);
+
 // Submits all pending tasks to their worker mailboxes and resets state.
 // Returns true if any tasks were posted to workers.
 bool iree_task_post_batch_submit(iree_task_post_batch_t* post_batch);
@@ -0,0 +1,158 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "iree/base/api.h"
+#include "iree/task/executor.h"
+#include "iree/task/scope.h"
+#include "iree/task/submission.h"
+#include "iree/task/task.h"
+#include "iree/task/topology.h"
+
+namespace {
+
+// Number of workers in the executor; small enough to saturate on most hosts.
+constexpr iree_host_size_t kWorkerCount = 4;
+
+// Tiles per worker in each background dispatch and how long each takes.
+// Background dispatches are large enough that a foreground submission that
+// has to wait for one to drain is easy to spot in the tail latencies.
+constexpr uint32_t kBackgroundTilesPerWorker = 256;
+constexpr std::chrono::microseconds kBackgroundTileDuration{50};
+
+// Tiles per worker in each foreground dispatch and how long each takes.
+constexpr uint32_t kForegroundTilesPerWorker = 1;
+constexpr std::chrono::microseconds kForegroundTileDuration{10};
+
+// Busy-waits for |duration| to simulate a tile doing real work.
+void SpinFor(std::chrono::microseconds duration) {
+  auto deadline = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < deadline) {
+  }
+}
+
+iree_status_t BackgroundTile(void* user_context,
+                             const iree_task_tile_context_t* tile_context,
+                             iree_task_submission_t* pending_submission) {
+  SpinFor(kBackgroundTileDuration);
+  return iree_ok_status();
+}
+
+iree_status_t ForegroundTile(void* user_context,
+                             const iree_task_tile_context_t* tile_context,
+                             iree_task_submission_t* pending_submission) {
+  SpinFor(kForegroundTileDuration);
+  return iree_ok_status();
+}
+
+// Submits a dispatch of |tile_count| tiles in |scope| and waits for it to
+// complete.
+void SubmitAndWait(iree_task_executor_t* executor, iree_task_scope_t* scope,
+                   iree_task_dispatch_closure_t closure, uint32_t tile_count) {
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {tile_count, 1, 1};
+  iree_task_dispatch_t dispatch;
+  iree_task_dispatch_initialize(scope, closure, workgroup_size,
+                                workgroup_count, &dispatch);
+  iree_task_fence_t* fence = NULL;
+  IREE_CHECK_OK(iree_task_executor_acquire_fence(executor, scope, &fence));
+  iree_task_set_completion_task(&dispatch.header, &fence->header);
+
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_task_submission_enqueue(&submission, &dispatch.header);
+  iree_task_executor_submit(executor, &submission);
+  iree_task_executor_flush(executor);
+  IREE_CHECK_OK(iree_task_scope_wait_idle(scope, IREE_TIME_INFINITE_FUTURE));
+}
+
+//==============================================================================
+// Foreground latency under background load
+//==============================================================================
+// A background thread continuously keeps all workers busy with large
+// dispatches while the benchmark thread measures the submit->complete latency
+// of small foreground dispatches. |state.range(0)| and |state.range(1)| are
+// the iree_task_scope_priority_t of the foreground and background scopes,
+// respectively: with equal priorities the foreground work queues up behind
+// whatever the workers are processing and with a higher foreground priority it
+// should preempt the background work.
+//
+// Reported times are the mean latency; p50/p99 latencies are reported as
+// counters as the tail is what matters here.
+
+void BM_ForegroundLatency(benchmark::State& state) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(kWorkerCount, &topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(iree_task_executor_create(
+      IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+      /*worker_local_memory_size=*/0, iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  iree_task_scope_t foreground_scope;
+  iree_task_scope_initialize(iree_make_cstring_view("foreground"),
+                             &foreground_scope);
+  iree_task_scope_set_priority(&foreground_scope,
+                               (iree_task_scope_priority_t)state.range(0));
+  iree_task_scope_t background_scope;
+  iree_task_scope_initialize(iree_make_cstring_view("background"),
+                             &background_scope);
+  iree_task_scope_set_priority(&background_scope,
+                               (iree_task_scope_priority_t)state.range(1));
+
+  std::atomic<bool> done{false};
+  std::thread background_thread([&]() {
+    while (!done.load(std::memory_order_relaxed)) {
+      SubmitAndWait(executor, &background_scope,
+                    iree_task_make_dispatch_closure(BackgroundTile, NULL),
+                    kWorkerCount * kBackgroundTilesPerWorker);
+    }
+  });
+
+  // Give the background work a chance to fill up the workers.
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  std::vector<double> latencies;
+  for (auto _ : state) {
+    auto start_time = std::chrono::steady_clock::now();
+    SubmitAndWait(executor, &foreground_scope,
+                  iree_task_make_dispatch_closure(ForegroundTile, NULL),
+                  kWorkerCount * kForegroundTilesPerWorker);
+    std::chrono::duration<double> latency =
+        std::chrono::steady_clock::now() - start_time;
+    state.SetIterationTime(latency.count());
+    latencies.push_back(latency.count());
+  }
+
+  done = true;
+  background_thread.join();
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&](double p) {
+    return latencies[std::min(latencies.size() - 1,
+                              (size_t)(p * latencies.size()))];
+  };
+  state.counters["p50_us"] = percentile(0.50) * 1e6;
+  state.counters["p99_us"] = percentile(0.99) * 1e6;
+
+  iree_task_scope_deinitialize(&background_scope);
+  iree_task_scope_deinitialize(&foreground_scope);
+  iree_task_executor_release(executor);
+}
+BENCHMARK(BM_ForegroundLatency)
+    ->ArgNames({"fg", "bg"})
+    ->Args({IREE_TASK_SCOPE_PRIORITY_NORMAL, IREE_TASK_SCOPE_PRIORITY_NORMAL})
+    ->Args({IREE_TASK_SCOPE_PRIORITY_HIGH, IREE_TASK_SCOPE_PRIORITY_LOW})
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace
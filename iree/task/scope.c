@@ -25,6 +25,10 @@ void iree_task_scope_initialize(iree_string_view_t name,
   // TODO(benvanik): pick trace colors based on name hash.
   IREE_TRACE(out_scope->task_trace_color = 0xFFFF0000u);
 
+  out_scope->priority = IREE_TASK_SCOPE_PRIORITY_NORMAL;
+  iree_atomic_store_int64(&out_scope->deadline_ns, IREE_TIME_INFINITE_FUTURE,
+                          iree_memory_order_relaxed);
+
   iree_slim_mutex_initialize(&out_scope->mutex);
   iree_notification_initialize(&out_scope->idle_notification);
 
@@ -59,6 +63,24 @@ iree_string_view_t iree_task_scope_name(iree_task_scope_t* scope) {
   return iree_make_cstring_view(scope->name);
 }
 
+iree_task_scope_priority_t iree_task_scope_priority(
+    const iree_task_scope_t* scope) {
+  return scope->priority;
+}
+
+void iree_task_scope_set_priority(iree_task_scope_t* scope,
+                                  iree_task_scope_priority_t priority) {
+  IREE_ASSERT_LE(priority, IREE_TASK_SCOPE_PRIORITY_HIGH);
+  scope->priority = priority;
+}
+
+void iree_task_scope_query_statistics(
+    iree_task_scope_t* scope, iree_task_dispatch_statistics_t* out_statistics) {
+  memset(out_statistics, 0, sizeof(*out_statistics));
+  iree_task_dispatch_statistics_merge(&scope->dispatch_statistics,
+                                      out_statistics);
+}
+
 iree_task_dispatch_statistics_t iree_task_scope_consume_statistics(
     iree_task_scope_t* scope) {
   iree_task_dispatch_statistics_t result = scope->dispatch_statistics;
@@ -66,9 +88,29 @@ iree_task_dispatch_statistics_t iree_task_scope_consume_statistics(
   return result;
 }
 
-bool iree_task_scope_has_failed(iree_task_scope_t* scope) {
-  return iree_atomic_load_intptr(&scope->permanent_status,
-                                 iree_memory_order_seq_cst) != 0;
+iree_time_t iree_task_scope_deadline(iree_task_scope_t* scope) {
+  return iree_atomic_load_int64(&scope->deadline_ns, iree_memory_order_relaxed);
+}
+
+// Incremented whenever any scope fails or has its deadline changed.
+static iree_atomic_int32_t iree_task_scope_change_epoch_ =
+    IREE_ATOMIC_VAR_INIT(0);
+
+int32_t iree_task_scope_change_epoch(void) {
+  return iree_atomic_load_int32(&iree_task_scope_change_epoch_,
+                                iree_memory_order_acquire);
+}
+
+static void iree_task_scope_bump_change_epoch(void) {
+  iree_atomic_fetch_add_int32(&iree_task_scope_change_epoch_, 1,
+                              iree_memory_order_release);
+}
+
+void iree_task_scope_set_deadline(iree_task_scope_t* scope,
+                                  iree_time_t deadline_ns) {
+  iree_atomic_store_int64(&scope->deadline_ns, deadline_ns,
+                          iree_memory_order_relaxed);
+  iree_task_scope_bump_change_epoch();
 }
 
 iree_status_t iree_task_scope_consume_status(iree_task_scope_t* scope) {
@@ -99,11 +141,29 @@ static void iree_task_scope_try_set_status(iree_task_scope_t* scope,
           iree_memory_order_seq_cst)) {
     // Previous status was not OK; drop our new status.
     IREE_IGNORE_ERROR(new_status);
+  } else {
+    iree_task_scope_bump_change_epoch();
   }
 
   IREE_TRACE_ZONE_END(z0);
 }
 
+bool iree_task_scope_has_failed(iree_task_scope_t* scope) {
+  if (iree_atomic_load_intptr(&scope->permanent_status,
+                              iree_memory_order_seq_cst) != 0) {
+    return true;
+  }
+
+  // Only query the time if the scope has a deadline; most don't.
+  iree_time_t deadline_ns = iree_task_scope_deadline(scope);
+  if (IREE_LIKELY(deadline_ns == IREE_TIME_INFINITE_FUTURE)) return false;
+  if (iree_time_now() < deadline_ns) return false;
+  iree_task_scope_try_set_status(
+      scope, iree_make_status(IREE_STATUS_DEADLINE_EXCEEDED,
+                              "scope deadline exceeded"));
+  return true;
+}
+
 void iree_task_scope_abort(iree_task_scope_t* scope) {
   iree_status_t status =
       iree_make_status(IREE_STATUS_ABORTED, "entire scope aborted by user");
@@ -155,10 +215,13 @@ iree_status_t iree_task_scope_wait_idle(iree_task_scope_t* scope,
                             (iree_condition_fn_t)iree_task_scope_is_idle,
                             scope);
   } else {
-    // NOTE: we are currently ignoring |deadline_ns|.
-    // We need to support timeouts on iree_notification_t to support this.
-    status = iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                              "scope-based waits do not yet support timeouts");
+    // Wait for the scope to enter the idle state or the deadline to elapse.
+    if (!iree_notification_await_until(
+            &scope->idle_notification,
+            (iree_condition_fn_t)iree_task_scope_is_idle, scope,
+            deadline_ns)) {
+      status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    }
   }
 
   IREE_TRACE_ZONE_END(z0);
@@ -20,6 +20,28 @@
 extern "C" {
 #endif  // __cplusplus
 
+// Scheduling priority class of all tasks within a scope.
+// Workers always prefer to run tasks from higher priority scopes over those
+// from lower priority ones, both when choosing between their own local tasks
+// and when stealing from other workers. To ensure forward progress lower
+// priority work is guaranteed a periodic slice of each worker even when higher
+// priority work is continuously available; see
+// IREE_TASK_PRIORITY_STARVATION_LIMIT.
+//
+// NOTE: values are ordered such that </> comparisons can be used and are used
+// as indices into per-priority worker lanes.
+typedef enum iree_task_scope_priority_e {
+  // Background work that may be deferred when other work is available.
+  IREE_TASK_SCOPE_PRIORITY_LOW = 0,
+  // Default priority of all scopes.
+  IREE_TASK_SCOPE_PRIORITY_NORMAL = 1,
+  // Latency-sensitive work that should preempt all other work.
+  IREE_TASK_SCOPE_PRIORITY_HIGH = 2,
+} iree_task_scope_priority_t;
+
+// Total number of distinct scope priority classes.
+#define IREE_TASK_SCOPE_PRIORITY_COUNT (IREE_TASK_SCOPE_PRIORITY_HIGH + 1)
+
 // A loose way of grouping tasks within the task system.
 // Each scope represents a unique collection of tasks that have some related
 // properties - most often their producer - that need to carry along some
@@ -50,11 +72,20 @@ typedef struct iree_task_scope_t {
   // The color will be modulated based on task type.
   IREE_TRACE(uint32_t task_trace_color;)
 
+  // Scheduling priority of all tasks within the scope.
+  // Must only be changed while the scope is idle.
+  iree_task_scope_priority_t priority;
+
   // A permanent status code set when a task within the scope fails. All pending
   // tasks will be aborted, though any in-flight tasks may continue executing
   // to completion.
   iree_atomic_intptr_t permanent_status;
 
+  // Absolute time in nanoseconds after which the scope will be failed with
+  // IREE_STATUS_DEADLINE_EXCEEDED or IREE_TIME_INFINITE_FUTURE if none.
+  // Checked whenever the scope failure state is polled.
+  iree_atomic_int64_t deadline_ns;
+
   // Dispatch statistics aggregated from all dispatches in this scope. Updated
   // relatively infrequently and must not be used for task control as values
   // are undefined in the case of failure and may tear.
@@ -98,13 +129,49 @@ void iree_task_scope_deinitialize(iree_task_scope_t* scope);
 // string.
 iree_string_view_t iree_task_scope_name(iree_task_scope_t* scope);
 
+// Returns the scheduling priority of tasks within the scope.
+iree_task_scope_priority_t iree_task_scope_priority(
+    const iree_task_scope_t* scope);
+
+// Sets the scheduling priority of tasks within the scope.
+// The scope must be idle as tasks that have already been submitted retain the
+// priority they were scheduled with.
+void iree_task_scope_set_priority(iree_task_scope_t* scope,
+                                  iree_task_scope_priority_t priority);
+
+// Queries the statistics aggregated from all dispatches that have retired
+// within the scope without resetting them. Lock-free; as with
+// iree_task_scope_consume_statistics the values may tear if this is performed
+// while tasks are in-flight.
+void iree_task_scope_query_statistics(
+    iree_task_scope_t* scope, iree_task_dispatch_statistics_t* out_statistics);
+
 // Returns and resets the statistics for the scope.
 // Statistics may experience tearing (non-atomic update across fields) if this
 // is performed while tasks are in-flight.
 iree_task_dispatch_statistics_t iree_task_scope_consume_statistics(
     iree_task_scope_t* scope);
 
+// Returns the absolute deadline of the scope or IREE_TIME_INFINITE_FUTURE if
+// the scope has no deadline.
+iree_time_t iree_task_scope_deadline(iree_task_scope_t* scope);
+
+// Sets an absolute deadline after which the scope will be aborted with
+// IREE_STATUS_DEADLINE_EXCEEDED. Pass IREE_TIME_INFINITE_FUTURE to clear the
+// deadline. Deadlines are checked cooperatively by the executor when scheduling
+// tasks, between tile reservations in dispatches, and when waiting; tasks that
+// have already begun executing are not interrupted.
+void iree_task_scope_set_deadline(iree_task_scope_t* scope,
+                                  iree_time_t deadline_ns);
+
+// Returns a process-wide counter that changes whenever any scope fails or has
+// its deadline changed. Allows the executor to skip rechecking the scopes of
+// long-lived waiting tasks when nothing could have changed.
+int32_t iree_task_scope_change_epoch(void);
+
 // Returns true if the scope has failed.
+// If the scope deadline has elapsed then the scope is first failed with
+// IREE_STATUS_DEADLINE_EXCEEDED.
 // iree_task_scope_consume_status can be used once to get the full status
 // describing the failure and subsequent calls will return the status code.
 bool iree_task_scope_has_failed(iree_task_scope_t* scope);
@@ -115,10 +182,13 @@ iree_status_t iree_task_scope_consume_status(iree_task_scope_t* scope);
 
 // Marks the scope as having been aborted by the user with IREE_STATUS_ABORTED.
 // All pending tasks will be dropped though in-flight tasks may complete
-// execution. Callers must use iree_task_scope_wait_idle to ensure the scope
-// state synchronizes prior to deinitializing. If the scope has already been
-// aborted or failed with a permanent error then the operation is ignored and
-// the previous error status is preserved.
+// execution. Dispatches stop reserving new tiles and will finish after their
+// current tiles complete. Waiting tasks are dropped the next time the executor
+// coordinates; callers can use iree_task_executor_flush to do so immediately.
+// Callers must use iree_task_scope_wait_idle to ensure the scope state
+// synchronizes prior to deinitializing. If the scope has already been aborted
+// or failed with a permanent error then the operation is ignored and the
+// previous error status is preserved.
 void iree_task_scope_abort(iree_task_scope_t* scope);
 
 // Marks the scope as having encountered an error while processing |task|.
@@ -33,6 +33,17 @@ TEST(ScopeTest, LongNameTruncation) {
   iree_task_scope_deinitialize(&scope);
 }
 
+TEST(ScopeTest, Priority) {
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope_a"), &scope);
+  EXPECT_EQ(IREE_TASK_SCOPE_PRIORITY_NORMAL, iree_task_scope_priority(&scope));
+  iree_task_scope_set_priority(&scope, IREE_TASK_SCOPE_PRIORITY_HIGH);
+  EXPECT_EQ(IREE_TASK_SCOPE_PRIORITY_HIGH, iree_task_scope_priority(&scope));
+  iree_task_scope_set_priority(&scope, IREE_TASK_SCOPE_PRIORITY_LOW);
+  EXPECT_EQ(IREE_TASK_SCOPE_PRIORITY_LOW, iree_task_scope_priority(&scope));
+  iree_task_scope_deinitialize(&scope);
+}
+
 TEST(ScopeTest, AbortEmpty) {
   iree_task_scope_t scope;
   iree_task_scope_initialize(iree_make_cstring_view("scope_a"), &scope);
@@ -53,6 +64,29 @@ TEST(ScopeTest, AbortEmpty) {
   iree_task_scope_deinitialize(&scope);
 }
 
+TEST(ScopeTest, Deadline) {
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope_a"), &scope);
+  EXPECT_EQ(IREE_TIME_INFINITE_FUTURE, iree_task_scope_deadline(&scope));
+
+  // Deadlines in the future don't fail the scope.
+  iree_task_scope_set_deadline(&scope, iree_time_now() + 60000000000ll);
+  EXPECT_FALSE(iree_task_scope_has_failed(&scope));
+
+  // Once the deadline has passed the scope fails the next time it is checked.
+  iree_task_scope_set_deadline(&scope, iree_time_now() - 1);
+  EXPECT_TRUE(iree_task_scope_has_failed(&scope));
+  iree_status_t consumed_status = iree_task_scope_consume_status(&scope);
+  EXPECT_TRUE(iree_status_is_deadline_exceeded(consumed_status));
+  iree_status_ignore(consumed_status);
+
+  // Clearing the deadline does not clear the failure.
+  iree_task_scope_set_deadline(&scope, IREE_TIME_INFINITE_FUTURE);
+  EXPECT_TRUE(iree_task_scope_has_failed(&scope));
+
+  iree_task_scope_deinitialize(&scope);
+}
+
 TEST(ScopeTest, FailEmpty) {
   iree_task_scope_t scope;
   iree_task_scope_initialize(iree_make_cstring_view("scope_a"), &scope);
@@ -461,9 +461,29 @@ static uint32_t iree_task_tile_to_color(
 #endif  // IREE_TASK_TRACING_PER_TILE_COLORS
 
 void iree_task_dispatch_statistics_merge(
-    const iree_task_dispatch_statistics_t* source,
+    iree_task_dispatch_statistics_t* source,
     iree_task_dispatch_statistics_t* target) {
-  // TODO(benvanik): statistics.
+#if IREE_STATISTICS_ENABLE
+  iree_atomic_fetch_add_int64(
+      &target->dispatch_count,
+      iree_atomic_load_int64(&source->dispatch_count,
+                             iree_memory_order_relaxed),
+      iree_memory_order_relaxed);
+  iree_atomic_fetch_add_int64(
+      &target->tile_count,
+      iree_atomic_load_int64(&source->tile_count, iree_memory_order_relaxed),
+      iree_memory_order_relaxed);
+  iree_atomic_fetch_add_int64(
+      &target->reservation_count,
+      iree_atomic_load_int64(&source->reservation_count,
+                             iree_memory_order_relaxed),
+      iree_memory_order_relaxed);
+  iree_atomic_fetch_add_int64(
+      &target->preemption_count,
+      iree_atomic_load_int64(&source->preemption_count,
+                             iree_memory_order_relaxed),
+      iree_memory_order_relaxed);
+#endif  // IREE_STATISTICS_ENABLE
 }
 
 //==============================================================================
@@ -523,9 +543,8 @@ void iree_task_dispatch_issue(iree_task_dispatch_t* dispatch_task,
     // By the task being ready to execute we know any dependencies on the
     // indirection buffer have been satisfied and its safe to read. We perform
     // the indirection here and convert the dispatch to a direct one such that
-    // following code can read the value.
-    // TODO(benvanik): non-one-shot command buffers won't be able to do this as
-    // the intent is that they can be dynamic per execution.
+    // following code can read the value. Reusable command buffers issue a copy
+    // of the dispatch each execution so the indirection is performed each time.
     const uint32_t* source_ptr = dispatch_task->workgroup_count.ptr;
     memcpy(dispatch_task->workgroup_count.value, source_ptr,
            sizeof(dispatch_task->workgroup_count.value));
@@ -553,17 +572,12 @@ void iree_task_dispatch_issue(iree_task_dispatch_t* dispatch_task,
   iree_host_size_t shard_count =
       iree_min(dispatch_task->tile_count, worker_count);
 
-  // Compute how many tiles we want each shard to reserve at a time from the
-  // larger grid. A higher number reduces overhead and improves locality while
-  // a lower number reduces maximum worst-case latency (coarser work stealing).
-  if (dispatch_task->tile_count <
-      worker_count * IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION) {
-    // Grid is small - allow it to be eagerly sliced up.
-    dispatch_task->tiles_per_reservation = 1;
-  } else {
-    dispatch_task->tiles_per_reservation =
-        IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION;
-  }
+  // Shards size their tile reservations from the shard count and the tile
+  // duration they measure as they execute; see
+  // iree_task_dispatch_reservation_size.
+  dispatch_task->shard_count = (uint32_t)shard_count;
+  iree_atomic_store_int32(&dispatch_task->tile_duration_ns, 0,
+                          iree_memory_order_relaxed);
 
   // Randomize starting worker.
   iree_host_size_t worker_offset = iree_task_post_batch_select_worker(
@@ -600,7 +614,13 @@ void iree_task_dispatch_retire(iree_task_dispatch_t* dispatch_task,
   IREE_TRACE_ZONE_BEGIN(z0);
   IREE_TRACE_ZONE_APPEND_VALUE(z0, dispatch_task->dispatch_id);
 
-  // TODO(benvanik): attach statistics to the tracy zone.
+#if IREE_STATISTICS_ENABLE
+  iree_atomic_store_int64(&dispatch_task->statistics.dispatch_count, 1,
+                          iree_memory_order_relaxed);
+  IREE_TRACE_ZONE_APPEND_VALUE(
+      z0, iree_atomic_load_int64(&dispatch_task->statistics.tile_count,
+                                 iree_memory_order_relaxed));
+#endif  // IREE_STATISTICS_ENABLE
 
   // Merge the statistics from the dispatch into the scope so we can track all
   // of the work without tracking all the dispatches at a global level.
@@ -654,8 +674,70 @@ iree_task_dispatch_shard_t* iree_task_dispatch_shard_allocate(
   return shard_task;
 }
 
-void iree_task_dispatch_shard_execute(
+// Returns the number of tiles a shard should claim in its next reservation from
+// the dispatch grid given that |tile_index| tiles are known to be reserved.
+//
+// Reservations follow guided self-scheduling: each claims a fraction of the
+// remaining tiles such that they start large (few touches of the shared tile
+// index and good locality) and shrink toward the tail of the grid (so that all
+// shards finish at about the same time). The size is then clamped based on the
+// measured tile duration such that reservations of cheap tiles are large enough
+// to amortize the reservation and reservations of expensive tiles don't hold up
+// preemption. Until a tile duration has been measured reservations are a single
+// tile.
+static uint32_t iree_task_dispatch_reservation_size(
+    iree_task_dispatch_t* dispatch_task, uint32_t tile_index) {
+  const uint32_t tile_duration_ns = (uint32_t)iree_atomic_load_int32(
+      &dispatch_task->tile_duration_ns, iree_memory_order_relaxed);
+  if (tile_duration_ns == 0 || tile_index >= dispatch_task->tile_count) {
+    return 1;
+  }
+  const uint32_t remaining_count = dispatch_task->tile_count - tile_index;
+  const uint32_t guided_size =
+      remaining_count / (dispatch_task->shard_count *
+                         IREE_TASK_DISPATCH_GUIDED_RESERVATION_DIVISOR);
+  const uint32_t min_size = iree_max(
+      1u, IREE_TASK_DISPATCH_MIN_RESERVATION_DURATION_NS / tile_duration_ns);
+  const uint32_t max_size = iree_max(
+      min_size,
+      IREE_TASK_DISPATCH_MAX_RESERVATION_DURATION_NS / tile_duration_ns);
+  return iree_min(iree_max(guided_size, min_size), max_size);
+}
+
+// Updates the estimated tile duration of |dispatch_task| with a measurement of
+// |tile_count| tiles executing in |duration_ns|. The estimate is a moving
+// average biased toward recent measurements and races between shards updating
+// it are benign.
+static void iree_task_dispatch_update_tile_duration(
+    iree_task_dispatch_t* dispatch_task, uint32_t tile_count,
+    iree_duration_t duration_ns) {
+  if (IREE_UNLIKELY(tile_count == 0 || duration_ns <= 0)) return;
+  int64_t sample_ns = iree_max(1, duration_ns / tile_count);
+  int64_t estimate_ns = iree_atomic_load_int32(&dispatch_task->tile_duration_ns,
+                                               iree_memory_order_relaxed);
+  estimate_ns = estimate_ns ? (estimate_ns * 3 + sample_ns) / 4 : sample_ns;
+  iree_atomic_store_int32(&dispatch_task->tile_duration_ns,
+                          (int32_t)iree_min(estimate_ns, INT32_MAX),
+                          iree_memory_order_relaxed);
+}
+
+// Pushes the statistics gathered by a shard up to its dispatch and the worker
+// that executed it, if any.
+static void iree_task_dispatch_shard_flush_statistics(
+    iree_task_dispatch_statistics_t* shard_statistics,
+    iree_task_dispatch_t* dispatch_task,
+    iree_task_dispatch_statistics_t* worker_statistics) {
+  iree_task_dispatch_statistics_merge(shard_statistics,
+                                      &dispatch_task->statistics);
+  if (worker_statistics) {
+    iree_task_dispatch_statistics_merge(shard_statistics, worker_statistics);
+  }
+}
+
+bool iree_task_dispatch_shard_execute(
     iree_task_dispatch_shard_t* task, iree_byte_span_t worker_local_memory,
+    iree_atomic_int32_t* preemption_mask,
+    iree_task_dispatch_statistics_t* worker_statistics,
     iree_task_submission_t* pending_submission) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
@@ -678,7 +760,7 @@ void iree_task_dispatch_shard_execute(
                          worker_local_memory.data_length));
     iree_task_retire(&task->header, pending_submission, iree_ok_status());
     IREE_TRACE_ZONE_END(z0);
-    return;
+    return true;
   }
   iree_byte_span_t local_memory = iree_make_byte_span(
       worker_local_memory.data, dispatch_task->local_memory_size);
@@ -699,27 +781,46 @@ void iree_task_dispatch_shard_execute(
   iree_task_dispatch_statistics_t shard_statistics;
   memset(&shard_statistics, 0, sizeof(shard_statistics));
   tile_context.statistics = &shard_statistics;
+  IREE_STATISTICS(int64_t shard_tile_count = 0);
+  IREE_STATISTICS(int64_t shard_reservation_count = 0);
+
+  // Any pending work with a priority higher than this will preempt the shard.
+  const int32_t preempting_priority_bits =
+      ~((1 << (iree_task_priority(&task->header) + 1)) - 1);
 
-  // Loop over all tiles until they are all processed.
+  // Loop over all tiles until they are all processed. Each reservation is
+  // sized from how many tiles we know have been reserved so far (by us or any
+  // other shard) and the tile duration measured so far.
+  //
+  // If the scope fails or is aborted we stop reserving tiles and bail after
+  // the current tile; the scope deadline (if any) is checked along with the
+  // preemption mask between reservations.
+  iree_task_scope_t* scope = dispatch_task->header.scope;
   const uint32_t tile_count = dispatch_task->tile_count;
-  const uint32_t tiles_per_reservation = dispatch_task->tiles_per_reservation;
-  uint32_t tile_base = iree_atomic_fetch_add_int32(&dispatch_task->tile_index,
-                                                   tiles_per_reservation,
-                                                   iree_memory_order_relaxed);
+  uint32_t reservation_size = iree_task_dispatch_reservation_size(
+      dispatch_task,
+      (uint32_t)iree_atomic_load_int32(&dispatch_task->tile_index,
+                                       iree_memory_order_relaxed));
+  uint32_t tile_base = (uint32_t)iree_atomic_fetch_add_int32(
+      &dispatch_task->tile_index, reservation_size, iree_memory_order_relaxed);
+  iree_time_t reservation_start_ns = iree_time_now();
+  if (IREE_UNLIKELY(iree_task_scope_has_failed(scope))) goto abort_shard;
   while (tile_base < tile_count) {
+    IREE_STATISTICS(++shard_reservation_count);
     const uint32_t tile_range =
-        iree_min(tile_base + tiles_per_reservation, tile_count);
+        iree_min(tile_base + reservation_size, tile_count);
+
+    // Compute the coordinates of the first tile in the reservation; the rest
+    // are stepped to incrementally as tiles in a reservation are sequential.
+    uint32_t tile_i = tile_base;
+    tile_context.workgroup_xyz[0] = tile_i % workgroup_count_x;
+    tile_i /= workgroup_count_x;
+    tile_context.workgroup_xyz[1] = tile_i % workgroup_count_y;
+    tile_i /= workgroup_count_y;
+    tile_context.workgroup_xyz[2] = tile_i;
+
     for (uint32_t tile_index = tile_base; tile_index < tile_range;
          ++tile_index) {
-      // TODO(benvanik): faster math here, especially knowing we pull off N
-      // sequential indices per reservation.
-      uint32_t tile_i = tile_index;
-      tile_context.workgroup_xyz[0] = tile_i % workgroup_count_x;
-      tile_i /= workgroup_count_x;
-      tile_context.workgroup_xyz[1] = tile_i % workgroup_count_y;
-      tile_i /= workgroup_count_y;
-      tile_context.workgroup_xyz[2] = tile_i;
-
       IREE_TRACE_ZONE_BEGIN_NAMED(z_tile,
                                   "iree_task_dispatch_shard_execute_tile");
       IREE_TRACE_ZONE_SET_COLOR(z_tile, iree_task_tile_to_color(&tile_context));
@@ -736,6 +837,7 @@ void iree_task_dispatch_shard_execute(
                                     &tile_context, pending_submission);
 
       IREE_TRACE_ZONE_END(z_tile);
+      IREE_STATISTICS(++shard_tile_count);
 
       // If any tile fails we bail early from the loop. This doesn't match
       // what an accelerator would do but saves some unneeded work.
@@ -748,23 +850,80 @@ void iree_task_dispatch_shard_execute(
         iree_task_try_set_status(&dispatch_task->status, status);
         goto abort_shard;  // out of the while-for nest
       }
+
+      // Stop as soon as the scope has failed so that cores can be used by
+      // other work. This is only a relaxed load of the status in the common
+      // case; deadlines are checked per-reservation below.
+      if (IREE_UNLIKELY(iree_atomic_load_intptr(&scope->permanent_status,
+                                                iree_memory_order_relaxed))) {
+        goto abort_shard;
+      }
+
+      // Step to the next tile in x, then y, then z order.
+      if (++tile_context.workgroup_xyz[0] == workgroup_count_x) {
+        tile_context.workgroup_xyz[0] = 0;
+        if (++tile_context.workgroup_xyz[1] == workgroup_count_y) {
+          tile_context.workgroup_xyz[1] = 0;
+          ++tile_context.workgroup_xyz[2];
+        }
+      }
+    }
+
+    // Feed the measured duration of the reservation back so that following
+    // reservations (from all shards) can be sized appropriately.
+    iree_time_t reservation_end_ns = iree_time_now();
+    iree_task_dispatch_update_tile_duration(
+        dispatch_task, tile_range - tile_base,
+        reservation_end_ns - reservation_start_ns);
+    reservation_start_ns = reservation_end_ns;
+    if (IREE_UNLIKELY(iree_task_scope_has_failed(scope))) goto abort_shard;
+
+    // Yield to higher priority work before taking any more tiles. The tiles
+    // remain in the grid for this or any other shard to reserve later.
+    if (preemption_mask &&
+        (iree_atomic_load_int32(preemption_mask, iree_memory_order_relaxed) &
+         preempting_priority_bits)) {
+#if IREE_STATISTICS_ENABLE
+      iree_atomic_store_int64(&shard_statistics.tile_count, shard_tile_count,
+                              iree_memory_order_relaxed);
+      iree_atomic_store_int64(&shard_statistics.reservation_count,
+                              shard_reservation_count,
+                              iree_memory_order_relaxed);
+      iree_atomic_store_int64(&shard_statistics.preemption_count, 1,
+                              iree_memory_order_relaxed);
+#endif  // IREE_STATISTICS_ENABLE
+      iree_task_dispatch_shard_flush_statistics(
+          &shard_statistics, dispatch_task, worker_statistics);
+      IREE_TRACE_ZONE_APPEND_TEXT(z0, "preempted");
+      IREE_TRACE_ZONE_END(z0);
+      return false;
     }
 
-    // Try to grab the next slice of tiles.
-    tile_base = iree_atomic_fetch_add_int32(&dispatch_task->tile_index,
-                                            tiles_per_reservation,
-                                            iree_memory_order_relaxed);
+    // Try to grab the next slice of tiles. All tiles up to the end of our last
+    // reservation have been reserved and we size the next from there.
+    reservation_size =
+        iree_task_dispatch_reservation_size(dispatch_task, tile_range);
+    tile_base = (uint32_t)iree_atomic_fetch_add_int32(
+        &dispatch_task->tile_index, reservation_size,
+        iree_memory_order_relaxed);
   }
 abort_shard:
 
   // Push aggregate statistics up to the dispatch.
   // Note that we may have partial information here if we errored out of the
   // loop but that's still useful to know.
-  iree_task_dispatch_statistics_merge(&shard_statistics,
-                                      &dispatch_task->statistics);
+#if IREE_STATISTICS_ENABLE
+  iree_atomic_store_int64(&shard_statistics.tile_count, shard_tile_count,
+                          iree_memory_order_relaxed);
+  iree_atomic_store_int64(&shard_statistics.reservation_count,
+                          shard_reservation_count, iree_memory_order_relaxed);
+#endif  // IREE_STATISTICS_ENABLE
+  iree_task_dispatch_shard_flush_statistics(&shard_statistics, dispatch_task,
+                                            worker_statistics);
 
   // NOTE: even if an error was hit we retire OK - the error has already been
   // propagated to the dispatch and it'll clean up after all shards are joined.
   iree_task_retire(&task->header, pending_submission, iree_ok_status());
   IREE_TRACE_ZONE_END(z0);
+  return true;
 }
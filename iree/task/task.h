@@ -404,17 +404,27 @@ void iree_task_wait_initialize(iree_task_scope_t* scope,
 // generic ones like 'l2 cache misses' or 'ipc') then we can sprinkle in some
 // #ifdefs.
 typedef struct iree_task_dispatch_statistics_t {
-  // TODO(benvanik): statistics counters.
   // NOTE: each of these increases the command buffer storage requirements; we
   // should always guard these with IREE_STATISTICS_ENABLE.
+#if IREE_STATISTICS_ENABLE
+  // Total number of dispatches that have retired.
+  iree_atomic_int64_t dispatch_count;
+  // Total number of tiles executed across all shards.
+  iree_atomic_int64_t tile_count;
+  // Total number of tile reservations made by shards from the dispatch grid.
+  iree_atomic_int64_t reservation_count;
+  // Total number of times a shard yielded to higher priority work.
+  iree_atomic_int64_t preemption_count;
+#else
   iree_atomic_int32_t reserved;
+#endif  // IREE_STATISTICS_ENABLE
 } iree_task_dispatch_statistics_t;
 
 // Merges statistics from |source| to |target| atomically per-field.
 // As each field is updated independently and in a relaxed memory order it's
 // possible for statistics consumers to see a tear.
 void iree_task_dispatch_statistics_merge(
-    const iree_task_dispatch_statistics_t* source,
+    iree_task_dispatch_statistics_t* source,
     iree_task_dispatch_statistics_t* target);
 
 typedef struct iree_task_tile_storage_t {
@@ -549,10 +559,14 @@ typedef iree_alignas(iree_max_align_t) struct iree_task_dispatch_t {
   // The total number of tiles in the dispatch bounding tile_index.
   uint32_t tile_count;
 
-  // Maximum number of tiles to fetch per tile reservation from the grid.
-  // Bounded by IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION and a
-  // reasonable number chosen based on the tile and shard counts.
-  uint32_t tiles_per_reservation;
+  // The number of shards the dispatch was issued across. Used to size the
+  // tile reservations made by each shard.
+  uint32_t shard_count;
+
+  // Estimated duration of a single tile in nanoseconds as measured by shards
+  // while executing the dispatch or 0 if no tiles have completed yet. Updated
+  // racily by all shards as it is only used to size tile reservations.
+  iree_atomic_int32_t tile_duration_ns;
 
   // The tail tile index; the next reservation will start from here.
   // This is used by shards to slice off the work to perform in their inner
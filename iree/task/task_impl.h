@@ -7,9 +7,11 @@
 #ifndef IREE_TASK_TASK_IMPL_H_
 #define IREE_TASK_TASK_IMPL_H_
 
+#include "iree/base/internal/atomics.h"
 #include "iree/task/list.h"
 #include "iree/task/pool.h"
 #include "iree/task/post_batch.h"
+#include "iree/task/scope.h"
 #include "iree/task/submission.h"
 #include "iree/task/task.h"
 
@@ -17,6 +19,12 @@
 extern "C" {
 #endif
 
+// Returns the scheduling priority of |task| as defined by its scope.
+static inline iree_task_scope_priority_t iree_task_priority(
+    const iree_task_t* task) {
+  return task->scope->priority;
+}
+
 //==============================================================================
 // IREE_TASK_TYPE_NOP
 //==============================================================================
@@ -113,10 +121,22 @@ iree_task_dispatch_shard_t* iree_task_dispatch_shard_allocate(
 // |worker_local_memory| is a block of memory exclusively available to the shard
 // during execution. Contents are undefined both before and after execution.
 //
+// |preemption_mask| is an optional bitmask of iree_task_scope_priority_t bits
+// indicating which priorities of work are waiting on the executing worker. It
+// is checked between tile reservations and if any work of a higher priority
+// than the dispatch is waiting the shard yields without retiring and returns
+// false. The caller must requeue the shard in order for it to continue
+// processing the remaining tiles at a later time.
+//
+// |worker_statistics| is an optional set of statistics that the shard
+// statistics will be merged into in addition to those of the parent dispatch.
+//
 // Errors are propagated to the parent scope and the dispatch will fail once
 // all shards have completed.
-void iree_task_dispatch_shard_execute(
+bool iree_task_dispatch_shard_execute(
     iree_task_dispatch_shard_t* task, iree_byte_span_t worker_local_memory,
+    iree_atomic_int32_t* preemption_mask,
+    iree_task_dispatch_statistics_t* worker_statistics,
     iree_task_submission_t* pending_submission);
 
 #ifdef __cplusplus
@@ -108,6 +108,14 @@ TEST_F(TaskDispatchTest, Issue345) {
   DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount, IREE_TASK_FLAG_NONE);
 }
 
+// Enough tiles that reservations grow to span multiple rows and slices of the
+// grid.
+TEST_F(TaskDispatchTest, IssueLarge) {
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {61, 37, 11};
+  DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount, IREE_TASK_FLAG_NONE);
+}
+
 TEST_F(TaskDispatchTest, IssueIndirect) {
   static const uint32_t kWorkgroupSize[3] = {1, 1, 1};
   static const uint32_t kWorkgroupCount[3] = {3, 4, 5};
@@ -162,6 +170,64 @@ TEST_F(TaskDispatchTest, IssueFailure) {
               StatusIs(StatusCode::kDataLoss));
 }
 
+// Aborting the scope from within a tile should stop all shards from reserving
+// any more tiles.
+TEST_F(TaskDispatchTest, IssueAbort) {
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {64 * 1024, 1, 1};
+
+  struct TileState {
+    iree_task_scope_t* scope;
+    iree_atomic_int32_t tile_count;
+  } state = {&scope_, IREE_ATOMIC_VAR_INIT(0)};
+  auto tile = [](void* user_context,
+                 const iree_task_tile_context_t* tile_context,
+                 iree_task_submission_t* pending_submission) -> iree_status_t {
+    TileState* state = (TileState*)user_context;
+    if (iree_atomic_fetch_add_int32(&state->tile_count, 1,
+                                    iree_memory_order_relaxed) == 32) {
+      iree_task_scope_abort(state->scope);
+    }
+    return iree_ok_status();
+  };
+
+  iree_task_dispatch_t task;
+  iree_task_dispatch_initialize(&scope_,
+                                iree_task_make_dispatch_closure(tile, &state),
+                                kWorkgroupSize, kWorkgroupCount, &task);
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  EXPECT_LT(
+      iree_atomic_load_int32(&state.tile_count, iree_memory_order_relaxed),
+      (int32_t)kWorkgroupCount[0]);
+  EXPECT_THAT(Status(iree_task_scope_consume_status(&scope_)),
+              StatusIs(StatusCode::kAborted));
+}
+
+// Dispatches in a scope past its deadline should not run any tiles.
+TEST_F(TaskDispatchTest, IssueDeadlineExceeded) {
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {64, 1, 1};
+
+  auto tile = [](void* user_context,
+                 const iree_task_tile_context_t* tile_context,
+                 iree_task_submission_t* pending_submission) -> iree_status_t {
+    iree_atomic_fetch_add_int32((iree_atomic_int32_t*)user_context, 1,
+                                iree_memory_order_relaxed);
+    return iree_ok_status();
+  };
+
+  iree_atomic_int32_t tile_count = IREE_ATOMIC_VAR_INIT(0);
+  iree_task_scope_set_deadline(&scope_, iree_time_now() - 1);
+  iree_task_dispatch_t task;
+  iree_task_dispatch_initialize(
+      &scope_, iree_task_make_dispatch_closure(tile, &tile_count),
+      kWorkgroupSize, kWorkgroupCount, &task);
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  EXPECT_EQ(0, iree_atomic_load_int32(&tile_count, iree_memory_order_relaxed));
+  EXPECT_THAT(Status(iree_task_scope_consume_status(&scope_)),
+              StatusIs(StatusCode::kDeadlineExceeded));
+}
+
 TEST_F(TaskDispatchTest, IssueFailureChained) {
   const uint32_t kWorkgroupSize[3] = {1, 1, 1};
   const uint32_t kWorkgroupCount[3] = {64, 1, 1};
@@ -7,6 +7,8 @@
 #include <atomic>
 #include <chrono>
 #include <thread>
+#include <utility>
+#include <vector>
 
 #include "iree/task/task.h"
 #include "iree/task/testing/task_test.h"
@@ -15,6 +17,10 @@
 
 namespace {
 
+using iree::Status;
+using iree::StatusCode;
+using iree::testing::status::StatusIs;
+
 class TaskWaitTest : public TaskTest {};
 
 TEST_F(TaskWaitTest, DISABLED_IssueSignaled) {
@@ -53,6 +59,80 @@ TEST_F(TaskWaitTest, DISABLED_IssueUnsignaled) {
   iree_event_deinitialize(&event);
 }
 
+// Aborting a scope should discard its waiting tasks even if their wait handles
+// are never signaled.
+TEST_F(TaskWaitTest, AbortUnsignaled) {
+  iree_event_t event;
+  iree_event_initialize(/*initial_state=*/false, &event);
+
+  iree_task_wait_t task;
+  iree_task_wait_initialize(&scope_, event, &task);
+
+  // Spin up a thread that will abort the scope after we start waiting.
+  std::thread abort_thread([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    iree_task_scope_abort(&scope_);
+    iree_task_executor_flush(executor_);
+  });
+
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  EXPECT_THAT(Status(iree_task_scope_consume_status(&scope_)),
+              StatusIs(StatusCode::kAborted));
+
+  abort_thread.join();
+  iree_event_deinitialize(&event);
+}
+
+// Waiting tasks should be discarded when their scope deadline elapses.
+TEST_F(TaskWaitTest, DeadlineUnsignaled) {
+  iree_event_t event;
+  iree_event_initialize(/*initial_state=*/false, &event);
+
+  iree_task_wait_t task;
+  iree_task_wait_initialize(&scope_, event, &task);
+
+  iree_task_scope_set_deadline(&scope_, iree_time_now() + 50000000ll);
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  EXPECT_THAT(Status(iree_task_scope_consume_status(&scope_)),
+              StatusIs(StatusCode::kDeadlineExceeded));
+
+  iree_event_deinitialize(&event);
+}
+
+// Many concurrent root waits (more than fit in a poll-based wait set) should
+// all be waited on and resolve. Bounded wait sets will fail the scope instead.
+TEST_F(TaskWaitTest, ManyOutstanding) {
+  static constexpr int kWaitCount = 256;
+  std::vector<iree_event_t> events(kWaitCount);
+  std::vector<iree_task_wait_t> wait_tasks(kWaitCount);
+  iree_task_nop_t join_task;
+  iree_task_nop_initialize(&scope_, &join_task);
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  for (int i = 0; i < kWaitCount; ++i) {
+    iree_event_initialize(/*initial_state=*/false, &events[i]);
+    iree_task_wait_initialize(&scope_, events[i], &wait_tasks[i]);
+    iree_task_set_completion_task(&wait_tasks[i].header, &join_task.header);
+    iree_task_submission_enqueue(&submission, &wait_tasks[i].header);
+  }
+
+  // Spin up a thread that will signal the events after we start waiting.
+  std::thread signal_thread([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    for (int i = kWaitCount - 1; i >= 0; --i) iree_event_set(&events[i]);
+  });
+
+  IREE_ASSERT_OK(SubmitAndWaitIdle(&submission, &join_task.header));
+  iree_status_t status = iree_task_scope_consume_status(&scope_);
+  if (!iree_status_is_ok(status)) {
+    EXPECT_THAT(Status(std::move(status)),
+                StatusIs(StatusCode::kResourceExhausted));
+  }
+
+  signal_thread.join();
+  for (int i = 0; i < kWaitCount; ++i) iree_event_deinitialize(&events[i]);
+}
+
 // TODO(benvanik): multi-waits: join wait a/b/c to task d.
 // TODO(benvanik): multi-waits: co-issue wait a/b/c to task d/e/f.
 
@@ -19,6 +19,7 @@ void iree_task_topology_group_initialize(
   out_group->group_index = group_index;
   snprintf(out_group->name, IREE_ARRAYSIZE(out_group->name), "worker[%u]",
            group_index);
+  out_group->numa_node = IREE_TASK_TOPOLOGY_NUMA_NODE_ANY;
   iree_thread_affinity_set_any(&out_group->ideal_thread_affinity);
   out_group->constructive_sharing_mask = IREE_TASK_TOPOLOGY_GROUP_MASK_ALL;
 }
@@ -65,6 +66,43 @@ const iree_task_topology_group_t* iree_task_topology_get_group(
   return &topology->groups[group_index];
 }
 
+iree_task_topology_group_mask_t iree_task_topology_group_mask_for_numa_node(
+    const iree_task_topology_t* topology, uint32_t numa_node) {
+  iree_task_topology_group_mask_t mask = 0;
+  for (iree_host_size_t i = 0; i < topology->group_count; ++i) {
+    const iree_task_topology_group_t* group = &topology->groups[i];
+    if (numa_node == IREE_TASK_TOPOLOGY_NUMA_NODE_ANY ||
+        group->numa_node == IREE_TASK_TOPOLOGY_NUMA_NODE_ANY ||
+        group->numa_node == numa_node) {
+      mask |= 1ull << i;
+    }
+  }
+  return mask;
+}
+
+uint32_t iree_task_topology_numa_node(const iree_task_topology_t* topology) {
+  if (topology->group_count == 0) return IREE_TASK_TOPOLOGY_NUMA_NODE_ANY;
+  uint32_t numa_node = topology->groups[0].numa_node;
+  for (iree_host_size_t i = 1; i < topology->group_count; ++i) {
+    if (topology->groups[i].numa_node != numa_node) {
+      return IREE_TASK_TOPOLOGY_NUMA_NODE_ANY;
+    }
+  }
+  return numa_node;
+}
+
+iree_host_size_t iree_task_topology_cache_size(
+    const iree_task_topology_t* topology) {
+  iree_host_size_t cache_size = 0;
+  for (iree_host_size_t i = 0; i < topology->group_count; ++i) {
+    iree_host_size_t group_cache_size = topology->groups[i].cache_size;
+    if (group_cache_size == 0) continue;
+    cache_size =
+        cache_size ? iree_min(cache_size, group_cache_size) : group_cache_size;
+  }
+  return cache_size;
+}
+
 iree_status_t iree_task_topology_push_group(
     iree_task_topology_t* topology, const iree_task_topology_group_t* group) {
   if (topology->group_count + 1 > IREE_ARRAYSIZE(topology->groups)) {
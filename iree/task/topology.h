@@ -27,6 +27,10 @@ typedef uint64_t iree_task_topology_group_mask_t;
 #define IREE_TASK_TOPOLOGY_GROUP_BIT_COUNT \
   (sizeof(iree_task_topology_group_mask_t) * 8)
 
+// Indicates a group is not attached to any particular NUMA node, such as when
+// its threads may float across all processors in the system.
+#define IREE_TASK_TOPOLOGY_NUMA_NODE_ANY UINT32_MAX
+
 // Information about a particular group within the topology.
 // Groups may be of varying levels of granularity even within the same topology
 // based on how the topology is defined.
@@ -41,6 +45,17 @@ typedef struct iree_task_topology_group_t {
   // Processor index in the cpuinfo set.
   uint32_t processor_index;
 
+  // NUMA node the processor is attached to or IREE_TASK_TOPOLOGY_NUMA_NODE_ANY
+  // if unknown/unpinned. Workers will (by default) only steal work from other
+  // workers on the same node as crossing the interconnect to touch another
+  // node's memory usually costs more than the imbalance does.
+  uint32_t numa_node;
+
+  // Size in bytes of the largest cache private to the group (usually L2) or 0
+  // if unknown. Used to size work such as buffer transfer tiles so that the
+  // data touched by each tile stays in cache.
+  uint32_t cache_size;
+
   // Ideal thread affinity for threads within this group.
   // All threads within the group share the same affinity and this is what
   // allows us to model Simultaneous Multi-Threading (SMT) (aka hyperthreading).
@@ -108,6 +123,22 @@ iree_host_size_t iree_task_topology_group_count(
 const iree_task_topology_group_t* iree_task_topology_get_group(
     const iree_task_topology_t* topology, iree_host_size_t group_index);
 
+// Returns a mask of all groups in |topology| that are attached to |numa_node|.
+// Groups with an unknown node are included in all masks and passing
+// IREE_TASK_TOPOLOGY_NUMA_NODE_ANY returns all groups.
+iree_task_topology_group_mask_t iree_task_topology_group_mask_for_numa_node(
+    const iree_task_topology_t* topology, uint32_t numa_node);
+
+// Returns the NUMA node shared by all groups in |topology| or
+// IREE_TASK_TOPOLOGY_NUMA_NODE_ANY if the groups span multiple nodes (or any
+// is unpinned).
+uint32_t iree_task_topology_numa_node(const iree_task_topology_t* topology);
+
+// Returns the smallest known cache size of all groups in |topology| or 0 if
+// none is known.
+iree_host_size_t iree_task_topology_cache_size(
+    const iree_task_topology_t* topology);
+
 // Pushes a new group onto the topology set.
 // The provided group data will be copied into the topology structure.
 iree_status_t iree_task_topology_push_group(
@@ -11,6 +11,7 @@
 
 #include "iree/base/api.h"
 #include "iree/base/internal/math.h"
+#include "iree/base/internal/numa.h"
 #include "iree/base/target_platform.h"
 #include "iree/base/tracing.h"
 
@@ -95,6 +96,18 @@ static void iree_task_topology_set_affinity_from_processor(
 #endif  // cpuinfo-like platform field
 }
 
+// Returns the NUMA node |processor| is attached to.
+static uint32_t iree_task_topology_numa_node_from_processor(
+    const struct cpuinfo_processor* processor) {
+  // cpuinfo doesn't track NUMA nodes so we look them up ourselves; this is
+  // only supported on Linux today and everything else reports a single node.
+#if defined(__linux__)
+  return iree_numa_node_for_processor(processor->linux_id);
+#else
+  return 0;
+#endif  // __linux__
+}
+
 // Returns a bitset with all *processors* that share the same |cache|.
 static uint64_t iree_task_topology_calculate_cache_bits(
     const struct cpuinfo_cache* cache) {
@@ -140,6 +153,12 @@ static void iree_task_topology_group_initialize_from_core(
       cpuinfo_get_processor(processor_i);
   iree_task_topology_set_affinity_from_processor(
       processor, &out_group->ideal_thread_affinity);
+  out_group->numa_node = iree_task_topology_numa_node_from_processor(processor);
+  if (processor->cache.l2) {
+    out_group->cache_size = processor->cache.l2->size;
+  } else if (processor->cache.l1d) {
+    out_group->cache_size = processor->cache.l1d->size;
+  }
 }
 
 // Fixes constructive_sharing_mask values such that they represent other chosen
@@ -259,6 +278,27 @@ void iree_task_topology_initialize_from_physical_cores_with_filter(
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Matches only cores attached to the NUMA node specified in |user_data|.
+static bool iree_task_topology_core_filter_numa_node(
+    const struct cpuinfo_core* core, uintptr_t user_data) {
+  return iree_task_topology_numa_node_from_processor(
+             cpuinfo_get_processor(core->processor_start)) == user_data;
+}
+
+void iree_task_topology_initialize_from_numa_node(
+    uint32_t numa_node, iree_host_size_t max_core_count,
+    iree_task_topology_t* out_topology) {
+  iree_task_topology_initialize_from_physical_cores_with_filter(
+      iree_task_topology_core_filter_numa_node, numa_node, max_core_count,
+      out_topology);
+  if (out_topology->group_count == 0) {
+    // Memory-only nodes have no cores; an empty topology would create a
+    // threadless executor so instead we use whatever cores are available.
+    iree_task_topology_initialize_from_physical_cores(max_core_count,
+                                                      out_topology);
+  }
+}
+
 void iree_task_topology_initialize_from_unique_l2_cache_groups(
     iree_host_size_t max_group_count, iree_task_topology_t* out_topology) {
   if (!iree_task_topology_is_cpuinfo_available() ||
@@ -48,6 +48,18 @@ void iree_task_topology_initialize_from_physical_cores_with_filter(
     iree_task_topology_core_filter_t filter_fn, uintptr_t filter_fn_data,
     iree_host_size_t max_core_count, iree_task_topology_t* out_topology);
 
+// Initializes a topology with one group for each physical core attached to
+// |numa_node|. Pair with an executor per node (see iree_numa_node_count) to
+// keep work and the memory it touches on the same node.
+//
+// If cpuinfo is not available this falls back to the same behavior as
+// iree_task_topology_initialize_from_physical_cores. If NUMA information is not
+// available then all cores are considered to be on node 0 and if the node has
+// no cores (such as memory-only nodes) all physical cores are used.
+void iree_task_topology_initialize_from_numa_node(
+    uint32_t numa_node, iree_host_size_t max_core_count,
+    iree_task_topology_t* out_topology);
+
 // Initializes a topology with one group for each unique L2 cache group across
 // all available cores. This optimizes for temporal and spatial cache locality
 // but may suffer from oversubscription if there are other processes trying to
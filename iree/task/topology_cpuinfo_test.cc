@@ -41,4 +41,13 @@ TEST(TopologyTest, FromPhysicalCores) {
   iree_task_topology_deinitialize(&topology);
 }
 
+TEST(TopologyTest, FromNUMANode) {
+  static constexpr iree_host_size_t kMaxGroupCount = 4;
+  iree_task_topology_t topology;
+  iree_task_topology_initialize(&topology);
+  iree_task_topology_initialize_from_numa_node(0, kMaxGroupCount, &topology);
+  EnsureTopologyValid(kMaxGroupCount, &topology);
+  iree_task_topology_deinitialize(&topology);
+}
+
 }  // namespace
@@ -117,4 +117,68 @@ TEST(TopologyTest, FromGroupCount) {
   iree_task_topology_deinitialize(&topology);
 }
 
+TEST(TopologyTest, NUMANodeMask) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize(&topology);
+  EXPECT_EQ(IREE_TASK_TOPOLOGY_NUMA_NODE_ANY,
+            iree_task_topology_numa_node(&topology));
+
+  // Groups 0 and 1 on node 0, group 2 on node 1, and group 3 unpinned.
+  static const uint32_t kGroupNodes[4] = {0, 0, 1,
+                                          IREE_TASK_TOPOLOGY_NUMA_NODE_ANY};
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(kGroupNodes); ++i) {
+    iree_task_topology_group_t group;
+    iree_task_topology_group_initialize(i, &group);
+    EXPECT_EQ(IREE_TASK_TOPOLOGY_NUMA_NODE_ANY, group.numa_node);
+    group.numa_node = kGroupNodes[i];
+    IREE_EXPECT_OK(iree_task_topology_push_group(&topology, &group));
+  }
+
+  // Unpinned groups are included in every node.
+  EXPECT_EQ(0b1011u, iree_task_topology_group_mask_for_numa_node(&topology, 0));
+  EXPECT_EQ(0b1100u, iree_task_topology_group_mask_for_numa_node(&topology, 1));
+  EXPECT_EQ(0b1000u, iree_task_topology_group_mask_for_numa_node(&topology, 2));
+  EXPECT_EQ(0b1111u, iree_task_topology_group_mask_for_numa_node(
+                         &topology, IREE_TASK_TOPOLOGY_NUMA_NODE_ANY));
+
+  // Mixed nodes have no single node.
+  EXPECT_EQ(IREE_TASK_TOPOLOGY_NUMA_NODE_ANY,
+            iree_task_topology_numa_node(&topology));
+
+  iree_task_topology_deinitialize(&topology);
+}
+
+TEST(TopologyTest, NUMANodeUniform) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize(&topology);
+  for (iree_host_size_t i = 0; i < 4; ++i) {
+    iree_task_topology_group_t group;
+    iree_task_topology_group_initialize(i, &group);
+    group.numa_node = 3;
+    IREE_EXPECT_OK(iree_task_topology_push_group(&topology, &group));
+  }
+  EXPECT_EQ(3, iree_task_topology_numa_node(&topology));
+  EXPECT_EQ(0b1111u, iree_task_topology_group_mask_for_numa_node(&topology, 3));
+  iree_task_topology_deinitialize(&topology);
+}
+
+TEST(TopologyTest, CacheSize) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize(&topology);
+  EXPECT_EQ(0, iree_task_topology_cache_size(&topology));
+
+  // Groups with unknown cache sizes are ignored and the smallest known size is
+  // returned.
+  const uint32_t cache_sizes[3] = {0, 1024 * 1024, 512 * 1024};
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(cache_sizes); ++i) {
+    iree_task_topology_group_t group;
+    iree_task_topology_group_initialize(i, &group);
+    EXPECT_EQ(0, group.cache_size);
+    group.cache_size = cache_sizes[i];
+    IREE_EXPECT_OK(iree_task_topology_push_group(&topology, &group));
+  }
+  EXPECT_EQ(512 * 1024, iree_task_topology_cache_size(&topology));
+  iree_task_topology_deinitialize(&topology);
+}
+
 }  // namespace
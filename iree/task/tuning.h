@@ -23,23 +23,28 @@ extern "C" {
 // at the cost of a higher minimum memory consumption.
 #define IREE_TASK_EXECUTOR_INITIAL_SHARD_RESERVATION_PER_WORKER (4)
 
+// Granularity at which worker local memory grows on demand. Growth requests are
+// rounded up to this size so that a sequence of dispatches each requesting
+// slightly more local memory does not reallocate on every dispatch.
+#define IREE_TASK_WORKER_LOCAL_MEMORY_GROWTH_GRANULARITY (64 * 1024)
+
 // Maximum number of events retained by the executor event pool.
 #define IREE_TASK_EXECUTOR_EVENT_POOL_CAPACITY 64
 
-// Maximum number of simultaneous waits an executor may perform as part of a
-// wait-any operation. A larger value may enable better wake coalescing by the
-// kernel. This is only a count limiting wait tasks that have been scheduled and
-// been promoted to the root executor waiting list. There may be any number of
-// waits deeper in the pipeline so long as they don't all become ready
-// simultaneously.
+// Initial number of simultaneous waits an executor may perform as part of a
+// wait-any operation. This is only a count of wait tasks that have been
+// scheduled and been promoted to the root executor waiting list. There may be
+// any number of waits deeper in the pipeline so long as they don't all become
+// ready simultaneously.
 //
-// Realistically, though, if we have more than 64 outstanding **root** waits
-// it's hard to reason about if/when the executor queue could make forward
-// progress and indicates a possible error in task assignment.
+// On platforms using epoll the wait set grows as needed and this is only the
+// initial capacity; many concurrent sessions each waiting on their own
+// semaphore timepoints can have hundreds of outstanding root waits and waking
+// is proportional to the number of ready waits and not the total.
 //
-// Also, the underlying iree_wait_set_t may not support more than 64 handles on
-// certain platforms without emulation. Trying to keep us on the fast-path
-// with a reasonable number seems fine for now until we have a need for more.
+// Elsewhere the underlying iree_wait_set_t may not support more than 64
+// handles without emulation and this is the maximum; waits beyond it fail
+// their scope with RESOURCE_EXHAUSTED.
 //
 // NOTE: we reserve 1 wait handle for our own internal use. This allows us to
 // wake the coordination worker when new work is submitted from external
@@ -72,9 +77,60 @@ extern "C" {
 #define IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT \
   IREE_TASK_EXECUTOR_MAX_WORKER_COUNT
 
-// Number of tiles that will be batched into a single reservation from the grid.
-// This is a maximum; if there are fewer tiles that would otherwise allow for
-// maximum parallelism then this may be ignored.
+// Number of tasks that can be held in each worker's work-stealing deque.
+// Must be a power of two. Tasks beyond this count are held in an overflow list
+// private to the worker and are not visible to thieves until the deque drains.
+//
+// Each slot is a pointer and is stored inline in the worker so this directly
+// scales the executor memory consumption (256 * 8b * 64 workers = 128KB).
+// Workers only receive tasks in batches when they have run out of work and
+// batches are generally bounded by the number of concurrently issued
+// dispatches such that overflow should be exceedingly rare.
+#define IREE_TASK_DEQUE_CAPACITY (256)
+
+// Maximum number of consecutive tasks a worker will take from higher priority
+// lanes while lower priority tasks are waiting before giving the lowest lane a
+// turn. Dispatch shards run in such a turn yield after a single tile
+// reservation.
+//
+// Larger values give higher priority work more of the worker and lower
+// latency under load while smaller values bound how long low priority work
+// can be delayed. A value of 1 alternates between lanes.
+#define IREE_TASK_PRIORITY_STARVATION_LIMIT (16)
+
+// Number of tasks a worker with only low priority work executes between
+// attempts to steal higher priority work from other workers. Each attempt
+// scans the other workers and most workloads never mix priorities so this
+// bounds the overhead paid by all-low priority workloads.
+//
+// Smaller values reduce the latency of higher priority work posted to busy
+// workers while other workers are busy with low priority work.
+#define IREE_TASK_PRIORITY_LOW_STEAL_INTERVAL (32)
+
+// Minimum and maximum number of iterations an idle worker spins checking for
+// new work before parking its thread in the OS. Each worker adapts its spin
+// count within this range: spins that see work arrive double it and parks
+// halve it.
+//
+// Spinning avoids the syscalls and scheduler latency of parking and waking a
+// thread when work arrives in quick succession (such as a series of small
+// dispatches) at the cost of burning the core while waiting. Setting both to 0
+// disables spinning and workers always park immediately.
+#define IREE_TASK_WORKER_MIN_SPIN_COUNT (16)
+#define IREE_TASK_WORKER_MAX_SPIN_COUNT (1024)
+
+// Interval at which threads donated to a threadless executor (one created with
+// no workers) re-check for work while idle. Threadless executors have no
+// threads of their own to notice newly submitted tasks or resolved waits and
+// donors poll for them instead. Smaller values reduce the latency of picking
+// up work submitted from other threads at the cost of additional wakes.
+#define IREE_TASK_EXECUTOR_DONATION_POLL_INTERVAL_NS (100 * 1000)
+
+// Dispatch shards reserve tiles from the grid using guided self-scheduling:
+// each reservation claims 1/(shard_count * divisor) of the tiles remaining such
+// that reservations start large and shrink toward the tail of the grid. A
+// divisor of 1 is classic guided self-scheduling while larger values trade
+// additional reservations early on for better balance when tile costs vary.
 //
 // The more tiles reserved at a time the higher the chance for latency to
 // increase as many reserved tiles are held up on one worker while another may
@@ -83,8 +139,20 @@ extern "C" {
 // The fewer tiles reserved at a time the higher the chance for cache-locality
 // destroying behavior where multiple workers all stomp on the same cache lines
 // (as say worker 0 and worker 1 both fight over sequential tiles adjacent in
-// memory).
-#define IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION (8)
+// memory) and the more time is spent contending on the shared tile index.
+#define IREE_TASK_DISPATCH_GUIDED_RESERVATION_DIVISOR (2)
+
+// Minimum estimated duration of the tiles claimed by a single reservation.
+// Tile costs are measured as shards execute and reservations of cheap tiles
+// are grown such that the shared tile index is not touched more than once per
+// this duration per shard. This also bounds how finely the tail of the grid is
+// split across shards.
+#define IREE_TASK_DISPATCH_MIN_RESERVATION_DURATION_NS (10 * 1000)
+
+// Maximum estimated duration of the tiles claimed by a single reservation.
+// Shards only check for preemption between reservations and this bounds how
+// long higher priority work may wait on a shard of expensive tiles.
+#define IREE_TASK_DISPATCH_MAX_RESERVATION_DURATION_NS (1000 * 1000)
 
 // Whether to enable per-tile colors for each tile tracing zone based on the
 // tile grid xyz. Not cheap and can be disabled to reduce tracing overhead.
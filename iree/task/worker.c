@@ -11,6 +11,7 @@
 
 #include "iree/base/internal/fpu_state.h"
 #include "iree/base/internal/math.h"
+#include "iree/base/internal/numa.h"
 #include "iree/base/tracing.h"
 #include "iree/task/executor_impl.h"
 #include "iree/task/post_batch.h"
@@ -20,23 +21,49 @@
 
 static int iree_task_worker_main(iree_task_worker_t* worker);
 
-iree_status_t iree_task_worker_initialize(
-    iree_task_executor_t* executor, iree_host_size_t worker_index,
-    const iree_task_topology_group_t* topology_group,
-    iree_byte_span_t local_memory, iree_prng_splitmix64_state_t* seed_prng,
-    iree_task_worker_t* out_worker) {
-  IREE_TRACE_ZONE_BEGIN(z0);
-
+// Initializes the worker state shared by both threaded and donated workers.
+static void iree_task_worker_initialize_state(
+    iree_task_executor_t* executor, iree_task_affinity_set_t worker_bit,
+    iree_task_affinity_set_t constructive_sharing_mask,
+    iree_task_affinity_set_t theft_victim_mask, uint32_t max_theft_attempts,
+    iree_byte_span_t local_memory, uint32_t numa_node,
+    iree_prng_splitmix64_state_t* seed_prng,
+    iree_task_worker_state_t initial_state, iree_task_worker_t* out_worker) {
   out_worker->executor = executor;
-  out_worker->worker_bit = iree_task_affinity_for_worker(worker_index);
-  out_worker->ideal_thread_affinity = topology_group->ideal_thread_affinity;
-  out_worker->constructive_sharing_mask =
-      topology_group->constructive_sharing_mask;
-  out_worker->max_theft_attempts =
-      executor->worker_count / IREE_TASK_EXECUTOR_MAX_THEFT_ATTEMPTS_DIVISOR;
+  out_worker->worker_bit = worker_bit;
+  out_worker->constructive_sharing_mask = constructive_sharing_mask;
+  out_worker->theft_victim_mask = theft_victim_mask;
+  out_worker->max_theft_attempts = max_theft_attempts;
   iree_prng_minilcg128_initialize(iree_prng_splitmix64_next(seed_prng),
                                   &out_worker->theft_prng);
   out_worker->local_memory = local_memory;
+  out_worker->local_memory_reserved = local_memory;
+  out_worker->local_memory_allocator = iree_numa_allocator(numa_node);
+  iree_atomic_store_int32(&out_worker->local_memory_trim_requested, 0,
+                          iree_memory_order_relaxed);
+
+  iree_atomic_store_int32(&out_worker->state, initial_state,
+                          iree_memory_order_seq_cst);
+
+  iree_notification_initialize(&out_worker->state_notification);
+  iree_atomic_task_slist_initialize(&out_worker->mailbox_slist);
+  iree_atomic_store_int32(&out_worker->mailbox_priority_mask, 0,
+                          iree_memory_order_relaxed);
+  out_worker->starvation_count = 0;
+  out_worker->starvation_grant_bit = 0;
+  out_worker->low_steal_countdown = 0;
+  out_worker->idle_spin_count = IREE_TASK_WORKER_MIN_SPIN_COUNT;
+  for (int i = 0; i < IREE_TASK_SCOPE_PRIORITY_COUNT; ++i) {
+    iree_task_deque_initialize(&out_worker->local_task_deques[i]);
+  }
+}
+
+iree_status_t iree_task_worker_initialize(
+    iree_task_executor_t* executor, iree_host_size_t worker_index,
+    const iree_task_topology_group_t* topology_group,
+    iree_task_affinity_set_t theft_victim_mask, iree_byte_span_t local_memory,
+    iree_prng_splitmix64_state_t* seed_prng, iree_task_worker_t* out_worker) {
+  IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_task_worker_state_t initial_state = IREE_TASK_WORKER_STATE_RUNNING;
   if (executor->scheduling_mode &
@@ -47,13 +74,13 @@ iree_status_t iree_task_worker_initialize(
     // blocking startup time.
     initial_state = IREE_TASK_WORKER_STATE_SUSPENDED;
   }
-  iree_atomic_store_int32(&out_worker->state, initial_state,
-                          iree_memory_order_seq_cst);
-
-  iree_notification_initialize(&out_worker->wake_notification);
-  iree_notification_initialize(&out_worker->state_notification);
-  iree_atomic_task_slist_initialize(&out_worker->mailbox_slist);
-  iree_task_queue_initialize(&out_worker->local_task_queue);
+  iree_task_worker_initialize_state(
+      executor, iree_task_affinity_for_worker(worker_index),
+      topology_group->constructive_sharing_mask, theft_victim_mask,
+      executor->worker_count / IREE_TASK_EXECUTOR_MAX_THEFT_ATTEMPTS_DIVISOR,
+      local_memory, topology_group->numa_node, seed_prng, initial_state,
+      out_worker);
+  out_worker->ideal_thread_affinity = topology_group->ideal_thread_affinity;
 
   iree_thread_create_params_t thread_params;
   memset(&thread_params, 0, sizeof(thread_params));
@@ -74,6 +101,21 @@ iree_status_t iree_task_worker_initialize(
   return status;
 }
 
+void iree_task_worker_initialize_donated(
+    iree_task_executor_t* executor, iree_task_affinity_set_t worker_bit,
+    iree_task_affinity_set_t constructive_sharing_mask,
+    uint32_t max_theft_attempts, iree_byte_span_t local_memory,
+    iree_prng_splitmix64_state_t* seed_prng, iree_task_worker_t* out_worker) {
+  // There's no thread to suspend or resume and the worker is always considered
+  // running (when pumped by a donated thread, at least). Donated threads may be
+  // running on any NUMA node so we let them steal from any worker.
+  iree_task_worker_initialize_state(
+      executor, worker_bit, constructive_sharing_mask,
+      iree_task_affinity_for_any_worker(), max_theft_attempts, local_memory,
+      executor->numa_node, seed_prng, IREE_TASK_WORKER_STATE_RUNNING,
+      out_worker);
+}
+
 // Returns true if the worker is in the zombie state (exited and awaiting
 // teardown).
 static bool iree_task_worker_is_zombie(iree_task_worker_t* worker) {
@@ -81,6 +123,67 @@ static bool iree_task_worker_is_zombie(iree_task_worker_t* worker) {
          IREE_TASK_WORKER_STATE_ZOMBIE;
 }
 
+// Releases local memory grown beyond the initial reservation, if any.
+static void iree_task_worker_release_local_memory(iree_task_worker_t* worker) {
+  if (worker->local_memory.data != worker->local_memory_reserved.data) {
+    iree_allocator_free(worker->local_memory_allocator,
+                        worker->local_memory.data);
+  }
+  worker->local_memory = worker->local_memory_reserved;
+}
+
+bool iree_task_worker_ensure_local_memory(iree_task_worker_t* worker,
+                                          iree_host_size_t local_memory_size) {
+  if (IREE_LIKELY(local_memory_size <= worker->local_memory.data_length)) {
+    return true;
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Grow to the largest size reserved so far (as known from the executables
+  // being dispatched) so that we don't grow again on the next larger dispatch.
+  iree_host_size_t reserved_size =
+      (iree_host_size_t)iree_atomic_load_int64(
+          &worker->executor->worker_local_memory_reservation,
+          iree_memory_order_relaxed);
+  iree_host_size_t new_size =
+      iree_host_align(iree_max(local_memory_size, reserved_size),
+                      IREE_TASK_WORKER_LOCAL_MEMORY_GROWTH_GRANULARITY);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, new_size);
+
+  // Allocated on the worker thread so that first-touch placement (when the
+  // allocator does not bind pages itself) also keeps the memory local.
+  uint8_t* new_data = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      worker->local_memory_allocator, new_size, (void**)&new_data);
+  if (!iree_status_is_ok(status)) {
+    // The dispatch will fail with RESOURCE_EXHAUSTED on the existing memory.
+    iree_status_ignore(status);
+    IREE_TRACE_ZONE_END(z0);
+    return false;
+  }
+  iree_task_worker_release_local_memory(worker);
+  worker->local_memory = iree_make_byte_span(new_data, new_size);
+
+  IREE_TRACE_ZONE_END(z0);
+  return true;
+}
+
+void iree_task_worker_request_trim(iree_task_worker_t* worker) {
+  iree_atomic_store_int32(&worker->local_memory_trim_requested, 1,
+                          iree_memory_order_release);
+}
+
+void iree_task_worker_trim_if_requested(iree_task_worker_t* worker) {
+  if (IREE_LIKELY(!iree_atomic_load_int32(&worker->local_memory_trim_requested,
+                                          iree_memory_order_relaxed))) {
+    return;
+  }
+  if (iree_atomic_exchange_int32(&worker->local_memory_trim_requested, 0,
+                                 iree_memory_order_acquire)) {
+    iree_task_worker_release_local_memory(worker);
+  }
+}
+
 void iree_task_worker_deinitialize(iree_task_worker_t* worker) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
@@ -98,12 +201,14 @@ void iree_task_worker_deinitialize(iree_task_worker_t* worker) {
   // get anything more posted to it) and then discarding everything we still
   // have a reference to.
   iree_atomic_task_slist_discard(&worker->mailbox_slist);
-  iree_task_list_discard(&worker->local_task_queue.list);
 
-  iree_notification_deinitialize(&worker->wake_notification);
+  iree_task_worker_release_local_memory(worker);
+
   iree_notification_deinitialize(&worker->state_notification);
   iree_atomic_task_slist_deinitialize(&worker->mailbox_slist);
-  iree_task_queue_deinitialize(&worker->local_task_queue);
+  for (int i = 0; i < IREE_TASK_SCOPE_PRIORITY_COUNT; ++i) {
+    iree_task_deque_deinitialize(&worker->local_task_deques[i]);
+  }
 
   IREE_TRACE_ZONE_END(z0);
 }
@@ -134,36 +239,285 @@ void iree_task_worker_request_exit(iree_task_worker_t* worker) {
   }
 
   // Kick the worker in case it is waiting for work.
-  iree_notification_post(&worker->wake_notification, 1);
+  iree_notification_set_post(&worker->executor->worker_wake_notifications,
+                             worker->worker_bit);
 
   IREE_TRACE_ZONE_END(z0);
 }
 
 void iree_task_worker_post_tasks(iree_task_worker_t* worker,
                                  iree_task_list_t* list) {
+  // Gather the priorities being posted so that the worker can tell if it
+  // should stop what it's doing to get to them. Lists are generally only a few
+  // tasks long (one shard per dispatch per worker).
+  int32_t priority_mask = 0;
+  for (iree_task_t* task = list->head; task != NULL; task = task->next_task) {
+    priority_mask |= 1 << iree_task_priority(task);
+  }
+
   // Move the list into the mailbox. Note that the mailbox is LIFO and this list
   // is concatenated with its current order preserved (which should be LIFO).
   iree_atomic_task_slist_concat(&worker->mailbox_slist, list->head, list->tail);
   memset(list, 0, sizeof(*list));
+
+  // NOTE: this happens after the tasks are in the mailbox such that a worker
+  // observing the bits is guaranteed to find the tasks when it flushes.
+  iree_atomic_fetch_or_int32(&worker->mailbox_priority_mask, priority_mask,
+                             iree_memory_order_release);
+}
+
+// Pushes a FIFO |list| of tasks into the local lanes of the worker based on the
+// priority of each task. Relative order is preserved within each lane.
+static void iree_task_worker_push_fifo_list(iree_task_worker_t* worker,
+                                            iree_task_list_t* list) {
+  iree_task_list_t lane_lists[IREE_TASK_SCOPE_PRIORITY_COUNT];
+  for (int i = 0; i < IREE_TASK_SCOPE_PRIORITY_COUNT; ++i) {
+    iree_task_list_initialize(&lane_lists[i]);
+  }
+  iree_task_t* task = NULL;
+  while ((task = iree_task_list_pop_front(list))) {
+    iree_task_list_push_back(&lane_lists[iree_task_priority(task)], task);
+  }
+  for (int i = 0; i < IREE_TASK_SCOPE_PRIORITY_COUNT; ++i) {
+    iree_task_deque_push_fifo_list(&worker->local_task_deques[i],
+                                   &lane_lists[i]);
+  }
 }
 
-iree_task_t* iree_task_worker_try_steal_task(iree_task_worker_t* worker,
-                                             iree_task_queue_t* target_queue,
-                                             iree_host_size_t max_tasks) {
-  // Try to grab tasks from the worker; if more than one task is stolen then the
-  // first will be returned and the remaining will be added to the target queue.
-  iree_task_t* task = iree_task_queue_try_steal(
-      &worker->local_task_queue, target_queue,
-      /*max_tasks=*/IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT);
-  if (task) return task;
+void iree_task_worker_push_lifo_list(iree_task_worker_t* worker,
+                                     iree_task_list_t* list) {
+  if (iree_task_list_is_empty(list)) return;
+  iree_task_list_reverse(list);
+  iree_task_worker_push_fifo_list(worker, list);
+}
+
+bool iree_task_worker_has_local_tasks(iree_task_worker_t* worker) {
+  for (int i = 0; i < IREE_TASK_SCOPE_PRIORITY_COUNT; ++i) {
+    if (!iree_task_deque_is_empty(&worker->local_task_deques[i])) return true;
+  }
+  return false;
+}
 
-  // If we still didn't steal any tasks then let's try the slist instead.
-  task = iree_atomic_task_slist_pop(&worker->mailbox_slist);
-  if (task) return task;
+iree_task_t* iree_task_worker_try_steal_task(
+    iree_task_worker_t* worker, iree_task_scope_priority_t min_priority,
+    iree_task_deque_t* target_deques, iree_host_size_t max_tasks) {
+  // Try to grab tasks from the worker starting with its most important lane;
+  // if more than one task is stolen then the first will be returned and the
+  // remaining will be added to the matching target lane.
+  for (int i = IREE_TASK_SCOPE_PRIORITY_COUNT - 1; i >= (int)min_priority;
+       --i) {
+    iree_task_t* task = iree_task_deque_try_steal(
+        &worker->local_task_deques[i], &target_deques[i], max_tasks);
+    if (task) return task;
+  }
+
+  // If we still didn't steal any tasks then let's try the slist instead. We
+  // don't know the priority of what we'll get and so only do this if any will
+  // do.
+  if (min_priority == IREE_TASK_SCOPE_PRIORITY_LOW) {
+    iree_task_t* task = iree_atomic_task_slist_pop(&worker->mailbox_slist);
+    if (task) return task;
+  }
 
   return NULL;
 }
 
+// Flushes all tasks posted to the worker mailbox into its local lanes.
+static void iree_task_worker_flush_mailbox(iree_task_worker_t* worker) {
+  // Reset the priority hint prior to flushing: any tasks posted after this
+  // point will set it again even if we end up flushing them here.
+  iree_atomic_store_int32(&worker->mailbox_priority_mask, 0,
+                          iree_memory_order_relaxed);
+
+  // Flushing is atomic and afterward we own the list exclusively.
+  iree_task_list_t list;
+  iree_task_list_initialize(&list);
+  if (iree_atomic_task_slist_flush(
+          &worker->mailbox_slist,
+          IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_FIFO, &list.head,
+          &list.tail)) {
+    iree_task_worker_push_fifo_list(worker, &list);
+  }
+}
+
+// Returns the index of the highest priority lane with tasks or -1 if empty.
+static int iree_task_worker_highest_lane(iree_task_worker_t* worker) {
+  for (int i = IREE_TASK_SCOPE_PRIORITY_COUNT - 1; i >= 0; --i) {
+    if (!iree_task_deque_is_empty(&worker->local_task_deques[i])) return i;
+  }
+  return -1;
+}
+
+// Returns the index of the lowest priority lane with tasks or -1 if empty.
+static int iree_task_worker_lowest_lane(iree_task_worker_t* worker) {
+  for (int i = 0; i < IREE_TASK_SCOPE_PRIORITY_COUNT; ++i) {
+    if (!iree_task_deque_is_empty(&worker->local_task_deques[i])) return i;
+  }
+  return -1;
+}
+
+#if IREE_STATISTICS_ENABLE
+void iree_task_worker_statistics_query(
+    iree_task_worker_statistics_t* statistics,
+    iree_task_executor_statistics_t* target) {
+#define IREE_TASK_WORKER_STATISTICS_LOAD(field) \
+  iree_atomic_load_int64(&statistics->field, iree_memory_order_relaxed)
+  target->task_count += IREE_TASK_WORKER_STATISTICS_LOAD(task_count);
+  target->tile_count +=
+      IREE_TASK_WORKER_STATISTICS_LOAD(dispatch_statistics.tile_count);
+  target->steal_attempt_count +=
+      IREE_TASK_WORKER_STATISTICS_LOAD(steal_attempt_count);
+  target->steal_success_count +=
+      IREE_TASK_WORKER_STATISTICS_LOAD(steal_success_count);
+  target->coordinator_acquire_count +=
+      IREE_TASK_WORKER_STATISTICS_LOAD(coordinator_acquire_count);
+  target->sleep_count += IREE_TASK_WORKER_STATISTICS_LOAD(sleep_count);
+  target->wake_count += IREE_TASK_WORKER_STATISTICS_LOAD(wake_count);
+  target->execute_duration_ns +=
+      IREE_TASK_WORKER_STATISTICS_LOAD(execute_duration_ns);
+  target->coordinate_duration_ns +=
+      IREE_TASK_WORKER_STATISTICS_LOAD(coordinate_duration_ns);
+  target->steal_duration_ns +=
+      IREE_TASK_WORKER_STATISTICS_LOAD(steal_duration_ns);
+  target->sleep_duration_ns +=
+      IREE_TASK_WORKER_STATISTICS_LOAD(sleep_duration_ns);
+#undef IREE_TASK_WORKER_STATISTICS_LOAD
+}
+#endif  // IREE_STATISTICS_ENABLE
+
+// Tries to steal tasks with a priority of at least |min_priority| from other
+// workers into the local lanes of |worker|. Returns the first stolen task, if
+// any.
+static iree_task_t* iree_task_worker_steal_task(
+    iree_task_worker_t* worker, iree_task_scope_priority_t min_priority) {
+  IREE_STATISTICS(iree_time_t start_ns = iree_time_now());
+  iree_task_t* task = iree_task_executor_try_steal_task(
+      worker->executor, worker->constructive_sharing_mask,
+      worker->theft_victim_mask, worker->max_theft_attempts,
+      &worker->theft_prng, min_priority, worker->local_task_deques);
+#if IREE_STATISTICS_ENABLE
+  iree_task_worker_statistics_add(&worker->statistics.steal_attempt_count, 1);
+  if (task) {
+    iree_task_worker_statistics_add(&worker->statistics.steal_success_count,
+                                    1);
+  }
+  iree_task_worker_statistics_add(&worker->statistics.steal_duration_ns,
+                                  iree_time_now() - start_ns);
+#endif  // IREE_STATISTICS_ENABLE
+  return task;
+}
+
+// Returns true if |pending_submission| has any ready tasks with a priority
+// higher than |priority|.
+static bool iree_task_worker_has_pending_priority(
+    iree_task_submission_t* pending_submission, int priority) {
+  for (iree_task_t* task = pending_submission->ready_list.head; task != NULL;
+       task = task->next_task) {
+    if ((int)iree_task_priority(task) > priority) return true;
+  }
+  return false;
+}
+
+// Ends any outstanding starvation guard turn by clearing the priority bit set
+// to limit it to a single slice.
+static void iree_task_worker_end_starvation_grant(iree_task_worker_t* worker) {
+  if (!worker->starvation_grant_bit) return;
+  iree_atomic_fetch_and_int32(&worker->mailbox_priority_mask,
+                              ~worker->starvation_grant_bit,
+                              iree_memory_order_relaxed);
+  worker->starvation_grant_bit = 0;
+}
+
+// Pops the next task the worker should execute from its local lanes.
+//
+// Tasks are taken from the highest priority lane available, including any
+// newly posted to the mailbox with a priority higher than all of the local
+// tasks. To ensure lower priority work is not starved indefinitely by a steady
+// stream of higher priority work the lowest priority lane is serviced once
+// every IREE_TASK_PRIORITY_STARVATION_LIMIT tasks.
+//
+// Tasks made ready by those the worker has executed accumulate in
+// |pending_submission| and are normally only scheduled once the worker runs
+// out of work. If any of them are a higher priority than everything in the
+// local lanes they are scheduled immediately so that they can run first.
+//
+// When the worker has nothing but low priority work it will periodically look
+// to steal any higher priority work from other workers. This is only done for
+// low priority work as it's the only class that has opted in to waiting and
+// it keeps the overhead of the common (everything normal priority) case to a
+// few loads per task. Steals are limited to one every
+// IREE_TASK_PRIORITY_LOW_STEAL_INTERVAL tasks so that workloads that are
+// entirely low priority do not scan the other workers for every task.
+static iree_task_t* iree_task_worker_pop_task(
+    iree_task_worker_t* worker, iree_task_submission_t* pending_submission) {
+  int lane = iree_task_worker_highest_lane(worker);
+
+  // Pull in any work that has been posted with a priority higher than what we
+  // have locally so that it can jump the line.
+  int32_t posted_mask = iree_atomic_load_int32(&worker->mailbox_priority_mask,
+                                               iree_memory_order_acquire);
+  if (posted_mask >> (lane + 1)) {
+    iree_task_worker_flush_mailbox(worker);
+    lane = iree_task_worker_highest_lane(worker);
+  }
+  if (lane < 0) return NULL;
+
+  // Schedule any higher priority work we've made ready; anything assigned to
+  // this worker will be posted directly into its local lanes.
+  if (!iree_task_submission_is_empty(pending_submission) &&
+      iree_task_worker_has_pending_priority(pending_submission, lane)) {
+    iree_task_executor_merge_submission(worker->executor, pending_submission);
+    iree_task_executor_coordinate(worker->executor, worker,
+                                  /*wait_on_idle=*/false);
+    lane = iree_task_worker_highest_lane(worker);
+  }
+
+  if (lane == IREE_TASK_SCOPE_PRIORITY_LOW) {
+    if (worker->low_steal_countdown == 0) {
+      worker->low_steal_countdown = IREE_TASK_PRIORITY_LOW_STEAL_INTERVAL;
+      iree_task_t* task =
+          iree_task_worker_steal_task(worker, IREE_TASK_SCOPE_PRIORITY_LOW + 1);
+      if (task) return task;
+    } else {
+      --worker->low_steal_countdown;
+    }
+  } else {
+    // Check for higher priority work as soon as we run out of it locally.
+    worker->low_steal_countdown = 0;
+  }
+
+  // Starvation guard: if lower priority lanes have been passed over too many
+  // times in a row give them a turn.
+  int lowest_lane = iree_task_worker_lowest_lane(worker);
+  if (lowest_lane < lane) {
+    if (++worker->starvation_count >= IREE_TASK_PRIORITY_STARVATION_LIMIT) {
+      // Only grant a slice: flag the higher priority work as if it had just
+      // been posted so that a dispatch shard picked up here yields after its
+      // first tile reservation instead of running the entire dispatch. The
+      // bit is cleared once the task returns unless it was already set by a
+      // real post (in which case the next mailbox flush clears it).
+      const int32_t lane_bit = 1 << lane;
+      int32_t prior_mask = iree_atomic_fetch_or_int32(
+          &worker->mailbox_priority_mask, lane_bit, iree_memory_order_relaxed);
+      worker->starvation_grant_bit = (prior_mask & lane_bit) ? 0 : lane_bit;
+      worker->starvation_count = 0;
+      lane = lowest_lane;
+    }
+  } else {
+    worker->starvation_count = 0;
+  }
+
+  iree_task_t* task = iree_task_deque_pop(&worker->local_task_deques[lane]);
+  if (IREE_UNLIKELY(!task)) {
+    // Lost a race with a thief for the last task in the lane; try the others.
+    for (int i = IREE_TASK_SCOPE_PRIORITY_COUNT - 1; i >= 0 && !task; --i) {
+      task = iree_task_deque_pop(&worker->local_task_deques[i]);
+    }
+    if (!task) iree_task_worker_end_starvation_grant(worker);
+  }
+  return task;
+}
+
 // Executes a task on a worker.
 // Only task types that are scheduled to workers are handled; all others must be
 // handled by the coordinator during scheduling.
@@ -177,16 +531,35 @@ static void iree_task_worker_execute(
   // TODO(benvanik): think a bit more about this timing; this ensures we have
   // BFS behavior at the cost of the additional merge overhead - it's probably
   // worth it?
-  // TODO(benvanik): handle partial tasks and re-queuing.
+#if IREE_STATISTICS_ENABLE
+  iree_time_t start_ns = iree_time_now();
+  iree_task_dispatch_statistics_t* dispatch_statistics =
+      &worker->statistics.dispatch_statistics;
+#else
+  iree_task_dispatch_statistics_t* dispatch_statistics = NULL;
+#endif  // IREE_STATISTICS_ENABLE
   switch (task->type) {
     case IREE_TASK_TYPE_CALL: {
       iree_task_call_execute((iree_task_call_t*)task, pending_submission);
       break;
     }
     case IREE_TASK_TYPE_DISPATCH_SHARD: {
-      iree_task_dispatch_shard_execute((iree_task_dispatch_shard_t*)task,
-                                       worker->local_memory,
-                                       pending_submission);
+      iree_task_scope_priority_t priority = iree_task_priority(task);
+      // Grow local memory if required by the dispatch. If growth fails the
+      // shard fails with RESOURCE_EXHAUSTED as the memory is insufficient.
+      iree_task_dispatch_t* dispatch_task =
+          (iree_task_dispatch_t*)task->completion_task;
+      iree_task_worker_ensure_local_memory(worker,
+                                           dispatch_task->local_memory_size);
+      if (!iree_task_dispatch_shard_execute(
+              (iree_task_dispatch_shard_t*)task, worker->local_memory,
+              &worker->mailbox_priority_mask, dispatch_statistics,
+              pending_submission)) {
+        // Preempted by higher priority work; requeue the shard so that it
+        // continues once that work has been handled. It remains available
+        // for other workers to steal in the meantime.
+        iree_task_deque_push(&worker->local_task_deques[priority], task);
+      }
       break;
     }
     default:
@@ -196,6 +569,15 @@ static void iree_task_worker_execute(
 
   // NOTE: task is invalidated above and must not be used!
   task = NULL;
+
+  // If the task ran as part of a starvation guard turn the turn is over.
+  iree_task_worker_end_starvation_grant(worker);
+
+#if IREE_STATISTICS_ENABLE
+  iree_task_worker_statistics_add(&worker->statistics.task_count, 1);
+  iree_task_worker_statistics_add(&worker->statistics.execute_duration_ns,
+                                  iree_time_now() - start_ns);
+#endif  // IREE_STATISTICS_ENABLE
 }
 
 // Pumps the worker thread once, processing a single task.
@@ -205,34 +587,33 @@ static bool iree_task_worker_pump_once(
     iree_task_worker_t* worker, iree_task_submission_t* pending_submission) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  // Check the local work queue for any work we know we should start
+  // Check the local work lanes for any work we know we should start
   // processing immediately. Other workers may try to steal some of this work
-  // if we take too long.
-  iree_task_t* task = iree_task_queue_pop_front(&worker->local_task_queue);
+  // if we take too long. This is a lock-free pop that only contends with
+  // thieves when we are down to our last task.
+  iree_task_t* task = iree_task_worker_pop_task(worker, pending_submission);
 
   // Check the mailbox to see if we have incoming work that has been posted.
-  // We try to greedily move it to our local work list so that we can work
-  // with the full thread-local pending task list.
+  // We try to greedily move it to our local work lanes so that we can work
+  // with the full thread-local pending task list. We only pay for the atomic
+  // flush when the lanes have run dry (or higher priority work arrives).
   if (!task) {
-    // NOTE: there's a potential for theft pessimization if the queue runs too
+    // NOTE: there's a potential for theft pessimization if the deque runs too
     // low and there's nothing there when a thief goes to grab some tasks. A
     // standout there would indicate that we weren't scheduling very well in the
     // first place (large uneven workloads for various workers, bad distribution
     // in the face of heterogenous multi-core architectures where some workers
     // complete tasks faster than others, etc).
-    task = iree_task_queue_flush_from_lifo_slist(&worker->local_task_queue,
-                                                 &worker->mailbox_slist);
+    iree_task_worker_flush_mailbox(worker);
+    task = iree_task_worker_pop_task(worker, pending_submission);
   }
 
   // If we ran out of work assigned to this specific worker try to steal some
   // from other workers that we hopefully share some of the cache hierarchy
-  // with. Their tasks will be moved from their local queue into ours and the
-  // the first task in the queue is popped off and returned.
+  // with. Their tasks will be moved from their local lanes into ours and the
+  // the first stolen task is returned.
   if (!task) {
-    task = iree_task_executor_try_steal_task(
-        worker->executor, worker->constructive_sharing_mask,
-        worker->max_theft_attempts, &worker->theft_prng,
-        &worker->local_task_queue);
+    task = iree_task_worker_steal_task(worker, IREE_TASK_SCOPE_PRIORITY_LOW);
   }
 
   // No tasks to run; let the caller know we want to wait for more.
@@ -249,19 +630,109 @@ static bool iree_task_worker_pump_once(
   return true;  // try again
 }
 
+iree_status_t iree_task_donated_wait_until(const iree_task_donated_wait_t* wait,
+                                           iree_time_t deadline_ns) {
+  if (wait->wait_set) {
+    // Not all implementations accept a NULL |out_wake_handle|.
+    iree_wait_handle_t wake_handle;
+    return iree_wait_any(wait->wait_set, deadline_ns, &wake_handle);
+  }
+  return iree_wait_one(wait->wait_handle, deadline_ns);
+}
+
+// Returns true if |wait| has resolved (successfully or otherwise).
+static bool iree_task_worker_is_wait_resolved(
+    const iree_task_donated_wait_t* wait) {
+  iree_status_t status =
+      iree_task_donated_wait_until(wait, IREE_TIME_INFINITE_PAST);
+  bool is_resolved = !iree_status_is_deadline_exceeded(status);
+  iree_status_ignore(status);
+  return is_resolved;
+}
+
+bool iree_task_worker_pump_donated(iree_task_worker_t* worker,
+                                   const iree_task_donated_wait_t* wait) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_task_submission_t pending_submission;
+  iree_task_submission_initialize(&pending_submission);
+
+  int executed_tasks = 0;
+  while (true) {
+    // Tasks in the local lanes have already been claimed by this worker and
+    // must be drained as no other worker is able to steal them when the worker
+    // is not part of the live set.
+    iree_task_t* task = iree_task_worker_pop_task(worker, &pending_submission);
+
+    if (!task) {
+      // Before picking up more work check to see if the caller's wait has
+      // resolved; we don't want to keep the donated thread any longer than
+      // required and it's better to leave the work for the real workers.
+      // We only do this when we run dry as it is a syscall.
+      if (executed_tasks > 0 && iree_task_worker_is_wait_resolved(wait)) {
+        break;
+      }
+      iree_task_worker_flush_mailbox(worker);
+      task = iree_task_worker_pop_task(worker, &pending_submission);
+    }
+    if (!task) {
+      task = iree_task_worker_steal_task(worker, IREE_TASK_SCOPE_PRIORITY_LOW);
+    }
+    if (!task) break;
+
+    iree_task_worker_execute(worker, task, &pending_submission);
+    ++executed_tasks;
+  }
+
+  // Any newly ready tasks will be scheduled on the next coordination.
+  if (!iree_task_submission_is_empty(&pending_submission)) {
+    iree_task_executor_merge_submission(worker->executor, &pending_submission);
+  }
+
+  // The donated thread is about to give up the worker; release local memory
+  // if a trim was requested while it was pumping.
+  iree_task_worker_trim_if_requested(worker);
+
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, executed_tasks);
+  IREE_TRACE_ZONE_END(z0);
+  return executed_tasks > 0;
+}
+
+// Waits for the worker to be posted new work, first spinning for the worker's
+// adaptive spin count before parking the thread. Spins that see work arrive
+// double the spin count and parks halve it so that workers receiving a steady
+// stream of short bursts stay hot while workers that go idle for longer stop
+// burning their cores.
+static void iree_task_worker_wait_for_wake(iree_task_worker_t* worker,
+                                           iree_host_size_t worker_index) {
+  bool did_park = iree_notification_set_commit_wait(
+      &worker->executor->worker_wake_notifications, worker_index,
+      worker->idle_spin_count);
+  if (did_park) {
+    worker->idle_spin_count =
+        iree_max(worker->idle_spin_count / 2, IREE_TASK_WORKER_MIN_SPIN_COUNT);
+  } else {
+    worker->idle_spin_count =
+        iree_min(worker->idle_spin_count * 2, IREE_TASK_WORKER_MAX_SPIN_COUNT);
+  }
+}
+
 // Alternates between pumping ready tasks in the worker queue and waiting
 // for more tasks to arrive. Only returns when the worker has been asked by
 // the executor to exit.
 static void iree_task_worker_pump_until_exit(iree_task_worker_t* worker) {
+  iree_notification_set_t* wake_notifications =
+      &worker->executor->worker_wake_notifications;
+  const iree_host_size_t worker_index =
+      iree_task_affinity_set_count_trailing_zeros(worker->worker_bit);
+
   // Pump the thread loop to process more tasks.
   while (true) {
     // If we fail to find any work to do we'll wait at the end of this loop.
     // In order not to not miss any work that is enqueued after we've already
-    // checked a particular source we use an interruptable wait token that
-    // will prevent the wait from happening if anyone touches the data
-    // structures we use.
-    iree_wait_token_t wait_token =
-        iree_notification_prepare_wait(&worker->wake_notification);
+    // checked a particular source we prepare the wait first such that any
+    // posts made after we've checked will prevent the wait from happening.
+    iree_notification_set_prepare_wait(wake_notifications, worker_index);
     iree_atomic_task_affinity_set_fetch_and(&worker->executor->worker_idle_mask,
                                             ~worker->worker_bit,
                                             iree_memory_order_seq_cst);
@@ -270,7 +741,6 @@ static void iree_task_worker_pump_until_exit(iree_task_worker_t* worker) {
     if (iree_atomic_load_int32(&worker->state, iree_memory_order_seq_cst) ==
         IREE_TASK_WORKER_STATE_EXITING) {
       // Thread exit requested - cancel pumping.
-      iree_notification_cancel_wait(&worker->wake_notification);
       // TODO(benvanik): complete tasks before exiting?
       break;
     }
@@ -310,14 +780,19 @@ static void iree_task_worker_pump_until_exit(iree_task_worker_t* worker) {
     // If nothing has been enqueued since we started this loop (so even
     // coordination didn't find anything) we go idle. Otherwise we fall
     // through and try the loop again.
-    if (schedule_dirty ||
-        !iree_task_queue_is_empty(&worker->local_task_queue)) {
+    if (schedule_dirty || iree_task_worker_has_local_tasks(worker)) {
       // Have more work to do; loop around to try another pump.
-      iree_notification_cancel_wait(&worker->wake_notification);
     } else {
       IREE_TRACE_ZONE_BEGIN_NAMED(z_wait,
                                   "iree_task_worker_main_pump_wake_wait");
-      iree_notification_commit_wait(&worker->wake_notification, wait_token);
+      iree_task_worker_trim_if_requested(worker);
+      IREE_STATISTICS(iree_time_t sleep_start_ns = iree_time_now());
+      iree_task_worker_wait_for_wake(worker, worker_index);
+#if IREE_STATISTICS_ENABLE
+      iree_task_worker_statistics_add(&worker->statistics.sleep_count, 1);
+      iree_task_worker_statistics_add(&worker->statistics.sleep_duration_ns,
+                                      iree_time_now() - sleep_start_ns);
+#endif  // IREE_STATISTICS_ENABLE
       IREE_TRACE_ZONE_END(z_wait);
     }
 
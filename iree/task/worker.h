@@ -16,9 +16,10 @@
 #include "iree/base/internal/threading.h"
 #include "iree/base/tracing.h"
 #include "iree/task/affinity_set.h"
+#include "iree/task/deque.h"
 #include "iree/task/executor.h"
 #include "iree/task/list.h"
-#include "iree/task/queue.h"
+#include "iree/task/scope.h"
 #include "iree/task/task.h"
 #include "iree/task/topology.h"
 #include "iree/task/tuning.h"
@@ -50,6 +51,49 @@ typedef enum iree_task_worker_state_e {
   IREE_TASK_WORKER_STATE_ZOMBIE = 3,
 } iree_task_worker_state_t;
 
+// Statistics counters for a single worker.
+// With the exception of wake_count the counters are only ever updated by the
+// thread pumping the worker and are read by threads querying the executor
+// statistics. As there is a single writer updates are performed with relaxed
+// loads and stores instead of read-modify-write atomics so that they cost no
+// more than a normal increment; see iree_task_worker_statistics_add.
+typedef struct iree_task_worker_statistics_t {
+#if IREE_STATISTICS_ENABLE
+  iree_atomic_int64_t task_count;
+  iree_atomic_int64_t steal_attempt_count;
+  iree_atomic_int64_t steal_success_count;
+  iree_atomic_int64_t coordinator_acquire_count;
+  iree_atomic_int64_t sleep_count;
+  // Incremented by any thread waking the worker with read-modify-write atomics.
+  iree_atomic_int64_t wake_count;
+  iree_atomic_int64_t execute_duration_ns;
+  iree_atomic_int64_t coordinate_duration_ns;
+  iree_atomic_int64_t steal_duration_ns;
+  iree_atomic_int64_t sleep_duration_ns;
+  // Statistics merged from all dispatch shards the worker has executed.
+  iree_task_dispatch_statistics_t dispatch_statistics;
+#else
+  int reserved;
+#endif  // IREE_STATISTICS_ENABLE
+} iree_task_worker_statistics_t;
+
+#if IREE_STATISTICS_ENABLE
+
+// Adds |value| to a worker statistics |counter|.
+// Must only be called by the single writer of the counter.
+static inline void iree_task_worker_statistics_add(iree_atomic_int64_t* counter,
+                                                   int64_t value) {
+  int64_t current = iree_atomic_load_int64(counter, iree_memory_order_relaxed);
+  iree_atomic_store_int64(counter, current + value, iree_memory_order_relaxed);
+}
+
+// Adds the counters from the worker |statistics| to |target|.
+void iree_task_worker_statistics_query(
+    iree_task_worker_statistics_t* statistics,
+    iree_task_executor_statistics_t* target);
+
+#endif  // IREE_STATISTICS_ENABLE
+
 // A worker within the executor pool.
 //
 // NOTE: fields in here are touched from multiple threads with lock-free
@@ -61,22 +105,25 @@ typedef struct iree_task_worker_t {
   // As workers self-nominate to be coordinators and fan out dispatch shards
   // they can directly emplace those shards into the workers that should execute
   // them based on the work distribution policy. When workers go to look for
-  // more work after their local queue empties they will flush this list and
-  // move all of the tasks into their local queue and restart processing.
-  // LAYOUT: must be 64b away from local_task_queue.
+  // more work after their local lanes empty they will flush this list and
+  // move all of the tasks into their local lanes and restart processing.
+  // LAYOUT: must be 64b away from local_task_deques.
   iree_atomic_task_slist_t mailbox_slist;
 
+  // Bitmask of iree_task_scope_priority_t bits indicating the priorities of
+  // tasks posted to the mailbox since it was last flushed. The worker checks
+  // this between tasks (and dispatch shards between tile reservations) so that
+  // newly posted higher priority work does not wait behind lower priority work
+  // the worker already has. Only a hint: thieves may take tasks from the
+  // mailbox without clearing the bits.
+  // LAYOUT: next to mailbox_slist as they are always posted to together.
+  iree_atomic_int32_t mailbox_priority_mask;
+
   // Current state of the worker (iree_task_worker_state_t).
-  // LAYOUT: frequent access; next to wake_notification as they are always
-  //         accessed together.
+  // LAYOUT: frequent access; checked after each wake from the executor
+  //         worker_wake_notifications.
   iree_atomic_int32_t state;
 
-  // Notification signaled when the worker should wake (if it is idle).
-  // LAYOUT: next to state for similar access patterns; when posting other
-  //         threads will touch mailbox_slist and then send a wake
-  //         notification.
-  iree_notification_t wake_notification;
-
   // Notification signaled when the worker changes any state.
   iree_notification_t state_notification;
 
@@ -97,6 +144,11 @@ typedef struct iree_task_worker_t {
   // all share the same L3 cache.
   iree_task_affinity_set_t constructive_sharing_mask;
 
+  // A bitmask of workers that may be stolen from. By default this is limited
+  // to the workers attached to the same NUMA node to avoid pulling work (and
+  // the memory it touches) across the interconnect.
+  iree_task_affinity_set_t theft_victim_mask;
+
   // Maximum number of attempts to make when trying to steal tasks from other
   // workers. This could be 64 (try stealing from all workers) or just a handful
   // (try stealing from these 3 other cores that share your L3 cache).
@@ -106,12 +158,37 @@ typedef struct iree_task_worker_t {
   // Only ever touched by the worker thread as it steals work.
   iree_prng_minilcg128_state_t theft_prng;
 
+  // Number of consecutive tasks taken from a higher priority lane while a
+  // lower priority lane had tasks waiting. Used to guarantee lower priority
+  // work makes forward progress; see IREE_TASK_PRIORITY_STARVATION_LIMIT.
+  // Only ever touched by the worker thread.
+  uint32_t starvation_count;
+
+  // Priority bit set in |mailbox_priority_mask| by the worker itself to limit
+  // a starvation guard turn to a single slice, or 0 if none is outstanding.
+  // Cleared once the task run in the turn returns so that it does not preempt
+  // later work. Only ever touched by the worker thread.
+  int32_t starvation_grant_bit;
+
+  // Number of tasks remaining before a worker with only low priority work
+  // next tries to steal higher priority work from other workers; see
+  // IREE_TASK_PRIORITY_LOW_STEAL_INTERVAL. Only ever touched by the worker
+  // thread.
+  uint32_t low_steal_countdown;
+
+  // Number of iterations to spin waiting for new work before parking the
+  // thread when idle. Adapted between IREE_TASK_WORKER_MIN_SPIN_COUNT and
+  // IREE_TASK_WORKER_MAX_SPIN_COUNT based on whether recent spins found work.
+  // Only ever touched by the worker thread.
+  uint32_t idle_spin_count;
+
   // Thread handle of the worker. If the thread has exited the handle will
-  // remain valid so that the executor can query its state.
+  // remain valid so that the executor can query its state. NULL if the worker
+  // is threadless and pumped by donated caller threads.
   iree_thread_t* thread;
 
-  // Destructive interference padding between the mailbox and local task queue
-  // to ensure that the worker - who is pounding on local_task_queue - doesn't
+  // Destructive interference padding between the mailbox and local task deques
+  // to ensure that the worker - who is pounding on local_task_deques - doesn't
   // contend with submissions or coordinators dropping new tasks in the mailbox.
   //
   // Today we don't need this, however on 32-bit systems or if we adjust the
@@ -124,33 +201,83 @@ typedef struct iree_task_worker_t {
 
   // Pointer to local memory available for use exclusively by the worker.
   // The base address should be aligned to avoid false sharing with other
-  // workers.
+  // workers. Initially |local_memory_reserved| and replaced by a larger block
+  // allocated from |local_memory_allocator| when a dispatch requires more.
+  // Only ever touched by the thread running the worker.
   iree_byte_span_t local_memory;
 
-  // Worker-local FIFO queue containing the tasks that will be processed by the
-  // worker. This queue supports work-stealing by other workers if they run out
-  // of work of their own.
-  // LAYOUT: must be 64b away from mailbox_slist.
-  iree_task_queue_t local_task_queue;
+  // Local memory reserved for the worker in the executor allocation at
+  // creation. May be empty.
+  iree_byte_span_t local_memory_reserved;
+
+  // Allocator used to grow local memory on demand. Allocations are made from
+  // the worker thread and prefer the NUMA node of the worker when known.
+  iree_allocator_t local_memory_allocator;
+
+  // Nonzero when the worker has been asked to release local memory grown
+  // beyond |local_memory_reserved| the next time it is idle.
+  iree_atomic_int32_t local_memory_trim_requested;
+
+  // Worker-local Chase-Lev deques containing the tasks that will be processed
+  // by the worker, one lane per iree_task_scope_priority_t. The worker pushes
+  // and pops at the bottom without locks while other workers may steal from
+  // the top if they run out of work of their own. Tasks are always taken from
+  // the highest priority lane that has any (modulo starvation avoidance).
+  // LAYOUT: must be 64b away from mailbox_slist; the deque itself aligns its
+  //         top/bottom indices to avoid interference between owner/thieves.
+  iree_task_deque_t local_task_deques[IREE_TASK_SCOPE_PRIORITY_COUNT];
+
+  // Statistics counters updated as the worker executes.
+  // LAYOUT: written frequently by the worker thread; kept at the end of the
+  //         structure away from the fields other threads post to.
+  iree_task_worker_statistics_t statistics;
 } iree_task_worker_t;
 static_assert(offsetof(iree_task_worker_t, mailbox_slist) +
                       sizeof(iree_atomic_task_slist_t) <
                   iree_hardware_constructive_interference_size,
               "mailbox_slist must be in the first cache line");
-static_assert(offsetof(iree_task_worker_t, local_task_queue) >=
+static_assert(offsetof(iree_task_worker_t, local_task_deques) >=
                   iree_hardware_constructive_interference_size,
-              "local_task_queue must be separated from mailbox_slist by "
+              "local_task_deques must be separated from mailbox_slist by "
               "at least a cache line");
 
 // Initializes a worker by creating its thread and configuring it for receiving
 // tasks. Where supported the worker will be created in a suspended state so
 // that we aren't creating a thundering herd on startup:
 // https://en.wikipedia.org/wiki/Thundering_herd_problem
+//
+// |theft_victim_mask| limits which other workers this worker will steal from.
 iree_status_t iree_task_worker_initialize(
     iree_task_executor_t* executor, iree_host_size_t worker_index,
     const iree_task_topology_group_t* topology_group,
-    iree_byte_span_t local_memory, iree_prng_splitmix64_state_t* seed_prng,
-    iree_task_worker_t* out_worker);
+    iree_task_affinity_set_t theft_victim_mask, iree_byte_span_t local_memory,
+    iree_prng_splitmix64_state_t* seed_prng, iree_task_worker_t* out_worker);
+
+// Initializes a worker that has no thread of its own and is instead pumped by
+// caller threads donated with iree_task_executor_donate_caller.
+// |worker_bit| may be 0 if the worker will never have tasks posted to it and
+// only acquires work by stealing from the other workers.
+void iree_task_worker_initialize_donated(
+    iree_task_executor_t* executor, iree_task_affinity_set_t worker_bit,
+    iree_task_affinity_set_t constructive_sharing_mask,
+    uint32_t max_theft_attempts, iree_byte_span_t local_memory,
+    iree_prng_splitmix64_state_t* seed_prng, iree_task_worker_t* out_worker);
+
+// Ensures the worker has at least |local_memory_size| bytes of local memory,
+// growing it if required. Must only be called from the thread running the
+// worker. Returns false if the local memory could not be grown; the worker
+// local memory remains unchanged.
+bool iree_task_worker_ensure_local_memory(iree_task_worker_t* worker,
+                                          iree_host_size_t local_memory_size);
+
+// Requests that the worker release local memory grown beyond its initial
+// reservation the next time it is idle. Thread-safe.
+void iree_task_worker_request_trim(iree_task_worker_t* worker);
+
+// Releases grown local memory if a trim was requested with
+// iree_task_worker_request_trim. Must only be called from the thread running
+// the worker (or while holding exclusive access to a donated worker).
+void iree_task_worker_trim_if_requested(iree_task_worker_t* worker);
 
 // Deinitializes a worker that has successfully exited. The worker must be in
 // the IREE_TASK_WORKER_STATE_ZOMBIE state.
@@ -170,14 +297,52 @@ void iree_task_worker_request_exit(iree_task_worker_t* worker);
 void iree_task_worker_post_tasks(iree_task_worker_t* worker,
                                  iree_task_list_t* list);
 
-// Tries to steal up to |max_tasks| from the back of the queue.
-// Returns NULL if no tasks are available and otherwise up to |max_tasks| tasks
-// that were at the tail of the worker FIFO will be moved to the |target_queue|
-// and the first of the stolen tasks is returned. While tasks from the FIFO
-// are preferred this may also steal tasks from the mailbox.
-iree_task_t* iree_task_worker_try_steal_task(iree_task_worker_t* worker,
-                                             iree_task_queue_t* target_queue,
-                                             iree_host_size_t max_tasks);
+// Pushes a LIFO |list| of tasks directly into the local lanes of the worker
+// based on the priority of each task. |list| will be reset.
+//
+// Must only be called from the thread owning the worker.
+void iree_task_worker_push_lifo_list(iree_task_worker_t* worker,
+                                     iree_task_list_t* list);
+
+// Returns true if the worker has any tasks in its local lanes.
+//
+// Must only be called from the thread owning the worker.
+bool iree_task_worker_has_local_tasks(iree_task_worker_t* worker);
+
+// Tries to steal up to |max_tasks| from the top of the worker deques.
+// Only lanes with a priority of at least |min_priority| are considered and
+// higher priority lanes are preferred. Returns NULL if no tasks are available
+// and otherwise up to |max_tasks| tasks that the worker would have processed
+// last will be moved to the matching lane in |target_deques| and the first of
+// the stolen tasks is returned. While tasks from the deques are preferred this
+// may also steal tasks from the mailbox when |min_priority| allows any task.
+//
+// Must only be called from the thread owning |target_deques|.
+iree_task_t* iree_task_worker_try_steal_task(
+    iree_task_worker_t* worker, iree_task_scope_priority_t min_priority,
+    iree_task_deque_t* target_deques, iree_host_size_t max_tasks);
+
+// The wait a donated caller is blocked on: either a single |wait_handle| or
+// any handle in |wait_set|. Exactly one of the two must be set.
+typedef struct iree_task_donated_wait_t {
+  iree_wait_handle_t* wait_handle;
+  iree_wait_set_t* wait_set;
+} iree_task_donated_wait_t;
+
+// Waits for |wait| to resolve until |deadline_ns| elapses.
+// Returns IREE_STATUS_DEADLINE_EXCEEDED if the deadline elapses first.
+iree_status_t iree_task_donated_wait_until(const iree_task_donated_wait_t* wait,
+                                           iree_time_t deadline_ns);
+
+// Pumps a threadless |worker| from the calling thread until either it runs out
+// of work or |wait| resolves. Any tasks that have been moved into the local
+// lanes of the worker are always drained prior to returning so that they are
+// not stranded where other workers cannot steal them.
+// Returns true if any tasks were executed.
+//
+// The caller must ensure that only one thread at a time pumps the worker.
+bool iree_task_worker_pump_donated(iree_task_worker_t* worker,
+                                   const iree_task_donated_wait_t* wait);
 
 #ifdef __cplusplus
 }  // extern "C"
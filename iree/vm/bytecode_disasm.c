@@ -48,8 +48,8 @@
 #define VM_ParseFuncAttr(name) VM_ParseConstI32(name)
 #define VM_ParseGlobalAttr(name) VM_ParseConstI32(name)
 #define VM_ParseRodataAttr(name) VM_ParseConstI32(name)
-#define VM_ParseType(name)             \
-  iree_vm_map_type(module, OP_I32(0)); \
+#define VM_ParseType(name)                                \
+  iree_vm_map_type(module, OP_I32(0), module->verified); \
   pc += 4;
 #define VM_ParseTypeOf(name) VM_ParseType(name)
 #define VM_ParseIntAttr32(name) VM_ParseConstI32(name)
@@ -98,6 +98,8 @@
   *(out_is_move) = 0; /*= OP_I16(0) & IREE_REF_REGISTER_MOVE_BIT;*/ \
   pc += kRegSize;
 #define VM_ParseVariadicResults(name) VM_ParseVariadicOperands(name)
+#define VM_ParsePrimitiveArrayAttr16(name) \
+  VM_DecPrimitiveArrayAttr16Impl(bytecode_data, &pc)
 
 #define EMIT_REG_NAME(reg)                \
   if ((reg)&IREE_REF_REGISTER_TYPE_BIT) { \
@@ -172,7 +174,7 @@ static iree_status_t iree_vm_bytecode_disasm_emit_type_name(
   iree_vm_bytecode_disasm_emit_type_name(type_def, b);
 
 static iree_status_t iree_vm_bytecode_disasm_emit_operand_list(
-    const iree_vm_registers_t* regs, const iree_vm_register_list_t* list,
+    const iree_vm_registers_t* regs, const iree_vm_register_bank_list_t* list,
     iree_vm_bytecode_disasm_format_t format, iree_string_builder_t* b) {
   bool include_values =
       regs && (format & IREE_VM_BYTECODE_DISASM_FORMAT_INLINE_VALUES);
@@ -193,7 +195,7 @@ static iree_status_t iree_vm_bytecode_disasm_emit_operand_list(
 #define EMIT_OPERAND_REG_LIST(reg_list) \
   iree_vm_bytecode_disasm_emit_operand_list(regs, reg_list, format, b)
 static iree_status_t iree_vm_bytecode_disasm_emit_result_list(
-    const iree_vm_register_list_t* list,
+    const iree_vm_register_bank_list_t* list,
     iree_vm_bytecode_disasm_format_t format, iree_string_builder_t* b) {
   for (uint16_t i = 0; i < list->size; ++i) {
     if (i > 0) {
@@ -310,6 +312,33 @@ static iree_status_t iree_vm_bytecode_disasm_emit_remap_list(
     break;                                                             \
   }
 
+#define DISASM_OP_CORE_COND_BRANCH_CMP_I32(op_name, op_mnemonic)          \
+  DISASM_OP(CORE, op_name) {                                              \
+    uint16_t lhs_reg = VM_ParseOperandRegI32("lhs");                      \
+    uint16_t rhs_reg = VM_ParseOperandRegI32("rhs");                      \
+    int32_t true_block_pc = VM_ParseBranchTarget("true_dest");            \
+    const iree_vm_register_remap_list_t* true_remap_list =                \
+        VM_ParseBranchOperands("true_operands");                          \
+    int32_t false_block_pc = VM_ParseBranchTarget("false_dest");          \
+    const iree_vm_register_remap_list_t* false_remap_list =               \
+        VM_ParseBranchOperands("false_operands");                         \
+    IREE_RETURN_IF_ERROR(                                                 \
+        iree_string_builder_append_format(b, "%s ", op_mnemonic));        \
+    EMIT_I32_REG_NAME(lhs_reg);                                           \
+    EMIT_OPTIONAL_VALUE_I32(regs->i32[lhs_reg]);                          \
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(b, ", "));    \
+    EMIT_I32_REG_NAME(rhs_reg);                                           \
+    EMIT_OPTIONAL_VALUE_I32(regs->i32[rhs_reg]);                          \
+    IREE_RETURN_IF_ERROR(                                                 \
+        iree_string_builder_append_format(b, ", ^%08X(", true_block_pc)); \
+    EMIT_REMAP_LIST(true_remap_list);                                     \
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(               \
+        b, "), ^%08X(", false_block_pc));                                 \
+    EMIT_REMAP_LIST(false_remap_list);                                    \
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(b, ")"));     \
+    break;                                                                \
+  }
+
 #define DISASM_OP_EXT_I64_UNARY_I64(op_name, op_mnemonic)             \
   DISASM_OP(EXT_I64, op_name) {                                       \
     uint16_t operand_reg = VM_ParseOperandRegI64("operand");          \
@@ -1076,7 +1105,7 @@ iree_status_t iree_vm_bytecode_disasm_op(
     DISASM_OP(CORE, SwitchI32) {
       uint16_t index_reg = VM_ParseOperandRegI32("index");
       int32_t default_value = VM_ParseIntAttr32("default_value");
-      const iree_vm_register_list_t* value_reg_list =
+      const iree_vm_register_bank_list_t* value_reg_list =
           VM_ParseVariadicOperands("values");
       uint16_t result_reg = VM_ParseResultRegI32("result");
       EMIT_I32_REG_NAME(result_reg);
@@ -1096,7 +1125,7 @@ iree_status_t iree_vm_bytecode_disasm_op(
       bool default_is_move;
       uint16_t default_value_reg =
           VM_ParseOperandRegRef("default_value", &default_is_move);
-      const iree_vm_register_list_t* value_reg_list =
+      const iree_vm_register_bank_list_t* value_reg_list =
           VM_ParseVariadicOperands("values");
       bool result_is_move;
       uint16_t result_reg = VM_ParseResultRegRef("result", &result_is_move);
@@ -1125,6 +1154,20 @@ iree_status_t iree_vm_bytecode_disasm_op(
     DISASM_OP_CORE_BINARY_I32(RemI32S, "vm.rem.i32.s");
     DISASM_OP_CORE_BINARY_I32(RemI32U, "vm.rem.i32.u");
     DISASM_OP_CORE_TERNARY_I32(FMAI32, "vm.fma.i32");
+
+    DISASM_OP(CORE, AddI32Imm) {
+      uint16_t operand_reg = VM_ParseOperandRegI32("operand");
+      int32_t imm = VM_ParseIntAttr32("imm");
+      uint16_t result_reg = VM_ParseResultRegI32("result");
+      EMIT_I32_REG_NAME(result_reg);
+      IREE_RETURN_IF_ERROR(
+          iree_string_builder_append_cstring(b, " = vm.add.i32.imm "));
+      EMIT_I32_REG_NAME(operand_reg);
+      EMIT_OPTIONAL_VALUE_I32(regs->i32[operand_reg]);
+      IREE_RETURN_IF_ERROR(iree_string_builder_append_format(b, ", %d", imm));
+      break;
+    }
+
     DISASM_OP_CORE_UNARY_I32(NotI32, "vm.not.i32");
     DISASM_OP_CORE_BINARY_I32(AndI32, "vm.and.i32");
     DISASM_OP_CORE_BINARY_I32(OrI32, "vm.or.i32");
@@ -1256,11 +1299,20 @@ iree_status_t iree_vm_bytecode_disasm_op(
       break;
     }
 
+    DISASM_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpEQI32,
+                                       "vm.cond_br.cmp.eq.i32");
+    DISASM_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpNEI32,
+                                       "vm.cond_br.cmp.ne.i32");
+    DISASM_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpLTI32S,
+                                       "vm.cond_br.cmp.lt.i32.s");
+    DISASM_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpLTI32U,
+                                       "vm.cond_br.cmp.lt.i32.u");
+
     DISASM_OP(CORE, Call) {
       int32_t function_ordinal = VM_ParseFuncAttr("callee");
-      const iree_vm_register_list_t* src_reg_list =
+      const iree_vm_register_bank_list_t* src_reg_list =
           VM_ParseVariadicOperands("operands");
-      const iree_vm_register_list_t* dst_reg_list =
+      const iree_vm_register_bank_list_t* dst_reg_list =
           VM_ParseVariadicResults("results");
       if (dst_reg_list->size > 0) {
         EMIT_RESULT_REG_LIST(dst_reg_list);
@@ -1299,10 +1351,10 @@ iree_status_t iree_vm_bytecode_disasm_op(
       int32_t function_ordinal = VM_ParseFuncAttr("callee");
       // TODO(benvanik): print segment sizes.
       // const iree_vm_register_list_t* segment_size_list =
-      VM_ParseVariadicOperands("segment_sizes");
-      const iree_vm_register_list_t* src_reg_list =
+      VM_ParsePrimitiveArrayAttr16("segment_sizes");
+      const iree_vm_register_bank_list_t* src_reg_list =
           VM_ParseVariadicOperands("operands");
-      const iree_vm_register_list_t* dst_reg_list =
+      const iree_vm_register_bank_list_t* dst_reg_list =
           VM_ParseVariadicResults("results");
       if (dst_reg_list->size > 0) {
         EMIT_RESULT_REG_LIST(dst_reg_list);
@@ -1339,7 +1391,7 @@ iree_status_t iree_vm_bytecode_disasm_op(
     }
 
     DISASM_OP(CORE, Return) {
-      const iree_vm_register_list_t* src_reg_list =
+      const iree_vm_register_bank_list_t* src_reg_list =
           VM_ParseVariadicOperands("operands");
       IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(b, "vm.return "));
       EMIT_OPERAND_REG_LIST(src_reg_list);
@@ -1380,7 +1432,7 @@ iree_status_t iree_vm_bytecode_disasm_op(
     DISASM_OP(CORE, Trace) {
       iree_string_view_t event_name;
       VM_ParseStrAttr("event_name", &event_name);
-      const iree_vm_register_list_t* src_reg_list =
+      const iree_vm_register_bank_list_t* src_reg_list =
           VM_ParseVariadicOperands("operands");
       IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
           b, "vm.trace \"%.*s\"(", (int)event_name.size, event_name.data));
@@ -1392,7 +1444,7 @@ iree_status_t iree_vm_bytecode_disasm_op(
     DISASM_OP(CORE, Print) {
       iree_string_view_t event_name;
       VM_ParseStrAttr("event_name", &event_name);
-      const iree_vm_register_list_t* src_reg_list =
+      const iree_vm_register_bank_list_t* src_reg_list =
           VM_ParseVariadicOperands("operands");
       IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
           b, "vm.print \"%.*s\"(", (int)event_name.size, event_name.data));
@@ -1574,7 +1626,7 @@ iree_status_t iree_vm_bytecode_disasm_op(
     DISASM_OP(EXT_I64, SwitchI64) {
       uint16_t index_reg = VM_ParseOperandRegI32("index");
       int64_t default_value = VM_ParseIntAttr64("default_value");
-      const iree_vm_register_list_t* value_reg_list =
+      const iree_vm_register_bank_list_t* value_reg_list =
           VM_ParseVariadicOperands("values");
       uint16_t result_reg = VM_ParseResultRegI64("result");
       EMIT_I64_REG_NAME(result_reg);
@@ -1910,7 +1962,7 @@ iree_status_t iree_vm_bytecode_disasm_op(
     DISASM_OP(EXT_F32, SwitchF32) {
       uint16_t index_reg = VM_ParseOperandRegI32("index");
       float default_value = VM_ParseFloatAttr32("default_value");
-      const iree_vm_register_list_t* value_reg_list =
+      const iree_vm_register_bank_list_t* value_reg_list =
           VM_ParseVariadicOperands("values");
       uint16_t result_reg = VM_ParseResultRegF32("result");
       EMIT_F32_REG_NAME(result_reg);
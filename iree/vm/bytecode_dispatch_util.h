@@ -33,6 +33,14 @@
 // sneak in. The iree_vm_registers_t struct is often kept in cache and the
 // masking is cheap relative to any other validation we could be performing.
 //
+// Modules whose bytecode was checked by iree_vm_bytecode_verify_module (or
+// transcoded from an older version) when loaded are dispatched with a variant
+// of the interpreter in which the register ordinals (along with global, rodata,
+// and type references) are known to be in range. The masking and bounds checks
+// are then redundant and the ordinals are used directly. Checks on values that
+// are only known at runtime (indirect global accesses, switch indices, etc) are
+// always performed.
+//
 // Alternative register widths
 // ---------------------------
 // Registers in the VM are just a blob of memory and not physical device
@@ -75,13 +83,29 @@ typedef struct iree_vm_registers_t {
   iree_vm_ref_t* ref;
 } iree_vm_registers_t;
 
+// Register list partitioned by bank.
+// Registers [0, i32_count) are i32 registers (including those holding i64/f32/
+// f64 values) followed by ref registers up to |size|. Within each bank the
+// registers are in the order of the operands/results they encode.
+// This structure is an overlay for the bytecode that is serialized in a
+// matching format.
+typedef struct iree_vm_register_bank_list_t {
+  uint16_t i32_count;
+  uint16_t size;
+  uint16_t registers[];
+} iree_vm_register_bank_list_t;
+static_assert(iree_alignof(iree_vm_register_bank_list_t) == 2,
+              "Expecting byte alignment (to avoid padding)");
+static_assert(offsetof(iree_vm_register_bank_list_t, registers) == 4,
+              "Expect no padding in the struct");
+
 // Storage associated with each stack frame of a bytecode function.
 // NOTE: we cannot store pointers to the stack in here as the stack may be
 // reallocated.
 typedef struct iree_vm_bytecode_frame_storage_t {
   // Pointer to a register list within the stack frame where return registers
   // will be stored by callees upon return.
-  const iree_vm_register_list_t* return_registers;
+  const iree_vm_register_bank_list_t* return_registers;
 
   // Counts of each register type rounded up to the next power of two.
   iree_host_size_t i32_register_count;
@@ -90,12 +114,25 @@ typedef struct iree_vm_bytecode_frame_storage_t {
   // Relative byte offsets from the head of this struct.
   iree_host_size_t i32_register_offset;
   iree_host_size_t ref_register_offset;
+
+  // Depth of the frame that entered the dispatch loop from an external caller.
+  // Only valid on the top frame of a suspended stack and used to determine
+  // when a resumed dispatch loop returns back to the external caller.
+  int32_t entry_frame_depth;
+
+  // True if the frame is suspended within an import call whose callee left
+  // its own frames on the stack above this one. The import call is resumed
+  // instead of reissued when this frame continues.
+  bool suspended_in_import;
 } iree_vm_bytecode_frame_storage_t;
 
 // Interleaved src-dst register sets for branch register remapping.
+// Pairs [0, i32_count) remap i32 registers and the remaining pairs up to |size|
+// remap ref registers.
 // This structure is an overlay for the bytecode that is serialized in a
 // matching format.
 typedef struct iree_vm_register_remap_list_t {
+  uint16_t i32_count;
   uint16_t size;
   struct pair {
     uint16_t src_reg;
@@ -104,13 +141,34 @@ typedef struct iree_vm_register_remap_list_t {
 } iree_vm_register_remap_list_t;
 static_assert(iree_alignof(iree_vm_register_remap_list_t) == 2,
               "Expecting byte alignment (to avoid padding)");
-static_assert(offsetof(iree_vm_register_remap_list_t, pairs) == 2,
+static_assert(offsetof(iree_vm_register_remap_list_t, pairs) == 4,
               "Expect no padding in the struct");
 
-// Maps a type ID to a type def with clamping for out of bounds values.
+// Register ordinals in verified bytecode are always in range and only need the
+// bank bits (i64 alignment, ref tag) applied.
+// IREE_VM_BYTECODE_DISPATCH_VERIFIED is defined by the dispatch variant being
+// compiled in bytecode_dispatch.c.
+#define VM_MaskRegI32(reg) \
+  (IREE_VM_BYTECODE_DISPATCH_VERIFIED ? (reg) : ((reg) & regs.i32_mask))
+#define VM_MaskRegI64(reg) (VM_MaskRegI32(reg) & ~1)
+#define VM_MaskRegRef(reg)                                              \
+  ((reg) & (IREE_VM_BYTECODE_DISPATCH_VERIFIED ? IREE_REF_REGISTER_MASK \
+                                               : regs.ref_mask))
+
+// Evaluates to false for checks that have been performed by the verifier.
+#define IREE_VM_UNVERIFIED(expr) (!IREE_VM_BYTECODE_DISPATCH_VERIFIED && (expr))
+
+// Returns the number of i32 registers in a banked register or remap |list|.
+// Counts are clamped so that the i32 bank never extends past the list as the
+// marshaling routines using them are shared by all dispatch variants.
+#define VM_BankI32Count(list) \
+  ((list)->i32_count > (list)->size ? (list)->size : (list)->i32_count)
+
+// Maps a type ID to a type def with clamping for out of bounds values in
+// bytecode that has not been |verified|.
 static inline const iree_vm_type_def_t* iree_vm_map_type(
-    iree_vm_bytecode_module_t* module, int32_t type_id) {
-  type_id = type_id >= module->type_count ? 0 : type_id;
+    iree_vm_bytecode_module_t* module, int32_t type_id, bool verified) {
+  type_id = !verified && type_id >= module->type_count ? 0 : type_id;
   return &module->type_table[type_id];
 }
 
@@ -195,8 +253,8 @@ static const int kRegSize = sizeof(uint16_t);
 #define VM_DecFuncAttr(name) VM_DecConstI32(name)
 #define VM_DecGlobalAttr(name) VM_DecConstI32(name)
 #define VM_DecRodataAttr(name) VM_DecConstI32(name)
-#define VM_DecType(name)               \
-  iree_vm_map_type(module, OP_I32(0)); \
+#define VM_DecType(name)                                                   \
+  iree_vm_map_type(module, OP_I32(0), IREE_VM_BYTECODE_DISPATCH_VERIFIED); \
   pc += 4;
 #define VM_DecTypeOf(name) VM_DecType(name)
 #define VM_DecIntAttr32(name) VM_DecConstI32(name)
@@ -215,49 +273,59 @@ static inline const iree_vm_register_remap_list_t* VM_DecBranchOperandsImpl(
   VM_AlignPC(*pc, kRegSize);
   const iree_vm_register_remap_list_t* list =
       (const iree_vm_register_remap_list_t*)&bytecode_data[*pc];
-  *pc = *pc + kRegSize + list->size * 2 * kRegSize;
+  *pc = *pc + 2 * kRegSize + list->size * 2 * kRegSize;
   return list;
 }
-#define VM_DecOperandRegI32(name)      \
-  regs.i32[OP_I16(0) & regs.i32_mask]; \
+#define VM_DecPrimitiveArrayAttr16(name) \
+  VM_DecPrimitiveArrayAttr16Impl(bytecode_data, &pc)
+static inline const iree_vm_register_list_t* VM_DecPrimitiveArrayAttr16Impl(
+    const uint8_t* IREE_RESTRICT bytecode_data, iree_vm_source_offset_t* pc) {
+  VM_AlignPC(*pc, kRegSize);
+  const iree_vm_register_list_t* list =
+      (const iree_vm_register_list_t*)&bytecode_data[*pc];
+  *pc = *pc + kRegSize + list->size * kRegSize;
+  return list;
+}
+#define VM_DecOperandRegI32(name)     \
+  regs.i32[VM_MaskRegI32(OP_I16(0))]; \
   pc += kRegSize;
-#define VM_DecOperandRegI64(name)                           \
-  *((int64_t*)&regs.i32[OP_I16(0) & (regs.i32_mask & ~1)]); \
+#define VM_DecOperandRegI64(name)                   \
+  *((int64_t*)&regs.i32[VM_MaskRegI64(OP_I16(0))]); \
   pc += kRegSize;
-#define VM_DecOperandRegF32(name)                  \
-  *((float*)&regs.i32[OP_I16(0) & regs.i32_mask]); \
+#define VM_DecOperandRegF32(name)                 \
+  *((float*)&regs.i32[VM_MaskRegI32(OP_I16(0))]); \
   pc += kRegSize;
-#define VM_DecOperandRegF64(name)                          \
-  *((double*)&regs.i32[OP_I16(0) & (regs.i32_mask & ~1)]); \
+#define VM_DecOperandRegF64(name)                  \
+  *((double*)&regs.i32[VM_MaskRegI64(OP_I16(0))]); \
   pc += kRegSize;
 #define VM_DecOperandRegRef(name, out_is_move)                      \
-  &regs.ref[OP_I16(0) & regs.ref_mask];                             \
+  &regs.ref[VM_MaskRegRef(OP_I16(0))];                              \
   *(out_is_move) = 0; /*= OP_I16(0) & IREE_REF_REGISTER_MOVE_BIT;*/ \
   pc += kRegSize;
 #define VM_DecVariadicOperands(name) \
   VM_DecVariadicOperandsImpl(bytecode_data, &pc)
-static inline const iree_vm_register_list_t* VM_DecVariadicOperandsImpl(
+static inline const iree_vm_register_bank_list_t* VM_DecVariadicOperandsImpl(
     const uint8_t* IREE_RESTRICT bytecode_data, iree_vm_source_offset_t* pc) {
   VM_AlignPC(*pc, kRegSize);
-  const iree_vm_register_list_t* list =
-      (const iree_vm_register_list_t*)&bytecode_data[*pc];
-  *pc = *pc + kRegSize + list->size * kRegSize;
+  const iree_vm_register_bank_list_t* list =
+      (const iree_vm_register_bank_list_t*)&bytecode_data[*pc];
+  *pc = *pc + 2 * kRegSize + list->size * kRegSize;
   return list;
 }
-#define VM_DecResultRegI32(name)        \
-  &regs.i32[OP_I16(0) & regs.i32_mask]; \
+#define VM_DecResultRegI32(name)       \
+  &regs.i32[VM_MaskRegI32(OP_I16(0))]; \
   pc += kRegSize;
-#define VM_DecResultRegI64(name)                           \
-  ((int64_t*)&regs.i32[OP_I16(0) & (regs.i32_mask & ~1)]); \
+#define VM_DecResultRegI64(name)                   \
+  ((int64_t*)&regs.i32[VM_MaskRegI64(OP_I16(0))]); \
   pc += kRegSize;
-#define VM_DecResultRegF32(name)                  \
-  ((float*)&regs.i32[OP_I16(0) & regs.i32_mask]); \
+#define VM_DecResultRegF32(name)                 \
+  ((float*)&regs.i32[VM_MaskRegI32(OP_I16(0))]); \
   pc += kRegSize;
-#define VM_DecResultRegF64(name)                          \
-  ((double*)&regs.i32[OP_I16(0) & (regs.i32_mask & ~1)]); \
+#define VM_DecResultRegF64(name)                  \
+  ((double*)&regs.i32[VM_MaskRegI64(OP_I16(0))]); \
   pc += kRegSize;
 #define VM_DecResultRegRef(name, out_is_move)                       \
-  &regs.ref[OP_I16(0) & regs.ref_mask];                             \
+  &regs.ref[VM_MaskRegRef(OP_I16(0))];                              \
   *(out_is_move) = 0; /*= OP_I16(0) & IREE_REF_REGISTER_MOVE_BIT;*/ \
   pc += kRegSize;
 #define VM_DecVariadicResults(name) VM_DecVariadicOperands(name)
@@ -425,6 +493,29 @@ static inline const iree_vm_register_list_t* VM_DecVariadicOperandsImpl(
     *result = op_func(a, b, c);                        \
   });
 
+// Superinstruction fusing a binary i32 comparison into a conditional branch.
+// Equivalent to `vm.cmp.*` followed by a `vm.cond_br` on its result but with
+// a single dispatch and without the intermediate condition register.
+#define DISPATCH_OP_CORE_COND_BRANCH_CMP_I32(op_name, op_func)                 \
+  DISPATCH_OP(CORE, op_name, {                                                 \
+    int32_t lhs = VM_DecOperandRegI32("lhs");                                  \
+    int32_t rhs = VM_DecOperandRegI32("rhs");                                  \
+    int32_t true_block_pc = VM_DecBranchTarget("true_dest");                   \
+    const iree_vm_register_remap_list_t* true_remap_list =                     \
+        VM_DecBranchOperands("true_operands");                                 \
+    int32_t false_block_pc = VM_DecBranchTarget("false_dest");                 \
+    const iree_vm_register_remap_list_t* false_remap_list =                    \
+        VM_DecBranchOperands("false_operands");                                \
+    if (op_func(lhs, rhs)) {                                                   \
+      pc = true_block_pc;                                                      \
+      iree_vm_bytecode_dispatch_remap_branch_registers(regs, true_remap_list); \
+    } else {                                                                   \
+      pc = false_block_pc;                                                     \
+      iree_vm_bytecode_dispatch_remap_branch_registers(regs,                   \
+                                                       false_remap_list);      \
+    }                                                                          \
+  });
+
 #define DISPATCH_OP_EXT_I64_UNARY_I64(op_name, op_func) \
   DISPATCH_OP(EXT_I64, op_name, {                       \
     int64_t operand = VM_DecOperandRegI64("operand");   \
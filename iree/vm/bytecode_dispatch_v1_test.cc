@@ -0,0 +1,173 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Tests for dispatch of hand-assembled bytecode modules with register lists
+// encoded by both the version 1 (transcoded when loaded) and latest encoders.
+// bytecode_dispatch_test.cc covers the op semantics using compiled modules.
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/api.h"
+#include "iree/vm/bytecode_module.h"
+#include "iree/vm/bytecode_module_test.h"
+#include "iree/vm/native_module_test.h"
+
+namespace {
+
+class BytecodeDispatchV1Test : public ::testing::TestWithParam<int> {
+ protected:
+  void SetUp() override {
+    IREE_ASSERT_OK(
+        iree_vm_instance_create(iree_allocator_system(), &instance_));
+    module_builder_ = std::make_unique<BytecodeModuleBuilder>("module",
+                                                              GetParam());
+  }
+
+  void TearDown() override {
+    iree_vm_context_release(context_);
+    iree_vm_instance_release(instance_);
+  }
+
+  // Creates the context from |module_builder_| and any |extra_modules|.
+  void CreateContext(std::vector<iree_vm_module_t*> extra_modules = {}) {
+    iree_vm_module_t* bytecode_module = NULL;
+    IREE_ASSERT_OK(
+        module_builder_->Build(iree_allocator_system(), &bytecode_module));
+    std::vector<iree_vm_module_t*> modules = extra_modules;
+    modules.push_back(bytecode_module);
+    IREE_ASSERT_OK(iree_vm_context_create_with_modules(
+        instance_, IREE_VM_CONTEXT_FLAG_NONE, modules.data(), modules.size(),
+        iree_allocator_system(), &context_));
+    for (iree_vm_module_t* module : modules) iree_vm_module_release(module);
+  }
+
+  // Invokes |function_name| with |inputs| and returns its i32 result.
+  int32_t InvokeI32(const char* function_name, iree_vm_list_t* inputs) {
+    iree_vm_function_t function;
+    IREE_CHECK_OK(iree_vm_context_resolve_function(
+        context_, iree_make_cstring_view(function_name), &function));
+    iree_vm_list_t* outputs = NULL;
+    IREE_CHECK_OK(iree_vm_list_create(/*element_type=*/NULL, 1,
+                                      iree_allocator_system(), &outputs));
+    IREE_CHECK_OK(iree_vm_invoke(context_, function,
+                                 IREE_VM_INVOCATION_FLAG_NONE,
+                                 /*policy=*/NULL, inputs, outputs,
+                                 iree_allocator_system()));
+    iree_vm_value_t value;
+    IREE_CHECK_OK(iree_vm_list_get_value(outputs, 0, &value));
+    iree_vm_list_release(outputs);
+    return value.i32;
+  }
+
+  int32_t InvokeI32(const char* function_name, int32_t arg0) {
+    iree_vm_list_t* inputs = NULL;
+    IREE_CHECK_OK(iree_vm_list_create(/*element_type=*/NULL, 1,
+                                      iree_allocator_system(), &inputs));
+    iree_vm_value_t value = iree_vm_value_make_i32(arg0);
+    IREE_CHECK_OK(iree_vm_list_push_value(inputs, &value));
+    int32_t result = InvokeI32(function_name, inputs);
+    iree_vm_list_release(inputs);
+    return result;
+  }
+
+  int version() const { return GetParam(); }
+
+  // Owns the module FlatBuffers and must outlive |context_|.
+  std::unique_ptr<BytecodeModuleBuilder> module_builder_;
+  iree_vm_instance_t* instance_ = NULL;
+  iree_vm_context_t* context_ = NULL;
+};
+
+// Tests internal calls and branches whose register lists interleave i32 and
+// ref registers. Version 1 lists are in operand order and must be partitioned
+// by bank when transcoded.
+TEST_P(BytecodeDispatchV1Test, MixedBankCallsAndBranches) {
+  const uint16_t kRef = IREE_REF_REGISTER_TYPE_BIT;
+
+  // callee(%i0, %r0, %i1) -> (%r0, %i0 + %i1)
+  BytecodeBuilder callee(version());
+  callee.Op(IREE_VM_OP_CORE_AddI32).Reg(0).Reg(1).Reg(2);
+  callee.Op(IREE_VM_OP_CORE_Return).List({kRef | 0, 2});
+
+  // main(%r0, %i0) {
+  //   %r1, %i2 = call @callee(%i0, %r0, %i1 = 3)
+  //   br ^exit(%i2 -> %i3, %r1 -> %r2)
+  // ^exit:
+  //   return %i3 + (%r2 != null)
+  // }
+  BytecodeBuilder main(version());
+  main.Op(IREE_VM_OP_CORE_ConstI32).U32(3).Reg(1);
+  main.Op(IREE_VM_OP_CORE_Call)
+      .U32(1)
+      .List({0, kRef | 0, 1})
+      .List({kRef | 1, 2});
+  main.Op(IREE_VM_OP_CORE_Branch);
+  size_t exit_target_offset = main.offset();
+  main.U32(0).RemapList({2, 3, kRef | 1, kRef | 2});
+  main.PatchU32(exit_target_offset, static_cast<uint32_t>(main.offset()));
+  main.Op(IREE_VM_OP_CORE_CmpNZRef).RefReg(2).Reg(4);
+  main.Op(IREE_VM_OP_CORE_AddI32).Reg(3).Reg(4).Reg(5);
+  main.Op(IREE_VM_OP_CORE_Return).List({5});
+
+  module_builder_->AddFunction(main, /*i32_register_count=*/6,
+                             /*ref_register_count=*/3, "main", "0ri_i");
+  module_builder_->AddFunction(callee, /*i32_register_count=*/3,
+                             /*ref_register_count=*/1);
+  CreateContext();
+
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_ASSERT_OK(iree_vm_buffer_create(IREE_VM_BUFFER_ACCESS_MUTABLE, 16,
+                                       iree_allocator_system(), &buffer));
+  iree_vm_list_t* inputs = NULL;
+  IREE_ASSERT_OK(iree_vm_list_create(/*element_type=*/NULL, 2,
+                                     iree_allocator_system(), &inputs));
+  iree_vm_ref_t buffer_ref = iree_vm_buffer_move_ref(buffer);
+  IREE_ASSERT_OK(iree_vm_list_push_ref_move(inputs, &buffer_ref));
+  iree_vm_value_t arg1 = iree_vm_value_make_i32(7);
+  IREE_ASSERT_OK(iree_vm_list_push_value(inputs, &arg1));
+
+  EXPECT_EQ(7 + 3 + 1, InvokeI32("module.main", inputs));
+  iree_vm_list_release(inputs);
+}
+
+// Tests that i32 results of imports are marshaled into the caller registers.
+// Result lists with no ref registers previously dropped all results.
+TEST_P(BytecodeDispatchV1Test, ImportResults) {
+  uint32_t add_1 = module_builder_->AddImport("module_a.add_1", "0i_i");
+  uint32_t sub_1 = module_builder_->AddImport("module_a.sub_1", "0i_i");
+
+  // main(%i0) = add_1(add_1(%i0)) + sub_1(%i0)
+  BytecodeBuilder main(version());
+  main.Op(IREE_VM_OP_CORE_Call).U32(add_1).List({0}).List({1});
+  main.Op(IREE_VM_OP_CORE_Call).U32(add_1).List({1}).List({2});
+  main.Op(IREE_VM_OP_CORE_Call).U32(sub_1).List({0}).List({3});
+  main.Op(IREE_VM_OP_CORE_AddI32).Reg(2).Reg(3).Reg(4);
+  main.Op(IREE_VM_OP_CORE_Return).List({4});
+  module_builder_->AddFunction(main, /*i32_register_count=*/5,
+                             /*ref_register_count=*/0, "main", "0i_i");
+
+  iree_vm_module_t* module_a = NULL;
+  IREE_ASSERT_OK(module_a_create(iree_allocator_system(), &module_a));
+  CreateContext({module_a});
+
+  EXPECT_EQ((10 + 2) + (10 - 1), InvokeI32("module.main", 10));
+}
+
+INSTANTIATE_TEST_SUITE_P(BytecodeVersions, BytecodeDispatchV1Test,
+                         ::testing::Values(IREE_VM_BYTECODE_VERSION_1,
+                                           IREE_VM_BYTECODE_VERSION_LATEST),
+                         [](const ::testing::TestParamInfo<int>& info) {
+                           return info.param == IREE_VM_BYTECODE_VERSION_1
+                                      ? "V1"
+                                      : "Latest";
+                         });
+
+}  // namespace
@@ -0,0 +1,430 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Tests for suspending and resuming bytecode functions that wait or yield
+// within imports, including imports of other bytecode modules that suspend
+// with their own frames still on the stack.
+
+#include <cstring>
+#include <utility>
+
+#include "iree/base/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/api.h"
+#include "iree/vm/bytecode_module.h"
+#include "iree/vm/bytecode_module_test.h"
+
+namespace {
+
+//===----------------------------------------------------------------------===//
+// Test wait source
+//===----------------------------------------------------------------------===//
+
+// A wait source that resolves once signaled by the test.
+// If |signal_on_wait| is set then blocking waits signal it immediately to
+// simulate the wait completing; otherwise they time out.
+typedef struct test_wait_state_t {
+  bool signaled;
+  bool signal_on_wait;
+  int wait_count;
+} test_wait_state_t;
+
+static iree_status_t test_wait_source_ctl(iree_wait_source_t wait_source,
+                                          iree_wait_source_command_t command,
+                                          const void* params,
+                                          void** inout_ptr) {
+  test_wait_state_t* state = (test_wait_state_t*)wait_source.self;
+  switch (command) {
+    case IREE_WAIT_SOURCE_COMMAND_QUERY:
+      *(iree_status_code_t*)inout_ptr =
+          state->signaled ? IREE_STATUS_OK : IREE_STATUS_DEFERRED;
+      return iree_ok_status();
+    case IREE_WAIT_SOURCE_COMMAND_WAIT_ONE:
+      ++state->wait_count;
+      if (state->signal_on_wait) state->signaled = true;
+      return state->signaled
+                 ? iree_ok_status()
+                 : iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "unsupported wait source command");
+  }
+}
+
+// The wait state used by test_module; set by the test fixture.
+static test_wait_state_t* test_wait_state = NULL;
+
+static iree_wait_source_t test_wait_source(void) {
+  iree_wait_source_t wait_source;
+  memset(&wait_source, 0, sizeof(wait_source));
+  wait_source.self = test_wait_state;
+  wait_source.ctl = test_wait_source_ctl;
+  return wait_source;
+}
+
+//===----------------------------------------------------------------------===//
+// test_module
+//===----------------------------------------------------------------------===//
+
+typedef iree_status_t (*call_i32_i32_t)(iree_vm_stack_t* stack,
+                                        void* module_ptr, void* module_state,
+                                        int32_t arg0, int32_t* out_ret0);
+
+static iree_status_t call_shim_i32_i32(iree_vm_stack_t* stack,
+                                       const iree_vm_function_call_t* call,
+                                       call_i32_i32_t target_fn, void* module,
+                                       void* module_state,
+                                       iree_vm_execution_result_t* out_result) {
+  const int32_t* args = (const int32_t*)call->arguments.data;
+  int32_t* results = (int32_t*)call->results.data;
+  return target_fn(stack, module, module_state, args[0], &results[0]);
+}
+
+// Waits on the test wait source and then returns arg0 + 1.
+static iree_status_t test_module_wait_add_1(iree_vm_stack_t* stack,
+                                            void* module, void* module_state,
+                                            int32_t arg0, int32_t* out_ret0) {
+  IREE_RETURN_IF_ERROR(
+      iree_vm_stack_wait(stack, test_wait_source(), iree_infinite_timeout()));
+  *out_ret0 = arg0 + 1;
+  return iree_ok_status();
+}
+
+static const iree_vm_native_export_descriptor_t test_module_exports_[] = {
+    {iree_make_cstring_view("wait_add_1"), iree_make_cstring_view("0i_i"), 0,
+     NULL},
+};
+static const iree_vm_native_function_ptr_t test_module_funcs_[] = {
+    {(iree_vm_native_function_shim_t)call_shim_i32_i32,
+     (iree_vm_native_function_target_t)test_module_wait_add_1},
+};
+static const iree_vm_native_module_descriptor_t test_module_descriptor_ = {
+    iree_make_cstring_view("test_module"),
+    0,
+    NULL,
+    IREE_ARRAYSIZE(test_module_exports_),
+    test_module_exports_,
+    IREE_ARRAYSIZE(test_module_funcs_),
+    test_module_funcs_,
+    0,
+    NULL,
+};
+
+//===----------------------------------------------------------------------===//
+// trampoline
+//===----------------------------------------------------------------------===//
+
+// A native module that forwards trampoline.call to its import while keeping
+// its own native frame on the stack. When the import suspends the frame stays
+// in place below the import frames and resuming the trampoline resumes the
+// import.
+
+// The function imported by the trampoline; resolved with the context.
+static iree_vm_function_t trampoline_target;
+
+static iree_status_t IREE_API_PTR trampoline_resolve_import(
+    void* self, iree_vm_module_state_t* module_state, iree_host_size_t ordinal,
+    const iree_vm_function_t* function,
+    const iree_vm_function_signature_t* signature) {
+  trampoline_target = *function;
+  return iree_ok_status();
+}
+
+// Leaves the trampoline frame unless the call into the target suspended.
+static iree_status_t trampoline_complete_call(iree_vm_stack_t* stack,
+                                              iree_status_t status) {
+  if (iree_status_is_deferred(status)) return status;
+  IREE_RETURN_IF_ERROR(status);
+  return iree_vm_stack_function_leave(stack);
+}
+
+static iree_status_t IREE_API_PTR trampoline_begin_call(
+    void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
+    iree_vm_execution_result_t* out_result) {
+  iree_vm_stack_frame_t* callee_frame = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_stack_function_enter(
+      stack, &call->function, IREE_VM_STACK_FRAME_NATIVE, /*frame_size=*/0,
+      /*frame_cleanup_fn=*/NULL, &callee_frame));
+  iree_vm_function_call_t target_call = *call;
+  target_call.function = trampoline_target;
+  iree_vm_module_t* target_module = trampoline_target.module;
+  return trampoline_complete_call(
+      stack, target_module->begin_call(target_module->self, stack,
+                                       &target_call, out_result));
+}
+
+static iree_status_t IREE_API_PTR trampoline_resume_call(
+    void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
+    iree_vm_execution_result_t* out_result) {
+  iree_vm_function_call_t target_call = *call;
+  target_call.function = trampoline_target;
+  iree_vm_module_t* target_module = trampoline_target.module;
+  return trampoline_complete_call(
+      stack, target_module->resume_call(target_module->self, stack,
+                                        &target_call, out_result));
+}
+
+static const iree_vm_native_import_descriptor_t trampoline_imports_[] = {
+    {iree_make_cstring_view("yielder.yield_twice")},
+};
+static const iree_vm_native_export_descriptor_t trampoline_exports_[] = {
+    {iree_make_cstring_view("call"), iree_make_cstring_view("0i_i"), 0, NULL},
+};
+static const iree_vm_native_module_descriptor_t trampoline_descriptor_ = {
+    iree_make_cstring_view("trampoline"),
+    IREE_ARRAYSIZE(trampoline_imports_),
+    trampoline_imports_,
+    IREE_ARRAYSIZE(trampoline_exports_),
+    trampoline_exports_,
+    0,
+    NULL,
+    0,
+    NULL,
+};
+
+//===----------------------------------------------------------------------===//
+// Tests
+//===----------------------------------------------------------------------===//
+
+class BytecodeInvocationTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    memset(&wait_state_, 0, sizeof(wait_state_));
+    test_wait_state = &wait_state_;
+
+    IREE_ASSERT_OK(
+        iree_vm_instance_create(iree_allocator_system(), &instance_));
+    iree_vm_module_t* modules[5] = {NULL};
+
+    iree_vm_module_t interface;
+    IREE_ASSERT_OK(iree_vm_module_initialize(&interface, NULL));
+    IREE_ASSERT_OK(iree_vm_native_module_create(
+        &interface, &test_module_descriptor_, iree_allocator_system(),
+        &modules[0]));
+
+    // middle.call(%i0) = test_module.wait_add_1(%i0)
+    uint32_t wait_add_1 =
+        middle_builder_.AddImport("test_module.wait_add_1", "0i_i");
+    BytecodeBuilder call(IREE_VM_BYTECODE_VERSION_LATEST);
+    call.Op(IREE_VM_OP_CORE_Call).U32(wait_add_1).List({0}).List({1});
+    call.Op(IREE_VM_OP_CORE_Return).List({1});
+    middle_builder_.AddFunction(call, /*i32_register_count=*/2,
+                                /*ref_register_count=*/0, "call", "0i_i");
+    IREE_ASSERT_OK(
+        middle_builder_.Build(iree_allocator_system(), &modules[1]));
+
+    // yielder.yield_twice(%i0) {
+    //   yield ^bb1
+    // ^bb1:
+    //   yield ^bb2
+    // ^bb2:
+    //   return %i0 + %i0
+    // }
+    BytecodeBuilder yield_twice(IREE_VM_BYTECODE_VERSION_LATEST);
+    yield_twice.Op(IREE_VM_OP_CORE_Yield);
+    size_t bb1_target_offset = yield_twice.offset();
+    yield_twice.U32(0).RemapList({});
+    yield_twice.PatchU32(bb1_target_offset, (uint32_t)yield_twice.offset());
+    yield_twice.Op(IREE_VM_OP_CORE_Yield);
+    size_t bb2_target_offset = yield_twice.offset();
+    yield_twice.U32(0).RemapList({});
+    yield_twice.PatchU32(bb2_target_offset, (uint32_t)yield_twice.offset());
+    yield_twice.Op(IREE_VM_OP_CORE_AddI32).Reg(0).Reg(0).Reg(1);
+    yield_twice.Op(IREE_VM_OP_CORE_Return).List({1});
+    yielder_builder_.AddFunction(yield_twice, /*i32_register_count=*/2,
+                                 /*ref_register_count=*/0, "yield_twice",
+                                 "0i_i");
+    IREE_ASSERT_OK(
+        yielder_builder_.Build(iree_allocator_system(), &modules[2]));
+
+    // outer.wait(%i0) = middle.call(%i0) + %i0
+    // outer.yield(%i0) = yielder.yield_twice(%i0) + %i0
+    uint32_t middle_call = outer_builder_.AddImport("middle.call", "0i_i");
+    uint32_t yielder_yield_twice =
+        outer_builder_.AddImport("yielder.yield_twice", "0i_i");
+    for (auto entry : {std::make_pair("wait", middle_call),
+                       std::make_pair("yield", yielder_yield_twice)}) {
+      BytecodeBuilder bytecode(IREE_VM_BYTECODE_VERSION_LATEST);
+      bytecode.Op(IREE_VM_OP_CORE_Call).U32(entry.second).List({0}).List({1});
+      bytecode.Op(IREE_VM_OP_CORE_AddI32).Reg(1).Reg(0).Reg(2);
+      bytecode.Op(IREE_VM_OP_CORE_Return).List({2});
+      outer_builder_.AddFunction(bytecode, /*i32_register_count=*/3,
+                                 /*ref_register_count=*/0, entry.first,
+                                 "0i_i");
+    }
+    IREE_ASSERT_OK(
+        outer_builder_.Build(iree_allocator_system(), &modules[3]));
+
+    IREE_ASSERT_OK(iree_vm_module_initialize(&interface, NULL));
+    interface.resolve_import = trampoline_resolve_import;
+    interface.begin_call = trampoline_begin_call;
+    interface.resume_call = trampoline_resume_call;
+    IREE_ASSERT_OK(iree_vm_native_module_create(
+        &interface, &trampoline_descriptor_, iree_allocator_system(),
+        &modules[4]));
+
+    IREE_ASSERT_OK(iree_vm_context_create_with_modules(
+        instance_, IREE_VM_CONTEXT_FLAG_NONE, modules,
+        IREE_ARRAYSIZE(modules), iree_allocator_system(), &context_));
+    for (iree_vm_module_t* module : modules) iree_vm_module_release(module);
+
+    IREE_ASSERT_OK(iree_vm_list_create(/*element_type=*/NULL, 1,
+                                       iree_allocator_system(), &inputs_));
+    iree_vm_value_t arg0 = iree_vm_value_make_i32(5);
+    IREE_ASSERT_OK(iree_vm_list_push_value(inputs_, &arg0));
+  }
+
+  void TearDown() override {
+    iree_vm_list_release(inputs_);
+    iree_vm_context_release(context_);
+    iree_vm_instance_release(instance_);
+    test_wait_state = NULL;
+  }
+
+  iree_vm_function_t ResolveFunction(const char* name) {
+    iree_vm_function_t function;
+    IREE_CHECK_OK(iree_vm_context_resolve_function(
+        context_, iree_make_cstring_view(name), &function));
+    return function;
+  }
+
+  iree_vm_invocation_t* CreateInvocation(const char* name) {
+    iree_vm_invocation_t* invocation = NULL;
+    IREE_CHECK_OK(iree_vm_invocation_create(
+        context_, ResolveFunction(name), IREE_VM_INVOCATION_FLAG_NONE,
+        /*policy=*/NULL, inputs_, iree_allocator_system(), &invocation));
+    return invocation;
+  }
+
+  // Resumes |invocation| until it completes and returns the number of times
+  // it suspended.
+  static int ResumeUntilComplete(iree_vm_invocation_t* invocation) {
+    int suspend_count = 0;
+    iree_status_t status = iree_ok_status();
+    while (iree_status_is_deferred(
+        status = iree_vm_invocation_resume(invocation, NULL, NULL))) {
+      ++suspend_count;
+    }
+    IREE_EXPECT_OK(status);
+    return suspend_count;
+  }
+
+  static int32_t GetResult(const iree_vm_list_t* outputs) {
+    iree_vm_value_t value;
+    IREE_CHECK_OK(iree_vm_list_get_value(outputs, 0, &value));
+    return value.i32;
+  }
+
+  // Synchronously invokes |name| and returns its result.
+  int32_t Invoke(const char* name) {
+    iree_vm_list_t* outputs = NULL;
+    IREE_CHECK_OK(iree_vm_list_create(/*element_type=*/NULL, 1,
+                                      iree_allocator_system(), &outputs));
+    IREE_EXPECT_OK(iree_vm_invoke(context_, ResolveFunction(name),
+                                  IREE_VM_INVOCATION_FLAG_NONE,
+                                  /*policy=*/NULL, inputs_, outputs,
+                                  iree_allocator_system()));
+    int32_t result = GetResult(outputs);
+    iree_vm_list_release(outputs);
+    return result;
+  }
+
+  test_wait_state_t wait_state_;
+  BytecodeModuleBuilder middle_builder_{"middle"};
+  BytecodeModuleBuilder yielder_builder_{"yielder"};
+  BytecodeModuleBuilder outer_builder_{"outer"};
+  iree_vm_instance_t* instance_ = NULL;
+  iree_vm_context_t* context_ = NULL;
+  iree_vm_list_t* inputs_ = NULL;
+};
+
+TEST_F(BytecodeInvocationTest, WaitInImport) {
+  iree_vm_invocation_t* invocation = CreateInvocation("middle.call");
+  EXPECT_EQ(IREE_STATUS_DEFERRED,
+            iree_status_consume_code(
+                iree_vm_invocation_resume(invocation, NULL, NULL)));
+  wait_state_.signaled = true;
+  IREE_EXPECT_OK(iree_vm_invocation_resume(invocation, NULL, NULL));
+  EXPECT_EQ(GetResult(iree_vm_invocation_output(invocation)), 6);
+  iree_vm_invocation_release(invocation);
+}
+
+TEST_F(BytecodeInvocationTest, WaitInBytecodeImport) {
+  // outer.wait -> middle.call -> test_module.wait_add_1: spurious resumes
+  // must suspend again with both bytecode frames still on the stack.
+  iree_vm_invocation_t* invocation = CreateInvocation("outer.wait");
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(IREE_STATUS_DEFERRED,
+              iree_status_consume_code(
+                  iree_vm_invocation_resume(invocation, NULL, NULL)));
+  }
+  wait_state_.signaled = true;
+  IREE_EXPECT_OK(iree_vm_invocation_resume(invocation, NULL, NULL));
+  EXPECT_EQ(GetResult(iree_vm_invocation_output(invocation)), 6 + 5);
+  iree_vm_invocation_release(invocation);
+}
+
+TEST_F(BytecodeInvocationTest, WaitInBytecodeImportManyInFlight) {
+  iree_vm_invocation_t* invocations[8];
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(invocations); ++i) {
+    invocations[i] = CreateInvocation("outer.wait");
+    EXPECT_EQ(IREE_STATUS_DEFERRED,
+              iree_status_consume_code(
+                  iree_vm_invocation_resume(invocations[i], NULL, NULL)));
+  }
+  wait_state_.signaled = true;
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(invocations); ++i) {
+    IREE_EXPECT_OK(iree_vm_invocation_resume(invocations[i], NULL, NULL));
+    EXPECT_EQ(GetResult(iree_vm_invocation_output(invocations[i])), 6 + 5);
+    iree_vm_invocation_release(invocations[i]);
+  }
+}
+
+TEST_F(BytecodeInvocationTest, AwaitWaitInBytecodeImport) {
+  wait_state_.signal_on_wait = true;
+  iree_vm_invocation_t* invocation = CreateInvocation("outer.wait");
+  IREE_EXPECT_OK(
+      iree_vm_invocation_await(invocation, IREE_TIME_INFINITE_FUTURE));
+  EXPECT_EQ(wait_state_.wait_count, 1);
+  EXPECT_EQ(GetResult(iree_vm_invocation_output(invocation)), 6 + 5);
+  iree_vm_invocation_release(invocation);
+}
+
+TEST_F(BytecodeInvocationTest, SynchronousInvokeWaitInBytecodeImport) {
+  wait_state_.signal_on_wait = true;
+  EXPECT_EQ(Invoke("outer.wait"), 6 + 5);
+  EXPECT_EQ(wait_state_.wait_count, 1);
+}
+
+TEST_F(BytecodeInvocationTest, YieldInBytecodeImport) {
+  // outer.yield -> yielder.yield_twice: each yield suspends with the yielder
+  // frame above the outer frame and resumes into the yielder.
+  iree_vm_invocation_t* invocation = CreateInvocation("outer.yield");
+  EXPECT_EQ(ResumeUntilComplete(invocation), 2);
+  EXPECT_EQ(GetResult(iree_vm_invocation_output(invocation)), 10 + 5);
+  iree_vm_invocation_release(invocation);
+}
+
+TEST_F(BytecodeInvocationTest, SynchronousInvokeYieldInBytecodeImport) {
+  EXPECT_EQ(Invoke("outer.yield"), 10 + 5);
+}
+
+TEST_F(BytecodeInvocationTest, YieldAboveNativeFrame) {
+  // trampoline.call -> yielder.yield_twice: the yielder suspends above the
+  // native trampoline frame, which must not be read as a bytecode frame when
+  // the yielder resumes.
+  iree_vm_invocation_t* invocation = CreateInvocation("trampoline.call");
+  EXPECT_EQ(ResumeUntilComplete(invocation), 2);
+  EXPECT_EQ(GetResult(iree_vm_invocation_output(invocation)), 10);
+  iree_vm_invocation_release(invocation);
+}
+
+TEST_F(BytecodeInvocationTest, SynchronousInvokeYieldAboveNativeFrame) {
+  EXPECT_EQ(Invoke("trampoline.call"), 10);
+}
+
+}  // namespace
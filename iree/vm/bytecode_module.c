@@ -23,6 +23,15 @@ static bool iree_vm_flatbuffer_strcmp(flatbuffers_string_t lhs,
   return x != 0 ? x : lhs_size < rhs.size ? -1 : lhs_size > rhs.size;
 }
 
+// Returns the encoding version of the module bytecode.
+// Modules that predate versioning have no version and use version 1.
+static uint32_t iree_vm_bytecode_module_bytecode_version(
+    iree_vm_BytecodeModuleDef_table_t module_def) {
+  uint32_t bytecode_version =
+      iree_vm_BytecodeModuleDef_bytecode_version(module_def);
+  return bytecode_version ? bytecode_version : IREE_VM_BYTECODE_VERSION_1;
+}
+
 // Resolves a type through either builtin rules or the ref registered types.
 static bool iree_vm_bytecode_module_resolve_type(
     iree_vm_TypeDef_table_t type_def, iree_vm_type_def_t* out_type) {
@@ -133,6 +142,14 @@ static iree_status_t iree_vm_bytecode_module_flatbuffer_verify(
                             "module missing name field");
   }
 
+  uint32_t bytecode_version =
+      iree_vm_bytecode_module_bytecode_version(module_def);
+  if (bytecode_version > IREE_VM_BYTECODE_VERSION_LATEST) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "bytecode version %u not supported (max %u)",
+                            bytecode_version, IREE_VM_BYTECODE_VERSION_LATEST);
+  }
+
   iree_vm_TypeDef_vec_t types = iree_vm_BytecodeModuleDef_types(module_def);
   for (size_t i = 0; i < iree_vm_TypeDef_vec_len(types); ++i) {
     iree_vm_TypeDef_table_t type_def = iree_vm_TypeDef_vec_at(types, i);
@@ -203,28 +220,162 @@ static iree_status_t iree_vm_bytecode_module_flatbuffer_verify(
     iree_vm_FunctionDescriptor_struct_t function_descriptor =
         iree_vm_FunctionDescriptor_vec_at(function_descriptors, i);
     if (function_descriptor->bytecode_offset < 0 ||
-        function_descriptor->bytecode_offset +
-                function_descriptor->bytecode_length >
-            flatbuffers_uint8_vec_len(bytecode_data)) {
+        function_descriptor->bytecode_length < 0 ||
+        function_descriptor->bytecode_offset >
+            flatbuffers_uint8_vec_len(bytecode_data) ||
+        function_descriptor->bytecode_length >
+            flatbuffers_uint8_vec_len(bytecode_data) -
+                function_descriptor->bytecode_offset) {
       return iree_make_status(
           IREE_STATUS_INVALID_ARGUMENT,
           "functions[%zu] descriptor bytecode span out of range (0 < %d < %zu)",
           i, function_descriptor->bytecode_offset,
           flatbuffers_uint8_vec_len(bytecode_data));
     }
-    if (function_descriptor->i32_register_count > IREE_I32_REGISTER_COUNT ||
+    if (function_descriptor->i32_register_count < 0 ||
+        function_descriptor->i32_register_count > IREE_I32_REGISTER_COUNT ||
+        function_descriptor->ref_register_count < 0 ||
         function_descriptor->ref_register_count > IREE_REF_REGISTER_COUNT) {
       return iree_make_status(
           IREE_STATUS_INVALID_ARGUMENT,
           "functions[%zu] descriptor register count out of range", i);
     }
+  }
 
-    // TODO(benvanik): run bytecode verifier on contents.
+  iree_vm_ModuleStateDef_table_t module_state_def =
+      iree_vm_BytecodeModuleDef_module_state(module_def);
+  if (module_state_def &&
+      (iree_vm_ModuleStateDef_global_bytes_capacity(module_state_def) < 0 ||
+       iree_vm_ModuleStateDef_global_ref_count(module_state_def) < 0)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "module state global counts out of range");
   }
 
   return iree_ok_status();
 }
 
+// Runs the bytecode verifier over all functions in the module.
+// Version 1 bytecode is transcoded to the latest version into |out_transcoded|
+// as part of verification; otherwise |out_transcoded| is left empty.
+// Must only be called after iree_vm_bytecode_module_flatbuffer_verify has
+// succeeded.
+static iree_status_t iree_vm_bytecode_module_prepare_bytecode(
+    iree_vm_BytecodeModuleDef_table_t module_def, iree_allocator_t allocator,
+    iree_vm_bytecode_transcoded_module_t* out_transcoded) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  memset(out_transcoded, 0, sizeof(*out_transcoded));
+
+  iree_vm_ImportFunctionDef_vec_t imported_functions =
+      iree_vm_BytecodeModuleDef_imported_functions(module_def);
+  iree_vm_ExportFunctionDef_vec_t exported_functions =
+      iree_vm_BytecodeModuleDef_exported_functions(module_def);
+  iree_vm_FunctionDescriptor_vec_t function_descriptors =
+      iree_vm_BytecodeModuleDef_function_descriptors(module_def);
+  flatbuffers_uint8_vec_t bytecode_data =
+      iree_vm_BytecodeModuleDef_bytecode_data(module_def);
+
+  iree_vm_bytecode_verifier_module_t verifier_module;
+  memset(&verifier_module, 0, sizeof(verifier_module));
+  verifier_module.type_count =
+      iree_vm_TypeDef_vec_len(iree_vm_BytecodeModuleDef_types(module_def));
+  iree_vm_ModuleStateDef_table_t module_state_def =
+      iree_vm_BytecodeModuleDef_module_state(module_def);
+  if (module_state_def) {
+    verifier_module.global_bytes_capacity =
+        iree_vm_ModuleStateDef_global_bytes_capacity(module_state_def);
+    verifier_module.global_ref_count =
+        iree_vm_ModuleStateDef_global_ref_count(module_state_def);
+  }
+  verifier_module.rodata_segment_count = iree_vm_RodataSegmentDef_vec_len(
+      iree_vm_BytecodeModuleDef_rodata_segments(module_def));
+  verifier_module.import_count =
+      iree_vm_ImportFunctionDef_vec_len(imported_functions);
+  verifier_module.function_count =
+      iree_vm_FunctionDescriptor_vec_len(function_descriptors);
+
+  // Functions and import calling conventions share a single allocation.
+  iree_vm_bytecode_verifier_function_t* functions = NULL;
+  iree_host_size_t total_size =
+      verifier_module.function_count * sizeof(*functions) +
+      verifier_module.import_count * sizeof(iree_string_view_t);
+  if (total_size > 0) {
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_allocator_malloc(allocator, total_size, (void**)&functions));
+  }
+  iree_string_view_t* import_cconvs =
+      (iree_string_view_t*)(functions + verifier_module.function_count);
+  verifier_module.functions = functions;
+  verifier_module.import_cconvs = import_cconvs;
+
+  for (iree_host_size_t i = 0; i < verifier_module.import_count; ++i) {
+    iree_vm_FunctionSignatureDef_table_t signature_def =
+        iree_vm_ImportFunctionDef_signature(
+            iree_vm_ImportFunctionDef_vec_at(imported_functions, i));
+    flatbuffers_string_t calling_convention =
+        signature_def
+            ? iree_vm_FunctionSignatureDef_calling_convention(signature_def)
+            : NULL;
+    import_cconvs[i] = iree_make_string_view(
+        calling_convention, flatbuffers_string_len(calling_convention));
+  }
+
+  for (iree_host_size_t i = 0; i < verifier_module.function_count; ++i) {
+    iree_vm_FunctionDescriptor_struct_t function_descriptor =
+        iree_vm_FunctionDescriptor_vec_at(function_descriptors, i);
+    functions[i].bytecode = iree_make_const_byte_span(
+        bytecode_data + function_descriptor->bytecode_offset,
+        function_descriptor->bytecode_length);
+    functions[i].i32_register_count = function_descriptor->i32_register_count;
+    functions[i].ref_register_count = function_descriptor->ref_register_count;
+    functions[i].cconv = iree_string_view_empty();
+  }
+
+  // Internal functions only have signatures when exported.
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0;
+       i < iree_vm_ExportFunctionDef_vec_len(exported_functions); ++i) {
+    iree_vm_ExportFunctionDef_table_t export_def =
+        iree_vm_ExportFunctionDef_vec_at(exported_functions, i);
+    iree_vm_FunctionSignatureDef_table_t signature_def =
+        iree_vm_ExportFunctionDef_signature(export_def);
+    flatbuffers_string_t calling_convention =
+        signature_def
+            ? iree_vm_FunctionSignatureDef_calling_convention(signature_def)
+            : NULL;
+    iree_string_view_t cconv = iree_make_string_view(
+        calling_convention, flatbuffers_string_len(calling_convention));
+    if (iree_string_view_is_empty(cconv)) continue;
+    iree_vm_bytecode_verifier_function_t* function =
+        &functions[iree_vm_ExportFunctionDef_internal_ordinal(export_def)];
+    if (!iree_string_view_is_empty(function->cconv) &&
+        !iree_string_view_equal(function->cconv, cconv)) {
+      status = iree_make_status(
+          IREE_STATUS_INVALID_ARGUMENT,
+          "exports[%zu] calling convention '%.*s' conflicts with '%.*s'", i,
+          (int)cconv.size, cconv.data, (int)function->cconv.size,
+          function->cconv.data);
+      break;
+    }
+    function->cconv = cconv;
+  }
+
+  if (iree_status_is_ok(status)) {
+    if (iree_vm_bytecode_module_bytecode_version(module_def) <
+        IREE_VM_BYTECODE_VERSION_LATEST) {
+      status = iree_vm_bytecode_transcode_module(&verifier_module, allocator,
+                                                 out_transcoded);
+    } else {
+#if IREE_VM_BYTECODE_VERIFICATION_ENABLE
+      status = iree_vm_bytecode_verify_module(&verifier_module, allocator);
+#endif  // IREE_VM_BYTECODE_VERIFICATION_ENABLE
+    }
+  }
+
+  iree_allocator_free(allocator, functions);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 static iree_status_t iree_vm_bytecode_map_internal_ordinal(
     iree_vm_bytecode_module_t* module, iree_vm_function_t function,
     uint16_t* out_ordinal,
@@ -266,6 +417,17 @@ static iree_status_t iree_vm_bytecode_map_internal_ordinal(
   return iree_ok_status();
 }
 
+// Frees |module| and its transcoded bytecode, if any.
+// The FlatBuffer data is not owned by the module until creation succeeds and
+// must be freed separately.
+static void iree_vm_bytecode_module_free(iree_vm_bytecode_module_t* module) {
+  iree_allocator_t allocator = module->allocator;
+  iree_allocator_free(allocator, module->transcoded_descriptors);
+  iree_vm_bytecode_transcoded_module_deinitialize(&module->transcoded,
+                                                  allocator);
+  iree_allocator_free(allocator, module);
+}
+
 static void iree_vm_bytecode_module_destroy(void* self) {
   iree_vm_bytecode_module_t* module = (iree_vm_bytecode_module_t*)self;
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -275,7 +437,7 @@ static void iree_vm_bytecode_module_destroy(void* self) {
   module->flatbuffer_data = iree_make_const_byte_span(NULL, 0);
   module->flatbuffer_allocator = iree_allocator_null();
 
-  iree_allocator_free(module->allocator, module);
+  iree_vm_bytecode_module_free(module);
 
   IREE_TRACE_ZONE_END(z0);
 }
@@ -616,9 +778,16 @@ static iree_status_t iree_vm_bytecode_module_resolve_source_location(
 
   // The source location stores the source map and PC and will perform the
   // actual lookup within the source map on demand.
+  // Transcoded functions are mapped back to pcs in the original bytecode that
+  // the source map was produced against.
   out_source_location->self = (void*)debug_database_def;
   out_source_location->data[0] = (uint64_t)source_map_def;
   out_source_location->data[1] = (uint64_t)frame->pc;
+  if (module->transcoded.bytecode_data.data) {
+    out_source_location->data[1] =
+        (uint64_t)iree_vm_bytecode_transcoded_module_map_pc(
+            &module->transcoded, ordinal, (iree_host_size_t)frame->pc);
+  }
   out_source_location->format = iree_vm_bytecode_module_source_location_format;
   return iree_ok_status();
 }
@@ -793,24 +962,17 @@ static iree_status_t IREE_API_PTR iree_vm_bytecode_module_notify(
   return iree_ok_status();
 }
 
-static iree_status_t iree_vm_bytecode_module_begin_call(
-    void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
-    iree_vm_execution_result_t* out_result) {
-  // NOTE: any work here adds directly to the invocation time. Avoid doing too
-  // much work or touching too many unlikely-to-be-cached structures (such as
-  // walking the FlatBuffer, which may cause page faults).
-  IREE_TRACE_ZONE_BEGIN(z0);
-  IREE_ASSERT_ARGUMENT(out_result);
-  memset(out_result, 0, sizeof(iree_vm_execution_result_t));
-
+// Returns the calling convention fragments of the function being called.
+static iree_status_t iree_vm_bytecode_module_get_call_cconv(
+    iree_vm_bytecode_module_t* module, const iree_vm_function_call_t* call,
+    iree_string_view_t* out_cconv_arguments,
+    iree_string_view_t* out_cconv_results) {
   // Map the (potentially) export ordinal into the internal function ordinal in
   // the function descriptor table.
-  iree_vm_bytecode_module_t* module = (iree_vm_bytecode_module_t*)self;
   uint16_t ordinal = 0;
   iree_vm_FunctionSignatureDef_table_t signature_def = NULL;
-  IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, iree_vm_bytecode_map_internal_ordinal(module, call->function,
-                                                &ordinal, &signature_def));
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_map_internal_ordinal(
+      module, call->function, &ordinal, &signature_def));
 
   // Grab calling convention string. This is not great as we are guaranteed to
   // have a bunch of cache misses, but without putting it on the descriptor
@@ -830,20 +992,58 @@ static iree_status_t iree_vm_bytecode_module_begin_call(
   signature.calling_convention.data = calling_convention;
   signature.calling_convention.size =
       flatbuffers_string_len(calling_convention);
+  *out_cconv_arguments = iree_string_view_empty();
+  *out_cconv_results = iree_string_view_empty();
+  return iree_vm_function_call_get_cconv_fragments(
+      &signature, out_cconv_arguments, out_cconv_results);
+}
+
+static iree_status_t iree_vm_bytecode_module_begin_call(
+    void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
+    iree_vm_execution_result_t* out_result) {
+  // NOTE: any work here adds directly to the invocation time. Avoid doing too
+  // much work or touching too many unlikely-to-be-cached structures (such as
+  // walking the FlatBuffer, which may cause page faults).
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_ASSERT_ARGUMENT(out_result);
+  memset(out_result, 0, sizeof(iree_vm_execution_result_t));
+
+  iree_vm_bytecode_module_t* module = (iree_vm_bytecode_module_t*)self;
   iree_string_view_t cconv_arguments = iree_string_view_empty();
   iree_string_view_t cconv_results = iree_string_view_empty();
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, iree_vm_function_call_get_cconv_fragments(
-              &signature, &cconv_arguments, &cconv_results));
+      z0, iree_vm_bytecode_module_get_call_cconv(module, call, &cconv_arguments,
+                                                 &cconv_results));
 
   // Jump into the dispatch routine to execute bytecode until the function
   // either returns (synchronous) or yields (asynchronous).
-  iree_status_t status = iree_vm_bytecode_dispatch(
+  iree_status_t status = iree_vm_bytecode_dispatch_begin(
       stack, module, call, cconv_arguments, cconv_results, out_result);
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
 
+static iree_status_t iree_vm_bytecode_module_resume_call(
+    void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
+    iree_vm_execution_result_t* out_result) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_ASSERT_ARGUMENT(out_result);
+  memset(out_result, 0, sizeof(iree_vm_execution_result_t));
+
+  iree_vm_bytecode_module_t* module = (iree_vm_bytecode_module_t*)self;
+  iree_string_view_t cconv_arguments = iree_string_view_empty();
+  iree_string_view_t cconv_results = iree_string_view_empty();
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_bytecode_module_get_call_cconv(module, call, &cconv_arguments,
+                                                 &cconv_results));
+
+  // Continue executing from where the yield left off in the current frame.
+  iree_status_t status = iree_vm_bytecode_dispatch_resume(
+      stack, module, call, cconv_results, out_result);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
     iree_const_byte_span_t flatbuffer_data,
     iree_allocator_t flatbuffer_allocator, iree_allocator_t allocator,
@@ -872,15 +1072,35 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
         "'" iree_vm_BytecodeModuleDef_file_identifier "' not found");
   }
 
+  // Older bytecode versions are always verified as they must be transcoded.
+  // Verified modules are dispatched without per-op range checks while others
+  // use the checked dispatch variant.
+  const bool verified = IREE_VM_BYTECODE_VERIFICATION_ENABLE ||
+                        iree_vm_bytecode_module_bytecode_version(module_def) <
+                            IREE_VM_BYTECODE_VERSION_LATEST;
+  iree_vm_bytecode_transcoded_module_t transcoded;
+  memset(&transcoded, 0, sizeof(transcoded));
+  if (verified) {
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_vm_bytecode_module_prepare_bytecode(module_def, allocator,
+                                                     &transcoded));
+  }
+
   iree_vm_TypeDef_vec_t type_defs = iree_vm_BytecodeModuleDef_types(module_def);
   size_t type_table_size =
       iree_vm_TypeDef_vec_len(type_defs) * sizeof(iree_vm_type_def_t);
 
   iree_vm_bytecode_module_t* module = NULL;
-  IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, iree_allocator_malloc(allocator, sizeof(*module) + type_table_size,
-                                (void**)&module));
+  status = iree_allocator_malloc(allocator, sizeof(*module) + type_table_size,
+                                 (void**)&module);
+  if (!iree_status_is_ok(status)) {
+    iree_vm_bytecode_transcoded_module_deinitialize(&transcoded, allocator);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
   module->allocator = allocator;
+  module->transcoded = transcoded;
+  module->verified = verified;
 
   iree_vm_FunctionDescriptor_vec_t function_descriptors =
       iree_vm_BytecodeModuleDef_function_descriptors(module_def);
@@ -893,6 +1113,34 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
   module->bytecode_data = iree_make_const_byte_span(
       bytecode_data, flatbuffers_uint8_vec_len(bytecode_data));
 
+  // Transcoded functions are dispatched from the transcoded bytecode and
+  // require descriptors with their new locations.
+  if (transcoded.bytecode_data.data && module->function_descriptor_count > 0) {
+    status = iree_allocator_malloc(
+        allocator,
+        module->function_descriptor_count *
+            sizeof(*module->transcoded_descriptors),
+        (void**)&module->transcoded_descriptors);
+    if (!iree_status_is_ok(status)) {
+      iree_vm_bytecode_module_free(module);
+      IREE_TRACE_ZONE_END(z0);
+      return status;
+    }
+    for (iree_host_size_t i = 0; i < module->function_descriptor_count; ++i) {
+      iree_vm_FunctionDescriptor_t* descriptor =
+          &module->transcoded_descriptors[i];
+      *descriptor = *iree_vm_FunctionDescriptor_vec_at(function_descriptors, i);
+      descriptor->bytecode_offset =
+          (int32_t)transcoded.functions[i].bytecode_offset;
+      descriptor->bytecode_length =
+          (int32_t)transcoded.functions[i].bytecode_length;
+    }
+    module->function_descriptor_table = module->transcoded_descriptors;
+    module->bytecode_data =
+        iree_make_const_byte_span(transcoded.bytecode_data.data,
+                                  transcoded.bytecode_data.data_length);
+  }
+
   module->flatbuffer_data = flatbuffer_data;
   module->flatbuffer_allocator = flatbuffer_allocator;
   module->def = module_def;
@@ -901,7 +1149,7 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
   iree_status_t resolve_status =
       iree_vm_bytecode_module_resolve_types(type_defs, module->type_table);
   if (!iree_status_is_ok(resolve_status)) {
-    iree_allocator_free(allocator, module);
+    iree_vm_bytecode_module_free(module);
     IREE_TRACE_ZONE_END(z0);
     return resolve_status;
   }
@@ -921,6 +1169,7 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
   module->interface.resolve_import = iree_vm_bytecode_module_resolve_import;
   module->interface.notify = iree_vm_bytecode_module_notify;
   module->interface.begin_call = iree_vm_bytecode_module_begin_call;
+  module->interface.resume_call = iree_vm_bytecode_module_resume_call;
   module->interface.get_function_reflection_attr =
       iree_vm_bytecode_module_get_function_reflection_attr;
 
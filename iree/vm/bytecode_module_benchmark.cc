@@ -13,6 +13,7 @@
 #include "iree/vm/api.h"
 #include "iree/vm/bytecode_module.h"
 #include "iree/vm/bytecode_module_benchmark_module_c.h"
+#include "iree/vm/bytecode_module_benchmark_unfused_module_c.h"
 
 namespace {
 
@@ -66,10 +67,11 @@ static iree_status_t native_import_module_create(
 }
 
 // Benchmarks the given exported function, optionally passing in arguments.
-static iree_status_t RunFunction(benchmark::State& state,
-                                 iree_string_view_t function_name,
-                                 std::vector<int32_t> i32_args,
-                                 int result_count, int64_t batch_size = 1) {
+// |module_file_toc| defaults to the module compiled with superinstructions.
+static iree_status_t RunFunction(
+    benchmark::State& state, iree_string_view_t function_name,
+    std::vector<int32_t> i32_args, int result_count, int64_t batch_size = 1,
+    const iree_file_toc_t* module_file_toc = nullptr) {
   iree_vm_instance_t* instance = NULL;
   IREE_CHECK_OK(iree_vm_instance_create(iree_allocator_system(), &instance));
 
@@ -77,8 +79,9 @@ static iree_status_t RunFunction(benchmark::State& state,
   IREE_CHECK_OK(
       native_import_module_create(iree_allocator_system(), &import_module));
 
-  const auto* module_file_toc =
-      iree_vm_bytecode_module_benchmark_module_create();
+  if (!module_file_toc) {
+    module_file_toc = iree_vm_bytecode_module_benchmark_module_create();
+  }
   iree_vm_module_t* bytecode_module = nullptr;
   IREE_CHECK_OK(iree_vm_bytecode_module_create(
       iree_const_byte_span_t{
@@ -128,6 +131,41 @@ static iree_status_t RunFunction(benchmark::State& state,
   return iree_ok_status();
 }
 
+// Creates a context with the benchmark module and its imports.
+static void CreateContext(iree_vm_instance_t** out_instance,
+                          iree_vm_context_t** out_context) {
+  IREE_CHECK_OK(iree_vm_instance_create(iree_allocator_system(), out_instance));
+
+  iree_vm_module_t* import_module = NULL;
+  IREE_CHECK_OK(
+      native_import_module_create(iree_allocator_system(), &import_module));
+
+  const auto* module_file_toc =
+      iree_vm_bytecode_module_benchmark_module_create();
+  iree_vm_module_t* bytecode_module = nullptr;
+  IREE_CHECK_OK(iree_vm_bytecode_module_create(
+      iree_const_byte_span_t{
+          reinterpret_cast<const uint8_t*>(module_file_toc->data),
+          module_file_toc->size},
+      iree_allocator_null(), iree_allocator_system(), &bytecode_module));
+
+  std::array<iree_vm_module_t*, 2> modules = {import_module, bytecode_module};
+  IREE_CHECK_OK(iree_vm_context_create_with_modules(
+      *out_instance, IREE_VM_CONTEXT_FLAG_NONE, modules.data(), modules.size(),
+      iree_allocator_system(), out_context));
+  iree_vm_module_release(import_module);
+  iree_vm_module_release(bytecode_module);
+}
+
+// Populates |inputs| with the (i32, !vm.buffer) arguments of @passthrough.
+static void PushPassthroughInputs(iree_vm_list_t* inputs,
+                                  iree_vm_buffer_t* buffer) {
+  iree_vm_value_t arg0 = iree_vm_value_make_i32(100);
+  IREE_CHECK_OK(iree_vm_list_push_value(inputs, &arg0));
+  iree_vm_ref_t arg1 = iree_vm_buffer_retain_ref(buffer);
+  IREE_CHECK_OK(iree_vm_list_push_ref_move(inputs, &arg1));
+}
+
 static void BM_ModuleCreate(benchmark::State& state) {
   while (state.KeepRunning()) {
     const auto* module_file_toc =
@@ -298,6 +336,59 @@ static void BM_LoopSumBytecode(benchmark::State& state) {
 }
 BENCHMARK(BM_LoopSumBytecode)->Arg(100000);
 
+// The same loop compiled without superinstructions: 3 ops are dispatched per
+// iteration instead of 2.
+static void BM_LoopSumBytecodeUnfused(benchmark::State& state) {
+  IREE_CHECK_OK(RunFunction(
+      state, iree_make_cstring_view("bytecode_module_benchmark.loop_sum"),
+      {static_cast<int32_t>(state.range(0))},
+      /*result_count=*/1,
+      /*batch_size=*/state.range(0),
+      iree_vm_bytecode_module_benchmark_unfused_module_create()));
+}
+BENCHMARK(BM_LoopSumBytecodeUnfused)->Arg(100000);
+
+static void BM_LoopBranchesReference(benchmark::State& state) {
+  static auto work = +[](int i, int sum) {
+    benchmark::DoNotOptimize(i);
+    return (i & 1) == 0 ? sum + 3 : sum - 1;
+  };
+  static auto loop = +[](int count) {
+    int sum = 0;
+    for (int i = 0; i < count; ++i) {
+      benchmark::DoNotOptimize(sum = work(i, sum));
+    }
+    return sum;
+  };
+  while (state.KeepRunningBatch(state.range(0))) {
+    int ret = loop(static_cast<int>(state.range(0)));
+    benchmark::DoNotOptimize(ret);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_LoopBranchesReference)->Arg(100000);
+
+static void BM_LoopBranchesBytecode(benchmark::State& state) {
+  IREE_CHECK_OK(RunFunction(
+      state, iree_make_cstring_view("bytecode_module_benchmark.loop_branches"),
+      {static_cast<int32_t>(state.range(0))},
+      /*result_count=*/1,
+      /*batch_size=*/state.range(0)));
+}
+BENCHMARK(BM_LoopBranchesBytecode)->Arg(100000);
+
+// The same loop compiled without superinstructions: 8 ops are dispatched per
+// iteration instead of 6.
+static void BM_LoopBranchesBytecodeUnfused(benchmark::State& state) {
+  IREE_CHECK_OK(RunFunction(
+      state, iree_make_cstring_view("bytecode_module_benchmark.loop_branches"),
+      {static_cast<int32_t>(state.range(0))},
+      /*result_count=*/1,
+      /*batch_size=*/state.range(0),
+      iree_vm_bytecode_module_benchmark_unfused_module_create()));
+}
+BENCHMARK(BM_LoopBranchesBytecodeUnfused)->Arg(100000);
+
 static void BM_BufferReduceReference(benchmark::State& state) {
   static auto work = +[](int32_t* buffer, int i, int sum) {
     int new_sum = buffer[i] + sum;
@@ -345,4 +436,123 @@ static void BM_BufferReduceBytecodeUnrolled(benchmark::State& state) {
 }
 BENCHMARK(BM_BufferReduceBytecodeUnrolled)->Arg(100000);
 
+//===----------------------------------------------------------------------===//
+// Invocation overhead
+//===----------------------------------------------------------------------===//
+// These measure the per-call cost of the public invocation APIs (as opposed to
+// the begin_call used above) when passing a value and a ref in and out of a
+// trivial function. Only the last case should avoid allocating per call.
+
+// Creates fresh input and output lists for every call as most callers do.
+static void BM_InvokeAllocatingLists(benchmark::State& state) {
+  iree_vm_instance_t* instance = NULL;
+  iree_vm_context_t* context = NULL;
+  CreateContext(&instance, &context);
+  iree_vm_function_t function;
+  IREE_CHECK_OK(iree_vm_context_resolve_function(
+      context, iree_make_cstring_view("bytecode_module_benchmark.passthrough"),
+      &function));
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_CHECK_OK(iree_vm_buffer_create(IREE_VM_BUFFER_ACCESS_MUTABLE, 16,
+                                      iree_allocator_system(), &buffer));
+
+  while (state.KeepRunning()) {
+    iree_vm_list_t* inputs = NULL;
+    IREE_CHECK_OK(iree_vm_list_create(/*element_type=*/NULL, 2,
+                                      iree_allocator_system(), &inputs));
+    PushPassthroughInputs(inputs, buffer);
+    iree_vm_list_t* outputs = NULL;
+    IREE_CHECK_OK(iree_vm_list_create(/*element_type=*/NULL, 2,
+                                      iree_allocator_system(), &outputs));
+    IREE_CHECK_OK(iree_vm_invoke(context, function,
+                                 IREE_VM_INVOCATION_FLAG_NONE,
+                                 /*policy=*/NULL, inputs, outputs,
+                                 iree_allocator_system()));
+    benchmark::DoNotOptimize(outputs);
+    iree_vm_list_release(outputs);
+    iree_vm_list_release(inputs);
+  }
+
+  iree_vm_buffer_release(buffer);
+  iree_vm_context_release(context);
+  iree_vm_instance_release(instance);
+}
+BENCHMARK(BM_InvokeAllocatingLists);
+
+// Reuses the input and output lists but still allocates the stack per call.
+static void BM_InvokeReusedLists(benchmark::State& state) {
+  iree_vm_instance_t* instance = NULL;
+  iree_vm_context_t* context = NULL;
+  CreateContext(&instance, &context);
+  iree_vm_function_t function;
+  IREE_CHECK_OK(iree_vm_context_resolve_function(
+      context, iree_make_cstring_view("bytecode_module_benchmark.passthrough"),
+      &function));
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_CHECK_OK(iree_vm_buffer_create(IREE_VM_BUFFER_ACCESS_MUTABLE, 16,
+                                      iree_allocator_system(), &buffer));
+  iree_vm_list_t* inputs = NULL;
+  IREE_CHECK_OK(iree_vm_list_create(/*element_type=*/NULL, 2,
+                                    iree_allocator_system(), &inputs));
+  PushPassthroughInputs(inputs, buffer);
+  iree_vm_list_t* outputs = NULL;
+  IREE_CHECK_OK(iree_vm_list_create(/*element_type=*/NULL, 2,
+                                    iree_allocator_system(), &outputs));
+
+  while (state.KeepRunning()) {
+    IREE_CHECK_OK(iree_vm_list_resize(outputs, 0));
+    IREE_CHECK_OK(iree_vm_invoke(context, function,
+                                 IREE_VM_INVOCATION_FLAG_NONE,
+                                 /*policy=*/NULL, inputs, outputs,
+                                 iree_allocator_system()));
+    benchmark::DoNotOptimize(outputs);
+  }
+
+  iree_vm_list_release(outputs);
+  iree_vm_list_release(inputs);
+  iree_vm_buffer_release(buffer);
+  iree_vm_context_release(context);
+  iree_vm_instance_release(instance);
+}
+BENCHMARK(BM_InvokeReusedLists);
+
+// Resets a single invocation per call; only the refs are retained/released.
+static void BM_InvocationReset(benchmark::State& state) {
+  iree_vm_instance_t* instance = NULL;
+  iree_vm_context_t* context = NULL;
+  CreateContext(&instance, &context);
+  iree_vm_function_t function;
+  IREE_CHECK_OK(iree_vm_context_resolve_function(
+      context, iree_make_cstring_view("bytecode_module_benchmark.passthrough"),
+      &function));
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_CHECK_OK(iree_vm_buffer_create(IREE_VM_BUFFER_ACCESS_MUTABLE, 16,
+                                      iree_allocator_system(), &buffer));
+  iree_vm_list_t* inputs = NULL;
+  IREE_CHECK_OK(iree_vm_list_create(/*element_type=*/NULL, 2,
+                                    iree_allocator_system(), &inputs));
+  PushPassthroughInputs(inputs, buffer);
+
+  iree_vm_invocation_t* invocation = NULL;
+  IREE_CHECK_OK(iree_vm_invocation_create(
+      context, function, IREE_VM_INVOCATION_FLAG_NONE, /*policy=*/NULL, inputs,
+      iree_allocator_system(), &invocation));
+  IREE_CHECK_OK(
+      iree_vm_invocation_await(invocation, IREE_TIME_INFINITE_FUTURE));
+
+  while (state.KeepRunning()) {
+    IREE_CHECK_OK(iree_vm_invocation_reset(invocation, inputs));
+    IREE_CHECK_OK(
+        iree_vm_invocation_await(invocation, IREE_TIME_INFINITE_FUTURE));
+    benchmark::DoNotOptimize(iree_vm_invocation_output(invocation));
+  }
+
+  iree_vm_invocation_release(invocation);
+  iree_vm_list_release(inputs);
+  iree_vm_buffer_release(buffer);
+  iree_vm_context_release(context);
+  iree_vm_instance_release(instance);
+}
+BENCHMARK(BM_InvocationReset);
+
 }  // namespace
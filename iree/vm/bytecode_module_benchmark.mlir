@@ -5,6 +5,12 @@ vm.module @bytecode_module_benchmark {
     vm.return
   }
 
+  // Measures the overhead of marshaling values and refs in and out of a call.
+  vm.export @passthrough
+  vm.func @passthrough(%arg0 : i32, %arg1 : !vm.buffer) -> (i32, !vm.buffer) {
+    vm.return %arg0, %arg1 : i32, !vm.buffer
+  }
+
   // Measures the cost of a call an internal function.
   vm.func @internal_func(%arg0 : i32) -> i32 attributes {noinline} {
     vm.return %arg0 : i32
@@ -77,6 +83,34 @@ vm.module @bytecode_module_benchmark {
     vm.return %ie : i32
   }
 
+  // Measures the cost of a loop made of the op sequences that are fused into
+  // superinstructions: comparisons feeding conditional branches and additions
+  // and subtractions of constants. bytecode_module_benchmark_unfused compiles
+  // this module with the fusion disabled for comparison.
+  vm.export @loop_branches
+  vm.func @loop_branches(%count : i32) -> i32 {
+    %c0 = vm.const.i32.zero : i32
+    %c1 = vm.const.i32 1 : i32
+    %c3 = vm.const.i32 3 : i32
+    vm.br ^loop(%c0, %c0 : i32, i32)
+  ^loop(%i : i32, %sum : i32):
+    %bit = vm.and.i32 %i, %c1 : i32
+    %is_even = vm.cmp.eq.i32 %bit, %c0 : i32
+    vm.cond_br %is_even, ^even, ^odd
+  ^even:
+    %sum_even = vm.add.i32 %sum, %c3 : i32
+    vm.br ^next(%sum_even : i32)
+  ^odd:
+    %sum_odd = vm.sub.i32 %sum, %c1 : i32
+    vm.br ^next(%sum_odd : i32)
+  ^next(%new_sum : i32):
+    %in = vm.add.i32 %i, %c1 : i32
+    %cmp = vm.cmp.lt.i32.s %in, %count : i32
+    vm.cond_br %cmp, ^loop(%in, %new_sum : i32, i32), ^loop_exit(%new_sum : i32)
+  ^loop_exit(%result : i32):
+    vm.return %result : i32
+  }
+
   // Measures the cost of lots of buffer loads.
   vm.export @buffer_reduce
   vm.func @buffer_reduce(%count : i32) -> i32 {
@@ -17,6 +17,7 @@
 
 #include "iree/base/api.h"
 #include "iree/vm/api.h"
+#include "iree/vm/bytecode_verifier.h"
 
 // NOTE: include order matters:
 #include "iree/base/internal/flatcc/parsing.h"
@@ -30,17 +31,6 @@ extern "C" {
 #define VMMAX(a, b) (((a) > (b)) ? (a) : (b))
 #define VMMIN(a, b) (((a) < (b)) ? (a) : (b))
 
-// Maximum register count per bank.
-// This determines the bits required to reference registers in the VM bytecode.
-#define IREE_I32_REGISTER_COUNT 0x7FFF
-#define IREE_REF_REGISTER_COUNT 0x7FFF
-
-#define IREE_I32_REGISTER_MASK 0x7FFF
-
-#define IREE_REF_REGISTER_TYPE_BIT 0x8000
-#define IREE_REF_REGISTER_MOVE_BIT 0x4000
-#define IREE_REF_REGISTER_MASK 0x3FFF
-
 // A loaded bytecode module.
 typedef struct iree_vm_bytecode_module_t {
   // Interface routing to the bytecode module functions.
@@ -57,6 +47,17 @@ typedef struct iree_vm_bytecode_module_t {
   // A pointer to the bytecode data embedded within the module.
   iree_const_byte_span_t bytecode_data;
 
+  // Version 1 bytecode transcoded to the latest version when loaded.
+  // When present |bytecode_data| and |function_descriptor_table| reference the
+  // transcoded functions and pcs must be mapped back to the original bytecode
+  // to query the debug database.
+  iree_vm_bytecode_transcoded_module_t transcoded;
+  iree_vm_FunctionDescriptor_t* transcoded_descriptors;
+
+  // True if |bytecode_data| was verified (or transcoded) when loaded and can be
+  // dispatched without the runtime checks required for untrusted bytecode.
+  bool verified;
+
   // Allocator this module was allocated with and must be freed with.
   iree_allocator_t allocator;
 
@@ -120,15 +121,21 @@ typedef struct iree_vm_bytecode_module_state_t {
   iree_allocator_t allocator;
 } iree_vm_bytecode_module_state_t;
 
-// Begins (or resumes) execution of the current frame and continues until
-// either a yield or return. |out_result| will contain the result status for
-// continuation, if needed.
-iree_status_t iree_vm_bytecode_dispatch(iree_vm_stack_t* stack,
-                                        iree_vm_bytecode_module_t* module,
-                                        const iree_vm_function_call_t* call,
-                                        iree_string_view_t cconv_arguments,
-                                        iree_string_view_t cconv_results,
-                                        iree_vm_execution_result_t* out_result);
+// Begins execution of |call| and continues until either a yield or return.
+// |out_result| will contain the result status for continuation, if needed.
+// Returns IREE_STATUS_DEFERRED if execution yielded and must be resumed with
+// iree_vm_bytecode_dispatch_resume.
+iree_status_t iree_vm_bytecode_dispatch_begin(
+    iree_vm_stack_t* stack, iree_vm_bytecode_module_t* module,
+    const iree_vm_function_call_t* call, iree_string_view_t cconv_arguments,
+    iree_string_view_t cconv_results, iree_vm_execution_result_t* out_result);
+
+// Resumes execution of a yielded |call| from the current frame of |stack| and
+// continues until either another yield or return.
+iree_status_t iree_vm_bytecode_dispatch_resume(
+    iree_vm_stack_t* stack, iree_vm_bytecode_module_t* module,
+    const iree_vm_function_call_t* call, iree_string_view_t cconv_results,
+    iree_vm_execution_result_t* out_result);
 
 #ifdef __cplusplus
 }  // extern "C"
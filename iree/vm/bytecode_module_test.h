@@ -0,0 +1,241 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_VM_BYTECODE_MODULE_TEST_H_
+#define IREE_VM_BYTECODE_MODULE_TEST_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/vm/bytecode_module.h"
+#include "iree/vm/bytecode_verifier.h"
+#include "iree/vm/generated/bytecode_op_table.h"
+#include "iree/vm/module.h"
+
+// NOTE: include order matters:
+#include "iree/base/internal/flatcc/building.h"
+#include "iree/schemas/bytecode_module_def_builder.h"
+
+// Serializes bytecode in the same form the compiler emits for |version|.
+class BytecodeBuilder {
+ public:
+  explicit BytecodeBuilder(int version = IREE_VM_BYTECODE_VERSION_LATEST)
+      : version_(version) {}
+
+  size_t offset() const { return data_.size(); }
+  const std::vector<uint8_t>& data() const { return data_; }
+
+  BytecodeBuilder& Op(uint8_t opcode) { return U8(opcode); }
+  BytecodeBuilder& U8(uint8_t value) {
+    data_.push_back(value);
+    return *this;
+  }
+  BytecodeBuilder& U16(uint16_t value) {
+    U8(value & 0xFF);
+    return U8(value >> 8);
+  }
+  BytecodeBuilder& U32(uint32_t value) {
+    U16(value & 0xFFFF);
+    return U16(value >> 16);
+  }
+  BytecodeBuilder& Reg(uint16_t ordinal) { return U16(ordinal); }
+  BytecodeBuilder& RefReg(uint16_t ordinal) {
+    return U16(ordinal | IREE_REF_REGISTER_TYPE_BIT);
+  }
+  // Primitive array attribute such as the segment sizes of variadic calls.
+  BytecodeBuilder& Array(std::vector<uint16_t> values) {
+    if (data_.size() % 2) U8(0);
+    U16(static_cast<uint16_t>(values.size()));
+    for (uint16_t value : values) U16(value);
+    return *this;
+  }
+  // Register list of operands/results.
+  BytecodeBuilder& List(std::vector<uint16_t> registers) {
+    return BankedList(registers, 1);
+  }
+  // Branch remapping list of interleaved src-dst register pairs.
+  BytecodeBuilder& RemapList(std::vector<uint16_t> pairs) {
+    return BankedList(pairs, 2);
+  }
+  BytecodeBuilder& Pad() {
+    while (data_.size() % 8) U8(0);
+    return *this;
+  }
+
+  // Overwrites the 32-bit value at |offset|, such as a forward branch target.
+  void PatchU32(size_t offset, uint32_t value) {
+    for (size_t i = 0; i < 4; ++i) {
+      data_[offset + i] = static_cast<uint8_t>(value >> (i * 8));
+    }
+  }
+
+ private:
+  BytecodeBuilder& BankedList(const std::vector<uint16_t>& values,
+                              size_t stride) {
+    if (data_.size() % 2) U8(0);
+    if (version_ == IREE_VM_BYTECODE_VERSION_1) {
+      U16(static_cast<uint16_t>(values.size() / stride));
+      for (uint16_t value : values) U16(value);
+      return *this;
+    }
+    // Partitioned by the bank of the first register of each entry.
+    std::vector<uint16_t> banks[2];
+    for (size_t i = 0; i < values.size(); i += stride) {
+      bool is_ref = (values[i] & IREE_REF_REGISTER_TYPE_BIT) != 0;
+      banks[is_ref].insert(banks[is_ref].end(), values.begin() + i,
+                           values.begin() + i + stride);
+    }
+    U16(static_cast<uint16_t>(banks[0].size() / stride));
+    U16(static_cast<uint16_t>(values.size() / stride));
+    for (const auto& bank : banks) {
+      for (uint16_t value : bank) U16(value);
+    }
+    return *this;
+  }
+
+  int version_;
+  std::vector<uint8_t> data_;
+};
+
+// Assembles a bytecode module FlatBuffer from hand-written functions.
+// The builder owns the serialized module and must outlive any modules it
+// creates.
+class BytecodeModuleBuilder {
+ public:
+  explicit BytecodeModuleBuilder(
+      const char* name, uint32_t version = IREE_VM_BYTECODE_VERSION_LATEST)
+      : name_(name), version_(version) {}
+
+  // Adds an import of |full_name| and returns the ordinal used to call it.
+  uint32_t AddImport(const char* full_name, const char* cconv) {
+    imports_.push_back({full_name, cconv, 0});
+    return 0x80000000u | static_cast<uint32_t>(imports_.size() - 1);
+  }
+
+  // Adds an internal function and returns its ordinal. If |export_name| is
+  // provided the function is exported with the calling convention |cconv|.
+  uint32_t AddFunction(const BytecodeBuilder& bytecode,
+                       uint16_t i32_register_count,
+                       uint16_t ref_register_count,
+                       const char* export_name = NULL,
+                       const char* cconv = NULL) {
+    functions_.push_back(
+        {bytecode.data(), i32_register_count, ref_register_count});
+    uint32_t ordinal = static_cast<uint32_t>(functions_.size() - 1);
+    if (export_name) exports_.push_back({export_name, cconv, ordinal});
+    return ordinal;
+  }
+
+  iree_status_t Build(iree_allocator_t allocator,
+                      iree_vm_module_t** out_module) {
+    flatcc_builder_t builder;
+    flatcc_builder_init(&builder);
+    flatcc_builder_t* fbb = &builder;
+    iree_vm_BytecodeModuleDef_start_as_root(fbb);
+
+    std::vector<iree_vm_ImportFunctionDef_ref_t> import_refs;
+    for (const auto& import : imports_) {
+      auto signature_ref = CreateSignature(fbb, import.cconv);
+      auto full_name_ref = flatbuffers_string_create_str(fbb, import.name);
+      iree_vm_ImportFunctionDef_start(fbb);
+      iree_vm_ImportFunctionDef_full_name_add(fbb, full_name_ref);
+      iree_vm_ImportFunctionDef_signature_add(fbb, signature_ref);
+      import_refs.push_back(iree_vm_ImportFunctionDef_end(fbb));
+    }
+    std::vector<iree_vm_ExportFunctionDef_ref_t> export_refs;
+    for (const auto& export_def : exports_) {
+      auto signature_ref = CreateSignature(fbb, export_def.cconv);
+      auto local_name_ref =
+          flatbuffers_string_create_str(fbb, export_def.name);
+      iree_vm_ExportFunctionDef_start(fbb);
+      iree_vm_ExportFunctionDef_local_name_add(fbb, local_name_ref);
+      iree_vm_ExportFunctionDef_signature_add(fbb, signature_ref);
+      iree_vm_ExportFunctionDef_internal_ordinal_add(
+          fbb, static_cast<int32_t>(export_def.ordinal));
+      export_refs.push_back(iree_vm_ExportFunctionDef_end(fbb));
+    }
+
+    // Functions are 8-byte aligned within the bytecode data as emitted by the
+    // compiler.
+    std::vector<uint8_t> bytecode_data;
+    std::vector<iree_vm_FunctionDescriptor_t> descriptors;
+    for (const auto& function : functions_) {
+      bytecode_data.resize(iree_host_align(bytecode_data.size(), 8));
+      iree_vm_FunctionDescriptor_t descriptor;
+      descriptor.bytecode_offset = static_cast<int32_t>(bytecode_data.size());
+      descriptor.bytecode_length =
+          static_cast<int32_t>(function.bytecode.size());
+      descriptor.i32_register_count = function.i32_register_count;
+      descriptor.ref_register_count = function.ref_register_count;
+      descriptors.push_back(descriptor);
+      bytecode_data.insert(bytecode_data.end(), function.bytecode.begin(),
+                           function.bytecode.end());
+    }
+    bytecode_data.resize(iree_host_align(bytecode_data.size(), 8));
+
+    auto name_ref = flatbuffers_string_create_str(fbb, name_);
+    auto imports_ref = iree_vm_ImportFunctionDef_vec_create(
+        fbb, import_refs.data(), import_refs.size());
+    auto exports_ref = iree_vm_ExportFunctionDef_vec_create(
+        fbb, export_refs.data(), export_refs.size());
+    iree_vm_ModuleStateDef_start(fbb);
+    auto module_state_ref = iree_vm_ModuleStateDef_end(fbb);
+    auto descriptors_ref = iree_vm_FunctionDescriptor_vec_create(
+        fbb, descriptors.data(), descriptors.size());
+    auto bytecode_data_ref = flatbuffers_uint8_vec_create(
+        fbb, bytecode_data.data(), bytecode_data.size());
+    iree_vm_BytecodeModuleDef_name_add(fbb, name_ref);
+    iree_vm_BytecodeModuleDef_imported_functions_add(fbb, imports_ref);
+    iree_vm_BytecodeModuleDef_exported_functions_add(fbb, exports_ref);
+    iree_vm_BytecodeModuleDef_module_state_add(fbb, module_state_ref);
+    iree_vm_BytecodeModuleDef_function_descriptors_add(fbb, descriptors_ref);
+    iree_vm_BytecodeModuleDef_bytecode_data_add(fbb, bytecode_data_ref);
+    iree_vm_BytecodeModuleDef_bytecode_version_add(fbb, version_);
+    iree_vm_BytecodeModuleDef_end_as_root(fbb);
+
+    flatbuffers_.emplace_back(flatcc_builder_get_buffer_size(fbb));
+    std::vector<uint8_t>& flatbuffer = flatbuffers_.back();
+    flatcc_builder_copy_buffer(fbb, flatbuffer.data(), flatbuffer.size());
+    flatcc_builder_clear(fbb);
+
+    return iree_vm_bytecode_module_create(
+        iree_make_const_byte_span(flatbuffer.data(), flatbuffer.size()),
+        iree_allocator_null(), allocator, out_module);
+  }
+
+ private:
+  static iree_vm_FunctionSignatureDef_ref_t CreateSignature(
+      flatcc_builder_t* fbb, const char* cconv) {
+    flatbuffers_string_ref_t cconv_ref =
+        cconv ? flatbuffers_string_create_str(fbb, cconv) : 0;
+    iree_vm_FunctionSignatureDef_start(fbb);
+    if (cconv_ref) {
+      iree_vm_FunctionSignatureDef_calling_convention_add(fbb, cconv_ref);
+    }
+    return iree_vm_FunctionSignatureDef_end(fbb);
+  }
+
+  struct FunctionRef {
+    const char* name;
+    const char* cconv;
+    uint32_t ordinal;
+  };
+  struct Function {
+    std::vector<uint8_t> bytecode;
+    uint16_t i32_register_count;
+    uint16_t ref_register_count;
+  };
+
+  const char* name_;
+  uint32_t version_;
+  std::vector<FunctionRef> imports_;
+  std::vector<FunctionRef> exports_;
+  std::vector<Function> functions_;
+  std::vector<std::vector<uint8_t>> flatbuffers_;
+};
+
+#endif  // IREE_VM_BYTECODE_MODULE_TEST_H_
@@ -0,0 +1,1573 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/vm/bytecode_verifier.h"
+
+#include <string.h>
+
+#include "iree/base/alignment.h"
+#include "iree/base/internal/math.h"
+#include "iree/base/tracing.h"
+#include "iree/vm/generated/bytecode_op_table.h"
+
+//===----------------------------------------------------------------------===//
+// Verification state
+//===----------------------------------------------------------------------===//
+
+// The compiler pads each function to this alignment with zeros.
+#define IREE_VM_BYTECODE_FUNCTION_ALIGNMENT 8
+
+// State used while verifying a single function.
+typedef struct iree_vm_bytecode_verifier_t {
+  const iree_vm_bytecode_verifier_module_t* module;
+  const iree_vm_bytecode_verifier_function_t* function;
+  const uint8_t* bytecode_data;
+  iree_host_size_t bytecode_length;
+  // Offset of the next byte to read.
+  iree_host_size_t pc;
+  // Bitmap of the byte offsets at which an instruction begins.
+  uint64_t* instruction_starts;
+  // Bitmap of the byte offsets targeted by branches.
+  uint64_t* branch_targets;
+
+  // Output receiving the version 2 encoding of the function while transcoding
+  // version 1 bytecode or NULL when verifying version 2 bytecode in place.
+  // All bytes read are copied to the output at |output_pc| with register list
+  // headers inserted as they are decoded.
+  uint8_t* output_data;
+  iree_host_size_t output_pc;
+  // Output pcs of each inserted register list header.
+  uint32_t* insertion_pcs;
+  iree_host_size_t insertion_count;
+  // Output pcs of each branch target that must be relocated.
+  uint32_t* branch_fixups;
+  iree_host_size_t branch_fixup_count;
+} iree_vm_bytecode_verifier_t;
+
+// A register list decoded from the bytecode.
+// Entries are read with unaligned loads as lists are only 2-byte aligned
+// relative to the function and functions themselves may be misaligned.
+// Entries [0, i32_count) are in the i32 bank and [i32_count, size) are in the
+// ref bank. Lists of primitive values have no ref bank.
+typedef struct iree_vm_bytecode_verifier_list_t {
+  uint16_t i32_count;
+  uint16_t size;
+  const uint8_t* data;
+} iree_vm_bytecode_verifier_list_t;
+
+static inline uint16_t iree_vm_bytecode_verifier_list_at(
+    iree_vm_bytecode_verifier_list_t list, iree_host_size_t i) {
+  return iree_unaligned_load_le_u16((const uint16_t*)(list.data + i * 2));
+}
+
+static inline void iree_vm_bytecode_verifier_set_bit(uint64_t* bitmap,
+                                                     iree_host_size_t i) {
+  bitmap[i / 64] |= 1ull << (i % 64);
+}
+
+//===----------------------------------------------------------------------===//
+// Operand decoding and verification
+//===----------------------------------------------------------------------===//
+// Each routine mirrors the corresponding VM_Dec* routine used by the dispatch
+// loop and consumes the same number of bytes.
+
+static iree_status_t iree_vm_bytecode_verifier_read(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t length,
+    const uint8_t** out_data) {
+  if (IREE_UNLIKELY(length > verifier->bytecode_length - verifier->pc)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "truncated instruction; %zu bytes required at offset %zu but the "
+        "function is %zu bytes",
+        length, verifier->pc, verifier->bytecode_length);
+  }
+  *out_data = verifier->bytecode_data + verifier->pc;
+  verifier->pc += length;
+  if (verifier->output_data) {
+    memcpy(verifier->output_data + verifier->output_pc, *out_data, length);
+    verifier->output_pc += length;
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verifier_read_u8(
+    iree_vm_bytecode_verifier_t* verifier, uint8_t* out_value) {
+  const uint8_t* data = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_read(verifier, 1, &data));
+  *out_value = data[0];
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verifier_read_u16(
+    iree_vm_bytecode_verifier_t* verifier, uint16_t* out_value) {
+  const uint8_t* data = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_read(verifier, 2, &data));
+  *out_value = iree_unaligned_load_le_u16((const uint16_t*)data);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verifier_read_u32(
+    iree_vm_bytecode_verifier_t* verifier, uint32_t* out_value) {
+  const uint8_t* data = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_read(verifier, 4, &data));
+  *out_value = iree_unaligned_load_le_u32((const uint32_t*)data);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verifier_skip(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t length) {
+  const uint8_t* data = NULL;
+  return iree_vm_bytecode_verifier_read(verifier, length, &data);
+}
+
+static iree_status_t iree_vm_bytecode_verifier_check_reg_i32(
+    iree_vm_bytecode_verifier_t* verifier, uint16_t reg, const char* name) {
+  if (IREE_UNLIKELY(reg & IREE_REF_REGISTER_TYPE_BIT)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "%s: expected an i32 register but got ref %u",
+                            name, reg & IREE_REF_REGISTER_MASK);
+  } else if (IREE_UNLIKELY(reg >= verifier->function->i32_register_count)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "%s: i32 register %u out of range (count=%u)",
+                            name, reg, verifier->function->i32_register_count);
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verifier_check_reg_i64(
+    iree_vm_bytecode_verifier_t* verifier, uint16_t reg, const char* name) {
+  if (IREE_UNLIKELY(reg & IREE_REF_REGISTER_TYPE_BIT)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "%s: expected an i64 register but got ref %u",
+                            name, reg & IREE_REF_REGISTER_MASK);
+  } else if (IREE_UNLIKELY((reg & ~1u) + 1 >=
+                           verifier->function->i32_register_count)) {
+    // 64-bit values occupy the aligned pair of 32-bit registers at reg&~1.
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "%s: i64 register %u out of range (count=%u)",
+                            name, reg, verifier->function->i32_register_count);
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verifier_check_reg_ref(
+    iree_vm_bytecode_verifier_t* verifier, uint16_t reg, const char* name) {
+  if (IREE_UNLIKELY(!(reg & IREE_REF_REGISTER_TYPE_BIT))) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "%s: expected a ref register but got i32 %u", name,
+                            reg);
+  } else if (IREE_UNLIKELY((reg & IREE_REF_REGISTER_MASK) >=
+                           verifier->function->ref_register_count)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "%s: ref register %u out of range (count=%u)",
+                            name, reg & IREE_REF_REGISTER_MASK,
+                            verifier->function->ref_register_count);
+  }
+  return iree_ok_status();
+}
+
+// Checks a register of either bank as indicated by its type bit.
+static iree_status_t iree_vm_bytecode_verifier_check_reg_any(
+    iree_vm_bytecode_verifier_t* verifier, uint16_t reg, const char* name) {
+  return (reg & IREE_REF_REGISTER_TYPE_BIT)
+             ? iree_vm_bytecode_verifier_check_reg_ref(verifier, reg, name)
+             : iree_vm_bytecode_verifier_check_reg_i32(verifier, reg, name);
+}
+
+typedef iree_status_t (*iree_vm_bytecode_verifier_check_reg_fn_t)(
+    iree_vm_bytecode_verifier_t* verifier, uint16_t reg, const char* name);
+
+static iree_status_t iree_vm_bytecode_verifier_reg(
+    iree_vm_bytecode_verifier_t* verifier,
+    iree_vm_bytecode_verifier_check_reg_fn_t check_reg, const char* name) {
+  uint16_t reg = 0;
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_read_u16(verifier, &reg));
+  return check_reg(verifier, reg, name);
+}
+
+// Decodes an array of |entry_size| byte entries prefixed with its length.
+static iree_status_t iree_vm_bytecode_verifier_array(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t entry_size,
+    iree_vm_bytecode_verifier_list_t* out_list) {
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_skip(
+      verifier, iree_host_align(verifier->pc, 2) - verifier->pc));
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verifier_read_u16(verifier, &out_list->size));
+  out_list->i32_count = out_list->size;
+  return iree_vm_bytecode_verifier_read(verifier, out_list->size * entry_size,
+                                        &out_list->data);
+}
+
+// Partitions the version 1 register list just copied to the output by the bank
+// of the first register in each entry and inserts the version 2 header.
+// |input_list| references the original list in the input bytecode.
+static void iree_vm_bytecode_verifier_transcode_list(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t header_pc,
+    iree_host_size_t entry_size, iree_vm_bytecode_verifier_list_t* list) {
+  uint8_t* output_entries =
+      verifier->output_data + verifier->output_pc - list->size * entry_size;
+  uint16_t i32_count = 0;
+  for (int bank = 0; bank < 2; ++bank) {
+    uint16_t bank_bit = bank ? IREE_REF_REGISTER_TYPE_BIT : 0;
+    for (iree_host_size_t i = 0; i < list->size; ++i) {
+      const uint8_t* entry = list->data + i * entry_size;
+      uint16_t reg = iree_unaligned_load_le_u16((const uint16_t*)entry);
+      if ((reg & IREE_REF_REGISTER_TYPE_BIT) != bank_bit) continue;
+      memcpy(output_entries, entry, entry_size);
+      output_entries += entry_size;
+      if (!bank) ++i32_count;
+    }
+  }
+  iree_unaligned_store_le_u16(
+      (uint16_t*)(verifier->output_data + header_pc), i32_count);
+  verifier->insertion_pcs[verifier->insertion_count++] = (uint32_t)header_pc;
+  list->i32_count = i32_count;
+  list->data = output_entries - list->size * entry_size;
+}
+
+// Decodes a register list of |entry_size| byte entries partitioned by bank.
+// The first register of each entry determines its bank.
+static iree_status_t iree_vm_bytecode_verifier_list(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t entry_size,
+    iree_vm_bytecode_verifier_list_t* out_list) {
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_skip(
+      verifier, iree_host_align(verifier->pc, 2) - verifier->pc));
+  if (verifier->output_data) {
+    // Reserve the header that version 1 bytecode lacks. Alignment padding is
+    // unchanged as functions remain 8-byte aligned and headers are 2 bytes.
+    // The transcoded banks are consistent by construction.
+    iree_host_size_t header_pc = verifier->output_pc;
+    verifier->output_pc += 2;
+    IREE_RETURN_IF_ERROR(
+        iree_vm_bytecode_verifier_array(verifier, entry_size, out_list));
+    iree_vm_bytecode_verifier_transcode_list(verifier, header_pc, entry_size,
+                                             out_list);
+    return iree_ok_status();
+  }
+
+  uint16_t i32_count = 0;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verifier_read_u16(verifier, &i32_count));
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verifier_array(verifier, entry_size, out_list));
+  if (IREE_UNLIKELY(i32_count > out_list->size)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "register list i32 count %u exceeds size %u",
+                            i32_count, out_list->size);
+  }
+  out_list->i32_count = i32_count;
+  for (iree_host_size_t i = 0; i < out_list->size; ++i) {
+    uint16_t reg = iree_vm_bytecode_verifier_list_at(
+        *out_list, i * (entry_size / 2));
+    bool is_ref = (reg & IREE_REF_REGISTER_TYPE_BIT) != 0;
+    if (IREE_UNLIKELY(is_ref != (i >= i32_count))) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "register list entry %zu is not in its bank", i);
+    }
+  }
+  return iree_ok_status();
+}
+
+// Decodes a variadic register list and checks each entry with |check_reg|.
+// |check_reg| may be NULL to only decode the list.
+static iree_status_t iree_vm_bytecode_verifier_variadic(
+    iree_vm_bytecode_verifier_t* verifier,
+    iree_vm_bytecode_verifier_check_reg_fn_t check_reg, const char* name,
+    iree_vm_bytecode_verifier_list_t* out_list) {
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_list(verifier, 2, out_list));
+  if (!check_reg) return iree_ok_status();
+  for (iree_host_size_t i = 0; i < out_list->size; ++i) {
+    IREE_RETURN_IF_ERROR(check_reg(
+        verifier, iree_vm_bytecode_verifier_list_at(*out_list, i), name));
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verifier_branch_target(
+    iree_vm_bytecode_verifier_t* verifier) {
+  uint32_t block_pc = 0;
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_read_u32(verifier, &block_pc));
+  if (IREE_UNLIKELY(block_pc >= verifier->bytecode_length)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "branch target %u out of range (length=%zu)",
+                            block_pc, verifier->bytecode_length);
+  }
+  // Checked against the instruction boundaries once the function is decoded.
+  iree_vm_bytecode_verifier_set_bit(verifier->branch_targets, block_pc);
+  if (verifier->output_data) {
+    // Relocated once all register list headers have been inserted.
+    verifier->branch_fixups[verifier->branch_fixup_count++] =
+        (uint32_t)(verifier->output_pc - 4);
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verifier_branch_operands(
+    iree_vm_bytecode_verifier_t* verifier) {
+  iree_vm_bytecode_verifier_list_t list;
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_list(verifier, 4, &list));
+  for (iree_host_size_t i = 0; i < list.size; ++i) {
+    // Both registers of a pair must be in the bank of the pair.
+    iree_vm_bytecode_verifier_check_reg_fn_t check_reg =
+        i < list.i32_count ? iree_vm_bytecode_verifier_check_reg_i32
+                           : iree_vm_bytecode_verifier_check_reg_ref;
+    IREE_RETURN_IF_ERROR(check_reg(
+        verifier, iree_vm_bytecode_verifier_list_at(list, i * 2 + 0),
+        "branch operand"));
+    IREE_RETURN_IF_ERROR(check_reg(
+        verifier, iree_vm_bytecode_verifier_list_at(list, i * 2 + 1),
+        "branch operand"));
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verifier_type(
+    iree_vm_bytecode_verifier_t* verifier) {
+  uint32_t type_id = 0;
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_read_u32(verifier, &type_id));
+  if (IREE_UNLIKELY(type_id >= verifier->module->type_count)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "type %u out of range (table=%zu)", type_id,
+                            verifier->module->type_count);
+  }
+  return iree_ok_status();
+}
+
+// Verifies a global byte offset attribute for a value of |value_size| bytes.
+static iree_status_t iree_vm_bytecode_verifier_global_bytes(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t value_size) {
+  uint32_t byte_offset = 0;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verifier_read_u32(verifier, &byte_offset));
+  if (IREE_UNLIKELY((uint64_t)byte_offset + value_size >
+                    verifier->module->global_bytes_capacity)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "global byte_offset out of range: %u+%zu "
+                            "(rwdata=%zu)",
+                            byte_offset, value_size,
+                            verifier->module->global_bytes_capacity);
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verifier_global_ref(
+    iree_vm_bytecode_verifier_t* verifier) {
+  uint32_t global = 0;
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_read_u32(verifier, &global));
+  if (IREE_UNLIKELY(global >= verifier->module->global_ref_count)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "global ref ordinal out of range: %u (table=%zu)",
+                            global, verifier->module->global_ref_count);
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verifier_rodata(
+    iree_vm_bytecode_verifier_t* verifier) {
+  uint32_t rodata_ordinal = 0;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verifier_read_u32(verifier, &rodata_ordinal));
+  if (IREE_UNLIKELY(rodata_ordinal >= verifier->module->rodata_segment_count)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "rodata ref ordinal out of range: %u (table=%zu)",
+                            rodata_ordinal,
+                            verifier->module->rodata_segment_count);
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verifier_str(
+    iree_vm_bytecode_verifier_t* verifier) {
+  uint16_t length = 0;
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_read_u16(verifier, &length));
+  return iree_vm_bytecode_verifier_skip(verifier, length);
+}
+
+#define VM_VerifyOpcode(out_opcode) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_read_u8(verifier, out_opcode))
+#define VM_VerifyFuncAttr(out_ordinal) \
+  IREE_RETURN_IF_ERROR(                \
+      iree_vm_bytecode_verifier_read_u32(verifier, out_ordinal))
+#define VM_VerifyGlobalAttrI32(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_global_bytes(verifier, 4))
+#define VM_VerifyGlobalAttrI64(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_global_bytes(verifier, 8))
+#define VM_VerifyGlobalAttrRef(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_global_ref(verifier))
+#define VM_VerifyRodataAttr(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_rodata(verifier))
+#define VM_VerifyTypeOf(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_type(verifier))
+#define VM_VerifyIntAttr32(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_skip(verifier, 4))
+#define VM_VerifyIntAttr64(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_skip(verifier, 8))
+#define VM_VerifyFloatAttr32(name) VM_VerifyIntAttr32(name)
+#define VM_VerifyStrAttr(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_str(verifier))
+#define VM_VerifyBranchTarget(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_branch_target(verifier))
+#define VM_VerifyBranchOperands(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_branch_operands(verifier))
+#define VM_VerifyRegI32(name)                         \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_reg( \
+      verifier, iree_vm_bytecode_verifier_check_reg_i32, name))
+#define VM_VerifyRegI64(name)                         \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_reg( \
+      verifier, iree_vm_bytecode_verifier_check_reg_i64, name))
+#define VM_VerifyRegRef(name)                         \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_reg( \
+      verifier, iree_vm_bytecode_verifier_check_reg_ref, name))
+#define VM_VerifyOperandRegI32(name) VM_VerifyRegI32(name)
+#define VM_VerifyOperandRegI64(name) VM_VerifyRegI64(name)
+#define VM_VerifyOperandRegF32(name) VM_VerifyRegI32(name)
+#define VM_VerifyOperandRegRef(name) VM_VerifyRegRef(name)
+#define VM_VerifyResultRegI32(name) VM_VerifyRegI32(name)
+#define VM_VerifyResultRegI64(name) VM_VerifyRegI64(name)
+#define VM_VerifyResultRegF32(name) VM_VerifyRegI32(name)
+#define VM_VerifyResultRegRef(name) VM_VerifyRegRef(name)
+#define VM_VerifyVariadicOperands(check_reg, name, out_list) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_variadic(   \
+      verifier, check_reg, name, out_list))
+#define VM_VerifyPrimitiveArrayAttr16(name, out_list) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_array(verifier, 2, out_list))
+
+//===----------------------------------------------------------------------===//
+// Calling convention verification
+//===----------------------------------------------------------------------===//
+
+// Checks |reg| against the calling convention type |cconv_type|.
+static iree_status_t iree_vm_bytecode_verifier_check_cconv_reg(
+    iree_vm_bytecode_verifier_t* verifier, char cconv_type, uint16_t reg,
+    const char* name) {
+  switch (cconv_type) {
+    case IREE_VM_CCONV_TYPE_I32:
+    case IREE_VM_CCONV_TYPE_F32:
+      return iree_vm_bytecode_verifier_check_reg_i32(verifier, reg, name);
+    case IREE_VM_CCONV_TYPE_I64:
+    case IREE_VM_CCONV_TYPE_F64:
+      return iree_vm_bytecode_verifier_check_reg_i64(verifier, reg, name);
+    case IREE_VM_CCONV_TYPE_REF:
+      return iree_vm_bytecode_verifier_check_reg_ref(verifier, reg, name);
+    default:
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "%s: unsupported calling convention type '%c'",
+                              name, cconv_type);
+  }
+}
+
+// Takes the next register for a value of |cconv_type| from its bank in |list|
+// and checks it against the type. |i32_reg_i| and |ref_reg_i| are the cursors
+// into each bank.
+static iree_status_t iree_vm_bytecode_verifier_next_cconv_reg(
+    iree_vm_bytecode_verifier_t* verifier, char cconv_type,
+    iree_vm_bytecode_verifier_list_t list, iree_host_size_t* i32_reg_i,
+    iree_host_size_t* ref_reg_i, const char* name) {
+  iree_host_size_t reg_i = 0;
+  if (cconv_type == IREE_VM_CCONV_TYPE_REF) {
+    if (IREE_UNLIKELY(*ref_reg_i >= list.size)) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "%s: too few ref registers (%u provided)", name,
+                              list.size - list.i32_count);
+    }
+    reg_i = (*ref_reg_i)++;
+  } else {
+    if (IREE_UNLIKELY(*i32_reg_i >= list.i32_count)) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "%s: too few i32 registers (%u provided)", name,
+                              list.i32_count);
+    }
+    reg_i = (*i32_reg_i)++;
+  }
+  return iree_vm_bytecode_verifier_check_cconv_reg(
+      verifier, cconv_type, iree_vm_bytecode_verifier_list_at(list, reg_i),
+      name);
+}
+
+// Checks that all registers in |list| were consumed by a calling convention.
+static iree_status_t iree_vm_bytecode_verifier_check_cconv_end(
+    iree_string_view_t cconv_fragment, iree_vm_bytecode_verifier_list_t list,
+    iree_host_size_t i32_reg_i, iree_host_size_t ref_reg_i, const char* name) {
+  if (IREE_UNLIKELY(i32_reg_i != list.i32_count || ref_reg_i != list.size)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "%s: count mismatch; calling convention '%.*s' covers %zu i32 and %zu "
+        "ref registers but %u and %u are provided",
+        name, (int)cconv_fragment.size, cconv_fragment.data, i32_reg_i,
+        ref_reg_i - list.i32_count, list.i32_count,
+        list.size - list.i32_count);
+  }
+  return iree_ok_status();
+}
+
+// Checks that the registers in |list| match the non-variadic calling
+// convention |cconv_fragment| (such as `iir`) one-to-one within each bank.
+static iree_status_t iree_vm_bytecode_verifier_check_cconv(
+    iree_vm_bytecode_verifier_t* verifier, iree_string_view_t cconv_fragment,
+    iree_vm_bytecode_verifier_list_t list, const char* name) {
+  iree_host_size_t i32_reg_i = 0;
+  iree_host_size_t ref_reg_i = list.i32_count;
+  for (iree_host_size_t i = 0; i < cconv_fragment.size; ++i) {
+    char cconv_type = cconv_fragment.data[i];
+    if (cconv_type == IREE_VM_CCONV_TYPE_VOID) continue;
+    IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_next_cconv_reg(
+        verifier, cconv_type, list, &i32_reg_i, &ref_reg_i, name));
+  }
+  return iree_vm_bytecode_verifier_check_cconv_end(cconv_fragment, list,
+                                                   i32_reg_i, ref_reg_i, name);
+}
+
+// Checks that the registers in |list| match the variadic calling convention
+// |cconv_fragment| (such as `iCrD`) with the span counts in |segment_sizes|.
+// This must match the walk performed when marshaling the arguments in
+// iree_vm_bytecode_populate_import_cconv_arguments.
+static iree_status_t iree_vm_bytecode_verifier_check_cconv_variadic(
+    iree_vm_bytecode_verifier_t* verifier, iree_string_view_t cconv_fragment,
+    iree_vm_bytecode_verifier_list_t segment_sizes,
+    iree_vm_bytecode_verifier_list_t list) {
+  iree_host_size_t i32_reg_i = 0;
+  iree_host_size_t ref_reg_i = list.i32_count;
+  for (iree_host_size_t i = 0, seg_i = 0; i < cconv_fragment.size;
+       ++i, ++seg_i) {
+    char cconv_type = cconv_fragment.data[i];
+    if (cconv_type == IREE_VM_CCONV_TYPE_VOID) continue;
+    if (cconv_type != IREE_VM_CCONV_TYPE_SPAN_START) {
+      IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_next_cconv_reg(
+          verifier, cconv_type, list, &i32_reg_i, &ref_reg_i, "operand"));
+      continue;
+    }
+
+    // Span of |span_count| tuples of the types up to the span end.
+    iree_host_size_t span_start_i = i + 1;
+    iree_host_size_t span_end_i = span_start_i;
+    while (span_end_i < cconv_fragment.size &&
+           cconv_fragment.data[span_end_i] != IREE_VM_CCONV_TYPE_SPAN_END) {
+      ++span_end_i;
+    }
+    if (IREE_UNLIKELY(span_end_i >= cconv_fragment.size)) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "unterminated span in calling convention '%.*s'",
+                              (int)cconv_fragment.size, cconv_fragment.data);
+    }
+    if (IREE_UNLIKELY(seg_i >= segment_sizes.size)) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "variadic segment %zu has no segment size",
+                              seg_i);
+    }
+    int16_t span_count =
+        (int16_t)iree_vm_bytecode_verifier_list_at(segment_sizes, seg_i);
+    if (IREE_UNLIKELY(span_count < 0)) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "variadic segment %zu has negative size %d",
+                              seg_i, span_count);
+    }
+    for (int16_t j = 0; j < span_count; ++j) {
+      for (iree_host_size_t k = span_start_i; k < span_end_i; ++k) {
+        IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_next_cconv_reg(
+            verifier, cconv_fragment.data[k], list, &i32_reg_i, &ref_reg_i,
+            "operand"));
+      }
+    }
+    i = span_end_i;
+  }
+  return iree_vm_bytecode_verifier_check_cconv_end(
+      cconv_fragment, list, i32_reg_i, ref_reg_i, "operands");
+}
+
+// Splits |cconv| into its argument and result fragments.
+static iree_status_t iree_vm_bytecode_verifier_cconv_fragments(
+    iree_string_view_t cconv, iree_string_view_t* out_arguments,
+    iree_string_view_t* out_results) {
+  iree_vm_function_signature_t signature;
+  memset(&signature, 0, sizeof(signature));
+  signature.calling_convention = cconv;
+  return iree_vm_function_call_get_cconv_fragments(&signature, out_arguments,
+                                                   out_results);
+}
+
+// Verifies a vm.call/vm.call.variadic to |function_ordinal|.
+// |segment_sizes| is only provided for variadic calls.
+static iree_status_t iree_vm_bytecode_verifier_call(
+    iree_vm_bytecode_verifier_t* verifier, uint32_t function_ordinal,
+    const iree_vm_bytecode_verifier_list_t* segment_sizes,
+    iree_vm_bytecode_verifier_list_t operands,
+    iree_vm_bytecode_verifier_list_t results) {
+  const iree_vm_bytecode_verifier_module_t* module = verifier->module;
+  iree_string_view_t cconv = iree_string_view_empty();
+  if (function_ordinal & 0x80000000u) {
+    uint32_t import_ordinal = function_ordinal & 0x7FFFFFFFu;
+    if (IREE_UNLIKELY(import_ordinal >= module->import_count)) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "import ordinal out of range: %u (table=%zu)",
+                              import_ordinal, module->import_count);
+    }
+    cconv = module->import_cconvs[import_ordinal];
+    if (IREE_UNLIKELY(iree_string_view_is_empty(cconv))) {
+      // The resolved import is only checked against the declared calling
+      // convention when there is one so there's nothing we can trust.
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "import %u has no calling convention declared",
+                              import_ordinal);
+    }
+  } else {
+    if (IREE_UNLIKELY(segment_sizes)) {
+      return iree_make_status(
+          IREE_STATUS_INVALID_ARGUMENT,
+          "variadic calls are only supported for imported functions");
+    }
+    if (IREE_UNLIKELY(function_ordinal >= module->function_count)) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "function ordinal out of range: %u (table=%zu)",
+                              function_ordinal, module->function_count);
+    }
+    cconv = module->functions[function_ordinal].cconv;
+  }
+
+  if (iree_string_view_is_empty(cconv)) {
+    // Internal function with an unknown signature: the calls just need to
+    // reference valid registers.
+    for (iree_host_size_t i = 0; i < operands.size; ++i) {
+      IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_check_reg_any(
+          verifier, iree_vm_bytecode_verifier_list_at(operands, i),
+          "operand"));
+    }
+    for (iree_host_size_t i = 0; i < results.size; ++i) {
+      IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_check_reg_any(
+          verifier, iree_vm_bytecode_verifier_list_at(results, i), "result"));
+    }
+    return iree_ok_status();
+  }
+
+  iree_string_view_t cconv_arguments = iree_string_view_empty();
+  iree_string_view_t cconv_results = iree_string_view_empty();
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_cconv_fragments(
+      cconv, &cconv_arguments, &cconv_results));
+  bool is_variadic = iree_vm_function_call_is_variadic_cconv(cconv_arguments);
+  if (segment_sizes) {
+    if (IREE_UNLIKELY(!is_variadic)) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "variadic call to non-variadic function '%.*s'",
+                              (int)cconv.size, cconv.data);
+    }
+    IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_check_cconv_variadic(
+        verifier, cconv_arguments, *segment_sizes, operands));
+  } else {
+    if (IREE_UNLIKELY(is_variadic)) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "non-variadic call to variadic function '%.*s'",
+                              (int)cconv.size, cconv.data);
+    }
+    IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_check_cconv(
+        verifier, cconv_arguments, operands, "operands"));
+  }
+  return iree_vm_bytecode_verifier_check_cconv(verifier, cconv_results, results,
+                                               "results");
+}
+
+// Verifies the registers returned by a vm.return against the function results.
+static iree_status_t iree_vm_bytecode_verifier_return(
+    iree_vm_bytecode_verifier_t* verifier,
+    iree_vm_bytecode_verifier_list_t operands) {
+  iree_string_view_t cconv = verifier->function->cconv;
+  if (iree_string_view_is_empty(cconv)) {
+    for (iree_host_size_t i = 0; i < operands.size; ++i) {
+      IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_check_reg_any(
+          verifier, iree_vm_bytecode_verifier_list_at(operands, i),
+          "operand"));
+    }
+    return iree_ok_status();
+  }
+  iree_string_view_t cconv_arguments = iree_string_view_empty();
+  iree_string_view_t cconv_results = iree_string_view_empty();
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_cconv_fragments(
+      cconv, &cconv_arguments, &cconv_results));
+  return iree_vm_bytecode_verifier_check_cconv(verifier, cconv_results,
+                                               operands, "operands");
+}
+
+//===----------------------------------------------------------------------===//
+// Instruction verification
+//===----------------------------------------------------------------------===//
+
+#define VERIFY_OP(ext, op_name) case IREE_VM_OP_##ext##_##op_name:
+
+#if IREE_VM_EXT_I64_ENABLE
+static iree_status_t iree_vm_bytecode_verify_op_ext_i64(
+    iree_vm_bytecode_verifier_t* verifier) {
+  uint8_t opcode = 0;
+  VM_VerifyOpcode(&opcode);
+  switch (opcode) {
+    VERIFY_OP(EXT_I64, GlobalLoadI64) {
+      VM_VerifyGlobalAttrI64("global");
+      VM_VerifyResultRegI64("value");
+    } break;
+    VERIFY_OP(EXT_I64, GlobalStoreI64) {
+      VM_VerifyGlobalAttrI64("global");
+      VM_VerifyOperandRegI64("value");
+    } break;
+    VERIFY_OP(EXT_I64, GlobalLoadIndirectI64) {
+      VM_VerifyOperandRegI32("global");
+      VM_VerifyResultRegI64("value");
+    } break;
+    VERIFY_OP(EXT_I64, GlobalStoreIndirectI64) {
+      VM_VerifyOperandRegI32("global");
+      VM_VerifyOperandRegI64("value");
+    } break;
+
+    VERIFY_OP(EXT_I64, ConstI64) {
+      VM_VerifyIntAttr64("value");
+      VM_VerifyResultRegI64("result");
+    } break;
+    VERIFY_OP(EXT_I64, ConstI64Zero) { VM_VerifyResultRegI64("result"); }
+    break;
+
+    VERIFY_OP(EXT_I64, ListGetI64)
+    VERIFY_OP(EXT_I64, BufferLoadI64) {
+      VM_VerifyOperandRegRef("source");
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyResultRegI64("result");
+    } break;
+    VERIFY_OP(EXT_I64, ListSetI64)
+    VERIFY_OP(EXT_I64, BufferStoreI64) {
+      VM_VerifyOperandRegRef("target");
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyOperandRegI64("value");
+    } break;
+    VERIFY_OP(EXT_I64, BufferFillI64) {
+      VM_VerifyOperandRegRef("target_buffer");
+      VM_VerifyOperandRegI32("target_offset");
+      VM_VerifyOperandRegI32("length");
+      VM_VerifyOperandRegI64("value");
+    } break;
+
+    VERIFY_OP(EXT_I64, SelectI64) {
+      VM_VerifyOperandRegI32("condition");
+      VM_VerifyOperandRegI64("true_value");
+      VM_VerifyOperandRegI64("false_value");
+      VM_VerifyResultRegI64("result");
+    } break;
+    VERIFY_OP(EXT_I64, SwitchI64) {
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyIntAttr64("default_value");
+      iree_vm_bytecode_verifier_list_t values;
+      VM_VerifyVariadicOperands(iree_vm_bytecode_verifier_check_reg_i64,
+                                "values", &values);
+      VM_VerifyResultRegI64("result");
+    } break;
+
+    VERIFY_OP(EXT_I64, AddI64)
+    VERIFY_OP(EXT_I64, SubI64)
+    VERIFY_OP(EXT_I64, MulI64)
+    VERIFY_OP(EXT_I64, DivI64S)
+    VERIFY_OP(EXT_I64, DivI64U)
+    VERIFY_OP(EXT_I64, RemI64S)
+    VERIFY_OP(EXT_I64, RemI64U)
+    VERIFY_OP(EXT_I64, AndI64)
+    VERIFY_OP(EXT_I64, OrI64)
+    VERIFY_OP(EXT_I64, XorI64) {
+      VM_VerifyOperandRegI64("lhs");
+      VM_VerifyOperandRegI64("rhs");
+      VM_VerifyResultRegI64("result");
+    } break;
+    VERIFY_OP(EXT_I64, FMAI64) {
+      VM_VerifyOperandRegI64("a");
+      VM_VerifyOperandRegI64("b");
+      VM_VerifyOperandRegI64("c");
+      VM_VerifyResultRegI64("result");
+    } break;
+    VERIFY_OP(EXT_I64, NotI64) {
+      VM_VerifyOperandRegI64("operand");
+      VM_VerifyResultRegI64("result");
+    } break;
+
+    VERIFY_OP(EXT_I64, TruncI64I32)
+    VERIFY_OP(EXT_I64, CmpNZI64) {
+      VM_VerifyOperandRegI64("operand");
+      VM_VerifyResultRegI32("result");
+    } break;
+    VERIFY_OP(EXT_I64, ExtI32I64S)
+    VERIFY_OP(EXT_I64, ExtI32I64U) {
+      VM_VerifyOperandRegI32("operand");
+      VM_VerifyResultRegI64("result");
+    } break;
+
+    VERIFY_OP(EXT_I64, ShlI64)
+    VERIFY_OP(EXT_I64, ShrI64S)
+    VERIFY_OP(EXT_I64, ShrI64U) {
+      VM_VerifyOperandRegI64("operand");
+      VM_VerifyOperandRegI32("amount");
+      VM_VerifyResultRegI64("result");
+    } break;
+
+    VERIFY_OP(EXT_I64, CmpEQI64)
+    VERIFY_OP(EXT_I64, CmpNEI64)
+    VERIFY_OP(EXT_I64, CmpLTI64S)
+    VERIFY_OP(EXT_I64, CmpLTI64U) {
+      VM_VerifyOperandRegI64("lhs");
+      VM_VerifyOperandRegI64("rhs");
+      VM_VerifyResultRegI32("result");
+    } break;
+
+    default:
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "unhandled ext i64 opcode 0x%02X", opcode);
+  }
+  return iree_ok_status();
+}
+#endif  // IREE_VM_EXT_I64_ENABLE
+
+#if IREE_VM_EXT_F32_ENABLE
+static iree_status_t iree_vm_bytecode_verify_op_ext_f32(
+    iree_vm_bytecode_verifier_t* verifier) {
+  uint8_t opcode = 0;
+  VM_VerifyOpcode(&opcode);
+  switch (opcode) {
+    VERIFY_OP(EXT_F32, GlobalLoadF32) {
+      VM_VerifyGlobalAttrI32("global");
+      VM_VerifyResultRegF32("value");
+    } break;
+    VERIFY_OP(EXT_F32, GlobalStoreF32) {
+      VM_VerifyGlobalAttrI32("global");
+      VM_VerifyOperandRegF32("value");
+    } break;
+    VERIFY_OP(EXT_F32, GlobalLoadIndirectF32) {
+      VM_VerifyOperandRegI32("global");
+      VM_VerifyResultRegF32("value");
+    } break;
+    VERIFY_OP(EXT_F32, GlobalStoreIndirectF32) {
+      VM_VerifyOperandRegI32("global");
+      VM_VerifyOperandRegF32("value");
+    } break;
+
+    VERIFY_OP(EXT_F32, ConstF32) {
+      VM_VerifyFloatAttr32("value");
+      VM_VerifyResultRegF32("result");
+    } break;
+    VERIFY_OP(EXT_F32, ConstF32Zero) { VM_VerifyResultRegF32("result"); }
+    break;
+
+    VERIFY_OP(EXT_F32, ListGetF32)
+    VERIFY_OP(EXT_F32, BufferLoadF32) {
+      VM_VerifyOperandRegRef("source");
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyResultRegF32("result");
+    } break;
+    VERIFY_OP(EXT_F32, ListSetF32)
+    VERIFY_OP(EXT_F32, BufferStoreF32) {
+      VM_VerifyOperandRegRef("target");
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyOperandRegF32("value");
+    } break;
+    VERIFY_OP(EXT_F32, BufferFillF32) {
+      VM_VerifyOperandRegRef("target_buffer");
+      VM_VerifyOperandRegI32("target_offset");
+      VM_VerifyOperandRegI32("length");
+      VM_VerifyOperandRegF32("value");
+    } break;
+
+    VERIFY_OP(EXT_F32, SelectF32) {
+      VM_VerifyOperandRegI32("condition");
+      VM_VerifyOperandRegF32("true_value");
+      VM_VerifyOperandRegF32("false_value");
+      VM_VerifyResultRegF32("result");
+    } break;
+    VERIFY_OP(EXT_F32, SwitchF32) {
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyFloatAttr32("default_value");
+      iree_vm_bytecode_verifier_list_t values;
+      VM_VerifyVariadicOperands(iree_vm_bytecode_verifier_check_reg_i32,
+                                "values", &values);
+      VM_VerifyResultRegF32("result");
+    } break;
+
+    VERIFY_OP(EXT_F32, AddF32)
+    VERIFY_OP(EXT_F32, SubF32)
+    VERIFY_OP(EXT_F32, MulF32)
+    VERIFY_OP(EXT_F32, DivF32)
+    VERIFY_OP(EXT_F32, RemF32)
+    VERIFY_OP(EXT_F32, Atan2F32)
+    VERIFY_OP(EXT_F32, PowF32) {
+      VM_VerifyOperandRegF32("lhs");
+      VM_VerifyOperandRegF32("rhs");
+      VM_VerifyResultRegF32("result");
+    } break;
+    VERIFY_OP(EXT_F32, FMAF32) {
+      VM_VerifyOperandRegF32("a");
+      VM_VerifyOperandRegF32("b");
+      VM_VerifyOperandRegF32("c");
+      VM_VerifyResultRegF32("result");
+    } break;
+    VERIFY_OP(EXT_F32, AbsF32)
+    VERIFY_OP(EXT_F32, NegF32)
+    VERIFY_OP(EXT_F32, CeilF32)
+    VERIFY_OP(EXT_F32, FloorF32)
+    VERIFY_OP(EXT_F32, AtanF32)
+    VERIFY_OP(EXT_F32, CosF32)
+    VERIFY_OP(EXT_F32, SinF32)
+    VERIFY_OP(EXT_F32, ExpF32)
+    VERIFY_OP(EXT_F32, Exp2F32)
+    VERIFY_OP(EXT_F32, ExpM1F32)
+    VERIFY_OP(EXT_F32, LogF32)
+    VERIFY_OP(EXT_F32, Log10F32)
+    VERIFY_OP(EXT_F32, Log1pF32)
+    VERIFY_OP(EXT_F32, Log2F32)
+    VERIFY_OP(EXT_F32, RsqrtF32)
+    VERIFY_OP(EXT_F32, SqrtF32)
+    VERIFY_OP(EXT_F32, TanhF32)
+    VERIFY_OP(EXT_F32, ErfF32) {
+      VM_VerifyOperandRegF32("operand");
+      VM_VerifyResultRegF32("result");
+    } break;
+
+    VERIFY_OP(EXT_F32, CastSI32F32)
+    VERIFY_OP(EXT_F32, CastUI32F32)
+    VERIFY_OP(EXT_F32, BitcastI32F32) {
+      VM_VerifyOperandRegI32("operand");
+      VM_VerifyResultRegF32("result");
+    } break;
+    VERIFY_OP(EXT_F32, CastF32SI32)
+    VERIFY_OP(EXT_F32, CastF32UI32)
+    VERIFY_OP(EXT_F32, BitcastF32I32)
+    VERIFY_OP(EXT_F32, CmpNaNF32) {
+      VM_VerifyOperandRegF32("operand");
+      VM_VerifyResultRegI32("result");
+    } break;
+
+    VERIFY_OP(EXT_F32, CmpEQF32O)
+    VERIFY_OP(EXT_F32, CmpEQF32U)
+    VERIFY_OP(EXT_F32, CmpNEF32O)
+    VERIFY_OP(EXT_F32, CmpNEF32U)
+    VERIFY_OP(EXT_F32, CmpLTF32O)
+    VERIFY_OP(EXT_F32, CmpLTF32U)
+    VERIFY_OP(EXT_F32, CmpLTEF32O)
+    VERIFY_OP(EXT_F32, CmpLTEF32U) {
+      VM_VerifyOperandRegF32("lhs");
+      VM_VerifyOperandRegF32("rhs");
+      VM_VerifyResultRegI32("result");
+    } break;
+
+    default:
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "unhandled ext f32 opcode 0x%02X", opcode);
+  }
+  return iree_ok_status();
+}
+#endif  // IREE_VM_EXT_F32_ENABLE
+
+// Verifies the instruction at the current pc and advances past it.
+// |out_is_terminator| is set if control cannot fall through to the next
+// instruction.
+static iree_status_t iree_vm_bytecode_verify_op(
+    iree_vm_bytecode_verifier_t* verifier, bool* out_is_terminator) {
+  *out_is_terminator = false;
+  uint8_t opcode = 0;
+  VM_VerifyOpcode(&opcode);
+  switch (opcode) {
+    //===------------------------------------------------------------------===//
+    // Globals
+    //===------------------------------------------------------------------===//
+
+    VERIFY_OP(CORE, GlobalLoadI32) {
+      VM_VerifyGlobalAttrI32("global");
+      VM_VerifyResultRegI32("value");
+    } break;
+    VERIFY_OP(CORE, GlobalStoreI32) {
+      VM_VerifyGlobalAttrI32("global");
+      VM_VerifyOperandRegI32("value");
+    } break;
+    VERIFY_OP(CORE, GlobalLoadRef) {
+      VM_VerifyGlobalAttrRef("global");
+      VM_VerifyTypeOf("value");
+      VM_VerifyResultRegRef("value");
+    } break;
+    VERIFY_OP(CORE, GlobalStoreRef) {
+      VM_VerifyGlobalAttrRef("global");
+      VM_VerifyTypeOf("value");
+      VM_VerifyOperandRegRef("value");
+    } break;
+    VERIFY_OP(CORE, GlobalLoadIndirectRef)
+    VERIFY_OP(CORE, GlobalStoreIndirectRef) {
+      VM_VerifyOperandRegI32("global");
+      VM_VerifyTypeOf("value");
+      VM_VerifyOperandRegRef("value");
+    } break;
+
+    //===------------------------------------------------------------------===//
+    // Constants
+    //===------------------------------------------------------------------===//
+
+    VERIFY_OP(CORE, ConstI32) {
+      VM_VerifyIntAttr32("value");
+      VM_VerifyResultRegI32("result");
+    } break;
+    VERIFY_OP(CORE, ConstI32Zero) { VM_VerifyResultRegI32("result"); }
+    break;
+    VERIFY_OP(CORE, ConstRefZero) { VM_VerifyResultRegRef("result"); }
+    break;
+    VERIFY_OP(CORE, ConstRefRodata) {
+      VM_VerifyRodataAttr("rodata");
+      VM_VerifyResultRegRef("value");
+    } break;
+
+    //===------------------------------------------------------------------===//
+    // Buffers
+    //===------------------------------------------------------------------===//
+
+    VERIFY_OP(CORE, BufferAlloc) {
+      VM_VerifyOperandRegI32("length");
+      VM_VerifyResultRegRef("result");
+    } break;
+    VERIFY_OP(CORE, BufferClone) {
+      VM_VerifyOperandRegRef("source");
+      VM_VerifyOperandRegI32("offset");
+      VM_VerifyOperandRegI32("length");
+      VM_VerifyResultRegRef("result");
+    } break;
+    VERIFY_OP(CORE, BufferLength)
+    VERIFY_OP(CORE, ListSize) {
+      VM_VerifyOperandRegRef("operand");
+      VM_VerifyResultRegI32("result");
+    } break;
+    VERIFY_OP(CORE, BufferCopy) {
+      VM_VerifyOperandRegRef("source_buffer");
+      VM_VerifyOperandRegI32("source_offset");
+      VM_VerifyOperandRegRef("target_buffer");
+      VM_VerifyOperandRegI32("target_offset");
+      VM_VerifyOperandRegI32("length");
+    } break;
+    VERIFY_OP(CORE, BufferCompare) {
+      VM_VerifyOperandRegRef("lhs_buffer");
+      VM_VerifyOperandRegI32("lhs_offset");
+      VM_VerifyOperandRegRef("rhs_buffer");
+      VM_VerifyOperandRegI32("rhs_offset");
+      VM_VerifyOperandRegI32("length");
+      VM_VerifyResultRegI32("result");
+    } break;
+    VERIFY_OP(CORE, BufferFillI8)
+    VERIFY_OP(CORE, BufferFillI16)
+    VERIFY_OP(CORE, BufferFillI32) {
+      VM_VerifyOperandRegRef("target_buffer");
+      VM_VerifyOperandRegI32("target_offset");
+      VM_VerifyOperandRegI32("length");
+      VM_VerifyOperandRegI32("value");
+    } break;
+    VERIFY_OP(CORE, BufferLoadI8U)
+    VERIFY_OP(CORE, BufferLoadI8S)
+    VERIFY_OP(CORE, BufferLoadI16U)
+    VERIFY_OP(CORE, BufferLoadI16S)
+    VERIFY_OP(CORE, BufferLoadI32)
+    VERIFY_OP(CORE, ListGetI32) {
+      VM_VerifyOperandRegRef("source");
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyResultRegI32("result");
+    } break;
+    VERIFY_OP(CORE, BufferStoreI8)
+    VERIFY_OP(CORE, BufferStoreI16)
+    VERIFY_OP(CORE, BufferStoreI32)
+    VERIFY_OP(CORE, ListSetI32) {
+      VM_VerifyOperandRegRef("target");
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyOperandRegI32("value");
+    } break;
+
+    //===------------------------------------------------------------------===//
+    // Lists
+    //===------------------------------------------------------------------===//
+
+    VERIFY_OP(CORE, ListAlloc) {
+      VM_VerifyTypeOf("element_type");
+      VM_VerifyOperandRegI32("initial_capacity");
+      VM_VerifyResultRegRef("result");
+    } break;
+    VERIFY_OP(CORE, ListReserve)
+    VERIFY_OP(CORE, ListResize) {
+      VM_VerifyOperandRegRef("list");
+      VM_VerifyOperandRegI32("size");
+    } break;
+    VERIFY_OP(CORE, ListGetRef) {
+      VM_VerifyOperandRegRef("list");
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyTypeOf("result");
+      VM_VerifyResultRegRef("result");
+    } break;
+    VERIFY_OP(CORE, ListSetRef) {
+      VM_VerifyOperandRegRef("list");
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyOperandRegRef("value");
+    } break;
+
+    //===------------------------------------------------------------------===//
+    // Conditional assignment
+    //===------------------------------------------------------------------===//
+
+    VERIFY_OP(CORE, SelectI32)
+    VERIFY_OP(CORE, FMAI32) {
+      VM_VerifyOperandRegI32("a");
+      VM_VerifyOperandRegI32("b");
+      VM_VerifyOperandRegI32("c");
+      VM_VerifyResultRegI32("result");
+    } break;
+    VERIFY_OP(CORE, SelectRef) {
+      VM_VerifyOperandRegI32("condition");
+      VM_VerifyTypeOf("true_value");
+      VM_VerifyOperandRegRef("true_value");
+      VM_VerifyOperandRegRef("false_value");
+      VM_VerifyResultRegRef("result");
+    } break;
+    VERIFY_OP(CORE, SwitchI32) {
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyIntAttr32("default_value");
+      iree_vm_bytecode_verifier_list_t values;
+      VM_VerifyVariadicOperands(iree_vm_bytecode_verifier_check_reg_i32,
+                                "values", &values);
+      VM_VerifyResultRegI32("result");
+    } break;
+    VERIFY_OP(CORE, SwitchRef) {
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyTypeOf("result");
+      VM_VerifyOperandRegRef("default_value");
+      iree_vm_bytecode_verifier_list_t values;
+      VM_VerifyVariadicOperands(iree_vm_bytecode_verifier_check_reg_ref,
+                                "values", &values);
+      VM_VerifyResultRegRef("result");
+    } break;
+
+    //===------------------------------------------------------------------===//
+    // Native integer arithmetic, bitwise ops, and comparisons
+    //===------------------------------------------------------------------===//
+
+    VERIFY_OP(CORE, GlobalStoreIndirectI32)
+    VERIFY_OP(CORE, GlobalLoadIndirectI32)
+    VERIFY_OP(CORE, NotI32)
+    VERIFY_OP(CORE, TruncI32I8)
+    VERIFY_OP(CORE, TruncI32I16)
+    VERIFY_OP(CORE, ExtI8I32S)
+    VERIFY_OP(CORE, ExtI8I32U)
+    VERIFY_OP(CORE, ExtI16I32S)
+    VERIFY_OP(CORE, ExtI16I32U)
+    VERIFY_OP(CORE, CmpNZI32) {
+      VM_VerifyOperandRegI32("operand");
+      VM_VerifyResultRegI32("result");
+    } break;
+    VERIFY_OP(CORE, AddI32Imm) {
+      VM_VerifyOperandRegI32("operand");
+      VM_VerifyIntAttr32("imm");
+      VM_VerifyResultRegI32("result");
+    } break;
+    VERIFY_OP(CORE, AddI32)
+    VERIFY_OP(CORE, SubI32)
+    VERIFY_OP(CORE, MulI32)
+    VERIFY_OP(CORE, DivI32S)
+    VERIFY_OP(CORE, DivI32U)
+    VERIFY_OP(CORE, RemI32S)
+    VERIFY_OP(CORE, RemI32U)
+    VERIFY_OP(CORE, AndI32)
+    VERIFY_OP(CORE, OrI32)
+    VERIFY_OP(CORE, XorI32)
+    VERIFY_OP(CORE, ShlI32)
+    VERIFY_OP(CORE, ShrI32S)
+    VERIFY_OP(CORE, ShrI32U)
+    VERIFY_OP(CORE, CmpEQI32)
+    VERIFY_OP(CORE, CmpNEI32)
+    VERIFY_OP(CORE, CmpLTI32S)
+    VERIFY_OP(CORE, CmpLTI32U) {
+      VM_VerifyOperandRegI32("lhs");
+      VM_VerifyOperandRegI32("rhs");
+      VM_VerifyResultRegI32("result");
+    } break;
+    VERIFY_OP(CORE, CmpEQRef)
+    VERIFY_OP(CORE, CmpNERef) {
+      VM_VerifyOperandRegRef("lhs");
+      VM_VerifyOperandRegRef("rhs");
+      VM_VerifyResultRegI32("result");
+    } break;
+    VERIFY_OP(CORE, CmpNZRef) {
+      VM_VerifyOperandRegRef("operand");
+      VM_VerifyResultRegI32("result");
+    } break;
+
+    //===------------------------------------------------------------------===//
+    // Control flow
+    //===------------------------------------------------------------------===//
+
+    VERIFY_OP(CORE, Branch)
+    VERIFY_OP(CORE, Yield)
+    VERIFY_OP(CORE, Break) {
+      VM_VerifyBranchTarget("dest");
+      VM_VerifyBranchOperands("operands");
+      *out_is_terminator = true;
+    } break;
+    VERIFY_OP(CORE, CondBranch) {
+      VM_VerifyOperandRegI32("condition");
+      VM_VerifyBranchTarget("true_dest");
+      VM_VerifyBranchOperands("true_operands");
+      VM_VerifyBranchTarget("false_dest");
+      VM_VerifyBranchOperands("false_operands");
+      *out_is_terminator = true;
+    } break;
+    VERIFY_OP(CORE, CondBranchCmpEQI32)
+    VERIFY_OP(CORE, CondBranchCmpNEI32)
+    VERIFY_OP(CORE, CondBranchCmpLTI32S)
+    VERIFY_OP(CORE, CondBranchCmpLTI32U) {
+      VM_VerifyOperandRegI32("lhs");
+      VM_VerifyOperandRegI32("rhs");
+      VM_VerifyBranchTarget("true_dest");
+      VM_VerifyBranchOperands("true_operands");
+      VM_VerifyBranchTarget("false_dest");
+      VM_VerifyBranchOperands("false_operands");
+      *out_is_terminator = true;
+    } break;
+    VERIFY_OP(CORE, CondBreak) {
+      // NOTE: the dispatch always takes the branch.
+      VM_VerifyOperandRegI32("condition");
+      VM_VerifyBranchTarget("dest");
+      VM_VerifyBranchOperands("operands");
+      *out_is_terminator = true;
+    } break;
+
+    VERIFY_OP(CORE, Call) {
+      uint32_t function_ordinal = 0;
+      VM_VerifyFuncAttr(&function_ordinal);
+      iree_vm_bytecode_verifier_list_t operands;
+      VM_VerifyVariadicOperands(NULL, "operands", &operands);
+      iree_vm_bytecode_verifier_list_t results;
+      VM_VerifyVariadicOperands(NULL, "results", &results);
+      IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_call(
+          verifier, function_ordinal, /*segment_sizes=*/NULL, operands,
+          results));
+    } break;
+    VERIFY_OP(CORE, CallVariadic) {
+      uint32_t function_ordinal = 0;
+      VM_VerifyFuncAttr(&function_ordinal);
+      iree_vm_bytecode_verifier_list_t segment_sizes;
+      VM_VerifyPrimitiveArrayAttr16("segment_sizes", &segment_sizes);
+      iree_vm_bytecode_verifier_list_t operands;
+      VM_VerifyVariadicOperands(NULL, "operands", &operands);
+      iree_vm_bytecode_verifier_list_t results;
+      VM_VerifyVariadicOperands(NULL, "results", &results);
+      IREE_RETURN_IF_ERROR(iree_vm_bytecode_verifier_call(
+          verifier, function_ordinal, &segment_sizes, operands, results));
+    } break;
+
+    VERIFY_OP(CORE, Return) {
+      iree_vm_bytecode_verifier_list_t operands;
+      VM_VerifyVariadicOperands(NULL, "operands", &operands);
+      IREE_RETURN_IF_ERROR(
+          iree_vm_bytecode_verifier_return(verifier, operands));
+      *out_is_terminator = true;
+    } break;
+    VERIFY_OP(CORE, Fail) {
+      VM_VerifyOperandRegI32("status");
+      VM_VerifyStrAttr("message");
+      *out_is_terminator = true;
+    } break;
+
+    //===------------------------------------------------------------------===//
+    // Debugging
+    //===------------------------------------------------------------------===//
+
+    VERIFY_OP(CORE, Trace)
+    VERIFY_OP(CORE, Print) {
+      VM_VerifyStrAttr("event_name");
+      iree_vm_bytecode_verifier_list_t operands;
+      VM_VerifyVariadicOperands(iree_vm_bytecode_verifier_check_reg_any,
+                                "operands", &operands);
+    } break;
+
+    //===------------------------------------------------------------------===//
+    // Extension trampolines
+    //===------------------------------------------------------------------===//
+
+#if IREE_VM_EXT_I64_ENABLE
+    VERIFY_OP(CORE, PrefixExtI64) {
+      IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_op_ext_i64(verifier));
+    } break;
+#endif  // IREE_VM_EXT_I64_ENABLE
+#if IREE_VM_EXT_F32_ENABLE
+    VERIFY_OP(CORE, PrefixExtF32) {
+      IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_op_ext_f32(verifier));
+    } break;
+#endif  // IREE_VM_EXT_F32_ENABLE
+
+    default:
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "unhandled or disabled opcode 0x%02X", opcode);
+  }
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// Function and module verification
+//===----------------------------------------------------------------------===//
+
+// Returns true if the function bytecode from |pc| onward is alignment padding.
+static bool iree_vm_bytecode_verifier_is_padding(
+    const iree_vm_bytecode_verifier_t* verifier) {
+  iree_host_size_t remaining = verifier->bytecode_length - verifier->pc;
+  if (remaining >= IREE_VM_BYTECODE_FUNCTION_ALIGNMENT) return false;
+  for (iree_host_size_t i = verifier->pc; i < verifier->bytecode_length; ++i) {
+    if (verifier->bytecode_data[i] != 0) return false;
+  }
+  return true;
+}
+
+static iree_status_t iree_vm_bytecode_verify_function(
+    iree_vm_bytecode_verifier_t* verifier) {
+  if (IREE_UNLIKELY(!verifier->bytecode_length)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "function has no bytecode");
+  }
+
+  // Linearly decode all instructions. The compiler emits blocks contiguously
+  // and every block ends in a terminator so the linear walk reaches every
+  // instruction that can be branched to.
+  bool is_terminator = false;
+  while (verifier->pc < verifier->bytecode_length) {
+    if (is_terminator && iree_vm_bytecode_verifier_is_padding(verifier)) {
+      break;
+    }
+    iree_host_size_t op_pc = verifier->pc;
+    iree_vm_bytecode_verifier_set_bit(verifier->instruction_starts, op_pc);
+    iree_status_t status = iree_vm_bytecode_verify_op(verifier, &is_terminator);
+    if (!iree_status_is_ok(status)) {
+      return iree_status_annotate_f(status, "at bytecode offset %zu", op_pc);
+    }
+  }
+  if (IREE_UNLIKELY(!is_terminator)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "function does not end with a terminator");
+  }
+
+  // All branch targets must be instruction starts.
+  iree_host_size_t word_count = (verifier->bytecode_length + 63) / 64;
+  for (iree_host_size_t i = 0; i < word_count; ++i) {
+    uint64_t invalid_targets =
+        verifier->branch_targets[i] & ~verifier->instruction_starts[i];
+    if (IREE_UNLIKELY(invalid_targets)) {
+      iree_host_size_t block_pc =
+          i * 64 + iree_math_count_trailing_zeros_u64(invalid_targets);
+      return iree_make_status(
+          IREE_STATUS_INVALID_ARGUMENT,
+          "branch target %zu is not at an instruction boundary", block_pc);
+    }
+  }
+
+  return iree_ok_status();
+}
+
+// Relocates the branch targets in the transcoded function to account for the
+// register list headers inserted before them.
+static void iree_vm_bytecode_verifier_relocate_branches(
+    iree_vm_bytecode_verifier_t* verifier) {
+  for (iree_host_size_t i = 0; i < verifier->branch_fixup_count; ++i) {
+    uint32_t* target_ptr =
+        (uint32_t*)(verifier->output_data + verifier->branch_fixups[i]);
+    uint32_t block_pc = iree_unaligned_load_le_u32(target_ptr);
+    // Header k was inserted at input pc insertion_pcs[k] - 2 * k and the
+    // target moves 2 bytes for each header inserted before it.
+    iree_host_size_t lo = 0;
+    iree_host_size_t hi = verifier->insertion_count;
+    while (lo < hi) {
+      iree_host_size_t mid = lo + (hi - lo) / 2;
+      if (verifier->insertion_pcs[mid] - 2 * mid < block_pc) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    iree_unaligned_store_le_u32(target_ptr, (uint32_t)(block_pc + 2 * lo));
+  }
+}
+
+// Verifies all functions in |module|. When |transcoded| is provided the
+// functions are version 1 bytecode that is transcoded into it.
+static iree_status_t iree_vm_bytecode_verifier_run(
+    const iree_vm_bytecode_verifier_module_t* module,
+    iree_allocator_t host_allocator,
+    iree_vm_bytecode_transcoded_module_t* transcoded) {
+  // Scratch is sized for the largest function and reused for each: bitmaps
+  // of instruction starts and branch targets and the branch fixups.
+  iree_host_size_t max_bytecode_length = 0;
+  for (iree_host_size_t i = 0; i < module->function_count; ++i) {
+    max_bytecode_length = iree_max(max_bytecode_length,
+                                   module->functions[i].bytecode.data_length);
+  }
+  iree_host_size_t word_count = (max_bytecode_length + 63) / 64;
+  iree_host_size_t fixup_capacity =
+      transcoded ? max_bytecode_length / sizeof(uint32_t) : 0;
+  uint64_t* bitmaps = NULL;
+  if (word_count > 0) {
+    IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+        host_allocator,
+        2 * word_count * sizeof(*bitmaps) + fixup_capacity * sizeof(uint32_t),
+        (void**)&bitmaps));
+  }
+
+  iree_status_t status = iree_ok_status();
+  iree_host_size_t output_offset = 0;
+  iree_host_size_t insertion_offset = 0;
+  for (iree_host_size_t i = 0; i < module->function_count; ++i) {
+    const iree_vm_bytecode_verifier_function_t* function =
+        &module->functions[i];
+    iree_vm_bytecode_verifier_t verifier;
+    memset(&verifier, 0, sizeof(verifier));
+    verifier.module = module;
+    verifier.function = function;
+    verifier.bytecode_data = function->bytecode.data;
+    verifier.bytecode_length = function->bytecode.data_length;
+    verifier.instruction_starts = bitmaps;
+    verifier.branch_targets = bitmaps + word_count;
+    if (bitmaps) memset(bitmaps, 0, 2 * word_count * sizeof(*bitmaps));
+    if (transcoded) {
+      verifier.output_data = transcoded->bytecode_data.data + output_offset;
+      verifier.insertion_pcs = transcoded->insertion_pcs + insertion_offset;
+      verifier.branch_fixups = (uint32_t*)(bitmaps + 2 * word_count);
+    }
+    status = iree_vm_bytecode_verify_function(&verifier);
+    if (!iree_status_is_ok(status)) {
+      status = iree_status_annotate_f(status, "in function %zu", i);
+      break;
+    }
+    if (transcoded) {
+      iree_vm_bytecode_verifier_relocate_branches(&verifier);
+      iree_host_size_t output_length = iree_host_align(
+          verifier.output_pc, IREE_VM_BYTECODE_FUNCTION_ALIGNMENT);
+      memset(verifier.output_data + verifier.output_pc, 0,
+             output_length - verifier.output_pc);
+      iree_vm_bytecode_transcoded_function_t* transcoded_function =
+          &transcoded->functions[i];
+      transcoded_function->bytecode_offset = (uint32_t)output_offset;
+      transcoded_function->bytecode_length = (uint32_t)output_length;
+      transcoded_function->insertion_offset = (uint32_t)insertion_offset;
+      transcoded_function->insertion_count = (uint32_t)verifier.insertion_count;
+      output_offset += output_length;
+      insertion_offset += verifier.insertion_count;
+    }
+  }
+
+  if (transcoded && iree_status_is_ok(status)) {
+    transcoded->bytecode_data.data_length = output_offset;
+  }
+  iree_allocator_free(host_allocator, bitmaps);
+  return status;
+}
+
+iree_status_t iree_vm_bytecode_verify_module(
+    const iree_vm_bytecode_verifier_module_t* module,
+    iree_allocator_t host_allocator) {
+  IREE_ASSERT_ARGUMENT(module);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status =
+      iree_vm_bytecode_verifier_run(module, host_allocator, NULL);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_vm_bytecode_transcode_module(
+    const iree_vm_bytecode_verifier_module_t* module,
+    iree_allocator_t host_allocator,
+    iree_vm_bytecode_transcoded_module_t* out_module) {
+  IREE_ASSERT_ARGUMENT(module);
+  IREE_ASSERT_ARGUMENT(out_module);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  memset(out_module, 0, sizeof(*out_module));
+
+  // Storage is allocated for the worst case and trimmed once the actual sizes
+  // are known. Each register list is at least 2 bytes and gains a 2 byte
+  // header so functions at most double in size.
+  iree_host_size_t bytecode_capacity = 0;
+  iree_host_size_t insertion_capacity = 0;
+  for (iree_host_size_t i = 0; i < module->function_count; ++i) {
+    iree_host_size_t length = module->functions[i].bytecode.data_length;
+    bytecode_capacity +=
+        iree_host_align(2 * length, IREE_VM_BYTECODE_FUNCTION_ALIGNMENT);
+    insertion_capacity += length / 2;
+  }
+  if (IREE_UNLIKELY(bytecode_capacity > INT32_MAX)) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "bytecode too large to transcode (%zu bytes)",
+                            bytecode_capacity);
+  }
+
+  out_module->function_count = module->function_count;
+  iree_status_t status = iree_ok_status();
+  if (module->function_count > 0) {
+    status = iree_allocator_malloc(
+        host_allocator, module->function_count * sizeof(*out_module->functions),
+        (void**)&out_module->functions);
+  }
+  if (iree_status_is_ok(status) && bytecode_capacity > 0) {
+    status = iree_allocator_malloc(host_allocator, bytecode_capacity,
+                                   (void**)&out_module->bytecode_data.data);
+  }
+  if (iree_status_is_ok(status) && insertion_capacity > 0) {
+    status = iree_allocator_malloc(
+        host_allocator, insertion_capacity * sizeof(*out_module->insertion_pcs),
+        (void**)&out_module->insertion_pcs);
+  }
+
+  if (iree_status_is_ok(status)) {
+    status = iree_vm_bytecode_verifier_run(module, host_allocator, out_module);
+  }
+
+  // Trim storage down to what was used.
+  if (iree_status_is_ok(status) && out_module->bytecode_data.data_length > 0) {
+    status = iree_allocator_realloc(host_allocator,
+                                    out_module->bytecode_data.data_length,
+                                    (void**)&out_module->bytecode_data.data);
+  }
+  if (iree_status_is_ok(status) && module->function_count > 0) {
+    const iree_vm_bytecode_transcoded_function_t* last_function =
+        &out_module->functions[module->function_count - 1];
+    iree_host_size_t insertion_count =
+        last_function->insertion_offset + last_function->insertion_count;
+    if (insertion_count > 0) {
+      status = iree_allocator_realloc(
+          host_allocator, insertion_count * sizeof(*out_module->insertion_pcs),
+          (void**)&out_module->insertion_pcs);
+    }
+  }
+
+  if (!iree_status_is_ok(status)) {
+    iree_vm_bytecode_transcoded_module_deinitialize(out_module,
+                                                    host_allocator);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_vm_bytecode_transcoded_module_deinitialize(
+    iree_vm_bytecode_transcoded_module_t* module,
+    iree_allocator_t host_allocator) {
+  IREE_ASSERT_ARGUMENT(module);
+  iree_allocator_free(host_allocator, module->bytecode_data.data);
+  iree_allocator_free(host_allocator, module->functions);
+  iree_allocator_free(host_allocator, module->insertion_pcs);
+  memset(module, 0, sizeof(*module));
+}
+
+iree_host_size_t iree_vm_bytecode_transcoded_module_map_pc(
+    const iree_vm_bytecode_transcoded_module_t* module,
+    iree_host_size_t function_ordinal, iree_host_size_t pc) {
+  if (function_ordinal >= module->function_count) return pc;
+  const iree_vm_bytecode_transcoded_function_t* function =
+      &module->functions[function_ordinal];
+  const uint32_t* insertion_pcs =
+      module->insertion_pcs + function->insertion_offset;
+  // Each header inserted before |pc| moved it by 2 bytes.
+  iree_host_size_t lo = 0;
+  iree_host_size_t hi = function->insertion_count;
+  while (lo < hi) {
+    iree_host_size_t mid = lo + (hi - lo) / 2;
+    if (insertion_pcs[mid] < pc) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return pc - 2 * lo;
+}
@@ -0,0 +1,146 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_VM_BYTECODE_VERIFIER_H_
+#define IREE_VM_BYTECODE_VERIFIER_H_
+
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/vm/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Maximum register count per bank.
+// This determines the bits required to reference registers in the VM bytecode.
+#define IREE_I32_REGISTER_COUNT 0x7FFF
+#define IREE_REF_REGISTER_COUNT 0x7FFF
+
+#define IREE_I32_REGISTER_MASK 0x7FFF
+
+#define IREE_REF_REGISTER_TYPE_BIT 0x8000
+#define IREE_REF_REGISTER_MOVE_BIT 0x4000
+#define IREE_REF_REGISTER_MASK 0x3FFF
+
+// Bytecode encoding versions as stored in BytecodeModuleDef.bytecode_version.
+// Modules that predate versioning have no version and use version 1.
+//
+// Version 1 interleaves the registers of all banks within register lists and
+// each register must be inspected to find its bank.
+//
+// Version 2 partitions register lists by bank: lists are prefixed with the
+// number of i32 registers they contain and all i32 registers precede all ref
+// registers. Within each bank registers retain their original order. Branch
+// remapping lists are partitioned the same way by the bank of each pair.
+#define IREE_VM_BYTECODE_VERSION_1 1
+#define IREE_VM_BYTECODE_VERSION_2 2
+#define IREE_VM_BYTECODE_VERSION_LATEST IREE_VM_BYTECODE_VERSION_2
+
+// A bytecode function to be verified.
+typedef struct iree_vm_bytecode_verifier_function_t {
+  // Bytecode of the function including any trailing alignment padding.
+  iree_const_byte_span_t bytecode;
+  // Total number of registers in each bank as declared by the function.
+  uint16_t i32_register_count;
+  uint16_t ref_register_count;
+  // Calling convention of the function (such as `0ri_r`), if known.
+  // Functions that are not exported have no calling convention in the module
+  // and their arguments/results are only verified against register bounds.
+  iree_string_view_t cconv;
+} iree_vm_bytecode_verifier_function_t;
+
+// Module-level tables referenced by bytecode that functions are verified
+// against. This is populated from the module metadata so that the verifier can
+// run without needing to walk the FlatBuffer.
+typedef struct iree_vm_bytecode_verifier_module_t {
+  // Total number of entries in the module type table.
+  iree_host_size_t type_count;
+  // Total size, in bytes, of global primitive value storage.
+  iree_host_size_t global_bytes_capacity;
+  // Total number of global ref values.
+  iree_host_size_t global_ref_count;
+  // Total number of rodata segments.
+  iree_host_size_t rodata_segment_count;
+  // Calling conventions of each imported function as declared by the module.
+  // Imports without a declared calling convention cannot be called as the
+  // signature they resolve to at runtime is not checked against the module.
+  iree_host_size_t import_count;
+  const iree_string_view_t* import_cconvs;
+  // Internal functions indexed by internal ordinal.
+  iree_host_size_t function_count;
+  const iree_vm_bytecode_verifier_function_t* functions;
+} iree_vm_bytecode_verifier_module_t;
+
+// Verifies the version 2 bytecode of all functions in |module|.
+//
+// On success all instructions are known to decode entirely within their
+// function, use only enabled opcodes, and reference registers, types, globals,
+// rodata segments, and functions that exist. Branch targets land on
+// instruction boundaries, every function ends with a terminator, and calls to
+// functions with known calling conventions pass and receive registers of the
+// expected banks and counts (including the segment sizes of variadic calls).
+//
+// Modules with verified bytecode are dispatched with a variant of the
+// interpreter that elides the equivalent runtime checks; see
+// bytecode_dispatch_util.h.
+iree_status_t iree_vm_bytecode_verify_module(
+    const iree_vm_bytecode_verifier_module_t* module,
+    iree_allocator_t host_allocator);
+
+// A function within a transcoded module.
+typedef struct iree_vm_bytecode_transcoded_function_t {
+  // Byte offset and length of the function in the transcoded bytecode.
+  uint32_t bytecode_offset;
+  uint32_t bytecode_length;
+  // Range of the function entries in |insertion_pcs|.
+  uint32_t insertion_offset;
+  uint32_t insertion_count;
+} iree_vm_bytecode_transcoded_function_t;
+
+// Version 1 bytecode re-encoded as the latest version.
+typedef struct iree_vm_bytecode_transcoded_module_t {
+  // Bytecode of all functions. Each function begins at an 8-byte aligned
+  // offset. NULL if the module has not been transcoded.
+  iree_byte_span_t bytecode_data;
+  // Location of each function within |bytecode_data| by internal ordinal.
+  iree_host_size_t function_count;
+  iree_vm_bytecode_transcoded_function_t* functions;
+  // Sorted function-relative pcs at which the 2-byte register list headers
+  // were inserted. Used to map pcs back to the original bytecode.
+  uint32_t* insertion_pcs;
+} iree_vm_bytecode_transcoded_module_t;
+
+// Verifies the version 1 bytecode of all functions in |module| and transcodes
+// it to the latest version. The bytecode is verified as with
+// iree_vm_bytecode_verify_module and the transcoded bytecode can be dispatched
+// as if it had been verified.
+//
+// |out_module| must be deinitialized with
+// iree_vm_bytecode_transcoded_module_deinitialize.
+iree_status_t iree_vm_bytecode_transcode_module(
+    const iree_vm_bytecode_verifier_module_t* module,
+    iree_allocator_t host_allocator,
+    iree_vm_bytecode_transcoded_module_t* out_module);
+
+// Releases the storage of a module transcoded by
+// iree_vm_bytecode_transcode_module.
+void iree_vm_bytecode_transcoded_module_deinitialize(
+    iree_vm_bytecode_transcoded_module_t* module,
+    iree_allocator_t host_allocator);
+
+// Maps |pc| of an instruction in the transcoded function |function_ordinal|
+// to the pc of the same instruction in the original version 1 bytecode.
+iree_host_size_t iree_vm_bytecode_transcoded_module_map_pc(
+    const iree_vm_bytecode_transcoded_module_t* module,
+    iree_host_size_t function_ordinal, iree_host_size_t pc);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_VM_BYTECODE_VERIFIER_H_
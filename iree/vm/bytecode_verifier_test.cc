@@ -0,0 +1,402 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/vm/bytecode_verifier.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/bytecode_module_test.h"
+
+namespace {
+
+using ::iree::Status;
+using ::iree::StatusCode;
+using ::iree::testing::status::StatusIs;
+
+class BytecodeVerifierTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    module_.type_count = 2;
+    module_.global_bytes_capacity = 16;
+    module_.global_ref_count = 1;
+    module_.rodata_segment_count = 1;
+  }
+
+  // Adds a function with the given |bytecode| and returns its ordinal.
+  uint32_t AddFunction(const BytecodeBuilder& bytecode,
+                       uint16_t i32_register_count,
+                       uint16_t ref_register_count,
+                       iree_string_view_t cconv = iree_string_view_empty()) {
+    bytecode_.push_back(bytecode.data());
+    iree_vm_bytecode_verifier_function_t function;
+    function.bytecode = iree_const_byte_span_empty();
+    function.i32_register_count = i32_register_count;
+    function.ref_register_count = ref_register_count;
+    function.cconv = cconv;
+    functions_.push_back(function);
+    return static_cast<uint32_t>(functions_.size() - 1);
+  }
+
+  // Adds an import with the given |cconv| and returns its function ordinal.
+  uint32_t AddImport(iree_string_view_t cconv) {
+    import_cconvs_.push_back(cconv);
+    return 0x80000000u | static_cast<uint32_t>(import_cconvs_.size() - 1);
+  }
+
+  iree_status_t Verify() {
+    for (size_t i = 0; i < functions_.size(); ++i) {
+      functions_[i].bytecode =
+          iree_make_const_byte_span(bytecode_[i].data(), bytecode_[i].size());
+    }
+    module_.function_count = functions_.size();
+    module_.functions = functions_.data();
+    module_.import_count = import_cconvs_.size();
+    module_.import_cconvs = import_cconvs_.data();
+    return iree_vm_bytecode_verify_module(&module_, iree_allocator_system());
+  }
+
+  // Transcodes the functions as version 1 bytecode into |transcoded_|.
+  iree_status_t Transcode() {
+    iree_vm_bytecode_transcoded_module_deinitialize(&transcoded_,
+                                                    iree_allocator_system());
+    for (size_t i = 0; i < functions_.size(); ++i) {
+      functions_[i].bytecode =
+          iree_make_const_byte_span(bytecode_[i].data(), bytecode_[i].size());
+    }
+    module_.function_count = functions_.size();
+    module_.functions = functions_.data();
+    module_.import_count = import_cconvs_.size();
+    module_.import_cconvs = import_cconvs_.data();
+    return iree_vm_bytecode_transcode_module(&module_, iree_allocator_system(),
+                                             &transcoded_);
+  }
+
+  // Returns the transcoded bytecode of function |ordinal|.
+  std::vector<uint8_t> TranscodedBytecode(size_t ordinal) {
+    const auto& function = transcoded_.functions[ordinal];
+    const uint8_t* data =
+        transcoded_.bytecode_data.data + function.bytecode_offset;
+    return std::vector<uint8_t>(data, data + function.bytecode_length);
+  }
+
+  void TearDown() override {
+    iree_vm_bytecode_transcoded_module_deinitialize(&transcoded_,
+                                                    iree_allocator_system());
+  }
+
+  iree_vm_bytecode_verifier_module_t module_ = {};
+  std::vector<std::vector<uint8_t>> bytecode_;
+  std::vector<iree_vm_bytecode_verifier_function_t> functions_;
+  std::vector<iree_string_view_t> import_cconvs_;
+  iree_vm_bytecode_transcoded_module_t transcoded_ = {};
+};
+
+TEST_F(BytecodeVerifierTest, Empty) { IREE_EXPECT_OK(Verify()); }
+
+TEST_F(BytecodeVerifierTest, ValidFunction) {
+  BytecodeBuilder b;
+  b.Op(IREE_VM_OP_CORE_ConstI32).U32(123).Reg(0);
+  b.Op(IREE_VM_OP_CORE_AddI32).Reg(0).Reg(0).Reg(1);
+  b.Op(IREE_VM_OP_CORE_Return).List({1});
+  b.Pad();
+  AddFunction(b, 2, 0, IREE_SV("0v_i"));
+  IREE_EXPECT_OK(Verify());
+}
+
+TEST_F(BytecodeVerifierTest, NoBytecode) {
+  AddFunction(BytecodeBuilder(), 1, 0);
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+}
+
+TEST_F(BytecodeVerifierTest, MissingTerminator) {
+  BytecodeBuilder b;
+  b.Op(IREE_VM_OP_CORE_ConstI32Zero).Reg(0);
+  AddFunction(b, 1, 0);
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+}
+
+TEST_F(BytecodeVerifierTest, TrailingInstructionAfterPadding) {
+  // Only padding (< 8 zero bytes) may follow the final terminator.
+  BytecodeBuilder b;
+  b.Op(IREE_VM_OP_CORE_Return).List({});
+  b.Pad();
+  b.Op(IREE_VM_OP_CORE_ConstI32Zero).Reg(0);
+  AddFunction(b, 1, 0);
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+}
+
+TEST_F(BytecodeVerifierTest, TruncatedInstruction) {
+  BytecodeBuilder b;
+  b.Op(IREE_VM_OP_CORE_Return).List({});
+  b.Op(IREE_VM_OP_CORE_ConstI32).U16(0);
+  AddFunction(b, 1, 0);
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+}
+
+TEST_F(BytecodeVerifierTest, UnknownOpcode) {
+  BytecodeBuilder b;
+  b.Op(0xFF);
+  b.Op(IREE_VM_OP_CORE_Return).List({});
+  AddFunction(b, 0, 0);
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+}
+
+TEST_F(BytecodeVerifierTest, RegisterOutOfRange) {
+  BytecodeBuilder b;
+  b.Op(IREE_VM_OP_CORE_ConstI32Zero).Reg(2);
+  b.Op(IREE_VM_OP_CORE_Return).List({});
+  AddFunction(b, 2, 0);
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+}
+
+TEST_F(BytecodeVerifierTest, RegisterBankMismatch) {
+  BytecodeBuilder b;
+  b.Op(IREE_VM_OP_CORE_ConstI32Zero).RefReg(0);
+  b.Op(IREE_VM_OP_CORE_Return).List({});
+  AddFunction(b, 1, 1);
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+}
+
+TEST_F(BytecodeVerifierTest, I64RegisterPair) {
+  // i64 registers occupy two i32 registers starting at an even ordinal.
+  BytecodeBuilder b;
+  b.Op(IREE_VM_OP_CORE_PrefixExtI64).Op(IREE_VM_OP_EXT_I64_ConstI64Zero);
+  b.Reg(3);
+  b.Op(IREE_VM_OP_CORE_Return).List({});
+  AddFunction(b, 4, 0);
+  IREE_EXPECT_OK(Verify());
+
+  functions_[0].i32_register_count = 3;
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+}
+
+TEST_F(BytecodeVerifierTest, BranchTargets) {
+  BytecodeBuilder b;
+  b.Op(IREE_VM_OP_CORE_Branch);
+  size_t target_offset = b.offset();
+  b.U32(0);
+  b.RemapList({0, 1});
+  uint32_t block_pc = static_cast<uint32_t>(b.offset());
+  b.Op(IREE_VM_OP_CORE_Return).List({1});
+  b.Pad();
+  AddFunction(b, 2, 0);
+  memcpy(&bytecode_[0][target_offset], &block_pc, sizeof(block_pc));
+  IREE_EXPECT_OK(Verify());
+
+  // Into the middle of an instruction.
+  uint32_t bad_pc = block_pc + 1;
+  memcpy(&bytecode_[0][target_offset], &bad_pc, sizeof(bad_pc));
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+
+  // Out of the function.
+  bad_pc = static_cast<uint32_t>(bytecode_[0].size());
+  memcpy(&bytecode_[0][target_offset], &bad_pc, sizeof(bad_pc));
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+}
+
+TEST_F(BytecodeVerifierTest, BranchRemapBankMismatch) {
+  BytecodeBuilder b;
+  b.Op(IREE_VM_OP_CORE_Branch).U32(0);
+  b.RemapList({0, static_cast<uint16_t>(IREE_REF_REGISTER_TYPE_BIT | 0)});
+  AddFunction(b, 1, 1);
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+}
+
+TEST_F(BytecodeVerifierTest, Superinstructions) {
+  BytecodeBuilder b;
+  b.Op(IREE_VM_OP_CORE_AddI32Imm).Reg(0).U32(1).Reg(1);
+  b.Op(IREE_VM_OP_CORE_CondBranchCmpLTI32S).Reg(1).Reg(0);
+  b.U32(0).RemapList({1, 0});
+  size_t false_target_offset = b.offset();
+  b.U32(0).RemapList({});
+  uint32_t exit_pc = static_cast<uint32_t>(b.offset());
+  b.Op(IREE_VM_OP_CORE_Return).List({1});
+  b.Pad();
+  AddFunction(b, 2, 0, IREE_SV("0i_i"));
+  memcpy(&bytecode_[0][false_target_offset], &exit_pc, sizeof(exit_pc));
+  IREE_EXPECT_OK(Verify());
+
+  // Comparison operands must be i32 registers.
+  bytecode_[0][11] |= IREE_REF_REGISTER_TYPE_BIT >> 8;
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+}
+
+TEST_F(BytecodeVerifierTest, ModuleTableReferences) {
+  // Global byte offsets must leave room for the value being accessed.
+  {
+    BytecodeBuilder b;
+    b.Op(IREE_VM_OP_CORE_GlobalLoadI32).U32(12).Reg(0);
+    b.Op(IREE_VM_OP_CORE_Return).List({});
+    AddFunction(b, 1, 0);
+    IREE_EXPECT_OK(Verify());
+    bytecode_[0][1] = 13;
+    EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+  }
+  bytecode_.clear();
+  functions_.clear();
+
+  // Global refs, types, and rodata segments must exist.
+  BytecodeBuilder b;
+  b.Op(IREE_VM_OP_CORE_GlobalLoadRef).U32(0).U32(1).RefReg(0);
+  b.Op(IREE_VM_OP_CORE_ConstRefRodata).U32(0).RefReg(0);
+  b.Op(IREE_VM_OP_CORE_Return).List({});
+  AddFunction(b, 0, 1);
+  IREE_EXPECT_OK(Verify());
+  module_.global_ref_count = 0;
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+  module_.global_ref_count = 1;
+  module_.type_count = 1;
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+  module_.type_count = 2;
+  module_.rodata_segment_count = 0;
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+}
+
+TEST_F(BytecodeVerifierTest, InternalCall) {
+  BytecodeBuilder callee;
+  callee.Op(IREE_VM_OP_CORE_Return).List({0});
+  uint32_t callee_ordinal = AddFunction(callee, 1, 0, IREE_SV("0i_i"));
+
+  BytecodeBuilder caller;
+  caller.Op(IREE_VM_OP_CORE_Call).U32(callee_ordinal).List({0}).List({1});
+  caller.Op(IREE_VM_OP_CORE_Return).List({});
+  AddFunction(caller, 2, 0);
+  IREE_EXPECT_OK(Verify());
+
+  // Wrong result count.
+  functions_[callee_ordinal].cconv = IREE_SV("0i_ii");
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+
+  // Callees without a known signature are only checked for register bounds.
+  functions_[callee_ordinal].cconv = iree_string_view_empty();
+  IREE_EXPECT_OK(Verify());
+
+  // Callee out of range.
+  bytecode_[1][1] = 7;
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+}
+
+TEST_F(BytecodeVerifierTest, ImportCall) {
+  uint32_t import_ordinal = AddImport(IREE_SV("0ri_i"));
+  BytecodeBuilder b;
+  b.Op(IREE_VM_OP_CORE_Call).U32(import_ordinal);
+  b.List({static_cast<uint16_t>(IREE_REF_REGISTER_TYPE_BIT | 0), 0}).List({1});
+  b.Op(IREE_VM_OP_CORE_Return).List({});
+  AddFunction(b, 2, 1);
+  IREE_EXPECT_OK(Verify());
+
+  // Argument bank mismatch.
+  import_cconvs_[0] = IREE_SV("0ii_i");
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+
+  // Imports must declare their calling convention.
+  import_cconvs_[0] = iree_string_view_empty();
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+
+  // Non-variadic call of a variadic import.
+  import_cconvs_[0] = IREE_SV("0rCiD_i");
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+}
+
+TEST_F(BytecodeVerifierTest, VariadicImportCall) {
+  uint32_t import_ordinal = AddImport(IREE_SV("0iCiiD_v"));
+  BytecodeBuilder b;
+  b.Op(IREE_VM_OP_CORE_CallVariadic).U32(import_ordinal);
+  b.Array({0xFFFF, 2});
+  b.List({0, 1, 2, 3, 4});
+  b.List({});
+  b.Op(IREE_VM_OP_CORE_Return).List({});
+  AddFunction(b, 5, 0);
+  IREE_EXPECT_OK(Verify());
+
+  // Segment sizes that disagree with the operand count.
+  import_cconvs_[0] = IREE_SV("0iCiD_v");
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+
+  // Variadic calls to internal functions are not supported.
+  bytecode_[0][4] = 0x00;
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+}
+
+TEST_F(BytecodeVerifierTest, ReturnSignature) {
+  BytecodeBuilder b;
+  b.Op(IREE_VM_OP_CORE_Return).List({static_cast<uint16_t>(
+      IREE_REF_REGISTER_TYPE_BIT | 0)});
+  AddFunction(b, 1, 1, IREE_SV("0v_r"));
+  IREE_EXPECT_OK(Verify());
+  functions_[0].cconv = IREE_SV("0v_i");
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+}
+
+TEST_F(BytecodeVerifierTest, ListBanks) {
+  // The i32 count must be within the list.
+  BytecodeBuilder b;
+  b.Op(IREE_VM_OP_CORE_Return).U8(0).U16(2).U16(1).Reg(0);
+  b.Pad();
+  AddFunction(b, 1, 0);
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+
+  // Registers must be within their bank.
+  bytecode_[0][2] = 0;
+  EXPECT_THAT(Status(Verify()), StatusIs(StatusCode::kInvalidArgument));
+  bytecode_[0][2] = 1;
+  IREE_EXPECT_OK(Verify());
+}
+
+TEST_F(BytecodeVerifierTest, TranscodeV1) {
+  // The same program in both versions with mixed bank lists and a branch
+  // across them.
+  auto build = [](int version, uint32_t* out_block_pc) {
+    BytecodeBuilder b(version);
+    b.Op(IREE_VM_OP_CORE_Call).U32(0x80000000u);
+    b.List({static_cast<uint16_t>(IREE_REF_REGISTER_TYPE_BIT | 0), 0});
+    b.List({1, static_cast<uint16_t>(IREE_REF_REGISTER_TYPE_BIT | 1)});
+    b.Op(IREE_VM_OP_CORE_Branch);
+    size_t target_offset = b.offset();
+    b.U32(0);
+    b.RemapList({static_cast<uint16_t>(IREE_REF_REGISTER_TYPE_BIT | 1),
+                 static_cast<uint16_t>(IREE_REF_REGISTER_TYPE_BIT | 0), 1, 0});
+    *out_block_pc = static_cast<uint32_t>(b.offset());
+    b.Op(IREE_VM_OP_CORE_Return)
+        .List({static_cast<uint16_t>(IREE_REF_REGISTER_TYPE_BIT | 0), 0});
+    b.Pad();
+    std::vector<uint8_t> data = b.data();
+    memcpy(&data[target_offset], out_block_pc, sizeof(*out_block_pc));
+    return data;
+  };
+  uint32_t v1_block_pc = 0;
+  std::vector<uint8_t> v1 = build(IREE_VM_BYTECODE_VERSION_1, &v1_block_pc);
+  uint32_t v2_block_pc = 0;
+  std::vector<uint8_t> v2 = build(IREE_VM_BYTECODE_VERSION_2, &v2_block_pc);
+
+  AddImport(IREE_SV("0ri_ir"));
+  AddFunction(BytecodeBuilder(), 2, 2, IREE_SV("0v_ri"));
+  bytecode_[0] = v1;
+  IREE_ASSERT_OK(Transcode());
+  EXPECT_EQ(TranscodedBytecode(0), v2);
+  EXPECT_EQ(transcoded_.functions[0].bytecode_offset % 8, 0u);
+
+  // Instructions map back to their original pcs.
+  EXPECT_EQ(iree_vm_bytecode_transcoded_module_map_pc(&transcoded_, 0, 0), 0u);
+  EXPECT_EQ(
+      iree_vm_bytecode_transcoded_module_map_pc(&transcoded_, 0, v2_block_pc),
+      v1_block_pc);
+
+  // The transcoded bytecode verifies as version 2.
+  bytecode_[0] = v2;
+  IREE_EXPECT_OK(Verify());
+
+  // Transcoding verifies the original bytecode.
+  bytecode_[0] = v1;
+  import_cconvs_[0] = IREE_SV("0ii_ir");
+  EXPECT_THAT(Status(Transcode()), StatusIs(StatusCode::kInvalidArgument));
+}
+
+}  // namespace
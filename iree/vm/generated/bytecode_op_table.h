@@ -49,7 +49,7 @@ typedef enum {
   IREE_VM_OP_CORE_RemI32S = 0x27,
   IREE_VM_OP_CORE_RemI32U = 0x28,
   IREE_VM_OP_CORE_FMAI32 = 0x29,
-  IREE_VM_OP_CORE_RSV_0x2A,
+  IREE_VM_OP_CORE_AddI32Imm = 0x2A,
   IREE_VM_OP_CORE_RSV_0x2B,
   IREE_VM_OP_CORE_RSV_0x2C,
   IREE_VM_OP_CORE_RSV_0x2D,
@@ -93,10 +93,10 @@ typedef enum {
   IREE_VM_OP_CORE_CallVariadic = 0x53,
   IREE_VM_OP_CORE_Return = 0x54,
   IREE_VM_OP_CORE_Fail = 0x55,
-  IREE_VM_OP_CORE_RSV_0x56,
-  IREE_VM_OP_CORE_RSV_0x57,
-  IREE_VM_OP_CORE_RSV_0x58,
-  IREE_VM_OP_CORE_RSV_0x59,
+  IREE_VM_OP_CORE_CondBranchCmpEQI32 = 0x56,
+  IREE_VM_OP_CORE_CondBranchCmpNEI32 = 0x57,
+  IREE_VM_OP_CORE_CondBranchCmpLTI32S = 0x58,
+  IREE_VM_OP_CORE_CondBranchCmpLTI32U = 0x59,
   IREE_VM_OP_CORE_RSV_0x5A,
   IREE_VM_OP_CORE_RSV_0x5B,
   IREE_VM_OP_CORE_RSV_0x5C,
@@ -308,7 +308,7 @@ typedef enum {
     OPC(0x27, RemI32S) \
     OPC(0x28, RemI32U) \
     OPC(0x29, FMAI32) \
-    RSV(0x2A) \
+    OPC(0x2A, AddI32Imm) \
     RSV(0x2B) \
     RSV(0x2C) \
     RSV(0x2D) \
@@ -352,10 +352,10 @@ typedef enum {
     OPC(0x53, CallVariadic) \
     OPC(0x54, Return) \
     OPC(0x55, Fail) \
-    RSV(0x56) \
-    RSV(0x57) \
-    RSV(0x58) \
-    RSV(0x59) \
+    OPC(0x56, CondBranchCmpEQI32) \
+    OPC(0x57, CondBranchCmpNEI32) \
+    OPC(0x58, CondBranchCmpLTI32S) \
+    OPC(0x59, CondBranchCmpLTI32U) \
     RSV(0x5A) \
     RSV(0x5B) \
     RSV(0x5C) \
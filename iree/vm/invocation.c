@@ -11,21 +11,28 @@
 #include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
 #include "iree/base/tracing.h"
 #include "iree/vm/ref.h"
 #include "iree/vm/stack.h"
 #include "iree/vm/value.h"
 
+// Returns the number of values in a non-variadic cconv fragment.
+static iree_host_size_t iree_vm_invoke_cconv_count(
+    iree_string_view_t cconv_fragment) {
+  return cconv_fragment.size > 0
+             ? (cconv_fragment.data[0] == 'v' ? 0 : cconv_fragment.size)
+             : 0;
+}
+
 // Marshals caller arguments from the variant list to the ABI convention.
 static iree_status_t iree_vm_invoke_marshal_inputs(
-    iree_string_view_t cconv_arguments, iree_vm_list_t* inputs,
+    iree_string_view_t cconv_arguments, const iree_vm_list_t* inputs,
     iree_byte_span_t arguments) {
   // We are 1:1 right now with no variadic args, so do a quick verification on
   // the input list.
   iree_host_size_t expected_input_count =
-      cconv_arguments.size > 0
-          ? (cconv_arguments.data[0] == 'v' ? 0 : cconv_arguments.size)
-          : 0;
+      iree_vm_invoke_cconv_count(cconv_arguments);
   if (IREE_UNLIKELY(!inputs)) {
     if (IREE_UNLIKELY(expected_input_count > 0)) {
       return iree_make_status(
@@ -91,9 +98,7 @@ static iree_status_t iree_vm_invoke_marshal_outputs(
     iree_string_view_t cconv_results, iree_byte_span_t results,
     iree_vm_list_t* outputs) {
   iree_host_size_t expected_output_count =
-      cconv_results.size > 0
-          ? (cconv_results.data[0] == 'v' ? 0 : cconv_results.size)
-          : 0;
+      iree_vm_invoke_cconv_count(cconv_results);
   if (IREE_UNLIKELY(!outputs)) {
     if (IREE_UNLIKELY(expected_output_count > 0)) {
       return iree_make_status(
@@ -144,6 +149,19 @@ static iree_status_t iree_vm_invoke_marshal_outputs(
   return iree_ok_status();
 }
 
+// Continues a |call| that yielded on |stack|. Calls that left their frames on
+// the stack are resumed while calls that unwound them before yielding (such as
+// native functions waiting with iree_vm_stack_wait) are reissued.
+static iree_status_t iree_vm_invoke_continue(
+    iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
+    iree_vm_execution_result_t* out_result) {
+  iree_vm_module_t* module = call->function.module;
+  if (iree_vm_stack_current_frame(stack)) {
+    return module->resume_call(module->self, stack, call, out_result);
+  }
+  return module->begin_call(module->self, stack, call, out_result);
+}
+
 // TODO(benvanik): implement this as an iree_vm_invocation_t sequence.
 static iree_status_t iree_vm_invoke_within(
     iree_vm_context_t* context, iree_vm_stack_t* stack,
@@ -177,8 +195,9 @@ static iree_status_t iree_vm_invoke_within(
   results.data = iree_alloca(results.data_length);
   memset(results.data, 0, results.data_length);
 
-  // Perform execution. Note that for synchronous execution we expect this to
-  // complete without yielding.
+  // Perform execution. Calls on asynchronous stacks yield when they need to
+  // wait and since this is a synchronous invocation we block until they can
+  // continue.
   iree_vm_function_call_t call;
   memset(&call, 0, sizeof(call));
   call.function = function;
@@ -187,6 +206,16 @@ static iree_status_t iree_vm_invoke_within(
   iree_vm_execution_result_t result;
   iree_status_t status =
       function.module->begin_call(function.module->self, stack, &call, &result);
+  while (iree_status_is_deferred(status)) {
+    iree_wait_source_t wait_source = iree_wait_source_immediate();
+    iree_time_t deadline_ns = IREE_TIME_INFINITE_PAST;
+    if (iree_vm_stack_pending_wait(stack, &wait_source, &deadline_ns)) {
+      // Failures are observed by the waiter when it is reissued.
+      iree_status_ignore(iree_wait_source_wait_one(
+          wait_source, iree_make_deadline(deadline_ns)));
+    }
+    status = iree_vm_invoke_continue(stack, &call, &result);
+  }
   if (!iree_status_is_ok(status)) {
     iree_vm_function_call_release(&call, &signature);
     return status;
@@ -224,3 +253,327 @@ IREE_API_EXPORT iree_status_t iree_vm_invoke(
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
+
+//===----------------------------------------------------------------------===//
+// iree_vm_invocation_t
+//===----------------------------------------------------------------------===//
+
+struct iree_vm_invocation_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t allocator;
+
+  // Retained context the function is invoked within.
+  iree_vm_context_t* context;
+  iree_vm_function_signature_t signature;
+  iree_string_view_t cconv_arguments;
+  iree_string_view_t cconv_results;
+
+  // Call with argument and result buffers stored inline after the invocation.
+  iree_vm_function_call_t call;
+
+  // Stack preserving the execution state across suspensions. Emptied once the
+  // invocation completes and retained (along with any storage it grew) for
+  // reuse by iree_vm_invocation_reset.
+  iree_vm_stack_t* stack;
+
+  // True once the call has begun executing and must be continued instead.
+  bool started;
+
+  // Set by iree_vm_invocation_abort from any thread.
+  iree_atomic_int32_t abort_requested;
+
+  // Set with release semantics after |completion_status| and |outputs| are
+  // populated so that they can be queried from other threads.
+  iree_atomic_int32_t completed;
+  iree_status_t completion_status;
+
+  // Output list populated on completion. Reused across resets.
+  iree_vm_list_t* outputs;
+};
+
+IREE_API_EXPORT iree_status_t iree_vm_invocation_create(
+    iree_vm_context_t* context, iree_vm_function_t function,
+    iree_vm_invocation_flags_t flags, const iree_vm_invocation_policy_t* policy,
+    const iree_vm_list_t* inputs, iree_allocator_t allocator,
+    iree_vm_invocation_t** out_invocation) {
+  IREE_ASSERT_ARGUMENT(context);
+  IREE_ASSERT_ARGUMENT(out_invocation);
+  *out_invocation = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Force tracing if specified on the context.
+  if (iree_vm_context_flags(context) & IREE_VM_CONTEXT_FLAG_TRACE_EXECUTION) {
+    flags |= IREE_VM_INVOCATION_FLAG_TRACE_EXECUTION;
+  }
+  flags |= IREE_VM_INVOCATION_FLAG_ASYNC;
+
+  // Size the argument and result buffers so that they can be stored inline.
+  // NOTE: today we don't support variadic arguments through this interface.
+  iree_vm_function_signature_t signature =
+      iree_vm_function_signature(&function);
+  iree_string_view_t cconv_arguments = iree_string_view_empty();
+  iree_string_view_t cconv_results = iree_string_view_empty();
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_function_call_get_cconv_fragments(
+              &signature, &cconv_arguments, &cconv_results));
+  iree_host_size_t arguments_size = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_function_call_compute_cconv_fragment_size(
+              cconv_arguments, /*segment_size_list=*/NULL, &arguments_size));
+  iree_host_size_t results_size = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_function_call_compute_cconv_fragment_size(
+              cconv_results, /*segment_size_list=*/NULL, &results_size));
+
+  iree_vm_invocation_t* invocation = NULL;
+  iree_host_size_t header_size = iree_host_align(sizeof(*invocation), 16);
+  iree_host_size_t total_size = header_size +
+                                iree_host_align(arguments_size, 16) +
+                                results_size;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(allocator, total_size, (void**)&invocation));
+  memset(invocation, 0, total_size);
+  iree_atomic_ref_count_init(&invocation->ref_count);
+  invocation->allocator = allocator;
+  invocation->context = context;
+  iree_vm_context_retain(context);
+  invocation->signature = signature;
+  invocation->cconv_arguments = cconv_arguments;
+  invocation->cconv_results = cconv_results;
+  invocation->call.function = function;
+  invocation->call.arguments =
+      iree_make_byte_span((uint8_t*)invocation + header_size, arguments_size);
+  invocation->call.results = iree_make_byte_span(
+      invocation->call.arguments.data + iree_host_align(arguments_size, 16),
+      results_size);
+
+  // Capture the inputs now so the caller is free to reuse the list.
+  iree_status_t status = iree_vm_invoke_marshal_inputs(
+      cconv_arguments, inputs, invocation->call.arguments);
+  if (iree_status_is_ok(status)) {
+    // Reserve the outputs now so that completion does not need to allocate.
+    status = iree_vm_list_create(
+        /*element_type=*/NULL, iree_vm_invoke_cconv_count(cconv_results),
+        allocator, &invocation->outputs);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_vm_stack_allocate(flags,
+                                    iree_vm_context_state_resolver(context),
+                                    allocator, &invocation->stack);
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_invocation = invocation;
+  } else {
+    iree_vm_invocation_release(invocation);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Completes |invocation| with |status|, marshaling outputs on success and
+// releasing all execution state.
+static void iree_vm_invocation_complete(iree_vm_invocation_t* invocation,
+                                        iree_status_t status) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  if (iree_status_is_ok(status)) {
+    status = iree_vm_invoke_marshal_outputs(invocation->cconv_results,
+                                            invocation->call.results,
+                                            invocation->outputs);
+  } else if (invocation->stack) {
+    status = IREE_VM_STACK_ANNOTATE_BACKTRACE_IF_ENABLED(invocation->stack,
+                                                         status);
+  }
+
+  // Drop any arguments or results not consumed by the callee or marshaling.
+  iree_vm_function_call_release(&invocation->call, &invocation->signature);
+
+  // Tears down any frames remaining from a failed or aborted call while
+  // keeping the stack storage for reuse.
+  if (invocation->stack) {
+    iree_vm_stack_reset(invocation->stack);
+  }
+
+  invocation->completion_status = status;
+  iree_atomic_store_int32(&invocation->completed, 1, iree_memory_order_release);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static bool iree_vm_invocation_is_completed(iree_vm_invocation_t* invocation) {
+  return iree_atomic_load_int32(&invocation->completed,
+                                iree_memory_order_acquire) != 0;
+}
+
+static void iree_vm_invocation_destroy(iree_vm_invocation_t* invocation) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_allocator_t allocator = invocation->allocator;
+  if (!iree_vm_invocation_is_completed(invocation)) {
+    iree_vm_invocation_complete(invocation,
+                                iree_status_from_code(IREE_STATUS_ABORTED));
+  }
+  iree_status_ignore(invocation->completion_status);
+  if (invocation->stack) {
+    iree_vm_stack_free(invocation->stack);
+  }
+  iree_vm_list_release(invocation->outputs);
+  iree_vm_context_release(invocation->context);
+  iree_allocator_free(allocator, invocation);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_invocation_reset(
+    iree_vm_invocation_t* invocation, const iree_vm_list_t* inputs) {
+  IREE_ASSERT_ARGUMENT(invocation);
+  if (!iree_vm_invocation_is_completed(invocation)) {
+    if (invocation->started) {
+      return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                              "invocation is in-flight and cannot be reset");
+    }
+    // Drop the inputs captured for the run that never started.
+    iree_vm_function_call_release(&invocation->call, &invocation->signature);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Release the outputs of the previous run; the list keeps its storage.
+  iree_status_ignore(invocation->completion_status);
+  invocation->completion_status = iree_ok_status();
+  iree_status_t status = iree_vm_list_resize(invocation->outputs, 0);
+
+  memset(invocation->call.arguments.data, 0,
+         invocation->call.arguments.data_length);
+  memset(invocation->call.results.data, 0,
+         invocation->call.results.data_length);
+  if (iree_status_is_ok(status)) {
+    status = iree_vm_invoke_marshal_inputs(invocation->cconv_arguments, inputs,
+                                           invocation->call.arguments);
+  }
+  invocation->started = false;
+  iree_atomic_store_int32(&invocation->abort_requested, 0,
+                          iree_memory_order_relaxed);
+
+  if (iree_status_is_ok(status)) {
+    iree_atomic_store_int32(&invocation->completed, 0,
+                            iree_memory_order_release);
+  } else {
+    // Leave the invocation completed with the failure so that it can be reset
+    // again once the caller has fixed its inputs.
+    iree_vm_invocation_complete(invocation, iree_status_clone(status));
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT void iree_vm_invocation_retain(
+    iree_vm_invocation_t* invocation) {
+  if (invocation) {
+    iree_atomic_ref_count_inc(&invocation->ref_count);
+  }
+}
+
+IREE_API_EXPORT void iree_vm_invocation_release(
+    iree_vm_invocation_t* invocation) {
+  if (invocation && iree_atomic_ref_count_dec(&invocation->ref_count) == 1) {
+    iree_vm_invocation_destroy(invocation);
+  }
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_invocation_resume(
+    iree_vm_invocation_t* invocation, iree_wait_source_t* out_wait_source,
+    iree_time_t* out_deadline_ns) {
+  IREE_ASSERT_ARGUMENT(invocation);
+  if (out_wait_source) *out_wait_source = iree_wait_source_immediate();
+  if (out_deadline_ns) *out_deadline_ns = IREE_TIME_INFINITE_PAST;
+  if (iree_vm_invocation_is_completed(invocation)) return iree_ok_status();
+  if (iree_atomic_load_int32(&invocation->abort_requested,
+                             iree_memory_order_acquire)) {
+    iree_vm_invocation_complete(invocation,
+                                iree_status_from_code(IREE_STATUS_ABORTED));
+    return iree_ok_status();
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_vm_execution_result_t result;
+  iree_status_t status = iree_ok_status();
+  if (!invocation->started) {
+    invocation->started = true;
+    iree_vm_module_t* module = invocation->call.function.module;
+    status = module->begin_call(module->self, invocation->stack,
+                                &invocation->call, &result);
+  } else {
+    status =
+        iree_vm_invoke_continue(invocation->stack, &invocation->call, &result);
+  }
+
+  if (iree_status_is_deferred(status)) {
+    if (iree_atomic_load_int32(&invocation->abort_requested,
+                               iree_memory_order_acquire)) {
+      iree_vm_invocation_complete(invocation,
+                                  iree_status_from_code(IREE_STATUS_ABORTED));
+      IREE_TRACE_ZONE_END(z0);
+      return iree_ok_status();
+    }
+    // Suspended; invocations that yield without waiting keep the immediate
+    // wait source so that they are resumed as soon as possible.
+    iree_vm_stack_pending_wait(invocation->stack, out_wait_source,
+                               out_deadline_ns);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  iree_vm_invocation_complete(invocation, status);
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t
+iree_vm_invocation_query_status(iree_vm_invocation_t* invocation) {
+  IREE_ASSERT_ARGUMENT(invocation);
+  if (!iree_vm_invocation_is_completed(invocation)) {
+    return iree_status_from_code(IREE_STATUS_UNAVAILABLE);
+  }
+  return iree_status_clone(invocation->completion_status);
+}
+
+IREE_API_EXPORT const iree_vm_list_t* iree_vm_invocation_output(
+    iree_vm_invocation_t* invocation) {
+  IREE_ASSERT_ARGUMENT(invocation);
+  if (!iree_vm_invocation_is_completed(invocation) ||
+      !iree_status_is_ok(invocation->completion_status)) {
+    return NULL;
+  }
+  return invocation->outputs;
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_invocation_await(
+    iree_vm_invocation_t* invocation, iree_time_t deadline) {
+  IREE_ASSERT_ARGUMENT(invocation);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  while (true) {
+    iree_wait_source_t wait_source = iree_wait_source_immediate();
+    iree_time_t wait_deadline_ns = IREE_TIME_INFINITE_PAST;
+    iree_status_t status = iree_vm_invocation_resume(invocation, &wait_source,
+                                                     &wait_deadline_ns);
+    if (!iree_status_is_deferred(status)) break;
+
+    // Block until the invocation can make progress. Failed waits are observed
+    // by the invocation when it resumes.
+    iree_time_t next_deadline_ns =
+        wait_deadline_ns < deadline ? wait_deadline_ns : deadline;
+    iree_status_ignore(iree_wait_source_wait_one(
+        wait_source, iree_make_deadline(next_deadline_ns)));
+    if (deadline != IREE_TIME_INFINITE_FUTURE && iree_time_now() >= deadline) {
+      IREE_TRACE_ZONE_END(z0);
+      return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    }
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return iree_vm_invocation_query_status(invocation);
+}
+
+IREE_API_EXPORT iree_status_t
+iree_vm_invocation_abort(iree_vm_invocation_t* invocation) {
+  IREE_ASSERT_ARGUMENT(invocation);
+  iree_atomic_store_int32(&invocation->abort_requested, 1,
+                          iree_memory_order_release);
+  return iree_ok_status();
+}
@@ -40,20 +40,72 @@ IREE_API_EXPORT iree_status_t iree_vm_invoke(
     iree_vm_list_t* inputs, iree_vm_list_t* outputs,
     iree_allocator_t allocator);
 
-// TODO(benvanik): document and implement.
+// Creates an asynchronous invocation of |function| in the VM.
+//
+// Unlike iree_vm_invoke the invocation does not execute on the calling thread
+// until the caller (or whichever scheduler it hands the invocation to) calls
+// iree_vm_invocation_resume or iree_vm_invocation_await. When the invocation
+// needs to wait (such as on a HAL semaphore) it suspends with its VM stack
+// preserved and reports what it is waiting on so that a small number of
+// threads can multiplex many in-flight invocations.
+//
+// |policy| is used to schedule the invocation relative to other pending or
+// in-flight invocations. It may be omitted to leave the behavior up to the
+// implementation.
+//
+// |inputs| is used to pass values and objects into the target function and must
+// match the signature defined by the compiled function. The contents are
+// captured by the invocation and list ownership remains with the caller.
 IREE_API_EXPORT iree_status_t iree_vm_invocation_create(
     iree_vm_context_t* context, iree_vm_function_t function,
     iree_vm_invocation_flags_t flags, const iree_vm_invocation_policy_t* policy,
     const iree_vm_list_t* inputs, iree_allocator_t allocator,
     iree_vm_invocation_t** out_invocation);
 
+// Resets a completed |invocation| so that its function can be invoked again
+// with |inputs| as if it had been newly created.
+//
+// The invocation keeps its stack, argument and result buffers, and output list
+// across resets so that repeatedly invoking the same function does not
+// allocate: resetting and running an invocation only retains and releases the
+// refs passed in and out of the function (in addition to whatever the function
+// itself does). This is the preferred way to invoke the same function many
+// times, such as when serving requests against a loaded model.
+//
+// |inputs| is used as with iree_vm_invocation_create and the caller may reuse
+// the list. Outputs of the previous run are released.
+//
+// Returns IREE_STATUS_FAILED_PRECONDITION if the invocation has begun running
+// but has not yet completed.
+IREE_API_EXPORT iree_status_t iree_vm_invocation_reset(
+    iree_vm_invocation_t* invocation, const iree_vm_list_t* inputs);
+
 // Retains the given |invocation| for the caller.
-IREE_API_EXPORT iree_status_t
-iree_vm_invocation_retain(iree_vm_invocation_t* invocation);
+IREE_API_EXPORT void iree_vm_invocation_retain(
+    iree_vm_invocation_t* invocation);
 
 // Releases the given |invocation| from the caller.
-IREE_API_EXPORT iree_status_t
-iree_vm_invocation_release(iree_vm_invocation_t* invocation);
+// Releasing an invocation that has not yet completed aborts it.
+IREE_API_EXPORT void iree_vm_invocation_release(
+    iree_vm_invocation_t* invocation);
+
+// Runs the invocation on the calling thread until it either completes or
+// suspends.
+//
+// Returns IREE_STATUS_DEFERRED if the invocation suspended. |out_wait_source|
+// and |out_deadline_ns| (both optional) receive the wait source the invocation
+// is waiting on and the absolute deadline of the wait: the invocation should
+// be resumed once the wait source resolves or the deadline elapses, whichever
+// comes first. The wait source is only valid until the invocation is resumed.
+// Invocations that yield without waiting report an immediate wait source.
+//
+// Returns IREE_STATUS_OK once the invocation has completed (successfully or
+// otherwise); use iree_vm_invocation_query_status to get the result.
+//
+// Must not be called concurrently on the same invocation.
+IREE_API_EXPORT iree_status_t iree_vm_invocation_resume(
+    iree_vm_invocation_t* invocation, iree_wait_source_t* out_wait_source,
+    iree_time_t* out_deadline_ns);
 
 // Queries the completion status of the invocation.
 // Returns one of the following:
@@ -62,27 +114,35 @@ iree_vm_invocation_release(iree_vm_invocation_t* invocation);
 //   IREE_STATUS_CANCELLED: the invocation was cancelled internally.
 //   IREE_STATUS_ABORTED: the invocation was aborted.
 //   IREE_STATUS_*: an error occurred during invocation.
+//
+// Safe to call from any thread.
 IREE_API_EXPORT iree_status_t
 iree_vm_invocation_query_status(iree_vm_invocation_t* invocation);
 
 // Returns a reference to the output of the invocation.
 // The returned structure is valid for the lifetime of the invocation and
 // callers must retain any refs they want to outlive the invocation once
-// released.
+// released or reset.
 //
 // Returns NULL if the invocation did not complete successfully.
 IREE_API_EXPORT const iree_vm_list_t* iree_vm_invocation_output(
     iree_vm_invocation_t* invocation);
 
-// Blocks the caller until the invocation completes (successfully or otherwise).
+// Runs the invocation on the calling thread until it completes (successfully or
+// otherwise), blocking the thread whenever the invocation suspends.
 //
 // Returns IREE_STATUS_DEADLINE_EXCEEDED if |deadline| elapses before the
 // invocation completes and otherwise returns iree_vm_invocation_query_status.
+// The invocation remains suspended and may be resumed or awaited again.
 IREE_API_EXPORT iree_status_t iree_vm_invocation_await(
     iree_vm_invocation_t* invocation, iree_time_t deadline);
 
 // Attempts to abort the invocation if it is in-flight.
-// A no-op if the invocation has already completed.
+// A no-op if the invocation has already completed. An invocation that is
+// running completes with IREE_STATUS_ABORTED the next time it suspends and a
+// suspended invocation does so the next time it is resumed.
+//
+// Safe to call from any thread.
 IREE_API_EXPORT iree_status_t
 iree_vm_invocation_abort(iree_vm_invocation_t* invocation);
 
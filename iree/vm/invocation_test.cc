@@ -0,0 +1,400 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/vm/invocation.h"
+
+#include <cstring>
+
+#include "iree/base/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/context.h"
+#include "iree/vm/instance.h"
+#include "iree/vm/list.h"
+#include "iree/vm/native_module.h"
+#include "iree/vm/stack.h"
+#include "iree/vm/value.h"
+
+namespace {
+
+//===----------------------------------------------------------------------===//
+// Test wait source
+//===----------------------------------------------------------------------===//
+
+// A wait source that resolves once signaled by the test.
+// If |signal_on_wait| is set then blocking waits signal it immediately to
+// simulate the wait completing; otherwise they time out.
+typedef struct test_wait_state_t {
+  bool signaled;
+  bool signal_on_wait;
+  int wait_count;
+} test_wait_state_t;
+
+static iree_status_t test_wait_source_ctl(iree_wait_source_t wait_source,
+                                          iree_wait_source_command_t command,
+                                          const void* params,
+                                          void** inout_ptr) {
+  test_wait_state_t* state = (test_wait_state_t*)wait_source.self;
+  switch (command) {
+    case IREE_WAIT_SOURCE_COMMAND_QUERY:
+      *(iree_status_code_t*)inout_ptr =
+          state->signaled ? IREE_STATUS_OK : IREE_STATUS_DEFERRED;
+      return iree_ok_status();
+    case IREE_WAIT_SOURCE_COMMAND_WAIT_ONE:
+      ++state->wait_count;
+      if (state->signal_on_wait) state->signaled = true;
+      return state->signaled
+                 ? iree_ok_status()
+                 : iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED);
+  }
+}
+
+// The wait state used by the module; set by the test fixture.
+static test_wait_state_t* test_wait_state = NULL;
+
+static iree_wait_source_t test_wait_source(void) {
+  iree_wait_source_t wait_source;
+  memset(&wait_source, 0, sizeof(wait_source));
+  wait_source.self = test_wait_state;
+  wait_source.ctl = test_wait_source_ctl;
+  return wait_source;
+}
+
+//===----------------------------------------------------------------------===//
+// test_module
+//===----------------------------------------------------------------------===//
+
+typedef iree_status_t (*call_i32_i32_t)(iree_vm_stack_t* stack,
+                                        void* module_ptr, void* module_state,
+                                        int32_t arg0, int32_t* out_ret0);
+
+static iree_status_t call_shim_i32_i32(iree_vm_stack_t* stack,
+                                       const iree_vm_function_call_t* call,
+                                       call_i32_i32_t target_fn, void* module,
+                                       void* module_state,
+                                       iree_vm_execution_result_t* out_result) {
+  const int32_t* args = (const int32_t*)call->arguments.data;
+  int32_t* results = (int32_t*)call->results.data;
+  return target_fn(stack, module, module_state, args[0], &results[0]);
+}
+
+// Waits on the test wait source and then returns arg0 + 1.
+static iree_status_t test_module_wait_add_1(iree_vm_stack_t* stack,
+                                            void* module, void* module_state,
+                                            int32_t arg0, int32_t* out_ret0) {
+  IREE_RETURN_IF_ERROR(
+      iree_vm_stack_wait(stack, test_wait_source(), iree_infinite_timeout()));
+  *out_ret0 = arg0 + 1;
+  return iree_ok_status();
+}
+
+static const iree_vm_native_export_descriptor_t test_module_exports_[] = {
+    {iree_make_cstring_view("wait_add_1"), iree_make_cstring_view("0i_i"), 0,
+     NULL},
+};
+static const iree_vm_native_function_ptr_t test_module_funcs_[] = {
+    {(iree_vm_native_function_shim_t)call_shim_i32_i32,
+     (iree_vm_native_function_target_t)test_module_wait_add_1},
+};
+static const iree_vm_native_module_descriptor_t test_module_descriptor_ = {
+    iree_make_cstring_view("test_module"),
+    0,
+    NULL,
+    IREE_ARRAYSIZE(test_module_exports_),
+    test_module_exports_,
+    IREE_ARRAYSIZE(test_module_funcs_),
+    test_module_funcs_,
+    0,
+    NULL,
+};
+
+//===----------------------------------------------------------------------===//
+// Tests
+//===----------------------------------------------------------------------===//
+
+class VMInvocationTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    memset(&wait_state_, 0, sizeof(wait_state_));
+    test_wait_state = &wait_state_;
+
+    IREE_ASSERT_OK(
+        iree_vm_instance_create(iree_allocator_system(), &instance_));
+    iree_vm_module_t interface;
+    IREE_ASSERT_OK(iree_vm_module_initialize(&interface, NULL));
+    iree_vm_module_t* module = NULL;
+    IREE_ASSERT_OK(iree_vm_native_module_create(
+        &interface, &test_module_descriptor_, iree_allocator_system(),
+        &module));
+    IREE_ASSERT_OK(iree_vm_context_create_with_modules(
+        instance_, IREE_VM_CONTEXT_FLAG_NONE, &module, 1,
+        iree_allocator_system(), &context_));
+    iree_vm_module_release(module);
+    IREE_ASSERT_OK(iree_vm_context_resolve_function(
+        context_, iree_make_cstring_view("test_module.wait_add_1"),
+        &function_));
+
+    IREE_ASSERT_OK(iree_vm_list_create(/*element_type=*/NULL, 1,
+                                       iree_allocator_system(), &inputs_));
+    iree_vm_value_t arg0 = iree_vm_value_make_i32(5);
+    IREE_ASSERT_OK(iree_vm_list_push_value(inputs_, &arg0));
+  }
+
+  void TearDown() override {
+    iree_vm_list_release(inputs_);
+    iree_vm_context_release(context_);
+    iree_vm_instance_release(instance_);
+    test_wait_state = NULL;
+  }
+
+  iree_vm_invocation_t* CreateInvocation() {
+    iree_vm_invocation_t* invocation = NULL;
+    IREE_CHECK_OK(iree_vm_invocation_create(
+        context_, function_, IREE_VM_INVOCATION_FLAG_NONE, /*policy=*/NULL,
+        inputs_, iree_allocator_system(), &invocation));
+    return invocation;
+  }
+
+  static int32_t GetResult(const iree_vm_list_t* outputs) {
+    iree_vm_value_t value;
+    IREE_CHECK_OK(iree_vm_list_get_value(outputs, 0, &value));
+    return value.i32;
+  }
+
+  test_wait_state_t wait_state_;
+  iree_vm_instance_t* instance_ = NULL;
+  iree_vm_context_t* context_ = NULL;
+  iree_vm_function_t function_;
+  iree_vm_list_t* inputs_ = NULL;
+};
+
+TEST_F(VMInvocationTest, SuspendsAndResumes) {
+  iree_vm_invocation_t* invocation = CreateInvocation();
+
+  // The invocation suspends on the unresolved wait source without blocking.
+  iree_wait_source_t wait_source = iree_wait_source_immediate();
+  iree_time_t deadline_ns = IREE_TIME_INFINITE_PAST;
+  EXPECT_EQ(IREE_STATUS_DEFERRED,
+            iree_status_consume_code(iree_vm_invocation_resume(
+                invocation, &wait_source, &deadline_ns)));
+  EXPECT_EQ(wait_source.ctl, test_wait_source_ctl);
+  EXPECT_EQ(deadline_ns, IREE_TIME_INFINITE_FUTURE);
+  EXPECT_EQ(wait_state_.wait_count, 0);
+  EXPECT_EQ(IREE_STATUS_UNAVAILABLE,
+            iree_status_consume_code(
+                iree_vm_invocation_query_status(invocation)));
+  EXPECT_EQ(iree_vm_invocation_output(invocation), nullptr);
+
+  // Spurious resumes suspend again.
+  EXPECT_EQ(IREE_STATUS_DEFERRED,
+            iree_status_consume_code(
+                iree_vm_invocation_resume(invocation, NULL, NULL)));
+
+  wait_state_.signaled = true;
+  IREE_EXPECT_OK(iree_vm_invocation_resume(invocation, &wait_source, NULL));
+  EXPECT_EQ(wait_source.ctl, nullptr);
+  IREE_EXPECT_OK(iree_vm_invocation_query_status(invocation));
+  EXPECT_EQ(GetResult(iree_vm_invocation_output(invocation)), 6);
+  EXPECT_EQ(wait_state_.wait_count, 0);
+
+  iree_vm_invocation_release(invocation);
+}
+
+TEST_F(VMInvocationTest, ManyInFlight) {
+  // A single thread can multiplex many suspended invocations.
+  iree_vm_invocation_t* invocations[16];
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(invocations); ++i) {
+    invocations[i] = CreateInvocation();
+    EXPECT_EQ(IREE_STATUS_DEFERRED,
+              iree_status_consume_code(
+                  iree_vm_invocation_resume(invocations[i], NULL, NULL)));
+  }
+  wait_state_.signaled = true;
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(invocations); ++i) {
+    IREE_EXPECT_OK(iree_vm_invocation_resume(invocations[i], NULL, NULL));
+    EXPECT_EQ(GetResult(iree_vm_invocation_output(invocations[i])), 6);
+    iree_vm_invocation_release(invocations[i]);
+  }
+}
+
+TEST_F(VMInvocationTest, Await) {
+  iree_vm_invocation_t* invocation = CreateInvocation();
+  wait_state_.signal_on_wait = true;
+  IREE_EXPECT_OK(
+      iree_vm_invocation_await(invocation, IREE_TIME_INFINITE_FUTURE));
+  EXPECT_EQ(wait_state_.wait_count, 1);
+  EXPECT_EQ(GetResult(iree_vm_invocation_output(invocation)), 6);
+  iree_vm_invocation_release(invocation);
+}
+
+TEST_F(VMInvocationTest, AwaitDeadlineExceeded) {
+  iree_vm_invocation_t* invocation = CreateInvocation();
+  EXPECT_EQ(IREE_STATUS_DEADLINE_EXCEEDED,
+            iree_status_consume_code(
+                iree_vm_invocation_await(invocation, IREE_TIME_INFINITE_PAST)));
+
+  // The invocation remains suspended and can be awaited again.
+  EXPECT_EQ(IREE_STATUS_UNAVAILABLE,
+            iree_status_consume_code(
+                iree_vm_invocation_query_status(invocation)));
+  wait_state_.signaled = true;
+  IREE_EXPECT_OK(
+      iree_vm_invocation_await(invocation, IREE_TIME_INFINITE_FUTURE));
+  EXPECT_EQ(GetResult(iree_vm_invocation_output(invocation)), 6);
+  iree_vm_invocation_release(invocation);
+}
+
+TEST_F(VMInvocationTest, Abort) {
+  iree_vm_invocation_t* invocation = CreateInvocation();
+  EXPECT_EQ(IREE_STATUS_DEFERRED,
+            iree_status_consume_code(
+                iree_vm_invocation_resume(invocation, NULL, NULL)));
+  IREE_EXPECT_OK(iree_vm_invocation_abort(invocation));
+  IREE_EXPECT_OK(iree_vm_invocation_resume(invocation, NULL, NULL));
+  EXPECT_EQ(IREE_STATUS_ABORTED,
+            iree_status_consume_code(
+                iree_vm_invocation_query_status(invocation)));
+  EXPECT_EQ(iree_vm_invocation_output(invocation), nullptr);
+  iree_vm_invocation_release(invocation);
+}
+
+TEST_F(VMInvocationTest, ReleaseSuspended) {
+  iree_vm_invocation_t* invocation = CreateInvocation();
+  EXPECT_EQ(IREE_STATUS_DEFERRED,
+            iree_status_consume_code(
+                iree_vm_invocation_resume(invocation, NULL, NULL)));
+  iree_vm_invocation_release(invocation);
+}
+
+TEST_F(VMInvocationTest, ResetReuses) {
+  iree_vm_invocation_t* invocation = CreateInvocation();
+  wait_state_.signal_on_wait = true;
+  IREE_EXPECT_OK(
+      iree_vm_invocation_await(invocation, IREE_TIME_INFINITE_FUTURE));
+  EXPECT_EQ(GetResult(iree_vm_invocation_output(invocation)), 6);
+
+  // Each reset runs the function again with the new inputs.
+  for (int32_t i = 0; i < 4; ++i) {
+    iree_vm_value_t arg0 = iree_vm_value_make_i32(i);
+    IREE_ASSERT_OK(iree_vm_list_set_value(inputs_, 0, &arg0));
+    IREE_ASSERT_OK(iree_vm_invocation_reset(invocation, inputs_));
+    EXPECT_EQ(IREE_STATUS_UNAVAILABLE,
+              iree_status_consume_code(
+                  iree_vm_invocation_query_status(invocation)));
+    EXPECT_EQ(iree_vm_invocation_output(invocation), nullptr);
+    IREE_EXPECT_OK(
+        iree_vm_invocation_await(invocation, IREE_TIME_INFINITE_FUTURE));
+    EXPECT_EQ(GetResult(iree_vm_invocation_output(invocation)), i + 1);
+  }
+  iree_vm_invocation_release(invocation);
+}
+
+TEST_F(VMInvocationTest, ResetAfterAbort) {
+  iree_vm_invocation_t* invocation = CreateInvocation();
+  EXPECT_EQ(IREE_STATUS_DEFERRED,
+            iree_status_consume_code(
+                iree_vm_invocation_resume(invocation, NULL, NULL)));
+  IREE_EXPECT_OK(iree_vm_invocation_abort(invocation));
+  IREE_EXPECT_OK(iree_vm_invocation_resume(invocation, NULL, NULL));
+  EXPECT_EQ(IREE_STATUS_ABORTED,
+            iree_status_consume_code(
+                iree_vm_invocation_query_status(invocation)));
+
+  // The abort request does not carry over to the next run.
+  IREE_ASSERT_OK(iree_vm_invocation_reset(invocation, inputs_));
+  wait_state_.signaled = true;
+  IREE_EXPECT_OK(iree_vm_invocation_resume(invocation, NULL, NULL));
+  IREE_EXPECT_OK(iree_vm_invocation_query_status(invocation));
+  EXPECT_EQ(GetResult(iree_vm_invocation_output(invocation)), 6);
+  iree_vm_invocation_release(invocation);
+}
+
+TEST_F(VMInvocationTest, ResetBeforeStart) {
+  iree_vm_invocation_t* invocation = CreateInvocation();
+  iree_vm_value_t arg0 = iree_vm_value_make_i32(10);
+  IREE_ASSERT_OK(iree_vm_list_set_value(inputs_, 0, &arg0));
+  IREE_ASSERT_OK(iree_vm_invocation_reset(invocation, inputs_));
+  wait_state_.signal_on_wait = true;
+  IREE_EXPECT_OK(
+      iree_vm_invocation_await(invocation, IREE_TIME_INFINITE_FUTURE));
+  EXPECT_EQ(GetResult(iree_vm_invocation_output(invocation)), 11);
+  iree_vm_invocation_release(invocation);
+}
+
+TEST_F(VMInvocationTest, ResetInFlightFails) {
+  iree_vm_invocation_t* invocation = CreateInvocation();
+  EXPECT_EQ(IREE_STATUS_DEFERRED,
+            iree_status_consume_code(
+                iree_vm_invocation_resume(invocation, NULL, NULL)));
+  EXPECT_EQ(IREE_STATUS_FAILED_PRECONDITION,
+            iree_status_consume_code(
+                iree_vm_invocation_reset(invocation, inputs_)));
+
+  // The suspended invocation is unaffected.
+  wait_state_.signaled = true;
+  IREE_EXPECT_OK(iree_vm_invocation_resume(invocation, NULL, NULL));
+  EXPECT_EQ(GetResult(iree_vm_invocation_output(invocation)), 6);
+  iree_vm_invocation_release(invocation);
+}
+
+TEST_F(VMInvocationTest, ResetWithMismatchedInputs) {
+  iree_vm_invocation_t* invocation = CreateInvocation();
+  wait_state_.signal_on_wait = true;
+  IREE_EXPECT_OK(
+      iree_vm_invocation_await(invocation, IREE_TIME_INFINITE_FUTURE));
+
+  // Failing to marshal the inputs leaves the invocation completed with the
+  // error and it can be reset again.
+  iree_vm_list_t* empty_inputs = NULL;
+  IREE_ASSERT_OK(iree_vm_list_create(/*element_type=*/NULL, 0,
+                                     iree_allocator_system(), &empty_inputs));
+  EXPECT_EQ(IREE_STATUS_INVALID_ARGUMENT,
+            iree_status_consume_code(
+                iree_vm_invocation_reset(invocation, empty_inputs)));
+  EXPECT_EQ(IREE_STATUS_INVALID_ARGUMENT,
+            iree_status_consume_code(
+                iree_vm_invocation_query_status(invocation)));
+  iree_vm_list_release(empty_inputs);
+
+  IREE_ASSERT_OK(iree_vm_invocation_reset(invocation, inputs_));
+  IREE_EXPECT_OK(
+      iree_vm_invocation_await(invocation, IREE_TIME_INFINITE_FUTURE));
+  EXPECT_EQ(GetResult(iree_vm_invocation_output(invocation)), 6);
+  iree_vm_invocation_release(invocation);
+}
+
+TEST_F(VMInvocationTest, SynchronousInvokeBlocks) {
+  wait_state_.signal_on_wait = true;
+  iree_vm_list_t* outputs = NULL;
+  IREE_ASSERT_OK(iree_vm_list_create(/*element_type=*/NULL, 1,
+                                     iree_allocator_system(), &outputs));
+  IREE_ASSERT_OK(iree_vm_invoke(context_, function_,
+                                IREE_VM_INVOCATION_FLAG_NONE,
+                                /*policy=*/NULL, inputs_, outputs,
+                                iree_allocator_system()));
+  EXPECT_EQ(wait_state_.wait_count, 1);
+  EXPECT_EQ(GetResult(outputs), 6);
+  iree_vm_list_release(outputs);
+}
+
+TEST_F(VMInvocationTest, SynchronousInvokeOfAsyncStack) {
+  // Async stacks yield on waits and iree_vm_invoke blocks for them.
+  wait_state_.signal_on_wait = true;
+  iree_vm_list_t* outputs = NULL;
+  IREE_ASSERT_OK(iree_vm_list_create(/*element_type=*/NULL, 1,
+                                     iree_allocator_system(), &outputs));
+  IREE_ASSERT_OK(iree_vm_invoke(context_, function_,
+                                IREE_VM_INVOCATION_FLAG_ASYNC,
+                                /*policy=*/NULL, inputs_, outputs,
+                                iree_allocator_system()));
+  EXPECT_EQ(wait_state_.wait_count, 1);
+  EXPECT_EQ(GetResult(outputs), 6);
+  iree_vm_list_release(outputs);
+}
+
+}  // namespace
@@ -396,14 +396,24 @@ typedef struct iree_vm_module_t {
 
   // Begins a function call with the given |call| arguments.
   // Execution may yield in the case of asynchronous code and require one or
-  // more calls to the resume method to complete.
+  // more calls to the resume method to complete. A yield is indicated by
+  // returning IREE_STATUS_DEFERRED with the stack frames of the call left on
+  // |stack|.
   iree_status_t(IREE_API_PTR* begin_call)(
       void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
       iree_vm_execution_result_t* out_result);
 
   // Resumes execution of a previously-yielded call.
+  // |call| must be for the same function passed to begin_call and its results
+  // will be populated when the call completes. The arguments were consumed by
+  // begin_call and are not used. As with begin_call this may return
+  // IREE_STATUS_DEFERRED if execution yields again.
+  //
+  // Calls that yielded within a call they made to another module leave the
+  // frames of both on the stack. Resuming the outer call resumes the inner one
+  // first.
   iree_status_t(IREE_API_PTR* resume_call)(
-      void* self, iree_vm_stack_t* stack,
+      void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
       iree_vm_execution_result_t* out_result);
 
   // TODO(benvanik): move this/refactor.
@@ -312,7 +312,13 @@ static iree_status_t IREE_API_PTR iree_vm_native_module_begin_call(
   iree_vm_module_state_t* module_state = callee_frame->module_state;
   iree_status_t status = function_ptr->shim(stack, call, function_ptr->target,
                                             module, module_state, out_result);
-  if (IREE_UNLIKELY(!iree_status_is_ok(status))) {
+  if (IREE_UNLIKELY(iree_status_is_deferred(status))) {
+    // The function is waiting and will be reissued by the caller when resumed.
+    // Functions must not have side effects prior to deferring so there is no
+    // native state to preserve.
+    IREE_RETURN_IF_ERROR(iree_vm_stack_function_leave(stack));
+    return status;
+  } else if (IREE_UNLIKELY(!iree_status_is_ok(status))) {
 #if IREE_STATUS_FEATURES & IREE_STATUS_FEATURE_ANNOTATIONS
     iree_string_view_t module_name IREE_ATTRIBUTE_UNUSED =
         iree_vm_native_module_name(module);
@@ -334,10 +340,12 @@ static iree_status_t IREE_API_PTR iree_vm_native_module_begin_call(
 
 static iree_status_t IREE_API_PTR
 iree_vm_native_module_resume_call(void* self, iree_vm_stack_t* stack,
+                                  const iree_vm_function_call_t* call,
                                   iree_vm_execution_result_t* out_result) {
   iree_vm_native_module_t* module = (iree_vm_native_module_t*)self;
   if (module->user_interface.resume_call) {
-    return module->user_interface.resume_call(module->self, stack, out_result);
+    return module->user_interface.resume_call(module->self, stack, call,
+                                              out_result);
   }
   return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
                           "native module does not support resume");
@@ -240,7 +240,11 @@ class NativeModule {
 
     auto* state = FromStatePointer(callee_frame->module_state);
     iree_status_t status = info.call(info.ptr, state, stack, call, out_result);
-    if (IREE_UNLIKELY(!iree_status_is_ok(status))) {
+    if (IREE_UNLIKELY(iree_status_is_deferred(status))) {
+      // Reissued by the caller when resumed; see iree_vm_stack_wait.
+      IREE_RETURN_IF_ERROR(iree_vm_stack_function_leave(stack));
+      return status;
+    } else if (IREE_UNLIKELY(!iree_status_is_ok(status))) {
       status = iree_status_annotate_f(
           status, "while invoking C++ function %s.%.*s", module->name_,
           (int)info.name.size, info.name.data);
@@ -9,6 +9,7 @@
 #include <assert.h>
 #include <inttypes.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <string.h>
 
 #include "iree/base/alignment.h"
@@ -188,6 +189,12 @@ struct iree_vm_stack_t {
   // Allocator used for dynamic stack allocations. May be the null allocator
   // if growth is prohibited.
   iree_allocator_t allocator;
+
+  // Wait recorded by iree_vm_stack_wait that the stack is suspended on.
+  // Cleared once the reissued call observes the wait result.
+  bool has_pending_wait;
+  iree_wait_source_t pending_wait_source;
+  iree_time_t pending_wait_deadline_ns;
 };
 
 //===----------------------------------------------------------------------===//
@@ -233,9 +240,7 @@ IREE_API_EXPORT iree_status_t iree_vm_stack_initialize(
 IREE_API_EXPORT void iree_vm_stack_deinitialize(iree_vm_stack_t* stack) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  while (stack->top) {
-    iree_status_ignore(iree_vm_stack_function_leave(stack));
-  }
+  iree_vm_stack_reset(stack);
 
   if (stack->owns_frame_storage) {
     iree_allocator_free(stack->allocator, stack->frame_storage);
@@ -278,6 +283,13 @@ IREE_API_EXPORT void iree_vm_stack_free(iree_vm_stack_t* stack) {
   IREE_TRACE_ZONE_END(z0);
 }
 
+IREE_API_EXPORT void iree_vm_stack_reset(iree_vm_stack_t* stack) {
+  while (stack->top) {
+    iree_status_ignore(iree_vm_stack_function_leave(stack));
+  }
+  stack->has_pending_wait = false;
+}
+
 IREE_API_EXPORT iree_vm_invocation_flags_t
 iree_vm_stack_invocation_flags(const iree_vm_stack_t* stack) {
   return stack->flags;
@@ -295,6 +307,23 @@ IREE_API_EXPORT iree_vm_stack_frame_t* iree_vm_stack_parent_frame(
   return parent_header ? &parent_header->frame : NULL;
 }
 
+IREE_API_EXPORT iree_vm_stack_frame_type_t
+iree_vm_stack_frame_type(const iree_vm_stack_frame_t* frame) {
+  uintptr_t frame_header_ptr =
+      (uintptr_t)frame - offsetof(iree_vm_stack_frame_header_t, frame);
+  return ((const iree_vm_stack_frame_header_t*)frame_header_ptr)->type;
+}
+
+IREE_API_EXPORT iree_vm_stack_frame_t* iree_vm_stack_frame_at_depth(
+    iree_vm_stack_t* stack, int32_t depth) {
+  for (iree_vm_stack_frame_header_t* frame_header = stack->top; frame_header;
+       frame_header = frame_header->parent) {
+    if (frame_header->frame.depth == depth) return &frame_header->frame;
+    if (frame_header->frame.depth < depth) break;
+  }
+  return NULL;
+}
+
 IREE_API_EXPORT iree_status_t iree_vm_stack_query_module_state(
     iree_vm_stack_t* stack, iree_vm_module_t* module,
     iree_vm_module_state_t** out_module_state) {
@@ -466,6 +495,45 @@ iree_vm_stack_function_leave(iree_vm_stack_t* stack) {
   return iree_ok_status();
 }
 
+IREE_API_EXPORT iree_status_t iree_vm_stack_wait(iree_vm_stack_t* stack,
+                                                 iree_wait_source_t wait_source,
+                                                 iree_timeout_t timeout) {
+  if (!(stack->flags & IREE_VM_INVOCATION_FLAG_ASYNC)) {
+    return iree_wait_source_wait_one(wait_source, timeout);
+  }
+
+  // A reissued call continues the wait it recorded before suspending.
+  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+  if (stack->has_pending_wait) {
+    wait_source = stack->pending_wait_source;
+    deadline_ns = stack->pending_wait_deadline_ns;
+    stack->has_pending_wait = false;
+  }
+
+  iree_status_code_t wait_status_code = IREE_STATUS_OK;
+  IREE_RETURN_IF_ERROR(iree_wait_source_query(wait_source, &wait_status_code));
+  if (wait_status_code == IREE_STATUS_DEFERRED) {
+    if (deadline_ns != IREE_TIME_INFINITE_FUTURE &&
+        iree_time_now() >= deadline_ns) {
+      return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    }
+    stack->has_pending_wait = true;
+    stack->pending_wait_source = wait_source;
+    stack->pending_wait_deadline_ns = deadline_ns;
+    return iree_status_from_code(IREE_STATUS_DEFERRED);
+  }
+  return iree_status_from_code(wait_status_code);
+}
+
+IREE_API_EXPORT bool iree_vm_stack_pending_wait(
+    const iree_vm_stack_t* stack, iree_wait_source_t* out_wait_source,
+    iree_time_t* out_deadline_ns) {
+  if (!stack->has_pending_wait) return false;
+  if (out_wait_source) *out_wait_source = stack->pending_wait_source;
+  if (out_deadline_ns) *out_deadline_ns = stack->pending_wait_deadline_ns;
+  return true;
+}
+
 IREE_API_EXPORT iree_status_t iree_vm_stack_format_backtrace(
     iree_vm_stack_t* stack, iree_string_builder_t* builder) {
   for (iree_vm_stack_frame_header_t* frame = stack->top; frame != NULL;
@@ -49,6 +49,12 @@ enum iree_vm_invocation_flag_bits_t {
   // functionality is available; specifically:
   //   -DIREE_VM_EXECUTION_TRACING_ENABLE=1
   IREE_VM_INVOCATION_FLAG_TRACE_EXECUTION = 1u << 0,
+
+  // Allows the invocation to suspend when it would otherwise block the calling
+  // thread, such as when waiting on a wait source with iree_vm_stack_wait.
+  // The owner of the stack must resume the suspended call once the wait
+  // resolves. When not set waits block the calling thread.
+  IREE_VM_INVOCATION_FLAG_ASYNC = 1u << 1,
 };
 typedef uint32_t iree_vm_invocation_flags_t;
 
@@ -188,6 +194,13 @@ IREE_API_EXPORT iree_status_t iree_vm_stack_allocate(
 // Frees a dynamically-allocated |stack| from iree_vm_stack_allocate.
 IREE_API_EXPORT void iree_vm_stack_free(iree_vm_stack_t* stack);
 
+// Resets |stack| to empty so that it can be reused for another invocation.
+// Any frames remaining from a failed or abandoned call are left (running their
+// cleanup functions) and any pending wait is dropped. Storage that the stack
+// grew into is retained so that subsequent invocations of the same depth do
+// not allocate.
+IREE_API_EXPORT void iree_vm_stack_reset(iree_vm_stack_t* stack);
+
 // Returns the flags controlling the invocation this stack is used with.
 IREE_API_EXPORT iree_vm_invocation_flags_t
 iree_vm_stack_invocation_flags(const iree_vm_stack_t* stack);
@@ -200,6 +213,17 @@ IREE_API_EXPORT iree_vm_stack_frame_t* iree_vm_stack_current_frame(
 IREE_API_EXPORT iree_vm_stack_frame_t* iree_vm_stack_parent_frame(
     iree_vm_stack_t* stack);
 
+// Returns the type of |frame| as specified when it was entered. Only frames of
+// type IREE_VM_STACK_FRAME_BYTECODE have bytecode frame storage.
+IREE_API_EXPORT iree_vm_stack_frame_type_t
+iree_vm_stack_frame_type(const iree_vm_stack_frame_t* frame);
+
+// Returns the stack frame at |depth| or nullptr if no frame exists at that
+// depth. This walks the stack from the top and should only be used on slow
+// paths such as resuming suspended stacks.
+IREE_API_EXPORT iree_vm_stack_frame_t* iree_vm_stack_frame_at_depth(
+    iree_vm_stack_t* stack, int32_t depth);
+
 // Queries the context-specific module state for the given module.
 IREE_API_EXPORT iree_status_t iree_vm_stack_query_module_state(
     iree_vm_stack_t* stack, iree_vm_module_t* module,
@@ -223,6 +247,30 @@ IREE_API_EXPORT iree_status_t iree_vm_stack_function_enter(
 IREE_API_EXPORT iree_status_t
 iree_vm_stack_function_leave(iree_vm_stack_t* stack);
 
+// Waits for |wait_source| to resolve or |timeout| to elapse on behalf of the
+// function in the current stack frame.
+//
+// If the stack belongs to an IREE_VM_INVOCATION_FLAG_ASYNC invocation and the
+// wait source has not yet resolved the wait is recorded on the stack and
+// IREE_STATUS_DEFERRED is returned. Callers must propagate the status without
+// having performed any side effects: once the wait resolves (or its deadline
+// elapses) the owner of the stack resumes execution by reissuing the call, at
+// which point this returns the result of the recorded wait. Otherwise blocks
+// the calling thread until the wait resolves.
+//
+// Returns IREE_STATUS_DEADLINE_EXCEEDED if |timeout| elapses before the wait
+// source resolves and the failure status if it resolved with a failure.
+IREE_API_EXPORT iree_status_t iree_vm_stack_wait(iree_vm_stack_t* stack,
+                                                 iree_wait_source_t wait_source,
+                                                 iree_timeout_t timeout);
+
+// Returns true if the stack is suspended on a wait recorded by
+// iree_vm_stack_wait and populates the wait source and the absolute deadline
+// after which the call should be resumed even if the source has not resolved.
+IREE_API_EXPORT bool iree_vm_stack_pending_wait(
+    const iree_vm_stack_t* stack, iree_wait_source_t* out_wait_source,
+    iree_time_t* out_deadline_ns);
+
 // Formats a backtrace of the current stack to the given string |builder|.
 IREE_API_EXPORT iree_status_t iree_vm_stack_format_backtrace(
     iree_vm_stack_t* stack, iree_string_builder_t* builder);
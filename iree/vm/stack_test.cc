@@ -56,10 +56,16 @@ TEST(VMStackTest, Usage) {
                                    IREE_VM_FUNCTION_LINKAGE_INTERNAL, 1};
   iree_vm_stack_frame_t* frame_b = nullptr;
   IREE_EXPECT_OK(iree_vm_stack_function_enter(
-      stack, &function_b, IREE_VM_STACK_FRAME_NATIVE, 0, NULL, &frame_b));
+      stack, &function_b, IREE_VM_STACK_FRAME_BYTECODE, 0, NULL, &frame_b));
   EXPECT_EQ(1, frame_b->function.ordinal);
   EXPECT_EQ(frame_b, iree_vm_stack_current_frame(stack));
   EXPECT_EQ(frame_a, iree_vm_stack_parent_frame(stack));
+  EXPECT_EQ(IREE_VM_STACK_FRAME_NATIVE, iree_vm_stack_frame_type(frame_a));
+  EXPECT_EQ(IREE_VM_STACK_FRAME_BYTECODE, iree_vm_stack_frame_type(frame_b));
+  EXPECT_EQ(frame_a, iree_vm_stack_frame_at_depth(stack, 0));
+  EXPECT_EQ(frame_b, iree_vm_stack_frame_at_depth(stack, 1));
+  EXPECT_EQ(nullptr, iree_vm_stack_frame_at_depth(stack, 2));
+  EXPECT_EQ(nullptr, iree_vm_stack_frame_at_depth(stack, -1));
 
   IREE_EXPECT_OK(iree_vm_stack_function_leave(stack));
   EXPECT_EQ(frame_a, iree_vm_stack_current_frame(stack));
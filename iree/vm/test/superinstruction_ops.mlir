@@ -0,0 +1,109 @@
+// Superinstructions are only supported by the bytecode interpreter and this
+// module is not compiled for other targets.
+vm.module @superinstruction_ops {
+
+  //===--------------------------------------------------------------------===//
+  // vm.add.i32.imm
+  //===--------------------------------------------------------------------===//
+
+  vm.export @test_add_i32_imm
+  vm.func @test_add_i32_imm() {
+    %c1 = vm.const.i32 1 : i32
+    %c1dno = util.do_not_optimize(%c1) : i32
+    %v = vm.add.i32.imm %c1dno, 2 : i32
+    %c3 = vm.const.i32 3 : i32
+    vm.check.eq %v, %c3, "1+2=3" : i32
+    vm.return
+  }
+
+  vm.export @test_add_i32_imm_negative
+  vm.func @test_add_i32_imm_negative() {
+    %c1 = vm.const.i32 1 : i32
+    %c1dno = util.do_not_optimize(%c1) : i32
+    %v = vm.add.i32.imm %c1dno, -3 : i32
+    %cn2 = vm.const.i32 -2 : i32
+    vm.check.eq %v, %cn2, "1+-3=-2" : i32
+    vm.return
+  }
+
+  vm.export @test_add_i32_imm_overflow
+  vm.func @test_add_i32_imm_overflow() {
+    %c = vm.const.i32 2147483647 : i32
+    %cdno = util.do_not_optimize(%c) : i32
+    %v = vm.add.i32.imm %cdno, 1 : i32
+    %cmin = vm.const.i32 -2147483648 : i32
+    vm.check.eq %v, %cmin, "INT_MAX+1=INT_MIN" : i32
+    vm.return
+  }
+
+  //===--------------------------------------------------------------------===//
+  // vm.cond_br.cmp.*
+  //===--------------------------------------------------------------------===//
+
+  vm.export @test_cond_br_cmp_eq_i32
+  vm.func @test_cond_br_cmp_eq_i32() {
+    %c1 = vm.const.i32 1 : i32
+    %c1dno = util.do_not_optimize(%c1) : i32
+    vm.cond_br.cmp.eq.i32 %c1dno, %c1, ^bb1(%c1dno : i32), ^bb2 : i32
+  ^bb1(%arg0 : i32):
+    vm.check.eq %arg0, %c1, "error!" : i32
+    vm.return
+  ^bb2:
+    %code = vm.const.i32 4 : i32
+    vm.fail %code, "unreachable!"
+  }
+
+  vm.export @test_cond_br_cmp_ne_i32
+  vm.func @test_cond_br_cmp_ne_i32() {
+    %c1 = vm.const.i32 1 : i32
+    %c1dno = util.do_not_optimize(%c1) : i32
+    vm.cond_br.cmp.ne.i32 %c1dno, %c1, ^bb1, ^bb2(%c1dno : i32) : i32
+  ^bb1:
+    %code = vm.const.i32 4 : i32
+    vm.fail %code, "unreachable!"
+  ^bb2(%arg0 : i32):
+    vm.check.eq %arg0, %c1, "error!" : i32
+    vm.return
+  }
+
+  vm.export @test_cond_br_cmp_lt_i32_s
+  vm.func @test_cond_br_cmp_lt_i32_s() {
+    %cn1 = vm.const.i32 -1 : i32
+    %cn1dno = util.do_not_optimize(%cn1) : i32
+    %c1 = vm.const.i32 1 : i32
+    vm.cond_br.cmp.lt.i32.s %cn1dno, %c1, ^bb1, ^bb2 : i32
+  ^bb1:
+    vm.return
+  ^bb2:
+    %code = vm.const.i32 4 : i32
+    vm.fail %code, "unreachable!"
+  }
+
+  vm.export @test_cond_br_cmp_lt_i32_u
+  vm.func @test_cond_br_cmp_lt_i32_u() {
+    %cn1 = vm.const.i32 -1 : i32
+    %cn1dno = util.do_not_optimize(%cn1) : i32
+    %c1 = vm.const.i32 1 : i32
+    vm.cond_br.cmp.lt.i32.u %cn1dno, %c1, ^bb1, ^bb2 : i32
+  ^bb1:
+    %code = vm.const.i32 4 : i32
+    vm.fail %code, "unreachable!"
+  ^bb2:
+    vm.return
+  }
+
+  vm.export @test_cond_br_cmp_loop
+  vm.func @test_cond_br_cmp_loop() {
+    %c0 = vm.const.i32.zero : i32
+    %c10 = vm.const.i32 10 : i32
+    %c10dno = util.do_not_optimize(%c10) : i32
+    vm.br ^bb1(%c0 : i32)
+  ^bb1(%i : i32):
+    %next = vm.add.i32.imm %i, 1 : i32
+    vm.cond_br.cmp.lt.i32.s %next, %c10dno, ^bb1(%next : i32), ^bb2 : i32
+  ^bb2:
+    vm.check.eq %next, %c10, "error!" : i32
+    vm.return
+  }
+
+}